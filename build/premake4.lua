@@ -16,6 +16,11 @@
     trigger     = "with-pe",
     description = "Enable Physics Effects"
   }
+
+  newoption {
+    trigger     = "with-pe-wide-ids",
+    description = "Use 32 bit object ids in Physics Effects to handle more than 65535 rigid bodies"
+  }
   
 	configurations {"Release", "Debug"}
 	configuration "Release"
@@ -37,8 +42,15 @@
 	configuration {"x32", "debug"}
 		targetsuffix ("_" .. _ACTION .. "_debug" )
 	
+	configuration "linux"
+		links {"pthread"}
+
 	configuration{}
 
+	if _OPTIONS["with-pe-wide-ids"] then
+		defines {"SCE_PFX_USE_WIDE_OBJECT_ID"}
+	end
+
 if not _OPTIONS["with-nacl"] then
 		flags { "NoRTTI", "NoExceptions"}
 		defines { "_HAS_EXCEPTIONS=0" }
@@ -103,6 +115,17 @@ if not _OPTIONS["with-nacl"] then
 	
 	
 	include "../dynamics/profiler_test"
+	include "../dynamics/serialize_test"
+	include "../dynamics/island_test"
+	include "../dynamics/gjk_benchmark"
+	include "../dynamics/bvh_benchmark"
+	include "../dynamics/vehicle_benchmark"
+	include "../dynamics/softbody_benchmark"
+	include "../dynamics/snapshot_benchmark"
+	include "../dynamics/heightfield_benchmark"
+	include "../dynamics/hull_benchmark"
+	include "../dynamics/solver_benchmark"
+	include "../dynamics/state_array_benchmark"
 	--include "../Lua"
 	
 	
@@ -112,6 +135,8 @@ if _OPTIONS["with-pe"] then
 	include "../physics_effects/low_level"
 	include "../physics_effects/util"
 	include "../physics_effects/sample_api_physics_effects/0_console"
+	include "../physics_effects/sample_api_physics_effects/7_solver_benchmark"
+	include "../physics_effects/sample_api_physics_effects/8_object_id_benchmark"
 	
 	include "../physics_effects/sample_api_physics_effects/1_simple"
 	include "../physics_effects/sample_api_physics_effects/2_stable"
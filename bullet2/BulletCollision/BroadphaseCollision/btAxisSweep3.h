@@ -636,7 +636,29 @@ template <typename BP_FP_INT_TYPE>
 void	btAxisSweep3Internal<BP_FP_INT_TYPE>::calculateOverlappingPairs(btDispatcher* dispatcher)
 {
 
-	if (m_pairCache->hasDeferredRemoval())
+	if (m_pairCache->hasBatchedUpdate())
+	{
+		///merge the pairs added and removed by the sort. The sort reports every change of overlap, so only the pairs that were
+		///both added and removed since the last update need the overlap test, not all pairs
+		class	RemoveSeparatedPairs : public btOverlapCallback
+		{
+			btAxisSweep3Internal*	m_broadphase;
+
+		public:
+			RemoveSeparatedPairs(btAxisSweep3Internal* broadphase)
+				:m_broadphase(broadphase)
+			{
+			}
+			virtual	bool	processOverlap(btBroadphasePair& pair)
+			{
+				return !m_broadphase->testAabbOverlap(pair.m_pProxy0,pair.m_pProxy1);
+			}
+		};
+
+		RemoveSeparatedPairs removeCallback(this);
+		m_pairCache->updatePairs(&removeCallback,dispatcher,true);
+	}
+	else if (m_pairCache->hasDeferredRemoval())
 	{
 	
 		btBroadphasePairArray&	overlappingPairArray = m_pairCache->getOverlappingPairArray();
@@ -60,6 +60,18 @@ public:
 
 	virtual void	rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0)) = 0;
 
+	///rayTestPacket performs rayTest for numRays rays, rayCallbacks[i] receives the proxies along ray i. aabbMin/aabbMax hold the aabb of each swept shape, they can be 0 for plain rays.
+	///The default implementation calls rayTest for each ray. Broadphases that return true from isRayTestPacketReentrant can be queried by several threads at once
+	virtual void	rayTestPacket(int numRays,const btVector3* rayFrom,const btVector3* rayTo,btBroadphaseRayCallback* const* rayCallbacks,const btVector3* aabbMin=0,const btVector3* aabbMax=0)
+	{
+		const btVector3 zero(0,0,0);
+		for (int i=0;i<numRays;i++)
+		{
+			rayTest(rayFrom[i],rayTo[i],*rayCallbacks[i],aabbMin?aabbMin[i]:zero,aabbMax?aabbMax[i]:zero);
+		}
+	}
+	virtual bool	isRayTestPacketReentrant() const { return false; }
+
 	virtual void	aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) = 0;
 
 	///calculateOverlappingPairs is optional: incremental algorithms (sweep and prune) might do it during the set aabb
@@ -75,6 +87,9 @@ public:
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btDispatcher* dispatcher) { (void) dispatcher; };
 
+	///setProxyDormant is a hint that the object of the proxy is deactivated (dormant) and won't move until it is activated again, see btDbvtBroadphase
+	virtual void	setProxyDormant(btBroadphaseProxy* proxy,bool dormant,btDispatcher* dispatcher) { (void) proxy; (void) dormant; (void) dispatcher; };
+
 	virtual void	printStats() = 0;
 
 };
@@ -221,6 +221,30 @@ struct	btDbvt
 		btDbvtNode*		parent;
 		sStkCLN(const btDbvtNode* n,btDbvtNode* p) : node(n),parent(p) {}
 	};
+	/* Ray packet, structure of arrays so the slab tests of all rays vectorize	*/ 
+	struct	sRayPacket
+	{
+		enum	{ MAXRAYS=32 };
+		int			count;
+		btScalar	origin[3][MAXRAYS];
+		btScalar	invdir[3][MAXRAYS];
+		btScalar	lambdamax[MAXRAYS];
+		btScalar	mins[3][MAXRAYS];	/* aabb of the swept shape, zero for rays	*/ 
+		btScalar	maxs[3][MAXRAYS];
+		sRayPacket() : count(0) {}
+		void		append(const btVector3& rayFrom,const btVector3& rayDirectionInverse,btScalar lambda_max,const btVector3& aabbMin,const btVector3& aabbMax)
+		{
+			btAssert(count<MAXRAYS);
+			for(int j=0;j<3;++j)
+			{
+				origin[j][count]=rayFrom[j];
+				invdir[j][count]=rayDirectionInverse[j];
+				mins[j][count]=aabbMin[j];
+				maxs[j][count]=aabbMax[j];
+			}
+			lambdamax[count++]=lambda_max;
+		}
+	};
 	// Policies/Interfaces
 
 	/* ICollide	*/ 
@@ -230,6 +254,7 @@ struct	btDbvt
 			DBVT_VIRTUAL void	Process(const btDbvtNode*,const btDbvtNode*)		{}
 		DBVT_VIRTUAL void	Process(const btDbvtNode*)					{}
 		DBVT_VIRTUAL void	Process(const btDbvtNode* n,btScalar)			{ Process(n); }
+		DBVT_VIRTUAL void	ProcessRay(const btDbvtNode* n,int)				{ Process(n); }
 		DBVT_VIRTUAL bool	Descent(const btDbvtNode*)					{ return(true); }
 		DBVT_VIRTUAL bool	AllLeaves(const btDbvtNode*)					{ return(true); }
 	};
@@ -344,6 +369,13 @@ struct	btDbvt
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const;
+	///rayTestPacket traverses the tree once for all rays of the packet, each node is only tested against the rays that reached its parent.
+	///It is re-entrant as long as every thread passes its own stack. policy.ProcessRay(leaf,i) is called for the leaves that overlap ray i
+	DBVT_PREFIX
+		static void	rayTestPacket(	const btDbvtNode* root,
+								const sRayPacket& packet,
+								btAlignedObjectArray<sStkNP>& stack,
+								DBVT_IPOLICY);
 
 	DBVT_PREFIX
 		static void		collideKDOP(const btDbvtNode* root,
@@ -1002,6 +1034,87 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 	}
 }
 
+//
+DBVT_INLINE int		RayPacketFirstRay(unsigned m)
+{
+	static const int	debruijn[32]={	0,1,28,2,29,14,24,3,30,22,20,15,25,17,4,8,
+										31,27,13,23,21,19,16,7,26,12,18,6,11,5,10,9};
+	return(debruijn[((m&(0u-m))*0x077CB531u)>>27]);
+}
+
+//
+DBVT_INLINE unsigned	RayPacketIntersect(const btDbvt::sRayPacket& packet,
+											int i,
+											const btVector3& nmin,
+											const btVector3& nmax)
+{
+	const btScalar	x0=(nmin.x()-packet.maxs[0][i]-packet.origin[0][i])*packet.invdir[0][i];
+	const btScalar	x1=(nmax.x()-packet.mins[0][i]-packet.origin[0][i])*packet.invdir[0][i];
+	const btScalar	y0=(nmin.y()-packet.maxs[1][i]-packet.origin[1][i])*packet.invdir[1][i];
+	const btScalar	y1=(nmax.y()-packet.mins[1][i]-packet.origin[1][i])*packet.invdir[1][i];
+	const btScalar	z0=(nmin.z()-packet.maxs[2][i]-packet.origin[2][i])*packet.invdir[2][i];
+	const btScalar	z1=(nmax.z()-packet.mins[2][i]-packet.origin[2][i])*packet.invdir[2][i];
+	const btScalar	tnear=btMax(btMax(btMin(x0,x1),btMin(y0,y1)),btMin(z0,z1));
+	const btScalar	tfar=btMin(btMin(btMax(x0,x1),btMax(y0,y1)),btMax(z0,z1));
+	return((tnear<=tfar)&(tnear<packet.lambdamax[i])&(tfar>btScalar(0)));
+}
+
+//
+DBVT_PREFIX
+inline void		btDbvt::rayTestPacket(	const btDbvtNode* root,
+										const sRayPacket& packet,
+										btAlignedObjectArray<sStkNP>& stack,
+										DBVT_IPOLICY)
+{
+	DBVT_CHECKTYPE
+	if(root&&packet.count)
+	{
+		const int		count=packet.count;
+		const unsigned	all=(count<32)?((1u<<count)-1):~0u;
+		btAssert(stack.size()==0);
+		stack.push_back(sStkNP(root,all));
+		do	{
+			const sStkNP		se=stack[stack.size()-1];
+			const btDbvtNode*	node=se.node;
+			stack.pop_back();
+			const btVector3&	nmin=node->volume.Mins();
+			const btVector3&	nmax=node->volume.Maxs();
+			const unsigned		mask=(unsigned)se.mask;
+			unsigned			hits=0;
+			if(mask==all)
+			{/* test all rays, cheaper than branching on the mask	*/ 
+				for(int i=0;i<count;++i)
+				{
+					hits|=RayPacketIntersect(packet,i,nmin,nmax)<<i;
+				}
+			}
+			else
+			{/* sparse packet, only rays that reached the parent	*/ 
+				for(unsigned m=mask;m;m&=m-1)
+				{
+					const int	i=RayPacketFirstRay(m);
+					hits|=RayPacketIntersect(packet,i,nmin,nmax)<<i;
+				}
+			}
+			if(hits)
+			{
+				if(node->isinternal())
+				{
+					stack.push_back(sStkNP(node->childs[0],hits));
+					stack.push_back(sStkNP(node->childs[1],hits));
+				}
+				else
+				{
+					for(unsigned m=hits;m;m&=m-1)
+					{
+						policy.ProcessRay(node,RayPacketFirstRay(m));
+					}
+				}
+			}
+		} while(stack.size());
+	}
+}
+
 //
 DBVT_PREFIX
 inline void		btDbvt::rayTest(	const btDbvtNode* root,
@@ -25,6 +25,11 @@ subject to the following restrictions:
 #include <stdio.h>
 #endif
 
+#if DBVT_BP_ENABLE_BENCHMARK
+#include "btAxisSweep3.h"
+#include "LinearMath/btQuickprof.h"
+#endif
+
 #if DBVT_BP_PROFILE
 struct	ProfileScope
 {
@@ -114,6 +119,99 @@ struct	btDbvtTreeCollider : btDbvt::ICollide
 	}
 };
 
+/* Gathers the pairs of a batched pair cache, can run on any thread	*/ 
+struct	btDbvtGatherCollider : btDbvt::ICollide
+{
+	btOverlappingPairCache*	paircache;
+	btDbvtGatherCollider(btOverlappingPairCache* p) : paircache(p) {}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		if(na!=nb)
+		{
+			paircache->addOverlappingPair((btDbvtProxy*)na->data,(btDbvtProxy*)nb->data);
+		}
+	}
+};
+
+/* Collides pairs of subtrees on the threads of the task scheduler	*/ 
+struct	btDbvtParallelCollider : btIParallelForBody
+{
+	btDbvt*						tree;
+	const btDbvt::sStkNN*		jobs;
+	btOverlappingPairCache*		paircache;
+	void	forLoop(int iBegin,int iEnd) const
+	{
+		btDbvtGatherCollider	collider(paircache);
+		for(int i=iBegin;i<iEnd;++i)
+		{
+			tree->collideTT(jobs[i].a,jobs[i].b,collider);
+		}
+	}
+};
+
+/* Removes the pairs whose leaves don't overlap anymore	*/ 
+struct	btDbvtPairValidator : btOverlapCallback
+{
+	bool	processOverlap(btBroadphasePair& pair)
+	{
+		btDbvtProxy*	pa=(btDbvtProxy*)pair.m_pProxy0;
+		btDbvtProxy*	pb=(btDbvtProxy*)pair.m_pProxy1;
+		/* pairs of dormant proxies can't change	*/ 
+		if((pa->stage==btDbvtBroadphase::DORMANT_STAGE)&&(pb->stage==btDbvtBroadphase::DORMANT_STAGE)) return(false);
+		return(!Intersect(pa->leaf->volume,pb->leaf->volume));
+	}
+};
+
+/* Splits the collision of two subtrees like collideTT does, until there are enough jobs	*/ 
+static void	splitCollideJobs(const btDbvtNode* root0,const btDbvtNode* root1,int minjobs,btAlignedObjectArray<btDbvt::sStkNN>& jobs)
+{
+	if(!root0||!root1) return;
+	const int	first=jobs.size();
+	jobs.push_back(btDbvt::sStkNN(root0,root1));
+	bool		split=true;
+	while(split&&(jobs.size()-first<minjobs))
+	{
+		split=false;
+		const int	end=jobs.size();
+		for(int i=first;i<end;++i)
+		{
+			const btDbvt::sStkNN	p=jobs[i];
+			btDbvt::sStkNN*			slot=&jobs[i];
+			if(p.a==p.b)
+			{
+				if(!p.a->isinternal()) continue;
+				*slot=btDbvt::sStkNN(p.a->childs[0],p.a->childs[0]);
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[1],p.a->childs[1]));
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[0],p.a->childs[1]));
+			}
+			else if(!Intersect(p.a->volume,p.b->volume))
+			{
+				/* nothing to collide, leave a job that returns immediately	*/ 
+				continue;
+			}
+			else if(p.a->isinternal()&&p.b->isinternal())
+			{
+				*slot=btDbvt::sStkNN(p.a->childs[0],p.b->childs[0]);
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[1],p.b->childs[0]));
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[0],p.b->childs[1]));
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[1],p.b->childs[1]));
+			}
+			else if(p.a->isinternal())
+			{
+				*slot=btDbvt::sStkNN(p.a->childs[0],p.b);
+				jobs.push_back(btDbvt::sStkNN(p.a->childs[1],p.b));
+			}
+			else if(p.b->isinternal())
+			{
+				*slot=btDbvt::sStkNN(p.a,p.b->childs[0]);
+				jobs.push_back(btDbvt::sStkNN(p.a,p.b->childs[1]));
+			}
+			else continue;
+			split=true;
+		}
+	}
+}
+
 //
 // btDbvtBroadphase
 //
@@ -123,6 +221,7 @@ btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 {
 	m_deferedcollide	=	false;
 	m_needcleanup		=	true;
+	m_dormantsleeping	=	false;
 	m_releasepaircache	=	(paircache!=0)?false:true;
 	m_prediction		=	0;
 	m_stageCurrent		=	0;
@@ -138,7 +237,7 @@ btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 	m_gid				=	0;
 	m_pid				=	0;
 	m_cid				=	0;
-	for(int i=0;i<=STAGECOUNT;++i)
+	for(int i=0;i<=DORMANT_STAGE;++i)
 	{
 		m_stageRoots[i]=0;
 	}
@@ -184,6 +283,7 @@ btBroadphaseProxy*				btDbvtBroadphase::createProxy(	const btVector3& aabbMin,
 		collider.proxy=proxy;
 		m_sets[0].collideTV(m_sets[0].m_root,aabb,collider);
 		m_sets[1].collideTV(m_sets[1].m_root,aabb,collider);
+		m_sets[DORMANT_SET].collideTV(m_sets[DORMANT_SET].m_root,aabb,collider);
 	}
 	return(proxy);
 }
@@ -195,6 +295,8 @@ void							btDbvtBroadphase::destroyProxy(	btBroadphaseProxy* absproxy,
 	btDbvtProxy*	proxy=(btDbvtProxy*)absproxy;
 	if(proxy->stage==STAGECOUNT)
 		m_sets[1].remove(proxy->leaf);
+	else if(proxy->stage==DORMANT_STAGE)
+		m_sets[DORMANT_SET].remove(proxy->leaf);
 	else
 		m_sets[0].remove(proxy->leaf);
 	listremove(proxy,m_stageRoots[proxy->stage]);
@@ -248,6 +350,55 @@ void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo,
 		aabbMax,
 		callback);
 
+	m_sets[DORMANT_SET].rayTestInternal(	m_sets[DORMANT_SET].m_root,
+		rayFrom,
+		rayTo,
+		rayCallback.m_rayDirectionInverse,
+		rayCallback.m_signs,
+		rayCallback.m_lambda_max,
+		aabbMin,
+		aabbMax,
+		callback);
+
+}
+
+
+struct	BroadphaseRayPacketTester : btDbvt::ICollide
+{
+	btBroadphaseRayCallback* const*	m_rayCallbacks;
+	BroadphaseRayPacketTester(btBroadphaseRayCallback* const* rayCallbacks)
+		:m_rayCallbacks(rayCallbacks)
+	{
+	}
+	void					ProcessRay(const btDbvtNode* leaf,int rayIndex)
+	{
+		btDbvtProxy*	proxy=(btDbvtProxy*)leaf->data;
+		m_rayCallbacks[rayIndex]->process(proxy);
+	}
+};
+
+void	btDbvtBroadphase::rayTestPacket(int numRays,const btVector3* rayFrom,const btVector3* /*rayTo*/,btBroadphaseRayCallback* const* rayCallbacks,const btVector3* aabbMin,const btVector3* aabbMax)
+{
+	btAlignedObjectArray<btDbvt::sStkNP>&	stack=m_rayPacketStacks[btGetCurrentThreadIndex()];
+	const btVector3							zero(0,0,0);
+	btDbvt::sRayPacket						packet;
+	for(int first=0;first<numRays;first+=btDbvt::sRayPacket::MAXRAYS)
+	{
+		const int	count=btMin<int>(numRays-first,btDbvt::sRayPacket::MAXRAYS);
+		packet.count=0;
+		for(int i=first;i<first+count;++i)
+		{
+			packet.append(rayFrom[i],
+				rayCallbacks[i]->m_rayDirectionInverse,
+				rayCallbacks[i]->m_lambda_max,
+				aabbMin?aabbMin[i]:zero,
+				aabbMax?aabbMax[i]:zero);
+		}
+		BroadphaseRayPacketTester	callback(rayCallbacks+first);
+		btDbvt::rayTestPacket(m_sets[0].m_root,packet,stack,callback);
+		btDbvt::rayTestPacket(m_sets[1].m_root,packet,stack,callback);
+		btDbvt::rayTestPacket(m_sets[DORMANT_SET].m_root,packet,stack,callback);
+	}
 }
 
 
@@ -273,6 +424,7 @@ void	btDbvtBroadphase::aabbTest(const btVector3& aabbMin,const btVector3& aabbMa
 		//process all children, that overlap with  the given AABB bounds
 	m_sets[0].collideTV(m_sets[0].m_root,bounds,callback);
 	m_sets[1].collideTV(m_sets[1].m_root,bounds,callback);
+	m_sets[DORMANT_SET].collideTV(m_sets[DORMANT_SET].m_root,bounds,callback);
 
 }
 
@@ -285,6 +437,10 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 														  btDispatcher* /*dispatcher*/)
 {
 	btDbvtProxy*						proxy=(btDbvtProxy*)absproxy;
+	if((proxy->stage==DORMANT_STAGE)&&(proxy->m_aabbMin==aabbMin)&&(proxy->m_aabbMax==aabbMax))
+	{/* dormant and not moving	*/ 
+		return;
+	}
 	ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(aabbMin,aabbMax);
 #if DBVT_BP_PREVENTFALSEUPDATE
 	if(NotEqual(aabb,proxy->leaf->volume))
@@ -297,6 +453,12 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 			proxy->leaf=m_sets[0].insert(aabb,proxy);
 			docollide=true;
 		}
+		else if(proxy->stage==DORMANT_STAGE)
+		{/* dormant -> dynamic set	*/ 
+			m_sets[DORMANT_SET].remove(proxy->leaf);
+			proxy->leaf=m_sets[0].insert(aabb,proxy);
+			docollide=true;
+		}
 		else
 		{/* dynamic set				*/ 
 			++m_updates_call;
@@ -340,6 +502,7 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 				btDbvtTreeCollider	collider(this);
 				m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
 				m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
+				m_sets[DORMANT_SET].collideTTpersistentStack(m_sets[DORMANT_SET].m_root,proxy->leaf,collider);
 			}
 		}	
 	}
@@ -361,6 +524,12 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 		proxy->leaf=m_sets[0].insert(aabb,proxy);
 		docollide=true;
 	}
+	else if(proxy->stage==DORMANT_STAGE)
+	{/* dormant -> dynamic set	*/ 
+		m_sets[DORMANT_SET].remove(proxy->leaf);
+		proxy->leaf=m_sets[0].insert(aabb,proxy);
+		docollide=true;
+	}
 	else
 	{/* dynamic set				*/ 
 		++m_updates_call;
@@ -382,10 +551,43 @@ void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 			btDbvtTreeCollider	collider(this);
 			m_sets[1].collideTTpersistentStack(m_sets[1].m_root,proxy->leaf,collider);
 			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,proxy->leaf,collider);
+			m_sets[DORMANT_SET].collideTTpersistentStack(m_sets[DORMANT_SET].m_root,proxy->leaf,collider);
 		}
 	}	
 }
 
+//
+void							btDbvtBroadphase::setProxyDormant(	btBroadphaseProxy* absproxy,
+																 bool dormant,
+																 btDispatcher* /*dispatcher*/)
+{
+	btDbvtProxy*	proxy=(btDbvtProxy*)absproxy;
+	if(dormant)
+	{
+		if((!m_dormantsleeping)||(proxy->stage==DORMANT_STAGE)) return;
+		/* dynamic or fixed -> dormant set	*/ 
+		if(proxy->stage==STAGECOUNT)
+			m_sets[1].remove(proxy->leaf);
+		else
+			m_sets[0].remove(proxy->leaf);
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(proxy->m_aabbMin,proxy->m_aabbMax);
+		proxy->leaf=m_sets[DORMANT_SET].insert(aabb,proxy);
+		listremove(proxy,m_stageRoots[proxy->stage]);
+		proxy->stage=DORMANT_STAGE;
+		listappend(proxy,m_stageRoots[DORMANT_STAGE]);
+	}
+	else if(proxy->stage==DORMANT_STAGE)
+	{
+		/* dormant -> dynamic set, the proxy didn't move so its pairs are up to date	*/ 
+		m_sets[DORMANT_SET].remove(proxy->leaf);
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(proxy->m_aabbMin,proxy->m_aabbMax);
+		proxy->leaf=m_sets[0].insert(aabb,proxy);
+		listremove(proxy,m_stageRoots[DORMANT_STAGE]);
+		proxy->stage=m_stageCurrent;
+		listappend(proxy,m_stageRoots[m_stageCurrent]);
+	}
+}
+
 //
 void							btDbvtBroadphase::calculateOverlappingPairs(btDispatcher* dispatcher)
 {
@@ -541,6 +743,25 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 		m_needcleanup=true;
 	}
 	/* collide dynamics		*/ 
+	if(m_deferedcollide&&m_paircache->hasBatchedUpdate())
+	{
+		/* the pair cache gathers the pairs of each thread	*/ 
+		const int	minjobs=btGetTaskScheduler()->getNumThreads()*8;
+		m_collideJobs.resize(0);
+		splitCollideJobs(m_sets[0].m_root,m_sets[1].m_root,minjobs,m_collideJobs);
+		splitCollideJobs(m_sets[0].m_root,m_sets[0].m_root,minjobs,m_collideJobs);
+		splitCollideJobs(m_sets[0].m_root,m_sets[DORMANT_SET].m_root,minjobs,m_collideJobs);
+		if(m_collideJobs.size()>0)
+		{
+			SPC(m_profiling.m_ddcollide);
+			btDbvtParallelCollider	body;
+			body.tree=&m_sets[0];
+			body.jobs=&m_collideJobs[0];
+			body.paircache=m_paircache;
+			btParallelFor(0,m_collideJobs.size(),1,body);
+		}
+	}
+	else
 	{
 		btDbvtTreeCollider	collider(this);
 		if(m_deferedcollide)
@@ -553,9 +774,21 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 			SPC(m_profiling.m_ddcollide);
 			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[0].m_root,collider);
 		}
+		if(m_deferedcollide)
+		{
+			SPC(m_profiling.m_fdcollide);
+			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[DORMANT_SET].m_root,collider);
+		}
 	}
 	/* clean up				*/ 
-	if(m_needcleanup)
+	if(m_paircache->hasBatchedUpdate())
+	{
+		/* merge the gathered pairs, and check all pairs if anything moved	*/ 
+		SPC(m_profiling.m_cleanup);
+		btDbvtPairValidator	validator;
+		m_paircache->updatePairs(m_needcleanup?&validator:0,dispatcher);
+	}
+	else if(m_needcleanup)
 	{
 		SPC(m_profiling.m_cleanup);
 		btBroadphasePairArray&	pairs=m_paircache->getOverlappingPairArray();
@@ -568,6 +801,8 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 				btBroadphasePair&	p=pairs[(m_cid+i)%pairs.size()];
 				btDbvtProxy*		pa=(btDbvtProxy*)p.m_pProxy0;
 				btDbvtProxy*		pb=(btDbvtProxy*)p.m_pProxy1;
+				/* pairs of dormant proxies can't change	*/ 
+				if((pa->stage==DORMANT_STAGE)&&(pb->stage==DORMANT_STAGE)) continue;
 				if(!Intersect(pa->leaf->volume,pb->leaf->volume))
 				{
 #if DBVT_BP_SORTPAIRS
@@ -597,6 +832,7 @@ void							btDbvtBroadphase::optimize()
 {
 	m_sets[0].optimizeTopDown();
 	m_sets[1].optimizeTopDown();
+	m_sets[DORMANT_SET].optimizeTopDown();
 }
 
 //
@@ -625,6 +861,13 @@ void							btDbvtBroadphase::getBroadphaseAabb(btVector3& aabbMin,btVector3& aab
 	else if(!m_sets[1].empty())	bounds=m_sets[1].m_root->volume;
 	else
 		bounds=btDbvtVolume::FromCR(btVector3(0,0,0),0);
+	if(!m_sets[DORMANT_SET].empty())
+	{
+		if(m_sets[0].empty()&&m_sets[1].empty())
+			bounds=m_sets[DORMANT_SET].m_root->volume;
+		else
+			Merge(bounds,m_sets[DORMANT_SET].m_root->volume,bounds);
+	}
 	aabbMin=bounds.Mins();
 	aabbMax=bounds.Maxs();
 }
@@ -632,12 +875,13 @@ void							btDbvtBroadphase::getBroadphaseAabb(btVector3& aabbMin,btVector3& aab
 void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 {
 	
-	int totalObjects = m_sets[0].m_leaves + m_sets[1].m_leaves;
+	int totalObjects = m_sets[0].m_leaves + m_sets[1].m_leaves + m_sets[DORMANT_SET].m_leaves;
 	if (!totalObjects)
 	{
 		//reset internal dynamic tree data structures
 		m_sets[0].clear();
 		m_sets[1].clear();
+		m_sets[DORMANT_SET].clear();
 		
 		m_deferedcollide	=	false;
 		m_needcleanup		=	true;
@@ -654,7 +898,7 @@ void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 		m_gid				=	0;
 		m_pid				=	0;
 		m_cid				=	0;
-		for(int i=0;i<=STAGECOUNT;++i)
+		for(int i=0;i<=DORMANT_STAGE;++i)
 		{
 			m_stageRoots[i]=0;
 		}
@@ -697,6 +941,10 @@ struct	btBroadphaseBenchmark
 			pbi->setAabb(proxy,center-extents,center+extents,0);
 		}
 	};
+	struct	KeyLess
+	{
+		bool				operator()(int a,int b) const	{ return(a<b); }
+	};
 	static int		UnsignedRand(int range=RAND_MAX-1)	{ return(rand()%(range+1)); }
 	static btScalar	UnitRand()							{ return(UnsignedRand(16384)/(btScalar)16384); }
 	static void		OutputTime(const char* name,btClock& c,unsigned count=0)
@@ -709,6 +957,22 @@ struct	btBroadphaseBenchmark
 		else
 			printf("%s : %u us (%u ms)\r\n",name,us,ms);
 	}
+	/* Sorted keys of the pairs, optionally only of the pairs whose proxy aabbs overlap	*/ 
+	static void		GetPairKeys(btOverlappingPairCache* paircache,bool overlapping,btAlignedObjectArray<int>& keys)
+	{
+		const btBroadphasePairArray&	pairs=paircache->getOverlappingPairArray();
+		keys.resize(0);
+		for(int i=0;i<pairs.size();++i)
+		{
+			const btBroadphaseProxy*	pa=pairs[i].m_pProxy0;
+			const btBroadphaseProxy*	pb=pairs[i].m_pProxy1;
+			if(overlapping&&!TestAabbAgainstAabb2(pa->m_aabbMin,pa->m_aabbMax,pb->m_aabbMin,pb->m_aabbMax)) continue;
+			const int	lo=btMin(pa->m_uniqueId,pb->m_uniqueId);
+			const int	hi=btMax(pa->m_uniqueId,pb->m_uniqueId);
+			keys.push_back(lo*65536+hi);
+		}
+		keys.quickSort(KeyLess());
+	}
 };
 
 void							btDbvtBroadphase::benchmark(btBroadphaseInterface* pbi)
@@ -783,7 +1047,174 @@ void							btDbvtBroadphase::benchmark(btBroadphaseInterface* pbi)
 		objects.resize(0);
 		btBroadphaseBenchmark::OutputTime("\tRelease",wallclock);
 	}
-
+	/* Sleeping			*/ 
+	static const int	sleeping_object_count=8192;
+	static const int	sleeping_iterations=1024;
+	static const int	active_percents[]={100,50,25,10,1};
+	static const int	nactive_percents=sizeof(active_percents)/sizeof(active_percents[0]);
+	printf("Sleeping experiments:\r\n");
+	printf("\tObjects: %u\r\n",sleeping_object_count);
+	int					awake_pairs=0;
+	for(int iexp=0;iexp<nactive_percents*2;++iexp)
+	{
+		const int		active_count=btMax(1,(sleeping_object_count*active_percents[iexp/2])/100);
+		const bool		dormant=(iexp&1)!=0;
+		const btScalar	speed=(btScalar)0.005;
+		const btScalar	amplitude=(btScalar)100;
+		btDbvtBroadphase*	dbvt=new btDbvtBroadphase();
+		dbvt->m_dormantsleeping=dormant;
+		srand(180673);
+		objects.reserve(sleeping_object_count);
+		for(int i=0;i<sleeping_object_count;++i)
+		{
+			btBroadphaseBenchmark::Object*	po=new btBroadphaseBenchmark::Object();
+			po->center[0]=btBroadphaseBenchmark::UnitRand()*50;
+			po->center[1]=btBroadphaseBenchmark::UnitRand()*50;
+			po->center[2]=btBroadphaseBenchmark::UnitRand()*50;
+			po->extents[0]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->extents[1]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->extents[2]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->time=btBroadphaseBenchmark::UnitRand()*2000;
+			po->proxy=dbvt->createProxy(po->center-po->extents,po->center+po->extents,0,po,1,1,0,0);
+			objects.push_back(po);
+		}
+		for(int i=0;i<objects.size();++i)
+		{
+			objects[i]->update(speed,amplitude,dbvt);
+		}
+		dbvt->calculateOverlappingPairs(0);
+		/* Put the tail to sleep, the way btCollisionWorld::updateAabbs does	*/ 
+		for(int i=active_count;i<objects.size();++i)
+		{
+			dbvt->setProxyDormant(objects[i]->proxy,true,0);
+		}
+		wallclock.reset();
+		for(int i=0;i<sleeping_iterations;++i)
+		{
+			for(int j=0;j<active_count;++j)
+			{				
+				objects[j]->update(speed,amplitude,dbvt);
+			}
+			dbvt->calculateOverlappingPairs(0);
+		}
+		const unsigned long	us=wallclock.getTimeMicroseconds();
+		/* The sleeping proxies have to stay in the dormant set, and find the same pairs as without it.
+		Stale pairs are only cleaned up over several frames, so only the pairs that really overlap are counted	*/ 
+		const btBroadphasePairArray&	pairs=dbvt->getOverlappingPairCache()->getOverlappingPairArray();
+		int				npairs=0;
+		for(int i=0;i<pairs.size();++i)
+		{
+			const btBroadphaseProxy*	pa=pairs[i].m_pProxy0;
+			const btBroadphaseProxy*	pb=pairs[i].m_pProxy1;
+			if(TestAabbAgainstAabb2(pa->m_aabbMin,pa->m_aabbMax,pb->m_aabbMin,pb->m_aabbMax)) ++npairs;
+		}
+		bool			skipped=true;
+		if(dormant)
+		{
+			skipped=(dbvt->m_sets[DORMANT_SET].m_leaves==sleeping_object_count-active_count);
+			for(int i=active_count;i<objects.size();++i)
+			{
+				skipped&=(((btDbvtProxy*)objects[i]->proxy)->stage==DORMANT_STAGE);
+			}
+			if(!skipped) printf("\tError: dormant proxies were moved out of the dormant set\r\n");
+			if(npairs!=awake_pairs) printf("\tError: %u pairs with dormant proxies, %u pairs without\r\n",npairs,awake_pairs);
+			btAssert(skipped&&(npairs==awake_pairs));
+		}
+		else
+		{
+			awake_pairs=npairs;
+		}
+		printf("\tActive %3d%% (%u), %s : %.1f us/frame, %u pairs\r\n",active_percents[iexp/2],active_count,dormant?"dormant":"awake  ",
+			us/(btScalar)sleeping_iterations,npairs);
+		for(int i=0;i<objects.size();++i)
+		{
+			dbvt->destroyProxy(objects[i]->proxy,0);
+			delete objects[i];
+		}
+		objects.resize(0);
+		delete dbvt;
+	}
+	/* Pair caches		*/ 
+	static const int	paircache_object_count=8192;
+	static const int	paircache_iterations=256;
+	printf("Pair cache experiments:\r\n");
+	printf("\tObjects: %u\r\n",paircache_object_count);
+	printf("\tThreads: %u\r\n",btGetTaskScheduler()->getNumThreads());
+	btAlignedObjectArray<int>	hashed_keys;
+	btAlignedObjectArray<int>	batched_keys;
+	for(int iexp=0;iexp<4;++iexp)
+	{
+		const bool		batched=(iexp&1)!=0;
+		const bool		sweep=(iexp&2)!=0;
+		const btScalar	speed=(btScalar)0.005;
+		const btScalar	amplitude=(btScalar)100;
+		btOverlappingPairCache*	paircache;
+		if(batched)
+			paircache=new(btAlignedAlloc(sizeof(btBatchedOverlappingPairCache),16)) btBatchedOverlappingPairCache();
+		else
+			paircache=new(btAlignedAlloc(sizeof(btHashedOverlappingPairCache),16)) btHashedOverlappingPairCache();
+		btBroadphaseInterface*	bp;
+		if(sweep)
+		{
+			bp=new bt32BitAxisSweep3(btVector3(-200,-200,-200),btVector3(200,200,200),paircache_object_count+1,paircache,true);
+		}
+		else
+		{
+			btDbvtBroadphase*	dbvt=new btDbvtBroadphase(paircache);
+			dbvt->m_deferedcollide=true;
+			bp=dbvt;
+		}
+		srand(180673);
+		objects.reserve(paircache_object_count);
+		for(int i=0;i<paircache_object_count;++i)
+		{
+			btBroadphaseBenchmark::Object*	po=new btBroadphaseBenchmark::Object();
+			po->center[0]=btBroadphaseBenchmark::UnitRand()*50;
+			po->center[1]=btBroadphaseBenchmark::UnitRand()*50;
+			po->center[2]=btBroadphaseBenchmark::UnitRand()*50;
+			po->extents[0]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->extents[1]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->extents[2]=btBroadphaseBenchmark::UnitRand()*2+2;
+			po->time=btBroadphaseBenchmark::UnitRand()*2000;
+			po->proxy=bp->createProxy(po->center-po->extents,po->center+po->extents,0,po,1,1,0,0);
+			objects.push_back(po);
+		}
+		bp->calculateOverlappingPairs(0);
+		wallclock.reset();
+		for(int i=0;i<paircache_iterations;++i)
+		{
+			for(int j=0;j<objects.size();++j)
+			{				
+				objects[j]->update(speed,amplitude,bp);
+			}
+			bp->calculateOverlappingPairs(0);
+		}
+		const unsigned long	us=wallclock.getTimeMicroseconds();
+		printf("\t%s, %s pair cache : %.1f us/frame, %u pairs\r\n",sweep?"bt32BitAxisSweep3":"btDbvtBroadphase",batched?"batched":"hashed",
+			us/(btScalar)paircache_iterations,paircache->getNumOverlappingPairs());
+		/* Both caches have to end up with the same pairs. The sweep is exact, the hashed cache of dbvt keeps stale pairs for a few frames,
+		so only the pairs that really overlap are compared there	*/ 
+		btBroadphaseBenchmark::GetPairKeys(paircache,!sweep,batched?batched_keys:hashed_keys);
+		if(batched)
+		{
+			bool	same=(batched_keys.size()==hashed_keys.size());
+			for(int i=0;same&&i<batched_keys.size();++i)
+			{
+				same=(batched_keys[i]==hashed_keys[i]);
+			}
+			if(!same) printf("\tError: %u pairs with the batched cache, %u with the hashed cache\r\n",batched_keys.size(),hashed_keys.size());
+			btAssert(same);
+		}
+		for(int i=0;i<objects.size();++i)
+		{
+			bp->destroyProxy(objects[i]->proxy,0);
+			delete objects[i];
+		}
+		objects.resize(0);
+		delete bp;
+		paircache->~btOverlappingPairCache();
+		btAlignedFree(paircache);
+	}
 }
 #else
 void							btDbvtBroadphase::benchmark(btBroadphaseInterface*)
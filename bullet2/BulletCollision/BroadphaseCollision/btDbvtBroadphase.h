@@ -19,6 +19,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "LinearMath/btThreads.h"
 
 //
 // Compile time config
@@ -59,17 +60,20 @@ typedef btAlignedObjectArray<btDbvtProxy*>	btDbvtProxyArray;
 ///The btDbvtBroadphase implements a broadphase using two dynamic AABB bounding volume hierarchies/trees (see btDbvt).
 ///One tree is used for static/non-moving objects, and another tree is used for dynamic objects. Objects can move from one tree to the other.
 ///This is a very fast broadphase, especially for very dynamic worlds where many objects are moving. Its insert/add and remove of objects is generally faster than the sweep and prune broadphases btAxisSweep3 and bt32BitAxisSweep3.
+///With m_deferedcollide and a pair cache that has a batched update (btBatchedOverlappingPairCache), collide splits the collisions of the trees over the threads of the task scheduler.
 struct	btDbvtBroadphase : btBroadphaseInterface
 {
 	/* Config		*/ 
 	enum	{
 		DYNAMIC_SET			=	0,	/* Dynamic set index	*/ 
 		FIXED_SET			=	1,	/* Fixed set index		*/ 
-		STAGECOUNT			=	2	/* Number of stages		*/ 
+		STAGECOUNT			=	2,	/* Number of stages		*/ 
+		DORMANT_SET			=	2,	/* Dormant set index	*/ 
+		DORMANT_STAGE		=	STAGECOUNT+1	/* Stage of dormant proxies	*/ 
 	};
 	/* Fields		*/ 
-	btDbvt					m_sets[2];					// Dbvt sets
-	btDbvtProxy*			m_stageRoots[STAGECOUNT+1];	// Stages list
+	btDbvt					m_sets[DORMANT_SET+1];		// Dbvt sets
+	btDbvtProxy*			m_stageRoots[STAGECOUNT+2];	// Stages list
 	btOverlappingPairCache*	m_paircache;				// Pair cache
 	btScalar				m_prediction;				// Velocity prediction
 	int						m_stageCurrent;				// Current stage
@@ -87,6 +91,9 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	bool					m_releasepaircache;			// Release pair cache on delete
 	bool					m_deferedcollide;			// Defere dynamic/static collision to collide call
 	bool					m_needcleanup;				// Need to run cleanup?
+	bool					m_dormantsleeping;			// Move deactivated proxies to the dormant set
+	btAlignedObjectArray<btDbvt::sStkNP>	m_rayPacketStacks[BT_MAX_THREAD_COUNT];	// Ray packet stack of each thread
+	btAlignedObjectArray<btDbvt::sStkNN>	m_collideJobs;			// Tree collisions split over the threads
 #if DBVT_BP_PROFILE
 	btClock					m_clock;
 	struct	{
@@ -108,6 +115,8 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	virtual void					destroyProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
 	virtual void					setAabb(btBroadphaseProxy* proxy,const btVector3& aabbMin,const btVector3& aabbMax,btDispatcher* dispatcher);
 	virtual void					rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0));
+	virtual void					rayTestPacket(int numRays,const btVector3* rayFrom,const btVector3* rayTo,btBroadphaseRayCallback* const* rayCallbacks,const btVector3* aabbMin=0,const btVector3* aabbMax=0);
+	virtual bool					isRayTestPacketReentrant() const { return(true); }
 	virtual void					aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
 
 	virtual void					getAabb(btBroadphaseProxy* proxy,btVector3& aabbMin, btVector3& aabbMax ) const;
@@ -117,6 +126,11 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	virtual	void					getBroadphaseAabb(btVector3& aabbMin,btVector3& aabbMax) const;
 	virtual	void					printStats();
 
+	///with m_dormantsleeping, setProxyDormant moves the proxy of a deactivated object into the dormant set. Dormant proxies are not optimized,
+	///collided or cleaned up against each other, moving proxies still collide with them. Waking a proxy moves it back to the dynamic set without
+	///a collision query, its pairs are still up to date because it didn't move. A dormant proxy also wakes when its aabb changes.
+	virtual void					setProxyDormant(btBroadphaseProxy* proxy,bool dormant,btDispatcher* dispatcher);
+
 
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btDispatcher* dispatcher);
@@ -49,6 +49,8 @@ m_invalidPair(0)
 		void* mem = btAlignedAlloc(sizeof(btSortedOverlappingPairCache),16);
 		m_overlappingPairs = new (mem)btSortedOverlappingPairCache();
 	}
+	///a btBatchedOverlappingPairCache only applies the pairs in updatePairs, which this broadphase doesn't call
+	btAssert(!m_overlappingPairs->hasBatchedUpdate());
 
 	struct btMultiSapOverlapFilterCallback : public btOverlapFilterCallback
 	{
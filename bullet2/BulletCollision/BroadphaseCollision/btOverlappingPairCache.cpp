@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "btDispatcher.h"
 #include "btCollisionAlgorithm.h"
 #include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btThreads.h"
 
 #include <stdio.h>
 
@@ -631,3 +632,464 @@ void	btSortedOverlappingPairCache::sortOverlappingPairs(btDispatcher* dispatcher
 	//should already be sorted
 }
 
+
+
+typedef btBatchedOverlappingPairCache::GatheredPair	btGatheredPair;
+
+//radix sort with 8 bit digits, the pairs are split into chunks of at least this size that are counted and scattered in parallel
+#define BT_PAIR_SORT_MIN_CHUNK 4096
+
+static SIMD_FORCE_INLINE unsigned int	btGatheredPairDigit(const btGatheredPair& pair,int pass)
+{
+	//least significant digit first, passes 0-3 sort by m_uid1 and 4-7 by m_uid0
+	unsigned int key = (pass < 4) ? pair.m_uid1 : pair.m_uid0;
+	return (key >> ((pass & 3) * 8)) & 0xff;
+}
+
+static SIMD_FORCE_INLINE bool	btGatheredPairLess(unsigned int uidA0,unsigned int uidA1,unsigned int uidB0,unsigned int uidB1)
+{
+	return (uidA0 < uidB0) || ((uidA0 == uidB0) && (uidA1 < uidB1));
+}
+
+struct btGatheredPairSortBody : public btIParallelForBody
+{
+	const btGatheredPair*	m_source;
+	btGatheredPair*	m_destination;
+	int*	m_histograms;
+	int		m_count;
+	int		m_chunkSize;
+	int		m_pass;
+	bool	m_scatter;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		for (int chunk=iBegin;chunk<iEnd;chunk++)
+		{
+			int* histogram = m_histograms + chunk * 256;
+			int begin = chunk * m_chunkSize;
+			int end = btMin(begin + m_chunkSize,m_count);
+			int i;
+			if (m_scatter)
+			{
+				//the histogram holds the destination of the first pair of each digit
+				for (i=begin;i<end;i++)
+				{
+					m_destination[histogram[btGatheredPairDigit(m_source[i],m_pass)]++] = m_source[i];
+				}
+			} else
+			{
+				for (i=0;i<256;i++)
+				{
+					histogram[i] = 0;
+				}
+				for (i=begin;i<end;i++)
+				{
+					histogram[btGatheredPairDigit(m_source[i],m_pass)]++;
+				}
+			}
+		}
+	}
+};
+
+///sorts the pairs by (m_uid0,m_uid1) and returns either pairs or buffer, whichever holds the result. Digits that are the same for all pairs are skipped.
+static btGatheredPair*	btRadixSortGatheredPairs(btGatheredPair* pairs,btGatheredPair* buffer,int count,unsigned int uid0Bits,unsigned int uid1Bits,btAlignedObjectArray<int>& histograms)
+{
+	int numChunks = 1;
+	if (!btThreadsAreRunning())
+	{
+		numChunks = btMax(1,btMin(btGetTaskScheduler()->getNumThreads(),count / BT_PAIR_SORT_MIN_CHUNK));
+	}
+	histograms.resize(numChunks * 256);
+
+	btGatheredPairSortBody body;
+	body.m_histograms = &histograms[0];
+	body.m_count = count;
+	body.m_chunkSize = (count + numChunks - 1) / numChunks;
+
+	btGatheredPair* source = pairs;
+	btGatheredPair* destination = buffer;
+	for (int pass=0;pass<8;pass++)
+	{
+		unsigned int bits = (pass < 4) ? uid1Bits : uid0Bits;
+		if (!((bits >> ((pass & 3) * 8)) & 0xff))
+		{
+			continue;
+		}
+		body.m_source = source;
+		body.m_destination = destination;
+		body.m_pass = pass;
+		body.m_scatter = false;
+		btParallelFor(0,numChunks,1,body);
+
+		//turn the counts into the destinations, digit by digit and chunk by chunk, which keeps the sort stable
+		int offset = 0;
+		for (int digit=0;digit<256;digit++)
+		{
+			for (int chunk=0;chunk<numChunks;chunk++)
+			{
+				int& entry = histograms[chunk * 256 + digit];
+				int digitCount = entry;
+				entry = offset;
+				offset += digitCount;
+			}
+		}
+
+		body.m_scatter = true;
+		btParallelFor(0,numChunks,1,body);
+		btSwap(source,destination);
+	}
+	return source;
+}
+
+// flags of the merged pairs
+enum btMergedPairFlags
+{
+	BT_MERGED_PAIR_EXISTING = 1,
+	BT_MERGED_PAIR_ADDED = 2,
+	BT_MERGED_PAIR_REMOVED = 4
+};
+
+struct btMergedPairValidationBody : public btIParallelForBody
+{
+	btBroadphasePair*	m_pairs;
+	unsigned char*	m_flags;
+	//the merged pairs to check, all of them when NULL
+	const int*	m_indices;
+	btOverlapCallback*	m_removeCallback;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		for (int j=iBegin;j<iEnd;j++)
+		{
+			int i = m_indices ? m_indices[j] : j;
+			if (!(m_flags[i] & BT_MERGED_PAIR_REMOVED) && m_removeCallback->processOverlap(m_pairs[i]))
+			{
+				m_flags[i] |= BT_MERGED_PAIR_REMOVED;
+			}
+		}
+	}
+};
+
+
+btBatchedOverlappingPairCache::btBatchedOverlappingPairCache():
+	m_currentArray(0),
+	m_overlapFilterCallback(0),
+	m_ghostPairCallback(0)
+{
+	int initialAllocatedSize= 2;
+	m_pairArrays[0].reserve(initialAllocatedSize);
+	m_pairArrays[1].reserve(initialAllocatedSize);
+}
+
+btBatchedOverlappingPairCache::~btBatchedOverlappingPairCache()
+{
+}
+
+void	btBatchedOverlappingPairCache::cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher)
+{
+	if (pair.m_algorithm)
+	{
+		pair.m_algorithm->~btCollisionAlgorithm();
+		dispatcher->freeCollisionAlgorithm(pair.m_algorithm);
+		pair.m_algorithm=0;
+	}
+}
+
+void	btBatchedOverlappingPairCache::processAllOverlappingPairs(btOverlapCallback* callback,btDispatcher* dispatcher)
+{
+	//removing keeps the remaining pairs in order
+	btBroadphasePairArray& pairs = m_pairArrays[m_currentArray];
+	int numPairs = 0;
+	for (int i=0;i<pairs.size();i++)
+	{
+		btBroadphasePair& pair = pairs[i];
+		if (callback->processOverlap(pair))
+		{
+			cleanOverlappingPair(pair,dispatcher);
+			if (m_ghostPairCallback)
+				m_ghostPairCallback->removeOverlappingPair(pair.m_pProxy0,pair.m_pProxy1,dispatcher);
+			gRemovePairs++;
+		} else
+		{
+			if (numPairs != i)
+			{
+				pairs[numPairs] = pair;
+			}
+			numPairs++;
+		}
+	}
+	pairs.resize(numPairs);
+}
+
+void	btBatchedOverlappingPairCache::cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+
+	class	CleanPairCallback : public btOverlapCallback
+	{
+		btBroadphaseProxy* m_cleanProxy;
+		btOverlappingPairCache*	m_pairCache;
+		btDispatcher* m_dispatcher;
+
+	public:
+		CleanPairCallback(btBroadphaseProxy* cleanProxy,btOverlappingPairCache* pairCache,btDispatcher* dispatcher)
+			:m_cleanProxy(cleanProxy),
+			m_pairCache(pairCache),
+			m_dispatcher(dispatcher)
+		{
+		}
+		virtual	bool	processOverlap(btBroadphasePair& pair)
+		{
+			if ((pair.m_pProxy0 == m_cleanProxy) ||
+				(pair.m_pProxy1 == m_cleanProxy))
+			{
+				m_pairCache->cleanOverlappingPair(pair,m_dispatcher);
+			}
+			return false;
+		}
+		
+	};
+
+	CleanPairCallback cleanPairs(proxy,this,dispatcher);
+
+	processAllOverlappingPairs(&cleanPairs,dispatcher);
+}
+
+void	btBatchedOverlappingPairCache::removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+
+	class	RemovePairCallback : public btOverlapCallback
+	{
+		btBroadphaseProxy* m_obsoleteProxy;
+
+	public:
+		RemovePairCallback(btBroadphaseProxy* obsoleteProxy)
+			:m_obsoleteProxy(obsoleteProxy)
+		{
+		}
+		virtual	bool	processOverlap(btBroadphasePair& pair)
+		{
+			return ((pair.m_pProxy0 == m_obsoleteProxy) ||
+				(pair.m_pProxy1 == m_obsoleteProxy));
+		}
+		
+	};
+
+	RemovePairCallback removeCallback(proxy);
+
+	processAllOverlappingPairs(&removeCallback,dispatcher);
+
+	//the proxy is about to be destroyed, forget the pairs that were reported since the last update
+	for (int t=0;t<BT_MAX_THREAD_COUNT;t++)
+	{
+		for (int r=0;r<2;r++)
+		{
+			GatheredPairArray& gathered = r ? m_threadPairs[t].m_removed : m_threadPairs[t].m_added;
+			int numGathered = 0;
+			for (int i=0;i<gathered.size();i++)
+			{
+				if ((gathered[i].m_proxy0 != proxy) && (gathered[i].m_proxy1 != proxy))
+				{
+					gathered[numGathered++] = gathered[i];
+				}
+			}
+			gathered.resize(numGathered);
+		}
+	}
+}
+
+btBroadphasePair*	btBatchedOverlappingPairCache::findPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+{
+	gFindPairs++;
+	if (proxy0->m_uniqueId > proxy1->m_uniqueId)
+		btSwap(proxy0,proxy1);
+	unsigned int uid0 = (unsigned int)proxy0->m_uniqueId;
+	unsigned int uid1 = (unsigned int)proxy1->m_uniqueId;
+
+	btBroadphasePairArray& pairs = m_pairArrays[m_currentArray];
+	int low = 0;
+	int high = pairs.size();
+	while (low < high)
+	{
+		int mid = (low + high) >> 1;
+		const btBroadphasePair& pair = pairs[mid];
+		if (btGatheredPairLess((unsigned int)pair.m_pProxy0->m_uniqueId,(unsigned int)pair.m_pProxy1->m_uniqueId,uid0,uid1))
+		{
+			low = mid + 1;
+		} else
+		{
+			high = mid;
+		}
+	}
+	if ((low < pairs.size()) && (pairs[low].m_pProxy0 == proxy0) && (pairs[low].m_pProxy1 == proxy1))
+	{
+		return &pairs[low];
+	}
+	return 0;
+}
+
+int	btBatchedOverlappingPairCache::sortGatheredPairs(bool removed,GatheredPairArray& sortedPairs)
+{
+	int t;
+	int count = 0;
+	for (t=0;t<BT_MAX_THREAD_COUNT;t++)
+	{
+		count += removed ? m_threadPairs[t].m_removed.size() : m_threadPairs[t].m_added.size();
+	}
+	sortedPairs.resize(count);
+	if (!count)
+	{
+		return 0;
+	}
+
+	//concatenate the arrays of the threads, and find the digits that differ between the pairs
+	unsigned int uid0Bits = 0;
+	unsigned int uid1Bits = 0;
+	int numGathered = 0;
+	for (t=0;t<BT_MAX_THREAD_COUNT;t++)
+	{
+		GatheredPairArray& gathered = removed ? m_threadPairs[t].m_removed : m_threadPairs[t].m_added;
+		for (int i=0;i<gathered.size();i++)
+		{
+			const GatheredPair& pair = gathered[i];
+			sortedPairs[numGathered++] = pair;
+			uid0Bits |= pair.m_uid0 ^ sortedPairs[0].m_uid0;
+			uid1Bits |= pair.m_uid1 ^ sortedPairs[0].m_uid1;
+		}
+		gathered.resize(0);
+	}
+
+	m_sortBuffer.resize(count);
+	GatheredPair* sorted = btRadixSortGatheredPairs(&sortedPairs[0],&m_sortBuffer[0],count,uid0Bits,uid1Bits,m_sortHistograms);
+
+	//remove the duplicates, broadphases can report a pair more than once
+	int numSorted = 0;
+	for (int i=0;i<count;i++)
+	{
+		if (!numSorted || (sorted[i].m_uid0 != sortedPairs[numSorted-1].m_uid0) || (sorted[i].m_uid1 != sortedPairs[numSorted-1].m_uid1))
+		{
+			sortedPairs[numSorted++] = sorted[i];
+		}
+	}
+	sortedPairs.resize(numSorted);
+	return numSorted;
+}
+
+void	btBatchedOverlappingPairCache::updatePairs(btOverlapCallback* removeCallback,btDispatcher* dispatcher,bool onlyConflictingPairs)
+{
+	m_addedPairs.resize(0);
+	m_removedPairs.resize(0);
+	m_conflictingPairs.resize(0);
+
+	int numAdded = sortGatheredPairs(false,m_sortedAdded);
+	int numRemoved = sortGatheredPairs(true,m_sortedRemoved);
+	if (!numAdded && !numRemoved && !removeCallback)
+	{
+		return;
+	}
+
+	btBroadphasePairArray& existingPairs = m_pairArrays[m_currentArray];
+	btBroadphasePairArray& mergedPairs = m_pairArrays[1 - m_currentArray];
+	int numExisting = existingPairs.size();
+
+	//merge the existing and added pairs, both sorted, into one sorted array
+	mergedPairs.resize(0);
+	mergedPairs.reserve(numExisting + numAdded);
+	m_mergeFlags.resize(numExisting + numAdded);
+	int numMerged = 0;
+	int existing = 0;
+	int added = 0;
+	int removed = 0;
+	while ((existing < numExisting) || (added < numAdded))
+	{
+		unsigned int uid0 = 0;
+		unsigned int uid1 = 0;
+		unsigned char flags = 0;
+		if (existing < numExisting)
+		{
+			const btBroadphasePair& pair = existingPairs[existing];
+			uid0 = (unsigned int)pair.m_pProxy0->m_uniqueId;
+			uid1 = (unsigned int)pair.m_pProxy1->m_uniqueId;
+			if ((added == numAdded) || !btGatheredPairLess(m_sortedAdded[added].m_uid0,m_sortedAdded[added].m_uid1,uid0,uid1))
+			{
+				flags = BT_MERGED_PAIR_EXISTING;
+				mergedPairs.push_back(pair);
+				existing++;
+			}
+		}
+		if (added < numAdded)
+		{
+			const GatheredPair& pair = m_sortedAdded[added];
+			if (!flags)
+			{
+				uid0 = pair.m_uid0;
+				uid1 = pair.m_uid1;
+				mergedPairs.push_back(btBroadphasePair(*pair.m_proxy0,*pair.m_proxy1));
+				flags = BT_MERGED_PAIR_ADDED;
+				added++;
+			} else if ((pair.m_uid0 == uid0) && (pair.m_uid1 == uid1))
+			{
+				flags |= BT_MERGED_PAIR_ADDED;
+				added++;
+			}
+		}
+		while ((removed < numRemoved) && btGatheredPairLess(m_sortedRemoved[removed].m_uid0,m_sortedRemoved[removed].m_uid1,uid0,uid1))
+		{
+			removed++;
+		}
+		if ((removed < numRemoved) && (m_sortedRemoved[removed].m_uid0 == uid0) && (m_sortedRemoved[removed].m_uid1 == uid1))
+		{
+			//the order of an add and a remove of the same pair is lost by the sort, so only the callback can tell
+			if (flags & BT_MERGED_PAIR_ADDED)
+				m_conflictingPairs.push_back(numMerged);
+			else
+				flags |= BT_MERGED_PAIR_REMOVED;
+		}
+		m_mergeFlags[numMerged++] = flags;
+	}
+
+	int numValidated = onlyConflictingPairs ? m_conflictingPairs.size() : numMerged;
+	if (removeCallback && numValidated)
+	{
+		btMergedPairValidationBody body;
+		body.m_pairs = &mergedPairs[0];
+		body.m_flags = &m_mergeFlags[0];
+		body.m_indices = onlyConflictingPairs ? &m_conflictingPairs[0] : 0;
+		body.m_removeCallback = removeCallback;
+		btParallelFor(0,numValidated,1024,body);
+	}
+
+	//compact, and report the added and removed pairs
+	int numPairs = 0;
+	for (int i=0;i<numMerged;i++)
+	{
+		btBroadphasePair& pair = mergedPairs[i];
+		unsigned char flags = m_mergeFlags[i];
+		if (flags & BT_MERGED_PAIR_REMOVED)
+		{
+			if (flags & BT_MERGED_PAIR_EXISTING)
+			{
+				cleanOverlappingPair(pair,dispatcher);
+				if (m_ghostPairCallback)
+					m_ghostPairCallback->removeOverlappingPair(pair.m_pProxy0,pair.m_pProxy1,dispatcher);
+				m_removedPairs.push_back(pair);
+			}
+			continue;
+		}
+		if (!(flags & BT_MERGED_PAIR_EXISTING))
+		{
+			if (m_ghostPairCallback)
+				m_ghostPairCallback->addOverlappingPair(pair.m_pProxy0,pair.m_pProxy1);
+			m_addedPairs.push_back(pair);
+		}
+		if (numPairs != i)
+		{
+			mergedPairs[numPairs] = pair;
+		}
+		numPairs++;
+	}
+	mergedPairs.resize(numPairs);
+	m_currentArray = 1 - m_currentArray;
+
+	gAddedPairs += m_addedPairs.size();
+	gRemovePairs += m_removedPairs.size();
+}
@@ -22,6 +22,7 @@ subject to the following restrictions:
 #include "btOverlappingPairCallback.h"
 
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btThreads.h"
 class btDispatcher;
 
 typedef btAlignedObjectArray<btBroadphasePair>	btBroadphasePairArray;
@@ -56,7 +57,7 @@ extern int gFindPairs;
 const int BT_NULL_PAIR=0xffffffff;
 
 ///The btOverlappingPairCache provides an interface for overlapping pair management (add, remove, storage), used by the btBroadphaseInterface broadphases.
-///The btHashedOverlappingPairCache and btSortedOverlappingPairCache classes are two implementations.
+///The btHashedOverlappingPairCache, btSortedOverlappingPairCache and btBatchedOverlappingPairCache classes are implementations.
 class btOverlappingPairCache : public btOverlappingPairCallback
 {
 public:
@@ -84,8 +85,23 @@ public:
 
 	virtual	void	setInternalGhostPairCallback(btOverlappingPairCallback* ghostPairCallback)=0;
 
+	virtual	btOverlappingPairCallback*	getInternalGhostPairCallback()=0;
+
 	virtual void	sortOverlappingPairs(btDispatcher* dispatcher) = 0;
 
+	///hasBatchedUpdate returns true if addOverlappingPair and removeOverlappingPair can be called from several threads at once and only take effect
+	///in updatePairs, which the broadphase then calls from calculateOverlappingPairs. See btBatchedOverlappingPairCache.
+	virtual bool	hasBatchedUpdate() const
+	{
+		return false;
+	}
+
+	///updatePairs applies the pairs added and removed since the last update. If removeCallback is not NULL, the pairs for which
+	///it returns true are removed as well, it can be called concurrently for different pairs. With onlyConflictingPairs, the callback
+	///only checks the pairs that were both added and removed since the last update, for broadphases that report every change of overlap.
+	virtual void	updatePairs(btOverlapCallback* /*removeCallback*/,btDispatcher* /*dispatcher*/,bool /*onlyConflictingPairs*/=false)
+	{
+	}
 
 };
 
@@ -262,6 +278,11 @@ private:
 		m_ghostPairCallback = ghostPairCallback;
 	}
 
+	virtual	btOverlappingPairCallback*	getInternalGhostPairCallback()
+	{
+		return m_ghostPairCallback;
+	}
+
 	virtual void	sortOverlappingPairs(btDispatcher* dispatcher);
 	
 
@@ -375,6 +396,11 @@ class	btSortedOverlappingPairCache : public btOverlappingPairCache
 			m_ghostPairCallback = ghostPairCallback;
 		}
 
+		virtual	btOverlappingPairCallback*	getInternalGhostPairCallback()
+		{
+			return m_ghostPairCallback;
+		}
+
 		virtual void	sortOverlappingPairs(btDispatcher* dispatcher);
 		
 
@@ -382,6 +408,195 @@ class	btSortedOverlappingPairCache : public btOverlappingPairCache
 
 
 
+///btBatchedOverlappingPairCache keeps the overlapping pairs in an array sorted by the unique ids of their proxies, without a hash table.
+///addOverlappingPair and removeOverlappingPair only append to an array of the calling thread, so a broadphase can report pairs from several threads.
+///updatePairs radix sorts the reported pairs and merges them with the pairs of the previous update in a single pass, which gives the sets of
+///added and removed pairs (see getAddedPairs and getRemovedPairs). Pairs that are reported again keep their collision algorithm.
+///A pair that is both added and removed between two updates is kept, the broadphase passes a callback to updatePairs that removes the pairs
+///that don't overlap anymore. btDbvtBroadphase and btAxisSweep3 support it, the order of the pairs doesn't depend on the number of threads.
+///Broadphases that don't call updatePairs, such as btSimpleBroadphase and btMultiSapBroadphase, would never see any pair, they assert on it.
+class btBatchedOverlappingPairCache : public btOverlappingPairCache
+{
+public:
+
+	///a reported pair, m_proxy0 has the lower unique id
+	struct	GatheredPair
+	{
+		unsigned int		m_uid0;
+		unsigned int		m_uid1;
+		btBroadphaseProxy*	m_proxy0;
+		btBroadphaseProxy*	m_proxy1;
+	};
+
+	typedef btAlignedObjectArray<GatheredPair>	GatheredPairArray;
+
+protected:
+
+	struct	ThreadPairs
+	{
+		GatheredPairArray	m_added;
+		GatheredPairArray	m_removed;
+		//keeps the arrays of different threads on different cache lines
+		char				m_padding[64];
+	};
+
+	//the current pair array and the array the next update merges into
+	btBroadphasePairArray	m_pairArrays[2];
+	int						m_currentArray;
+
+	ThreadPairs				m_threadPairs[BT_MAX_THREAD_COUNT];
+
+	GatheredPairArray		m_sortedAdded;
+	GatheredPairArray		m_sortedRemoved;
+	GatheredPairArray		m_sortBuffer;
+	btAlignedObjectArray<int>			m_sortHistograms;
+	btAlignedObjectArray<unsigned char>	m_mergeFlags;
+	btAlignedObjectArray<int>			m_conflictingPairs;
+
+	btBroadphasePairArray	m_addedPairs;
+	btBroadphasePairArray	m_removedPairs;
+
+	btOverlapFilterCallback*	m_overlapFilterCallback;
+	btOverlappingPairCallback*	m_ghostPairCallback;
+
+	void	gatherPair(GatheredPairArray& pairs,btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+	{
+		if (proxy0->m_uniqueId > proxy1->m_uniqueId)
+			btSwap(proxy0,proxy1);
+		GatheredPair& pair = pairs.expandNonInitializing();
+		pair.m_uid0 = (unsigned int)proxy0->m_uniqueId;
+		pair.m_uid1 = (unsigned int)proxy1->m_uniqueId;
+		pair.m_proxy0 = proxy0;
+		pair.m_proxy1 = proxy1;
+	}
+
+	///sorts the pairs gathered by all threads into sortedPairs, without duplicates, and returns their number
+	int		sortGatheredPairs(bool removed,GatheredPairArray& sortedPairs);
+
+public:
+
+	btBatchedOverlappingPairCache();
+	virtual ~btBatchedOverlappingPairCache();
+
+	SIMD_FORCE_INLINE bool needsBroadphaseCollision(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1) const
+	{
+		if (m_overlapFilterCallback)
+			return m_overlapFilterCallback->needBroadphaseCollision(proxy0,proxy1);
+
+		bool collides = (proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) != 0;
+		collides = collides && (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask);
+		
+		return collides;
+	}
+
+	///the pair is created by the next updatePairs, so this always returns 0
+	virtual btBroadphasePair*	addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+	{
+		btAssert(proxy0 != proxy1);
+		if (needsBroadphaseCollision(proxy0,proxy1))
+		{
+			gatherPair(m_threadPairs[btGetCurrentThreadIndex()].m_added,proxy0,proxy1);
+		}
+		return 0;
+	}
+
+	///the pair is removed by the next updatePairs, unless it is added again before that
+	virtual void*	removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* /*dispatcher*/)
+	{
+		gatherPair(m_threadPairs[btGetCurrentThreadIndex()].m_removed,proxy0,proxy1);
+		return 0;
+	}
+
+	virtual void	removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual void	cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual	void	cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher);
+
+	virtual void	processAllOverlappingPairs(btOverlapCallback*,btDispatcher* dispatcher);
+
+	///binary search, only finds the pairs merged by updatePairs
+	virtual btBroadphasePair*	findPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
+
+	virtual bool	hasBatchedUpdate() const
+	{
+		return true;
+	}
+
+	virtual void	updatePairs(btOverlapCallback* removeCallback,btDispatcher* dispatcher,bool onlyConflictingPairs=false);
+
+	///the pairs created by the last updatePairs, their algorithms are created later by the dispatcher
+	const btBroadphasePairArray&	getAddedPairs() const
+	{
+		return m_addedPairs;
+	}
+
+	///the pairs removed by the last updatePairs, their algorithms are already released
+	const btBroadphasePairArray&	getRemovedPairs() const
+	{
+		return m_removedPairs;
+	}
+
+	virtual btBroadphasePair*	getOverlappingPairArrayPtr()
+	{
+		return &m_pairArrays[m_currentArray][0];
+	}
+
+	virtual const btBroadphasePair*	getOverlappingPairArrayPtr() const
+	{
+		return &m_pairArrays[m_currentArray][0];
+	}
+
+	virtual btBroadphasePairArray&	getOverlappingPairArray()
+	{
+		return m_pairArrays[m_currentArray];
+	}
+
+	const btBroadphasePairArray&	getOverlappingPairArray() const
+	{
+		return m_pairArrays[m_currentArray];
+	}
+
+	virtual int	getNumOverlappingPairs() const
+	{
+		return m_pairArrays[m_currentArray].size();
+	}
+
+	btOverlapFilterCallback* getOverlapFilterCallback()
+	{
+		return m_overlapFilterCallback;
+	}
+
+	virtual void	setOverlapFilterCallback(btOverlapFilterCallback* callback)
+	{
+		m_overlapFilterCallback = callback;
+	}
+
+	///removals are applied directly or by updatePairs, the broadphase doesn't need to sort and clean the pair array
+	virtual bool	hasDeferredRemoval()
+	{
+		return false;
+	}
+
+	virtual	void	setInternalGhostPairCallback(btOverlappingPairCallback* ghostPairCallback)
+	{
+		m_ghostPairCallback = ghostPairCallback;
+	}
+
+	virtual	btOverlappingPairCallback*	getInternalGhostPairCallback()
+	{
+		return m_ghostPairCallback;
+	}
+
+	///the pairs are always sorted
+	virtual void	sortOverlappingPairs(btDispatcher* /*dispatcher*/)
+	{
+	}
+
+};
+
+
+
 ///btNullPairCache skips add/removal of overlapping pairs. Userful for benchmarking and unit testing.
 class btNullPairCache : public btOverlappingPairCache
 {
@@ -441,6 +656,11 @@ public:
 
 	}
 
+	virtual	btOverlappingPairCallback*	getInternalGhostPairCallback()
+	{
+		return 0;
+	}
+
 	virtual btBroadphasePair*	addOverlappingPair(btBroadphaseProxy* /*proxy0*/,btBroadphaseProxy* /*proxy1*/)
 	{
 		return 0;
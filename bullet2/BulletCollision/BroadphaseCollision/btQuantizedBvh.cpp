@@ -18,6 +18,7 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 
 #define RAYAABB2
 
@@ -52,9 +53,7 @@ void btQuantizedBvh::buildInternal()
 
 	}
 
-	m_curNodeIndex = 0;
-
-	buildTree(0,numLeafNodes);
+	buildQuantizedTreeBinned(numLeafNodes);
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if(m_useQuantization && !m_SubtreeHeaders.size())
@@ -227,6 +226,445 @@ void	btQuantizedBvh::updateSubtreeHeaders(int leftChildNodexIndex,int rightChild
 }
 
 
+#define BT_BVH_NUM_BINS 16
+//ranges with more leaves are split on the calling thread with parallel binning, smaller ranges are built by a single task
+#define BT_BVH_MAX_TASK_LEAVES 8192
+#define BT_BVH_NUM_BINNING_CHUNKS 64
+
+///btBvhBuildBounds is the quantized aabb and the centroid bounds of a range of leaves. The centroids are min+max, so they stay integers.
+struct btBvhBuildBounds
+{
+	int		m_aabbMin[3];
+	int		m_aabbMax[3];
+	int		m_centroidMin[3];
+	int		m_centroidMax[3];
+
+	void	init()
+	{
+		for (int i=0;i<3;i++)
+		{
+			m_aabbMin[i] = 0xffff;
+			m_aabbMax[i] = 0;
+			m_centroidMin[i] = 0x7fffffff;
+			m_centroidMax[i] = -1;
+		}
+	}
+
+	SIMD_FORCE_INLINE void	add(const btQuantizedBvhNode& leaf)
+	{
+		for (int i=0;i<3;i++)
+		{
+			int minValue = leaf.m_quantizedAabbMin[i];
+			int maxValue = leaf.m_quantizedAabbMax[i];
+			m_aabbMin[i] = btMin(m_aabbMin[i],minValue);
+			m_aabbMax[i] = btMax(m_aabbMax[i],maxValue);
+			m_centroidMin[i] = btMin(m_centroidMin[i],minValue+maxValue);
+			m_centroidMax[i] = btMax(m_centroidMax[i],minValue+maxValue);
+		}
+	}
+
+	void	merge(const btBvhBuildBounds& other)
+	{
+		for (int i=0;i<3;i++)
+		{
+			m_aabbMin[i] = btMin(m_aabbMin[i],other.m_aabbMin[i]);
+			m_aabbMax[i] = btMax(m_aabbMax[i],other.m_aabbMax[i]);
+			m_centroidMin[i] = btMin(m_centroidMin[i],other.m_centroidMin[i]);
+			m_centroidMax[i] = btMax(m_centroidMax[i],other.m_centroidMax[i]);
+		}
+	}
+};
+
+///btBvhBin is the quantized aabb and the number of leaves that fall into one bin
+struct btBvhBin
+{
+	int		m_aabbMin[3];
+	int		m_aabbMax[3];
+	int		m_count;
+
+	void	init()
+	{
+		for (int i=0;i<3;i++)
+		{
+			m_aabbMin[i] = 0xffff;
+			m_aabbMax[i] = 0;
+		}
+		m_count = 0;
+	}
+
+	void	merge(const btBvhBin& other)
+	{
+		for (int i=0;i<3;i++)
+		{
+			m_aabbMin[i] = btMin(m_aabbMin[i],other.m_aabbMin[i]);
+			m_aabbMax[i] = btMax(m_aabbMax[i],other.m_aabbMax[i]);
+		}
+		m_count += other.m_count;
+	}
+
+	///cost is the surface area times the number of leaves, extentScale converts the quantized extents back to the scale of the mesh
+	btScalar	cost(const btVector3& extentScale) const
+	{
+		btScalar x = btScalar(m_aabbMax[0]-m_aabbMin[0])*extentScale.getX();
+		btScalar y = btScalar(m_aabbMax[1]-m_aabbMin[1])*extentScale.getY();
+		btScalar z = btScalar(m_aabbMax[2]-m_aabbMin[2])*extentScale.getZ();
+		return (x*y+y*z+z*x)*btScalar(m_count);
+	}
+};
+
+///btBvhBuildRange is a range of leaves and the index of the node that will hold its subtree
+struct btBvhBuildRange
+{
+	int		m_startIndex;
+	int		m_endIndex;
+	int		m_nodeIndex;
+	btBvhBuildBounds	m_bounds;
+};
+
+///btBvhBinning maps the centroids of a range to bins along the axis with the largest centroid extent
+struct btBvhBinning
+{
+	btVector3	m_extentScale;
+	int		m_axis;
+	int		m_centroidMin;
+	float	m_scale;
+
+	btBvhBinning(const btBvhBuildBounds& bounds, const btVector3& extentScale)
+		:m_extentScale(extentScale)
+	{
+		//the quantization is different for each axis, so the extents are compared at the scale of the mesh
+		btVector3 centroidExtent(btScalar(bounds.m_centroidMax[0]-bounds.m_centroidMin[0]),
+			btScalar(bounds.m_centroidMax[1]-bounds.m_centroidMin[1]),
+			btScalar(bounds.m_centroidMax[2]-bounds.m_centroidMin[2]));
+		m_axis = (centroidExtent*extentScale).maxAxis();
+		m_centroidMin = bounds.m_centroidMin[m_axis];
+		m_scale = float(BT_BVH_NUM_BINS)/float(bounds.m_centroidMax[m_axis]-m_centroidMin+1);
+	}
+
+	SIMD_FORCE_INLINE int	getBin(const btQuantizedBvhNode& leaf) const
+	{
+		int centroid = int(leaf.m_quantizedAabbMin[m_axis])+int(leaf.m_quantizedAabbMax[m_axis]);
+		int bin = int(float(centroid-m_centroidMin)*m_scale);
+		return btMin(bin,BT_BVH_NUM_BINS-1);
+	}
+};
+
+///btBvhBins holds the leaves of a range sorted into bins by their centroid
+struct btBvhBins
+{
+	btBvhBin	m_bins[BT_BVH_NUM_BINS];
+
+	void	init()
+	{
+		for (int i=0;i<BT_BVH_NUM_BINS;i++)
+		{
+			m_bins[i].init();
+		}
+	}
+
+	void	merge(const btBvhBins& other)
+	{
+		for (int i=0;i<BT_BVH_NUM_BINS;i++)
+		{
+			m_bins[i].merge(other.m_bins[i]);
+		}
+	}
+
+	void	add(const btQuantizedBvhNode* leaves, int startIndex, int endIndex, const btBvhBinning& binning)
+	{
+		for (int i=startIndex;i<endIndex;i++)
+		{
+			const btQuantizedBvhNode& leaf = leaves[i];
+			btBvhBin& bin = m_bins[binning.getBin(leaf)];
+			for (int j=0;j<3;j++)
+			{
+				bin.m_aabbMin[j] = btMin(bin.m_aabbMin[j],int(leaf.m_quantizedAabbMin[j]));
+				bin.m_aabbMax[j] = btMax(bin.m_aabbMax[j],int(leaf.m_quantizedAabbMax[j]));
+			}
+			bin.m_count++;
+		}
+	}
+};
+
+static void	btComputeBuildBounds(const btQuantizedBvhNode* leaves, int startIndex, int endIndex, btBvhBuildBounds& bounds)
+{
+	bounds.init();
+	for (int i=startIndex;i<endIndex;i++)
+	{
+		bounds.add(leaves[i]);
+	}
+}
+
+///btSplitBinnedRange finds the split of the binned range with the lowest surface area cost, partitions the leaves and fills in the child ranges
+static void	btSplitBinnedRange(btQuantizedBvhNode* leaves, const btBvhBuildRange& range, const btBvhBinning& binning, const btBvhBins& bins, btBvhBuildRange& left, btBvhBuildRange& right)
+{
+	int numLeaves = range.m_endIndex-range.m_startIndex;
+	int bestBin = -1;
+	int bestCount = 0;
+	btScalar bestCost = SIMD_INFINITY;
+
+	if (range.m_bounds.m_centroidMin[binning.m_axis]<range.m_bounds.m_centroidMax[binning.m_axis])
+	{
+		//sweep from the right to get the cost of the right side of every split
+		btScalar rightCost[BT_BVH_NUM_BINS];
+		btBvhBin side = bins.m_bins[BT_BVH_NUM_BINS-1];
+		int i;
+		for (i=BT_BVH_NUM_BINS-1;i>0;i--)
+		{
+			if (i<BT_BVH_NUM_BINS-1)
+				side.merge(bins.m_bins[i]);
+			rightCost[i] = side.m_count ? side.cost(binning.m_extentScale) : btScalar(-1.);
+		}
+		side.init();
+		for (i=0;i<BT_BVH_NUM_BINS-1;i++)
+		{
+			side.merge(bins.m_bins[i]);
+			if (!side.m_count || rightCost[i+1]<btScalar(0.))
+				continue;
+			btScalar cost = side.cost(binning.m_extentScale)+rightCost[i+1];
+			if (cost<bestCost)
+			{
+				bestCost = cost;
+				bestBin = i;
+				bestCount = side.m_count;
+			}
+		}
+	}
+
+	//very uneven splits are replaced by a split in the middle, like buildTree does, to bound the depth of the tree
+	int minLeaves = numLeaves/16;
+	int splitIndex;
+	left.m_bounds.init();
+	right.m_bounds.init();
+	if (bestBin>=0 && bestCount>minLeaves && numLeaves-bestCount>minLeaves)
+	{
+		int i = range.m_startIndex;
+		int j = range.m_endIndex-1;
+		while (i<=j)
+		{
+			if (binning.getBin(leaves[i])<=bestBin)
+			{
+				left.m_bounds.add(leaves[i]);
+				i++;
+			} else
+			{
+				right.m_bounds.add(leaves[i]);
+				btQuantizedBvhNode tmp = leaves[i];
+				leaves[i] = leaves[j];
+				leaves[j] = tmp;
+				j--;
+			}
+		}
+		splitIndex = i;
+		btAssert(splitIndex-range.m_startIndex==bestCount);
+	} else
+	{
+		splitIndex = range.m_startIndex+(numLeaves>>1);
+		btComputeBuildBounds(leaves,range.m_startIndex,splitIndex,left.m_bounds);
+		btComputeBuildBounds(leaves,splitIndex,range.m_endIndex,right.m_bounds);
+	}
+
+	left.m_startIndex = range.m_startIndex;
+	left.m_endIndex = splitIndex;
+	left.m_nodeIndex = range.m_nodeIndex+1;
+	right.m_startIndex = splitIndex;
+	right.m_endIndex = range.m_endIndex;
+	right.m_nodeIndex = range.m_nodeIndex+2*(splitIndex-range.m_startIndex);
+}
+
+static void	btStoreInternalNode(btQuantizedBvhNode* nodes, const btBvhBuildRange& range)
+{
+	btQuantizedBvhNode& node = nodes[range.m_nodeIndex];
+	for (int i=0;i<3;i++)
+	{
+		node.m_quantizedAabbMin[i] = (unsigned short int)range.m_bounds.m_aabbMin[i];
+		node.m_quantizedAabbMax[i] = (unsigned short int)range.m_bounds.m_aabbMax[i];
+	}
+	//the escape index is the number of nodes of the subtree
+	node.m_escapeIndexOrTriangleIndex = -(2*(range.m_endIndex-range.m_startIndex)-1);
+}
+
+static void	btBuildBinnedSubtree(btQuantizedBvhNode* leaves, btQuantizedBvhNode* nodes, const btBvhBuildRange& root, const btVector3& extentScale)
+{
+	btAlignedObjectArray<btBvhBuildRange> stack;
+	stack.push_back(root);
+	btBvhBins bins;
+	while (stack.size())
+	{
+		btBvhBuildRange range = stack[stack.size()-1];
+		stack.pop_back();
+
+		if (range.m_endIndex-range.m_startIndex==1)
+		{
+			nodes[range.m_nodeIndex] = leaves[range.m_startIndex];
+			continue;
+		}
+		btStoreInternalNode(nodes,range);
+
+		btBvhBinning binning(range.m_bounds,extentScale);
+		bins.init();
+		bins.add(leaves,range.m_startIndex,range.m_endIndex,binning);
+		btBvhBuildRange left,right;
+		btSplitBinnedRange(leaves,range,binning,bins,left,right);
+		stack.push_back(right);
+		stack.push_back(left);
+	}
+}
+
+struct btBvhBinLeavesLoop : public btIParallelForBody
+{
+	const btQuantizedBvhNode*	m_leaves;
+	const btBvhBuildRange*	m_range;
+	const btBvhBinning*	m_binning;
+	btBvhBins*	m_chunkBins;
+	int		m_chunkSize;
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		for (int chunk=iBegin;chunk<iEnd;chunk++)
+		{
+			int startIndex = m_range->m_startIndex+chunk*m_chunkSize;
+			int endIndex = btMin(startIndex+m_chunkSize,m_range->m_endIndex);
+			m_chunkBins[chunk].init();
+			m_chunkBins[chunk].add(m_leaves,startIndex,endIndex,*m_binning);
+		}
+	}
+};
+
+struct btBvhRootBoundsLoop : public btIParallelForBody
+{
+	const btQuantizedBvhNode*	m_leaves;
+	btBvhBuildBounds*	m_chunkBounds;
+	int		m_numLeaves;
+	int		m_chunkSize;
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		for (int chunk=iBegin;chunk<iEnd;chunk++)
+		{
+			int startIndex = chunk*m_chunkSize;
+			btComputeBuildBounds(m_leaves,startIndex,btMin(startIndex+m_chunkSize,m_numLeaves),m_chunkBounds[chunk]);
+		}
+	}
+};
+
+struct btBvhBuildSubtreesLoop : public btIParallelForBody
+{
+	btQuantizedBvhNode*	m_leaves;
+	btQuantizedBvhNode*	m_nodes;
+	const btBvhBuildRange*	m_ranges;
+	btVector3	m_extentScale;
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			btBuildBinnedSubtree(m_leaves,m_nodes,m_ranges[i],m_extentScale);
+		}
+	}
+};
+
+void	btQuantizedBvh::buildQuantizedTreeBinned(int numLeafNodes)
+{
+	btAssert(m_useQuantization);
+	m_curNodeIndex = 0;
+	if (!numLeafNodes)
+		return;
+	m_curNodeIndex = 2*numLeafNodes-1;
+
+	btQuantizedBvhNode* leaves = &m_quantizedLeafNodes[0];
+	btQuantizedBvhNode* nodes = &m_quantizedContiguousNodes[0];
+	btVector3 extentScale = btVector3(btScalar(1.),btScalar(1.),btScalar(1.))/m_bvhQuantization;
+
+	int numChunks = btMin(BT_BVH_NUM_BINNING_CHUNKS,(numLeafNodes+BT_BVH_MAX_TASK_LEAVES-1)/BT_BVH_MAX_TASK_LEAVES);
+
+	btBvhBuildRange root;
+	root.m_startIndex = 0;
+	root.m_endIndex = numLeafNodes;
+	root.m_nodeIndex = 0;
+	{
+		btAlignedObjectArray<btBvhBuildBounds> chunkBounds;
+		chunkBounds.resize(numChunks);
+		btBvhRootBoundsLoop loop;
+		loop.m_leaves = leaves;
+		loop.m_chunkBounds = &chunkBounds[0];
+		loop.m_numLeaves = numLeafNodes;
+		loop.m_chunkSize = (numLeafNodes+numChunks-1)/numChunks;
+		btParallelFor(0,numChunks,1,loop);
+		root.m_bounds = chunkBounds[0];
+		for (int i=1;i<numChunks;i++)
+		{
+			root.m_bounds.merge(chunkBounds[i]);
+		}
+	}
+
+	//the top of the tree is split here, binning the leaves in parallel. The bins hold integer bounds and counts, so merging them in any order gives the same split.
+	btAlignedObjectArray<btBvhBuildRange> pending;
+	btAlignedObjectArray<btBvhBuildRange> tasks;
+	btAlignedObjectArray<btBvhBins> chunkBins;
+	chunkBins.resize(numChunks);
+	pending.push_back(root);
+	while (pending.size())
+	{
+		btBvhBuildRange range = pending[pending.size()-1];
+		pending.pop_back();
+		int numLeaves = range.m_endIndex-range.m_startIndex;
+		if (numLeaves<=BT_BVH_MAX_TASK_LEAVES)
+		{
+			tasks.push_back(range);
+			continue;
+		}
+		btStoreInternalNode(nodes,range);
+
+		int chunkSize = (numLeaves+numChunks-1)/numChunks;
+		btBvhBinning binning(range.m_bounds,extentScale);
+		btBvhBinLeavesLoop loop;
+		loop.m_leaves = leaves;
+		loop.m_range = &range;
+		loop.m_binning = &binning;
+		loop.m_chunkBins = &chunkBins[0];
+		loop.m_chunkSize = chunkSize;
+		int numRangeChunks = (numLeaves+chunkSize-1)/chunkSize;
+		btParallelFor(0,numRangeChunks,1,loop);
+		for (int i=1;i<numRangeChunks;i++)
+		{
+			chunkBins[0].merge(chunkBins[i]);
+		}
+
+		btBvhBuildRange left,right;
+		btSplitBinnedRange(leaves,range,binning,chunkBins[0],left,right);
+		pending.push_back(right);
+		pending.push_back(left);
+	}
+
+	btBvhBuildSubtreesLoop loop;
+	loop.m_leaves = leaves;
+	loop.m_nodes = nodes;
+	loop.m_ranges = &tasks[0];
+	loop.m_extentScale = extentScale;
+	btParallelFor(0,tasks.size(),1,loop);
+
+	buildSubtreeHeaders(0);
+}
+
+void	btQuantizedBvh::buildSubtreeHeaders(int nodeIndex)
+{
+	//same headers as buildTree creates: the children of nodes bigger than MAX_SUBTREE_SIZE_IN_BYTES, added after the headers of their subtrees
+	const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode())
+		return;
+	if (node.getEscapeIndex()*int(sizeof(btQuantizedBvhNode)) <= MAX_SUBTREE_SIZE_IN_BYTES)
+		return;
+
+	int leftChildNodeIndex = nodeIndex+1;
+	const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+	int rightChildNodeIndex = leftChildNodeIndex+(leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+	buildSubtreeHeaders(leftChildNodeIndex);
+	buildSubtreeHeaders(rightChildNodeIndex);
+	updateSubtreeHeaders(leftChildNodeIndex,rightChildNodeIndex);
+}
+
+
 int	btQuantizedBvh::sortAndCalcSplittingIndex(int startIndex,int endIndex,int splitAxis)
 {
 	int i;
@@ -305,6 +305,13 @@ protected:
 
 	void	buildTree	(int startIndex,int endIndex);
 
+	///buildQuantizedTreeBinned builds the same node layout as buildTree from m_quantizedLeafNodes, using binned surface area heuristic splits.
+	///A range of n leaves always takes 2n-1 nodes, so the subtrees are written at their final index and built in parallel with btParallelFor.
+	///The tree only depends on the leaves, not on the number of threads.
+	void	buildQuantizedTreeBinned(int numLeafNodes);
+
+	void	buildSubtreeHeaders(int nodeIndex);
+
 	int	calcSplittingAxis(int startIndex,int endIndex);
 
 	int	sortAndCalcSplittingIndex(int startIndex,int endIndex,int splitAxis);
@@ -452,12 +459,22 @@ public:
 		return	m_quantizedContiguousNodes;
 	}
 
+	SIMD_FORCE_INLINE const QuantizedNodeArray&	getQuantizedNodeArray() const
+	{
+		return	m_quantizedContiguousNodes;
+	}
+
 
 	SIMD_FORCE_INLINE BvhSubtreeInfoArray&	getSubtreeInfoArray()
 	{
 		return m_SubtreeHeaders;
 	}
 
+	SIMD_FORCE_INLINE const BvhSubtreeInfoArray&	getSubtreeInfoArray() const
+	{
+		return m_SubtreeHeaders;
+	}
+
 ////////////////////////////////////////////////////////////////////
 
 	/////Calculate space needed to store BVH for serialization
@@ -485,11 +502,21 @@ public:
 
 ////////////////////////////////////////////////////////////////////
 
-	SIMD_FORCE_INLINE bool isQuantized()
+	SIMD_FORCE_INLINE bool isQuantized() const
 	{
 		return m_useQuantization;
 	}
 
+	SIMD_FORCE_INLINE const btVector3&	getBvhAabbMin() const
+	{
+		return m_bvhAabbMin;
+	}
+
+	SIMD_FORCE_INLINE const btVector3&	getBvhQuantization() const
+	{
+		return m_bvhQuantization;
+	}
+
 private:
 	// Special "copy" constructor that allows for in-place deserialization
 	// Prevents btVector3's default constructor from being called, but doesn't inialize much else
@@ -50,6 +50,8 @@ btSimpleBroadphase::btSimpleBroadphase(int maxProxies, btOverlappingPairCache* o
 		m_pairCache = new (mem)btHashedOverlappingPairCache();
 		m_ownsPairCache = true;
 	}
+	///a btBatchedOverlappingPairCache only applies the pairs in updatePairs, which this broadphase doesn't call
+	btAssert(!m_pairCache->hasBatchedUpdate());
 
 	// allocate handles buffer and put all handles on free list
 	m_pHandlesRawPtr = btAlignedAlloc(sizeof(btSimpleBroadphaseProxy)*maxProxies,16);
@@ -0,0 +1,547 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btWideQuantizedBvh.h"
+#include "LinearMath/btAabbUtil2.h"
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BT_WIDE_BVH_SSE2
+#include <emmintrin.h>
+#endif
+
+//deeper trees are walked by recursion
+#define BT_WIDE_BVH_STACK_SIZE 128
+
+static SIMD_FORCE_INLINE short int btBiasQuantized(unsigned short int value)
+{
+	return (short int)(value ^ 0x8000);
+}
+
+static SIMD_FORCE_INLINE unsigned short int btUnbiasQuantized(short int value)
+{
+	return (unsigned short int)(value ^ 0x8000);
+}
+
+///btWideBvhQuery is a quantized query aabb, prepared for testing against all children of a btWideBvhNode
+struct btWideBvhQuery
+{
+#ifdef BT_WIDE_BVH_SSE2
+	//the lanes that don't belong to a test compare against the extreme values, so they never fail
+	__m128i	m_maxXY;
+	__m128i	m_maxZ;
+	__m128i	m_minX;
+	__m128i	m_minYZ;
+#else
+	short int	m_min[3];
+	short int	m_max[3];
+#endif
+
+	btWideBvhQuery(const unsigned short int* quantizedAabbMin, const unsigned short int* quantizedAabbMax)
+	{
+		short int minX = btBiasQuantized(quantizedAabbMin[0]);
+		short int minY = btBiasQuantized(quantizedAabbMin[1]);
+		short int minZ = btBiasQuantized(quantizedAabbMin[2]);
+		short int maxX = btBiasQuantized(quantizedAabbMax[0]);
+		short int maxY = btBiasQuantized(quantizedAabbMax[1]);
+		short int maxZ = btBiasQuantized(quantizedAabbMax[2]);
+#ifdef BT_WIDE_BVH_SSE2
+		const short int lowest = -0x7fff-1;
+		const short int highest = 0x7fff;
+		m_maxXY = _mm_set_epi16(maxY,maxY,maxY,maxY,maxX,maxX,maxX,maxX);
+		m_maxZ = _mm_set_epi16(highest,highest,highest,highest,maxZ,maxZ,maxZ,maxZ);
+		m_minX = _mm_set_epi16(minX,minX,minX,minX,lowest,lowest,lowest,lowest);
+		m_minYZ = _mm_set_epi16(minZ,minZ,minZ,minZ,minY,minY,minY,minY);
+#else
+		m_min[0] = minX; m_min[1] = minY; m_min[2] = minZ;
+		m_max[0] = maxX; m_max[1] = maxY; m_max[2] = maxZ;
+#endif
+	}
+
+	///returns a mask with bit 2*i set if child i of node overlaps the query
+	SIMD_FORCE_INLINE unsigned int	overlap(const btWideBvhNode& node) const
+	{
+#ifdef BT_WIDE_BVH_SSE2
+		const __m128i* bounds = (const __m128i*)&node.m_bounds[0];
+		__m128i minXY = _mm_load_si128(bounds);
+		__m128i minZmaxX = _mm_load_si128(bounds+1);
+		__m128i maxYZ = _mm_load_si128(bounds+2);
+		__m128i separated = _mm_or_si128(
+			_mm_or_si128(_mm_cmpgt_epi16(minXY,m_maxXY),_mm_cmpgt_epi16(minZmaxX,m_maxZ)),
+			_mm_or_si128(_mm_cmpgt_epi16(m_minX,minZmaxX),_mm_cmpgt_epi16(m_minYZ,maxYZ)));
+		//fold the second axis of each register onto the first
+		separated = _mm_or_si128(separated,_mm_srli_si128(separated,8));
+		return (~(unsigned int)_mm_movemask_epi8(separated)) & 0x55;
+#else
+		unsigned int mask = 0;
+		for (int i=0;i<4;i++)
+		{
+			bool overlap = (node.m_bounds[i] <= m_max[0]) & (node.m_bounds[4+i] <= m_max[1]) & (node.m_bounds[8+i] <= m_max[2])
+				& (node.m_bounds[12+i] >= m_min[0]) & (node.m_bounds[16+i] >= m_min[1]) & (node.m_bounds[20+i] >= m_min[2]);
+			mask |= overlap ? (1u<<(2*i)) : 0;
+		}
+		return mask;
+#endif
+	}
+};
+
+///btWideBvhRay does the slab test of btRayAabb2 for all children of a btWideBvhNode, the children are unquantized on the fly
+struct btWideBvhRay
+{
+#if defined (BT_WIDE_BVH_SSE2) && !defined (BT_USE_DOUBLE_PRECISION)
+	__m128	m_quantization[3];
+	__m128	m_lowerOffset[3];
+	__m128	m_upperOffset[3];
+	__m128	m_sourceLanes[3];
+	__m128	m_invDirectionLanes[3];
+	__m128	m_lambdaMaxLanes;
+	__m128	m_bvhAabbMinLanes[3];
+	int		m_lowerBounds[3];
+	int		m_upperBounds[3];
+#else
+	const btQuantizedBvh*	m_bvh;
+#endif
+	btVector3		m_source;
+	btVector3		m_invDirection;
+	unsigned int	m_sign[3];
+	btScalar		m_lambdaMax;
+	btVector3		m_aabbMin;
+	btVector3		m_aabbMax;
+
+	btWideBvhRay(const btQuantizedBvh* bvh, const btVector3& raySource, const btVector3& invDirection, const unsigned int sign[3], btScalar lambdaMax, const btVector3& aabbMin, const btVector3& aabbMax)
+		:m_source(raySource),
+		m_invDirection(invDirection),
+		m_lambdaMax(lambdaMax),
+		m_aabbMin(aabbMin),
+		m_aabbMax(aabbMax)
+	{
+		m_sign[0] = sign[0]; m_sign[1] = sign[1]; m_sign[2] = sign[2];
+#if defined (BT_WIDE_BVH_SSE2) && !defined (BT_USE_DOUBLE_PRECISION)
+		for (int axis=0;axis<3;axis++)
+		{
+			m_quantization[axis] = _mm_set1_ps(bvh->getBvhQuantization()[axis]);
+			//unQuantize adds the bvh minimum, then the cast extents are removed from the min and max bounds, in the same order as btQuantizedBvh
+			m_lowerOffset[axis] = _mm_set1_ps(sign[axis] ? aabbMin[axis] : aabbMax[axis]);
+			m_upperOffset[axis] = _mm_set1_ps(sign[axis] ? aabbMax[axis] : aabbMin[axis]);
+			m_sourceLanes[axis] = _mm_set1_ps(raySource[axis]);
+			m_invDirectionLanes[axis] = _mm_set1_ps(invDirection[axis]);
+			m_bvhAabbMinLanes[axis] = _mm_set1_ps(bvh->getBvhAabbMin()[axis]);
+			//the entering bound of the slab is the max bound for a negative direction
+			m_lowerBounds[axis] = sign[axis] ? 12+4*axis : 4*axis;
+			m_upperBounds[axis] = sign[axis] ? 4*axis : 12+4*axis;
+		}
+		m_lambdaMaxLanes = _mm_set1_ps(lambdaMax);
+#else
+		m_bvh = bvh;
+#endif
+	}
+
+#if defined (BT_WIDE_BVH_SSE2) && !defined (BT_USE_DOUBLE_PRECISION)
+	SIMD_FORCE_INLINE __m128	slab(const btWideBvhNode& node, int boundsIndex, int axis, const __m128& offset) const
+	{
+		__m128i biased = _mm_loadl_epi64((const __m128i*)&node.m_bounds[boundsIndex]);
+		__m128i quantized = _mm_unpacklo_epi16(_mm_xor_si128(biased,_mm_set1_epi16(-0x7fff-1)),_mm_setzero_si128());
+		__m128 bound = _mm_add_ps(_mm_div_ps(_mm_cvtepi32_ps(quantized),m_quantization[axis]),m_bvhAabbMinLanes[axis]);
+		bound = _mm_sub_ps(bound,offset);
+		return _mm_mul_ps(_mm_sub_ps(bound,m_sourceLanes[axis]),m_invDirectionLanes[axis]);
+	}
+#endif
+
+	///returns a mask with bit i set if the ray hits the aabb of child i of node, expanded by the cast extents
+	SIMD_FORCE_INLINE unsigned int	hit(const btWideBvhNode& node) const
+	{
+#if defined (BT_WIDE_BVH_SSE2) && !defined (BT_USE_DOUBLE_PRECISION)
+		__m128 tmin = slab(node,m_lowerBounds[0],0,m_lowerOffset[0]);
+		__m128 tmax = slab(node,m_upperBounds[0],0,m_upperOffset[0]);
+		__m128 tymin = slab(node,m_lowerBounds[1],1,m_lowerOffset[1]);
+		__m128 tymax = slab(node,m_upperBounds[1],1,m_upperOffset[1]);
+		__m128 miss = _mm_or_ps(_mm_cmpgt_ps(tmin,tymax),_mm_cmpgt_ps(tymin,tmax));
+		tmin = _mm_max_ps(tmin,tymin);
+		tmax = _mm_min_ps(tmax,tymax);
+		__m128 tzmin = slab(node,m_lowerBounds[2],2,m_lowerOffset[2]);
+		__m128 tzmax = slab(node,m_upperBounds[2],2,m_upperOffset[2]);
+		miss = _mm_or_ps(miss,_mm_or_ps(_mm_cmpgt_ps(tmin,tzmax),_mm_cmpgt_ps(tzmin,tmax)));
+		tmin = _mm_max_ps(tmin,tzmin);
+		tmax = _mm_min_ps(tmax,tzmax);
+		__m128 inside = _mm_and_ps(_mm_cmplt_ps(tmin,m_lambdaMaxLanes),_mm_cmpgt_ps(tmax,_mm_setzero_ps()));
+		return (unsigned int)_mm_movemask_ps(_mm_andnot_ps(miss,inside));
+#else
+		unsigned int mask = 0;
+		for (int i=0;i<4;i++)
+		{
+			unsigned short int quantizedMin[3];
+			unsigned short int quantizedMax[3];
+			for (int axis=0;axis<3;axis++)
+			{
+				quantizedMin[axis] = btUnbiasQuantized(node.m_bounds[4*axis+i]);
+				quantizedMax[axis] = btUnbiasQuantized(node.m_bounds[12+4*axis+i]);
+			}
+			btVector3 bounds[2];
+			bounds[0] = m_bvh->unQuantize(quantizedMin);
+			bounds[1] = m_bvh->unQuantize(quantizedMax);
+			bounds[0] -= m_aabbMax;
+			bounds[1] -= m_aabbMin;
+			btScalar param = 1.0;
+			if (btRayAabb2(m_source,m_invDirection,m_sign,bounds,param,0.0f,m_lambdaMax))
+				mask |= 1u<<i;
+		}
+		return mask;
+#endif
+	}
+};
+
+static SIMD_FORCE_INLINE void btProcessWideBvhLeaf(btNodeOverlapCallback* nodeCallback, int leaf)
+{
+	unsigned int partMask = (~0u)<<(31-MAX_NUM_PARTS_IN_BITS);
+	nodeCallback->processNode(leaf>>(31-MAX_NUM_PARTS_IN_BITS),leaf&~partMask);
+}
+
+
+btWideQuantizedBvh::btWideQuantizedBvh()
+:m_bvh(0)
+{
+}
+
+void	btWideQuantizedBvh::build(const btQuantizedBvh* bvh)
+{
+	m_bvh = bvh;
+	m_nodes.resize(0);
+	m_parents.resize(0);
+	m_slotBinaryNodes.resize(0);
+	m_binaryLeafSlots.resize(0);
+	m_dirtyFlags.resize(0);
+	btAssert(bvh->isQuantized());
+	if (!bvh->isQuantized() || !bvh->getQuantizedNodeArray().size())
+		return;
+
+	//every wide node but the root removes at least one internal binary node, so half the binary node count is always enough
+	int maxNumNodes = bvh->getQuantizedNodeArray().size()/2+1;
+	m_nodes.reserve(maxNumNodes);
+	m_parents.reserve(maxNumNodes);
+	m_slotBinaryNodes.reserve(4*maxNumNodes);
+	m_binaryLeafSlots.resize(bvh->getQuantizedNodeArray().size(),-1);
+	m_nodes.resize(1);
+	m_parents.resize(1,-1);
+	m_slotBinaryNodes.resize(4);
+	buildNode(0,0);
+	m_dirtyFlags.resize(m_nodes.size(),0);
+}
+
+static SIMD_FORCE_INLINE void btGetBinaryChildren(const QuantizedNodeArray& nodes, int nodeIndex, int& leftChild, int& rightChild)
+{
+	leftChild = nodeIndex+1;
+	rightChild = nodes[leftChild].isLeafNode() ? leftChild+1 : leftChild+nodes[leftChild].getEscapeIndex();
+}
+
+static SIMD_FORCE_INLINE btScalar btQuantizedSurface(const btQuantizedBvhNode& node, const btVector3& extentScale)
+{
+	//the quantization is different for each axis, extentScale converts the extents back to the scale of the mesh
+	btScalar x = btScalar(node.m_quantizedAabbMax[0]-node.m_quantizedAabbMin[0])*extentScale.getX();
+	btScalar y = btScalar(node.m_quantizedAabbMax[1]-node.m_quantizedAabbMin[1])*extentScale.getY();
+	btScalar z = btScalar(node.m_quantizedAabbMax[2]-node.m_quantizedAabbMin[2])*extentScale.getZ();
+	return x*y+y*z+z*x;
+}
+
+void	btWideQuantizedBvh::buildNode(int wideNodeIndex, int binaryNodeIndex)
+{
+	const QuantizedNodeArray& nodes = m_bvh->getQuantizedNodeArray();
+	btVector3 extentScale = btVector3(btScalar(1.),btScalar(1.),btScalar(1.))/m_bvh->getBvhQuantization();
+
+	int slots[4];
+	int numSlots = 1;
+	slots[0] = binaryNodeIndex;
+
+	//open the internal node with the largest surface until there are 4 children, so the wide node keeps the best splits of the binary tree
+	while (numSlots<4)
+	{
+		int best = -1;
+		btScalar bestSurface = btScalar(-1.);
+		for (int i=0;i<numSlots;i++)
+		{
+			if (!nodes[slots[i]].isLeafNode())
+			{
+				btScalar surface = btQuantizedSurface(nodes[slots[i]],extentScale);
+				if (surface>bestSurface)
+				{
+					best = i;
+					bestSurface = surface;
+				}
+			}
+		}
+		if (best<0)
+			break;
+
+		int leftChild,rightChild;
+		btGetBinaryChildren(nodes,slots[best],leftChild,rightChild);
+		for (int i=numSlots;i>best+1;i--)
+		{
+			slots[i] = slots[i-1];
+		}
+		slots[best] = leftChild;
+		slots[best+1] = rightChild;
+		numSlots++;
+	}
+
+	//the internal children are allocated next to each other
+	int firstChild = m_nodes.size();
+	int numInternal = 0;
+	int i;
+	for (i=0;i<numSlots;i++)
+	{
+		if (!nodes[slots[i]].isLeafNode())
+			numInternal++;
+	}
+	m_nodes.resize(firstChild+numInternal);
+	m_parents.resize(firstChild+numInternal,wideNodeIndex);
+	m_slotBinaryNodes.resize(4*(firstChild+numInternal));
+
+	btWideBvhNode& node = m_nodes[wideNodeIndex];
+	int childIndex = firstChild;
+	for (i=0;i<4;i++)
+	{
+		if (i<numSlots)
+		{
+			const btQuantizedBvhNode& child = nodes[slots[i]];
+			for (int axis=0;axis<3;axis++)
+			{
+				node.m_bounds[4*axis+i] = btBiasQuantized(child.m_quantizedAabbMin[axis]);
+				node.m_bounds[12+4*axis+i] = btBiasQuantized(child.m_quantizedAabbMax[axis]);
+			}
+			node.m_children[i] = child.isLeafNode() ? child.m_escapeIndexOrTriangleIndex : ~(childIndex++);
+			m_slotBinaryNodes[4*wideNodeIndex+i] = slots[i];
+			if (child.isLeafNode())
+				m_binaryLeafSlots[slots[i]] = 4*wideNodeIndex+i;
+		} else
+		{
+			//an empty aabb, the child is skipped if a query covers the whole bvh
+			for (int axis=0;axis<3;axis++)
+			{
+				node.m_bounds[4*axis+i] = btBiasQuantized(0xffff);
+				node.m_bounds[12+4*axis+i] = btBiasQuantized(0);
+			}
+			node.m_children[i] = EMPTY_CHILD;
+			m_slotBinaryNodes[4*wideNodeIndex+i] = -1;
+		}
+	}
+
+	childIndex = firstChild;
+	for (i=0;i<numSlots;i++)
+	{
+		if (!nodes[slots[i]].isLeafNode())
+		{
+			buildNode(childIndex++,slots[i]);
+		}
+	}
+}
+
+void	btWideQuantizedBvh::refitNode(int wideNodeIndex)
+{
+	const QuantizedNodeArray& nodes = m_bvh->getQuantizedNodeArray();
+	btWideBvhNode& node = m_nodes[wideNodeIndex];
+	for (int i=0;i<4;i++)
+	{
+		int child = node.m_children[i];
+		if (child==EMPTY_CHILD)
+			continue;
+		if (child>=0)
+		{
+			const btQuantizedBvhNode& leaf = nodes[m_slotBinaryNodes[4*wideNodeIndex+i]];
+			for (int axis=0;axis<3;axis++)
+			{
+				node.m_bounds[4*axis+i] = btBiasQuantized(leaf.m_quantizedAabbMin[axis]);
+				node.m_bounds[12+4*axis+i] = btBiasQuantized(leaf.m_quantizedAabbMax[axis]);
+			}
+		} else
+		{
+			//the union of the children of the child, its empty slots never win the min or max
+			const btWideBvhNode& childNode = m_nodes[~child];
+			for (int axis=0;axis<3;axis++)
+			{
+				const short int* childMin = &childNode.m_bounds[4*axis];
+				const short int* childMax = &childNode.m_bounds[12+4*axis];
+				node.m_bounds[4*axis+i] = btMin(btMin(childMin[0],childMin[1]),btMin(childMin[2],childMin[3]));
+				node.m_bounds[12+4*axis+i] = btMax(btMax(childMax[0],childMax[1]),btMax(childMax[2],childMax[3]));
+			}
+		}
+	}
+}
+
+void	btWideQuantizedBvh::refit()
+{
+	//the children of a node are allocated after it, so going backwards refits every node after its children
+	for (int i=m_nodes.size()-1;i>=0;i--)
+	{
+		refitNode(i);
+	}
+}
+
+struct btWideBvhDescendingSortPredicate
+{
+	bool operator() ( const int& a, const int& b ) const
+	{
+		return a > b;
+	}
+};
+
+void	btWideQuantizedBvh::refitPartial(const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	if (!m_nodes.size())
+		return;
+
+	//the same subtrees as btOptimizedBvh::refitPartial
+	unsigned short int quantizedQueryAabbMin[3];
+	unsigned short int quantizedQueryAabbMax[3];
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMin,aabbMin,0);
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMax,aabbMax,1);
+
+	//mark the nodes of the leaves in these subtrees and all their ancestors, stopping at ancestors that are already marked
+	const QuantizedNodeArray& nodes = m_bvh->getQuantizedNodeArray();
+	const BvhSubtreeInfoArray& subtrees = m_bvh->getSubtreeInfoArray();
+	m_dirtyNodes.resize(0);
+	for (int i=0;i<subtrees.size();i++)
+	{
+		const btBvhSubtreeInfo& subtree = subtrees[i];
+		if (!testQuantizedAabbAgainstQuantizedAabb(quantizedQueryAabbMin,quantizedQueryAabbMax,subtree.m_quantizedAabbMin,subtree.m_quantizedAabbMax))
+			continue;
+		int endNode = subtree.m_rootNodeIndex+subtree.m_subtreeSize;
+		for (int j=subtree.m_rootNodeIndex;j<endNode;j++)
+		{
+			if (!nodes[j].isLeafNode())
+				continue;
+			btAssert(m_binaryLeafSlots[j]>=0);
+			for (int node = m_binaryLeafSlots[j]>>2; node>=0 && !m_dirtyFlags[node]; node = m_parents[node])
+			{
+				m_dirtyFlags[node] = 1;
+				m_dirtyNodes.push_back(node);
+			}
+		}
+	}
+
+	//children before their parents
+	m_dirtyNodes.quickSort(btWideBvhDescendingSortPredicate());
+	for (int i=0;i<m_dirtyNodes.size();i++)
+	{
+		refitNode(m_dirtyNodes[i]);
+		m_dirtyFlags[m_dirtyNodes[i]] = 0;
+	}
+}
+
+void	btWideQuantizedBvh::walkTree(btNodeOverlapCallback* nodeCallback, const unsigned short int* quantizedQueryAabbMin, const unsigned short int* quantizedQueryAabbMax, int rootNodeIndex) const
+{
+	btWideBvhQuery query(quantizedQueryAabbMin,quantizedQueryAabbMax);
+
+	int stack[BT_WIDE_BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = rootNodeIndex;
+	while (stackSize)
+	{
+		const btWideBvhNode& node = m_nodes[stack[--stackSize]];
+		unsigned int overlap = query.overlap(node);
+		//children are pushed in reverse, so they are visited in order
+		for (int i=3;i>=0;i--)
+		{
+			if (overlap & (1u<<(2*i)))
+			{
+				int child = node.m_children[i];
+				if (child>=0)
+				{
+					btProcessWideBvhLeaf(nodeCallback,child);
+				} else if (child!=EMPTY_CHILD)
+				{
+					if (stackSize<BT_WIDE_BVH_STACK_SIZE)
+						stack[stackSize++] = ~child;
+					else
+						walkTree(nodeCallback,quantizedQueryAabbMin,quantizedQueryAabbMax,~child);
+				}
+			}
+		}
+	}
+}
+
+void	btWideQuantizedBvh::walkTreeAgainstRay(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax, int rootNodeIndex) const
+{
+	//same tests as btQuantizedBvh::walkStacklessQuantizedTreeAgainstRay: the quantized ray aabb prunes all children at once, the ray is tested against the ones that are left
+	btVector3 rayDirection = (rayTarget-raySource);
+	rayDirection.normalize ();
+	btScalar lambda_max = rayDirection.dot(rayTarget-raySource);
+	rayDirection[0] = rayDirection[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDirection[0];
+	rayDirection[1] = rayDirection[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDirection[1];
+	rayDirection[2] = rayDirection[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDirection[2];
+	unsigned int sign[3] = { rayDirection[0] < 0.0, rayDirection[1] < 0.0, rayDirection[2] < 0.0};
+
+	btVector3 rayAabbMin = raySource;
+	btVector3 rayAabbMax = raySource;
+	rayAabbMin.setMin(rayTarget);
+	rayAabbMax.setMax(rayTarget);
+	rayAabbMin += aabbMin;
+	rayAabbMax += aabbMax;
+
+	unsigned short int quantizedQueryAabbMin[3];
+	unsigned short int quantizedQueryAabbMax[3];
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMin,rayAabbMin,0);
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMax,rayAabbMax,1);
+	btWideBvhQuery query(quantizedQueryAabbMin,quantizedQueryAabbMax);
+	btWideBvhRay ray(m_bvh,raySource,rayDirection,sign,lambda_max,aabbMin,aabbMax);
+
+	int stack[BT_WIDE_BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = rootNodeIndex;
+	while (stackSize)
+	{
+		const btWideBvhNode& node = m_nodes[stack[--stackSize]];
+		unsigned int overlap = query.overlap(node);
+		if (!overlap)
+			continue;
+		unsigned int hit = ray.hit(node);
+		for (int i=3;i>=0;i--)
+		{
+			if (!(overlap & (1u<<(2*i))) || !(hit & (1u<<i)))
+				continue;
+			int child = node.m_children[i];
+			if (child>=0)
+			{
+				btProcessWideBvhLeaf(nodeCallback,child);
+			} else if (child!=EMPTY_CHILD)
+			{
+				if (stackSize<BT_WIDE_BVH_STACK_SIZE)
+					stack[stackSize++] = ~child;
+				else
+					walkTreeAgainstRay(nodeCallback,raySource,rayTarget,aabbMin,aabbMax,~child);
+			}
+		}
+	}
+}
+
+void	btWideQuantizedBvh::reportAabbOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	if (!m_nodes.size())
+		return;
+	unsigned short int quantizedQueryAabbMin[3];
+	unsigned short int quantizedQueryAabbMax[3];
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMin,aabbMin,0);
+	m_bvh->quantizeWithClamp(quantizedQueryAabbMax,aabbMax,1);
+	walkTree(nodeCallback,quantizedQueryAabbMin,quantizedQueryAabbMax,0);
+}
+
+void	btWideQuantizedBvh::reportRayOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget) const
+{
+	reportBoxCastOverlappingNodex(nodeCallback,raySource,rayTarget,btVector3(0,0,0),btVector3(0,0,0));
+}
+
+void	btWideQuantizedBvh::reportBoxCastOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	if (!m_nodes.size())
+		return;
+	walkTreeAgainstRay(nodeCallback,raySource,rayTarget,aabbMin,aabbMax,0);
+}
@@ -0,0 +1,99 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_WIDE_QUANTIZED_BVH_H
+#define BT_WIDE_QUANTIZED_BVH_H
+
+#include "btQuantizedBvh.h"
+
+///btWideBvhNode stores the quantized aabbs of up to 4 children, one 64 byte cache line per node.
+///The bounds are kept per axis for all children, so one SIMD compare tests an axis of all children at once.
+///They are stored with the sign bit flipped (value^0x8000), so signed 16 bit compares order them like the unsigned values.
+ATTRIBUTE_ALIGNED16	(struct) btWideBvhNode
+{
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	//48 bytes: minX[4] minY[4], minZ[4] maxX[4], maxY[4] maxZ[4]
+	short int	m_bounds[24];
+	//16 bytes: >=0 is a leaf with the same part/triangle packing as btQuantizedBvhNode, <0 is ~(child node index)
+	int			m_children[4];
+};
+
+typedef btAlignedObjectArray<btWideBvhNode>	WideBvhNodeArray;
+
+///btWideQuantizedBvh is a 4-ary copy of a quantized btQuantizedBvh, built by collapsing the binary tree.
+///The children of a node are stored next to each other in depth-first order, so a query reads the siblings of a node from adjacent cache lines.
+///The leaves that are reported are the same as for the btQuantizedBvh it was built from, the order can differ.
+///The source btQuantizedBvh is used to quantize queries and has to outlive the wide bvh. Rebuild the wide bvh after the source is rebuilt,
+///call refit or refitPartial after the source is refit: the tree keeps its layout and only the bounds of the changed nodes are updated.
+class btWideQuantizedBvh
+{
+	WideBvhNodeArray	m_nodes;
+
+	const btQuantizedBvh*	m_bvh;
+
+	//for the refits: the parent of every node, the binary node of every child slot (4 per node, -1 if empty)
+	//and the child slot of every binary leaf as 4*node+slot
+	btAlignedObjectArray<int>	m_parents;
+	btAlignedObjectArray<int>	m_slotBinaryNodes;
+	btAlignedObjectArray<int>	m_binaryLeafSlots;
+	btAlignedObjectArray<int>	m_dirtyNodes;
+	btAlignedObjectArray<unsigned char>	m_dirtyFlags;
+
+	void	buildNode(int wideNodeIndex, int binaryNodeIndex);
+
+	void	refitNode(int wideNodeIndex);
+
+	void	walkTree(btNodeOverlapCallback* nodeCallback, const unsigned short int* quantizedQueryAabbMin, const unsigned short int* quantizedQueryAabbMax, int rootNodeIndex) const;
+
+	void	walkTreeAgainstRay(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax, int rootNodeIndex) const;
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	enum
+	{
+		EMPTY_CHILD = ~0x7fffffff
+	};
+
+	btWideQuantizedBvh();
+
+	///build collapses the quantized tree of bvh, non-quantized trees are not supported
+	void	build(const btQuantizedBvh* bvh);
+
+	///refit updates the bounds of all nodes from the leaves of the source bvh, after btOptimizedBvh::refit
+	void	refit();
+
+	///refitPartial updates the nodes above the leaves of the source subtrees that overlap the aabb, after btOptimizedBvh::refitPartial
+	///with the same aabb. The nodes are refit bottom-up and only once, the rest of the tree isn't touched
+	void	refitPartial(const btVector3& aabbMin, const btVector3& aabbMax);
+
+	int		getNumNodes() const
+	{
+		return m_nodes.size();
+	}
+
+	const WideBvhNodeArray&	getNodeArray() const
+	{
+		return m_nodes;
+	}
+
+	void	reportAabbOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& aabbMin, const btVector3& aabbMax) const;
+	void	reportRayOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget) const;
+	void	reportBoxCastOverlappingNodex(btNodeOverlapCallback* nodeCallback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax) const;
+};
+
+#endif //BT_WIDE_QUANTIZED_BVH_H
@@ -21,11 +21,15 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
 
 #include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletCollision/CollisionShapes/btCompoundShape.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
 #include "LinearMath/btPoolAllocator.h"
+#include "LinearMath/btThreadSafePoolAllocator.h"
 #include "BulletCollision/CollisionDispatch/btCollisionConfiguration.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
 
 int gNumManifold = 0;
 
@@ -33,10 +37,46 @@ int gNumManifold = 0;
 #include <stdio.h>
 #endif
 
+///manifold creation and removal is deferred while pairs are processed in parallel, and replayed in pair order afterwards
+struct btDispatcherManifoldEvent
+{
+	btPersistentManifold*	m_manifold;
+	int		m_pairIndex;
+	int		m_eventIndex;
+	bool	m_release;
+};
+
+class btSortManifoldEventPredicate
+{
+public:
+	bool operator() ( const btDispatcherManifoldEvent& lhs, const btDispatcherManifoldEvent& rhs ) const
+	{
+		if (lhs.m_pairIndex != rhs.m_pairIndex)
+			return lhs.m_pairIndex < rhs.m_pairIndex;
+		return lhs.m_eventIndex < rhs.m_eventIndex;
+	}
+};
+
+struct btDispatcherThreadLocalData
+{
+	btAlignedObjectArray<btDispatcherManifoldEvent>	m_manifoldEvents;
+
+	int		m_pairIndex;
+	int		m_eventIndex;
+
+	btDispatcherThreadLocalData()
+		:m_pairIndex(0),
+		m_eventIndex(0)
+	{
+	}
+};
+
 
 btCollisionDispatcher::btCollisionDispatcher (btCollisionConfiguration* collisionConfiguration): 
 m_dispatcherFlags(btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD),
-	m_collisionConfiguration(collisionConfiguration)
+	m_collisionConfiguration(collisionConfiguration),
+	m_parallelDispatchActive(false),
+	m_parallelDispatchGrainSize(40)
 {
 	int i;
 
@@ -46,6 +86,12 @@ m_dispatcherFlags(btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESH
 
 	m_persistentManifoldPoolAllocator = collisionConfiguration->getPersistentManifoldPool();
 
+	///the thread safe allocators take over the pools of the collision configuration as their first page, and grow by pages of the same size
+	void* mem = btAlignedAlloc(sizeof(btThreadSafePoolAllocator),16);
+	m_collisionAlgorithmAllocator = new(mem) btThreadSafePoolAllocator(m_collisionAlgorithmPoolAllocator,m_collisionAlgorithmPoolAllocator->getMaxCount());
+	mem = btAlignedAlloc(sizeof(btThreadSafePoolAllocator),16);
+	m_persistentManifoldAllocator = new(mem) btThreadSafePoolAllocator(m_persistentManifoldPoolAllocator,m_persistentManifoldPoolAllocator->getMaxCount());
+
 	for (i=0;i<MAX_BROADPHASE_COLLISION_TYPES;i++)
 	{
 		for (int j=0;j<MAX_BROADPHASE_COLLISION_TYPES;j++)
@@ -66,16 +112,35 @@ void btCollisionDispatcher::registerCollisionCreateFunc(int proxyType0, int prox
 
 btCollisionDispatcher::~btCollisionDispatcher()
 {
+	for (int i=0;i<m_threadLocalData.size();i++)
+	{
+		btDispatcherThreadLocalData* data = m_threadLocalData[i];
+		data->~btDispatcherThreadLocalData();
+		btAlignedFree(data);
+	}
+	m_persistentManifoldAllocator->~btThreadSafePoolAllocator();
+	btAlignedFree(m_persistentManifoldAllocator);
+	m_collisionAlgorithmAllocator->~btThreadSafePoolAllocator();
+	btAlignedFree(m_collisionAlgorithmAllocator);
 }
 
-btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1) 
-{ 
-	gNumManifold++;
-	
-	//btAssert(gNumManifold < 65535);
-	
+btDispatcherThreadLocalData*	btCollisionDispatcher::getThreadLocalData()
+{
+	return m_threadLocalData[btGetCurrentThreadIndex()];
+}
 
+void	btCollisionDispatcher::prepareThreadLocalData(int numThreads)
+{
+	while (m_threadLocalData.size() < numThreads)
+	{
+		void* mem = btAlignedAlloc(sizeof(btDispatcherThreadLocalData),16);
+		btDispatcherThreadLocalData* data = new(mem) btDispatcherThreadLocalData();
+		m_threadLocalData.push_back(data);
+	}
+}
 
+btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1) 
+{ 
 	//optional relative contact breaking threshold, turned on by default (use setDispatcherFlags to switch off feature for improved performance)
 	
 	btScalar contactBreakingThreshold =  (m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ? 
@@ -84,25 +149,33 @@ btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObj
 
 	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(),body1->getContactProcessingThreshold());
 		
-	void* mem = 0;
-	
-	if (m_persistentManifoldPoolAllocator->getFreeCount())
-	{
-		mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
-	} else
+	btDispatcherThreadLocalData* threadData = m_parallelDispatchActive ? getThreadLocalData() : 0;
+
+	//when the pool overflows, by default it grows by another page. If we require a contiguous contact pool then assert.
+	void* mem = m_persistentManifoldAllocator->allocate(sizeof(btPersistentManifold),(m_dispatcherFlags&CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION)==0);
+	if (!mem)
 	{
-		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
-		if ((m_dispatcherFlags&CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION)==0)
-		{
-			mem = btAlignedAlloc(sizeof(btPersistentManifold),16);
-		} else
-		{
-			btAssert(0);
-			//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration
-			return 0;
-		}
+		btAssert(0);
+		//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration
+		return 0;
 	}
 	btPersistentManifold* manifold = new(mem) btPersistentManifold (body0,body1,0,contactBreakingThreshold,contactProcessingThreshold);
+
+	if (threadData)
+	{
+		btDispatcherManifoldEvent event;
+		event.m_manifold = manifold;
+		event.m_pairIndex = threadData->m_pairIndex;
+		event.m_eventIndex = threadData->m_eventIndex++;
+		event.m_release = false;
+		threadData->m_manifoldEvents.push_back(event);
+		return manifold;
+	}
+
+	gNumManifold++;
+	
+	//btAssert(gNumManifold < 65535);
+
 	manifold->m_index1a = m_manifoldsPtr.size();
 	m_manifoldsPtr.push_back(manifold);
 
@@ -117,6 +190,17 @@ void btCollisionDispatcher::clearManifold(btPersistentManifold* manifold)
 	
 void btCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
 {
+	if (m_parallelDispatchActive)
+	{
+		btDispatcherThreadLocalData* threadData = getThreadLocalData();
+		btDispatcherManifoldEvent event;
+		event.m_manifold = manifold;
+		event.m_pairIndex = threadData->m_pairIndex;
+		event.m_eventIndex = threadData->m_eventIndex++;
+		event.m_release = true;
+		threadData->m_manifoldEvents.push_back(event);
+		return;
+	}
 	
 	gNumManifold--;
 
@@ -130,13 +214,7 @@ void btCollisionDispatcher::releaseManifold(btPersistentManifold* manifold)
 	m_manifoldsPtr.pop_back();
 
 	manifold->~btPersistentManifold();
-	if (m_persistentManifoldPoolAllocator->validPtr(manifold))
-	{
-		m_persistentManifoldPoolAllocator->freeMemory(manifold);
-	} else
-	{
-		btAlignedFree(manifold);
-	}
+	m_persistentManifoldAllocator->freeMemory(manifold);
 	
 }
 
@@ -235,8 +313,142 @@ public:
 
 
 
+///the GImpact algorithms lock and unlock the child shapes of the btGImpactShapeInterface, which is shared by all pairs of the shape.
+///Compound children are checked too, the compound algorithm dispatches them to their own algorithms.
+static bool	btIsParallelDispatchSafeShape(const btCollisionShape* shape)
+{
+	if (shape->getShapeType()==GIMPACT_SHAPE_PROXYTYPE)
+		return false;
+	if (shape->isCompound())
+	{
+		const btCompoundShape* compoundShape = (const btCompoundShape*)shape;
+		for (int i=0;i<compoundShape->getNumChildShapes();i++)
+		{
+			if (!btIsParallelDispatchSafeShape(compoundShape->getChildShape(i)))
+				return false;
+		}
+	}
+	return true;
+}
+
+///the default collision algorithms only modify their own pair and manifolds, the soft body algorithms also modify the soft body
+///and the GImpact algorithms modify the shape, those pairs are processed on the main thread
+static bool	btIsParallelDispatchSafe(const btBroadphasePair& pair)
+{
+	const int safeTypes = btCollisionObject::CO_COLLISION_OBJECT | btCollisionObject::CO_RIGID_BODY | btCollisionObject::CO_GHOST_OBJECT;
+	const btCollisionObject* colObj0 = (const btCollisionObject*)pair.m_pProxy0->m_clientObject;
+	const btCollisionObject* colObj1 = (const btCollisionObject*)pair.m_pProxy1->m_clientObject;
+	return (colObj0->getInternalType() & safeTypes) && (colObj1->getInternalType() & safeTypes)
+		&& btIsParallelDispatchSafeShape(colObj0->getCollisionShape()) && btIsParallelDispatchSafeShape(colObj1->getCollisionShape());
+}
+
+struct btParallelDispatchLoop : public btIParallelForBody
+{
+	btCollisionDispatcher*	m_dispatcher;
+	btDispatcherThreadLocalData**	m_threadLocalData;
+	btBroadphasePair*	m_pairs;
+	const btDispatcherInfo&	m_dispatchInfo;
+
+	btParallelDispatchLoop(btCollisionDispatcher* dispatcher,btDispatcherThreadLocalData** threadLocalData,btBroadphasePair* pairs,const btDispatcherInfo& dispatchInfo)
+		:m_dispatcher(dispatcher),
+		m_threadLocalData(threadLocalData),
+		m_pairs(pairs),
+		m_dispatchInfo(dispatchInfo)
+	{
+	}
+
+	virtual void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("dispatchPairsTask");
+		btDispatcherThreadLocalData* threadData = m_threadLocalData[btGetCurrentThreadIndex()];
+		btNearCallback nearCallback = m_dispatcher->getNearCallback();
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			if (btIsParallelDispatchSafe(m_pairs[i]))
+			{
+				threadData->m_pairIndex = i;
+				threadData->m_eventIndex = 0;
+				(*nearCallback)(m_pairs[i],*m_dispatcher,m_dispatchInfo);
+			}
+		}
+	}
+};
+
+void	btCollisionDispatcher::dispatchAllCollisionPairsParallel(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo)
+{
+	int numPairs = pairCache->getNumOverlappingPairs();
+	btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+
+	prepareThreadLocalData(btGetTaskScheduler()->getNumThreads());
+
+	m_parallelDispatchActive = true;
+
+	btParallelDispatchLoop dispatchLoop(this,&m_threadLocalData[0],pairs,dispatchInfo);
+	btParallelFor(0,numPairs,m_parallelDispatchGrainSize,dispatchLoop);
+
+	///the remaining pairs are processed on the main thread, still deferring manifold changes so they are merged in pair order
+	btDispatcherThreadLocalData* mainThreadData = m_threadLocalData[0];
+	for (int i=0;i<numPairs;i++)
+	{
+		if (!btIsParallelDispatchSafe(pairs[i]))
+		{
+			mainThreadData->m_pairIndex = i;
+			mainThreadData->m_eventIndex = 0;
+			(*m_nearCallback)(pairs[i],*this,dispatchInfo);
+		}
+	}
+
+	m_parallelDispatchActive = false;
+
+	mergeThreadLocalData();
+}
+
+///mergeThreadLocalData applies the deferred manifold changes in the same order as the sequential dispatch would, so the manifold array doesn't depend on the number of threads
+void	btCollisionDispatcher::mergeThreadLocalData()
+{
+	btAssert(!m_parallelDispatchActive);
+
+	btAlignedObjectArray<btDispatcherManifoldEvent> events;
+	int i,j;
+	for (i=0;i<m_threadLocalData.size();i++)
+	{
+		btDispatcherThreadLocalData* threadData = m_threadLocalData[i];
+		for (j=0;j<threadData->m_manifoldEvents.size();j++)
+		{
+			events.push_back(threadData->m_manifoldEvents[j]);
+		}
+		threadData->m_manifoldEvents.resize(0);
+	}
+
+	events.quickSort(btSortManifoldEventPredicate());
+
+	for (i=0;i<events.size();i++)
+	{
+		btPersistentManifold* manifold = events[i].m_manifold;
+		if (events[i].m_release)
+		{
+			releaseManifold(manifold);
+		} else
+		{
+			gNumManifold++;
+			manifold->m_index1a = m_manifoldsPtr.size();
+			m_manifoldsPtr.push_back(manifold);
+		}
+	}
+}
+
 void	btCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher) 
 {
+	if ((m_dispatcherFlags & CD_ENABLE_PARALLEL_DISPATCH) &&
+		(dispatchInfo.m_dispatchFunc == btDispatcherInfo::DISPATCH_DISCRETE) &&
+		btIsMainThread() && !btThreadsAreRunning() &&
+		(btGetTaskScheduler()->getNumThreads() > 1) &&
+		(pairCache->getNumOverlappingPairs() > m_parallelDispatchGrainSize))
+	{
+		dispatchAllCollisionPairsParallel(pairCache,dispatchInfo);
+		return;
+	}
+
 	//m_blockedForChanges = true;
 
 	btCollisionPairCallback	collisionCallback(dispatchInfo,this);
@@ -293,22 +505,10 @@ void btCollisionDispatcher::defaultNearCallback(btBroadphasePair& collisionPair,
 
 void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 {
-	if (m_collisionAlgorithmPoolAllocator->getFreeCount())
-	{
-		return m_collisionAlgorithmPoolAllocator->allocate(size);
-	}
-	
-	//warn user for overflow?
-	return	btAlignedAlloc(static_cast<size_t>(size), 16);
+	return m_collisionAlgorithmAllocator->allocate(size);
 }
 
 void btCollisionDispatcher::freeCollisionAlgorithm(void* ptr)
 {
-	if (m_collisionAlgorithmPoolAllocator->validPtr(ptr))
-	{
-		m_collisionAlgorithmPoolAllocator->freeMemory(ptr);
-	} else
-	{
-		btAlignedFree(ptr);
-	}
+	m_collisionAlgorithmAllocator->freeMemory(ptr);
 }
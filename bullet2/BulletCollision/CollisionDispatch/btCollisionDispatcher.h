@@ -27,7 +27,9 @@ subject to the following restrictions:
 class btIDebugDraw;
 class btOverlappingPairCache;
 class btPoolAllocator;
+class btThreadSafePoolAllocator;
 class btCollisionConfiguration;
+struct btDispatcherThreadLocalData;
 
 #include "btCollisionCreateFunc.h"
 
@@ -57,10 +59,29 @@ protected:
 
 	btPoolAllocator*	m_persistentManifoldPoolAllocator;
 
+	///all collision algorithms and manifolds are allocated from these, they can be used from any thread of the task scheduler
+	btThreadSafePoolAllocator*	m_collisionAlgorithmAllocator;
+
+	btThreadSafePoolAllocator*	m_persistentManifoldAllocator;
+
 	btCollisionAlgorithmCreateFunc* m_doubleDispatch[MAX_BROADPHASE_COLLISION_TYPES][MAX_BROADPHASE_COLLISION_TYPES];
 
 	btCollisionConfiguration*	m_collisionConfiguration;
 
+	///per-thread deferred manifold changes, used while the pairs are processed in parallel
+	btAlignedObjectArray<btDispatcherThreadLocalData*>	m_threadLocalData;
+
+	bool	m_parallelDispatchActive;
+
+	int		m_parallelDispatchGrainSize;
+
+	btDispatcherThreadLocalData*	getThreadLocalData();
+
+	void	prepareThreadLocalData(int numThreads);
+
+	void	mergeThreadLocalData();
+
+	void	dispatchAllCollisionPairsParallel(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo);
 
 public:
 
@@ -68,7 +89,10 @@ public:
 	{
 		CD_STATIC_STATIC_REPORTED = 1,
 		CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD = 2,
-		CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION = 4
+		CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION = 4,
+		///CD_ENABLE_PARALLEL_DISPATCH processes the overlapping pairs using btParallelFor, when the task scheduler has more than one thread.
+		///The near callback, collision algorithms and contact callbacks need to be thread safe. Pairs involving soft bodies or user types are processed on the main thread.
+		CD_ENABLE_PARALLEL_DISPATCH = 8
 	};
 
 	int	getDispatcherFlags() const
@@ -123,6 +147,17 @@ public:
 	
 	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher) ;
 
+	///number of pairs that a thread processes at once, when CD_ENABLE_PARALLEL_DISPATCH is set
+	void	setParallelDispatchGrainSize(int grainSize)
+	{
+		m_parallelDispatchGrainSize = grainSize;
+	}
+
+	int		getParallelDispatchGrainSize() const
+	{
+		return m_parallelDispatchGrainSize;
+	}
+
 	void	setNearCallback(btNearCallback	nearCallback)
 	{
 		m_nearCallback = nearCallback; 
@@ -155,6 +190,7 @@ public:
 		m_collisionConfiguration = config;
 	}
 
+	///the free elements of this pool were taken over by getPersistentManifoldAllocator
 	virtual	btPoolAllocator*	getInternalManifoldPool()
 	{
 		return m_persistentManifoldPoolAllocator;
@@ -165,6 +201,17 @@ public:
 		return m_persistentManifoldPoolAllocator;
 	}
 
+	///the hit and miss counters of these allocators show how often the pools had to grow
+	btThreadSafePoolAllocator*	getPersistentManifoldAllocator()
+	{
+		return m_persistentManifoldAllocator;
+	}
+
+	btThreadSafePoolAllocator*	getCollisionAlgorithmAllocator()
+	{
+		return m_collisionAlgorithmAllocator;
+	}
+
 };
 
 #endif //BT_COLLISION__DISPATCHER_H
@@ -37,7 +37,9 @@ btCollisionObject::btCollisionObject()
 		m_hitFraction(btScalar(1.)),
 		m_ccdSweptSphereRadius(btScalar(0.)),
 		m_ccdMotionThreshold(btScalar(0.)),
-		m_checkCollideWith(false)
+		m_checkCollideWith(false),
+		m_activationListener(0),
+		m_islandObjectIndex(-1)
 {
 	m_worldTransform.setIdentity();
 }
@@ -49,12 +51,20 @@ btCollisionObject::~btCollisionObject()
 void btCollisionObject::setActivationState(int newState) const
 { 
 	if ( (m_activationState1 != DISABLE_DEACTIVATION) && (m_activationState1 != DISABLE_SIMULATION))
+	{
+		bool wasActive = isActive();
 		m_activationState1 = newState;
+		if (m_activationListener && !wasActive && isActive())
+			m_activationListener->collisionObjectActivated(this);
+	}
 }
 
 void btCollisionObject::forceActivationState(int newState) const
 {
+	bool wasActive = isActive();
 	m_activationState1 = newState;
+	if (m_activationListener && !wasActive && isActive())
+		m_activationListener->collisionObjectActivated(this);
 }
 
 void btCollisionObject::activate(bool forceActivation) const
@@ -27,6 +27,7 @@ subject to the following restrictions:
 
 struct	btBroadphaseProxy;
 class	btCollisionShape;
+class	btCollisionObject;
 struct btCollisionShapeData;
 #include "LinearMath/btMotionState.h"
 #include "LinearMath/btAlignedAllocator.h"
@@ -34,6 +35,14 @@ struct btCollisionShapeData;
 
 typedef btAlignedObjectArray<class btCollisionObject*> btCollisionObjectArray;
 
+///btCollisionObjectActivationListener is notified when a sleeping collision object becomes active, see btCollisionObject::setActivationListener
+struct btCollisionObjectActivationListener
+{
+	virtual ~btCollisionObjectActivationListener() {}
+
+	virtual void	collisionObjectActivated(const btCollisionObject* colObj) = 0;
+};
+
 #ifdef BT_USE_DOUBLE_PRECISION
 #define btCollisionObjectData btCollisionObjectDoubleData
 #define btCollisionObjectDataName "btCollisionObjectDoubleData"
@@ -105,6 +114,10 @@ protected:
 	/// If some object should have elaborate collision filtering by sub-classes
 	int			m_checkCollideWith;
 
+	///m_activationListener and m_islandObjectIndex are used by the btSimulationIslandManager for persistent islands
+	btCollisionObjectActivationListener*	m_activationListener;
+	int			m_islandObjectIndex;
+
 	virtual bool	checkCollideWithOverride(const btCollisionObject* /* co */) const
 	{
 		return true;
@@ -241,6 +254,28 @@ public:
 
 	void	activate(bool forceActivation = false) const;
 
+	///the activation listener is called by setActivationState, forceActivationState and activate when the object stops sleeping
+	void	setActivationListener(btCollisionObjectActivationListener* listener)
+	{
+		m_activationListener = listener;
+	}
+
+	btCollisionObjectActivationListener*	getActivationListener() const
+	{
+		return m_activationListener;
+	}
+
+	///the index in the island objects of the current frame with persistent islands, -1 if the object isn't one of them
+	int		getIslandObjectIndex() const
+	{
+		return m_islandObjectIndex;
+	}
+
+	void	setIslandObjectIndex(int index)
+	{
+		m_islandObjectIndex = index;
+	}
+
 	SIMD_FORCE_INLINE bool isActive() const
 	{
 		return ((getActivationState() != ISLAND_SLEEPING) && (getActivationState() != DISABLE_SIMULATION));
@@ -33,6 +33,7 @@ subject to the following restrictions:
 #include "LinearMath/btQuickprof.h"
 #include "LinearMath/btStackAlloc.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
 
@@ -199,6 +200,12 @@ void	btCollisionWorld::updateAabbs()
 	{
 		btCollisionObject* colObj = m_collisionObjects[i];
 
+		//let the broadphase park the proxies of sleeping objects, so their pairs are not re-tested every frame
+		if (!colObj->isStaticOrKinematicObject() && colObj->getBroadphaseHandle())
+		{
+			m_broadphasePairCache->setProxyDormant(colObj->getBroadphaseHandle(),!colObj->isActive(),m_dispatcher1);
+		}
+
 		//only update aabb of active objects
 		if (m_forceUpdateAllAabbs || colObj->isActive())
 		{
@@ -989,6 +996,19 @@ struct btSingleSweepCallback : public btBroadphaseRayCallback
 
 
 
+/* Compute AABB that encompasses angular movement */
+static void	btCalculateSweepAabb(const btConvexShape* castShape, const btTransform& convexFromTrans, const btTransform& convexToTrans, btVector3& castShapeAabbMin, btVector3& castShapeAabbMax)
+{
+	btVector3 linVel, angVel;
+	btTransformUtil::calculateVelocity (convexFromTrans, convexToTrans, 1.0f, linVel, angVel);
+	btVector3 zeroLinVel;
+	zeroLinVel.setValue(0,0,0);
+	btTransform R;
+	R.setIdentity ();
+	R.setRotation (convexFromTrans.getRotation());
+	castShape->calculateTemporalAabb (R, zeroLinVel, angVel, 1.0f, castShapeAabbMin, castShapeAabbMax);
+}
+
 void	btCollisionWorld::convexSweepTest(const btConvexShape* castShape, const btTransform& convexFromWorld, const btTransform& convexToWorld, ConvexResultCallback& resultCallback, btScalar allowedCcdPenetration) const
 {
 
@@ -1003,17 +1023,7 @@ void	btCollisionWorld::convexSweepTest(const btConvexShape* castShape, const btT
 	convexFromTrans = convexFromWorld;
 	convexToTrans = convexToWorld;
 	btVector3 castShapeAabbMin, castShapeAabbMax;
-	/* Compute AABB that encompasses angular movement */
-	{
-		btVector3 linVel, angVel;
-		btTransformUtil::calculateVelocity (convexFromTrans, convexToTrans, 1.0f, linVel, angVel);
-		btVector3 zeroLinVel;
-		zeroLinVel.setValue(0,0,0);
-		btTransform R;
-		R.setIdentity ();
-		R.setRotation (convexFromTrans.getRotation());
-		castShape->calculateTemporalAabb (R, zeroLinVel, angVel, 1.0f, castShapeAabbMin, castShapeAabbMax);
-	}
+	btCalculateSweepAabb(castShape,convexFromTrans,convexToTrans,castShapeAabbMin,castShapeAabbMax);
 
 #ifndef USE_BRUTEFORCE_RAYBROADPHASE
 
@@ -1051,6 +1061,178 @@ void	btCollisionWorld::convexSweepTest(const btConvexShape* castShape, const btT
 }
 
 
+///number of rays or sweeps that traverse the broadphase together in rayTestBatch and convexSweepTestBatch
+#define BT_BATCHED_QUERY_PACKET_SIZE 32
+
+///the callbacks of a packet have no default constructor, they are constructed in place in aligned storage
+struct btBatchedRayPacket
+{
+	ATTRIBUTE_ALIGNED16(char)	m_resultCallbacks[BT_BATCHED_QUERY_PACKET_SIZE*sizeof(btCollisionWorld::ClosestRayResultCallback)];
+	ATTRIBUTE_ALIGNED16(char)	m_rayCallbacks[BT_BATCHED_QUERY_PACKET_SIZE*sizeof(btSingleRayCallback)];
+	btBroadphaseRayCallback*	m_rayCallbackPtrs[BT_BATCHED_QUERY_PACKET_SIZE];
+
+	btCollisionWorld::ClosestRayResultCallback*	getResultCallbacks() { return (btCollisionWorld::ClosestRayResultCallback*)m_resultCallbacks; }
+	btSingleRayCallback*	getRayCallbacks() { return (btSingleRayCallback*)m_rayCallbacks; }
+};
+
+struct btRayTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld*	m_world;
+	btBroadphaseInterface*	m_broadphase;
+	const btVector3*	m_rayFromWorld;
+	const btVector3*	m_rayToWorld;
+	int	m_numRays;
+	btCollisionWorld::BatchedQueryResult*	m_results;
+	short int	m_collisionFilterGroup;
+	short int	m_collisionFilterMask;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("rayTestBatchTask");
+		btBatchedRayPacket packet;
+		btCollisionWorld::ClosestRayResultCallback* resultCallbacks = packet.getResultCallbacks();
+		btSingleRayCallback* rayCallbacks = packet.getRayCallbacks();
+		for (int p=iBegin;p<iEnd;p++)
+		{
+			int first = p*BT_BATCHED_QUERY_PACKET_SIZE;
+			int count = btMin(m_numRays-first,BT_BATCHED_QUERY_PACKET_SIZE);
+			for (int i=0;i<count;i++)
+			{
+				const btVector3& rayFrom = m_rayFromWorld[first+i];
+				const btVector3& rayTo = m_rayToWorld[first+i];
+				btCollisionWorld::ClosestRayResultCallback* resultCallback = new (&resultCallbacks[i]) btCollisionWorld::ClosestRayResultCallback(rayFrom,rayTo);
+				resultCallback->m_collisionFilterGroup = m_collisionFilterGroup;
+				resultCallback->m_collisionFilterMask = m_collisionFilterMask;
+				packet.m_rayCallbackPtrs[i] = new (&rayCallbacks[i]) btSingleRayCallback(rayFrom,rayTo,m_world,*resultCallback);
+			}
+			m_broadphase->rayTestPacket(count,&m_rayFromWorld[first],&m_rayToWorld[first],packet.m_rayCallbackPtrs);
+			for (int i=0;i<count;i++)
+			{
+				btCollisionWorld::BatchedQueryResult& result = m_results[first+i];
+				result.m_collisionObject = resultCallbacks[i].m_collisionObject;
+				result.m_hitPointWorld = resultCallbacks[i].m_hitPointWorld;
+				result.m_hitNormalWorld = resultCallbacks[i].m_hitNormalWorld;
+				result.m_hitFraction = resultCallbacks[i].m_closestHitFraction;
+				rayCallbacks[i].~btSingleRayCallback();
+				resultCallbacks[i].~ClosestRayResultCallback();
+			}
+		}
+	}
+};
+
+void	btCollisionWorld::rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchedQueryResult* results, short int collisionFilterGroup, short int collisionFilterMask) const
+{
+	BT_PROFILE("rayTestBatch");
+	btRayTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_broadphase = m_broadphasePairCache;
+	loop.m_rayFromWorld = rayFromWorld;
+	loop.m_rayToWorld = rayToWorld;
+	loop.m_numRays = numRays;
+	loop.m_results = results;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	loop.m_collisionFilterMask = collisionFilterMask;
+
+	int numPackets = (numRays+BT_BATCHED_QUERY_PACKET_SIZE-1)/BT_BATCHED_QUERY_PACKET_SIZE;
+	if (m_broadphasePairCache->isRayTestPacketReentrant())
+	{
+		btParallelFor(0,numPackets,1,loop);
+	} else
+	{
+		loop.forLoop(0,numPackets);
+	}
+}
+
+struct btBatchedSweepPacket
+{
+	ATTRIBUTE_ALIGNED16(char)	m_resultCallbacks[BT_BATCHED_QUERY_PACKET_SIZE*sizeof(btCollisionWorld::ClosestConvexResultCallback)];
+	ATTRIBUTE_ALIGNED16(char)	m_sweepCallbacks[BT_BATCHED_QUERY_PACKET_SIZE*sizeof(btSingleSweepCallback)];
+	btBroadphaseRayCallback*	m_sweepCallbackPtrs[BT_BATCHED_QUERY_PACKET_SIZE];
+	btVector3	m_rayFrom[BT_BATCHED_QUERY_PACKET_SIZE];
+	btVector3	m_rayTo[BT_BATCHED_QUERY_PACKET_SIZE];
+	btVector3	m_castShapeAabbMin[BT_BATCHED_QUERY_PACKET_SIZE];
+	btVector3	m_castShapeAabbMax[BT_BATCHED_QUERY_PACKET_SIZE];
+
+	btCollisionWorld::ClosestConvexResultCallback*	getResultCallbacks() { return (btCollisionWorld::ClosestConvexResultCallback*)m_resultCallbacks; }
+	btSingleSweepCallback*	getSweepCallbacks() { return (btSingleSweepCallback*)m_sweepCallbacks; }
+};
+
+struct btConvexSweepTestBatchLoop : public btIParallelForBody
+{
+	const btCollisionWorld*	m_world;
+	btBroadphaseInterface*	m_broadphase;
+	const btConvexShape* const*	m_castShapes;
+	const btTransform*	m_fromWorld;
+	const btTransform*	m_toWorld;
+	int	m_numSweeps;
+	btCollisionWorld::BatchedQueryResult*	m_results;
+	btScalar	m_allowedCcdPenetration;
+	short int	m_collisionFilterGroup;
+	short int	m_collisionFilterMask;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("convexSweepTestBatchTask");
+		btBatchedSweepPacket packet;
+		btCollisionWorld::ClosestConvexResultCallback* resultCallbacks = packet.getResultCallbacks();
+		btSingleSweepCallback* sweepCallbacks = packet.getSweepCallbacks();
+		for (int p=iBegin;p<iEnd;p++)
+		{
+			int first = p*BT_BATCHED_QUERY_PACKET_SIZE;
+			int count = btMin(m_numSweeps-first,BT_BATCHED_QUERY_PACKET_SIZE);
+			for (int i=0;i<count;i++)
+			{
+				const btTransform& fromTrans = m_fromWorld[first+i];
+				const btTransform& toTrans = m_toWorld[first+i];
+				packet.m_rayFrom[i] = fromTrans.getOrigin();
+				packet.m_rayTo[i] = toTrans.getOrigin();
+				btCalculateSweepAabb(m_castShapes[first+i],fromTrans,toTrans,packet.m_castShapeAabbMin[i],packet.m_castShapeAabbMax[i]);
+				btCollisionWorld::ClosestConvexResultCallback* resultCallback = new (&resultCallbacks[i]) btCollisionWorld::ClosestConvexResultCallback(packet.m_rayFrom[i],packet.m_rayTo[i]);
+				resultCallback->m_collisionFilterGroup = m_collisionFilterGroup;
+				resultCallback->m_collisionFilterMask = m_collisionFilterMask;
+				packet.m_sweepCallbackPtrs[i] = new (&sweepCallbacks[i]) btSingleSweepCallback(m_castShapes[first+i],fromTrans,toTrans,m_world,*resultCallback,m_allowedCcdPenetration);
+			}
+			m_broadphase->rayTestPacket(count,packet.m_rayFrom,packet.m_rayTo,packet.m_sweepCallbackPtrs,packet.m_castShapeAabbMin,packet.m_castShapeAabbMax);
+			for (int i=0;i<count;i++)
+			{
+				btCollisionWorld::BatchedQueryResult& result = m_results[first+i];
+				result.m_collisionObject = resultCallbacks[i].m_hitCollisionObject;
+				result.m_hitPointWorld = resultCallbacks[i].m_hitPointWorld;
+				result.m_hitNormalWorld = resultCallbacks[i].m_hitNormalWorld;
+				result.m_hitFraction = resultCallbacks[i].m_closestHitFraction;
+				sweepCallbacks[i].~btSingleSweepCallback();
+				resultCallbacks[i].~ClosestConvexResultCallback();
+			}
+		}
+	}
+};
+
+void	btCollisionWorld::convexSweepTestBatch(const btConvexShape* const* castShapes, const btTransform* fromWorld, const btTransform* toWorld, int numSweeps, BatchedQueryResult* results, btScalar allowedCcdPenetration, short int collisionFilterGroup, short int collisionFilterMask) const
+{
+	BT_PROFILE("convexSweepTestBatch");
+	btConvexSweepTestBatchLoop loop;
+	loop.m_world = this;
+	loop.m_broadphase = m_broadphasePairCache;
+	loop.m_castShapes = castShapes;
+	loop.m_fromWorld = fromWorld;
+	loop.m_toWorld = toWorld;
+	loop.m_numSweeps = numSweeps;
+	loop.m_results = results;
+	loop.m_allowedCcdPenetration = allowedCcdPenetration;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	loop.m_collisionFilterMask = collisionFilterMask;
+
+	int numPackets = (numSweeps+BT_BATCHED_QUERY_PACKET_SIZE-1)/BT_BATCHED_QUERY_PACKET_SIZE;
+	if (m_broadphasePairCache->isRayTestPacketReentrant())
+	{
+		btParallelFor(0,numPackets,1,loop);
+	} else
+	{
+		loop.forLoop(0,numPackets);
+	}
+}
+
+
 
 struct btBridgedManifoldResult : public btManifoldResult
 {
@@ -426,6 +426,16 @@ public:
 
 
 
+	///BatchedQueryResult is the closest hit of one ray or sweep of rayTestBatch and convexSweepTestBatch.
+	///m_collisionObject is 0 and m_hitFraction is 1 when nothing was hit
+	struct	BatchedQueryResult
+	{
+		const btCollisionObject*	m_collisionObject;
+		btVector3	m_hitPointWorld;
+		btVector3	m_hitNormalWorld;
+		btScalar	m_hitFraction;
+	};
+
 	int	getNumCollisionObjects() const
 	{
 		return int(m_collisionObjects.size());
@@ -439,6 +449,14 @@ public:
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value return by the callback.
 	void    convexSweepTest (const btConvexShape* castShape, const btTransform& from, const btTransform& to, ConvexResultCallback& resultCallback,  btScalar allowedCcdPenetration = btScalar(0.)) const;
 
+	///rayTestBatch casts numRays rays and stores the closest hit of ray i in results[i].
+	///Packets of consecutive rays traverse the broadphase together, so coherent rays should be adjacent. The packets are spread over the threads of the
+	///task scheduler (see btThreads.h) when the broadphase supports concurrent packet queries, so the collision shapes must support concurrent ray tests.
+	void	rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchedQueryResult* results, short int collisionFilterGroup=btBroadphaseProxy::DefaultFilter, short int collisionFilterMask=btBroadphaseProxy::AllFilter) const;
+
+	///convexSweepTestBatch sweeps castShapes[i] from fromWorld[i] to toWorld[i] and stores the closest hit in results[i], see rayTestBatch
+	void	convexSweepTestBatch(const btConvexShape* const* castShapes, const btTransform* fromWorld, const btTransform* toWorld, int numSweeps, BatchedQueryResult* results, btScalar allowedCcdPenetration = btScalar(0.), short int collisionFilterGroup=btBroadphaseProxy::DefaultFilter, short int collisionFilterMask=btBroadphaseProxy::AllFilter) const;
+
 	///contactTest performs a discrete collision test between colObj against all objects in the btCollisionWorld, and calls the resultCallback.
 	///it reports one or more contact points for every overlapping object (including the one with deepest penetration)
 	void	contactTest(btCollisionObject* colObj, ContactResultCallback& resultCallback);
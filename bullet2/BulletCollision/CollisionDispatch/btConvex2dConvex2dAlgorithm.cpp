@@ -122,7 +122,9 @@ void btConvex2dConvex2dAlgorithm ::processCollision (const btCollisionObjectWrap
 
 		btGjkPairDetector::ClosestPointInput input;
 
-		btGjkPairDetector	gjkPairDetector(min0,min1,m_simplexSolver,m_pdSolver);
+		///the simplex solver is shared by all algorithms of a collision configuration, use a local copy so pairs can be processed concurrently
+		btSimplexSolverInterface	simplexSolver(*m_simplexSolver);
+		btGjkPairDetector	gjkPairDetector(min0,min1,&simplexSolver,m_pdSolver);
 		//TODO: if (dispatchInfo.m_useContinuous)
 		gjkPairDetector.setMinkowskiA(min0);
 		gjkPairDetector.setMinkowskiB(min1);
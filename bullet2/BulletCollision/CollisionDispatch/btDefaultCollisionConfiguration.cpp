@@ -24,6 +24,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btSphereSphereCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btSphereBoxCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btSphereTriangleCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btHeightfieldConvexCollisionAlgorithm.h"
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
 #include "BulletCollision/NarrowPhaseCollision/btMinkowskiPenetrationDepthSolver.h"
 #include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
@@ -91,16 +92,30 @@ btDefaultCollisionConfiguration::btDefaultCollisionConfiguration(const btDefault
 	mem = btAlignedAlloc (sizeof(btConvexPlaneCollisionAlgorithm::CreateFunc),16);
 	m_planeConvexCF = new (mem) btConvexPlaneCollisionAlgorithm::CreateFunc;
 	m_planeConvexCF->m_swapped = true;
+
+	//sphere, capsule and box versus heightfield, optional
+	m_convexHeightfieldCF = 0;
+	m_heightfieldConvexCF = 0;
+	if (constructionInfo.m_useHeightfieldCollisionAlgorithm)
+	{
+		mem = btAlignedAlloc (sizeof(btHeightfieldConvexCollisionAlgorithm::CreateFunc),16);
+		m_convexHeightfieldCF = new (mem) btHeightfieldConvexCollisionAlgorithm::CreateFunc;
+		mem = btAlignedAlloc (sizeof(btHeightfieldConvexCollisionAlgorithm::CreateFunc),16);
+		m_heightfieldConvexCF = new (mem) btHeightfieldConvexCollisionAlgorithm::CreateFunc;
+		m_heightfieldConvexCF->m_swapped = true;
+	}
 	
 	///calculate maximum element size, big enough to fit any collision algorithm in the memory pool
 	int maxSize = sizeof(btConvexConvexAlgorithm);
 	int maxSize2 = sizeof(btConvexConcaveCollisionAlgorithm);
 	int maxSize3 = sizeof(btCompoundCollisionAlgorithm);
+	int maxSize4 = sizeof(btHeightfieldConvexCollisionAlgorithm);
 	int sl = sizeof(btConvexSeparatingDistanceUtil);
 	sl = sizeof(btGjkPairDetector);
 	int	collisionAlgorithmMaxElementSize = btMax(maxSize,constructionInfo.m_customCollisionAlgorithmMaxElementSize);
 	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize,maxSize2);
 	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize,maxSize3);
+	collisionAlgorithmMaxElementSize = btMax(collisionAlgorithmMaxElementSize,maxSize4);
 
 	if (constructionInfo.m_stackAlloc)
 	{
@@ -194,6 +209,14 @@ btDefaultCollisionConfiguration::~btDefaultCollisionConfiguration()
 	m_planeConvexCF->~btCollisionAlgorithmCreateFunc();
 	btAlignedFree( m_planeConvexCF);
 
+	if (m_convexHeightfieldCF)
+	{
+		m_convexHeightfieldCF->~btCollisionAlgorithmCreateFunc();
+		btAlignedFree( m_convexHeightfieldCF);
+		m_heightfieldConvexCF->~btCollisionAlgorithmCreateFunc();
+		btAlignedFree( m_heightfieldConvexCF);
+	}
+
 	m_simplexSolver->~btVoronoiSimplexSolver();
 	btAlignedFree(m_simplexSolver);
 
@@ -248,6 +271,19 @@ btCollisionAlgorithmCreateFunc* btDefaultCollisionConfiguration::getCollisionAlg
 	{
 		return m_planeConvexCF;
 	}
+
+	if (m_convexHeightfieldCF)
+	{
+		if (btHeightfieldConvexCollisionAlgorithm::isSupportedConvex(proxyType0) && (proxyType1 == TERRAIN_SHAPE_PROXYTYPE))
+		{
+			return m_convexHeightfieldCF;
+		}
+
+		if (btHeightfieldConvexCollisionAlgorithm::isSupportedConvex(proxyType1) && (proxyType0 == TERRAIN_SHAPE_PROXYTYPE))
+		{
+			return m_heightfieldConvexCF;
+		}
+	}
 	
 
 
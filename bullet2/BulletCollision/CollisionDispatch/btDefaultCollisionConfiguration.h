@@ -30,6 +30,8 @@ struct	btDefaultCollisionConstructionInfo
 	int					m_customCollisionAlgorithmMaxElementSize;
 	int					m_defaultStackAllocatorSize;
 	int					m_useEpaPenetrationAlgorithm;
+	///collide spheres, capsules and boxes with btHeightfieldTerrainShape using btHeightfieldConvexCollisionAlgorithm instead of btConvexConcaveCollisionAlgorithm
+	bool				m_useHeightfieldCollisionAlgorithm;
 
 	btDefaultCollisionConstructionInfo()
 		:m_stackAlloc(0),
@@ -39,7 +41,8 @@ struct	btDefaultCollisionConstructionInfo
 		m_defaultMaxCollisionAlgorithmPoolSize(4096),
 		m_customCollisionAlgorithmMaxElementSize(0),
 		m_defaultStackAllocatorSize(0),
-		m_useEpaPenetrationAlgorithm(true)
+		m_useEpaPenetrationAlgorithm(true),
+		m_useHeightfieldCollisionAlgorithm(false)
 	{
 	}
 };
@@ -86,6 +89,8 @@ protected:
 	btCollisionAlgorithmCreateFunc*	m_triangleSphereCF;
 	btCollisionAlgorithmCreateFunc*	m_planeConvexCF;
 	btCollisionAlgorithmCreateFunc*	m_convexPlaneCF;
+	btCollisionAlgorithmCreateFunc*	m_convexHeightfieldCF;
+	btCollisionAlgorithmCreateFunc*	m_heightfieldConvexCF;
 	
 public:
 
@@ -0,0 +1,596 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btHeightfieldConvexCollisionAlgorithm.h"
+
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+#include "BulletCollision/CollisionDispatch/btManifoldResult.h"
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/CollisionShapes/btCapsuleShape.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+
+btHeightfieldConvexCollisionAlgorithm::btHeightfieldConvexCollisionAlgorithm(btPersistentManifold* mf,const btCollisionAlgorithmConstructionInfo& ci,const btCollisionObjectWrapper* col0Wrap,const btCollisionObjectWrapper* col1Wrap, bool isSwapped)
+: btCollisionAlgorithm(ci),
+m_ownManifold(false),
+m_manifoldPtr(mf),
+m_isSwapped(isSwapped)
+{
+	const btCollisionObjectWrapper* convexObjWrap = m_isSwapped? col1Wrap : col0Wrap;
+	const btCollisionObjectWrapper* terrainObjWrap = m_isSwapped? col0Wrap : col1Wrap;
+
+	if (!m_manifoldPtr && m_dispatcher->needsCollision(convexObjWrap->getCollisionObject(),terrainObjWrap->getCollisionObject()))
+	{
+		m_manifoldPtr = m_dispatcher->getNewManifold(convexObjWrap->getCollisionObject(),terrainObjWrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+}
+
+
+btHeightfieldConvexCollisionAlgorithm::~btHeightfieldConvexCollisionAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+
+///closest point on triangle abc to p, from 'Real-Time Collision Detection' by Christer Ericson.
+///Returns true if the closest point is in the interior of the face.
+static bool	btClosestPointOnTriangle(const btVector3& p,const btVector3& a,const btVector3& b,const btVector3& c,btVector3& closest)
+{
+	btVector3 ab = b-a;
+	btVector3 ac = c-a;
+	btVector3 ap = p-a;
+	btScalar d1 = ab.dot(ap);
+	btScalar d2 = ac.dot(ap);
+	if (d1<=btScalar(0.) && d2<=btScalar(0.))
+	{
+		closest = a;
+		return false;
+	}
+
+	btVector3 bp = p-b;
+	btScalar d3 = ab.dot(bp);
+	btScalar d4 = ac.dot(bp);
+	if (d3>=btScalar(0.) && d4<=d3)
+	{
+		closest = b;
+		return false;
+	}
+
+	btScalar vc = d1*d4-d3*d2;
+	if (vc<=btScalar(0.) && d1>=btScalar(0.) && d3<=btScalar(0.))
+	{
+		closest = a+ab*(d1/(d1-d3));
+		return false;
+	}
+
+	btVector3 cp = p-c;
+	btScalar d5 = ab.dot(cp);
+	btScalar d6 = ac.dot(cp);
+	if (d6>=btScalar(0.) && d5<=d6)
+	{
+		closest = c;
+		return false;
+	}
+
+	btScalar vb = d5*d2-d1*d6;
+	if (vb<=btScalar(0.) && d2>=btScalar(0.) && d6<=btScalar(0.))
+	{
+		closest = a+ac*(d2/(d2-d6));
+		return false;
+	}
+
+	btScalar va = d3*d6-d5*d4;
+	if (va<=btScalar(0.) && (d4-d3)>=btScalar(0.) && (d5-d6)>=btScalar(0.))
+	{
+		closest = b+(c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+		return false;
+	}
+
+	btScalar denom = btScalar(1.)/(va+vb+vc);
+	closest = a+ab*(vb*denom)+ac*(vc*denom);
+	return true;
+}
+
+///closest points between the segments p1q1 and p2q2, also from Ericson. s and t are the parameters of c1 and c2.
+static void	btClosestPointsSegmentSegment(const btVector3& p1,const btVector3& q1,const btVector3& p2,const btVector3& q2,btScalar& s,btScalar& t,btVector3& c1,btVector3& c2)
+{
+	btVector3 d1 = q1-p1;
+	btVector3 d2 = q2-p2;
+	btVector3 r = p1-p2;
+	btScalar a = d1.length2();
+	btScalar e = d2.length2();
+	btScalar f = d2.dot(r);
+
+	if (a<=SIMD_EPSILON && e<=SIMD_EPSILON)
+	{
+		s = t = btScalar(0.);
+	} else if (a<=SIMD_EPSILON)
+	{
+		s = btScalar(0.);
+		t = btClamped(f/e,btScalar(0.),btScalar(1.));
+	} else
+	{
+		btScalar c = d1.dot(r);
+		if (e<=SIMD_EPSILON)
+		{
+			t = btScalar(0.);
+			s = btClamped(-c/a,btScalar(0.),btScalar(1.));
+		} else
+		{
+			btScalar b = d1.dot(d2);
+			btScalar denom = a*e-b*b;
+			s = denom!=btScalar(0.) ? btClamped((b*f-c*e)/denom,btScalar(0.),btScalar(1.)) : btScalar(0.);
+			t = (b*s+f)/e;
+			if (t<btScalar(0.))
+			{
+				t = btScalar(0.);
+				s = btClamped(-c/a,btScalar(0.),btScalar(1.));
+			} else if (t>btScalar(1.))
+			{
+				t = btScalar(1.);
+				s = btClamped((b-c)/a,btScalar(0.),btScalar(1.));
+			}
+		}
+	}
+	c1 = p1+d1*s;
+	c2 = p2+d2*t;
+}
+
+
+///btHeightfieldContactAdder converts the contacts from the scaled local frame of the terrain to world space and adds the terrain margin
+struct btHeightfieldContactAdder
+{
+	btManifoldResult*	m_resultOut;
+	const btCollisionObject*	m_terrainObj;
+	btTransform	m_terrainTrans;
+	btScalar	m_margin;
+	btScalar	m_threshold;
+
+	//distance is measured from the terrain surface without margin to the convex, along normal
+	void	addContact(const btVector3& normal,const btVector3& pointOnTerrain,btScalar distance,int x,int y)
+	{
+		distance -= m_margin;
+		if (distance>=m_threshold)
+			return;
+		if (m_resultOut->getBody0Internal()==m_terrainObj)
+		{
+			m_resultOut->setShapeIdentifiersA(x,y);
+		} else
+		{
+			m_resultOut->setShapeIdentifiersB(x,y);
+		}
+		m_resultOut->addContactPoint(m_terrainTrans.getBasis()*normal,m_terrainTrans(pointOnTerrain+normal*m_margin),distance);
+	}
+};
+
+
+///btHeightfieldEdgeContact keeps the closest edge or vertex contact of a sphere or of the inside of a capsule.
+///Edges between triangles that are coplanar or form a valley would push sideways, so the contact is only added if it is closer than all face contacts of the sphere.
+struct btHeightfieldEdgeContact
+{
+	btVector3	m_normal;
+	btVector3	m_point;
+	btScalar	m_distance;
+	btScalar	m_minFaceDistance;
+	int			m_x;
+	int			m_y;
+
+	btHeightfieldEdgeContact()
+		:m_distance(BT_LARGE_FLOAT),
+		m_minFaceDistance(BT_LARGE_FLOAT)
+	{
+	}
+
+	void	update(const btVector3& normal,const btVector3& point,btScalar distance,int x,int y)
+	{
+		if (distance<m_distance)
+		{
+			m_normal = normal;
+			m_point = point;
+			m_distance = distance;
+			m_x = x;
+			m_y = y;
+		}
+	}
+
+	void	flush(btHeightfieldContactAdder& adder) const
+	{
+		if (m_distance<m_minFaceDistance)
+		{
+			adder.addContact(m_normal,m_point,m_distance,m_x,m_y);
+		}
+	}
+};
+
+
+static void	btCollideSphereTriangle(btHeightfieldContactAdder& adder,btHeightfieldEdgeContact& edgeContact,const btVector3& center,btScalar radius,const btVector3* triangle,const btVector3& normal,int x,int y)
+{
+	btScalar planeDistance = normal.dot(center-triangle[0]);
+	//centers more than the radius below the surface are left to the neighbouring triangles
+	if (planeDistance-radius-adder.m_margin>=adder.m_threshold || planeDistance<-radius)
+		return;
+
+	btVector3 closest;
+	if (btClosestPointOnTriangle(center,triangle[0],triangle[1],triangle[2],closest))
+	{
+		adder.addContact(normal,center-normal*planeDistance,planeDistance-radius,x,y);
+		edgeContact.m_minFaceDistance = btMin(edgeContact.m_minFaceDistance,planeDistance-radius);
+		return;
+	}
+	//edges and vertices only push away from the upper side
+	if (planeDistance<=btScalar(0.))
+		return;
+	btVector3 diff = center-closest;
+	btScalar dist = diff.length();
+	btVector3 contactNormal = dist>SIMD_EPSILON ? diff/dist : normal;
+	edgeContact.update(contactNormal,closest,dist-radius,x,y);
+}
+
+
+static void	btCollideSegmentTriangle(btHeightfieldEdgeContact& edgeContact,const btVector3& p0,const btVector3& p1,btScalar radius,const btVector3* triangle,const btVector3& normal,int x,int y)
+{
+	//the inside of the segment can only be closest to an edge, for example a capsule lying across a ridge
+	for (int i=0;i<3;i++)
+	{
+		const btVector3& e0 = triangle[i];
+		const btVector3& e1 = triangle[(i+1)%3];
+		const btVector3& opposite = triangle[(i+2)%3];
+		btScalar s,t;
+		btVector3 onSegment,onEdge;
+		btClosestPointsSegmentSegment(p0,p1,e0,e1,s,t,onSegment,onEdge);
+		if (s<=btScalar(0.) || s>=btScalar(1.))
+			continue;
+		btVector3 diff = onSegment-onEdge;
+		if (normal.dot(diff)<=btScalar(0.))
+			continue;
+		btVector3 outward = (e1-e0).cross(normal);
+		if (outward.dot(opposite-e0)>btScalar(0.))
+			outward = -outward;
+		if (outward.dot(diff)<=btScalar(0.))
+			continue;
+		btScalar dist = diff.length();
+		if (dist<=SIMD_EPSILON)
+			continue;
+		edgeContact.update(diff/dist,onEdge,dist-radius,x,y);
+	}
+}
+
+
+static void	btCollideBoxTriangle(btHeightfieldContactAdder& adder,const btVector3* boxVertices,btScalar maxDepth,const btVector3* triangle,const btVector3& faceNormal,const btVector3& normal,int x,int y)
+{
+	//box vertices below the face
+	for (int i=0;i<8;i++)
+	{
+		const btVector3& v = boxVertices[i];
+		btScalar planeDistance = normal.dot(v-triangle[0]);
+		if (planeDistance-adder.m_margin>=adder.m_threshold || planeDistance<-maxDepth)
+			continue;
+		if (faceNormal.dot((triangle[1]-triangle[0]).cross(v-triangle[0]))<btScalar(0.) ||
+			faceNormal.dot((triangle[2]-triangle[1]).cross(v-triangle[1]))<btScalar(0.) ||
+			faceNormal.dot((triangle[0]-triangle[2]).cross(v-triangle[2]))<btScalar(0.))
+			continue;
+		adder.addContact(normal,v-normal*planeDistance,planeDistance,x,y);
+	}
+}
+
+
+///box edges crossing a ridge of the terrain, where neither shape has a vertex inside the other. The edge e0e1 is shared by 2 triangles with
+///the opposite vertices oppositeA and oppositeB, the contact normal has to lie between the normals of both triangles.
+static void	btCollideBoxEdge(btHeightfieldContactAdder& adder,const btTransform& boxTrans,const btVector3* boxVertices,btScalar maxDepth,const btVector3& up,const btVector3& e0,const btVector3& e1,const btVector3& oppositeA,const btVector3& oppositeB,int x,int y)
+{
+	btVector3 edge = e1-e0;
+	btVector3 toA = oppositeA-e0;
+	btVector3 toB = oppositeB-e0;
+	//flat and nearly flat edges are left to the vertex contacts
+	btScalar toleranceA = btScalar(1e-4)*toA.length();
+	btScalar toleranceB = btScalar(1e-4)*toB.length();
+	//only ridges, triangle B falls away below the face of A. In a valley both triangles fall away downwards, into the terrain
+	btVector3 normalA = edge.cross(toA);
+	if (normalA.dot(up)<btScalar(0.))
+		normalA = -normalA;
+	if (normalA.dot(toB)>-toleranceB*normalA.length())
+		return;
+	for (int axis=0;axis<3;axis++)
+	{
+		btVector3 n = boxTrans.getBasis().getColumn(axis).cross(edge);
+		btScalar length2 = n.length2();
+		if (length2<=SIMD_EPSILON*edge.length2())
+			continue;
+		n /= btSqrt(length2);
+		//both triangles have to fall away from the edge along n
+		btScalar dA = n.dot(toA);
+		btScalar dB = n.dot(toB);
+		if (dA+dB>btScalar(0.))
+		{
+			n = -n;
+			dA = -dA;
+			dB = -dB;
+		}
+		if (dA>-toleranceA || dB>-toleranceB)
+			continue;
+		//of the 4 box edges along this axis, the one furthest along -n
+		btVector3 localN = n*boxTrans.getBasis();
+		int corner = 0;
+		for (int j=0;j<3;j++)
+		{
+			if (j!=axis && localN[j]<btScalar(0.))
+				corner |= 1<<j;
+		}
+		btScalar s,t;
+		btVector3 onBox,onEdge;
+		btClosestPointsSegmentSegment(boxVertices[corner],boxVertices[corner|(1<<axis)],e0,e1,s,t,onBox,onEdge);
+		if (s<=btScalar(0.) || s>=btScalar(1.) || t<=btScalar(0.) || t>=btScalar(1.))
+			continue;
+		btScalar distance = n.dot(onBox-onEdge);
+		if (distance-adder.m_margin>=adder.m_threshold || distance<-maxDepth)
+			continue;
+		adder.addContact(n,onEdge,distance,x,y);
+	}
+}
+
+
+struct btHeightfieldCornerSortPredicate
+{
+	template <class T>
+	bool operator() ( const T& a, const T& b ) const
+	{
+		if (a.m_y != b.m_y)
+			return a.m_y < b.m_y;
+		if (a.m_x != b.m_x)
+			return a.m_x < b.m_x;
+		return a.m_vertex < b.m_vertex;
+	}
+};
+
+struct btHeightfieldEdgeSortPredicate
+{
+	template <class T>
+	bool operator() ( const T& a, const T& b ) const
+	{
+		for (int i=0;i<4;i++)
+		{
+			if (a.m_corners[i] != b.m_corners[i])
+				return a.m_corners[i] < b.m_corners[i];
+		}
+		return a.m_vertex0 < b.m_vertex0;
+	}
+};
+
+
+static void	btCollideBoxVertex(btHeightfieldContactAdder& adder,const btTransform& boxTrans,const btVector3& halfExtents,const btVector3& vertex,int x,int y)
+{
+	btVector3 local = boxTrans.invXform(vertex);
+	btVector3 outside = local.absolute()-halfExtents;
+	int axis = outside.maxAxis();
+	if (outside[axis]-adder.m_margin>=adder.m_threshold)
+		return;
+	//push the box away from the vertex through the nearest face
+	btVector3 normal = boxTrans.getBasis().getColumn(axis);
+	if (local[axis]>btScalar(0.))
+		normal = -normal;
+	adder.addContact(normal,vertex,outside[axis],x,y);
+}
+
+
+void btHeightfieldConvexCollisionAlgorithm::processCollision (const btCollisionObjectWrapper* body0Wrap,const btCollisionObjectWrapper* body1Wrap,const btDispatcherInfo& dispatchInfo,btManifoldResult* resultOut)
+{
+	(void)dispatchInfo;
+	if (!m_manifoldPtr)
+		return;
+
+	const btCollisionObjectWrapper* convexObjWrap = m_isSwapped? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* terrainObjWrap = m_isSwapped? body0Wrap: body1Wrap;
+
+	const btConvexShape* convexShape = (const btConvexShape*) convexObjWrap->getCollisionShape();
+	const btHeightfieldTerrainShape* terrainShape = (const btHeightfieldTerrainShape*) terrainObjWrap->getCollisionShape();
+
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	btHeightfieldContactAdder adder;
+	adder.m_resultOut = resultOut;
+	adder.m_terrainObj = terrainObjWrap->getCollisionObject();
+	adder.m_terrainTrans = terrainObjWrap->getWorldTransform();
+	adder.m_margin = terrainShape->getMargin();
+	adder.m_threshold = m_manifoldPtr->getContactBreakingThreshold();
+
+	btTransform convexInTerrain = adder.m_terrainTrans.inverse()*convexObjWrap->getWorldTransform();
+	btVector3 aabbMin,aabbMax;
+	convexShape->getAabb(convexInTerrain,aabbMin,aabbMax);
+	btVector3 expand(adder.m_margin+adder.m_threshold,adder.m_margin+adder.m_threshold,adder.m_margin+adder.m_threshold);
+	aabbMin -= expand;
+	aabbMax += expand;
+
+	m_vertices.resize(0);
+	m_cells.resize(0);
+	terrainShape->getTrianglesInAabb(aabbMin,aabbMax,m_vertices,m_cells);
+
+	//the terrain is solid below its surface
+	btVector3 up(0,0,0);
+	up[terrainShape->getUpAxis()] = terrainShape->getLocalScaling()[terrainShape->getUpAxis()]<btScalar(0.) ? btScalar(-1.) : btScalar(1.);
+
+	int shapeType = convexShape->getShapeType();
+	btVector3 capsule0,capsule1;
+	btScalar radius = btScalar(0.);
+	btVector3 halfExtents(0,0,0);
+	btVector3 boxVertices[8];
+	if (shapeType==SPHERE_SHAPE_PROXYTYPE)
+	{
+		radius = ((const btSphereShape*)convexShape)->getRadius();
+	} else if (shapeType==CAPSULE_SHAPE_PROXYTYPE)
+	{
+		const btCapsuleShape* capsule = (const btCapsuleShape*)convexShape;
+		btVector3 halfAxis = convexInTerrain.getBasis().getColumn(capsule->getUpAxis())*capsule->getHalfHeight();
+		capsule0 = convexInTerrain.getOrigin()+halfAxis;
+		capsule1 = convexInTerrain.getOrigin()-halfAxis;
+		radius = capsule->getRadius();
+	} else
+	{
+		btAssert(shapeType==BOX_SHAPE_PROXYTYPE);
+		halfExtents = ((const btBoxShape*)convexShape)->getHalfExtentsWithMargin();
+		for (int i=0;i<8;i++)
+		{
+			btVector3 corner((i&1) ? halfExtents[0] : -halfExtents[0],(i&2) ? halfExtents[1] : -halfExtents[1],(i&4) ? halfExtents[2] : -halfExtents[2]);
+			boxVertices[i] = convexInTerrain(corner);
+		}
+		radius = btScalar(2.)*halfExtents.length();
+	}
+
+	btHeightfieldEdgeContact edgeContacts[3];
+	int numTriangles = m_vertices.size()/3;
+	if (shapeType==BOX_SHAPE_PROXYTYPE)
+	{
+		m_degenerate.resize(0);
+		m_degenerate.resize(numTriangles,0);
+	}
+	for (int i=0;i<numTriangles;i++)
+	{
+		const btVector3* triangle = &m_vertices[3*i];
+		int x = m_cells[2*i];
+		int y = m_cells[2*i+1];
+		btVector3 faceNormal = (triangle[1]-triangle[0]).cross(triangle[2]-triangle[0]);
+		btScalar length2 = faceNormal.length2();
+		if (length2<=SIMD_EPSILON*SIMD_EPSILON)
+		{
+			if (shapeType==BOX_SHAPE_PROXYTYPE)
+				m_degenerate[i] = 1;
+			continue;
+		}
+		btVector3 normal = faceNormal/btSqrt(length2);
+		if (normal.dot(up)<btScalar(0.))
+			normal = -normal;
+
+		switch (shapeType)
+		{
+		case SPHERE_SHAPE_PROXYTYPE:
+			btCollideSphereTriangle(adder,edgeContacts[0],convexInTerrain.getOrigin(),radius,triangle,normal,x,y);
+			break;
+		case CAPSULE_SHAPE_PROXYTYPE:
+			btCollideSphereTriangle(adder,edgeContacts[0],capsule0,radius,triangle,normal,x,y);
+			btCollideSphereTriangle(adder,edgeContacts[1],capsule1,radius,triangle,normal,x,y);
+			btCollideSegmentTriangle(edgeContacts[2],capsule0,capsule1,radius,triangle,normal,x,y);
+			break;
+		default:
+			btCollideBoxTriangle(adder,boxVertices,radius,triangle,faceNormal,normal,x,y);
+		}
+	}
+
+	if (shapeType==BOX_SHAPE_PROXYTYPE)
+	{
+		//the grid vertex of every gathered vertex. The 2 triangles of a cell are stored next to each other, with the 4 corners
+		//of the cell as their vertices 0, 1, 2 and 5, and vertex 0 at the cell x and y
+		int upAxis = terrainShape->getUpAxis();
+		int axisX = upAxis==0 ? 1 : 0;
+		int axisY = upAxis==2 ? 1 : 2;
+		m_vertexCorners.resize(2*m_vertices.size());
+		for (int i=0;i<m_vertices.size();i++)
+		{
+			const btVector3& v00 = m_vertices[i-i%6];
+			const btVector3& v = m_vertices[i];
+			int cell = i/3;
+			m_vertexCorners[2*i] = m_cells[2*cell] + (v[axisX]!=v00[axisX] ? 1 : 0);
+			m_vertexCorners[2*i+1] = m_cells[2*cell+1] + (v[axisY]!=v00[axisY] ? 1 : 0);
+		}
+
+		//terrain vertices inside the box. Neighbouring cells share corners, so each grid vertex is tested once, whether or not its triangles are degenerate
+		static const int cellCorners[4] = {0,1,2,5};
+		m_corners.resize(0);
+		for (int i=0;i<m_vertices.size();i+=6)
+		{
+			for (int j=0;j<4;j++)
+			{
+				Corner& corner = m_corners.expandNonInitializing();
+				corner.m_vertex = i+cellCorners[j];
+				corner.m_x = m_vertexCorners[2*corner.m_vertex];
+				corner.m_y = m_vertexCorners[2*corner.m_vertex+1];
+			}
+		}
+		m_corners.quickSort(btHeightfieldCornerSortPredicate());
+		for (int i=0;i<m_corners.size();i++)
+		{
+			const Corner& corner = m_corners[i];
+			if (i>0 && corner.m_x==m_corners[i-1].m_x && corner.m_y==m_corners[i-1].m_y)
+				continue;
+			btCollideBoxVertex(adder,convexInTerrain,halfExtents,m_vertices[corner.m_vertex],corner.m_x,corner.m_y);
+		}
+
+		//box edges on ridges. The edges are sorted by their grid vertices, so the 2 triangles of an inner edge end up next to each other
+		m_edges.resize(0);
+		for (int i=0;i<numTriangles;i++)
+		{
+			if (m_degenerate[i])
+				continue;
+			for (int j=0;j<3;j++)
+			{
+				Edge& edge = m_edges.expandNonInitializing();
+				edge.m_vertex0 = 3*i+j;
+				edge.m_vertex1 = 3*i+(j+1)%3;
+				edge.m_opposite = 3*i+(j+2)%3;
+				const int* c0 = &m_vertexCorners[2*edge.m_vertex0];
+				const int* c1 = &m_vertexCorners[2*edge.m_vertex1];
+				if (c1[1]<c0[1] || (c1[1]==c0[1] && c1[0]<c0[0]))
+				{
+					btSwap(edge.m_vertex0,edge.m_vertex1);
+					btSwap(c0,c1);
+				}
+				edge.m_corners[0] = c0[1];
+				edge.m_corners[1] = c0[0];
+				edge.m_corners[2] = c1[1];
+				edge.m_corners[3] = c1[0];
+			}
+		}
+		m_edges.quickSort(btHeightfieldEdgeSortPredicate());
+		for (int i=1;i<m_edges.size();i++)
+		{
+			const Edge& a = m_edges[i-1];
+			const Edge& b = m_edges[i];
+			if (a.m_corners[0]!=b.m_corners[0] || a.m_corners[1]!=b.m_corners[1] || a.m_corners[2]!=b.m_corners[2] || a.m_corners[3]!=b.m_corners[3])
+				continue;
+			btCollideBoxEdge(adder,convexInTerrain,boxVertices,radius,up,m_vertices[a.m_vertex0],m_vertices[a.m_vertex1],
+				m_vertices[a.m_opposite],m_vertices[b.m_opposite],a.m_corners[1],a.m_corners[0]);
+		}
+	}
+	//the inside of a capsule competes with the faces below its ends
+	edgeContacts[2].m_minFaceDistance = btMin(edgeContacts[0].m_minFaceDistance,edgeContacts[1].m_minFaceDistance);
+	for (int i=0;i<3;i++)
+	{
+		edgeContacts[i].flush(adder);
+	}
+
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr->getNumContacts())
+		{
+			resultOut->refreshContactPoints();
+		}
+	}
+}
+
+btScalar btHeightfieldConvexCollisionAlgorithm::calculateTimeOfImpact(btCollisionObject* col0,btCollisionObject* col1,const btDispatcherInfo& dispatchInfo,btManifoldResult* resultOut)
+{
+	(void)resultOut;
+	(void)dispatchInfo;
+	(void)col0;
+	(void)col1;
+
+	//not yet
+	return btScalar(1.);
+}
@@ -0,0 +1,105 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_HEIGHTFIELD_CONVEX_COLLISION_ALGORITHM_H
+#define BT_HEIGHTFIELD_CONVEX_COLLISION_ALGORITHM_H
+
+#include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+#include "btCollisionDispatcher.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btVector3.h"
+class btPersistentManifold;
+class btHeightfieldTerrainShape;
+
+///btHeightfieldConvexCollisionAlgorithm collides spheres, capsules and boxes with a btHeightfieldTerrainShape.
+///It gathers the triangles near the convex with btHeightfieldTerrainShape::getTrianglesInAabb, which skips cells using the min/max mips of the terrain,
+///and computes the contacts directly instead of running GJK against every triangle like btConvexConcaveCollisionAlgorithm.
+///Boxes get contacts for their vertices below the terrain surface, for terrain vertices inside the box and for box edges crossing a ridge of the terrain.
+///It is enabled with btDefaultCollisionConstructionInfo::m_useHeightfieldCollisionAlgorithm.
+class btHeightfieldConvexCollisionAlgorithm : public btCollisionAlgorithm
+{
+	bool		m_ownManifold;
+	btPersistentManifold*	m_manifoldPtr;
+	bool		m_isSwapped;
+
+	//a grid vertex of the terrain and its index in m_vertices
+	struct	Corner
+	{
+		int	m_x;
+		int	m_y;
+		int	m_vertex;
+	};
+
+	//a triangle edge, m_corners holds the y and x of its 2 grid vertices
+	struct	Edge
+	{
+		int	m_corners[4];
+		int	m_vertex0;
+		int	m_vertex1;
+		int	m_opposite;
+	};
+
+	//gathered triangles, cell corners and edges, kept between frames to avoid reallocations
+	btAlignedObjectArray<btVector3>	m_vertices;
+	btAlignedObjectArray<int>		m_cells;
+	btAlignedObjectArray<unsigned char>	m_degenerate;
+	btAlignedObjectArray<int>		m_vertexCorners;
+	btAlignedObjectArray<Corner>	m_corners;
+	btAlignedObjectArray<Edge>		m_edges;
+
+public:
+
+	btHeightfieldConvexCollisionAlgorithm(btPersistentManifold* mf,const btCollisionAlgorithmConstructionInfo& ci,const btCollisionObjectWrapper* body0Wrap,const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
+
+	virtual ~btHeightfieldConvexCollisionAlgorithm();
+
+	virtual void processCollision (const btCollisionObjectWrapper* body0Wrap,const btCollisionObjectWrapper* body1Wrap,const btDispatcherInfo& dispatchInfo,btManifoldResult* resultOut);
+
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0,btCollisionObject* body1,const btDispatcherInfo& dispatchInfo,btManifoldResult* resultOut);
+
+	virtual	void	getAllContactManifolds(btManifoldArray&	manifoldArray)
+	{
+		if (m_manifoldPtr && m_ownManifold)
+		{
+			manifoldArray.push_back(m_manifoldPtr);
+		}
+	}
+
+	///returns true for the convex shape types this algorithm handles
+	static bool	isSupportedConvex(int proxyType)
+	{
+		return proxyType==SPHERE_SHAPE_PROXYTYPE || proxyType==CAPSULE_SHAPE_PROXYTYPE || proxyType==BOX_SHAPE_PROXYTYPE;
+	}
+
+	struct CreateFunc :public 	btCollisionAlgorithmCreateFunc
+	{
+		virtual	btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap,const btCollisionObjectWrapper* body1Wrap)
+		{
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btHeightfieldConvexCollisionAlgorithm));
+			if (!m_swapped)
+			{
+				return new(mem) btHeightfieldConvexCollisionAlgorithm(0,ci,body0Wrap,body1Wrap,false);
+			} else
+			{
+				return new(mem) btHeightfieldConvexCollisionAlgorithm(0,ci,body0Wrap,body1Wrap,true);
+			}
+		}
+	};
+
+};
+
+#endif //BT_HEIGHTFIELD_CONVEX_COLLISION_ALGORITHM_H
@@ -21,17 +21,404 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.h"
 
 //#include <stdio.h>
 #include "LinearMath/btQuickprof.h"
 
+///btIslandGraphPairCallback keeps the island graph in sync with the overlapping pair cache, and forwards the events to the previous ghost pair callback.
+///It is also the activation listener of the collision objects, so the island manager knows which sleeping objects woke up.
+class btIslandGraphPairCallback : public btOverlappingPairCallback, public btCollisionObjectActivationListener
+{
+	btSimulationIslandManager*	m_islandManager;
+
+public:
+
+	btOverlappingPairCallback*	m_nextPairCallback;
+
+	btIslandGraphPairCallback(btSimulationIslandManager* islandManager,btOverlappingPairCallback* nextPairCallback)
+		:m_islandManager(islandManager),
+		m_nextPairCallback(nextPairCallback)
+	{
+	}
+
+	virtual btBroadphasePair*	addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+	{
+		m_islandManager->addGraphEdge((btCollisionObject*)proxy0->m_clientObject,(btCollisionObject*)proxy1->m_clientObject);
+		if (m_nextPairCallback)
+			return m_nextPairCallback->addOverlappingPair(proxy0,proxy1);
+		return 0;
+	}
+
+	virtual void*	removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher)
+	{
+		m_islandManager->removeGraphEdge((btCollisionObject*)proxy0->m_clientObject,(btCollisionObject*)proxy1->m_clientObject);
+		if (m_nextPairCallback)
+			return m_nextPairCallback->removeOverlappingPair(proxy0,proxy1,dispatcher);
+		return 0;
+	}
+
+	virtual void	removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy0,btDispatcher* dispatcher)
+	{
+		if (m_nextPairCallback)
+			m_nextPairCallback->removeOverlappingPairsContainingProxy(proxy0,dispatcher);
+	}
+
+	virtual void	collisionObjectActivated(const btCollisionObject* colObj)
+	{
+		m_islandManager->m_activatedObjects.push_back((btCollisionObject*)colObj);
+	}
+};
+
 btSimulationIslandManager::btSimulationIslandManager():
-m_splitIslands(true)
+m_splitIslands(true),
+m_persistentWorld(0),
+m_graphPairCallback(0),
+m_numExpandedIslandObjects(0)
 {
 }
 
 btSimulationIslandManager::~btSimulationIslandManager()
 {
+	disablePersistentIslands();
+}
+
+void	btSimulationIslandManager::enablePersistentIslands(btCollisionWorld* colWorld)
+{
+	disablePersistentIslands();
+
+	btOverlappingPairCache* pairCache = colWorld->getPairCache();
+	void* mem = btAlignedAlloc(sizeof(btIslandGraphPairCallback),16);
+	m_graphPairCallback = new (mem) btIslandGraphPairCallback(this,pairCache->getInternalGhostPairCallback());
+	pairCache->setInternalGhostPairCallback(m_graphPairCallback);
+	m_persistentWorld = colWorld;
+
+	//add the pairs that already exist
+	btBroadphasePair* pairPtr = pairCache->getOverlappingPairArrayPtr();
+	int numOverlappingPairs = pairCache->getNumOverlappingPairs();
+	int i;
+	for (i=0;i<numOverlappingPairs;i++)
+	{
+		addGraphEdge((btCollisionObject*)pairPtr[i].m_pProxy0->m_clientObject,(btCollisionObject*)pairPtr[i].m_pProxy1->m_clientObject);
+	}
+
+	//the active objects start the union find of the first frame
+	btCollisionObjectArray& collisionObjects = colWorld->getCollisionObjectArray();
+	for (i=0;i<collisionObjects.size();i++)
+	{
+		addCollisionObject(collisionObjects[i]);
+	}
+}
+
+void	btSimulationIslandManager::disablePersistentIslands()
+{
+	if (!m_persistentWorld)
+		return;
+
+	btOverlappingPairCache* pairCache = m_persistentWorld->getPairCache();
+	btAssert(pairCache->getInternalGhostPairCallback() == m_graphPairCallback);
+	pairCache->setInternalGhostPairCallback(m_graphPairCallback->m_nextPairCallback);
+
+	btCollisionObjectArray& collisionObjects = m_persistentWorld->getCollisionObjectArray();
+	for (int i=0;i<collisionObjects.size();i++)
+	{
+		if (collisionObjects[i]->getActivationListener() == m_graphPairCallback)
+			collisionObjects[i]->setActivationListener(0);
+	}
+
+	m_graphPairCallback->~btIslandGraphPairCallback();
+	btAlignedFree(m_graphPairCallback);
+	m_graphPairCallback = 0;
+	m_persistentWorld = 0;
+
+	m_graphNodes.clear();
+	m_graphEdges.clear();
+	m_freeGraphNodes.clear();
+	m_freeGraphEdges.clear();
+	m_graphNodeIndices.clear();
+	for (int i=0;i<m_islandObjects.size();i++)
+	{
+		m_islandObjects[i]->setIslandObjectIndex(-1);
+	}
+	m_islandObjects.clear();
+	m_activatedObjects.clear();
+	m_kinematicObjects.clear();
+}
+
+void	btSimulationIslandManager::addCollisionObject(btCollisionObject* colObj)
+{
+	if (!m_persistentWorld)
+		return;
+
+	colObj->setActivationListener(m_graphPairCallback);
+	if (colObj->isActive())
+	{
+		m_activatedObjects.push_back(colObj);
+	}
+	if (colObj->isKinematicObject())
+	{
+		m_kinematicObjects.push_back(colObj);
+	}
+}
+
+void	btSimulationIslandManager::removeCollisionObject(btCollisionObject* colObj)
+{
+	if (!m_persistentWorld)
+		return;
+
+	colObj->setActivationListener(0);
+
+	//the object can be in the activated objects more than once, if it fell asleep and woke up again in between frames
+	int i;
+	for (i=m_activatedObjects.size()-1;i>=0;i--)
+	{
+		if (m_activatedObjects[i]==colObj)
+		{
+			m_activatedObjects.swap(i,m_activatedObjects.size()-1);
+			m_activatedObjects.pop_back();
+		}
+	}
+	//the order of the island objects only matters between updateActivationState and buildAndProcessIslands
+	int index = colObj->getIslandObjectIndex();
+	if (index>=0)
+	{
+		btCollisionObject* last = m_islandObjects[m_islandObjects.size()-1];
+		m_islandObjects[index] = last;
+		last->setIslandObjectIndex(index);
+		m_islandObjects.pop_back();
+		m_numExpandedIslandObjects = btMin(m_numExpandedIslandObjects,m_islandObjects.size());
+		colObj->setIslandObjectIndex(-1);
+	}
+	//there are few kinematic objects
+	if (m_kinematicObjects.size())
+	{
+		m_kinematicObjects.remove(colObj);
+	}
+	colObj->setIslandTag(-1);
+}
+
+void	btSimulationIslandManager::addGraphEdge(btCollisionObject* colObj0,btCollisionObject* colObj1)
+{
+	btCollisionObject* objects[2] = {colObj0,colObj1};
+	int nodeIndices[2];
+	int side;
+
+	for (side=0;side<2;side++)
+	{
+		const int* nodeIndexPtr = m_graphNodeIndices.find(btHashPtr(objects[side]));
+		if (nodeIndexPtr)
+		{
+			nodeIndices[side] = *nodeIndexPtr;
+		} else
+		{
+			int nodeIndex;
+			if (m_freeGraphNodes.size())
+			{
+				nodeIndex = m_freeGraphNodes[m_freeGraphNodes.size()-1];
+				m_freeGraphNodes.pop_back();
+			} else
+			{
+				nodeIndex = m_graphNodes.size();
+				m_graphNodes.expandNonInitializing();
+			}
+			btIslandGraphNode& node = m_graphNodes[nodeIndex];
+			node.m_object = objects[side];
+			node.m_firstEdge = -1;
+			node.m_numEdges = 0;
+			m_graphNodeIndices.insert(btHashPtr(objects[side]),nodeIndex);
+			nodeIndices[side] = nodeIndex;
+		}
+	}
+
+	int edgeIndex;
+	if (m_freeGraphEdges.size())
+	{
+		edgeIndex = m_freeGraphEdges[m_freeGraphEdges.size()-1];
+		m_freeGraphEdges.pop_back();
+	} else
+	{
+		edgeIndex = m_graphEdges.size();
+		m_graphEdges.expandNonInitializing();
+	}
+
+	btIslandGraphEdge& edge = m_graphEdges[edgeIndex];
+	for (side=0;side<2;side++)
+	{
+		btIslandGraphNode& node = m_graphNodes[nodeIndices[side]];
+		edge.m_nodes[side] = nodeIndices[side];
+		edge.m_prev[side] = -1;
+		edge.m_next[side] = node.m_firstEdge;
+		if (node.m_firstEdge>=0)
+		{
+			btIslandGraphEdge& nextEdge = m_graphEdges[node.m_firstEdge];
+			nextEdge.m_prev[nextEdge.m_nodes[0]==nodeIndices[side] ? 0 : 1] = edgeIndex;
+		}
+		node.m_firstEdge = edgeIndex;
+		node.m_numEdges++;
+	}
+}
+
+void	btSimulationIslandManager::unlinkGraphEdge(int edgeIndex,int side)
+{
+	const btIslandGraphEdge& edge = m_graphEdges[edgeIndex];
+	int nodeIndex = edge.m_nodes[side];
+	btIslandGraphNode& node = m_graphNodes[nodeIndex];
+
+	if (edge.m_prev[side]>=0)
+	{
+		btIslandGraphEdge& prevEdge = m_graphEdges[edge.m_prev[side]];
+		prevEdge.m_next[prevEdge.m_nodes[0]==nodeIndex ? 0 : 1] = edge.m_next[side];
+	} else
+	{
+		node.m_firstEdge = edge.m_next[side];
+	}
+	if (edge.m_next[side]>=0)
+	{
+		btIslandGraphEdge& nextEdge = m_graphEdges[edge.m_next[side]];
+		nextEdge.m_prev[nextEdge.m_nodes[0]==nodeIndex ? 0 : 1] = edge.m_prev[side];
+	}
+
+	node.m_numEdges--;
+	if (!node.m_numEdges)
+	{
+		//objects without overlapping pairs don't need a node
+		m_graphNodeIndices.remove(btHashPtr(node.m_object));
+		m_freeGraphNodes.push_back(nodeIndex);
+	}
+}
+
+void	btSimulationIslandManager::removeGraphEdge(btCollisionObject* colObj0,btCollisionObject* colObj1)
+{
+	const int* nodeIndexPtr0 = m_graphNodeIndices.find(btHashPtr(colObj0));
+	const int* nodeIndexPtr1 = m_graphNodeIndices.find(btHashPtr(colObj1));
+	if (!nodeIndexPtr0 || !nodeIndexPtr1)
+		return;
+
+	//search the edge list of the node with the fewest edges, a static ground can overlap with thousands of objects
+	int nodeIndex = *nodeIndexPtr0;
+	int otherNodeIndex = *nodeIndexPtr1;
+	if (m_graphNodes[otherNodeIndex].m_numEdges < m_graphNodes[nodeIndex].m_numEdges)
+	{
+		btSwap(nodeIndex,otherNodeIndex);
+	}
+
+	int edgeIndex = m_graphNodes[nodeIndex].m_firstEdge;
+	while (edgeIndex>=0)
+	{
+		const btIslandGraphEdge& edge = m_graphEdges[edgeIndex];
+		int side = edge.m_nodes[0]==nodeIndex ? 0 : 1;
+		if (edge.m_nodes[1-side]==otherNodeIndex)
+			break;
+		edgeIndex = edge.m_next[side];
+	}
+	if (edgeIndex<0)
+		return;
+
+	unlinkGraphEdge(edgeIndex,0);
+	unlinkGraphEdge(edgeIndex,1);
+	m_freeGraphEdges.push_back(edgeIndex);
+}
+
+void	btSimulationIslandManager::addIslandObject(btCollisionObject* colObj)
+{
+	colObj->setHitFraction(btScalar(1.));
+	colObj->setCompanionId(-1);
+	colObj->setIslandTag(m_unionFind.addElement());
+	colObj->setIslandObjectIndex(m_islandObjects.size());
+	m_islandObjects.push_back(colObj);
+}
+
+///expandIslandObjects adds the objects that overlap with the island objects to the union find, until the islands are complete.
+///This pulls in sleeping objects that touch an active object, like the union find over all pairs does.
+void	btSimulationIslandManager::expandIslandObjects()
+{
+	while (m_numExpandedIslandObjects < m_islandObjects.size())
+	{
+		btCollisionObject* colObj0 = m_islandObjects[m_numExpandedIslandObjects++];
+		if (!colObj0->mergesSimulationIslands())
+			continue;
+
+		const int* nodeIndexPtr = m_graphNodeIndices.find(btHashPtr(colObj0));
+		if (!nodeIndexPtr)
+			continue;
+
+		int nodeIndex = *nodeIndexPtr;
+		int edgeIndex = m_graphNodes[nodeIndex].m_firstEdge;
+		while (edgeIndex>=0)
+		{
+			const btIslandGraphEdge& edge = m_graphEdges[edgeIndex];
+			int side = edge.m_nodes[0]==nodeIndex ? 0 : 1;
+			btCollisionObject* colObj1 = m_graphNodes[edge.m_nodes[1-side]].m_object;
+			if (colObj1->mergesSimulationIslands())
+			{
+				if (colObj1->getIslandTag()<0)
+				{
+					addIslandObject(colObj1);
+				}
+				m_unionFind.unite(colObj0->getIslandTag(),colObj1->getIslandTag());
+			}
+			edgeIndex = edge.m_next[side];
+		}
+	}
+}
+
+///with persistent islands, only the active objects start the union find. The remaining objects are sleeping, or only connected to sleeping objects, so their islands don't change.
+///The active objects are the island objects of the previous frame that are still active, and the objects that were added or woken up since then,
+///so the cost only depends on the number of active objects. Objects outside the islands keep island tag -1.
+void	btSimulationIslandManager::updatePersistentActivationState()
+{
+	int i;
+	for (i=0;i<m_islandObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = m_islandObjects[i];
+		collisionObject->setIslandTag(-1);
+		collisionObject->setIslandObjectIndex(-1);
+		collisionObject->setHitFraction(btScalar(1.));
+		if (collisionObject->isActive())
+		{
+			m_activatedObjects.push_back(collisionObject);
+		}
+	}
+
+	m_unionFind.reset(0);
+	m_islandObjects.resize(0);
+	m_numExpandedIslandObjects = 0;
+
+	for (i=0;i<m_activatedObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = m_activatedObjects[i];
+		if ((collisionObject->getIslandTag()<0) && collisionObject->isActive() && !collisionObject->isStaticOrKinematicObject())
+		{
+			addIslandObject(collisionObject);
+		}
+	}
+	m_activatedObjects.resize(0);
+
+	expandIslandObjects();
+}
+
+void	btSimulationIslandManager::storePersistentIslandActivationState()
+{
+	for (int i=0;i<m_islandObjects.size();i++)
+	{
+		m_islandObjects[i]->setIslandTag(m_unionFind.find(i));
+		m_unionFind.getElement(i).m_sz = i;
+	}
+}
+
+void	btSimulationIslandManager::uniteIslands(btCollisionObject* colObj0,btCollisionObject* colObj1)
+{
+	if (m_persistentWorld)
+	{
+		//a constraint can connect an active object to a sleeping one that isn't part of the union find yet
+		if (colObj0->getIslandTag()<0)
+			addIslandObject(colObj0);
+		if (colObj1->getIslandTag()<0)
+			addIslandObject(colObj1);
+		expandIslandObjects();
+	}
+	m_unionFind.unite(colObj0->getIslandTag(),colObj1->getIslandTag());
 }
 
 
@@ -72,6 +459,12 @@ void btSimulationIslandManager::findUnions(btDispatcher* /* dispatcher */,btColl
 #ifdef STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_persistentWorld)
+	{
+		btAssert(colWorld==m_persistentWorld);
+		updatePersistentActivationState();
+		return;
+	}
 
 	// put the index into m_controllers into m_tag   
 	int index = 0;
@@ -99,6 +492,11 @@ void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWor
 
 void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_persistentWorld)
+	{
+		storePersistentIslandActivationState();
+		return;
+	}
 	// put the islandId ('find' value) into m_tag   
 	{
 		int index = 0;
@@ -126,6 +524,12 @@ void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* c
 #else //STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_persistentWorld)
+	{
+		btAssert(colWorld==m_persistentWorld);
+		updatePersistentActivationState();
+		return;
+	}
 
 	initUnionFind( int (colWorld->getCollisionObjectArray().size()));
 
@@ -151,6 +555,11 @@ void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld
 
 void	btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_persistentWorld)
+	{
+		storePersistentIslandActivationState();
+		return;
+	}
 	// put the islandId ('find' value) into m_tag	
 	{
 
@@ -205,7 +614,8 @@ void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisio
 
 	BT_PROFILE("islandUnionFindAndQuickSort");
 	
-	btCollisionObjectArray& collisionObjects = collisionWorld->getCollisionObjectArray();
+	//with persistent islands, the union find elements refer to m_islandObjects instead of all collision objects
+	btCollisionObjectArray& collisionObjects = m_persistentWorld ? m_islandObjects : collisionWorld->getCollisionObjectArray();
 
 	m_islandmanifold.resize(0);
 
@@ -306,54 +716,106 @@ void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisio
 
 	
 	int i;
-	int maxNumManifolds = dispatcher->getNumManifolds();
 
-//#define SPLIT_ISLANDS 1
-//#ifdef SPLIT_ISLANDS
+	if (m_persistentWorld)
+	{
+		//the manifolds that aren't sleeping belong to the pairs of the island objects, apart from those of the kinematic objects,
+		//so the pairs of the sleeping objects outside the islands aren't visited
+		btOverlappingPairCache* pairCache = collisionWorld->getPairCache();
+		for (i=0;i<m_islandObjects.size();i++)
+		{
+			addObjectManifolds(dispatcher,pairCache,m_islandObjects[i]);
+		}
+		for (i=0;i<m_kinematicObjects.size();i++)
+		{
+			addObjectManifolds(dispatcher,pairCache,m_kinematicObjects[i]);
+		}
+	} else
+	{
+		int maxNumManifolds = dispatcher->getNumManifolds();
+		for (i=0;i<maxNumManifolds ;i++)
+		{
+			addIslandManifold(dispatcher,dispatcher->getManifoldByIndexInternal(i));
+		}
+	}
+}
 
-	
-//#endif //SPLIT_ISLANDS
+void	btSimulationIslandManager::addIslandManifold(btDispatcher* dispatcher,btPersistentManifold* manifold)
+{
+	 const btCollisionObject* colObj0 = static_cast<const btCollisionObject*>(manifold->getBody0());
+	 const btCollisionObject* colObj1 = static_cast<const btCollisionObject*>(manifold->getBody1());
 
-	
-	for (i=0;i<maxNumManifolds ;i++)
+	 ///@todo: check sleeping conditions!
+	 if (((colObj0) && colObj0->getActivationState() != ISLAND_SLEEPING) ||
+		((colObj1) && colObj1->getActivationState() != ISLAND_SLEEPING))
 	{
-		 btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
-		 
-		 const btCollisionObject* colObj0 = static_cast<const btCollisionObject*>(manifold->getBody0());
-		 const btCollisionObject* colObj1 = static_cast<const btCollisionObject*>(manifold->getBody1());
-		
-		 ///@todo: check sleeping conditions!
-		 if (((colObj0) && colObj0->getActivationState() != ISLAND_SLEEPING) ||
-			((colObj1) && colObj1->getActivationState() != ISLAND_SLEEPING))
+
+		//kinematic objects don't merge islands, but wake up all connected objects
+		if (colObj0->isKinematicObject() && colObj0->getActivationState() != ISLAND_SLEEPING)
 		{
-		
-			//kinematic objects don't merge islands, but wake up all connected objects
-			if (colObj0->isKinematicObject() && colObj0->getActivationState() != ISLAND_SLEEPING)
-			{
-				if (colObj0->hasContactResponse())
-					colObj1->activate();
-			}
-			if (colObj1->isKinematicObject() && colObj1->getActivationState() != ISLAND_SLEEPING)
+			if (colObj0->hasContactResponse())
+				colObj1->activate();
+		}
+		if (colObj1->isKinematicObject() && colObj1->getActivationState() != ISLAND_SLEEPING)
+		{
+			if (colObj1->hasContactResponse())
+				colObj0->activate();
+		}
+		if(m_splitIslands)
+		{
+			//filtering for response
+			if (dispatcher->needsResponse(colObj0,colObj1))
 			{
-				if (colObj1->hasContactResponse())
-					colObj0->activate();
-			}
-			if(m_splitIslands)
-			{ 
-				//filtering for response
-				if (dispatcher->needsResponse(colObj0,colObj1))
+				//with persistent islands, sleeping objects outside the islands of this frame keep island tag -1,
+				//so a manifold between such an object and a static one has no island to go with
+				if (!m_persistentWorld || getIslandId(manifold)>=0)
 					m_islandmanifold.push_back(manifold);
 			}
 		}
 	}
 }
 
+///addObjectManifolds adds the manifolds of the pairs of colObj from the island graph. A pair between two island objects is visited
+///from the object with the lower index, the pairs of a kinematic object only if the other object isn't an island object.
+void	btSimulationIslandManager::addObjectManifolds(btDispatcher* dispatcher,btOverlappingPairCache* pairCache,btCollisionObject* colObj0)
+{
+	const int* nodeIndexPtr = m_graphNodeIndices.find(btHashPtr(colObj0));
+	if (!nodeIndexPtr)
+		return;
+
+	int index0 = colObj0->getIslandObjectIndex();
+	int nodeIndex = *nodeIndexPtr;
+	int edgeIndex = m_graphNodes[nodeIndex].m_firstEdge;
+	while (edgeIndex>=0)
+	{
+		const btIslandGraphEdge& edge = m_graphEdges[edgeIndex];
+		int side = edge.m_nodes[0]==nodeIndex ? 0 : 1;
+		edgeIndex = edge.m_next[side];
+
+		btCollisionObject* colObj1 = m_graphNodes[edge.m_nodes[1-side]].m_object;
+		int index1 = colObj1->getIslandObjectIndex();
+		if (index1>=0 && (index0<0 || index1<index0))
+			continue;
+
+		btBroadphasePair* pair = pairCache->findPair(colObj0->getBroadphaseHandle(),colObj1->getBroadphaseHandle());
+		if (!pair || !pair->m_algorithm)
+			continue;
+		m_pairManifolds.resize(0);
+		pair->m_algorithm->getAllContactManifolds(m_pairManifolds);
+		for (int i=0;i<m_pairManifolds.size();i++)
+		{
+			addIslandManifold(dispatcher,m_pairManifolds[i]);
+		}
+	}
+}
+
 
 
 ///@todo: this is random access, it can be walked 'cache friendly'!
 void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback)
 {
 	btCollisionObjectArray& collisionObjects = collisionWorld->getCollisionObjectArray();
+	btCollisionObjectArray& islandObjects = m_persistentWorld ? m_islandObjects : collisionObjects;
 
 	buildIslands(dispatcher,collisionWorld);
 
@@ -404,7 +866,7 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 					for (endIslandIndex = startIslandIndex;(endIslandIndex<numElem) && (getUnionFind().getElement(endIslandIndex).m_id == islandId);endIslandIndex++)
 					{
 							int i = getUnionFind().getElement(endIslandIndex).m_sz;
-							btCollisionObject* colObj0 = collisionObjects[i];
+							btCollisionObject* colObj0 = islandObjects[i];
 							m_islandBodies.push_back(colObj0);
 							if (colObj0->isActive())
 									islandSleeping = false;
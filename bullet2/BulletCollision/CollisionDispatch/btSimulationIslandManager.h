@@ -19,23 +19,78 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btUnionFind.h"
 #include "btCollisionCreateFunc.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
 #include "btCollisionObject.h"
 
 class btCollisionObject;
 class btCollisionWorld;
 class btDispatcher;
 class btPersistentManifold;
+class btIslandGraphPairCallback;
+class btOverlappingPairCache;
 
 
 ///SimulationIslandManager creates and handles simulation islands, using btUnionFind
 class btSimulationIslandManager
 {
+	friend class btIslandGraphPairCallback;
+
 	btUnionFind m_unionFind;
 
 	btAlignedObjectArray<btPersistentManifold*>  m_islandmanifold;
 	btAlignedObjectArray<btCollisionObject* >  m_islandBodies;
 	
 	bool m_splitIslands;
+
+	///the island graph stores the overlapping pairs of each object across frames, when persistent islands are enabled.
+	///Each node has a doubly linked list of its edges, an edge is linked into the lists of both of its nodes.
+	struct btIslandGraphNode
+	{
+		btCollisionObject*	m_object;
+		int					m_firstEdge;
+		int					m_numEdges;
+	};
+
+	struct btIslandGraphEdge
+	{
+		int		m_nodes[2];
+		int		m_next[2];
+		int		m_prev[2];
+	};
+
+	btCollisionWorld*				m_persistentWorld;
+	btIslandGraphPairCallback*		m_graphPairCallback;
+	btAlignedObjectArray<btIslandGraphNode>	m_graphNodes;
+	btAlignedObjectArray<btIslandGraphEdge>	m_graphEdges;
+	btAlignedObjectArray<int>		m_freeGraphNodes;
+	btAlignedObjectArray<int>		m_freeGraphEdges;
+	btHashMap<btHashPtr,int>		m_graphNodeIndices;
+
+	///the objects of the union find elements of the current frame, when persistent islands are enabled.
+	///Each object stores its index, see btCollisionObject::getIslandObjectIndex
+	btCollisionObjectArray			m_islandObjects;
+	int								m_numExpandedIslandObjects;
+
+	///the objects that were added or woken up since the last updateActivationState, they start the union find of the next frame
+	btCollisionObjectArray			m_activatedObjects;
+
+	///the objects that were kinematic when they were added, they wake up the sleeping objects they touch
+	btCollisionObjectArray			m_kinematicObjects;
+
+	btAlignedObjectArray<btPersistentManifold*>	m_pairManifolds;
+
+	void	addGraphEdge(btCollisionObject* colObj0,btCollisionObject* colObj1);
+	void	removeGraphEdge(btCollisionObject* colObj0,btCollisionObject* colObj1);
+	void	unlinkGraphEdge(int edgeIndex,int side);
+
+	void	addIslandObject(btCollisionObject* colObj);
+	void	expandIslandObjects();
+
+	void	addIslandManifold(btDispatcher* dispatcher,btPersistentManifold* manifold);
+	void	addObjectManifolds(btDispatcher* dispatcher,btOverlappingPairCache* pairCache,btCollisionObject* colObj);
+
+	void	updatePersistentActivationState();
+	void	storePersistentIslandActivationState();
 	
 public:
 	btSimulationIslandManager();
@@ -50,9 +105,32 @@ public:
 	virtual	void	updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher);
 	virtual	void	storeIslandActivationState(btCollisionWorld* world);
 
+	///uniteIslands merges the islands of two non-static objects, it is used for constraints between updateActivationState and storeIslandActivationState
+	void	uniteIslands(btCollisionObject* colObj0,btCollisionObject* colObj1);
 
 	void	findUnions(btDispatcher* dispatcher,btCollisionWorld* colWorld);
 
+	///enablePersistentIslands keeps the overlapping pairs of each object across frames, updated from the pair add/remove events of the pair cache of colWorld.
+	///Each frame, islands are only built for the active objects and the objects connected to them, instead of a union find and sort over all objects and pairs.
+	///The island manager becomes the internal ghost pair callback of the pair cache and forwards the events to the previous one (such as btGhostPairCallback),
+	///so that one has to be set first. The pair cache has to report every removal, like btHashedOverlappingPairCache does.
+	///The island manager also becomes the activation listener of the collision objects, to find the objects that wake up. Use btDiscreteDynamicsWorld::setPersistentIslands,
+	///or call addCollisionObject/removeCollisionObject for every object that is added to or removed from colWorld.
+	void	enablePersistentIslands(btCollisionWorld* colWorld);
+
+	void	disablePersistentIslands();
+
+	bool	hasPersistentIslands() const
+	{
+		return m_persistentWorld!=0;
+	}
+
+	///addCollisionObject and removeCollisionObject keep track of the objects of the world when persistent islands are enabled, they do nothing otherwise.
+	///Objects that become kinematic after they were added have to be removed and added again, to wake up the sleeping objects they touch
+	void	addCollisionObject(btCollisionObject* colObj);
+
+	void	removeCollisionObject(btCollisionObject* colObj);
+
 	
 
 	struct	IslandCallback
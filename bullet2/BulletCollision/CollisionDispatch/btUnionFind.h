@@ -49,6 +49,16 @@ class btUnionFind
 
 	  void	reset(int N);
 
+	  ///addElement appends a set that only contains the new element, and returns the index of the element
+	  int	addElement()
+	  {
+		  int index = m_elements.size();
+		  btElement& element = m_elements.expandNonInitializing();
+		  element.m_id = index;
+		  element.m_sz = 1;
+		  return index;
+	  }
+
 	  SIMD_FORCE_INLINE int	getNumElements() const
 	  {
 		  return int(m_elements.size());
@@ -17,6 +17,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
 #include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+#include "BulletCollision/BroadphaseCollision/btWideQuantizedBvh.h"
 #include "LinearMath/btSerializer.h"
 
 ///Bvh Concave triangle mesh is a static-triangle mesh shape with Bounding Volume Hierarchy optimization.
@@ -25,6 +26,7 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 :btTriangleMeshShape(meshInterface),
 m_bvh(0),
 m_triangleInfoMap(0),
+m_wideBvh(0),
 m_useQuantizedAabbCompression(useQuantizedAabbCompression),
 m_ownsBvh(false)
 {
@@ -45,6 +47,7 @@ btBvhTriangleMeshShape::btBvhTriangleMeshShape(btStridingMeshInterface* meshInte
 :btTriangleMeshShape(meshInterface),
 m_bvh(0),
 m_triangleInfoMap(0),
+m_wideBvh(0),
 m_useQuantizedAabbCompression(useQuantizedAabbCompression),
 m_ownsBvh(false)
 {
@@ -71,6 +74,8 @@ void	btBvhTriangleMeshShape::partialRefitTree(const btVector3& aabbMin,const btV
 	
 	m_localAabbMin.setMin(aabbMin);
 	m_localAabbMax.setMax(aabbMax);
+	if (m_wideBvh)
+		m_wideBvh->refitPartial(aabbMin,aabbMax);
 }
 
 
@@ -79,10 +84,17 @@ void	btBvhTriangleMeshShape::refitTree(const btVector3& aabbMin,const btVector3&
 	m_bvh->refit( m_meshInterface, aabbMin,aabbMax );
 	
 	recalcLocalAabb();
+	if (m_wideBvh)
+		m_wideBvh->refit();
 }
 
 btBvhTriangleMeshShape::~btBvhTriangleMeshShape()
 {
+	if (m_wideBvh)
+	{
+		m_wideBvh->~btWideQuantizedBvh();
+		btAlignedFree(m_wideBvh);
+	}
 	if (m_ownsBvh)
 	{
 		m_bvh->~btOptimizedBvh();
@@ -156,7 +168,10 @@ void	btBvhTriangleMeshShape::performRaycast (btTriangleCallback* callback, const
 
 	MyNodeOverlapCallback	myNodeCallback(callback,m_meshInterface);
 
-	m_bvh->reportRayOverlappingNodex(&myNodeCallback,raySource,rayTarget);
+	if (m_wideBvh)
+		m_wideBvh->reportRayOverlappingNodex(&myNodeCallback,raySource,rayTarget);
+	else
+		m_bvh->reportRayOverlappingNodex(&myNodeCallback,raySource,rayTarget);
 }
 
 void	btBvhTriangleMeshShape::performConvexcast (btTriangleCallback* callback, const btVector3& raySource, const btVector3& rayTarget, const btVector3& aabbMin, const btVector3& aabbMax)
@@ -225,7 +240,10 @@ void	btBvhTriangleMeshShape::performConvexcast (btTriangleCallback* callback, co
 
 	MyNodeOverlapCallback	myNodeCallback(callback,m_meshInterface);
 
-	m_bvh->reportBoxCastOverlappingNodex (&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+	if (m_wideBvh)
+		m_wideBvh->reportBoxCastOverlappingNodex (&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
+	else
+		m_bvh->reportBoxCastOverlappingNodex (&myNodeCallback, raySource, rayTarget, aabbMin, aabbMax);
 }
 
 //perform bvh tree traversal and report overlapping triangles to 'callback'
@@ -320,7 +338,10 @@ void	btBvhTriangleMeshShape::processAllTriangles(btTriangleCallback* callback,co
 
 	MyNodeOverlapCallback	myNodeCallback(callback,m_meshInterface);
 
-	m_bvh->reportAabbOverlappingNodex(&myNodeCallback,aabbMin,aabbMax);
+	if (m_wideBvh)
+		m_wideBvh->reportAabbOverlappingNodex(&myNodeCallback,aabbMin,aabbMax);
+	else
+		m_bvh->reportAabbOverlappingNodex(&myNodeCallback,aabbMin,aabbMax);
 
 
 #endif//DISABLE_BVH
@@ -350,6 +371,7 @@ void   btBvhTriangleMeshShape::buildOptimizedBvh()
 	//rebuild the bvh...
 	m_bvh->build(m_meshInterface,m_useQuantizedAabbCompression,m_localAabbMin,m_localAabbMax);
 	m_ownsBvh = true;
+	updateWideBvh();
 }
 
 void   btBvhTriangleMeshShape::setOptimizedBvh(btOptimizedBvh* bvh, const btVector3& scaling)
@@ -364,6 +386,38 @@ void   btBvhTriangleMeshShape::setOptimizedBvh(btOptimizedBvh* bvh, const btVect
    {
       btTriangleMeshShape::setLocalScaling(scaling);
    }
+   updateWideBvh();
+}
+
+void	btBvhTriangleMeshShape::setUseWideBvh(bool useWideBvh)
+{
+	if (useWideBvh && !m_wideBvh)
+	{
+		void* mem = btAlignedAlloc(sizeof(btWideQuantizedBvh),16);
+		m_wideBvh = new(mem) btWideQuantizedBvh();
+		updateWideBvh();
+	}
+	if (!useWideBvh && m_wideBvh)
+	{
+		m_wideBvh->~btWideQuantizedBvh();
+		btAlignedFree(m_wideBvh);
+		m_wideBvh = 0;
+	}
+}
+
+void	btBvhTriangleMeshShape::updateWideBvh()
+{
+	//without bvh, the wide bvh is built together with it
+	if (!m_wideBvh || !m_bvh)
+		return;
+	//non-quantized trees have no wide version
+	if (m_bvh->isQuantized())
+	{
+		m_wideBvh->build(m_bvh);
+	} else
+	{
+		setUseWideBvh(false);
+	}
 }
 
 
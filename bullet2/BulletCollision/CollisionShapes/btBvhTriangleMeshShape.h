@@ -21,6 +21,8 @@ subject to the following restrictions:
 #include "LinearMath/btAlignedAllocator.h"
 #include "btTriangleInfoMap.h"
 
+class btWideQuantizedBvh;
+
 ///The btBvhTriangleMeshShape is a static-triangle mesh shape with several optimizations, such as bounding volume hierarchy and cache friendly traversal for PlayStation 3 Cell SPU. It is recommended to enable useQuantizedAabbCompression for better memory usage.
 ///It takes a triangle mesh as input, for example a btTriangleMesh or btTriangleIndexVertexArray. The btBvhTriangleMeshShape class allows for triangle mesh deformations by a refit or partialRefit method.
 ///Instead of building the bounding volume hierarchy acceleration structure, it is also possible to serialize (save) and deserialize (load) the structure from disk.
@@ -30,6 +32,7 @@ ATTRIBUTE_ALIGNED16(class) btBvhTriangleMeshShape : public btTriangleMeshShape
 
 	btOptimizedBvh*	m_bvh;
 	btTriangleInfoMap*	m_triangleInfoMap;
+	btWideQuantizedBvh*	m_wideBvh;
 
 	bool m_useQuantizedAabbCompression;
 	bool m_ownsBvh;
@@ -84,6 +87,24 @@ public:
 		return	m_useQuantizedAabbCompression;
 	}
 
+	///with useWideBvh, a 4-ary copy of the quantized bvh is built (see btWideQuantizedBvh) and processAllTriangles, performRaycast and performConvexcast
+	///traverse it instead. It is rebuilt with the bvh and refit with it, partialRefitTree only refits the wide nodes above the refit leaves.
+	///This pays off for large static meshes.
+	void	setUseWideBvh(bool useWideBvh);
+
+	bool	getUseWideBvh() const
+	{
+		return m_wideBvh!=0;
+	}
+
+	const btWideQuantizedBvh*	getWideBvh() const
+	{
+		return m_wideBvh;
+	}
+
+	///rebuilds the wide bvh after the btOptimizedBvh was changed directly, for example by btOptimizedBvh::updateBvhNodes
+	void	updateWideBvh();
+
 	void	setTriangleInfoMap(btTriangleInfoMap* triangleInfoMap)
 	{
 		m_triangleInfoMap = triangleInfoMap;
@@ -17,6 +17,14 @@ subject to the following restrictions:
 
 #include "LinearMath/btTransformUtil.h"
 
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BT_HEIGHTFIELD_SSE2
+#include <emmintrin.h>
+#endif
+
+//the local axes of the grid x and y, for each up axis
+static const int sGridAxes[3][2] = {{1,2},{0,2},{0,1}};
+
 
 
 btHeightfieldTerrainShape::btHeightfieldTerrainShape
@@ -407,3 +415,307 @@ const btVector3& btHeightfieldTerrainShape::getLocalScaling() const
 {
 	return m_localScaling;
 }
+
+
+
+btScalar	btHeightfieldTerrainShape::readRawHeight(int index) const
+{
+	switch (m_heightDataType)
+	{
+	case PHY_FLOAT:
+		return m_heightfieldDataFloat[index];
+	case PHY_UCHAR:
+		return m_heightfieldDataUnsignedChar[index] * m_heightScale;
+	case PHY_SHORT:
+		return m_heightfieldDataShort[index] * m_heightScale;
+	default:
+		btAssert(!"Bad m_heightDataType");
+	}
+	return btScalar(0.);
+}
+
+
+
+void	btHeightfieldTerrainShape::buildMinMaxMips()
+{
+	clearMinMaxMips();
+
+	int width = m_heightStickWidth-1;
+	int length = m_heightStickLength-1;
+	int total = 0;
+	for (;;)
+	{
+		int stride = (width+1)&~1;
+		int rows = (length+1)&~1;
+		m_mipOffsets.push_back(total);
+		m_mipStrides.push_back(stride);
+		total += stride*rows;
+		//the last level covers the terrain with a single entry
+		if (width==1 && length==1)
+			break;
+		width = (width+1)>>1;
+		length = (length+1)>>1;
+	}
+	//the padding stays empty, so it never overlaps a query
+	m_mipMinHeights.resize(total,BT_LARGE_FLOAT);
+	m_mipMaxHeights.resize(total,-BT_LARGE_FLOAT);
+
+	updateMipLevels(0,0,m_heightStickWidth-2,m_heightStickLength-2);
+}
+
+
+
+void	btHeightfieldTerrainShape::updateMinMaxMips(int startX,int startY,int endX,int endY)
+{
+	if (!hasMinMaxMips())
+		return;
+	//a sample is shared by the cells on both sides of it
+	updateMipLevels(btMax(startX-1,0),btMax(startY-1,0),btMin(endX,m_heightStickWidth-2),btMin(endY,m_heightStickLength-2));
+}
+
+
+
+void	btHeightfieldTerrainShape::clearMinMaxMips()
+{
+	m_mipMinHeights.clear();
+	m_mipMaxHeights.clear();
+	m_mipOffsets.clear();
+	m_mipStrides.clear();
+}
+
+
+
+///updateMipLevels recomputes the cells startX..endX, startY..endY (inclusive) of level 0 and the entries above them
+void	btHeightfieldTerrainShape::updateMipLevels(int startX,int startY,int endX,int endY)
+{
+	if (startX>endX || startY>endY)
+		return;
+
+	int stride = m_mipStrides[0];
+	for (int j=startY;j<=endY;j++)
+	{
+		int sample = j*m_heightStickWidth+startX;
+		int entry = j*stride+startX;
+		for (int x=startX;x<=endX;x++,sample++,entry++)
+		{
+			btScalar h00 = readRawHeight(sample);
+			btScalar h10 = readRawHeight(sample+1);
+			btScalar h01 = readRawHeight(sample+m_heightStickWidth);
+			btScalar h11 = readRawHeight(sample+m_heightStickWidth+1);
+			m_mipMinHeights[entry] = btMin(btMin(h00,h10),btMin(h01,h11));
+			m_mipMaxHeights[entry] = btMax(btMax(h00,h10),btMax(h01,h11));
+		}
+	}
+
+	for (int level=1;level<m_mipOffsets.size();level++)
+	{
+		startX >>= 1;
+		startY >>= 1;
+		endX >>= 1;
+		endY >>= 1;
+		int childOffset = m_mipOffsets[level-1];
+		int childStride = m_mipStrides[level-1];
+		int offset = m_mipOffsets[level];
+		stride = m_mipStrides[level];
+		for (int j=startY;j<=endY;j++)
+		{
+			for (int x=startX;x<=endX;x++)
+			{
+				int child0 = childOffset+2*j*childStride+2*x;
+				int child1 = child0+childStride;
+				int entry = offset+j*stride+x;
+				m_mipMinHeights[entry] = btMin(btMin(m_mipMinHeights[child0],m_mipMinHeights[child0+1]),btMin(m_mipMinHeights[child1],m_mipMinHeights[child1+1]));
+				m_mipMaxHeights[entry] = btMax(btMax(m_mipMaxHeights[child0],m_mipMaxHeights[child0+1]),btMax(m_mipMaxHeights[child1],m_mipMaxHeights[child1+1]));
+			}
+		}
+	}
+}
+
+
+
+///returns a bit for each entry of the 2x2 block at row0 and row1 whose height range overlaps minHeight..maxHeight
+static SIMD_FORCE_INLINE int btOverlappingMipEntries(const btScalar* mipMin,const btScalar* mipMax,int row0,int row1,btScalar minHeight,btScalar maxHeight)
+{
+#if defined (BT_HEIGHTFIELD_SSE2) && !defined (BT_USE_DOUBLE_PRECISION)
+	__m128 mins = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)(mipMin+row0)),(const __m64*)(mipMin+row1));
+	__m128 maxs = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),(const __m64*)(mipMax+row0)),(const __m64*)(mipMax+row1));
+	__m128 overlap = _mm_and_ps(_mm_cmple_ps(mins,_mm_set1_ps(maxHeight)),_mm_cmpge_ps(maxs,_mm_set1_ps(minHeight)));
+	return _mm_movemask_ps(overlap);
+#else
+	int mask = 0;
+	if (mipMin[row0]<=maxHeight && mipMax[row0]>=minHeight)
+		mask |= 1;
+	if (mipMin[row0+1]<=maxHeight && mipMax[row0+1]>=minHeight)
+		mask |= 2;
+	if (mipMin[row1]<=maxHeight && mipMax[row1]>=minHeight)
+		mask |= 4;
+	if (mipMin[row1+1]<=maxHeight && mipMax[row1+1]>=minHeight)
+		mask |= 8;
+	return mask;
+#endif
+}
+
+
+
+void	btHeightfieldTerrainShape::appendCellTriangles(int x,int y,btScalar minHeight,btScalar maxHeight,btAlignedObjectArray<btVector3>& vertices,btAlignedObjectArray<int>& cells) const
+{
+	int sample = y*m_heightStickWidth+x;
+	btScalar h00 = readRawHeight(sample);
+	btScalar h10 = readRawHeight(sample+1);
+	btScalar h01 = readRawHeight(sample+m_heightStickWidth);
+	btScalar h11 = readRawHeight(sample+m_heightStickWidth+1);
+	if (btMax(btMax(h00,h10),btMax(h01,h11))<minHeight || btMin(btMin(h00,h10),btMin(h01,h11))>maxHeight)
+		return;
+
+	//same vertices as getVertex
+	int axisX = sGridAxes[m_upAxis][0];
+	int axisY = sGridAxes[m_upAxis][1];
+	btVector3 v00,v10,v01,v11;
+	v00[axisX] = v01[axisX] = ((-m_width/btScalar(2.0)) + x)*m_localScaling[axisX];
+	v10[axisX] = v11[axisX] = ((-m_width/btScalar(2.0)) + (x+1))*m_localScaling[axisX];
+	v00[axisY] = v10[axisY] = ((-m_length/btScalar(2.0)) + y)*m_localScaling[axisY];
+	v01[axisY] = v11[axisY] = ((-m_length/btScalar(2.0)) + (y+1))*m_localScaling[axisY];
+	v00[m_upAxis] = (h00 - m_localOrigin[m_upAxis])*m_localScaling[m_upAxis];
+	v10[m_upAxis] = (h10 - m_localOrigin[m_upAxis])*m_localScaling[m_upAxis];
+	v01[m_upAxis] = (h01 - m_localOrigin[m_upAxis])*m_localScaling[m_upAxis];
+	v11[m_upAxis] = (h11 - m_localOrigin[m_upAxis])*m_localScaling[m_upAxis];
+	v00[3] = v10[3] = v01[3] = v11[3] = btScalar(0.);
+
+	//same split and winding as processAllTriangles
+	if (m_flipQuadEdges || (m_useDiamondSubdivision && !((y+x) & 1)))
+	{
+		vertices.push_back(v00);
+		vertices.push_back(v10);
+		vertices.push_back(v11);
+		vertices.push_back(v00);
+		vertices.push_back(v11);
+		vertices.push_back(v01);
+	} else
+	{
+		vertices.push_back(v00);
+		vertices.push_back(v01);
+		vertices.push_back(v10);
+		vertices.push_back(v10);
+		vertices.push_back(v01);
+		vertices.push_back(v11);
+	}
+	cells.push_back(x);
+	cells.push_back(y);
+	cells.push_back(x);
+	cells.push_back(y);
+}
+
+
+
+void	btHeightfieldTerrainShape::getTrianglesInAabb(const btVector3& aabbMin,const btVector3& aabbMax,btAlignedObjectArray<btVector3>& vertices,btAlignedObjectArray<int>& cells) const
+{
+	// convert to the unscaled grid, the up axis holds raw heights there
+	btVector3 invScaling(btScalar(1.)/m_localScaling[0],btScalar(1.)/m_localScaling[1],btScalar(1.)/m_localScaling[2]);
+	btVector3 localAabbMin = aabbMin*invScaling + m_localOrigin;
+	btVector3 localAabbMax = aabbMax*invScaling + m_localOrigin;
+	btVector3 gridMin = localAabbMin;
+	btVector3 gridMax = localAabbMax;
+	gridMin.setMin(localAabbMax);
+	gridMax.setMax(localAabbMin);
+
+	int axisX = sGridAxes[m_upAxis][0];
+	int axisY = sGridAxes[m_upAxis][1];
+	if (gridMax[axisX]<btScalar(0.) || gridMin[axisX]>m_width || gridMax[axisY]<btScalar(0.) || gridMin[axisY]>m_length)
+		return;
+	if (gridMax[m_upAxis]<m_minHeight || gridMin[m_upAxis]>m_maxHeight)
+		return;
+
+	int lastX = m_heightStickWidth-2;
+	int lastY = m_heightStickLength-2;
+	//the ranges are clamped to positive values, so truncating rounds down
+	int startX = btMin(int(btMax(gridMin[axisX],btScalar(0.))),lastX);
+	int endX = btMin(int(btMin(gridMax[axisX],m_width)),lastX);
+	int startY = btMin(int(btMax(gridMin[axisY],btScalar(0.))),lastY);
+	int endY = btMin(int(btMin(gridMax[axisY],m_length)),lastY);
+	//cells that only touch the aabb overlap it too
+	if (startX>0 && btScalar(startX)==gridMin[axisX])
+		startX--;
+	if (startY>0 && btScalar(startY)==gridMin[axisY])
+		startY--;
+	btScalar minHeight = gridMin[m_upAxis];
+	btScalar maxHeight = gridMax[m_upAxis];
+
+	if (!hasMinMaxMips())
+	{
+		for (int y=startY;y<=endY;y++)
+		{
+			for (int x=startX;x<=endX;x++)
+			{
+				appendCellTriangles(x,y,minHeight,maxHeight,vertices,cells);
+			}
+		}
+		return;
+	}
+
+	//start at the finest level where the range spans at most 2x2 entries
+	int numLevels = m_mipOffsets.size();
+	int level = 0;
+	while (level<numLevels-1 && ((endX>>level)-(startX>>level)>1 || (endY>>level)-(startY>>level)>1))
+	{
+		level++;
+	}
+
+	const btScalar* mipMin = &m_mipMinHeights[0];
+	const btScalar* mipMax = &m_mipMaxHeights[0];
+
+	//entries are (level,x,y), at most 3 are left on the stack per level
+	int stack[3*(3*32+4)];
+	int stackSize = 0;
+	for (int y=startY>>level;y<=(endY>>level);y++)
+	{
+		for (int x=startX>>level;x<=(endX>>level);x++)
+		{
+			int entry = m_mipOffsets[level]+y*m_mipStrides[level]+x;
+			if (mipMin[entry]<=maxHeight && mipMax[entry]>=minHeight)
+			{
+				stack[stackSize++] = level;
+				stack[stackSize++] = x;
+				stack[stackSize++] = y;
+			}
+		}
+	}
+
+	while (stackSize)
+	{
+		int y = stack[--stackSize];
+		int x = stack[--stackSize];
+		int entryLevel = stack[--stackSize];
+		if (entryLevel==0)
+		{
+			appendCellTriangles(x,y,minHeight,maxHeight,vertices,cells);
+			continue;
+		}
+
+		int childLevel = entryLevel-1;
+		int childX = 2*x;
+		int childY = 2*y;
+		int row0 = m_mipOffsets[childLevel]+childY*m_mipStrides[childLevel]+childX;
+		int mask = btOverlappingMipEntries(mipMin,mipMax,row0,row0+m_mipStrides[childLevel],minHeight,maxHeight);
+
+		//clip the children to the query range
+		if (childX<(startX>>childLevel))
+			mask &= ~(1|4);
+		if (childX+1>(endX>>childLevel))
+			mask &= ~(2|8);
+		if (childY<(startY>>childLevel))
+			mask &= ~(1|2);
+		if (childY+1>(endY>>childLevel))
+			mask &= ~(4|8);
+
+		//push in reverse, so the children are visited in row order
+		for (int i=3;i>=0;i--)
+		{
+			if (mask & (1<<i))
+			{
+				stack[stackSize++] = childLevel;
+				stack[stackSize++] = childX+(i&1);
+				stack[stackSize++] = childY+(i>>1);
+			}
+		}
+	}
+}
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_HEIGHTFIELD_TERRAIN_SHAPE_H
 
 #include "btConcaveShape.h"
+#include "LinearMath/btAlignedObjectArray.h"
 
 ///btHeightfieldTerrainShape simulates a 2D heightfield terrain
 /**
@@ -99,10 +100,23 @@ protected:
 	
 	btVector3	m_localScaling;
 
+	///min/max mip levels of the raw cell heights, see buildMinMaxMips.
+	///Level 0 has one entry per grid cell, each coarser level one entry per 2x2 entries of the level below.
+	///Every level is padded to an even width and length with empty entries (min > max), so the 4 children of an entry are always 2 pairs of adjacent values.
+	btAlignedObjectArray<btScalar>	m_mipMinHeights;
+	btAlignedObjectArray<btScalar>	m_mipMaxHeights;
+	btAlignedObjectArray<int>		m_mipOffsets;
+	btAlignedObjectArray<int>		m_mipStrides;
+
 	virtual btScalar	getRawHeightFieldValue(int x,int y) const;
 	void		quantizeWithClamp(int* out, const btVector3& point,int isMax) const;
 	void		getVertex(int x,int y,btVector3& vertex) const;
 
+	///reads the raw height at a sample index without the virtual getRawHeightFieldValue call
+	btScalar	readRawHeight(int index) const;
+	void		updateMipLevels(int startX,int startY,int endX,int endY);
+	void		appendCellTriangles(int x,int y,btScalar minHeight,btScalar maxHeight,btAlignedObjectArray<btVector3>& vertices,btAlignedObjectArray<int>& cells) const;
+
 
 
 	/// protected initialization
@@ -150,6 +164,32 @@ public:
 
 	virtual void	processAllTriangles(btTriangleCallback* callback,const btVector3& aabbMin,const btVector3& aabbMax) const;
 
+	///getTrianglesInAabb appends the triangles of all grid cells that overlap the aabb (in the scaled local frame of the shape) to vertices, 3 vertices per triangle.
+	///The triangles and their vertices are the same as reported by processAllTriangles, the cell x and y of each triangle are appended to cells.
+	///Unlike processAllTriangles, cells that are entirely above or below the aabb are skipped, using the min/max mips if they are built.
+	///The heights are read from the heightfield data directly, so subclasses that override getRawHeightFieldValue should not use it.
+	void	getTrianglesInAabb(const btVector3& aabbMin,const btVector3& aabbMax,btAlignedObjectArray<btVector3>& vertices,btAlignedObjectArray<int>& cells) const;
+
+	///buildMinMaxMips stores the minimum and maximum height of every cell and of every 2x2, 4x4, ... block of cells,
+	///so getTrianglesInAabb can skip whole blocks of the terrain hierarchically. It uses about 2.7 scalars per cell.
+	///The mips are not updated automatically: call updateMinMaxMips after changing heights in the heightfield data.
+	void	buildMinMaxMips();
+
+	///updateMinMaxMips refreshes the mips after the heights of the samples startX..endX, startY..endY (inclusive) changed
+	void	updateMinMaxMips(int startX,int startY,int endX,int endY);
+
+	void	clearMinMaxMips();
+
+	bool	hasMinMaxMips() const
+	{
+		return m_mipOffsets.size()!=0;
+	}
+
+	int		getUpAxis() const
+	{
+		return m_upAxis;
+	}
+
 	virtual void	calculateLocalInertia(btScalar mass,btVector3& inertia) const;
 
 	virtual void	setLocalScaling(const btVector3& scaling);
@@ -179,9 +179,14 @@ void btOptimizedBvh::build(btStridingMeshInterface* triangles, bool useQuantized
 		m_contiguousNodes.resize(2*numLeafNodes);
 	}
 
-	m_curNodeIndex = 0;
-
-	buildTree(0,numLeafNodes);
+	if (m_useQuantization)
+	{
+		buildQuantizedTreeBinned(numLeafNodes);
+	} else
+	{
+		m_curNodeIndex = 0;
+		buildTree(0,numLeafNodes);
+	}
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if(m_useQuantization && !m_SubtreeHeaders.size())
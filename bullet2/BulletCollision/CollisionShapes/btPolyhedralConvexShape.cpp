@@ -328,7 +328,7 @@ btVector3	btPolyhedralConvexShape::localGetSupportingVertexWithoutMargin(const b
         btVector3 temp[128];
         int inner_count = MIN(getNumVertices() - k, 128);
         for( i = 0; i < inner_count; i++ )
-            getVertex(i,temp[i]); 
+            getVertex(k+i,temp[i]); 
         i = (int) vec.maxDot( temp, inner_count, newDot);
 		if (newDot > maxDot)
 		{
@@ -356,24 +356,25 @@ void	btPolyhedralConvexShape::batchedUnitVectorGetSupportingVertexWithoutMargin(
 		supportVerticesOut[i][3] = btScalar(-BT_LARGE_FLOAT);
 	}
 
-	for (int j=0;j<numVectors;j++)
+	//gather each chunk of vertices once and query all directions against it
+	for( int k = 0; k < getNumVertices(); k += 128 )
 	{
-        const btVector3& vec = vectors[j];
-        
-        for( int k = 0; k < getNumVertices(); k += 128 )
-        {
-            btVector3 temp[128];
-            int inner_count = MIN(getNumVertices() - k, 128);
-            for( i = 0; i < inner_count; i++ )
-                getVertex(i,temp[i]); 
-            i = (int) vec.maxDot( temp, inner_count, newDot);
-            if (newDot > supportVerticesOut[j][3])
-            {
+		btVector3 temp[128];
+		int inner_count = MIN(getNumVertices() - k, 128);
+		for( i = 0; i < inner_count; i++ )
+			getVertex(k+i,temp[i]);
+
+		for (int j=0;j<numVectors;j++)
+		{
+			const btVector3& vec = vectors[j];
+			i = (int) vec.maxDot( temp, inner_count, newDot);
+			if (newDot > supportVerticesOut[j][3])
+			{
 				supportVerticesOut[j] = temp[i];
 				supportVerticesOut[j][3] = newDot;
-            }        
-        }
-    }
+			}
+		}
+	}
 
 #endif //__SPU__
 }
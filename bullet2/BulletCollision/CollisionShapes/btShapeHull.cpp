@@ -18,6 +18,7 @@ subject to the following restrictions:
 
 #include "btShapeHull.h"
 #include "LinearMath/btConvexHull.h"
+#include "LinearMath/btThreads.h"
 
 #define NUM_UNITSPHERE_POINTS 42
 
@@ -36,28 +37,41 @@ btShapeHull::~btShapeHull ()
 }
 
 bool
-btShapeHull::buildHull (btScalar /*margin*/)
+btShapeHull::buildHull (btScalar margin)
 {
+	HullLibrary hl;
+	return buildHull(margin,hl);
+}
+
+bool
+btShapeHull::buildHull (btScalar /*margin*/, HullLibrary& hl)
+{
+	//the preferred directions are appended to a local copy, so hulls can be built concurrently
+	btVector3 directions[NUM_UNITSPHERE_POINTS+MAX_PREFERRED_PENETRATION_DIRECTIONS*2];
 	int numSampleDirections = NUM_UNITSPHERE_POINTS;
+	int i;
+	for (i = 0; i < NUM_UNITSPHERE_POINTS; i++)
+	{
+		directions[i] = getUnitSpherePoints()[i];
+	}
 	{
 		int numPDA = m_shape->getNumPreferredPenetrationDirections();
 		if (numPDA)
 		{
-			for (int i=0;i<numPDA;i++)
+			for (i=0;i<numPDA;i++)
 			{
 				btVector3 norm;
 				m_shape->getPreferredPenetrationDirection(i,norm);
-				getUnitSpherePoints()[numSampleDirections] = norm;
+				directions[numSampleDirections] = norm;
 				numSampleDirections++;
 			}
 		}
 	}
 
 	btVector3 supportPoints[NUM_UNITSPHERE_POINTS+MAX_PREFERRED_PENETRATION_DIRECTIONS*2];
-	int i;
 	for (i = 0; i < numSampleDirections; i++)
 	{
-		supportPoints[i] = m_shape->localGetSupportingVertex(getUnitSpherePoints()[i]);
+		supportPoints[i] = m_shape->localGetSupportingVertex(directions[i]);
 	}
 
 	HullDesc hd;
@@ -72,7 +86,6 @@ btShapeHull::buildHull (btScalar /*margin*/)
 	hd.mVertexStride = sizeof (btVector3);
 #endif
 
-	HullLibrary hl;
 	HullResult hr;
 	if (hl.CreateConvexHull (hd, hr) == QE_FAIL)
 	{
@@ -99,6 +112,39 @@ btShapeHull::buildHull (btScalar /*margin*/)
 	return true;
 }
 
+struct btShapeHullBuildBody : public btIParallelForBody
+{
+	btShapeHull* const*	m_hulls;
+	btScalar	m_margin;
+	mutable int	m_numBuilt;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		//one HullLibrary per task, its triangle arrays are reused
+		HullLibrary hl;
+		int numBuilt = 0;
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			if (m_hulls[i]->buildHull(m_margin,hl))
+			{
+				numBuilt++;
+			}
+		}
+		btAtomicAdd(&m_numBuilt,numBuilt);
+	}
+};
+
+int
+btShapeHull::buildHulls (btShapeHull* const* hulls, int numHulls, btScalar margin)
+{
+	btShapeHullBuildBody body;
+	body.m_hulls = hulls;
+	body.m_margin = margin;
+	body.m_numBuilt = 0;
+	btParallelFor(0,numHulls,16,body);
+	return body.m_numBuilt;
+}
+
 int
 btShapeHull::numTriangles () const
 {
@@ -21,6 +21,8 @@ subject to the following restrictions:
 #include "LinearMath/btAlignedObjectArray.h"
 #include "BulletCollision/CollisionShapes/btConvexShape.h"
 
+class HullLibrary;
+
 
 ///The btShapeHull class takes a btConvexShape, builds a simplified convex hull using btConvexHull and provides triangle indices and vertices.
 ///It can be useful for to simplify a complex convex object and for visualization of a non-polyhedral convex object.
@@ -36,6 +38,10 @@ protected:
 
 	static btVector3* getUnitSpherePoints();
 
+	bool buildHull (btScalar margin, HullLibrary& hl);
+
+	friend struct btShapeHullBuildBody;
+
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
 	
@@ -44,6 +50,9 @@ public:
 
 	bool buildHull (btScalar margin);
 
+	///buildHulls builds the hulls concurrently with btParallelFor and returns the number of hulls that were built successfully
+	static int buildHulls (btShapeHull* const* hulls, int numHulls, btScalar margin);
+
 	int numTriangles () const;
 	int numVertices () const;
 	int numIndices () const;
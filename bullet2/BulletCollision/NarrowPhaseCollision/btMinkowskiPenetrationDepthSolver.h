@@ -24,7 +24,8 @@ class btMinkowskiPenetrationDepthSolver : public btConvexPenetrationDepthSolver
 {
 protected:
 
-	static btVector3*	getPenetrationDirections();
+	///getPenetrationDirections returns the constant sample directions, without preferred penetration directions
+	static const btVector3*	getPenetrationDirections();
 
 public:
 
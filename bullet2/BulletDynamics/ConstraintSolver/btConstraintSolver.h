@@ -44,6 +44,14 @@ public:
 
 	///clear internal cached data and reset random seed
 	virtual	void	reset() = 0;
+
+	///createTaskSolver returns a new solver of the same type and with the same settings, allocated with btAlignedAlloc.
+	///btDiscreteDynamicsWorld::setNumTasks uses it to give every solver task its own solver. Solvers that return 0 are only run on a single task.
+	///A class derived from a solver that implements it has to override it as well, otherwise its tasks get solvers of the base type.
+	virtual btConstraintSolver*	createTaskSolver() const
+	{
+		return 0;
+	}
 };
 
 
@@ -29,7 +29,10 @@ enum	btSolverMode
 	SOLVER_CACHE_FRIENDLY = 128,
 	SOLVER_SIMD = 256,
 	SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS = 512,
-	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024
+	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024,
+	///SOLVER_BATCHED colors the manifolds and joints into batches that don't share a dynamic body, and spreads the batches over the threads of the task scheduler (see btThreads.h).
+	///The contact and friction rows of BT_CONSTRAINT_ROW_LANES manifolds of a batch are solved side by side by a SoA (SSE) row kernel
+	SOLVER_BATCHED = 2048
 };
 
 struct btContactSolverInfoData
@@ -26,17 +26,20 @@ subject to the following restrictions:
 #include <new>
 #include "LinearMath/btStackAlloc.h"
 #include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
 //#include "btSolverBody.h"
 //#include "btSolverConstraint.h"
 #include "LinearMath/btAlignedObjectArray.h"
 #include <string.h> //for memset
 
+///gNumSplitImpulseRecoveries is updated with btAtomicAdd, since several solvers can run at the same time
 int		gNumSplitImpulseRecoveries = 0;
 
 #include "BulletDynamics/Dynamics/btRigidBody.h"
 
 btSequentialImpulseConstraintSolver::btSequentialImpulseConstraintSolver()
-:m_btSeed2(0)
+:m_useConstraintRowLanes(true),
+m_btSeed2(0)
 {
 
 }
@@ -55,6 +58,12 @@ static inline __m128 btSimdDot3( __m128 vec0, __m128 vec1 )
 }
 #endif//USE_SIMD
 
+///the SoA row kernel of SOLVER_BATCHED only needs the SSE intrinsics, not the SSE layout of btVector3 that USE_SIMD requires, so it is used by all SSE builds
+#if (BT_CONSTRAINT_ROW_LANES == 4) && !defined (BT_USE_DOUBLE_PRECISION) && (defined (USE_SIMD) || defined (__SSE__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 1))
+#define BT_USE_SSE_ROW_LANES 1
+#include <emmintrin.h>
+#endif
+
 // Project Gauss Seidel or the equivalent Sequential Impulse
 void btSequentialImpulseConstraintSolver::resolveSingleConstraintRowGenericSIMD(btSolverBody& body1,btSolverBody& body2,const btSolverConstraint& c)
 {
@@ -180,7 +189,6 @@ void	btSequentialImpulseConstraintSolver::resolveSplitPenetrationImpulseCacheFri
 {
 		if (c.m_rhsPenetration)
         {
-			gNumSplitImpulseRecoveries++;
 			btScalar deltaImpulse = c.m_rhsPenetration-btScalar(c.m_appliedPushImpulse)*c.m_cfm;
 			const btScalar deltaVel1Dotn	=	c.m_contactNormal.dot(body1.internalGetPushVelocity()) 	+ c.m_relpos1CrossNormal.dot(body1.internalGetTurnVelocity());
 			const btScalar deltaVel2Dotn	=	-c.m_contactNormal.dot(body2.internalGetPushVelocity()) + c.m_relpos2CrossNormal.dot(body2.internalGetTurnVelocity());
@@ -208,8 +216,6 @@ void	btSequentialImpulseConstraintSolver::resolveSplitPenetrationImpulseCacheFri
 	if (!c.m_rhsPenetration)
 		return;
 
-	gNumSplitImpulseRecoveries++;
-
 	__m128 cpAppliedImp = _mm_set1_ps(c.m_appliedPushImpulse);
 	__m128	lowerLimit1 = _mm_set1_ps(c.m_lowerLimit);
 	__m128	upperLimit1 = _mm_set1_ps(c.m_upperLimit);
@@ -846,11 +852,30 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 			m_tmpSolverNonContactConstraintPool.resizeNoInitialize(totalNumRows);
 
 			
+			///in batched mode, the joints are converted in batch order so the rows of each batch are contiguous
+			const bool batched = (infoGlobal.m_solverMode & SOLVER_BATCHED) != 0;
+			if (batched)
+			{
+				m_tmpGroupBodyIds.resizeNoInitialize(numConstraints*2);
+				for (i=0;i<numConstraints;i++)
+				{
+					m_tmpGroupBodyIds[i*2] = getOrInitSolverBody(constraints[i]->getRigidBodyA());
+					m_tmpGroupBodyIds[i*2+1] = getOrInitSolverBody(constraints[i]->getRigidBodyB());
+				}
+				batchConstraintGroups(m_nonContactBatches);
+				m_nonContactBatches.m_groupRowOffsets.resizeNoInitialize(numConstraints+1);
+			}
+
 			///setup the btSolverConstraints
 			int currentRow = 0;
 
-			for (i=0;i<numConstraints;i++)
+			int k;
+			for (k=0;k<numConstraints;k++)
 			{
+				i = batched ? m_tmpGroupOrder[k] : k;
+				if (batched)
+					m_nonContactBatches.m_groupRowOffsets[k] = currentRow;
+
 				const btTypedConstraint::btConstraintInfo1& info1 = m_tmpConstraintSizesPool[i];
 				
 				if (info1.m_numConstraintRows)
@@ -981,6 +1006,8 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 				}
 				currentRow+=m_tmpConstraintSizesPool[i].m_numConstraintRows;
 			}
+			if (batched)
+				m_nonContactBatches.m_groupRowOffsets[numConstraints] = currentRow;
 		}
 
 		{
@@ -989,10 +1016,38 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 //			btCollisionObject* colObj0=0,*colObj1=0;
 
 
-			for (i=0;i<numManifolds;i++)
+			if (infoGlobal.m_solverMode & SOLVER_BATCHED)
+			{
+				///convert the manifolds in batch order, each manifold forms one group of contact rows and one group of friction rows
+				m_tmpGroupBodyIds.resizeNoInitialize(numManifolds*2);
+				for (i=0;i<numManifolds;i++)
+				{
+					m_tmpGroupBodyIds[i*2] = getOrInitSolverBody(*(btCollisionObject*)manifoldPtr[i]->getBody0());
+					m_tmpGroupBodyIds[i*2+1] = getOrInitSolverBody(*(btCollisionObject*)manifoldPtr[i]->getBody1());
+				}
+				batchConstraintGroups(m_contactBatches);
+				m_contactBatches.m_groupRowOffsets.resizeNoInitialize(numManifolds+1);
+				m_frictionBatches.m_groupRowOffsets.resizeNoInitialize(numManifolds+1);
+				for (i=0;i<numManifolds;i++)
+				{
+					m_contactBatches.m_groupRowOffsets[i] = m_tmpSolverContactConstraintPool.size();
+					m_frictionBatches.m_groupRowOffsets[i] = m_tmpSolverContactFrictionConstraintPool.size();
+					manifold = manifoldPtr[m_tmpGroupOrder[i]];
+					convertContact(manifold,infoGlobal);
+				}
+				m_contactBatches.m_groupRowOffsets[numManifolds] = m_tmpSolverContactConstraintPool.size();
+				m_frictionBatches.m_groupRowOffsets[numManifolds] = m_tmpSolverContactFrictionConstraintPool.size();
+				m_frictionBatches.m_batchOffsets = m_contactBatches.m_batchOffsets;
+				m_frictionBatches.m_numIndependentBatches = m_contactBatches.m_numIndependentBatches;
+				if (m_useConstraintRowLanes)
+					packConstraintRowLanes();
+			} else
 			{
-				manifold = manifoldPtr[i];
-				convertContact(manifold,infoGlobal);
+				for (i=0;i<numManifolds;i++)
+				{
+					manifold = manifoldPtr[i];
+					convertContact(manifold,infoGlobal);
+				}
 			}
 		}
 	}
@@ -1032,9 +1087,547 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 
 }
 
+///the row types of the SOLVER_BATCHED mode, they select the limits and the row kernel used by solveConstraintRowGroups
+enum btBatchedRowType
+{
+	BT_NON_CONTACT_ROWS,
+	BT_CONTACT_ROWS,
+	BT_FRICTION_ROWS,
+	BT_SPLIT_IMPULSE_ROWS
+};
+
+struct btSolveRowGroupsLoop : public btIParallelForBody
+{
+	btSequentialImpulseConstraintSolver*	m_solver;
+	btConstraintArray*	m_constraintPool;
+	const btSequentialImpulseConstraintSolver::btConstraintRowBatches*	m_batches;
+	int		m_rowType;
+	int		m_iteration;
+
+	virtual void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("solveConstraintRowGroups");
+		m_solver->solveConstraintRowGroups(*m_constraintPool,*m_batches,m_rowType,m_iteration,iBegin,iEnd);
+	}
+};
+
+///batchConstraintGroups colors the groups (manifolds or joints) greedily in their original order: each group gets the first batch that doesn't contain one of its dynamic bodies yet.
+///The solver body ids of group g are m_tmpGroupBodyIds[g*2] and m_tmpGroupBodyIds[g*2+1]. On return, m_tmpGroupOrder lists the groups batch by batch.
+///The order of the groups within a batch is kept, so the result doesn't depend on the number of threads.
+void	btSequentialImpulseConstraintSolver::batchConstraintGroups(btConstraintRowBatches& batches)
+{
+	const int maxIndependentBatches = 32;
+	int batchSizes[maxIndependentBatches+1];
+	int i;
+
+	for (i=0;i<=maxIndependentBatches;i++)
+	{
+		batchSizes[i] = 0;
+	}
+
+	int numBodies = m_tmpSolverBodyPool.size();
+	m_tmpBodyBatchMasks.resizeNoInitialize(numBodies);
+	for (i=0;i<numBodies;i++)
+	{
+		m_tmpBodyBatchMasks[i] = 0;
+	}
+
+	int numGroups = m_tmpGroupBodyIds.size()/2;
+	m_tmpGroupBatchIds.resizeNoInitialize(numGroups);
+	int numIndependentBatches = 0;
+	for (i=0;i<numGroups;i++)
+	{
+		int bodyIdA = m_tmpGroupBodyIds[i*2];
+		int bodyIdB = m_tmpGroupBodyIds[i*2+1];
+		bool dynamicA = m_tmpSolverBodyPool[bodyIdA].m_originalBody!=0;
+		bool dynamicB = m_tmpSolverBodyPool[bodyIdB].m_originalBody!=0;
+		unsigned int usedBatches = (dynamicA ? m_tmpBodyBatchMasks[bodyIdA] : 0) | (dynamicB ? m_tmpBodyBatchMasks[bodyIdB] : 0);
+		int batch = 0;
+		while (batch < maxIndependentBatches && (usedBatches & (1u<<batch)))
+		{
+			batch++;
+		}
+		if (batch < maxIndependentBatches)
+		{
+			if (dynamicA)
+				m_tmpBodyBatchMasks[bodyIdA] |= (1u<<batch);
+			if (dynamicB)
+				m_tmpBodyBatchMasks[bodyIdB] |= (1u<<batch);
+			numIndependentBatches = btMax(numIndependentBatches,batch+1);
+		}
+		m_tmpGroupBatchIds[i] = batch;
+		batchSizes[batch]++;
+	}
+
+	///groups that didn't fit in an independent batch go into a final batch that is solved in order
+	int numBatches = batchSizes[maxIndependentBatches] ? numIndependentBatches+1 : numIndependentBatches;
+	batches.m_numIndependentBatches = numIndependentBatches;
+	batches.m_batchOffsets.resizeNoInitialize(numBatches+1);
+	int offset = 0;
+	for (i=0;i<numBatches;i++)
+	{
+		int batch = i<numIndependentBatches ? i : maxIndependentBatches;
+		batches.m_batchOffsets[i] = offset;
+		offset += batchSizes[batch];
+		batchSizes[batch] = batches.m_batchOffsets[i];
+	}
+	batches.m_batchOffsets[numBatches] = offset;
+
+	m_tmpGroupOrder.resizeNoInitialize(numGroups);
+	for (i=0;i<numGroups;i++)
+	{
+		m_tmpGroupOrder[batchSizes[m_tmpGroupBatchIds[i]]++] = i;
+	}
+}
+
+///solveConstraintRowGroups solves the rows of the groups [groupBegin,groupEnd) in order. It is called concurrently for groups of the same independent batch,
+///so it only uses the row kernels that never write to the shared fixed solver body.
+void	btSequentialImpulseConstraintSolver::solveConstraintRowGroups(btConstraintArray& constraintPool, const btConstraintRowBatches& batches, int rowType, int iteration, int groupBegin, int groupEnd)
+{
+	int rowBegin = batches.m_groupRowOffsets[groupBegin];
+	int rowEnd = batches.m_groupRowOffsets[groupEnd];
+	for (int row=rowBegin;row<rowEnd;row++)
+	{
+		btSolverConstraint& c = constraintPool[row];
+		btSolverBody& bodyA = m_tmpSolverBodyPool[c.m_solverBodyIdA];
+		btSolverBody& bodyB = m_tmpSolverBodyPool[c.m_solverBodyIdB];
+		switch (rowType)
+		{
+		case BT_NON_CONTACT_ROWS:
+			if (iteration < c.m_overrideNumSolverIterations)
+				resolveSingleConstraintRowGeneric(bodyA,bodyB,c);
+			break;
+		case BT_CONTACT_ROWS:
+			resolveSingleConstraintRowLowerLimit(bodyA,bodyB,c);
+			break;
+		case BT_FRICTION_ROWS:
+			{
+				btScalar totalImpulse = m_tmpSolverContactConstraintPool[c.m_frictionIndex].m_appliedImpulse;
+				if (totalImpulse>btScalar(0))
+				{
+					c.m_lowerLimit = -(c.m_friction*totalImpulse);
+					c.m_upperLimit = c.m_friction*totalImpulse;
+					resolveSingleConstraintRowGeneric(bodyA,bodyB,c);
+				}
+			}
+			break;
+		case BT_SPLIT_IMPULSE_ROWS:
+			resolveSplitPenetrationImpulseCacheFriendly(bodyA,bodyB,c);
+			break;
+		}
+	}
+}
+
+struct btSolveRowPacketsLoop : public btIParallelForBody
+{
+	btSequentialImpulseConstraintSolver*	m_solver;
+	int		m_rowType;
+
+	virtual void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("solveConstraintRowPackets");
+		m_solver->solveConstraintRowPackets(m_rowType,iBegin,iEnd);
+	}
+};
+
+#ifdef BT_USE_SSE_ROW_LANES
+static const btScalar btZeroLane[4] = {0.f,0.f,0.f,0.f};
+
+///btLoadLanes transposes a vector of the 4 bodies of a packet into x, y, z and w lanes, the lanes of empty bodies are zero
+static SIMD_FORCE_INLINE void btLoadLanes(btSolverBody* const* bodies, btVector3 btSolverBody::* vector, __m128* lanes)
+{
+	for (int l=0;l<4;l++)
+	{
+		lanes[l] = _mm_loadu_ps(bodies[l] ? (bodies[l]->*vector).m_floats : btZeroLane);
+	}
+	_MM_TRANSPOSE4_PS(lanes[0],lanes[1],lanes[2],lanes[3]);
+}
+
+///btStoreLanes writes the lanes back to the dynamic bodies. Static bodies are shared by the threads and are never written.
+static SIMD_FORCE_INLINE void btStoreLanes(btSolverBody* const* bodies, btVector3 btSolverBody::* vector, __m128* lanes)
+{
+	_MM_TRANSPOSE4_PS(lanes[0],lanes[1],lanes[2],lanes[3]);
+	for (int l=0;l<4;l++)
+	{
+		if (bodies[l] && bodies[l]->m_originalBody)
+			_mm_storeu_ps((bodies[l]->*vector).m_floats,lanes[l]);
+	}
+}
+
+static SIMD_FORCE_INLINE __m128 btDotLanes(const btScalar (*a)[4], const __m128* b)
+{
+	__m128 result = _mm_add_ps(_mm_mul_ps(_mm_load_ps(a[0]),b[0]),_mm_mul_ps(_mm_load_ps(a[1]),b[1]));
+	return _mm_add_ps(result,_mm_mul_ps(_mm_load_ps(a[2]),b[2]));
+}
+
+static SIMD_FORCE_INLINE __m128 btSelectLanes(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask,a),_mm_andnot_ps(mask,b));
+}
+#endif //BT_USE_SSE_ROW_LANES
+
+void	btSequentialImpulseConstraintSolver::setConstraintRowLane(btConstraintRowLane& rowLane, int lane, const btSolverConstraint* row, int poolIndex, int contactRow)
+{
+	for (int i=0;i<3;i++)
+	{
+		rowLane.m_contactNormal[i][lane] = row ? row->m_contactNormal[i] : btScalar(0.);
+		rowLane.m_relpos1CrossNormal[i][lane] = row ? row->m_relpos1CrossNormal[i] : btScalar(0.);
+		rowLane.m_relpos2CrossNormal[i][lane] = row ? row->m_relpos2CrossNormal[i] : btScalar(0.);
+		rowLane.m_angularComponentA[i][lane] = row ? row->m_angularComponentA[i] : btScalar(0.);
+		rowLane.m_angularComponentB[i][lane] = row ? row->m_angularComponentB[i] : btScalar(0.);
+	}
+	rowLane.m_rhs[lane] = row ? row->m_rhs : btScalar(0.);
+	rowLane.m_cfm[lane] = row ? row->m_cfm : btScalar(0.);
+	rowLane.m_jacDiagABInv[lane] = row ? row->m_jacDiagABInv : btScalar(0.);
+	rowLane.m_lowerLimit[lane] = row ? row->m_lowerLimit : btScalar(0.);
+	rowLane.m_friction[lane] = row ? row->m_friction : btScalar(0.);
+	rowLane.m_appliedImpulse[lane] = row ? btScalar(row->m_appliedImpulse) : btScalar(0.);
+	rowLane.m_poolIndex[lane] = poolIndex;
+	rowLane.m_contactRow[lane] = contactRow;
+}
+
+///resolveConstraintRowLanes solves the contact rows (lower limit) or friction rows (limits from the impulse of their contact row) of a packet.
+///The lanes don't share a dynamic body, and every lane solves its rows in order with the arithmetic of resolveSingleConstraintRowLowerLimit
+///and resolveSingleConstraintRowGeneric, so the impulses are the same as those of solveConstraintRowGroups.
+void	btSequentialImpulseConstraintSolver::resolveConstraintRowLanes(const btConstraintRowPacket& packet, btSolverBody* const* bodiesA, btSolverBody* const* bodiesB, btConstraintRowLane* rows, int numRows, const btConstraintRowLane* contactRows, bool friction)
+{
+#ifdef BT_USE_SSE_ROW_LANES
+	//the velocities stay in registers while all rows of the packet are solved
+	__m128 deltaLinearA[4],deltaAngularA[4],deltaLinearB[4],deltaAngularB[4];
+	btLoadLanes(bodiesA,&btSolverBody::m_deltaLinearVelocity,deltaLinearA);
+	btLoadLanes(bodiesA,&btSolverBody::m_deltaAngularVelocity,deltaAngularA);
+	btLoadLanes(bodiesB,&btSolverBody::m_deltaLinearVelocity,deltaLinearB);
+	btLoadLanes(bodiesB,&btSolverBody::m_deltaAngularVelocity,deltaAngularB);
+
+	const __m128 signMask = _mm_set1_ps(-0.f);
+	for (int r=0;r<numRows;r++)
+	{
+		btConstraintRowLane& row = rows[r];
+		__m128 appliedImpulse = _mm_load_ps(row.m_appliedImpulse);
+		__m128 jacDiagABInv = _mm_load_ps(row.m_jacDiagABInv);
+		__m128 deltaImpulse = _mm_sub_ps(_mm_load_ps(row.m_rhs),_mm_mul_ps(appliedImpulse,_mm_load_ps(row.m_cfm)));
+		__m128 deltaVel1Dotn = _mm_add_ps(btDotLanes(row.m_contactNormal,deltaLinearA),btDotLanes(row.m_relpos1CrossNormal,deltaAngularA));
+		__m128 deltaVel2Dotn = _mm_add_ps(_mm_xor_ps(btDotLanes(row.m_contactNormal,deltaLinearB),signMask),btDotLanes(row.m_relpos2CrossNormal,deltaAngularB));
+		deltaImpulse = _mm_sub_ps(deltaImpulse,_mm_mul_ps(deltaVel1Dotn,jacDiagABInv));
+		deltaImpulse = _mm_sub_ps(deltaImpulse,_mm_mul_ps(deltaVel2Dotn,jacDiagABInv));
+		__m128 sum = _mm_add_ps(appliedImpulse,deltaImpulse);
+		__m128 newImpulse;
+		if (friction)
+		{
+			__m128 totalImpulse = _mm_set_ps(contactRows[row.m_contactRow[3]].m_appliedImpulse[3],contactRows[row.m_contactRow[2]].m_appliedImpulse[2],
+				contactRows[row.m_contactRow[1]].m_appliedImpulse[1],contactRows[row.m_contactRow[0]].m_appliedImpulse[0]);
+			__m128 upperLimit = _mm_mul_ps(_mm_load_ps(row.m_friction),totalImpulse);
+			__m128 lowerLimit = _mm_xor_ps(upperLimit,signMask);
+			__m128 lowerLess = _mm_cmplt_ps(sum,lowerLimit);
+			__m128 upperGreater = _mm_andnot_ps(lowerLess,_mm_cmpgt_ps(sum,upperLimit));
+			deltaImpulse = btSelectLanes(lowerLess,_mm_sub_ps(lowerLimit,appliedImpulse),deltaImpulse);
+			deltaImpulse = btSelectLanes(upperGreater,_mm_sub_ps(upperLimit,appliedImpulse),deltaImpulse);
+			newImpulse = btSelectLanes(lowerLess,lowerLimit,btSelectLanes(upperGreater,upperLimit,sum));
+			//rows of contacts without impulse are skipped
+			__m128 active = _mm_cmpgt_ps(totalImpulse,_mm_setzero_ps());
+			deltaImpulse = _mm_and_ps(active,deltaImpulse);
+			newImpulse = btSelectLanes(active,newImpulse,appliedImpulse);
+		} else
+		{
+			__m128 lowerLimit = _mm_load_ps(row.m_lowerLimit);
+			__m128 lowerLess = _mm_cmplt_ps(sum,lowerLimit);
+			deltaImpulse = btSelectLanes(lowerLess,_mm_sub_ps(lowerLimit,appliedImpulse),deltaImpulse);
+			newImpulse = btSelectLanes(lowerLess,lowerLimit,sum);
+		}
+		_mm_store_ps(row.m_appliedImpulse,newImpulse);
+
+		for (int i=0;i<3;i++)
+		{
+			__m128 normal = _mm_load_ps(row.m_contactNormal[i]);
+			deltaLinearA[i] = _mm_add_ps(deltaLinearA[i],_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(normal,_mm_load_ps(packet.m_invMassA[i])),deltaImpulse),_mm_load_ps(packet.m_linearFactorA[i])));
+			deltaAngularA[i] = _mm_add_ps(deltaAngularA[i],_mm_mul_ps(_mm_load_ps(row.m_angularComponentA[i]),_mm_mul_ps(deltaImpulse,_mm_load_ps(packet.m_angularFactorA[i]))));
+			deltaLinearB[i] = _mm_add_ps(deltaLinearB[i],_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_xor_ps(normal,signMask),_mm_load_ps(packet.m_invMassB[i])),deltaImpulse),_mm_load_ps(packet.m_linearFactorB[i])));
+			deltaAngularB[i] = _mm_add_ps(deltaAngularB[i],_mm_mul_ps(_mm_load_ps(row.m_angularComponentB[i]),_mm_mul_ps(deltaImpulse,_mm_load_ps(packet.m_angularFactorB[i]))));
+		}
+	}
+
+	btStoreLanes(bodiesA,&btSolverBody::m_deltaLinearVelocity,deltaLinearA);
+	btStoreLanes(bodiesA,&btSolverBody::m_deltaAngularVelocity,deltaAngularA);
+	btStoreLanes(bodiesB,&btSolverBody::m_deltaLinearVelocity,deltaLinearB);
+	btStoreLanes(bodiesB,&btSolverBody::m_deltaAngularVelocity,deltaAngularB);
+#else
+	(void)packet;
+	//the lanes are independent, so each lane solves all its rows in turn
+	for (int l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+	{
+		if (!bodiesA[l])
+			continue;
+		btSolverBody& bodyA = *bodiesA[l];
+		btSolverBody& bodyB = *bodiesB[l];
+		for (int r=0;r<numRows;r++)
+		{
+			btConstraintRowLane& row = rows[r];
+			if (row.m_poolIndex[l]<0)
+				continue;
+			btVector3 contactNormal(row.m_contactNormal[0][l],row.m_contactNormal[1][l],row.m_contactNormal[2][l]);
+			btVector3 relpos1CrossNormal(row.m_relpos1CrossNormal[0][l],row.m_relpos1CrossNormal[1][l],row.m_relpos1CrossNormal[2][l]);
+			btVector3 relpos2CrossNormal(row.m_relpos2CrossNormal[0][l],row.m_relpos2CrossNormal[1][l],row.m_relpos2CrossNormal[2][l]);
+			btScalar lowerLimit = row.m_lowerLimit[l];
+			btScalar upperLimit = BT_LARGE_FLOAT;
+			if (friction)
+			{
+				btScalar totalImpulse = contactRows[row.m_contactRow[l]].m_appliedImpulse[l];
+				if (!(totalImpulse>btScalar(0)))
+					continue;
+				lowerLimit = -(row.m_friction[l]*totalImpulse);
+				upperLimit = row.m_friction[l]*totalImpulse;
+			}
+			btScalar appliedImpulse = row.m_appliedImpulse[l];
+			btScalar deltaImpulse = row.m_rhs[l]-appliedImpulse*row.m_cfm[l];
+			const btScalar deltaVel1Dotn = contactNormal.dot(bodyA.internalGetDeltaLinearVelocity()) + relpos1CrossNormal.dot(bodyA.internalGetDeltaAngularVelocity());
+			const btScalar deltaVel2Dotn = -contactNormal.dot(bodyB.internalGetDeltaLinearVelocity()) + relpos2CrossNormal.dot(bodyB.internalGetDeltaAngularVelocity());
+			deltaImpulse -= deltaVel1Dotn*row.m_jacDiagABInv[l];
+			deltaImpulse -= deltaVel2Dotn*row.m_jacDiagABInv[l];
+			const btScalar sum = appliedImpulse + deltaImpulse;
+			if (sum < lowerLimit)
+			{
+				deltaImpulse = lowerLimit-appliedImpulse;
+				row.m_appliedImpulse[l] = lowerLimit;
+			}
+			else if (friction && sum > upperLimit)
+			{
+				deltaImpulse = upperLimit-appliedImpulse;
+				row.m_appliedImpulse[l] = upperLimit;
+			}
+			else
+			{
+				row.m_appliedImpulse[l] = sum;
+			}
+			btVector3 angularComponentA(row.m_angularComponentA[0][l],row.m_angularComponentA[1][l],row.m_angularComponentA[2][l]);
+			btVector3 angularComponentB(row.m_angularComponentB[0][l],row.m_angularComponentB[1][l],row.m_angularComponentB[2][l]);
+			bodyA.internalApplyImpulse(contactNormal*bodyA.internalGetInvMass(),angularComponentA,deltaImpulse);
+			bodyB.internalApplyImpulse(-contactNormal*bodyB.internalGetInvMass(),angularComponentB,deltaImpulse);
+		}
+	}
+#endif //BT_USE_SSE_ROW_LANES
+}
+
+///packConstraintRowLanes copies the contact and friction rows of the independent batches into packets of BT_CONSTRAINT_ROW_LANES manifolds of the same batch
+void	btSequentialImpulseConstraintSolver::packConstraintRowLanes()
+{
+	BT_PROFILE("packConstraintRowLanes");
+	const btAlignedObjectArray<int>& contactOffsets = m_contactBatches.m_groupRowOffsets;
+	const btAlignedObjectArray<int>& frictionOffsets = m_frictionBatches.m_groupRowOffsets;
+	int numBatches = m_contactBatches.m_numIndependentBatches;
+	int b,l;
+
+	m_packets.resizeNoInitialize(0);
+	m_tmpPacketGroups.resizeNoInitialize(0);
+	m_batchPacketOffsets.resizeNoInitialize(numBatches+1);
+	int numContactRows = 0;
+	int numFrictionRows = 0;
+	for (b=0;b<numBatches;b++)
+	{
+		m_batchPacketOffsets[b] = m_packets.size();
+		int lane = BT_CONSTRAINT_ROW_LANES;
+		for (int g=m_contactBatches.m_batchOffsets[b];g<m_contactBatches.m_batchOffsets[b+1];g++)
+		{
+			int numGroupContactRows = contactOffsets[g+1]-contactOffsets[g];
+			if (!numGroupContactRows)
+				continue;
+			if (lane==BT_CONSTRAINT_ROW_LANES)
+			{
+				btConstraintRowPacket& packet = m_packets.expandNonInitializing();
+				for (l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+				{
+					packet.m_solverBodyIdA[l] = -1;
+					packet.m_solverBodyIdB[l] = -1;
+					m_tmpPacketGroups.push_back(-1);
+				}
+				packet.m_numContactRows = 0;
+				packet.m_numFrictionRows = 0;
+				lane = 0;
+			}
+			btConstraintRowPacket& packet = m_packets[m_packets.size()-1];
+			const btSolverConstraint& row = m_tmpSolverContactConstraintPool[contactOffsets[g]];
+			packet.m_solverBodyIdA[lane] = row.m_solverBodyIdA;
+			packet.m_solverBodyIdB[lane] = row.m_solverBodyIdB;
+			packet.m_numContactRows = btMax(packet.m_numContactRows,numGroupContactRows);
+			packet.m_numFrictionRows = btMax(packet.m_numFrictionRows,frictionOffsets[g+1]-frictionOffsets[g]);
+			m_tmpPacketGroups[m_tmpPacketGroups.size()-BT_CONSTRAINT_ROW_LANES+lane] = g;
+			lane++;
+		}
+	}
+	m_batchPacketOffsets[numBatches] = m_packets.size();
+
+	for (int p=0;p<m_packets.size();p++)
+	{
+		btConstraintRowPacket& packet = m_packets[p];
+		for (l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+		{
+			const btSolverBody* bodyA = packet.m_solverBodyIdA[l]>=0 ? &m_tmpSolverBodyPool[packet.m_solverBodyIdA[l]] : 0;
+			const btSolverBody* bodyB = packet.m_solverBodyIdB[l]>=0 ? &m_tmpSolverBodyPool[packet.m_solverBodyIdB[l]] : 0;
+			for (int i=0;i<3;i++)
+			{
+				packet.m_invMassA[i][l] = bodyA ? bodyA->m_invMass[i] : btScalar(0.);
+				packet.m_linearFactorA[i][l] = bodyA ? bodyA->m_linearFactor[i] : btScalar(0.);
+				packet.m_angularFactorA[i][l] = bodyA ? bodyA->m_angularFactor[i] : btScalar(0.);
+				packet.m_invMassB[i][l] = bodyB ? bodyB->m_invMass[i] : btScalar(0.);
+				packet.m_linearFactorB[i][l] = bodyB ? bodyB->m_linearFactor[i] : btScalar(0.);
+				packet.m_angularFactorB[i][l] = bodyB ? bodyB->m_angularFactor[i] : btScalar(0.);
+			}
+		}
+	}
+
+	for (int p=0;p<m_packets.size();p++)
+	{
+		m_packets[p].m_contactRowBegin = numContactRows;
+		m_packets[p].m_frictionRowBegin = numFrictionRows;
+		numContactRows += m_packets[p].m_numContactRows;
+		numFrictionRows += m_packets[p].m_numFrictionRows;
+	}
+	m_contactRowLanes.resizeNoInitialize(numContactRows);
+	m_frictionRowLanes.resizeNoInitialize(numFrictionRows);
+
+	for (int p=0;p<m_packets.size();p++)
+	{
+		const btConstraintRowPacket& packet = m_packets[p];
+		for (l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+		{
+			int g = m_tmpPacketGroups[p*BT_CONSTRAINT_ROW_LANES+l];
+			int r;
+			for (r=0;r<packet.m_numContactRows;r++)
+			{
+				int index = (g>=0 && r<contactOffsets[g+1]-contactOffsets[g]) ? contactOffsets[g]+r : -1;
+				setConstraintRowLane(m_contactRowLanes[packet.m_contactRowBegin+r],l,index>=0 ? &m_tmpSolverContactConstraintPool[index] : 0,index,0);
+			}
+			for (r=0;r<packet.m_numFrictionRows;r++)
+			{
+				int index = (g>=0 && r<frictionOffsets[g+1]-frictionOffsets[g]) ? frictionOffsets[g]+r : -1;
+				const btSolverConstraint* row = index>=0 ? &m_tmpSolverContactFrictionConstraintPool[index] : 0;
+				setConstraintRowLane(m_frictionRowLanes[packet.m_frictionRowBegin+r],l,row,index,row ? row->m_frictionIndex-contactOffsets[g] : 0);
+			}
+		}
+	}
+}
+
+///unpackConstraintRowLanes copies the impulses of the packed rows back to the constraint pools, for the warmstarting in solveGroupCacheFriendlyFinish
+void	btSequentialImpulseConstraintSolver::unpackConstraintRowLanes()
+{
+	int i,l;
+	for (i=0;i<m_contactRowLanes.size();i++)
+	{
+		const btConstraintRowLane& rowLane = m_contactRowLanes[i];
+		for (l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+		{
+			if (rowLane.m_poolIndex[l]>=0)
+				m_tmpSolverContactConstraintPool[rowLane.m_poolIndex[l]].m_appliedImpulse = rowLane.m_appliedImpulse[l];
+		}
+	}
+	for (i=0;i<m_frictionRowLanes.size();i++)
+	{
+		const btConstraintRowLane& rowLane = m_frictionRowLanes[i];
+		for (l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+		{
+			if (rowLane.m_poolIndex[l]>=0)
+				m_tmpSolverContactFrictionConstraintPool[rowLane.m_poolIndex[l]].m_appliedImpulse = rowLane.m_appliedImpulse[l];
+		}
+	}
+	m_packets.resizeNoInitialize(0);
+	m_contactRowLanes.resizeNoInitialize(0);
+	m_frictionRowLanes.resizeNoInitialize(0);
+}
+
+void	btSequentialImpulseConstraintSolver::solveConstraintRowPackets(int rowType, int packetBegin, int packetEnd)
+{
+	btSolverBody* bodiesA[BT_CONSTRAINT_ROW_LANES];
+	btSolverBody* bodiesB[BT_CONSTRAINT_ROW_LANES];
+	for (int p=packetBegin;p<packetEnd;p++)
+	{
+		const btConstraintRowPacket& packet = m_packets[p];
+		for (int l=0;l<BT_CONSTRAINT_ROW_LANES;l++)
+		{
+			bodiesA[l] = packet.m_solverBodyIdA[l]>=0 ? &m_tmpSolverBodyPool[packet.m_solverBodyIdA[l]] : 0;
+			bodiesB[l] = packet.m_solverBodyIdB[l]>=0 ? &m_tmpSolverBodyPool[packet.m_solverBodyIdB[l]] : 0;
+		}
+		btConstraintRowLane* contactRows = &m_contactRowLanes[packet.m_contactRowBegin];
+		if (rowType==BT_FRICTION_ROWS)
+		{
+			if (packet.m_numFrictionRows)
+				resolveConstraintRowLanes(packet,bodiesA,bodiesB,&m_frictionRowLanes[packet.m_frictionRowBegin],packet.m_numFrictionRows,contactRows,true);
+		} else
+		{
+			resolveConstraintRowLanes(packet,bodiesA,bodiesB,contactRows,packet.m_numContactRows,contactRows,false);
+		}
+	}
+}
+
+void	btSequentialImpulseConstraintSolver::solveConstraintRowBatches(btConstraintArray& constraintPool, const btConstraintRowBatches& batches, int rowType, int iteration)
+{
+	///a batch needs at least this many groups to be spread over threads
+	const int grainSize = 32;
+
+	btSolveRowGroupsLoop loop;
+	loop.m_solver = this;
+	loop.m_constraintPool = &constraintPool;
+	loop.m_batches = &batches;
+	loop.m_rowType = rowType;
+	loop.m_iteration = iteration;
+
+	///the contact and friction rows of the independent batches are packed into packets of BT_CONSTRAINT_ROW_LANES manifolds
+	const int packetGrainSize = grainSize/BT_CONSTRAINT_ROW_LANES;
+	const bool packed = m_useConstraintRowLanes && (rowType==BT_CONTACT_ROWS || rowType==BT_FRICTION_ROWS);
+	btSolveRowPacketsLoop packetLoop;
+	packetLoop.m_solver = this;
+	packetLoop.m_rowType = rowType;
+
+	int numBatches = batches.m_batchOffsets.size()-1;
+	for (int b=0;b<numBatches;b++)
+	{
+		int begin = batches.m_batchOffsets[b];
+		int end = batches.m_batchOffsets[b+1];
+		if (packed && b < batches.m_numIndependentBatches)
+		{
+			int packetBegin = m_batchPacketOffsets[b];
+			int packetEnd = m_batchPacketOffsets[b+1];
+			if ((packetEnd-packetBegin) > packetGrainSize)
+			{
+				btParallelFor(packetBegin,packetEnd,packetGrainSize,packetLoop);
+			} else
+			{
+				solveConstraintRowPackets(rowType,packetBegin,packetEnd);
+			}
+		} else if (b < batches.m_numIndependentBatches && (end-begin) > grainSize)
+		{
+			btParallelFor(begin,end,grainSize,loop);
+		} else
+		{
+			solveConstraintRowGroups(constraintPool,batches,rowType,iteration,begin,end);
+		}
+	}
+}
+
+///solveSingleIterationBatched solves the joint, contact and friction rows batch by batch. The rows are not randomized or interleaved.
+btScalar btSequentialImpulseConstraintSolver::solveSingleIterationBatched(int iteration, btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal)
+{
+	solveConstraintRowBatches(m_tmpSolverNonContactConstraintPool,m_nonContactBatches,BT_NON_CONTACT_ROWS,iteration);
+
+	if (iteration< infoGlobal.m_numIterations)
+	{
+		for (int j=0;j<numConstraints;j++)
+		{
+			constraints[j]->solveConstraintObsolete(constraints[j]->getRigidBodyA(),constraints[j]->getRigidBodyB(),infoGlobal.m_timeStep);
+		}
+
+		solveConstraintRowBatches(m_tmpSolverContactConstraintPool,m_contactBatches,BT_CONTACT_ROWS,iteration);
+		solveConstraintRowBatches(m_tmpSolverContactFrictionConstraintPool,m_frictionBatches,BT_FRICTION_ROWS,iteration);
+	}
+	return 0.f;
+}
+
 btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration, btCollisionObject** /*bodies */,int /*numBodies*/,btPersistentManifold** /*manifoldPtr*/, int /*numManifolds*/,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal,btIDebugDraw* /*debugDrawer*/,btStackAlloc* /*stackAlloc*/)
 {
 
+	if (infoGlobal.m_solverMode & SOLVER_BATCHED)
+	{
+		return solveSingleIterationBatched(iteration,constraints,numConstraints,infoGlobal);
+	}
+
 	int numNonContactPool = m_tmpSolverNonContactConstraintPool.size();
 	int numConstraintPool = m_tmpSolverContactConstraintPool.size();
 	int numFrictionPool = m_tmpSolverContactFrictionConstraintPool.size();
@@ -1216,7 +1809,25 @@ void btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySplitImpulseIte
 	int iteration;
 	if (infoGlobal.m_splitImpulse)
 	{
-		if (infoGlobal.m_solverMode & SOLVER_SIMD)
+		///the penetration rows don't change during the iterations, so they are counted once here instead of in the row kernels,
+		///which can run on several threads (batched mode, or one solver per task in btDiscreteDynamicsWorld)
+		int numRecoveries = 0;
+		for (int j=0;j<m_tmpSolverContactConstraintPool.size();j++)
+		{
+			if (m_tmpSolverContactConstraintPool[j].m_rhsPenetration)
+				numRecoveries++;
+		}
+		if (numRecoveries)
+			btAtomicAdd((volatile int*)&gNumSplitImpulseRecoveries,numRecoveries*infoGlobal.m_numIterations);
+
+		if (infoGlobal.m_solverMode & SOLVER_BATCHED)
+		{
+			for ( iteration = 0;iteration<infoGlobal.m_numIterations;iteration++)
+			{
+				solveConstraintRowBatches(m_tmpSolverContactConstraintPool,m_contactBatches,BT_SPLIT_IMPULSE_ROWS,iteration);
+			}
+		}
+		else if (infoGlobal.m_solverMode & SOLVER_SIMD)
 		{
 			for ( iteration = 0;iteration<infoGlobal.m_numIterations;iteration++)
 			{
@@ -1266,6 +1877,9 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(
 		{			
 			solveSingleIteration(iteration, bodies ,numBodies,manifoldPtr, numManifolds,constraints,numConstraints,infoGlobal,debugDrawer,stackAlloc);
 		}
+
+		if ((infoGlobal.m_solverMode & SOLVER_BATCHED) && m_useConstraintRowLanes)
+			unpackConstraintRowLanes();
 		
 	}
 	return 0.f;
@@ -1370,4 +1984,12 @@ void	btSequentialImpulseConstraintSolver::reset()
 	m_btSeed2 = 0;
 }
 
+btConstraintSolver*	btSequentialImpulseConstraintSolver::createTaskSolver() const
+{
+	void* mem = btAlignedAlloc(sizeof(btSequentialImpulseConstraintSolver),16);
+	btSequentialImpulseConstraintSolver* solver = new (mem) btSequentialImpulseConstraintSolver;
+	copySolverSettings(*solver);
+	return solver;
+}
+
 
@@ -28,10 +28,16 @@ class btCollisionObject;
 #include "BulletCollision/NarrowPhaseCollision/btManifoldPoint.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
 
+///the number of manifolds whose contact and friction rows are solved side by side by the SoA row kernel of SOLVER_BATCHED
+#define BT_CONSTRAINT_ROW_LANES 4
+
 ///The btSequentialImpulseConstraintSolver is a fast SIMD implementation of the Projected Gauss Seidel (iterative LCP) method.
 ATTRIBUTE_ALIGNED16(class) btSequentialImpulseConstraintSolver : public btConstraintSolver
 {
 protected:
+	friend struct btSolveRowGroupsLoop;
+	friend struct btSolveRowPacketsLoop;
+
 	btAlignedObjectArray<btSolverBody>      m_tmpSolverBodyPool;
 	btConstraintArray			m_tmpSolverContactConstraintPool;
 	btConstraintArray			m_tmpSolverNonContactConstraintPool;
@@ -42,6 +48,75 @@ protected:
 	btAlignedObjectArray<btTypedConstraint::btConstraintInfo1> m_tmpConstraintSizesPool;
 	int							m_maxOverrideNumSolverIterations;
 
+	///btConstraintRowBatches is used by SOLVER_BATCHED. The rows of a manifold or joint form a group, group g holds the rows m_groupRowOffsets[g]..m_groupRowOffsets[g+1]-1.
+	///Batch i holds the groups m_batchOffsets[i]..m_batchOffsets[i+1]-1. The groups of the first m_numIndependentBatches batches don't share a dynamic body,
+	///the groups of the remaining batch are solved in order.
+	struct btConstraintRowBatches
+	{
+		btAlignedObjectArray<int>	m_groupRowOffsets;
+		btAlignedObjectArray<int>	m_batchOffsets;
+		int							m_numIndependentBatches;
+	};
+
+	btConstraintRowBatches		m_nonContactBatches;
+	btConstraintRowBatches		m_contactBatches;
+	btConstraintRowBatches		m_frictionBatches;
+	btAlignedObjectArray<int>	m_tmpGroupBodyIds;
+	btAlignedObjectArray<int>	m_tmpGroupOrder;
+	btAlignedObjectArray<int>	m_tmpGroupBatchIds;
+	btAlignedObjectArray<unsigned int>	m_tmpBodyBatchMasks;
+
+	///btConstraintRowLane holds row r of the BT_CONSTRAINT_ROW_LANES manifolds of a packet in SoA layout. Lanes of manifolds with fewer rows are
+	///padded with zero rows, which give a zero impulse. m_poolIndex is the index of the row in the constraint pool (-1 for padding), m_contactRow
+	///is the contact row of the packet whose impulse limits a friction row.
+	ATTRIBUTE_ALIGNED16(struct) btConstraintRowLane
+	{
+		btScalar	m_contactNormal[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_relpos1CrossNormal[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_relpos2CrossNormal[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_angularComponentA[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_angularComponentB[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_rhs[BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_cfm[BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_jacDiagABInv[BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_lowerLimit[BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_friction[BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_appliedImpulse[BT_CONSTRAINT_ROW_LANES];
+		int			m_poolIndex[BT_CONSTRAINT_ROW_LANES];
+		int			m_contactRow[BT_CONSTRAINT_ROW_LANES];
+	};
+
+	///a packet holds up to BT_CONSTRAINT_ROW_LANES manifolds of an independent batch, which don't share a dynamic body. Its contact rows are
+	///m_contactRowLanes[m_contactRowBegin..m_contactRowBegin+m_numContactRows-1], likewise for the friction rows. Empty lanes have body id -1.
+	///The inverse masses and factors of the bodies don't change during the iterations and are packed once.
+	ATTRIBUTE_ALIGNED16(struct) btConstraintRowPacket
+	{
+		btScalar	m_invMassA[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_linearFactorA[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_angularFactorA[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_invMassB[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_linearFactorB[3][BT_CONSTRAINT_ROW_LANES];
+		btScalar	m_angularFactorB[3][BT_CONSTRAINT_ROW_LANES];
+		int		m_solverBodyIdA[BT_CONSTRAINT_ROW_LANES];
+		int		m_solverBodyIdB[BT_CONSTRAINT_ROW_LANES];
+		int		m_contactRowBegin;
+		int		m_numContactRows;
+		int		m_frictionRowBegin;
+		int		m_numFrictionRows;
+	};
+
+	///the contact and friction rows of the independent batches of m_contactBatches, packed by packConstraintRowLanes. The packets of independent
+	///batch b are m_packets[m_batchPacketOffsets[b]..m_batchPacketOffsets[b+1]-1].
+	btAlignedObjectArray<btConstraintRowPacket>	m_packets;
+	btAlignedObjectArray<int>	m_batchPacketOffsets;
+	btAlignedObjectArray<btConstraintRowLane>	m_contactRowLanes;
+	btAlignedObjectArray<btConstraintRowLane>	m_frictionRowLanes;
+	btAlignedObjectArray<int>	m_tmpPacketGroups;
+
+	///m_useConstraintRowLanes selects the SoA row kernel for the contact and friction rows of the independent batches of SOLVER_BATCHED (default).
+	///The scalar row kernels give the same impulses, it is only cleared to compare them.
+	bool	m_useConstraintRowLanes;
+
 	void setupFrictionConstraint(	btSolverConstraint& solverConstraint, const btVector3& normalAxis,int solverBodyIdA,int  solverBodyIdB,
 									btManifoldPoint& cp,const btVector3& rel_pos1,const btVector3& rel_pos2,
 									btCollisionObject* colObj0,btCollisionObject* colObj1, btScalar relaxation, 
@@ -85,6 +160,24 @@ protected:
 	
 	void	resolveSingleConstraintRowLowerLimitSIMD(btSolverBody& bodyA,btSolverBody& bodyB,const btSolverConstraint& contactConstraint);
 		
+	void	batchConstraintGroups(btConstraintRowBatches& batches);
+
+	void	solveConstraintRowBatches(btConstraintArray& constraintPool, const btConstraintRowBatches& batches, int rowType, int iteration);
+
+	void	solveConstraintRowGroups(btConstraintArray& constraintPool, const btConstraintRowBatches& batches, int rowType, int iteration, int groupBegin, int groupEnd);
+
+	static void	setConstraintRowLane(btConstraintRowLane& rowLane, int lane, const btSolverConstraint* row, int poolIndex, int contactRow);
+
+	static void	resolveConstraintRowLanes(const btConstraintRowPacket& packet, btSolverBody* const* bodiesA, btSolverBody* const* bodiesB, btConstraintRowLane* rows, int numRows, const btConstraintRowLane* contactRows, bool friction);
+
+	void	packConstraintRowLanes();
+
+	void	unpackConstraintRowLanes();
+
+	void	solveConstraintRowPackets(int rowType, int packetBegin, int packetEnd);
+
+	btScalar	solveSingleIterationBatched(int iteration, btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& infoGlobal);
+
 protected:
 	
 	
@@ -109,6 +202,18 @@ public:
 	
 	///clear internal cached data and reset random seed
 	virtual	void	reset();
+
+	///createTaskSolver returns a btSequentialImpulseConstraintSolver with the same settings (see copySolverSettings).
+	///It can't know the type of a derived solver: derived solvers must override it, returning a solver of their own type
+	///that got the settings through copySolverSettings, or return 0 to solve all islands on a single task.
+	virtual btConstraintSolver*	createTaskSolver() const;
+
+	///copySolverSettings copies the state of this solver that carries over between solves (the random seed and the row kernel selection) to solver
+	void	copySolverSettings(btSequentialImpulseConstraintSolver& solver) const
+	{
+		solver.m_btSeed2 = m_btSeed2;
+		solver.m_useConstraintRowLanes = m_useConstraintRowLanes;
+	}
 	
 	unsigned long btRand2();
 
@@ -27,6 +27,7 @@ subject to the following restrictions:
 
 //rigidbody & constraints
 #include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "BulletDynamics/Dynamics/btRigidBodyStateArray.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 #include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
@@ -47,6 +48,8 @@ subject to the following restrictions:
 #include "LinearMath/btMotionState.h"
 
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btStackAlloc.h"
+#include "LinearMath/btThreads.h"
 
 #if 0
 btAlignedObjectArray<btVector3> debugContacts;
@@ -201,6 +204,265 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 
 
 
+///ParallelSolverIslandCallback gathers the islands into batches (in the same way as InplaceSolverIslandCallback) and solves
+///them afterwards using btParallelFor. Each batch is assigned to one solver task, and the assignment only depends on the
+///batch sizes and the number of tasks, so the result doesn't depend on the thread that runs a task.
+struct ParallelSolverIslandCallback : public btSimulationIslandManager::IslandCallback
+{
+	struct btIslandBatch
+	{
+		int	m_bodyOffset;
+		int	m_numBodies;
+		int	m_manifoldOffset;
+		int	m_numManifolds;
+		int	m_constraintOffset;
+		int	m_numConstraints;
+		int	m_cost;
+		int	m_taskIndex;
+	};
+
+	class btBatchCostSortPredicate
+	{
+		const btAlignedObjectArray<btIslandBatch>& m_batches;
+	public:
+		btBatchCostSortPredicate(const btAlignedObjectArray<btIslandBatch>& batches)
+			:m_batches(batches)
+		{
+		}
+		bool operator() ( int lhs, int rhs ) const
+		{
+			//largest batches first, ties are broken by batch index to keep the order deterministic
+			if (m_batches[lhs].m_cost != m_batches[rhs].m_cost)
+				return m_batches[lhs].m_cost > m_batches[rhs].m_cost;
+			return lhs < rhs;
+		}
+	};
+
+	btContactSolverInfo*	m_solverInfo;
+	btTypedConstraint**		m_sortedConstraints;
+	int						m_numConstraints;
+	int						m_constraintCursor;
+	btIDebugDraw*			m_debugDrawer;
+	btDispatcher*			m_dispatcher;
+	btConstraintSolver**	m_solvers;
+	btStackAlloc**			m_stackAllocs;
+	int						m_numTasks;
+
+	btAlignedObjectArray<btCollisionObject*> m_bodies;
+	btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btIslandBatch> m_batches;
+	btIslandBatch	m_currentBatch;
+
+	btAlignedObjectArray<int>	m_sortedBatches;
+	btAlignedObjectArray<int>	m_taskLoad;
+	btAlignedObjectArray<int>	m_taskBatchOffsets;
+	btAlignedObjectArray<int>	m_taskBatches;
+
+	struct SolveTasksLoop : public btIParallelForBody
+	{
+		ParallelSolverIslandCallback*	m_callback;
+
+		SolveTasksLoop(ParallelSolverIslandCallback* callback)
+			:m_callback(callback)
+		{
+		}
+		virtual void	forLoop(int iBegin, int iEnd) const
+		{
+			BT_PROFILE("solveIslandTasks");
+			for (int taskIndex=iBegin;taskIndex<iEnd;taskIndex++)
+			{
+				m_callback->solveTask(taskIndex);
+			}
+		}
+	};
+
+	ParallelSolverIslandCallback(btDispatcher* dispatcher)
+		:m_solverInfo(NULL),
+		m_sortedConstraints(NULL),
+		m_numConstraints(0),
+		m_constraintCursor(0),
+		m_debugDrawer(NULL),
+		m_dispatcher(dispatcher),
+		m_solvers(NULL),
+		m_stackAllocs(NULL),
+		m_numTasks(0)
+	{
+	}
+
+	ParallelSolverIslandCallback& operator=(ParallelSolverIslandCallback& other)
+	{
+		btAssert(0);
+		(void)other;
+		return *this;
+	}
+
+	void	setup ( btContactSolverInfo* solverInfo, btTypedConstraint** sortedConstraints, int numConstraints, btIDebugDraw* debugDrawer, btConstraintSolver** solvers, btStackAlloc** stackAllocs, int numTasks)
+	{
+		btAssert(solverInfo);
+		m_solverInfo = solverInfo;
+		m_sortedConstraints = sortedConstraints;
+		m_numConstraints = numConstraints;
+		m_constraintCursor = 0;
+		m_debugDrawer = debugDrawer;
+		m_solvers = solvers;
+		m_stackAllocs = stackAllocs;
+		m_numTasks = numTasks;
+		m_bodies.resize(0);
+		m_manifolds.resize(0);
+		m_constraints.resize(0);
+		m_batches.resize(0);
+		beginBatch();
+	}
+
+	void	beginBatch()
+	{
+		m_currentBatch.m_bodyOffset = m_bodies.size();
+		m_currentBatch.m_numBodies = 0;
+		m_currentBatch.m_manifoldOffset = m_manifolds.size();
+		m_currentBatch.m_numManifolds = 0;
+		m_currentBatch.m_constraintOffset = m_constraints.size();
+		m_currentBatch.m_numConstraints = 0;
+		m_currentBatch.m_cost = 0;
+		m_currentBatch.m_taskIndex = 0;
+	}
+
+	void	endBatch()
+	{
+		if (m_currentBatch.m_numBodies || m_currentBatch.m_numManifolds || m_currentBatch.m_numConstraints)
+		{
+			m_currentBatch.m_cost = m_currentBatch.m_numBodies + m_currentBatch.m_numManifolds + m_currentBatch.m_numConstraints;
+			m_batches.push_back(m_currentBatch);
+		}
+		beginBatch();
+	}
+
+	virtual	void	processIsland(btCollisionObject** bodies,int numBodies,btPersistentManifold**	manifolds,int numManifolds, int islandId)
+	{
+		int i;
+		int numCurConstraints = 0;
+
+		if (islandId<0)
+		{
+			///we don't split islands, so all constraints/contact manifolds/bodies are solved as a single batch
+			for (i=0;i<m_numConstraints;i++)
+				m_constraints.push_back(m_sortedConstraints[i]);
+			numCurConstraints = m_numConstraints;
+		} else
+		{
+			//islands are reported in increasing islandId order, just like the sorted constraints
+			while (m_constraintCursor<m_numConstraints && btGetConstraintIslandId(m_sortedConstraints[m_constraintCursor]) < islandId)
+			{
+				m_constraintCursor++;
+			}
+			while (m_constraintCursor<m_numConstraints && btGetConstraintIslandId(m_sortedConstraints[m_constraintCursor]) == islandId)
+			{
+				m_constraints.push_back(m_sortedConstraints[m_constraintCursor++]);
+				numCurConstraints++;
+			}
+		}
+
+		for (i=0;i<numBodies;i++)
+		{
+			//static and kinematic objects don't get a solver body, leaving them out avoids sharing their companion id between tasks
+			if (!bodies[i]->isStaticOrKinematicObject())
+			{
+				m_bodies.push_back(bodies[i]);
+				m_currentBatch.m_numBodies++;
+			}
+		}
+		for (i=0;i<numManifolds;i++)
+			m_manifolds.push_back(manifolds[i]);
+		m_currentBatch.m_numManifolds += numManifolds;
+		m_currentBatch.m_numConstraints += numCurConstraints;
+
+		if (islandId<0 || m_solverInfo->m_minimumSolverBatchSize<=1 ||
+			(m_currentBatch.m_numConstraints+m_currentBatch.m_numManifolds)>m_solverInfo->m_minimumSolverBatchSize)
+		{
+			endBatch();
+		}
+	}
+
+	void	solveBatch(const btIslandBatch& batch, int taskIndex)
+	{
+		btCollisionObject** bodies = batch.m_numBodies? &m_bodies[batch.m_bodyOffset] : 0;
+		btPersistentManifold** manifolds = batch.m_numManifolds? &m_manifolds[batch.m_manifoldOffset] : 0;
+		btTypedConstraint** constraints = batch.m_numConstraints? &m_constraints[batch.m_constraintOffset] : 0;
+
+		m_solvers[taskIndex]->solveGroup(bodies,batch.m_numBodies,manifolds,batch.m_numManifolds,constraints,batch.m_numConstraints,*m_solverInfo,m_debugDrawer,m_stackAllocs[taskIndex],m_dispatcher);
+	}
+
+	void	solveTask(int taskIndex)
+	{
+		for (int i=m_taskBatchOffsets[taskIndex];i<m_taskBatchOffsets[taskIndex+1];i++)
+		{
+			solveBatch(m_batches[m_taskBatches[i]],taskIndex);
+		}
+	}
+
+	void	processConstraints()
+	{
+		endBatch();
+
+		int numBatches = m_batches.size();
+		if (!numBatches)
+			return;
+
+		int i;
+		int numTasks = btMin(m_numTasks,numBatches);
+
+		if (numTasks<=1)
+		{
+			for (i=0;i<numBatches;i++)
+				solveBatch(m_batches[i],0);
+			return;
+		}
+
+		//assign the largest batches first, each to the task with the least work so far
+		m_sortedBatches.resize(numBatches);
+		for (i=0;i<numBatches;i++)
+			m_sortedBatches[i] = i;
+		m_sortedBatches.quickSort(btBatchCostSortPredicate(m_batches));
+
+		m_taskLoad.resize(numTasks);
+		for (i=0;i<numTasks;i++)
+			m_taskLoad[i] = 0;
+
+		for (i=0;i<numBatches;i++)
+		{
+			btIslandBatch& batch = m_batches[m_sortedBatches[i]];
+			int bestTask = 0;
+			for (int t=1;t<numTasks;t++)
+			{
+				if (m_taskLoad[t] < m_taskLoad[bestTask])
+					bestTask = t;
+			}
+			batch.m_taskIndex = bestTask;
+			m_taskLoad[bestTask] += batch.m_cost;
+		}
+
+		//each task solves its batches in island order
+		m_taskBatchOffsets.resize(numTasks+1);
+		for (i=0;i<=numTasks;i++)
+			m_taskBatchOffsets[i] = 0;
+		for (i=0;i<numBatches;i++)
+			m_taskBatchOffsets[m_batches[i].m_taskIndex+1]++;
+		for (i=0;i<numTasks;i++)
+			m_taskBatchOffsets[i+1] += m_taskBatchOffsets[i];
+
+		m_taskBatches.resize(numBatches);
+		m_taskLoad.resize(numTasks);
+		for (i=0;i<numTasks;i++)
+			m_taskLoad[i] = m_taskBatchOffsets[i];
+		for (i=0;i<numBatches;i++)
+			m_taskBatches[m_taskLoad[m_batches[i].m_taskIndex]++] = i;
+
+		SolveTasksLoop solveLoop(this);
+		btParallelFor(0,numTasks,1,solveLoop);
+	}
+
+};
+
 btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration)
 :btDynamicsWorld(dispatcher,pairCache,collisionConfiguration),
 m_constraintSolver(constraintSolver),
@@ -209,7 +471,10 @@ m_localTime(0),
 m_synchronizeAllMotionStates(false),
 m_profileTimings(0),
 m_sortedConstraints	(),
-m_solverIslandCallback ( NULL )
+m_solverIslandCallback ( NULL ),
+m_parallelSolverIslandCallback ( NULL ),
+m_numTasks(1),
+m_rigidBodyStateArray(NULL)
 {
 	if (!m_constraintSolver)
 	{
@@ -232,11 +497,17 @@ m_solverIslandCallback ( NULL )
 		void* mem = btAlignedAlloc(sizeof(InplaceSolverIslandCallback),16);
 		m_solverIslandCallback = new (mem) InplaceSolverIslandCallback (m_constraintSolver, m_stackAlloc, dispatcher);
 	}
+
+	{
+		void* mem = btAlignedAlloc(sizeof(ParallelSolverIslandCallback),16);
+		m_parallelSolverIslandCallback = new (mem) ParallelSolverIslandCallback (dispatcher);
+	}
 }
 
 
 btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 {
+	m_islandManager->disablePersistentIslands();
 	//only delete it when we created it
 	if (m_ownsIslandManager)
 	{
@@ -248,6 +519,13 @@ btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 		m_solverIslandCallback->~InplaceSolverIslandCallback();
 		btAlignedFree(m_solverIslandCallback);
 	}
+	setNumTasks(1);
+	setUseRigidBodyStateArray(false);
+	if (m_parallelSolverIslandCallback)
+	{
+		m_parallelSolverIslandCallback->~ParallelSolverIslandCallback();
+		btAlignedFree(m_parallelSolverIslandCallback);
+	}
 	if (m_ownsConstraintSolver)
 	{
 
@@ -319,6 +597,11 @@ void	btDiscreteDynamicsWorld::debugDrawWorld()
 
 void	btDiscreteDynamicsWorld::clearForces()
 {
+	if (m_rigidBodyStateArray)
+	{
+		m_rigidBodyStateArray->clearForces();
+		return;
+	}
 	///@todo: iterate over awake simulation islands!
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
@@ -332,6 +615,11 @@ void	btDiscreteDynamicsWorld::clearForces()
 ///apply gravity, call this once per timestep
 void	btDiscreteDynamicsWorld::applyGravity()
 {
+	if (m_rigidBodyStateArray)
+	{
+		m_rigidBodyStateArray->applyGravity();
+		return;
+	}
 	///@todo: iterate over awake simulation islands!
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
@@ -530,6 +818,7 @@ btVector3 btDiscreteDynamicsWorld::getGravity () const
 void	btDiscreteDynamicsWorld::addCollisionObject(btCollisionObject* collisionObject,short int collisionFilterGroup,short int collisionFilterMask)
 {
 	btCollisionWorld::addCollisionObject(collisionObject,collisionFilterGroup,collisionFilterMask);
+	m_islandManager->addCollisionObject(collisionObject);
 }
 
 void	btDiscreteDynamicsWorld::removeCollisionObject(btCollisionObject* collisionObject)
@@ -538,15 +827,38 @@ void	btDiscreteDynamicsWorld::removeCollisionObject(btCollisionObject* collision
 	if (body)
 		removeRigidBody(body);
 	else
+	{
+		m_islandManager->removeCollisionObject(collisionObject);
 		btCollisionWorld::removeCollisionObject(collisionObject);
+	}
 }
 
 void	btDiscreteDynamicsWorld::removeRigidBody(btRigidBody* body)
 {
+	if (m_rigidBodyStateArray && m_rigidBodyStateArray->hasBody(body))
+		m_rigidBodyStateArray->removeBody(body);
 	m_nonStaticRigidBodies.remove(body);
+	m_islandManager->removeCollisionObject(body);
 	btCollisionWorld::removeCollisionObject(body);
 }
 
+void	btDiscreteDynamicsWorld::setPersistentIslands(bool persistentIslands)
+{
+	if (persistentIslands)
+	{
+		if (!m_islandManager->hasPersistentIslands())
+			m_islandManager->enablePersistentIslands(this);
+	} else
+	{
+		m_islandManager->disablePersistentIslands();
+	}
+}
+
+bool	btDiscreteDynamicsWorld::getPersistentIslands() const
+{
+	return m_islandManager->hasPersistentIslands();
+}
+
 
 void	btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body)
 {
@@ -560,6 +872,8 @@ void	btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body)
 		if (!body->isStaticObject())
 		{
 			m_nonStaticRigidBodies.push_back(body);
+			if (m_rigidBodyStateArray)
+				m_rigidBodyStateArray->addBody(body);
 		} else
 		{
 			body->setActivationState(ISLAND_SLEEPING);
@@ -585,6 +899,8 @@ void	btDiscreteDynamicsWorld::addRigidBody(btRigidBody* body, short group, short
 		if (!body->isStaticObject())
 		{
 			m_nonStaticRigidBodies.push_back(body);
+			if (m_rigidBodyStateArray)
+				m_rigidBodyStateArray->addBody(body);
 		}
 		 else
 		{
@@ -609,6 +925,11 @@ void	btDiscreteDynamicsWorld::updateActions(btScalar timeStep)
 void	btDiscreteDynamicsWorld::updateActivationState(btScalar timeStep)
 {
 	BT_PROFILE("updateActivationState");
+	if (m_rigidBodyStateArray)
+	{
+		m_rigidBodyStateArray->updateActivationState(timeStep);
+		return;
+	}
 
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
@@ -712,6 +1033,38 @@ void	btDiscreteDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 	
 	btTypedConstraint** constraintsPtr = getNumConstraints() ? &m_sortedConstraints[0] : 0;
 	
+	///there are fewer solver tasks than m_numTasks when the constraint solver can't be duplicated
+	int numSolverTasks = 1 + m_taskConstraintSolvers.size();
+	if (numSolverTasks>1)
+	{
+		btConstraintSolver* solvers[BT_MAX_THREAD_COUNT];
+		btStackAlloc* stackAllocs[BT_MAX_THREAD_COUNT];
+		solvers[0] = m_constraintSolver;
+		stackAllocs[0] = m_stackAlloc;
+		for (i=1;i<numSolverTasks;i++)
+		{
+			solvers[i] = m_taskConstraintSolvers[i-1];
+			stackAllocs[i] = m_taskStackAllocs[i-1];
+		}
+
+		m_parallelSolverIslandCallback->setup(&solverInfo,constraintsPtr,m_sortedConstraints.size(),getDebugDrawer(),solvers,stackAllocs,numSolverTasks);
+		for (i=0;i<numSolverTasks;i++)
+		{
+			solvers[i]->prepareSolve(getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds());
+		}
+
+		/// gather the islands, and solve them in parallel afterwards
+		m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(),getCollisionWorld(),m_parallelSolverIslandCallback);
+
+		m_parallelSolverIslandCallback->processConstraints();
+
+		for (i=0;i<numSolverTasks;i++)
+		{
+			solvers[i]->allSolved(solverInfo, m_debugDrawer, stackAllocs[i]);
+		}
+		return;
+	}
+
 	m_solverIslandCallback->setup(&solverInfo,constraintsPtr,m_sortedConstraints.size(),getDebugDrawer());
 	m_constraintSolver->prepareSolve(getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds());
 	
@@ -738,8 +1091,8 @@ void	btDiscreteDynamicsWorld::calculateSimulationIslands()
 			btTypedConstraint* constraint = m_constraints[i];
 			if (constraint->isEnabled())
 			{
-				const btRigidBody* colObj0 = &constraint->getRigidBodyA();
-				const btRigidBody* colObj1 = &constraint->getRigidBodyB();
+				btRigidBody* colObj0 = &constraint->getRigidBodyA();
+				btRigidBody* colObj1 = &constraint->getRigidBodyB();
 
 				if (((colObj0) && (!(colObj0)->isStaticOrKinematicObject())) &&
 					((colObj1) && (!(colObj1)->isStaticOrKinematicObject())))
@@ -747,8 +1100,7 @@ void	btDiscreteDynamicsWorld::calculateSimulationIslands()
 					if (colObj0->isActive() || colObj1->isActive())
 					{
 
-						getSimulationIslandManager()->getUnionFind().unite((colObj0)->getIslandTag(),
-							(colObj1)->getIslandTag());
+						getSimulationIslandManager()->uniteIslands(colObj0,colObj1);
 					}
 				}
 			}
@@ -850,9 +1202,201 @@ public:
 ///internal debugging variable. this value shouldn't be too high
 int gNumClampedCcdMotions=0;
 
+///number of bodies per task of the packed integration passes
+#define BT_RIGID_BODY_STATE_GRAIN_SIZE 256
+
+///integrateTransformContinuous clamps the motion of a fast moving body at the first hit of a swept sphere.
+///It returns true if the motion was clamped, in that case the body already proceeded to the clamped transform
+bool	btDiscreteDynamicsWorld::integrateTransformContinuous(btRigidBody* body,btScalar timeStep,const btTransform& bodyPredictedTrans)
+{
+	BT_PROFILE("CCD motion clamping");
+	if (body->getCollisionShape()->isConvex())
+	{
+		gNumClampedCcdMotions++;
+#ifdef USE_STATIC_ONLY
+		class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
+		{
+		public:
+
+			StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) : 
+			  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
+			{
+			}
+
+		  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+			{
+				btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
+				if (!otherObj->isStaticOrKinematicObject())
+					return false;
+				return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
+			}
+		};
+
+		StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),bodyPredictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+#else
+		btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),bodyPredictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+#endif
+		//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+		btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+		sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
+
+		sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+		sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
+		btTransform modifiedPredictedTrans = bodyPredictedTrans;
+		modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
+
+		convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
+		if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+		{
+			
+			//printf("clamped integration to hit fraction = %f\n",fraction);
+			body->setHitFraction(sweepResults.m_closestHitFraction);
+			btTransform predictedTrans;
+			body->predictIntegratedTransform(timeStep*body->getHitFraction(), predictedTrans);
+			body->setHitFraction(0.f);
+			body->proceedToTransform( predictedTrans);
+
+#if 0
+			btVector3 linVel = body->getLinearVelocity();
+
+			btScalar maxSpeed = body->getCcdMotionThreshold()/getSolverInfo().m_timeStep;
+			btScalar maxSpeedSqr = maxSpeed*maxSpeed;
+			if (linVel.length2()>maxSpeedSqr)
+			{
+				linVel.normalize();
+				linVel*= maxSpeed;
+				body->setLinearVelocity(linVel);
+				btScalar ms2 = body->getLinearVelocity().length2();
+				body->predictIntegratedTransform(timeStep, predictedTrans);
+
+				btScalar sm2 = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+				btScalar smt = body->getCcdSquareMotionThreshold();
+				printf("sm2=%f\n",sm2);
+			}
+#else
+			//response  between two dynamic objects without friction, assuming 0 penetration depth
+			btScalar appliedImpulse = 0.f;
+			btScalar depth = 0.f;
+
+			appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
+			
+
+#endif
+
+			return true;
+		}
+	}
+	return false;
+}
+
+struct btIntegrateTransformsLoop : public btIParallelForBody
+{
+	btRigidBodyStateArray*	m_states;
+	btScalar	m_timeStep;
+	bool	m_proceedToTransforms;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("integrateTransformsTask");
+		m_states->integrateTransforms(iBegin,iEnd,m_timeStep);
+		if (m_proceedToTransforms)
+		{
+			for (int i=iBegin;i<iEnd;i++)
+			{
+				m_states->proceedToTransform(i);
+			}
+		}
+	}
+};
+
+struct btProceedToTransformsLoop : public btIParallelForBody
+{
+	btRigidBodyStateArray*	m_states;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("proceedToTransformsTask");
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			m_states->proceedToTransform(i);
+		}
+	}
+};
+
 void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
+	if (m_rigidBodyStateArray)
+	{
+		btRigidBodyStateArray& states = *m_rigidBodyStateArray;
+		states.updateRows();
+		int numBodies = states.getNumActive();
+		for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+		{
+			m_nonStaticRigidBodies[i]->setHitFraction(1.f);
+		}
+
+		///the ccd sweeps use the broadphase, so bodies only proceed in parallel without ccd
+		bool useContinuous = getDispatchInfo().m_useContinuous;
+		btIntegrateTransformsLoop loop;
+		loop.m_states = &states;
+		loop.m_timeStep = timeStep;
+		loop.m_proceedToTransforms = !useContinuous;
+		btParallelFor(0,numBodies,BT_RIGID_BODY_STATE_GRAIN_SIZE,loop);
+
+		///without a body that moves further than its ccd motion threshold the bodies proceed in parallel after all
+		bool needsContinuous = false;
+		for (int i=0;useContinuous && i<numBodies && !needsContinuous;i++)
+		{
+			btScalar threshold = states.getBody(i)->getCcdSquareMotionThreshold();
+			needsContinuous = threshold && threshold < states.getSquareMotion(i);
+		}
+		if (useContinuous && !needsContinuous)
+		{
+			btProceedToTransformsLoop proceedLoop;
+			proceedLoop.m_states = &states;
+			btParallelFor(0,numBodies,BT_RIGID_BODY_STATE_GRAIN_SIZE,proceedLoop);
+		}
+
+		if (needsContinuous)
+		{
+			///the bodies proceed in the order of the serial path. A clamped motion applies an impulse to the hit body,
+			///so once a motion got clamped the remaining bodies are predicted again from their current velocities
+			bool clamped = false;
+			btTransform predictedTrans;
+			for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+			{
+				btRigidBody* body = m_nonStaticRigidBodies[i];
+				if (!body->isActive() || body->isStaticOrKinematicObject())
+					continue;
+				int row = states.findRow(body);
+				btScalar squareMotion;
+				if (clamped)
+				{
+					body->predictIntegratedTransform(timeStep, predictedTrans);
+					squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+				} else
+				{
+					states.getTransform(row,predictedTrans);
+					squareMotion = states.getSquareMotion(row);
+				}
+				if (body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+				{
+					if (integrateTransformContinuous(body,timeStep,predictedTrans))
+					{
+						clamped = true;
+						continue;
+					}
+				}
+				if (clamped)
+					body->proceedToTransform(predictedTrans);
+				else
+					states.proceedToTransform(row);
+			}
+		}
+		return;
+	}
+
 	btTransform predictedTrans;
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
@@ -870,82 +1414,8 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 
 			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
 			{
-				BT_PROFILE("CCD motion clamping");
-				if (body->getCollisionShape()->isConvex())
-				{
-					gNumClampedCcdMotions++;
-#ifdef USE_STATIC_ONLY
-					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
-					{
-					public:
-
-						StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) : 
-						  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
-						{
-						}
-
-					  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-						{
-							btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
-							if (!otherObj->isStaticOrKinematicObject())
-								return false;
-							return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
-						}
-					};
-
-					StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
-#else
-					btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
-#endif
-					//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
-
-					sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
-					sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
-					btTransform modifiedPredictedTrans = predictedTrans;
-					modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
-
-					convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
-					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
-					{
-						
-						//printf("clamped integration to hit fraction = %f\n",fraction);
-						body->setHitFraction(sweepResults.m_closestHitFraction);
-						body->predictIntegratedTransform(timeStep*body->getHitFraction(), predictedTrans);
-						body->setHitFraction(0.f);
-						body->proceedToTransform( predictedTrans);
-
-#if 0
-						btVector3 linVel = body->getLinearVelocity();
-
-						btScalar maxSpeed = body->getCcdMotionThreshold()/getSolverInfo().m_timeStep;
-						btScalar maxSpeedSqr = maxSpeed*maxSpeed;
-						if (linVel.length2()>maxSpeedSqr)
-						{
-							linVel.normalize();
-							linVel*= maxSpeed;
-							body->setLinearVelocity(linVel);
-							btScalar ms2 = body->getLinearVelocity().length2();
-							body->predictIntegratedTransform(timeStep, predictedTrans);
-
-							btScalar sm2 = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
-							btScalar smt = body->getCcdSquareMotionThreshold();
-							printf("sm2=%f\n",sm2);
-						}
-#else
-						//response  between two dynamic objects without friction, assuming 0 penetration depth
-						btScalar appliedImpulse = 0.f;
-						btScalar depth = 0.f;
-
-						appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
-						
-
-#endif
-
-        				continue;
-					}
-				}
+				if (integrateTransformContinuous(body,timeStep,predictedTrans))
+					continue;
 			}
 			
 
@@ -959,9 +1429,33 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 
 
 
+struct btPredictUnconstraintMotionLoop : public btIParallelForBody
+{
+	btRigidBodyStateArray*	m_states;
+	btScalar	m_timeStep;
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("predictUnconstraintMotionTask");
+		m_states->predictUnconstraintMotion(iBegin,iEnd,m_timeStep);
+	}
+};
+
 void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
+	if (m_rigidBodyStateArray)
+	{
+		btRigidBodyStateArray& states = *m_rigidBodyStateArray;
+		states.updateRows();
+		states.setTimeStep(timeStep);
+
+		btPredictUnconstraintMotionLoop loop;
+		loop.m_states = &states;
+		loop.m_timeStep = timeStep;
+		btParallelFor(0,states.getNumDynamic(),BT_RIGID_BODY_STATE_GRAIN_SIZE,loop);
+		return;
+	}
 	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
@@ -1186,6 +1680,10 @@ void	btDiscreteDynamicsWorld::setConstraintSolver(btConstraintSolver* solver)
 	m_ownsConstraintSolver = false;
 	m_constraintSolver = solver;
 	m_solverIslandCallback->m_solver = solver;
+
+	///the task solvers are duplicates of the previous solver, create them again from the new one
+	removeTaskSolvers(0);
+	setNumTasks(m_numTasks);
 }
 
 btConstraintSolver* btDiscreteDynamicsWorld::getConstraintSolver()
@@ -1193,6 +1691,65 @@ btConstraintSolver* btDiscreteDynamicsWorld::getConstraintSolver()
 	return m_constraintSolver;
 }
 
+void	btDiscreteDynamicsWorld::removeTaskSolvers(int numTaskSolvers)
+{
+	while (m_taskConstraintSolvers.size() > numTaskSolvers)
+	{
+		btConstraintSolver* solver = m_taskConstraintSolvers[m_taskConstraintSolvers.size()-1];
+		solver->~btConstraintSolver();
+		btAlignedFree(solver);
+		m_taskConstraintSolvers.pop_back();
+
+		btStackAlloc* stackAlloc = m_taskStackAllocs[m_taskStackAllocs.size()-1];
+		stackAlloc->destroy();
+		stackAlloc->~btStackAlloc();
+		btAlignedFree(stackAlloc);
+		m_taskStackAllocs.pop_back();
+	}
+}
+
+void	btDiscreteDynamicsWorld::setNumTasks(int numTasks)
+{
+	numTasks = btMax(1,btMin(numTasks,int(BT_MAX_THREAD_COUNT)));
+
+	removeTaskSolvers(numTasks-1);
+
+	while (m_taskConstraintSolvers.size() < numTasks-1)
+	{
+		btConstraintSolver* solver = m_constraintSolver ? m_constraintSolver->createTaskSolver() : 0;
+		if (!solver)
+			break;
+		m_taskConstraintSolvers.push_back(solver);
+
+		///the task stack allocators get the same size as the world stack allocator
+		unsigned int stackSize = m_stackAlloc ? (unsigned int)m_stackAlloc->getAvailableMemory() : 0;
+		void* mem = btAlignedAlloc(sizeof(btStackAlloc),16);
+		m_taskStackAllocs.push_back(new (mem) btStackAlloc(stackSize));
+	}
+
+	m_numTasks = numTasks;
+}
+
+
+void	btDiscreteDynamicsWorld::setUseRigidBodyStateArray(bool useStateArray)
+{
+	if (useStateArray && !m_rigidBodyStateArray)
+	{
+		void* mem = btAlignedAlloc(sizeof(btRigidBodyStateArray),16);
+		m_rigidBodyStateArray = new (mem) btRigidBodyStateArray;
+		for (int i=0;i<m_nonStaticRigidBodies.size();i++)
+		{
+			m_rigidBodyStateArray->addBody(m_nonStaticRigidBodies[i]);
+		}
+	}
+	if (!useStateArray && m_rigidBodyStateArray)
+	{
+		m_rigidBodyStateArray->~btRigidBodyStateArray();
+		btAlignedFree(m_rigidBodyStateArray);
+		m_rigidBodyStateArray = NULL;
+	}
+}
+
 
 int		btDiscreteDynamicsWorld::getNumConstraints() const
 {
@@ -27,7 +27,10 @@ class btTypedConstraint;
 class btActionInterface;
 
 class btIDebugDraw;
+class btStackAlloc;
+class btRigidBodyStateArray;
 struct InplaceSolverIslandCallback;
+struct ParallelSolverIslandCallback;
 
 #include "LinearMath/btAlignedObjectArray.h"
 
@@ -40,6 +43,15 @@ protected:
 	
     btAlignedObjectArray<btTypedConstraint*>	m_sortedConstraints;
 	InplaceSolverIslandCallback* 	m_solverIslandCallback;
+	ParallelSolverIslandCallback*	m_parallelSolverIslandCallback;
+
+	///solvers and stack allocators for solver tasks 1..m_numTasks-1, task 0 uses m_constraintSolver and m_stackAlloc.
+	///The task solvers are created with m_constraintSolver->createTaskSolver()
+	btAlignedObjectArray<btConstraintSolver*>	m_taskConstraintSolvers;
+	btAlignedObjectArray<btStackAlloc*>	m_taskStackAllocs;
+	int	m_numTasks;
+
+	void	removeTaskSolvers(int numTaskSolvers);
 
 	btConstraintSolver*	m_constraintSolver;
 
@@ -49,6 +61,9 @@ protected:
 
 	btAlignedObjectArray<btRigidBody*> m_nonStaticRigidBodies;
 
+	///packed body state of the dynamic bodies, NULL unless enabled with setUseRigidBodyStateArray
+	btRigidBodyStateArray*	m_rigidBodyStateArray;
+
 	btVector3	m_gravity;
 
 	//for variable timesteps
@@ -66,6 +81,8 @@ protected:
 	virtual void	predictUnconstraintMotion(btScalar timeStep);
 	
 	virtual void	integrateTransforms(btScalar timeStep);
+
+	bool	integrateTransformContinuous(btRigidBody* body,btScalar timeStep,const btTransform& predictedTrans);
 		
 	virtual void	calculateSimulationIslands();
 
@@ -168,11 +185,33 @@ public:
 	///apply gravity, call this once per timestep
 	virtual void	applyGravity();
 
-	virtual void	setNumTasks(int numTasks)
+	///setNumTasks enables parallel island solving when numTasks > 1. The islands are distributed over numTasks solver tasks,
+	///each with its own stack allocator and a duplicate of the constraint solver (see btConstraintSolver::createTaskSolver), and run using
+	///btParallelFor (see LinearMath/btThreads.h). Solvers that can't be duplicated solve all islands on a single task.
+	///The assignment of islands to tasks only depends on numTasks, so the simulation is deterministic for a fixed number of tasks.
+	virtual void	setNumTasks(int numTasks);
+
+	int		getNumTasks() const
 	{
-        (void) numTasks;
+		return m_numTasks;
 	}
 
+	///setUseRigidBodyStateArray keeps the velocities and forces of the dynamic bodies in packed structure-of-arrays form (see btRigidBodyStateArray)
+	///and runs applyGravity, predictUnconstraintMotion, integrateTransforms, updateActivationState and clearForces over it, the two
+	///integration passes split over the task scheduler threads. It pays off for scenes with many active bodies.
+	void	setUseRigidBodyStateArray(bool useStateArray);
+
+	bool	getUseRigidBodyStateArray() const
+	{
+		return m_rigidBodyStateArray != NULL;
+	}
+
+	///setPersistentIslands keeps the simulation islands across frames, so the island update only depends on the number of active bodies
+	///(see btSimulationIslandManager::enablePersistentIslands). Set the ghost pair callback of the pair cache before enabling it.
+	void	setPersistentIslands(bool persistentIslands);
+
+	bool	getPersistentIslands() const;
+
 	///obsolete, use updateActions instead
 	virtual void updateVehicles(btScalar timeStep)
 	{
@@ -42,6 +42,8 @@ void	btRigidBody::setupRigidBody(const btRigidBody::btRigidBodyConstructionInfo&
 {
 
 	m_internalType=CO_RIGID_BODY;
+	m_stateArray = 0;
+	m_stateIndex = -1;
 
 	m_linearVelocity.setValue(btScalar(0.0), btScalar(0.0), btScalar(0.0));
 	m_angularVelocity.setValue(btScalar(0.),btScalar(0.),btScalar(0.));
@@ -102,6 +104,7 @@ void	btRigidBody::setupRigidBody(const btRigidBody::btRigidBodyConstructionInfo&
 
 void btRigidBody::predictIntegratedTransform(btScalar timeStep,btTransform& predictedTransform) 
 {
+	syncState();
 	btTransformUtil::integrateTransform(m_worldTransform,m_linearVelocity,m_angularVelocity,timeStep,predictedTransform);
 }
 
@@ -115,6 +118,7 @@ void			btRigidBody::saveKinematicState(btScalar timeStep)
 			getMotionState()->getWorldTransform(m_worldTransform);
 		btVector3 linVel,angVel;
 		
+		syncStateForWrite();
 		btTransformUtil::calculateVelocity(m_interpolationWorldTransform,m_worldTransform,timeStep,m_linearVelocity,m_angularVelocity);
 		m_interpolationLinearVelocity = m_linearVelocity;
 		m_interpolationAngularVelocity = m_angularVelocity;
@@ -133,6 +137,7 @@ void	btRigidBody::getAabb(btVector3& aabbMin,btVector3& aabbMax) const
 
 void btRigidBody::setGravity(const btVector3& acceleration) 
 {
+	syncStateForWrite();
 	if (m_inverseMass != btScalar(0.0))
 	{
 		m_gravity = acceleration * (btScalar(1.0) / m_inverseMass);
@@ -147,6 +152,7 @@ void btRigidBody::setGravity(const btVector3& acceleration)
 
 void btRigidBody::setDamping(btScalar lin_damping, btScalar ang_damping)
 {
+	syncStateForWrite();
 	m_linearDamping = btClamped(lin_damping, (btScalar)btScalar(0.0), (btScalar)btScalar(1.0));
 	m_angularDamping = btClamped(ang_damping, (btScalar)btScalar(0.0), (btScalar)btScalar(1.0));
 }
@@ -159,6 +165,7 @@ void			btRigidBody::applyDamping(btScalar timeStep)
 {
 	//On new damping: see discussion/issue report here: http://code.google.com/p/bullet/issues/detail?id=74
 	//todo: do some performance comparisons (but other parts of the engine are probably bottleneck anyway
+	syncStateForWrite();
 
 //#define USE_OLD_DAMPING_METHOD 1
 #ifdef USE_OLD_DAMPING_METHOD
@@ -229,6 +236,7 @@ void btRigidBody::proceedToTransform(const btTransform& newTrans)
 
 void btRigidBody::setMassProps(btScalar mass, const btVector3& inertia)
 {
+	syncStateForWrite();
 	if (mass == btScalar(0.))
 	{
 		m_collisionFlags |= btCollisionObject::CF_STATIC_OBJECT;
@@ -261,6 +269,7 @@ void btRigidBody::integrateVelocities(btScalar step)
 	if (isStaticOrKinematicObject())
 		return;
 
+	syncStateForWrite();
 	m_linearVelocity += m_totalForce * (m_inverseMass * step);
 	m_angularVelocity += m_invInertiaTensorWorld * m_totalTorque * step;
 
@@ -346,6 +355,8 @@ const char*	btRigidBody::serialize(void* dataBuffer, class btSerializer* seriali
 
 	btCollisionObject::serialize(&rbd->m_collisionObjectData, serializer);
 
+	syncState();
+
 	m_invInertiaTensorWorld.serialize(rbd->m_invInertiaTensorWorld);
 	m_linearVelocity.serialize(rbd->m_linearVelocity);
 	m_angularVelocity.serialize(rbd->m_angularVelocity);
@@ -20,6 +20,7 @@ subject to the following restrictions:
 #include "LinearMath/btTransform.h"
 #include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "btRigidBodyStateArray.h"
 
 class btCollisionShape;
 class btMotionState;
@@ -90,6 +91,27 @@ class btRigidBody  : public btCollisionObject
 	
 	int				m_debugBodyId;
 	
+	///the velocities and forces of a body in a btRigidBodyStateArray live in row m_stateIndex of m_stateArray,
+	///see syncState and syncStateForWrite
+	btRigidBodyStateArray*	m_stateArray;
+	int				m_stateIndex;
+
+	///btRigidBodyStateArray loads and stores the packed state without going through the accessors
+	friend class btRigidBodyStateArray;
+
+	///syncState copies the velocities and forces back from the state array when a pass changed them
+	SIMD_FORCE_INLINE void	syncState() const
+	{
+		if (m_stateArray && m_stateArray->isArrayNewer(m_stateIndex))
+			m_stateArray->storeRow(m_stateIndex);
+	}
+
+	///syncStateForWrite is called before the body changes state that the state array packs, the array loads the row again
+	SIMD_FORCE_INLINE void	syncStateForWrite()
+	{
+		if (m_stateArray)
+			m_stateArray->setBodyNewer(m_stateIndex);
+	}
 
 protected:
 
@@ -253,6 +275,7 @@ public:
 	}
 	void setLinearFactor(const btVector3& linearFactor)
 	{
+		syncStateForWrite();
 		m_linearFactor = linearFactor;
 		m_invMass = m_linearFactor*m_inverseMass;
 	}
@@ -267,16 +290,19 @@ public:
 
 	void			applyCentralForce(const btVector3& force)
 	{
+		syncStateForWrite();
 		m_totalForce += force*m_linearFactor;
 	}
 
 	const btVector3& getTotalForce() const
 	{
+		syncState();
 		return m_totalForce;
 	};
 
 	const btVector3& getTotalTorque() const
 	{
+		syncState();
 		return m_totalTorque;
 	};
     
@@ -287,6 +313,7 @@ public:
 
 	void	setInvInertiaDiagLocal(const btVector3& diagInvInertia)
 	{
+		syncStateForWrite();
 		m_invInertiaLocal = diagInvInertia;
 	}
 
@@ -298,6 +325,7 @@ public:
 
 	void	applyTorque(const btVector3& torque)
 	{
+		syncStateForWrite();
 		m_totalTorque += torque*m_angularFactor;
 	}
 	
@@ -309,12 +337,14 @@ public:
 	
 	void applyCentralImpulse(const btVector3& impulse)
 	{
+		syncStateForWrite();
 		m_linearVelocity += impulse *m_linearFactor * m_inverseMass;
 	}
 	
   	void applyTorqueImpulse(const btVector3& torque)
 	{
-			m_angularVelocity += m_invInertiaTensorWorld * torque * m_angularFactor;
+		syncStateForWrite();
+		m_angularVelocity += m_invInertiaTensorWorld * torque * m_angularFactor;
 	}
 	
 	void applyImpulse(const btVector3& impulse, const btVector3& rel_pos) 
@@ -331,6 +361,7 @@ public:
 
 	void clearForces() 
 	{
+		syncStateForWrite();
 		m_totalForce.setValue(btScalar(0.0), btScalar(0.0), btScalar(0.0));
 		m_totalTorque.setValue(btScalar(0.0), btScalar(0.0), btScalar(0.0));
 	}
@@ -346,26 +377,35 @@ public:
 		return m_worldTransform; 
 	}
 	const btVector3&   getLinearVelocity() const { 
+		syncState();
 		return m_linearVelocity; 
 	}
 	const btVector3&    getAngularVelocity() const { 
+		syncState();
 		return m_angularVelocity; 
 	}
 	
 
 	inline void setLinearVelocity(const btVector3& lin_vel)
 	{ 
+		syncState();
 		m_linearVelocity = lin_vel; 
+		if (m_stateArray)
+			m_stateArray->setVelocity(m_stateIndex,m_linearVelocity,m_angularVelocity);
 	}
 
 	inline void setAngularVelocity(const btVector3& ang_vel) 
 	{ 
+		syncState();
 		m_angularVelocity = ang_vel; 
+		if (m_stateArray)
+			m_stateArray->setVelocity(m_stateIndex,m_linearVelocity,m_angularVelocity);
 	}
 
 	btVector3 getVelocityInLocalPoint(const btVector3& rel_pos) const
 	{
 		//we also calculate lin/ang velocity for kinematic objects
+		syncState();
 		return m_linearVelocity + m_angularVelocity.cross(rel_pos);
 
 		//for kinematic objects, we could also use use:
@@ -0,0 +1,171 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRigidBodySnapshot.h"
+#include "btRigidBody.h"
+#include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
+#include "LinearMath/btMotionState.h"
+#include <string.h>
+
+
+static void	btStoreRigidBodyState(const btRigidBody* body, btRigidBodySnapshotState& state)
+{
+	//with double precision the state has tail padding, it is compared and written as words so it has to be zero
+	memset(&state,0,sizeof(btRigidBodySnapshotState));
+	const btTransform& trans = body->getWorldTransform();
+	for (int i=0;i<3;i++)
+	{
+		state.m_basis[3*i] = trans.getBasis()[i][0];
+		state.m_basis[3*i+1] = trans.getBasis()[i][1];
+		state.m_basis[3*i+2] = trans.getBasis()[i][2];
+		state.m_origin[i] = trans.getOrigin()[i];
+		state.m_linearVelocity[i] = body->getLinearVelocity()[i];
+		state.m_angularVelocity[i] = body->getAngularVelocity()[i];
+	}
+	state.m_deactivationTime = body->getDeactivationTime();
+	state.m_activationState = body->getActivationState();
+}
+
+void	btRigidBodySnapshot::findBodies(const btCollisionWorld* world) const
+{
+	const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+	m_bodies.resize(0);
+	for (int i=0;i<objects.size();i++)
+	{
+		btRigidBody* body = btRigidBody::upcast(objects[i]);
+		if (body && !body->isStaticOrKinematicObject())
+		{
+			m_bodies.push_back(body);
+		}
+	}
+}
+
+void	btRigidBodySnapshot::capture(const btCollisionWorld* world)
+{
+	findBodies(world);
+	m_states.resize(m_bodies.size());
+	for (int i=0;i<m_bodies.size();i++)
+	{
+		btStoreRigidBodyState(m_bodies[i],m_states[i]);
+	}
+}
+
+bool	btRigidBodySnapshot::restore(btCollisionWorld* world) const
+{
+	findBodies(world);
+	int numBodies = btMin(m_bodies.size(),m_states.size());
+	for (int i=0;i<numBodies;i++)
+	{
+		btRigidBody* body = m_bodies[i];
+		const btRigidBodySnapshotState& state = m_states[i];
+
+		btRigidBodySnapshotState current;
+		btStoreRigidBodyState(body,current);
+		if (memcmp(&current,&state,sizeof(btRigidBodySnapshotState))==0)
+			continue;
+
+		btTransform trans(btMatrix3x3(state.m_basis[0],state.m_basis[1],state.m_basis[2],
+									state.m_basis[3],state.m_basis[4],state.m_basis[5],
+									state.m_basis[6],state.m_basis[7],state.m_basis[8]),
+						btVector3(state.m_origin[0],state.m_origin[1],state.m_origin[2]));
+
+		//the velocities go first, setCenterOfMassTransform copies them into the interpolation velocities
+		body->setLinearVelocity(btVector3(state.m_linearVelocity[0],state.m_linearVelocity[1],state.m_linearVelocity[2]));
+		body->setAngularVelocity(btVector3(state.m_angularVelocity[0],state.m_angularVelocity[1],state.m_angularVelocity[2]));
+		body->setCenterOfMassTransform(trans);
+		body->forceActivationState(state.m_activationState);
+		body->setDeactivationTime(state.m_deactivationTime);
+
+		if (body->getMotionState())
+		{
+			body->getMotionState()->setWorldTransform(trans);
+		}
+		//the next step updates the aabbs of active bodies anyway
+		if (body->getBroadphaseHandle() && !body->isActive() && !world->getForceUpdateAllAabbs())
+		{
+			world->updateSingleAabb(body);
+		}
+	}
+	return m_bodies.size()==m_states.size();
+}
+
+void	btRigidBodySnapshot::writeDelta(const btRigidBodySnapshot& base, btAlignedObjectArray<unsigned int>& delta) const
+{
+	static const btRigidBodySnapshotState zeroState = btRigidBodySnapshotState();
+
+	int numBodies = m_states.size();
+	//worst case: every word of every body changed
+	delta.reserve(delta.size()+1+numBodies*(NUM_MASK_WORDS+NUM_STATE_WORDS));
+	delta.push_back((unsigned int)numBodies);
+
+	for (int i=0;i<numBodies;i++)
+	{
+		const unsigned int* cur = (const unsigned int*)&m_states[i];
+		const unsigned int* prev = (const unsigned int*)(i<base.m_states.size() ? &base.m_states[i] : &zeroState);
+
+		int maskIndex = delta.size();
+		int w;
+		for (w=0;w<NUM_MASK_WORDS;w++)
+		{
+			delta.push_back(0);
+		}
+		for (w=0;w<NUM_STATE_WORDS;w++)
+		{
+			if (cur[w]!=prev[w])
+			{
+				delta[maskIndex+(w>>5)] |= 1u<<(w&31);
+				delta.push_back(cur[w]);
+			}
+		}
+	}
+}
+
+int		btRigidBodySnapshot::readDelta(const btRigidBodySnapshot& base, const unsigned int* delta, int deltaSize)
+{
+	static const btRigidBodySnapshotState zeroState = btRigidBodySnapshotState();
+
+	btAssert(&base!=this);
+	if (deltaSize<1)
+		return 0;
+
+	int numBodies = (int)delta[0];
+	if (numBodies<0 || numBodies>(deltaSize-1)/NUM_MASK_WORDS)
+		return 0;
+	int pos = 1;
+	m_states.resize(numBodies);
+	for (int i=0;i<numBodies;i++)
+	{
+		if (pos+NUM_MASK_WORDS>deltaSize)
+			return 0;
+		const unsigned int* mask = &delta[pos];
+		pos += NUM_MASK_WORDS;
+
+		unsigned int* cur = (unsigned int*)&m_states[i];
+		const unsigned int* prev = (const unsigned int*)(i<base.m_states.size() ? &base.m_states[i] : &zeroState);
+		for (int w=0;w<NUM_STATE_WORDS;w++)
+		{
+			if (mask[w>>5] & (1u<<(w&31)))
+			{
+				if (pos>=deltaSize)
+					return 0;
+				cur[w] = delta[pos++];
+			} else
+			{
+				cur[w] = prev[w];
+			}
+		}
+	}
+	return pos;
+}
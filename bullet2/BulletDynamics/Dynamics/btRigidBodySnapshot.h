@@ -0,0 +1,85 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RIGID_BODY_SNAPSHOT_H
+#define BT_RIGID_BODY_SNAPSHOT_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btScalar.h"
+
+class btCollisionWorld;
+class btRigidBody;
+
+///btRigidBodySnapshotState is the fixed layout of the state of one dynamic rigid body in a btRigidBodySnapshot
+struct btRigidBodySnapshotState
+{
+	btScalar	m_basis[9];
+	btScalar	m_origin[3];
+	btScalar	m_linearVelocity[3];
+	btScalar	m_angularVelocity[3];
+	btScalar	m_deactivationTime;
+	int			m_activationState;
+};
+
+///btRigidBodySnapshot captures the state of the dynamic rigid bodies of a world (transform, velocities and activation) for rollback and replication.
+///Unlike btDefaultSerializer it doesn't write shapes, DNA or any static data, so it can be taken every frame.
+///Bodies are identified by their order among the dynamic rigid bodies of the world, restore expects the same bodies in the same order.
+///Contact caches and constraint warm starting are not part of the snapshot.
+///Deltas are written against a base snapshot: each body stores a mask of the 32 bit words that differ from the base, followed by those words.
+///The layout depends on btScalar and the endianness, so both ends need the same build.
+class btRigidBodySnapshot
+{
+	btAlignedObjectArray<btRigidBodySnapshotState>	m_states;
+
+	///scratch array of the dynamic bodies of the world, in capture order
+	mutable btAlignedObjectArray<btRigidBody*>	m_bodies;
+
+	void	findBodies(const btCollisionWorld* world) const;
+
+public:
+
+	enum
+	{
+		NUM_STATE_WORDS = sizeof(btRigidBodySnapshotState)/sizeof(unsigned int),
+		NUM_MASK_WORDS = (NUM_STATE_WORDS+31)/32
+	};
+
+	int		size() const
+	{
+		return m_states.size();
+	}
+
+	const btRigidBodySnapshotState&	getState(int index) const
+	{
+		return m_states[index];
+	}
+
+	///capture stores the state of all non static, non kinematic rigid bodies of the world
+	void	capture(const btCollisionWorld* world);
+
+	///restore writes the stored state back into the dynamic rigid bodies of the world, bodies that didn't change are skipped.
+	///Returns false if the world has a different number of dynamic bodies, the common bodies are restored anyway.
+	///The broadphase aabbs are left to the next step, call btCollisionWorld::updateAabbs before querying the world in between.
+	bool	restore(btCollisionWorld* world) const;
+
+	///writeDelta appends the difference between this snapshot and base to delta. An empty base gives a full snapshot.
+	void	writeDelta(const btRigidBodySnapshot& base, btAlignedObjectArray<unsigned int>& delta) const;
+
+	///readDelta replaces this snapshot with base plus delta, this and base must be different objects.
+	///Returns the number of words read, or 0 if delta is invalid.
+	int		readDelta(const btRigidBodySnapshot& base, const unsigned int* delta, int deltaSize);
+};
+
+#endif //BT_RIGID_BODY_SNAPSHOT_H
@@ -0,0 +1,573 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRigidBodyStateArray.h"
+#include "btRigidBody.h"
+#include "LinearMath/btTransformUtil.h"
+
+
+btRigidBodyStateArray::btRigidBodyStateArray()
+:m_numActive(0),
+m_numDynamic(0),
+m_dampingTimeStep(btScalar(0.))
+{
+}
+
+btRigidBodyStateArray::~btRigidBodyStateArray()
+{
+	while (size())
+	{
+		removeBody(m_bodies[size()-1]);
+	}
+}
+
+void	btRigidBodyStateArray::resize(int numRows)
+{
+	///the rows grow one at a time, so reserve room for twice the rows like btAlignedObjectArray::push_back
+	int capacity = numRows > m_bodies.capacity() ? numRows*2 : 0;
+	btAlignedObjectArray<btScalar>* columns[] = {
+		m_linearVelocity,m_angularVelocity,m_totalForce,m_totalTorque,m_gravity,m_invInertiaLocal,
+		m_position};
+	int i,j;
+	for (i=0;i<int(sizeof(columns)/sizeof(columns[0]));i++)
+	{
+		for (j=0;j<3;j++)
+		{
+			columns[i][j].reserve(capacity);
+			columns[i][j].resizeNoInitialize(numRows);
+		}
+	}
+	for (j=0;j<4;j++)
+	{
+		m_orientation[j].reserve(capacity);
+		m_orientation[j].resizeNoInitialize(numRows);
+		m_deltaOrientation[j].reserve(capacity);
+		m_deltaOrientation[j].resizeNoInitialize(numRows);
+	}
+	m_basis.reserve(capacity);
+	m_basis.resizeNoInitialize(numRows);
+	m_predictedTransform.reserve(capacity);
+	m_predictedTransform.resizeNoInitialize(numRows);
+	m_invInertiaTensorWorld.reserve(capacity);
+	m_invInertiaTensorWorld.resizeNoInitialize(numRows);
+	btAlignedObjectArray<btScalar>* scalars[] = {
+		&m_linearDamping,&m_angularDamping,&m_linearDampingFactor,&m_angularDampingFactor,&m_squareMotion};
+	for (i=0;i<int(sizeof(scalars)/sizeof(scalars[0]));i++)
+	{
+		scalars[i]->reserve(capacity);
+		scalars[i]->resizeNoInitialize(numRows);
+	}
+	btAlignedObjectArray<int>* ints[] = {&m_sync,&m_group,&m_additionalDamping};
+	for (i=0;i<int(sizeof(ints)/sizeof(ints[0]));i++)
+	{
+		ints[i]->reserve(capacity);
+		ints[i]->resizeNoInitialize(numRows);
+	}
+	m_bodies.reserve(capacity);
+	m_bodies.resizeNoInitialize(numRows);
+	m_numActive = btMin(m_numActive,numRows);
+	m_numDynamic = btMin(m_numDynamic,numRows);
+}
+
+///swapRows only moves the persistent state, the integrated transforms are computed and used within one pass
+void	btRigidBodyStateArray::swapRows(int a, int b)
+{
+	int j;
+	for (j=0;j<3;j++)
+	{
+		btSwap(m_linearVelocity[j][a],m_linearVelocity[j][b]);
+		btSwap(m_angularVelocity[j][a],m_angularVelocity[j][b]);
+		btSwap(m_totalForce[j][a],m_totalForce[j][b]);
+		btSwap(m_totalTorque[j][a],m_totalTorque[j][b]);
+		btSwap(m_gravity[j][a],m_gravity[j][b]);
+		btSwap(m_invInertiaLocal[j][a],m_invInertiaLocal[j][b]);
+		btSwap(m_position[j][a],m_position[j][b]);
+	}
+	for (j=0;j<4;j++)
+	{
+		btSwap(m_orientation[j][a],m_orientation[j][b]);
+	}
+	btSwap(m_basis[a],m_basis[b]);
+	btSwap(m_linearDamping[a],m_linearDamping[b]);
+	btSwap(m_angularDamping[a],m_angularDamping[b]);
+	btSwap(m_linearDampingFactor[a],m_linearDampingFactor[b]);
+	btSwap(m_angularDampingFactor[a],m_angularDampingFactor[b]);
+	btSwap(m_additionalDamping[a],m_additionalDamping[b]);
+	btSwap(m_sync[a],m_sync[b]);
+	btSwap(m_group[a],m_group[b]);
+	btSwap(m_bodies[a],m_bodies[b]);
+	m_bodies[a]->m_stateIndex = a;
+	m_bodies[b]->m_stateIndex = b;
+}
+
+void	btRigidBodyStateArray::addBody(btRigidBody* body)
+{
+	btAssert(!body->m_stateArray);
+	int index = size();
+	resize(index+1);
+	m_bodies[index] = body;
+	body->m_stateArray = this;
+	body->m_stateIndex = index;
+	///the group is set by the next updateRows, until then the row is left alone like a static body
+	m_group[index] = 2;
+	///an invalid damping makes loadRow compute the damping factors
+	m_linearDamping[index] = btScalar(-1.);
+	m_additionalDamping[index] = 0;
+	loadRow(index);
+	loadTransform(index);
+}
+
+void	btRigidBodyStateArray::removeBody(btRigidBody* body)
+{
+	btAssert(body->m_stateArray==this);
+	int index = body->m_stateIndex;
+	if (m_sync[index]==BT_ROW_ARRAY_NEWER)
+		storeRow(index);
+	int last = size()-1;
+	if (index!=last)
+		swapRows(index,last);
+	resize(last);
+	body->m_stateArray = 0;
+	body->m_stateIndex = -1;
+}
+
+bool	btRigidBodyStateArray::hasBody(const btRigidBody* body) const
+{
+	return body->m_stateArray==this;
+}
+
+int		btRigidBodyStateArray::findRow(const btRigidBody* body) const
+{
+	btAssert(body->m_stateArray==this);
+	return body->m_stateIndex;
+}
+
+void	btRigidBodyStateArray::loadRow(int index)
+{
+	const btRigidBody* body = m_bodies[index];
+	for (int j=0;j<3;j++)
+	{
+		m_linearVelocity[j][index] = body->m_linearVelocity[j];
+		m_angularVelocity[j][index] = body->m_angularVelocity[j];
+		m_totalForce[j][index] = body->m_totalForce[j];
+		m_totalTorque[j][index] = body->m_totalTorque[j];
+		m_gravity[j][index] = body->m_gravity[j]*body->m_linearFactor[j];
+		m_invInertiaLocal[j][index] = body->m_invInertiaLocal[j];
+	}
+	///the damping factors are only recomputed when the damping changed, most reloads follow a velocity change
+	int additionalDamping = body->m_additionalDamping ? 1 : 0;
+	if (m_linearDamping[index]!=body->m_linearDamping || m_angularDamping[index]!=body->m_angularDamping ||
+		m_additionalDamping[index]!=additionalDamping)
+	{
+		m_linearDamping[index] = body->m_linearDamping;
+		m_angularDamping[index] = body->m_angularDamping;
+		m_additionalDamping[index] = additionalDamping;
+		///the additional damping is rare and full of branches, it is applied on the body, see predictUnconstraintMotion
+		if (additionalDamping)
+		{
+			m_linearDampingFactor[index] = btScalar(1.);
+			m_angularDampingFactor[index] = btScalar(1.);
+		} else
+		{
+			m_linearDampingFactor[index] = btPow(btScalar(1)-m_linearDamping[index], m_dampingTimeStep);
+			m_angularDampingFactor[index] = btPow(btScalar(1)-m_angularDamping[index], m_dampingTimeStep);
+		}
+	}
+	m_sync[index] = BT_ROW_SYNCED;
+}
+
+void	btRigidBodyStateArray::storeRow(int index)
+{
+	btRigidBody* body = m_bodies[index];
+	body->m_linearVelocity.setValue(m_linearVelocity[0][index],m_linearVelocity[1][index],m_linearVelocity[2][index]);
+	body->m_angularVelocity.setValue(m_angularVelocity[0][index],m_angularVelocity[1][index],m_angularVelocity[2][index]);
+	body->m_totalForce.setValue(m_totalForce[0][index],m_totalForce[1][index],m_totalForce[2][index]);
+	body->m_totalTorque.setValue(m_totalTorque[0][index],m_totalTorque[1][index],m_totalTorque[2][index]);
+	m_sync[index] = BT_ROW_SYNCED;
+}
+
+void	btRigidBodyStateArray::loadTransform(int index)
+{
+	const btTransform& trans = m_bodies[index]->getWorldTransform();
+	btQuaternion orn;
+	trans.getBasis().getRotation(orn);
+	for (int j=0;j<3;j++)
+	{
+		m_position[j][index] = trans.getOrigin()[j];
+	}
+	m_basis[index] = trans.getBasis();
+	m_orientation[0][index] = orn.x();
+	m_orientation[1][index] = orn.y();
+	m_orientation[2][index] = orn.z();
+	m_orientation[3][index] = orn.w();
+}
+
+void	btRigidBodyStateArray::loadStaleRows(int iBegin, int iEnd)
+{
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		if (m_sync[i]==BT_ROW_BODY_NEWER)
+			loadRow(i);
+	}
+}
+
+///loadTransforms copies the positions, the orientation is only recomputed when the basis differs from the one it was computed from,
+///the user or a ccd clamp moved the body
+void	btRigidBodyStateArray::loadTransforms(int iBegin, int iEnd)
+{
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		const btTransform& trans = m_bodies[i]->getWorldTransform();
+		const btMatrix3x3& basis = trans.getBasis();
+		const btMatrix3x3& cached = m_basis[i];
+		if (basis[0].x()!=cached[0].x() || basis[0].y()!=cached[0].y() || basis[0].z()!=cached[0].z() ||
+			basis[1].x()!=cached[1].x() || basis[1].y()!=cached[1].y() || basis[1].z()!=cached[1].z() ||
+			basis[2].x()!=cached[2].x() || basis[2].y()!=cached[2].y() || basis[2].z()!=cached[2].z())
+		{
+			loadTransform(i);
+		} else
+		{
+			m_position[0][i] = trans.getOrigin().x();
+			m_position[1][i] = trans.getOrigin().y();
+			m_position[2][i] = trans.getOrigin().z();
+		}
+	}
+}
+
+void	btRigidBodyStateArray::markArrayNewer(int iBegin, int iEnd)
+{
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		m_sync[i] = BT_ROW_ARRAY_NEWER;
+	}
+}
+
+void	btRigidBodyStateArray::updateRows()
+{
+	int n = size();
+	int i;
+	for (i=0;i<n;i++)
+	{
+		const btRigidBody* body = m_bodies[i];
+		m_group[i] = body->isStaticOrKinematicObject() ? 2 : (body->isActive() ? 0 : 1);
+	}
+	///two partitions, active dynamic rows before sleeping dynamic rows before static and kinematic rows.
+	///Rows that are already in place are not moved, so a frame without activation changes swaps nothing
+	for (int group=2;group>0;group--)
+	{
+		int lo = 0;
+		int hi = (group==2 ? n : m_numDynamic)-1;
+		for (;;)
+		{
+			while (lo<=hi && m_group[lo]<group)
+				lo++;
+			while (lo<=hi && m_group[hi]>=group)
+				hi--;
+			if (lo>=hi)
+				break;
+			swapRows(lo,hi);
+			lo++;
+			hi--;
+		}
+		if (group==2)
+			m_numDynamic = lo;
+		else
+			m_numActive = lo;
+	}
+}
+
+void	btRigidBodyStateArray::setTimeStep(btScalar timeStep)
+{
+	if (timeStep==m_dampingTimeStep)
+		return;
+	m_dampingTimeStep = timeStep;
+	for (int i=0;i<size();i++)
+	{
+		if (!m_additionalDamping[i])
+		{
+			m_linearDampingFactor[i] = btPow(btScalar(1)-m_linearDamping[i], timeStep);
+			m_angularDampingFactor[i] = btPow(btScalar(1)-m_angularDamping[i], timeStep);
+		}
+	}
+}
+
+void	btRigidBodyStateArray::applyGravity()
+{
+	updateRows();
+	int n = m_numActive;
+	if (!n)
+		return;
+	loadStaleRows(0,n);
+	for (int j=0;j<3;j++)
+	{
+		btScalar* force = &m_totalForce[j][0];
+		const btScalar* gravity = &m_gravity[j][0];
+		for (int i=0;i<n;i++)
+		{
+			force[i] += gravity[i];
+		}
+	}
+	markArrayNewer(0,n);
+}
+
+void	btRigidBodyStateArray::clearForces()
+{
+	int n = size();
+	if (!n)
+		return;
+	loadStaleRows(0,n);
+	for (int j=0;j<3;j++)
+	{
+		btScalar* force = &m_totalForce[j][0];
+		btScalar* torque = &m_totalTorque[j][0];
+		for (int i=0;i<n;i++)
+		{
+			force[i] = btScalar(0.);
+			torque[i] = btScalar(0.);
+		}
+	}
+	markArrayNewer(0,n);
+}
+
+void	btRigidBodyStateArray::updateActivationState(btScalar timeStep)
+{
+	for (int i=0;i<size();i++)
+	{
+		btRigidBody* body = m_bodies[i];
+		if (m_sync[i]==BT_ROW_BODY_NEWER)
+			loadRow(i);
+
+		//btRigidBody::updateDeactivation
+		if ((body->getActivationState() != ISLAND_SLEEPING) && (body->getActivationState() != DISABLE_DEACTIVATION))
+		{
+			const btScalar vx = m_linearVelocity[0][i];
+			const btScalar vy = m_linearVelocity[1][i];
+			const btScalar vz = m_linearVelocity[2][i];
+			const btScalar wx = m_angularVelocity[0][i];
+			const btScalar wy = m_angularVelocity[1][i];
+			const btScalar wz = m_angularVelocity[2][i];
+			if ((vx*vx+vy*vy+vz*vz < body->m_linearSleepingThreshold*body->m_linearSleepingThreshold) &&
+				(wx*wx+wy*wy+wz*wz < body->m_angularSleepingThreshold*body->m_angularSleepingThreshold))
+			{
+				body->setDeactivationTime(body->getDeactivationTime()+timeStep);
+			} else
+			{
+				body->setDeactivationTime(btScalar(0.));
+				body->setActivationState(0);
+			}
+		}
+
+		if (body->wantsSleeping())
+		{
+			if (body->isStaticOrKinematicObject())
+			{
+				body->setActivationState(ISLAND_SLEEPING);
+			} else
+			{
+				if (body->getActivationState() == ACTIVE_TAG)
+					body->setActivationState( WANTS_DEACTIVATION );
+				if (body->getActivationState() == ISLAND_SLEEPING) 
+				{
+					for (int j=0;j<3;j++)
+					{
+						m_linearVelocity[j][i] = btScalar(0.);
+						m_angularVelocity[j][i] = btScalar(0.);
+					}
+					m_sync[i] = BT_ROW_ARRAY_NEWER;
+				}
+			}
+		} else
+		{
+			if (body->getActivationState() != DISABLE_DEACTIVATION)
+				body->setActivationState( ACTIVE_TAG );
+		}
+	}
+}
+
+void	btRigidBodyStateArray::applyDamping(int iBegin, int iEnd)
+{
+	if (iBegin>=iEnd)
+		return;
+	for (int j=0;j<3;j++)
+	{
+		btScalar* linVel = &m_linearVelocity[j][0];
+		btScalar* angVel = &m_angularVelocity[j][0];
+		const btScalar* linDamping = &m_linearDampingFactor[0];
+		const btScalar* angDamping = &m_angularDampingFactor[0];
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			linVel[i] *= linDamping[i];
+			angVel[i] *= angDamping[i];
+		}
+	}
+}
+
+///integrate is btTransformUtil::integrateTransform (exponential map) for a range of bodies
+void	btRigidBodyStateArray::integrate(int iBegin, int iEnd, btScalar timeStep)
+{
+	if (iBegin>=iEnd)
+		return;
+	int i;
+	for (i=iBegin;i<iEnd;i++)
+	{
+		const btScalar wx = m_angularVelocity[0][i];
+		const btScalar wy = m_angularVelocity[1][i];
+		const btScalar wz = m_angularVelocity[2][i];
+		btScalar	fAngle = btSqrt(wx*wx+wy*wy+wz*wz);
+		//limit the angular motion
+		if (fAngle*timeStep > ANGULAR_MOTION_THRESHOLD)
+		{
+			fAngle = ANGULAR_MOTION_THRESHOLD / timeStep;
+		}
+		btScalar scale;
+		if ( fAngle < btScalar(0.001) )
+		{
+			// use Taylor's expansions of sync function
+			scale = btScalar(0.5)*timeStep-(timeStep*timeStep*timeStep)*(btScalar(0.020833333333))*fAngle*fAngle;
+		}
+		else
+		{
+			// sync(fAngle) = sin(c*fAngle)/t
+			scale = btSin(btScalar(0.5)*fAngle*timeStep)/fAngle;
+		}
+		m_deltaOrientation[0][i] = wx*scale;
+		m_deltaOrientation[1][i] = wy*scale;
+		m_deltaOrientation[2][i] = wz*scale;
+		m_deltaOrientation[3][i] = btCos( fAngle*timeStep*btScalar(0.5) );
+	}
+
+	const btScalar* px = &m_position[0][0];
+	const btScalar* py = &m_position[1][0];
+	const btScalar* pz = &m_position[2][0];
+	const btScalar* vx = &m_linearVelocity[0][0];
+	const btScalar* vy = &m_linearVelocity[1][0];
+	const btScalar* vz = &m_linearVelocity[2][0];
+	btScalar* squareMotion = &m_squareMotion[0];
+	for (i=iBegin;i<iEnd;i++)
+	{
+		const btScalar x = px[i] + vx[i]*timeStep;
+		const btScalar y = py[i] + vy[i]*timeStep;
+		const btScalar z = pz[i] + vz[i]*timeStep;
+		const btScalar dx = x-px[i];
+		const btScalar dy = y-py[i];
+		const btScalar dz = z-pz[i];
+		squareMotion[i] = dx*dx+dy*dy+dz*dz;
+		m_predictedTransform[i].getOrigin().setValue(x,y,z);
+	}
+
+	const btScalar* qx = &m_orientation[0][0];
+	const btScalar* qy = &m_orientation[1][0];
+	const btScalar* qz = &m_orientation[2][0];
+	const btScalar* qw = &m_orientation[3][0];
+	const btScalar* dqx = &m_deltaOrientation[0][0];
+	const btScalar* dqy = &m_deltaOrientation[1][0];
+	const btScalar* dqz = &m_deltaOrientation[2][0];
+	const btScalar* dqw = &m_deltaOrientation[3][0];
+	for (i=iBegin;i<iEnd;i++)
+	{
+		//predictedOrn = dorn * orn0, normalized
+		btScalar x = dqw[i] * qx[i] + dqx[i] * qw[i] + dqy[i] * qz[i] - dqz[i] * qy[i];
+		btScalar y = dqw[i] * qy[i] + dqy[i] * qw[i] + dqz[i] * qx[i] - dqx[i] * qz[i];
+		btScalar z = dqw[i] * qz[i] + dqz[i] * qw[i] + dqx[i] * qy[i] - dqy[i] * qx[i];
+		btScalar w = dqw[i] * qw[i] - dqx[i] * qx[i] - dqy[i] * qy[i] - dqz[i] * qz[i];
+		const btScalar invLength = btScalar(1.0) / btSqrt(x*x+y*y+z*z+w*w);
+		x *= invLength;
+		y *= invLength;
+		z *= invLength;
+		w *= invLength;
+
+		//btMatrix3x3::setRotation
+		const btScalar s = btScalar(2.0) / (x*x+y*y+z*z+w*w);
+		const btScalar xs = x * s,   ys = y * s,   zs = z * s;
+		const btScalar wx = w * xs,  wy = w * ys,  wz = w * zs;
+		const btScalar xx = x * xs,  xy = x * ys,  xz = x * zs;
+		const btScalar yy = y * ys,  yz = y * zs,  zz = z * zs;
+		m_predictedTransform[i].getBasis().setValue(
+			btScalar(1.0) - (yy + zz), xy - wz, xz + wy,
+			xy + wz, btScalar(1.0) - (xx + zz), yz - wx,
+			xz - wy, yz + wx, btScalar(1.0) - (xx + yy));
+	}
+}
+
+///updateInertiaTensors is btRigidBody::updateInertiaTensor of the integrated basis
+void	btRigidBodyStateArray::updateInertiaTensors(int iBegin, int iEnd)
+{
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		const btMatrix3x3& basis = m_predictedTransform[i].getBasis();
+		btVector3 invInertiaLocal(m_invInertiaLocal[0][i],m_invInertiaLocal[1][i],m_invInertiaLocal[2][i]);
+		m_invInertiaTensorWorld[i] = basis.scaled(invInertiaLocal) * basis.transpose();
+	}
+}
+
+void	btRigidBodyStateArray::predictUnconstraintMotion(int iBegin, int iEnd, btScalar timeStep)
+{
+	btAssert(timeStep==m_dampingTimeStep);
+	loadStaleRows(iBegin,iEnd);
+	int i;
+	for (i=iBegin;i<iEnd;i++)
+	{
+		if (m_additionalDamping[i])
+		{
+			m_bodies[i]->applyDamping(timeStep);
+			loadRow(i);
+		}
+	}
+	loadTransforms(iBegin,iEnd);
+	applyDamping(iBegin,iEnd);
+	integrate(iBegin,iEnd,timeStep);
+	for (i=iBegin;i<iEnd;i++)
+	{
+		getTransform(i,m_bodies[i]->m_interpolationWorldTransform);
+	}
+	markArrayNewer(iBegin,iEnd);
+}
+
+void	btRigidBodyStateArray::integrateTransforms(int iBegin, int iEnd, btScalar timeStep)
+{
+	loadStaleRows(iBegin,iEnd);
+	loadTransforms(iBegin,iEnd);
+	integrate(iBegin,iEnd,timeStep);
+	updateInertiaTensors(iBegin,iEnd);
+}
+
+void	btRigidBodyStateArray::getTransform(int index, btTransform& trans) const
+{
+	trans = m_predictedTransform[index];
+}
+
+void	btRigidBodyStateArray::proceedToTransform(int index)
+{
+	btRigidBody* body = m_bodies[index];
+	btAssert(!body->isKinematicObject());
+	const btTransform& trans = m_predictedTransform[index];
+	body->m_worldTransform = trans;
+	body->m_interpolationWorldTransform = trans;
+	body->m_interpolationLinearVelocity.setValue(m_linearVelocity[0][index],m_linearVelocity[1][index],m_linearVelocity[2][index]);
+	body->m_interpolationAngularVelocity.setValue(m_angularVelocity[0][index],m_angularVelocity[1][index],m_angularVelocity[2][index]);
+	body->m_invInertiaTensorWorld = m_invInertiaTensorWorld[index];
+
+	///the next pass finds the basis unchanged and keeps the orientation, which btTransformUtil::integrateTransform would get from the basis
+	btQuaternion orn;
+	trans.getBasis().getRotation(orn);
+	m_position[0][index] = trans.getOrigin().x();
+	m_position[1][index] = trans.getOrigin().y();
+	m_position[2][index] = trans.getOrigin().z();
+	m_basis[index] = trans.getBasis();
+	m_orientation[0][index] = orn.x();
+	m_orientation[1][index] = orn.y();
+	m_orientation[2][index] = orn.z();
+	m_orientation[3][index] = orn.w();
+}
@@ -0,0 +1,192 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RIGID_BODY_STATE_ARRAY_H
+#define BT_RIGID_BODY_STATE_ARRAY_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btTransform.h"
+
+class btRigidBody;
+
+///btRigidBodyStateArray keeps the state that the unconstrained integration passes touch in packed structure-of-arrays form, so the
+///arithmetic runs over contiguous arrays instead of hopping between btRigidBody objects. A body gets a row when it is added and keeps it
+///until it is removed. The velocities and the accumulated forces live in the rows: a btRigidBody accessor copies them back to the body
+///when a pass changed them (storeRow), and a body that changes them, or the gravity, damping, linear factor or inverse inertia packed
+///with them, marks its row stale so the next pass loads it again. The transform stays on the body, because collision detection reads it,
+///the rows keep the orientation quaternion of the last transform they wrote and only recompute it when the body transform changed.
+///The rows are ordered active dynamic bodies first, then sleeping dynamic bodies, then static and kinematic bodies.
+///The results match btRigidBody::applyGravity, applyDamping, updateDeactivation and btTransformUtil::integrateTransform.
+///Ranges of rows can be processed concurrently.
+class btRigidBodyStateArray
+{
+public:
+
+	enum	btRowSync
+	{
+		BT_ROW_SYNCED=0,
+		///a pass changed the row, the body copy is out of date
+		BT_ROW_ARRAY_NEWER,
+		///the body changed, the row is out of date
+		BT_ROW_BODY_NEWER
+	};
+
+private:
+
+	btAlignedObjectArray<btRigidBody*>	m_bodies;
+	btAlignedObjectArray<int>	m_sync;
+	btAlignedObjectArray<int>	m_group;
+	int		m_numActive;
+	int		m_numDynamic;
+
+	btAlignedObjectArray<btScalar>	m_linearVelocity[3];
+	btAlignedObjectArray<btScalar>	m_angularVelocity[3];
+	btAlignedObjectArray<btScalar>	m_totalForce[3];
+	btAlignedObjectArray<btScalar>	m_totalTorque[3];
+
+	///m_gravity is the gravity force times the linear factor, what btRigidBody::applyGravity adds to the total force
+	btAlignedObjectArray<btScalar>	m_gravity[3];
+	btAlignedObjectArray<btScalar>	m_invInertiaLocal[3];
+	btAlignedObjectArray<btScalar>	m_linearDamping;
+	btAlignedObjectArray<btScalar>	m_angularDamping;
+	///m_linearDampingFactor and m_angularDampingFactor are the damping over m_dampingTimeStep, 1 for bodies with additional damping
+	btAlignedObjectArray<btScalar>	m_linearDampingFactor;
+	btAlignedObjectArray<btScalar>	m_angularDampingFactor;
+	btAlignedObjectArray<int>	m_additionalDamping;
+	btScalar	m_dampingTimeStep;
+
+	///m_basis is the basis of the body transform that m_orientation was computed from
+	btAlignedObjectArray<btScalar>	m_position[3];
+	btAlignedObjectArray<btScalar>	m_orientation[4];
+	btAlignedObjectArray<btMatrix3x3>	m_basis;
+
+	///the integrated transforms, m_squareMotion is the squared distance between the current and the integrated position,
+	///used for the ccd motion threshold. The matrices are written and read whole per body, so they are not split into arrays
+	btAlignedObjectArray<btTransform>	m_predictedTransform;
+	btAlignedObjectArray<btScalar>	m_squareMotion;
+	btAlignedObjectArray<btMatrix3x3>	m_invInertiaTensorWorld;
+	///m_deltaOrientation is the exponential map of the angular velocity, kept apart so the loops without btSin/btCos vectorize
+	btAlignedObjectArray<btScalar>	m_deltaOrientation[4];
+
+	void	resize(int numRows);
+	void	swapRows(int a, int b);
+	void	loadRow(int index);
+	void	loadTransform(int index);
+	void	loadStaleRows(int iBegin, int iEnd);
+	void	loadTransforms(int iBegin, int iEnd);
+	void	applyDamping(int iBegin, int iEnd);
+	void	integrate(int iBegin, int iEnd, btScalar timeStep);
+	void	updateInertiaTensors(int iBegin, int iEnd);
+	void	markArrayNewer(int iBegin, int iEnd);
+
+public:
+
+	btRigidBodyStateArray();
+
+	~btRigidBodyStateArray();
+
+	int		size() const
+	{
+		return m_bodies.size();
+	}
+
+	///addBody gives the body a row and loads it, removeBody stores the row in the body before removing it
+	void	addBody(btRigidBody* body);
+
+	void	removeBody(btRigidBody* body);
+
+	btRigidBody*	getBody(int index) const
+	{
+		return m_bodies[index];
+	}
+
+	///storeRow copies the velocities and forces of a row that a pass changed back to its body
+	void	storeRow(int index);
+
+	bool	isArrayNewer(int index) const
+	{
+		return m_sync[index]==BT_ROW_ARRAY_NEWER;
+	}
+
+	///setBodyNewer stores the row if needed and marks it stale, call it before the body changes the packed state
+	void	setBodyNewer(int index)
+	{
+		if (m_sync[index]==BT_ROW_ARRAY_NEWER)
+			storeRow(index);
+		m_sync[index] = BT_ROW_BODY_NEWER;
+	}
+
+	bool	hasBody(const btRigidBody* body) const;
+
+	///findRow returns the row of a body in this array
+	int		findRow(const btRigidBody* body) const;
+
+	///setVelocity writes the velocities of a synced row along with the body, so a velocity change doesn't force a reload
+	void	setVelocity(int index, const btVector3& linearVelocity, const btVector3& angularVelocity)
+	{
+		btAssert(m_sync[index]!=BT_ROW_ARRAY_NEWER);
+		for (int j=0;j<3;j++)
+		{
+			m_linearVelocity[j][index] = linearVelocity[j];
+			m_angularVelocity[j][index] = angularVelocity[j];
+		}
+	}
+
+	///updateRows orders the rows by activation state, call it before a pass because the islands and the user change the activation states
+	void	updateRows();
+
+	///setTimeStep recomputes the damping factors when the time step changed, call it before predictUnconstraintMotion
+	void	setTimeStep(btScalar timeStep);
+
+	///the active dynamic bodies are rows [0,getNumActive()), the sleeping dynamic bodies follow up to getNumDynamic()
+	int		getNumActive() const
+	{
+		return m_numActive;
+	}
+
+	int		getNumDynamic() const
+	{
+		return m_numDynamic;
+	}
+
+	///applyGravity is btRigidBody::applyGravity for the active dynamic bodies
+	void	applyGravity();
+
+	///clearForces is btRigidBody::clearForces for all bodies
+	void	clearForces();
+
+	///updateActivationState is btDiscreteDynamicsWorld::updateActivationState for all bodies
+	void	updateActivationState(btScalar timeStep);
+
+	///predictUnconstraintMotion applies damping to rows [iBegin,iEnd) and stores their predicted interpolation world transforms
+	void	predictUnconstraintMotion(int iBegin, int iEnd, btScalar timeStep);
+
+	///integrateTransforms computes the integrated transforms and world inverse inertia tensors of rows [iBegin,iEnd),
+	///use getSquareMotion/getTransform for ccd and proceedToTransform to store the result
+	void	integrateTransforms(int iBegin, int iEnd, btScalar timeStep);
+
+	btScalar	getSquareMotion(int index) const
+	{
+		return m_squareMotion[index];
+	}
+
+	///getTransform returns the integrated transform
+	void	getTransform(int index, btTransform& trans) const;
+
+	///proceedToTransform is btRigidBody::proceedToTransform with the integrated transform and the inertia tensor computed by integrateTransforms
+	void	proceedToTransform(int index);
+};
+
+#endif //BT_RIGID_BODY_STATE_ARRAY_H
@@ -0,0 +1,638 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRaycastVehicleFleet.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btQuaternion.h"
+#include "LinearMath/btMinMax.h"
+#include "LinearMath/btIDebugDraw.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
+
+///number of vehicles updated by one task of btParallelFor
+#define BT_VEHICLE_FLEET_GRAIN_SIZE 32
+
+template <typename T>
+static void btEraseRange(btAlignedObjectArray<T>& array, int first, int count)
+{
+	for (int i=first+count;i<array.size();i++)
+	{
+		array[i-count] = array[i];
+	}
+	//pop_back doesn't construct a fill value, resize would for types like btTransform
+	for (int i=0;i<count;i++)
+	{
+		array.pop_back();
+	}
+}
+
+//spreads the 10 low bits of v over every third bit
+static unsigned int btExpandBits10(unsigned int v)
+{
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+struct btVehicleSortKeyPredicate
+{
+	template <typename SortKey>
+	bool operator() (const SortKey& a, const SortKey& b) const
+	{
+		return a.m_key < b.m_key || (a.m_key == b.m_key && a.m_vehicle < b.m_vehicle);
+	}
+};
+
+struct btPrepareVehiclesLoop : public btIParallelForBody
+{
+	btRaycastVehicleFleet*	m_fleet;
+	bool	m_castRays;
+
+	btPrepareVehiclesLoop(btRaycastVehicleFleet* fleet, bool castRays)
+		:m_fleet(fleet),
+		m_castRays(castRays)
+	{
+	}
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		m_fleet->prepareVehicles(iBegin,iEnd,m_castRays);
+	}
+};
+
+struct btUpdateVehiclesLoop : public btIParallelForBody
+{
+	btRaycastVehicleFleet*	m_fleet;
+	btScalar	m_step;
+
+	btUpdateVehiclesLoop(btRaycastVehicleFleet* fleet, btScalar step)
+		:m_fleet(fleet),
+		m_step(step)
+	{
+	}
+
+	void	forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("updateVehiclesTask");
+		m_fleet->updateVehicles(iBegin,iEnd,m_step);
+	}
+};
+
+
+btRaycastVehicleFleet::btRaycastVehicleFleet()
+:m_indexRightAxis(0),
+m_indexUpAxis(2),
+m_indexForwardAxis(1),
+m_rayFilterGroup(btBroadphaseProxy::DefaultFilter),
+m_rayFilterMask(btBroadphaseProxy::AllFilter)
+{
+	m_firstWheel.push_back(0);
+}
+
+btRaycastVehicleFleet::~btRaycastVehicleFleet()
+{
+}
+
+int	btRaycastVehicleFleet::addVehicle(btRigidBody* chassis)
+{
+	m_chassis.push_back(chassis);
+	m_speedKmHour.push_back(btScalar(0.));
+	m_rayOffset.push_back(-1);
+	m_firstWheel.push_back(m_firstWheel[m_firstWheel.size()-1]);
+	return m_chassis.size()-1;
+}
+
+void	btRaycastVehicleFleet::removeVehicle(int vehicle)
+{
+	btAssert(vehicle>=0 && vehicle<getNumVehicles());
+	int first = m_firstWheel[vehicle];
+	int count = getNumWheels(vehicle);
+
+	btEraseRange(m_chassisConnectionCS,first,count);
+	btEraseRange(m_wheelDirectionCS,first,count);
+	btEraseRange(m_wheelAxleCS,first,count);
+	btEraseRange(m_suspensionRestLength,first,count);
+	btEraseRange(m_maxSuspensionTravel,first,count);
+	btEraseRange(m_wheelRadius,first,count);
+	btEraseRange(m_suspensionStiffness,first,count);
+	btEraseRange(m_dampingCompression,first,count);
+	btEraseRange(m_dampingRelaxation,first,count);
+	btEraseRange(m_frictionSlip,first,count);
+	btEraseRange(m_maxSuspensionForce,first,count);
+	btEraseRange(m_rollInfluence,first,count);
+	btEraseRange(m_isFrontWheel,first,count);
+	btEraseRange(m_steering,first,count);
+	btEraseRange(m_engineForce,first,count);
+	btEraseRange(m_brake,first,count);
+	btEraseRange(m_worldTransform,first,count);
+	btEraseRange(m_hardPointWS,first,count);
+	btEraseRange(m_wheelDirectionWS,first,count);
+	btEraseRange(m_contactPointWS,first,count);
+	btEraseRange(m_contactNormalWS,first,count);
+	btEraseRange(m_forwardWS,first,count);
+	btEraseRange(m_axleWS,first,count);
+	btEraseRange(m_groundObject,first,count);
+	btEraseRange(m_isInContact,first,count);
+	btEraseRange(m_suspensionLength,first,count);
+	btEraseRange(m_suspensionRelativeVelocity,first,count);
+	btEraseRange(m_clippedInvContactDotSuspension,first,count);
+	btEraseRange(m_chassisMass,first,count);
+	btEraseRange(m_suspensionForce,first,count);
+	btEraseRange(m_sideVelocity,first,count);
+	btEraseRange(m_sideDenominator,first,count);
+	btEraseRange(m_forwardVelocity,first,count);
+	btEraseRange(m_forwardDenominator,first,count);
+	btEraseRange(m_forwardImpulse,first,count);
+	btEraseRange(m_sideImpulse,first,count);
+	btEraseRange(m_skidInfo,first,count);
+	btEraseRange(m_rotation,first,count);
+	btEraseRange(m_deltaRotation,first,count);
+
+	btEraseRange(m_chassis,vehicle,1);
+	btEraseRange(m_speedKmHour,vehicle,1);
+	btEraseRange(m_rayOffset,vehicle,1);
+	btEraseRange(m_firstWheel,vehicle,1);
+	for (int v=vehicle;v<m_firstWheel.size();v++)
+	{
+		m_firstWheel[v] -= count;
+	}
+}
+
+int	btRaycastVehicleFleet::addWheel(int vehicle, const btVector3& connectionPointCS0, const btVector3& wheelDirectionCS0, const btVector3& wheelAxleCS, btScalar suspensionRestLength, btScalar wheelRadius, const btRaycastVehicle::btVehicleTuning& tuning, bool isFrontWheel)
+{
+	//the wheels of a vehicle are adjacent, so only the last vehicle can get more
+	btAssert(vehicle==getNumVehicles()-1);
+
+	m_chassisConnectionCS.push_back(connectionPointCS0);
+	m_wheelDirectionCS.push_back(wheelDirectionCS0);
+	m_wheelAxleCS.push_back(wheelAxleCS);
+	m_suspensionRestLength.push_back(suspensionRestLength);
+	m_maxSuspensionTravel.push_back(tuning.m_maxSuspensionTravelCm*btScalar(0.01));
+	m_wheelRadius.push_back(wheelRadius);
+	m_suspensionStiffness.push_back(tuning.m_suspensionStiffness);
+	m_dampingCompression.push_back(tuning.m_suspensionCompression);
+	m_dampingRelaxation.push_back(tuning.m_suspensionDamping);
+	m_frictionSlip.push_back(tuning.m_frictionSlip);
+	m_maxSuspensionForce.push_back(tuning.m_maxSuspensionForce);
+	m_rollInfluence.push_back(btScalar(0.1));
+	m_isFrontWheel.push_back(isFrontWheel ? 1 : 0);
+
+	m_steering.push_back(btScalar(0.));
+	m_engineForce.push_back(btScalar(0.));
+	m_brake.push_back(btScalar(0.));
+
+	const btVector3 zero(btScalar(0.),btScalar(0.),btScalar(0.));
+	m_worldTransform.push_back(btTransform::getIdentity());
+	m_hardPointWS.push_back(zero);
+	m_wheelDirectionWS.push_back(zero);
+	m_contactPointWS.push_back(zero);
+	m_contactNormalWS.push_back(zero);
+	m_forwardWS.push_back(zero);
+	m_axleWS.push_back(zero);
+	m_groundObject.push_back(0);
+	m_isInContact.push_back(0);
+	m_suspensionLength.push_back(suspensionRestLength);
+	m_suspensionRelativeVelocity.push_back(btScalar(0.));
+	m_clippedInvContactDotSuspension.push_back(btScalar(1.));
+	m_chassisMass.push_back(btScalar(0.));
+	m_suspensionForce.push_back(btScalar(0.));
+	m_sideVelocity.push_back(btScalar(0.));
+	m_sideDenominator.push_back(btScalar(1.));
+	m_forwardVelocity.push_back(btScalar(0.));
+	m_forwardDenominator.push_back(btScalar(1.));
+	m_forwardImpulse.push_back(btScalar(0.));
+	m_sideImpulse.push_back(btScalar(0.));
+	m_skidInfo.push_back(btScalar(1.));
+	m_rotation.push_back(btScalar(0.));
+	m_deltaRotation.push_back(btScalar(0.));
+
+	m_firstWheel[vehicle+1]++;
+	prepareVehicles(vehicle,vehicle+1,false);
+	return getNumWheels(vehicle)-1;
+}
+
+int	btRaycastVehicleFleet::sortRays()
+{
+	m_sortKeys.resize(0);
+	btVector3 aabbMin(BT_LARGE_FLOAT,BT_LARGE_FLOAT,BT_LARGE_FLOAT);
+	btVector3 aabbMax(-BT_LARGE_FLOAT,-BT_LARGE_FLOAT,-BT_LARGE_FLOAT);
+	for (int v=0;v<m_chassis.size();v++)
+	{
+		m_rayOffset[v] = -1;
+		if (m_chassis[v]->isActive() && getNumWheels(v))
+		{
+			const btVector3& origin = m_chassis[v]->getCenterOfMassPosition();
+			aabbMin.setMin(origin);
+			aabbMax.setMax(origin);
+			SortKey key;
+			key.m_key = 0;
+			key.m_vehicle = v;
+			m_sortKeys.push_back(key);
+		}
+	}
+	if (!m_sortKeys.size())
+	{
+		return 0;
+	}
+
+	//morton order of the chassis positions, quantized to 10 bits per axis
+	btVector3 extents = aabbMax-aabbMin;
+	btVector3 quantization(btScalar(1023.)/btMax(extents.x(),SIMD_EPSILON),
+		btScalar(1023.)/btMax(extents.y(),SIMD_EPSILON),
+		btScalar(1023.)/btMax(extents.z(),SIMD_EPSILON));
+	for (int i=0;i<m_sortKeys.size();i++)
+	{
+		btVector3 q = (m_chassis[m_sortKeys[i].m_vehicle]->getCenterOfMassPosition()-aabbMin)*quantization;
+		m_sortKeys[i].m_key = btExpandBits10((unsigned int)q.x()) | (btExpandBits10((unsigned int)q.y())<<1) | (btExpandBits10((unsigned int)q.z())<<2);
+	}
+	m_sortKeys.quickSort(btVehicleSortKeyPredicate());
+
+	m_rayOrder.resize(m_sortKeys.size());
+	int numRays = 0;
+	for (int i=0;i<m_sortKeys.size();i++)
+	{
+		int v = m_sortKeys[i].m_vehicle;
+		m_rayOrder[i] = v;
+		m_rayOffset[v] = numRays;
+		numRays += getNumWheels(v);
+	}
+	m_rayFrom.resize(numRays);
+	m_rayTo.resize(numRays);
+	m_rayResults.resize(numRays);
+	return numRays;
+}
+
+void	btRaycastVehicleFleet::prepareVehicles(int vehicleBegin, int vehicleEnd, bool castRays)
+{
+	for (int v=vehicleBegin;v<vehicleEnd;v++)
+	{
+		if (castRays && m_rayOffset[v]<0)
+		{
+			continue;
+		}
+		const btRigidBody* chassis = m_chassis[v];
+		const btTransform& chassisTrans = chassis->getCenterOfMassTransform();
+		const btMatrix3x3& chassisBasis = chassisTrans.getBasis();
+
+		if (castRays)
+		{
+			btScalar speed = btScalar(3.6) * chassis->getLinearVelocity().length();
+			btVector3 forwardW = chassisBasis.getColumn(m_indexForwardAxis);
+			m_speedKmHour[v] = forwardW.dot(chassis->getLinearVelocity()) < btScalar(0.) ? -speed : speed;
+		}
+
+		int firstWheel = m_firstWheel[v];
+		for (int w=firstWheel;w<m_firstWheel[v+1];w++)
+		{
+			btVector3 hardPoint = chassisTrans(m_chassisConnectionCS[w]);
+			btVector3 wheelDirection = chassisBasis * m_wheelDirectionCS[w];
+			btVector3 right = chassisBasis * m_wheelAxleCS[w];
+			m_hardPointWS[w] = hardPoint;
+			m_wheelDirectionWS[w] = wheelDirection;
+
+			//same as btRaycastVehicle::updateWheelTransform, using the suspension length of the last step
+			btVector3 up = -wheelDirection;
+			btVector3 fwd = up.cross(right);
+			fwd.normalize();
+			btMatrix3x3 steeringMat(btQuaternion(up,m_steering[w]));
+			btMatrix3x3 rotatingMat(btQuaternion(right,-m_rotation[w]));
+			btMatrix3x3 basis2(
+				right[0],fwd[0],up[0],
+				right[1],fwd[1],up[1],
+				right[2],fwd[2],up[2]
+			);
+			m_worldTransform[w].setBasis(steeringMat * rotatingMat * basis2);
+			m_worldTransform[w].setOrigin(hardPoint + wheelDirection * m_suspensionLength[w]);
+
+			if (castRays)
+			{
+				btScalar rayLength = m_suspensionRestLength[w]+m_wheelRadius[w];
+				int ray = m_rayOffset[v]+w-firstWheel;
+				m_rayFrom[ray] = hardPoint;
+				m_rayTo[ray] = hardPoint + wheelDirection * rayLength;
+				m_contactPointWS[w] = m_rayTo[ray];
+			}
+		}
+	}
+}
+
+///the friction impulses of the wheels wheelBegin..wheelEnd-1, as btRaycastVehicle::updateFriction, from the velocities and
+///impulse denominators gathered by updateVehicles. It is branch free over the wheel arrays, so the compiler can vectorize it.
+void	btRaycastVehicleFleet::computeFrictionImpulses(int wheelBegin, int wheelEnd, btScalar step)
+{
+	if (wheelBegin>=wheelEnd)
+		return;
+	const unsigned char* isInContact = &m_isInContact[0];
+	const btScalar* sideVelocity = &m_sideVelocity[0];
+	const btScalar* sideDenominator = &m_sideDenominator[0];
+	const btScalar* forwardVelocity = &m_forwardVelocity[0];
+	const btScalar* forwardDenominator = &m_forwardDenominator[0];
+	const btScalar* engineForce = &m_engineForce[0];
+	const btScalar* brake = &m_brake[0];
+	const btScalar* suspensionForce = &m_suspensionForce[0];
+	const btScalar* frictionSlip = &m_frictionSlip[0];
+	btScalar* sideImpulse = &m_sideImpulse[0];
+	btScalar* forwardImpulse = &m_forwardImpulse[0];
+	btScalar* skidInfo = &m_skidInfo[0];
+	for (int w=wheelBegin;w<wheelEnd;w++)
+	{
+		//resolveSingleBilateral with a fixed second body
+		btScalar side = btScalar(-0.2) * sideVelocity[w] / sideDenominator[w];
+
+		//switch between active rolling (throttle), braking and non-active rolling friction (no throttle/break)
+		btScalar maxImpulse = brake[w];
+		btScalar rollingFriction = -forwardVelocity[w] / forwardDenominator[w];
+		rollingFriction = btMax(btMin(rollingFriction, maxImpulse), -maxImpulse);
+		rollingFriction = engineForce[w] != btScalar(0.) ? engineForce[w] * step : rollingFriction;
+
+		btScalar maximp = suspensionForce[w] * step * frictionSlip[w];
+		btScalar x = rollingFriction * btScalar(0.5);
+		btScalar impulseSquared = x*x + side*side;
+		btScalar skid = impulseSquared > maximp*maximp ? maximp / btSqrt(impulseSquared) : btScalar(1.);
+
+		sideImpulse[w] = isInContact[w] ? side : btScalar(0.);
+		forwardImpulse[w] = isInContact[w] ? rollingFriction : btScalar(0.);
+		skidInfo[w] = isInContact[w] ? skid : btScalar(1.);
+	}
+}
+
+void	btRaycastVehicleFleet::updateVehicles(int vehicleBegin, int vehicleEnd, btScalar step)
+{
+	//ray results, as btRaycastVehicle::rayCast
+	for (int v=vehicleBegin;v<vehicleEnd;v++)
+	{
+		if (m_rayOffset[v]<0)
+		{
+			continue;
+		}
+		const btRigidBody* chassis = m_chassis[v];
+		const btVector3& centerOfMass = chassis->getCenterOfMassPosition();
+		btScalar chassisMass = btScalar(1.) / chassis->getInvMass();
+		int firstWheel = m_firstWheel[v];
+		for (int w=firstWheel;w<m_firstWheel[v+1];w++)
+		{
+			const btCollisionWorld::BatchedQueryResult& result = m_rayResults[m_rayOffset[v]+w-firstWheel];
+			const btRigidBody* body = result.m_collisionObject ? btRigidBody::upcast(result.m_collisionObject) : 0;
+			m_chassisMass[w] = chassisMass;
+			if (body && body->hasContactResponse())
+			{
+				btScalar rayLength = m_suspensionRestLength[w]+m_wheelRadius[w];
+				btVector3 normal = result.m_hitNormalWorld.normalized();
+				m_contactNormalWS[w] = normal;
+				m_contactPointWS[w] = result.m_hitPointWorld;
+				m_isInContact[w] = 1;
+				m_groundObject[w] = result.m_collisionObject;
+
+				//clamp on max suspension travel
+				btScalar suspensionLength = result.m_hitFraction*rayLength - m_wheelRadius[w];
+				btScalar minSuspensionLength = m_suspensionRestLength[w] - m_maxSuspensionTravel[w];
+				btScalar maxSuspensionLength = m_suspensionRestLength[w] + m_maxSuspensionTravel[w];
+				m_suspensionLength[w] = btMin(btMax(suspensionLength,minSuspensionLength),maxSuspensionLength);
+
+				btScalar denominator = normal.dot(m_wheelDirectionWS[w]);
+				btVector3 chassisVelocity = chassis->getVelocityInLocalPoint(result.m_hitPointWorld-centerOfMass);
+				btScalar projVel = normal.dot(chassisVelocity);
+				if (denominator >= btScalar(-0.1))
+				{
+					m_suspensionRelativeVelocity[w] = btScalar(0.0);
+					m_clippedInvContactDotSuspension[w] = btScalar(1.0) / btScalar(0.1);
+				} else
+				{
+					btScalar inv = btScalar(-1.) / denominator;
+					m_suspensionRelativeVelocity[w] = projVel * inv;
+					m_clippedInvContactDotSuspension[w] = inv;
+				}
+			} else
+			{
+				//put wheel info as in rest position
+				m_isInContact[w] = 0;
+				m_groundObject[w] = 0;
+				m_suspensionLength[w] = m_suspensionRestLength[w];
+				m_suspensionRelativeVelocity[w] = btScalar(0.0);
+				m_contactNormalWS[w] = -m_wheelDirectionWS[w];
+				m_clippedInvContactDotSuspension[w] = btScalar(1.0);
+			}
+		}
+	}
+
+	//suspension forces of all wheels of the range, as btRaycastVehicle::updateSuspension.
+	//The state of sleeping vehicles didn't change, so it gives them the same forces again.
+	{
+		const int wheelBegin = m_firstWheel[vehicleBegin];
+		const int wheelEnd = m_firstWheel[vehicleEnd];
+		const unsigned char* isInContact = &m_isInContact[0];
+		const btScalar* restLength = &m_suspensionRestLength[0];
+		const btScalar* suspensionLength = &m_suspensionLength[0];
+		const btScalar* stiffness = &m_suspensionStiffness[0];
+		const btScalar* clippedInvContactDotSuspension = &m_clippedInvContactDotSuspension[0];
+		const btScalar* relativeVelocity = &m_suspensionRelativeVelocity[0];
+		const btScalar* dampingCompression = &m_dampingCompression[0];
+		const btScalar* dampingRelaxation = &m_dampingRelaxation[0];
+		const btScalar* chassisMass = &m_chassisMass[0];
+		btScalar* suspensionForce = &m_suspensionForce[0];
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			btScalar damping = relativeVelocity[w] < btScalar(0.) ? dampingCompression[w] : dampingRelaxation[w];
+			btScalar force = stiffness[w] * (restLength[w]-suspensionLength[w]) * clippedInvContactDotSuspension[w] - damping * relativeVelocity[w];
+			force = btMax(force * chassisMass[w], btScalar(0.));
+			suspensionForce[w] = isInContact[w] ? force : btScalar(0.);
+		}
+	}
+
+	//suspension impulses, and the velocities along the friction directions of all wheels after them.
+	//Everything friction needs from the chassis is gathered here, so the friction impulses can be computed for the whole range at once.
+	for (int v=vehicleBegin;v<vehicleEnd;v++)
+	{
+		if (m_rayOffset[v]<0)
+		{
+			continue;
+		}
+		btRigidBody* chassis = m_chassis[v];
+		const btVector3& centerOfMass = chassis->getCenterOfMassPosition();
+		const int wheelBegin = m_firstWheel[v];
+		const int wheelEnd = m_firstWheel[v+1];
+
+		//apply suspension force
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			if (m_isInContact[w])
+			{
+				btScalar suspensionForce = btMin(m_suspensionForce[w],m_maxSuspensionForce[w]);
+				btVector3 impulse = m_contactNormalWS[w] * suspensionForce * step;
+				chassis->applyImpulse(impulse,m_contactPointWS[w]-centerOfMass);
+			}
+		}
+
+		//friction directions and chassis response, as btRaycastVehicle::updateFriction against a static ground
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			if (!m_isInContact[w])
+			{
+				continue;
+			}
+			const btVector3& surfNormalWS = m_contactNormalWS[w];
+			const btVector3& contactPoint = m_contactPointWS[w];
+			btVector3 axle = m_worldTransform[w].getBasis().getColumn(m_indexRightAxis);
+			axle -= surfNormalWS * axle.dot(surfNormalWS);
+			axle.normalize();
+			btVector3 forward = surfNormalWS.cross(axle);
+			forward.normalize();
+			m_axleWS[w] = axle;
+			m_forwardWS[w] = forward;
+
+			btVector3 relVelocity = chassis->getVelocityInLocalPoint(contactPoint - centerOfMass);
+			m_sideVelocity[w] = axle.dot(relVelocity);
+			m_sideDenominator[w] = chassis->computeImpulseDenominator(contactPoint,axle);
+			m_forwardVelocity[w] = forward.dot(relVelocity);
+			m_forwardDenominator[w] = chassis->computeImpulseDenominator(contactPoint,forward);
+		}
+	}
+
+	//friction impulses of the wheels of each run of active vehicles
+	for (int v=vehicleBegin;v<vehicleEnd;)
+	{
+		if (m_rayOffset[v]<0)
+		{
+			v++;
+			continue;
+		}
+		int runBegin = v;
+		while (v<vehicleEnd && m_rayOffset[v]>=0)
+		{
+			v++;
+		}
+		computeFrictionImpulses(m_firstWheel[runBegin],m_firstWheel[v],step);
+	}
+
+	//friction impulses and wheel rotation
+	for (int v=vehicleBegin;v<vehicleEnd;v++)
+	{
+		if (m_rayOffset[v]<0)
+		{
+			continue;
+		}
+		btRigidBody* chassis = m_chassis[v];
+		const btVector3& centerOfMass = chassis->getCenterOfMassPosition();
+		const btMatrix3x3& chassisBasis = chassis->getCenterOfMassTransform().getBasis();
+		const int wheelBegin = m_firstWheel[v];
+		const int wheelEnd = m_firstWheel[v+1];
+
+		bool sliding = false;
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			if (m_skidInfo[w] < btScalar(1.))
+			{
+				sliding = true;
+			}
+		}
+
+		if (sliding)
+		{
+			for (int w=wheelBegin;w<wheelEnd;w++)
+			{
+				if (m_sideImpulse[w] != btScalar(0.) && m_skidInfo[w] < btScalar(1.))
+				{
+					m_forwardImpulse[w] *= m_skidInfo[w];
+					m_sideImpulse[w] *= m_skidInfo[w];
+				}
+			}
+		}
+
+		btVector3 chassisUp = chassisBasis.getColumn(m_indexUpAxis);
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			btVector3 relPos = m_contactPointWS[w] - centerOfMass;
+			if (m_forwardImpulse[w] != btScalar(0.))
+			{
+				chassis->applyImpulse(m_forwardWS[w]*m_forwardImpulse[w],relPos);
+			}
+			if (m_sideImpulse[w] != btScalar(0.))
+			{
+				relPos -= chassisUp * (chassisUp.dot(relPos) * (btScalar(1.)-m_rollInfluence[w]));
+				chassis->applyImpulse(m_axleWS[w]*m_sideImpulse[w],relPos);
+			}
+		}
+
+		//wheel rotation
+		btVector3 chassisForward = chassisBasis.getColumn(m_indexForwardAxis);
+		for (int w=wheelBegin;w<wheelEnd;w++)
+		{
+			if (m_isInContact[w])
+			{
+				const btVector3& normal = m_contactNormalWS[w];
+				btVector3 fwd = chassisForward - normal * chassisForward.dot(normal);
+				btVector3 velocity = chassis->getVelocityInLocalPoint(m_hardPointWS[w] - centerOfMass);
+				m_deltaRotation[w] = (fwd.dot(velocity) * step) / m_wheelRadius[w];
+			}
+			m_rotation[w] += m_deltaRotation[w];
+			m_deltaRotation[w] *= btScalar(0.99);//damping of rotation when not in contact
+		}
+	}
+}
+
+void	btRaycastVehicleFleet::updateAction(btCollisionWorld* collisionWorld, btScalar step)
+{
+	BT_PROFILE("btRaycastVehicleFleet::updateAction");
+	int numRays = sortRays();
+	if (!numRays)
+	{
+		return;
+	}
+	{
+		btPrepareVehiclesLoop loop(this,true);
+		btParallelFor(0,getNumVehicles(),BT_VEHICLE_FLEET_GRAIN_SIZE,loop);
+	}
+
+	collisionWorld->rayTestBatch(&m_rayFrom[0],&m_rayTo[0],numRays,&m_rayResults[0],m_rayFilterGroup,m_rayFilterMask);
+
+	{
+		btUpdateVehiclesLoop loop(this,step);
+		btParallelFor(0,getNumVehicles(),BT_VEHICLE_FLEET_GRAIN_SIZE,loop);
+	}
+}
+
+void	btRaycastVehicleFleet::updateWheelTransforms()
+{
+	btPrepareVehiclesLoop loop(this,false);
+	btParallelFor(0,getNumVehicles(),BT_VEHICLE_FLEET_GRAIN_SIZE,loop);
+}
+
+void	btRaycastVehicleFleet::resetSuspension()
+{
+	for (int w=0;w<m_suspensionLength.size();w++)
+	{
+		m_suspensionLength[w] = m_suspensionRestLength[w];
+		m_suspensionRelativeVelocity[w] = btScalar(0.0);
+		m_contactNormalWS[w] = -m_wheelDirectionWS[w];
+		m_clippedInvContactDotSuspension[w] = btScalar(1.0);
+	}
+}
+
+void	btRaycastVehicleFleet::debugDraw(btIDebugDraw* debugDrawer)
+{
+	for (int w=0;w<m_worldTransform.size();w++)
+	{
+		btVector3 wheelColor = m_isInContact[w] ? btVector3(0,0,1) : btVector3(1,0,1);
+		const btVector3& wheelPosWS = m_worldTransform[w].getOrigin();
+		btVector3 axle = m_worldTransform[w].getBasis().getColumn(m_indexRightAxis);
+
+		//debug wheels (cylinders)
+		debugDrawer->drawLine(wheelPosWS,wheelPosWS+axle,wheelColor);
+		debugDrawer->drawLine(wheelPosWS,m_contactPointWS[w],wheelColor);
+	}
+}
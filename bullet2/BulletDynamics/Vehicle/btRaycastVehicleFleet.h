@@ -0,0 +1,278 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RAYCAST_VEHICLE_FLEET_H
+#define BT_RAYCAST_VEHICLE_FLEET_H
+
+#include "BulletDynamics/Dynamics/btActionInterface.h"
+#include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btTransform.h"
+#include "btRaycastVehicle.h"
+
+class btRigidBody;
+
+///btRaycastVehicleFleet simulates many raycast vehicles with a single action, for traffic and crowds of cars.
+///The wheels of all vehicles are stored as arrays of their properties, the wheels of a vehicle are adjacent.
+///Each step casts the rays of all wheels with one btCollisionWorld::rayTestBatch call, ordered along a space filling curve
+///of the chassis positions so the packets are coherent. The wheel transforms, suspension and friction are updated for
+///groups of vehicles with btParallelFor.
+///The vehicle model matches btRaycastVehicle with a btDefaultVehicleRaycaster: the ground is treated as static and a hit
+///only counts for rigid bodies with contact response. Rays can hit other vehicles of the fleet, use setRayFilter to avoid that.
+///Vehicles with a deactivated chassis keep their wheel state and are skipped, activate the chassis after changing its controls.
+///Add the fleet to the world with btDynamicsWorld::addAction, the chassis bodies are added to the world as usual.
+///Each vehicle needs its own chassis, the vehicles apply their impulses from several threads.
+class btRaycastVehicleFleet : public btActionInterface
+{
+	//per vehicle
+	btAlignedObjectArray<btRigidBody*>	m_chassis;
+	btAlignedObjectArray<int>			m_firstWheel;	//m_firstWheel[v+1]-m_firstWheel[v] wheels, one more entry than vehicles
+	btAlignedObjectArray<btScalar>		m_speedKmHour;
+	btAlignedObjectArray<int>			m_rayOffset;	//index of the first ray of the vehicle in the batch
+	btAlignedObjectArray<int>			m_rayOrder;		//vehicles sorted by the space filling curve
+
+	//per wheel, constant
+	btAlignedObjectArray<btVector3>	m_chassisConnectionCS;
+	btAlignedObjectArray<btVector3>	m_wheelDirectionCS;
+	btAlignedObjectArray<btVector3>	m_wheelAxleCS;
+	btAlignedObjectArray<btScalar>	m_suspensionRestLength;
+	btAlignedObjectArray<btScalar>	m_maxSuspensionTravel;
+	btAlignedObjectArray<btScalar>	m_wheelRadius;
+	btAlignedObjectArray<btScalar>	m_suspensionStiffness;
+	btAlignedObjectArray<btScalar>	m_dampingCompression;
+	btAlignedObjectArray<btScalar>	m_dampingRelaxation;
+	btAlignedObjectArray<btScalar>	m_frictionSlip;
+	btAlignedObjectArray<btScalar>	m_maxSuspensionForce;
+	btAlignedObjectArray<btScalar>	m_rollInfluence;
+	btAlignedObjectArray<unsigned char>	m_isFrontWheel;
+
+	//per wheel, controls
+	btAlignedObjectArray<btScalar>	m_steering;
+	btAlignedObjectArray<btScalar>	m_engineForce;
+	btAlignedObjectArray<btScalar>	m_brake;
+
+	//per wheel, state
+	btAlignedObjectArray<btTransform>	m_worldTransform;
+	btAlignedObjectArray<btVector3>	m_hardPointWS;
+	btAlignedObjectArray<btVector3>	m_wheelDirectionWS;
+	btAlignedObjectArray<btVector3>	m_contactPointWS;
+	btAlignedObjectArray<btVector3>	m_contactNormalWS;
+	btAlignedObjectArray<btVector3>	m_forwardWS;
+	btAlignedObjectArray<btVector3>	m_axleWS;
+	btAlignedObjectArray<const btCollisionObject*>	m_groundObject;
+	btAlignedObjectArray<unsigned char>	m_isInContact;
+	btAlignedObjectArray<btScalar>	m_suspensionLength;
+	btAlignedObjectArray<btScalar>	m_suspensionRelativeVelocity;
+	btAlignedObjectArray<btScalar>	m_clippedInvContactDotSuspension;
+	btAlignedObjectArray<btScalar>	m_chassisMass;
+	btAlignedObjectArray<btScalar>	m_suspensionForce;
+	btAlignedObjectArray<btScalar>	m_sideVelocity;
+	btAlignedObjectArray<btScalar>	m_sideDenominator;
+	btAlignedObjectArray<btScalar>	m_forwardVelocity;
+	btAlignedObjectArray<btScalar>	m_forwardDenominator;
+	btAlignedObjectArray<btScalar>	m_forwardImpulse;
+	btAlignedObjectArray<btScalar>	m_sideImpulse;
+	btAlignedObjectArray<btScalar>	m_skidInfo;
+	btAlignedObjectArray<btScalar>	m_rotation;
+	btAlignedObjectArray<btScalar>	m_deltaRotation;
+
+	struct	SortKey
+	{
+		unsigned int	m_key;
+		int				m_vehicle;
+	};
+	btAlignedObjectArray<SortKey>	m_sortKeys;
+
+	//ray batch, in m_rayOrder
+	btAlignedObjectArray<btVector3>	m_rayFrom;
+	btAlignedObjectArray<btVector3>	m_rayTo;
+	btAlignedObjectArray<btCollisionWorld::BatchedQueryResult>	m_rayResults;
+
+	int	m_indexRightAxis;
+	int	m_indexUpAxis;
+	int	m_indexForwardAxis;
+	short int	m_rayFilterGroup;
+	short int	m_rayFilterMask;
+
+	///sortRays orders the active vehicles along the space filling curve and assigns their rays, vehicles with a sleeping chassis are skipped
+	int		sortRays();
+
+	void	prepareVehicles(int vehicleBegin, int vehicleEnd, bool castRays);
+	void	updateVehicles(int vehicleBegin, int vehicleEnd, btScalar step);
+	void	computeFrictionImpulses(int wheelBegin, int wheelEnd, btScalar step);
+
+	friend struct btPrepareVehiclesLoop;
+	friend struct btUpdateVehiclesLoop;
+
+public:
+
+	btRaycastVehicleFleet();
+
+	virtual ~btRaycastVehicleFleet();
+
+	///addVehicle adds a vehicle for an existing chassis and returns its index, wheels can only be added to the last vehicle
+	int		addVehicle(btRigidBody* chassis);
+
+	///removeVehicle removes a vehicle and its wheels, the vehicles after it move down by one index
+	void	removeVehicle(int vehicle);
+
+	///addWheel adds a wheel to the last vehicle and returns its index in the vehicle, the arguments are those of btRaycastVehicle::addWheel
+	int		addWheel(int vehicle, const btVector3& connectionPointCS0, const btVector3& wheelDirectionCS0, const btVector3& wheelAxleCS, btScalar suspensionRestLength, btScalar wheelRadius, const btRaycastVehicle::btVehicleTuning& tuning, bool isFrontWheel);
+
+	///btActionInterface interface
+	virtual void	updateAction(btCollisionWorld* collisionWorld, btScalar step);
+
+	///btActionInterface interface
+	virtual void	debugDraw(btIDebugDraw* debugDrawer);
+
+	///updateWheelTransforms computes the wheel transforms from the current chassis transforms, as btRaycastVehicle::updateWheelTransform
+	void	updateWheelTransforms();
+
+	void	resetSuspension();
+
+	int		getNumVehicles() const
+	{
+		return m_chassis.size();
+	}
+
+	int		getNumWheels(int vehicle) const
+	{
+		return m_firstWheel[vehicle+1]-m_firstWheel[vehicle];
+	}
+
+	btRigidBody*	getRigidBody(int vehicle)
+	{
+		return m_chassis[vehicle];
+	}
+
+	const btRigidBody*	getRigidBody(int vehicle) const
+	{
+		return m_chassis[vehicle];
+	}
+
+	///Velocity of vehicle (positive if velocity vector has same direction as foward vector), computed by updateAction
+	btScalar	getCurrentSpeedKmHour(int vehicle) const
+	{
+		return m_speedKmHour[vehicle];
+	}
+
+	void	setSteeringValue(btScalar steering, int vehicle, int wheel)
+	{
+		m_steering[m_firstWheel[vehicle]+wheel] = steering;
+	}
+
+	btScalar	getSteeringValue(int vehicle, int wheel) const
+	{
+		return m_steering[m_firstWheel[vehicle]+wheel];
+	}
+
+	void	applyEngineForce(btScalar force, int vehicle, int wheel)
+	{
+		m_engineForce[m_firstWheel[vehicle]+wheel] = force;
+	}
+
+	void	setBrake(btScalar brake, int vehicle, int wheel)
+	{
+		m_brake[m_firstWheel[vehicle]+wheel] = brake;
+	}
+
+	void	setRollInfluence(btScalar rollInfluence, int vehicle, int wheel)
+	{
+		m_rollInfluence[m_firstWheel[vehicle]+wheel] = rollInfluence;
+	}
+
+	const btTransform&	getWheelTransformWS(int vehicle, int wheel) const
+	{
+		return m_worldTransform[m_firstWheel[vehicle]+wheel];
+	}
+
+	bool	isWheelInContact(int vehicle, int wheel) const
+	{
+		return m_isInContact[m_firstWheel[vehicle]+wheel]!=0;
+	}
+
+	///the object hit by the ray of the wheel in the last step, 0 when the wheel is in the air
+	const btCollisionObject*	getWheelGroundObject(int vehicle, int wheel) const
+	{
+		return m_groundObject[m_firstWheel[vehicle]+wheel];
+	}
+
+	const btVector3&	getWheelContactPointWS(int vehicle, int wheel) const
+	{
+		return m_contactPointWS[m_firstWheel[vehicle]+wheel];
+	}
+
+	const btVector3&	getWheelContactNormalWS(int vehicle, int wheel) const
+	{
+		return m_contactNormalWS[m_firstWheel[vehicle]+wheel];
+	}
+
+	btScalar	getWheelSuspensionLength(int vehicle, int wheel) const
+	{
+		return m_suspensionLength[m_firstWheel[vehicle]+wheel];
+	}
+
+	btScalar	getWheelSuspensionForce(int vehicle, int wheel) const
+	{
+		return m_suspensionForce[m_firstWheel[vehicle]+wheel];
+	}
+
+	btScalar	getWheelSkidInfo(int vehicle, int wheel) const
+	{
+		return m_skidInfo[m_firstWheel[vehicle]+wheel];
+	}
+
+	btScalar	getWheelRotation(int vehicle, int wheel) const
+	{
+		return m_rotation[m_firstWheel[vehicle]+wheel];
+	}
+
+	bool	isFrontWheel(int vehicle, int wheel) const
+	{
+		return m_isFrontWheel[m_firstWheel[vehicle]+wheel]!=0;
+	}
+
+	///the coordinate system applies to all vehicles of the fleet, the default is the one of btRaycastVehicle
+	void	setCoordinateSystem(int rightIndex,int upIndex,int forwardIndex)
+	{
+		m_indexRightAxis = rightIndex;
+		m_indexUpAxis = upIndex;
+		m_indexForwardAxis = forwardIndex;
+	}
+
+	int		getRightAxis() const
+	{
+		return m_indexRightAxis;
+	}
+
+	int		getUpAxis() const
+	{
+		return m_indexUpAxis;
+	}
+
+	int		getForwardAxis() const
+	{
+		return m_indexForwardAxis;
+	}
+
+	///setRayFilter sets the collision filter group and mask of the wheel rays
+	void	setRayFilter(short int collisionFilterGroup, short int collisionFilterMask)
+	{
+		m_rayFilterGroup = collisionFilterGroup;
+		m_rayFilterMask = collisionFilterMask;
+	}
+};
+
+#endif //BT_RAYCAST_VEHICLE_FLEET_H
@@ -22,6 +22,26 @@ subject to the following restrictions:
 #include "bDefines.h"
 #include "LinearMath/btSerializer.h"
 
+#if defined (_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#define BT_BFILE_MMAP_WIN32
+#elif defined (__unix__) || defined (__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BT_BFILE_MMAP_POSIX
+#endif
+
+#if defined (_M_IX86) || defined (_M_X64) || defined (__i386__) || defined (__x86_64__)
+//chunk data in a file is only 4 byte aligned, which x86 accepts for any type
+#define BT_BFILE_IN_PLACE_ALIGNMENT 4
+#else
+#define BT_BFILE_IN_PLACE_ALIGNMENT 8
+#endif
+
 #define SIZEOFBLENDERHEADER 12
 #define MAX_ARRAY_LENGTH 512
 using namespace bParse;
@@ -31,14 +51,18 @@ using namespace bParse;
 int numallocs = 0;
 
 // ----------------------------------------------------- //
-bFile::bFile(const char *filename, const char headerString[7])
+bFile::bFile(const char *filename, const char headerString[7], bool memoryMap)
 	:	mOwnsBuffer(true),
 		mFileBuffer(0),
 		mFileLen(0),
 		mVersion(0),
+		mMemoryMapped(false),
+		mMappingHandle(0),
 		mDataStart(0),
 		mFileDNA(0),
 		mMemoryDNA(0),
+		mNumInPlaceChunks(0),
+		mInPlaceBytes(0),
 		mFlags(FD_INVALID)
 {
 	for (int i=0;i<7;i++)
@@ -46,6 +70,12 @@ bFile::bFile(const char *filename, const char headerString[7])
 		m_headerString[i] = headerString[i];
 	}
 
+	if (memoryMap && mapFile(filename))
+	{
+		parseHeader();
+		return;
+	}
+
 	FILE *fp = fopen(filename, "rb");
 	if (fp)
 	{
@@ -70,9 +100,13 @@ bFile::bFile( char *memoryBuffer, int len, const char headerString[7])
 	mFileBuffer(0),
 		mFileLen(0),
 		mVersion(0),
+		mMemoryMapped(false),
+		mMappingHandle(0),
 		mDataStart(0),
 		mFileDNA(0),
 		mMemoryDNA(0),
+		mNumInPlaceChunks(0),
+		mInPlaceBytes(0),
 		mFlags(FD_INVALID)
 {
 	for (int i=0;i<7;i++)
@@ -90,7 +124,10 @@ bFile::bFile( char *memoryBuffer, int len, const char headerString[7])
 // ----------------------------------------------------- //
 bFile::~bFile()
 {
-	if (mOwnsBuffer && mFileBuffer)
+	if (mMemoryMapped)
+	{
+		unmapFile();
+	} else if (mOwnsBuffer && mFileBuffer)
 	{
 		free(mFileBuffer);
 		mFileBuffer = 0;
@@ -105,6 +142,83 @@ bFile::~bFile()
 
 
 
+// ----------------------------------------------------- //
+bool bFile::mapFile(const char* filename)
+{
+#if defined (BT_BFILE_MMAP_POSIX)
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st)!=0 || st.st_size<=0 || st.st_size>0x7fffffff)
+	{
+		close(fd);
+		return false;
+	}
+	//a private mapping can be written, pointer fixups and endian swaps only copy the pages they touch
+	void* data = mmap(0, (size_t)st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	mFileBuffer = (char*)data;
+	mFileLen = (int)st.st_size;
+	mMemoryMapped = true;
+	return true;
+#elif defined (BT_BFILE_MMAP_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart<=0 || size.QuadPart>0x7fffffff)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+	void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	mFileBuffer = (char*)data;
+	mFileLen = (int)size.QuadPart;
+	mMappingHandle = mapping;
+	mMemoryMapped = true;
+	return true;
+#else
+	(void)filename;
+	return false;
+#endif
+}
+
+// ----------------------------------------------------- //
+void bFile::unmapFile()
+{
+#if defined (BT_BFILE_MMAP_POSIX)
+	munmap(mFileBuffer, (size_t)mFileLen);
+#elif defined (BT_BFILE_MMAP_WIN32)
+	UnmapViewOfFile(mFileBuffer);
+	CloseHandle((HANDLE)mMappingHandle);
+	mMappingHandle = 0;
+#endif
+	mFileBuffer = 0;
+	mMemoryMapped = false;
+}
+
+// ----------------------------------------------------- //
+bool bFile::canUseInPlace(const char* head) const
+{
+	//only a private mapping of the file is used in place. A malloc'd copy keeps the chunks in their own allocations as before,
+	//and the buffer of a bFile created from memory belongs to the caller and might not outlive the file
+	if (!mMemoryMapped)
+		return false;
+	return ((size_t)head & (BT_BFILE_IN_PLACE_ALIGNMENT-1))==0;
+}
+
 // ----------------------------------------------------- //
 void bFile::parseHeader()
 {
@@ -415,6 +529,14 @@ char* bFile::readStruct(char *head, bChunkInd&  dataChunk)
 	}
 
 
+	//the layout in the file matches the memory layout, so the chunk can stay where it is
+	if (canUseInPlace(head))
+	{
+		mNumInPlaceChunks++;
+		mInPlaceBytes += dataChunk.len;
+		return head;
+	}
+
 	char *dataAlloc = new char[(dataChunk.len)+1];
 	memset(dataAlloc, 0, dataChunk.len+1);
 
@@ -1048,6 +1170,42 @@ void bFile::resolvePointersStructRecursive(char *strcPtr, int dna_nr, bool verbo
 }
 
 
+bool bFile::structHasPointers(int dna_nr)
+{
+	bParse::bDNA* fileDna = mFileDNA ? mFileDNA : mMemoryDNA;
+	if (dna_nr < 0)
+		return false;
+	if (m_structHasPointers.size() != fileDna->getNumStructs())
+	{
+		m_structHasPointers.resize(0);
+		m_structHasPointers.resize(fileDna->getNumStructs(),-1);
+	}
+	if (m_structHasPointers[dna_nr] >= 0)
+		return m_structHasPointers[dna_nr]!=0;
+
+	//structs can't contain themselves, this only guards against a broken DNA
+	m_structHasPointers[dna_nr] = 0;
+
+	short	firstStructType = fileDna->getStruct(0)[0];
+	short int* oldStruct = fileDna->getStruct(dna_nr);
+	int elementLength = oldStruct[1];
+	oldStruct+=2;
+	bool hasPointers = false;
+	for (int ele=0; !hasPointers && ele<elementLength; ele++, oldStruct+=2)
+	{
+		char* memName = fileDna->getName(oldStruct[1]);
+		if (memName[0] == '*')
+		{
+			hasPointers = true;
+		} else if (oldStruct[0]>=firstStructType)
+		{
+			hasPointers = structHasPointers(fileDna->getReverseType(oldStruct[0]));
+		}
+	}
+	m_structHasPointers[dna_nr] = hasPointers ? 1 : 0;
+	return hasPointers;
+}
+
 ///Resolve pointers replaces the original pointers in structures, and linked lists by the new in-memory structures
 void bFile::resolvePointers(bool verboseDumpAllBlocks)
 {
@@ -1066,6 +1224,10 @@ void bFile::resolvePointers(bool verboseDumpAllBlocks)
 		{
 			const bChunkInd& dataChunk = m_chunks.at(i);
 
+			//chunks without pointers, such as vertex, index and bvh node arrays, are left untouched
+			if (!verboseDumpAllBlocks && !structHasPointers(dataChunk.dna_nr))
+				continue;
+
 			if (!mFileDNA || fileDna->flagEqual(dataChunk.dna_nr))
 			{
 				//dataChunk.len
@@ -49,6 +49,10 @@ namespace bParse {
 		int					mFileLen;
 		int					mVersion;
 
+		///the file buffer is a private (copy-on-write) mapping of the file instead of a malloc'd copy
+		bool				mMemoryMapped;
+		void*				mMappingHandle;
+
 
 		bPtrMap				mLibPointers;
 
@@ -62,6 +66,13 @@ namespace bParse {
 		btAlignedObjectArray<bChunkInd>	m_chunks;
         btHashMap<btHashPtr, bChunkInd> m_chunkPtrPtrMap;
 
+		///per file DNA struct: -1 not computed yet, 0 no pointers, 1 contains pointers (possibly in a nested struct)
+		btAlignedObjectArray<int>	m_structHasPointers;
+
+		///number of chunks that are used in place in the file buffer, and their total size
+		int					mNumInPlaceChunks;
+		int					mInPlaceBytes;
+
         // 
 	
 		bPtrMap				mDataPointers;
@@ -83,6 +94,15 @@ namespace bParse {
 		void resolvePointersChunk(const bChunkInd& dataChunk, bool verboseDumpAllBlocks);
 
 		void resolvePointersStructRecursive(char *strcPtr, int old_dna, bool verboseDumpAllBlocks, int recursion);
+
+		///chunks of structs without pointers don't need to be visited by resolvePointers
+		bool structHasPointers(int dna_nr);
+
+		///returns true if chunk data can be used in place, without a copy
+		bool canUseInPlace(const char* head) const;
+
+		bool	mapFile(const char* filename);
+		void	unmapFile();
 		//void swapPtr(char *dst, char *src);
 
 		void parseStruct(char *strcPtr, char *dtPtr, int old_dna, int new_dna, bool fixupPointers);
@@ -104,7 +124,9 @@ namespace bParse {
 		void	parseInternal(bool verboseDumpAllTypes, char* memDna,int memDnaLength);
 
 	public:
-		bFile(const char *filename, const char headerString[7]);
+		///with memoryMap, the file is mapped instead of read into memory. Chunks that match the memory DNA are then used in place,
+		///only pages that get pointers resolved or endians swapped are copied. Falls back to reading the file if it can't be mapped.
+		bFile(const char *filename, const char headerString[7], bool memoryMap=false);
 		
 		//todo: make memoryBuffer const char
 		//bFile( const char *memoryBuffer, int len);
@@ -150,6 +172,22 @@ namespace bParse {
 			return mVersion;
 		}
 
+		bool	isMemoryMapped() const
+		{
+			return mMemoryMapped;
+		}
+
+		///chunks that were used in place in the file buffer, instead of being copied
+		int		getNumInPlaceChunks() const
+		{
+			return mNumInPlaceChunks;
+		}
+
+		int		getInPlaceBytes() const
+		{
+			return mInPlaceBytes;
+		}
+
 		
 	};
 }
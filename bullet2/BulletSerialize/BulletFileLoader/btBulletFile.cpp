@@ -79,8 +79,8 @@ btBulletFile::btBulletFile()
 
 
 
-btBulletFile::btBulletFile(const char* fileName)
-:bFile(fileName, "BULLET ")
+btBulletFile::btBulletFile(const char* fileName, bool memoryMap)
+:bFile(fileName, "BULLET ", memoryMap)
 {
 	m_DnaCopy = 0;
 }
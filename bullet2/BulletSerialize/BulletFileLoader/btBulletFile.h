@@ -55,7 +55,8 @@ namespace bParse {
 		btAlignedObjectArray<char*>				m_dataBlocks;
 		btBulletFile();
 
-		btBulletFile(const char* fileName);
+		///see bFile::bFile for memoryMap
+		btBulletFile(const char* fileName, bool memoryMap=false);
 
 		btBulletFile(char *memoryBuffer, int len);
 
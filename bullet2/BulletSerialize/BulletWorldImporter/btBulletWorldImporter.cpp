@@ -18,6 +18,7 @@ subject to the following restrictions:
 #include "../BulletFileLoader/btBulletFile.h"
 
 #include "btBulletDynamicsCommon.h"
+#include "LinearMath/btThreads.h"
 #include "BulletCollision/Gimpact/btGImpactShape.h"
 
 
@@ -29,7 +30,10 @@ subject to the following restrictions:
 
 btBulletWorldImporter::btBulletWorldImporter(btDynamicsWorld* world)
 :m_dynamicsWorld(world),
-m_verboseDumpAllTypes(false)
+m_verboseDumpAllTypes(false),
+m_memoryMapFiles(false),
+m_streaming(false),
+m_streamingFocus(0,0,0)
 {
 }
 
@@ -40,6 +44,9 @@ btBulletWorldImporter::~btBulletWorldImporter()
 void btBulletWorldImporter::deleteAllData()
 {
 	int i;
+	m_pendingBvhShapes.clear();
+	m_streamingObjects.clear();
+
 	for (i=0;i<m_allocatedConstraints.size();i++)
 	{
 		if(m_dynamicsWorld)
@@ -150,7 +157,7 @@ void btBulletWorldImporter::deleteAllData()
 
 bool	btBulletWorldImporter::loadFile( const char* fileName)
 {
-	bParse::btBulletFile* bulletFile2 = new bParse::btBulletFile(fileName);
+	bParse::btBulletFile* bulletFile2 = new bParse::btBulletFile(fileName,m_memoryMapFiles);
 
 	bool result = loadFileFromMemory(bulletFile2);
 
@@ -635,6 +642,11 @@ btCollisionShape* btBulletWorldImporter::convertCollisionShape(  btCollisionShap
 
 
 			btBvhTriangleMeshShape* trimeshShape = createBvhTriangleMeshShape(meshInterface,bvh);
+			//a shape created without bvh is built by buildPendingBvhs, together with the other triangle meshes of the file
+			if (!trimeshShape->getOptimizedBvh())
+			{
+				m_pendingBvhShapes.push_back(trimeshShape);
+			}
 			trimeshShape->setMargin(trimesh->m_collisionMargin);
 			shape = trimeshShape;
 
@@ -728,9 +740,28 @@ bool	btBulletWorldImporter::loadFileFromMemory(  bParse::btBulletFile* bulletFil
 
 }
 
-bool	btBulletWorldImporter::convertAllObjects(  bParse::btBulletFile* bulletFile2)
+static void collectWrappedShapes(btCollisionShape* shape, btHashMap<btHashPtr,int>& wrappedShapes)
 {
+	if (shape->getShapeType()==SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE)
+	{
+		btScaledBvhTriangleMeshShape* scaledShape = (btScaledBvhTriangleMeshShape*)shape;
+		wrappedShapes.insert(scaledShape->getChildShape(),0);
+	}
+	if (shape->isCompound())
+	{
+		btCompoundShape* compoundShape = (btCompoundShape*)shape;
+		for (int i=0;i<compoundShape->getNumChildShapes();i++)
+		{
+			btCollisionShape* childShape = compoundShape->getChildShape(i);
+			wrappedShapes.insert(childShape,0);
+			collectWrappedShapes(childShape,wrappedShapes);
+		}
+	}
+}
 
+bool	btBulletWorldImporter::convertAllObjects(  bParse::btBulletFile* bulletFile2)
+{
+	//the meshes still pending from previous files stay queued, their objects are out of the world until updateStreaming builds them
 	m_shapeMap.clear();
 	m_bodyMap.clear();
 
@@ -774,6 +805,11 @@ bool	btBulletWorldImporter::convertAllObjects(  bParse::btBulletFile* bulletFile
 		}
 	}
 
+	if (!m_streaming)
+	{
+		buildPendingBvhs(m_pendingBvhShapes.size());
+	}
+
 	
 
 
@@ -930,6 +966,48 @@ bool	btBulletWorldImporter::convertAllObjects(  bParse::btBulletFile* bulletFile
 		
 	}
 
+	if (m_pendingBvhShapes.size())
+	{
+		//the objects of a btScaledBvhTriangleMeshShape or a compound stay in the world, so the meshes they use are built right away
+		btHashMap<btHashPtr,int> wrappedShapes;
+		for (i=0;i<m_shapeMap.size();i++)
+		{
+			collectWrappedShapes(*m_shapeMap.getAtIndex(i),wrappedShapes);
+		}
+		int numWrapped = 0;
+		for (i=0;i<m_pendingBvhShapes.size();i++)
+		{
+			if (wrappedShapes.find(m_pendingBvhShapes[i]))
+			{
+				m_pendingBvhShapes.swap(i,numWrapped++);
+			}
+		}
+		buildPendingBvhs(numWrapped);
+
+		btHashMap<btHashPtr,int> pendingShapes;
+		for (i=0;i<m_pendingBvhShapes.size();i++)
+		{
+			pendingShapes.insert(m_pendingBvhShapes[i],i);
+		}
+		for (i=0;i<m_bodyMap.size();i++)
+		{
+			btCollisionObject* colObj = *m_bodyMap.getAtIndex(i);
+			if (pendingShapes.find(colObj->getCollisionShape()))
+			{
+				if (m_dynamicsWorld)
+				{
+					btRigidBody* body = btRigidBody::upcast(colObj);
+					if (body)
+						m_dynamicsWorld->removeRigidBody(body);
+					else
+						m_dynamicsWorld->removeCollisionObject(colObj);
+				}
+				m_streamingObjects.push_back(colObj);
+			}
+		}
+		//meshes without streaming objects of their own are needed right away
+		buildPendingBvhs(sortPendingBvhs());
+	}
 	
 	for (i=0;i<bulletFile2->m_constraints.size();i++)
 	{
@@ -1215,6 +1293,136 @@ bool	btBulletWorldImporter::convertAllObjects(  bParse::btBulletFile* bulletFile
 
 
 
+struct btPendingBvh
+{
+	btBvhTriangleMeshShape*	m_shape;
+	btScalar	m_distance2;
+	int		m_numObjects;
+	int		m_index;
+};
+
+struct btPendingBvhSortPredicate
+{
+	bool operator() ( const btPendingBvh& a, const btPendingBvh& b ) const
+	{
+		if ((a.m_numObjects==0) != (b.m_numObjects==0))
+			return a.m_numObjects==0;
+		if (a.m_distance2 != b.m_distance2)
+			return a.m_distance2 < b.m_distance2;
+		return a.m_index < b.m_index;
+	}
+};
+
+int	btBulletWorldImporter::sortPendingBvhs()
+{
+	int i;
+	btHashMap<btHashPtr,int> shapeIndex;
+	btAlignedObjectArray<btPendingBvh> pending;
+	pending.resize(m_pendingBvhShapes.size());
+	for (i=0;i<pending.size();i++)
+	{
+		pending[i].m_shape = m_pendingBvhShapes[i];
+		pending[i].m_distance2 = BT_LARGE_FLOAT;
+		pending[i].m_numObjects = 0;
+		pending[i].m_index = i;
+		shapeIndex.insert(m_pendingBvhShapes[i],i);
+	}
+
+	for (i=0;i<m_streamingObjects.size();i++)
+	{
+		btCollisionObject* colObj = m_streamingObjects[i];
+		int* index = shapeIndex.find(colObj->getCollisionShape());
+		if (index)
+		{
+			//distance from the focus to the world aabb, large meshes are close as soon as the focus gets near any part of them
+			btVector3 aabbMin,aabbMax;
+			colObj->getCollisionShape()->getAabb(colObj->getWorldTransform(),aabbMin,aabbMax);
+			btVector3 closest = m_streamingFocus;
+			closest.setMax(aabbMin);
+			closest.setMin(aabbMax);
+			btPendingBvh& entry = pending[*index];
+			entry.m_distance2 = btMin(entry.m_distance2,(closest-m_streamingFocus).length2());
+			entry.m_numObjects++;
+		}
+	}
+
+	pending.quickSort(btPendingBvhSortPredicate());
+
+	int numWithoutObjects = 0;
+	for (i=0;i<pending.size();i++)
+	{
+		m_pendingBvhShapes[i] = pending[i].m_shape;
+		if (!pending[i].m_numObjects)
+			numWithoutObjects++;
+	}
+	return numWithoutObjects;
+}
+
+struct btBuildBvhLoop : public btIParallelForBody
+{
+	btBvhTriangleMeshShape**	m_shapes;
+
+	virtual void forLoop( int iBegin, int iEnd ) const
+	{
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			m_shapes[i]->buildOptimizedBvh();
+		}
+	}
+};
+
+void	btBulletWorldImporter::buildPendingBvhs(int numShapes)
+{
+	if (numShapes<=0)
+		return;
+
+	int i;
+	//the meshes are independent, each one is built by a single thread
+	btBuildBvhLoop loop;
+	loop.m_shapes = &m_pendingBvhShapes[0];
+	btParallelFor(0,numShapes,1,loop);
+
+	btHashMap<btHashPtr,int> builtShapes;
+	for (i=0;i<numShapes;i++)
+	{
+		builtShapes.insert(m_pendingBvhShapes[i],i);
+	}
+
+	int numRemaining = 0;
+	for (i=0;i<m_streamingObjects.size();i++)
+	{
+		btCollisionObject* colObj = m_streamingObjects[i];
+		if (builtShapes.find(colObj->getCollisionShape()))
+		{
+			if (m_dynamicsWorld)
+			{
+				btRigidBody* body = btRigidBody::upcast(colObj);
+				if (body)
+					m_dynamicsWorld->addRigidBody(body);
+				else
+					m_dynamicsWorld->addCollisionObject(colObj);
+			}
+		} else
+		{
+			m_streamingObjects[numRemaining++] = colObj;
+		}
+	}
+	m_streamingObjects.resize(numRemaining);
+
+	for (i=numShapes;i<m_pendingBvhShapes.size();i++)
+	{
+		m_pendingBvhShapes[i-numShapes] = m_pendingBvhShapes[i];
+	}
+	m_pendingBvhShapes.resize(m_pendingBvhShapes.size()-numShapes);
+}
+
+int	btBulletWorldImporter::updateStreaming(int maxShapes)
+{
+	sortPendingBvhs();
+	buildPendingBvhs(btMin(maxShapes,m_pendingBvhShapes.size()));
+	return m_pendingBvhShapes.size();
+}
+
 btCollisionObject* btBulletWorldImporter::createCollisionObject(const btTransform& startTransform,btCollisionShape* shape, const char* bodyName)
 {
 	return createRigidBody(false,0,startTransform,shape,bodyName);
@@ -1341,11 +1549,13 @@ btBvhTriangleMeshShape* btBulletWorldImporter::createBvhTriangleMeshShape(btStri
 		return bvhTriMesh;
 	}
 
-	btBvhTriangleMeshShape* ts = new btBvhTriangleMeshShape(trimesh,true);
+	//the bvh is built later by buildPendingBvhs
+	btBvhTriangleMeshShape* ts = new btBvhTriangleMeshShape(trimesh,true,false);
 	m_allocatedCollisionShapes.push_back(ts);
 	return ts;
 
 }
+
 btCollisionShape* btBulletWorldImporter::createConvexTriangleMeshShape(btStridingMeshInterface* trimesh)
 {
 	return 0;
@@ -67,6 +67,8 @@ protected:
 
 	bool m_verboseDumpAllTypes;
 
+	bool m_memoryMapFiles;
+
 	btCollisionShape* convertCollisionShape(  btCollisionShapeData* shapeData  );
 
 	btAlignedObjectArray<btCollisionShape*>  m_allocatedCollisionShapes;
@@ -98,6 +100,20 @@ protected:
 	btHashMap<btHashPtr,btCollisionShape*>	m_shapeMap;
 	btHashMap<btHashPtr,btCollisionObject*>	m_bodyMap;
 
+	///triangle mesh shapes that were created without bvh, the bvhs are built in parallel by buildPendingBvhs
+	btAlignedObjectArray<btBvhTriangleMeshShape*>	m_pendingBvhShapes;
+	///static objects that are kept out of the dynamics world until the bvh of their shape is built
+	btAlignedObjectArray<btCollisionObject*>	m_streamingObjects;
+
+	bool		m_streaming;
+	btVector3	m_streamingFocus;
+
+	///sorts m_pendingBvhShapes by the distance of their nearest streaming object to the focus, returns the number of shapes that have streaming objects
+	int		sortPendingBvhs();
+
+	///builds the bvhs of the first numShapes pending shapes on the threads of the task scheduler, then adds their streaming objects to the world
+	void	buildPendingBvhs(int numShapes);
+
 
 	//methods
 
@@ -137,6 +153,50 @@ public:
 		return m_verboseDumpAllTypes;
 	}
 
+	///loadFile maps the file into memory and converts the chunks in place where the file matches the memory layout, instead of reading a copy
+	void	setMemoryMapFiles(bool memoryMapFiles)
+	{
+		m_memoryMapFiles = memoryMapFiles;
+	}
+
+	bool	getMemoryMapFiles() const
+	{
+		return m_memoryMapFiles;
+	}
+
+	///With streaming, convertAllObjects doesn't wait for the bvhs of static triangle meshes. The objects using those meshes
+	///are kept out of the dynamics world until updateStreaming has built their bvh, nearest to the streaming focus first.
+	///Meshes that are also used through a btScaledBvhTriangleMeshShape or a compound are always built right away.
+	///Pending meshes of earlier files stay queued when the next file is loaded, updateStreaming serves the meshes of all files.
+	void	setStreaming(bool streaming)
+	{
+		m_streaming = streaming;
+	}
+
+	bool	getStreaming() const
+	{
+		return m_streaming;
+	}
+
+	void	setStreamingFocus(const btVector3& focus)
+	{
+		m_streamingFocus = focus;
+	}
+
+	const btVector3&	getStreamingFocus() const
+	{
+		return m_streamingFocus;
+	}
+
+	///builds the bvhs of the maxShapes triangle meshes nearest to the streaming focus and adds their objects to the dynamics world.
+	///Returns the number of triangle meshes that are still pending.
+	int		updateStreaming(int maxShapes);
+
+	int		getNumPendingShapes() const
+	{
+		return m_pendingBvhShapes.size();
+	}
+
 	// query for data
 	int	getNumCollisionShapes() const;
 	btCollisionShape* getCollisionShapeByIndex(int index);
@@ -174,6 +234,7 @@ public:
 	virtual btCollisionShape* createCylinderShapeY(btScalar radius,btScalar height);
 	virtual btCollisionShape* createCylinderShapeZ(btScalar radius,btScalar height);
 	virtual class btTriangleIndexVertexArray*	createTriangleMeshContainer();
+	///without bvh the shape is created unbuilt, the importer builds the bvh of any shape that is returned without one
 	virtual	btBvhTriangleMeshShape* createBvhTriangleMeshShape(btStridingMeshInterface* trimesh, btOptimizedBvh* bvh);
 	virtual btCollisionShape* createConvexTriangleMeshShape(btStridingMeshInterface* trimesh);
 	virtual btGImpactMeshShape* createGimpactShape(btStridingMeshInterface* trimesh);
@@ -0,0 +1,682 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
+
+#include "btCPUSoftBodySolver.h"
+#include "BulletSoftBody/btSoftBody.h"
+#include "BulletSoftBody/btSoftBodyInternals.h"
+
+#if !defined (BT_USE_DOUBLE_PRECISION) && (defined (BT_USE_SSE) || defined (__SSE__) || defined (_M_X64))
+#define BT_USE_SSE_LINK_SOLVER
+#include <xmmintrin.h>
+#endif
+
+
+btSoftBodyLinkData::btSoftBodyLinkData(btSoftBody* softBody)
+	:m_softBody(softBody),
+	m_nodeBase(0),
+	m_numNodes(-1),
+	m_linkBase(0),
+	m_numLinks(-1)
+{
+}
+
+bool	btSoftBodyLinkData::needsRebuild() const
+{
+	const btSoftBody* psb = m_softBody;
+	if ((psb->m_nodes.size() != m_numNodes) || (psb->m_links.size() != m_numLinks))
+		return true;
+	if (m_numNodes && (&psb->m_nodes[0] != m_nodeBase))
+		return true;
+	if (m_numLinks && (&psb->m_links[0] != m_linkBase))
+		return true;
+	return false;
+}
+
+void	btSoftBodyLinkData::build()
+{
+	BT_PROFILE("btSoftBodyLinkData::build");
+	const btSoftBody* psb = m_softBody;
+	m_numNodes = psb->m_nodes.size();
+	m_numLinks = psb->m_links.size();
+	m_nodeBase = m_numNodes ? &psb->m_nodes[0] : 0;
+	m_linkBase = m_numLinks ? &psb->m_links[0] : 0;
+
+	m_positionX.resize(m_numNodes);
+	m_positionY.resize(m_numNodes);
+	m_positionZ.resize(m_numNodes);
+	m_inverseMass.resize(m_numNodes);
+
+	m_linkNode0.resize(0);
+	m_linkNode1.resize(0);
+	m_linkIndex.resize(0);
+	m_linkC0.resize(m_numLinks);
+	m_linkC1.resize(m_numLinks);
+	m_batchStart.resize(0);
+
+	//greedy coloring: each pass takes the remaining links whose nodes are still free in this batch
+	btAlignedObjectArray<int> nodeBatch;
+	nodeBatch.resize(m_numNodes,-1);
+	btAlignedObjectArray<int> remaining;
+	remaining.resize(m_numLinks);
+	for (int i=0;i<m_numLinks;i++)
+	{
+		remaining[i] = i;
+	}
+
+	const btSoftBody::Node* nodes = m_numNodes ? &psb->m_nodes[0] : 0;
+	int batch = 0;
+	while (remaining.size())
+	{
+		m_batchStart.push_back(m_linkIndex.size());
+		int numRemaining = 0;
+		for (int j=0;j<remaining.size();j++)
+		{
+			const int i = remaining[j];
+			const btSoftBody::Link& l = psb->m_links[i];
+			const int n0 = int(l.m_n[0]-nodes);
+			const int n1 = int(l.m_n[1]-nodes);
+			if ((nodeBatch[n0] != batch) && (nodeBatch[n1] != batch))
+			{
+				nodeBatch[n0] = batch;
+				nodeBatch[n1] = batch;
+				m_linkNode0.push_back(n0);
+				m_linkNode1.push_back(n1);
+				m_linkIndex.push_back(i);
+			} else
+			{
+				remaining[numRemaining++] = i;
+			}
+		}
+		remaining.resize(numRemaining);
+		batch++;
+	}
+	m_batchStart.push_back(m_linkIndex.size());
+}
+
+
+///gathers the link constants, returns false if the links of the soft body were reordered since the last build
+static bool	gatherLinkConstants(btSoftBodyLinkData* data)
+{
+	const btSoftBody* psb = data->m_softBody;
+	const btSoftBody::Node* nodes = data->m_numNodes ? &psb->m_nodes[0] : 0;
+	for (int p=0;p<data->m_numLinks;p++)
+	{
+		const btSoftBody::Link& l = psb->m_links[data->m_linkIndex[p]];
+		if ((l.m_n[0] != nodes+data->m_linkNode0[p]) || (l.m_n[1] != nodes+data->m_linkNode1[p]))
+			return false;
+		data->m_linkC0[p] = l.m_c0;
+		data->m_linkC1[p] = l.m_c1;
+	}
+	return true;
+}
+
+static void	gatherPositions(btSoftBodyLinkData* data)
+{
+	const btSoftBody* psb = data->m_softBody;
+	for (int i=0;i<data->m_numNodes;i++)
+	{
+		const btSoftBody::Node& n = psb->m_nodes[i];
+		data->m_positionX[i] = n.m_x.getX();
+		data->m_positionY[i] = n.m_x.getY();
+		data->m_positionZ[i] = n.m_x.getZ();
+		data->m_inverseMass[i] = n.m_im;
+	}
+}
+
+static void	scatterPositions(btSoftBodyLinkData* data)
+{
+	btSoftBody* psb = data->m_softBody;
+	for (int i=0;i<data->m_numNodes;i++)
+	{
+		psb->m_nodes[i].m_x.setValue(data->m_positionX[i],data->m_positionY[i],data->m_positionZ[i]);
+	}
+}
+
+///same as btSoftBody::PSolve_Links, for the packed links [begin,end) of one batch
+static void	solveLinkRange(btSoftBodyLinkData* data, int begin, int end, btScalar kst)
+{
+	btScalar* px = &data->m_positionX[0];
+	btScalar* py = &data->m_positionY[0];
+	btScalar* pz = &data->m_positionZ[0];
+	const btScalar* im = &data->m_inverseMass[0];
+	const int* node0 = &data->m_linkNode0[0];
+	const int* node1 = &data->m_linkNode1[0];
+	const btScalar* c0 = &data->m_linkC0[0];
+	const btScalar* c1 = &data->m_linkC1[0];
+
+	int p = begin;
+#ifdef BT_USE_SSE_LINK_SOLVER
+	//the links of a batch don't share nodes, so 4 links can be gathered, solved and scattered at once
+	const __m128 vkst = _mm_set1_ps(kst);
+	const __m128 vepsilon = _mm_set1_ps(SIMD_EPSILON);
+	const __m128 vzero = _mm_setzero_ps();
+	for (;p+4<=end;p+=4)
+	{
+		const int a0 = node0[p], a1 = node0[p+1], a2 = node0[p+2], a3 = node0[p+3];
+		const int b0 = node1[p], b1 = node1[p+1], b2 = node1[p+2], b3 = node1[p+3];
+		const __m128 ax = _mm_setr_ps(px[a0],px[a1],px[a2],px[a3]);
+		const __m128 ay = _mm_setr_ps(py[a0],py[a1],py[a2],py[a3]);
+		const __m128 az = _mm_setr_ps(pz[a0],pz[a1],pz[a2],pz[a3]);
+		const __m128 bx = _mm_setr_ps(px[b0],px[b1],px[b2],px[b3]);
+		const __m128 by = _mm_setr_ps(py[b0],py[b1],py[b2],py[b3]);
+		const __m128 bz = _mm_setr_ps(pz[b0],pz[b1],pz[b2],pz[b3]);
+		const __m128 ima = _mm_setr_ps(im[a0],im[a1],im[a2],im[a3]);
+		const __m128 imb = _mm_setr_ps(im[b0],im[b1],im[b2],im[b3]);
+		const __m128 vc0 = _mm_loadu_ps(c0+p);
+		const __m128 vc1 = _mm_loadu_ps(c1+p);
+
+		const __m128 dx = _mm_sub_ps(bx,ax);
+		const __m128 dy = _mm_sub_ps(by,ay);
+		const __m128 dz = _mm_sub_ps(bz,az);
+		const __m128 len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy)),_mm_mul_ps(dz,dz));
+		const __m128 sum = _mm_add_ps(vc1,len);
+		const __m128 active = _mm_and_ps(_mm_cmpgt_ps(vc0,vzero),_mm_cmpgt_ps(sum,vepsilon));
+		//inactive lanes may divide by zero, their k is masked out
+		const __m128 k = _mm_and_ps(active,_mm_mul_ps(_mm_div_ps(_mm_sub_ps(vc1,len),_mm_mul_ps(vc0,sum)),vkst));
+		const __m128 ka = _mm_mul_ps(k,ima);
+		const __m128 kb = _mm_mul_ps(k,imb);
+
+		ATTRIBUTE_ALIGNED16(float	out[6][4]);
+		_mm_store_ps(out[0],_mm_sub_ps(ax,_mm_mul_ps(dx,ka)));
+		_mm_store_ps(out[1],_mm_sub_ps(ay,_mm_mul_ps(dy,ka)));
+		_mm_store_ps(out[2],_mm_sub_ps(az,_mm_mul_ps(dz,ka)));
+		_mm_store_ps(out[3],_mm_add_ps(bx,_mm_mul_ps(dx,kb)));
+		_mm_store_ps(out[4],_mm_add_ps(by,_mm_mul_ps(dy,kb)));
+		_mm_store_ps(out[5],_mm_add_ps(bz,_mm_mul_ps(dz,kb)));
+		px[a0] = out[0][0]; px[a1] = out[0][1]; px[a2] = out[0][2]; px[a3] = out[0][3];
+		py[a0] = out[1][0]; py[a1] = out[1][1]; py[a2] = out[1][2]; py[a3] = out[1][3];
+		pz[a0] = out[2][0]; pz[a1] = out[2][1]; pz[a2] = out[2][2]; pz[a3] = out[2][3];
+		px[b0] = out[3][0]; px[b1] = out[3][1]; px[b2] = out[3][2]; px[b3] = out[3][3];
+		py[b0] = out[4][0]; py[b1] = out[4][1]; py[b2] = out[4][2]; py[b3] = out[4][3];
+		pz[b0] = out[5][0]; pz[b1] = out[5][1]; pz[b2] = out[5][2]; pz[b3] = out[5][3];
+	}
+#endif //BT_USE_SSE_LINK_SOLVER
+	for (;p<end;p++)
+	{
+		if (c0[p]>0)
+		{
+			const int a = node0[p];
+			const int b = node1[p];
+			const btScalar dx = px[b]-px[a];
+			const btScalar dy = py[b]-py[a];
+			const btScalar dz = pz[b]-pz[a];
+			const btScalar len = dx*dx+dy*dy+dz*dz;
+			if (c1[p]+len > SIMD_EPSILON)
+			{
+				const btScalar k = ((c1[p]-len)/(c0[p]*(c1[p]+len)))*kst;
+				const btScalar ka = k*im[a];
+				const btScalar kb = k*im[b];
+				px[a] -= dx*ka;
+				py[a] -= dy*ka;
+				pz[a] -= dz*ka;
+				px[b] += dx*kb;
+				py[b] += dy*kb;
+				pz[b] += dz*kb;
+			}
+		}
+	}
+}
+
+struct btSolveLinkBatchLoop : public btIParallelForBody
+{
+	btSoftBodyLinkData*	m_data;
+	btScalar	m_kst;
+
+	btSolveLinkBatchLoop(btSoftBodyLinkData* data, btScalar kst)
+		:m_data(data),
+		m_kst(kst)
+	{
+	}
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("solveLinkBatchTask");
+		solveLinkRange(m_data,iBegin,iEnd,m_kst);
+	}
+};
+
+static void	copyToVertexBuffer( const btSoftBody *const softBody, btVertexBufferDescriptor *vertexBuffer )
+{
+	// Currently only support CPU output buffers
+	if( vertexBuffer->getBufferType() == btVertexBufferDescriptor::CPU_BUFFER )
+	{
+		const btAlignedObjectArray<btSoftBody::Node> &clothVertices( softBody->m_nodes );
+		int numVertices = clothVertices.size();
+
+		const btCPUVertexBufferDescriptor *cpuVertexBuffer = static_cast< btCPUVertexBufferDescriptor* >(vertexBuffer);
+		float *basePointer = cpuVertexBuffer->getBasePointer();
+
+		if( vertexBuffer->hasVertexPositions() )
+		{
+			const int vertexOffset = cpuVertexBuffer->getVertexOffset();
+			const int vertexStride = cpuVertexBuffer->getVertexStride();
+			float *vertexPointer = basePointer + vertexOffset;
+
+			for( int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex )
+			{
+				const btVector3& position = clothVertices[vertexIndex].m_x;
+				*(vertexPointer + 0) = float(position.getX());
+				*(vertexPointer + 1) = float(position.getY());
+				*(vertexPointer + 2) = float(position.getZ());
+				vertexPointer += vertexStride;
+			}
+		}
+		if( vertexBuffer->hasNormals() )
+		{
+			const int normalOffset = cpuVertexBuffer->getNormalOffset();
+			const int normalStride = cpuVertexBuffer->getNormalStride();
+			float *normalPointer = basePointer + normalOffset;
+
+			for( int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex )
+			{
+				const btVector3& normal = clothVertices[vertexIndex].m_n;
+				*(normalPointer + 0) = float(normal.getX());
+				*(normalPointer + 1) = float(normal.getY());
+				*(normalPointer + 2) = float(normal.getZ());
+				normalPointer += normalStride;
+			}
+		}
+	}
+}
+
+///returns true if solving against colObj changes its state, so soft bodies touching it can't be solved at the same time
+static bool	isDynamicRigidBody(const btCollisionObject* colObj)
+{
+	const btRigidBody* body = btRigidBody::upcast(colObj);
+	return body && ((body->getInvMass() != btScalar(0.)) || !body->isStaticOrKinematicObject());
+}
+
+
+btCPUSoftBodySolver::btCPUSoftBodySolver()
+	:m_minLinksPerParallelBatch(256)
+{
+}
+
+btCPUSoftBodySolver::~btCPUSoftBodySolver()
+{
+	for (int i=0;i<m_linkDataMap.size();i++)
+	{
+		btSoftBodyLinkData* data = *m_linkDataMap.getAtIndex(i);
+		data->~btSoftBodyLinkData();
+		btAlignedFree(data);
+	}
+}
+
+btSoftBodyLinkData*	btCPUSoftBodySolver::findOrCreateLinkData( btSoftBody* softBody )
+{
+	btSoftBodyLinkData** found = m_linkDataMap.find(btHashPtr(softBody));
+	if (found)
+		return *found;
+
+	void* ptr = btAlignedAlloc(sizeof(btSoftBodyLinkData),16);
+	btSoftBodyLinkData* data = new(ptr) btSoftBodyLinkData(softBody);
+	m_linkDataMap.insert(btHashPtr(softBody),data);
+	return data;
+}
+
+// The data is already in the soft bodies after each step
+void btCPUSoftBodySolver::copyBackToSoftBodies(bool bMove)
+{
+}
+
+void btCPUSoftBodySolver::optimize( btAlignedObjectArray< btSoftBody * > &softBodies , bool forceUpdate)
+{
+	bool changed = forceUpdate || (softBodies.size() != m_softBodySet.size());
+	for (int i=0;!changed && i<softBodies.size();i++)
+	{
+		changed = (softBodies[i] != m_softBodySet[i]);
+	}
+	if (!changed)
+		return;
+
+	m_softBodySet.copyFromArray( softBodies );
+	m_linkData.resize(0);
+	for (int i=0;i<m_softBodySet.size();i++)
+	{
+		btSoftBodyLinkData* data = findOrCreateLinkData(m_softBodySet[i]);
+		if (forceUpdate)
+		{
+			data->m_numNodes = -1;
+		}
+		m_linkData.push_back(data);
+	}
+
+	//release the data of soft bodies that left the solver
+	btHashMap< btHashPtr, int > softBodyIndices;
+	for (int i=0;i<m_softBodySet.size();i++)
+	{
+		softBodyIndices.insert(btHashPtr(m_softBodySet[i]),i);
+	}
+	btAlignedObjectArray< btSoftBodyLinkData * > removed;
+	for (int i=0;i<m_linkDataMap.size();i++)
+	{
+		btSoftBodyLinkData* data = *m_linkDataMap.getAtIndex(i);
+		if (!softBodyIndices.find(btHashPtr(data->m_softBody)))
+		{
+			removed.push_back(data);
+		}
+	}
+	for (int i=0;i<removed.size();i++)
+	{
+		m_linkDataMap.remove(btHashPtr(removed[i]->m_softBody));
+		m_vertexBuffers.remove(btHashPtr(removed[i]->m_softBody));
+		removed[i]->~btSoftBodyLinkData();
+		btAlignedFree(removed[i]);
+	}
+}
+
+bool btCPUSoftBodySolver::checkInitialized()
+{
+	return true;
+}
+
+
+struct btPredictSoftBodyMotionLoop : public btIParallelForBody
+{
+	btSoftBody* const*	m_softBodies;
+	btScalar	m_timeStep;
+
+	btPredictSoftBodyMotionLoop(btSoftBody* const* softBodies, btScalar timeStep)
+		:m_softBodies(softBodies),
+		m_timeStep(timeStep)
+	{
+	}
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("predictSoftBodyMotionTask");
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			m_softBodies[i]->predictMotion(m_timeStep);
+		}
+	}
+};
+
+void btCPUSoftBodySolver::predictMotion( float timeStep )
+{
+	m_activeBodies.resize(0);
+	for ( int i=0; i < m_softBodySet.size(); ++i)
+	{
+		btSoftBody*	psb = m_softBodySet[i];
+		if (psb->isActive())
+		{
+			m_activeBodies.push_back(psb);
+		}
+	}
+	if (m_activeBodies.size())
+	{
+		btParallelFor(0,m_activeBodies.size(),1,btPredictSoftBodyMotionLoop(&m_activeBodies[0],timeStep));
+	}
+}
+
+
+void btCPUSoftBodySolver::solveSoftBody( btSoftBodyLinkData* data, bool parallelBatches )
+{
+	btSoftBody* psb = data->m_softBody;
+	int i,ni;
+
+	if (data->needsRebuild() || !gatherLinkConstants(data))
+	{
+		data->build();
+		gatherLinkConstants(data);
+	}
+
+	/* Prepare links		*/
+	for(i=0,ni=psb->m_links.size();i<ni;++i)
+	{
+		btSoftBody::Link&	l=psb->m_links[i];
+		l.m_c3		=	l.m_n[1]->m_q-l.m_n[0]->m_q;
+		l.m_c2		=	1/(l.m_c3.length2()*l.m_c0);
+	}
+	/* Prepare anchors		*/
+	for(i=0,ni=psb->m_anchors.size();i<ni;++i)
+	{
+		btSoftBody::Anchor&	a=psb->m_anchors[i];
+		const btVector3	ra=a.m_body->getWorldTransform().getBasis()*a.m_local;
+		a.m_c0	=	ImpulseMatrix(	psb->m_sst.sdt,
+			a.m_node->m_im,
+			a.m_body->getInvMass(),
+			a.m_body->getInvInertiaTensorWorld(),
+			ra);
+		a.m_c1	=	ra;
+		a.m_c2	=	psb->m_sst.sdt*a.m_node->m_im;
+		a.m_body->activate();
+	}
+	/* Solve positions		*/
+	if(psb->m_cfg.piterations>0)
+	{
+		//the link solver works on the packed positions, the other solvers on the nodes
+		bool packedValid = false;
+		bool nodesValid = true;
+		for(int isolve=0;isolve<psb->m_cfg.piterations;++isolve)
+		{
+			const btScalar ti=isolve/(btScalar)psb->m_cfg.piterations;
+			for(int iseq=0;iseq<psb->m_cfg.m_psequence.size();++iseq)
+			{
+				const btSoftBody::ePSolver::_ solver = psb->m_cfg.m_psequence[iseq];
+				if (solver == btSoftBody::ePSolver::Linear)
+				{
+					if (!packedValid)
+					{
+						gatherPositions(data);
+						packedValid = true;
+					}
+					for (int batch=0;batch<data->getNumBatches();batch++)
+					{
+						const int begin = data->m_batchStart[batch];
+						const int end = data->m_batchStart[batch+1];
+						if (parallelBatches && (end-begin >= m_minLinksPerParallelBatch))
+						{
+							btParallelFor(begin,end,m_minLinksPerParallelBatch/2,btSolveLinkBatchLoop(data,1));
+						} else
+						{
+							solveLinkRange(data,begin,end,1);
+						}
+					}
+					nodesValid = false;
+				} else
+				{
+					if ((solver == btSoftBody::ePSolver::Anchors && !psb->m_anchors.size()) ||
+						(solver == btSoftBody::ePSolver::RContacts && !psb->m_rcontacts.size()) ||
+						(solver == btSoftBody::ePSolver::SContacts && !psb->m_scontacts.size()))
+					{
+						continue;
+					}
+					if (!nodesValid)
+					{
+						scatterPositions(data);
+						nodesValid = true;
+					}
+					btSoftBody::getSolver(solver)(psb,1,ti);
+					packedValid = false;
+				}
+			}
+		}
+		if (!nodesValid)
+		{
+			scatterPositions(data);
+		}
+		const btScalar	vc=psb->m_sst.isdt*(1-psb->m_cfg.kDP);
+		for(i=0,ni=psb->m_nodes.size();i<ni;++i)
+		{
+			btSoftBody::Node&	n=psb->m_nodes[i];
+			n.m_v	=	(n.m_x-n.m_q)*vc;
+			n.m_f	=	btVector3(0,0,0);
+		}
+	}
+}
+
+struct btSolveSoftBodiesLoop : public btIParallelForBody
+{
+	btCPUSoftBodySolver*	m_solver;
+	btSoftBodyLinkData* const*	m_softBodies;
+
+	btSolveSoftBodiesLoop(btCPUSoftBodySolver* solver, btSoftBodyLinkData* const* softBodies)
+		:m_solver(solver),
+		m_softBodies(softBodies)
+	{
+	}
+
+	virtual void forLoop(int iBegin, int iEnd) const;
+};
+
+void btCPUSoftBodySolver::solveConstraints( float solverdt )
+{
+	m_parallelBodies.resize(0);
+	m_serialBodies.resize(0);
+	m_fallbackBodies.resize(0);
+
+	for(int i=0; i < m_softBodySet.size(); ++i)
+	{
+		btSoftBody*	psb = m_softBodySet[i];
+		if (!psb->isActive())
+			continue;
+
+		//the packed path covers the position solvers, anything else is left to btSoftBody
+		if (psb->m_clusters.size() || (psb->m_cfg.viterations>0) || (psb->m_cfg.diterations>0))
+		{
+			m_fallbackBodies.push_back(psb);
+			continue;
+		}
+
+		bool serial = (psb->m_scontacts.size() > 0);
+		for (int j=0;!serial && j<psb->m_anchors.size();j++)
+		{
+			serial = isDynamicRigidBody(psb->m_anchors[j].m_body);
+		}
+		for (int j=0;!serial && j<psb->m_rcontacts.size();j++)
+		{
+			serial = isDynamicRigidBody(psb->m_rcontacts[j].m_cti.m_colObj);
+		}
+		if (serial)
+		{
+			m_serialBodies.push_back(m_linkData[i]);
+		} else
+		{
+			m_parallelBodies.push_back(m_linkData[i]);
+		}
+	}
+
+	for (int i=0;i<m_fallbackBodies.size();i++)
+	{
+		m_fallbackBodies[i]->solveConstraints();
+	}
+
+	//with fewer soft bodies than threads, the batches of each soft body are spread across the threads instead
+	const int numThreads = btGetTaskScheduler()->getNumThreads();
+	if (m_parallelBodies.size() >= numThreads)
+	{
+		btParallelFor(0,m_parallelBodies.size(),1,btSolveSoftBodiesLoop(this,&m_parallelBodies[0]));
+	} else
+	{
+		for (int i=0;i<m_parallelBodies.size();i++)
+		{
+			solveSoftBody(m_parallelBodies[i],true);
+		}
+	}
+
+	//these push rigid bodies or the nodes of other soft bodies
+	for (int i=0;i<m_serialBodies.size();i++)
+	{
+		solveSoftBody(m_serialBodies[i],true);
+	}
+} // btCPUSoftBodySolver::solveConstraints
+
+void btSolveSoftBodiesLoop::forLoop(int iBegin, int iEnd) const
+{
+	BT_PROFILE("solveSoftBodiesTask");
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		m_solver->solveSoftBody(m_softBodies[i],false);
+	}
+}
+
+
+struct btIntegrateSoftBodiesLoop : public btIParallelForBody
+{
+	btSoftBody* const*	m_softBodies;
+	btVertexBufferDescriptor* const*	m_vertexBuffers;
+
+	btIntegrateSoftBodiesLoop(btSoftBody* const* softBodies, btVertexBufferDescriptor* const* vertexBuffers)
+		:m_softBodies(softBodies),
+		m_vertexBuffers(vertexBuffers)
+	{
+	}
+
+	virtual void forLoop(int iBegin, int iEnd) const
+	{
+		BT_PROFILE("integrateSoftBodiesTask");
+		for (int i=iBegin;i<iEnd;i++)
+		{
+			m_softBodies[i]->integrateMotion();
+			if (m_vertexBuffers[i])
+			{
+				copyToVertexBuffer(m_softBodies[i],m_vertexBuffers[i]);
+			}
+		}
+	}
+};
+
+void btCPUSoftBodySolver::updateSoftBodies( )
+{
+	m_activeBodies.resize(0);
+	m_activeVertexBuffers.resize(0);
+	for ( int i=0; i < m_softBodySet.size(); i++)
+	{
+		btSoftBody*	psb = m_softBodySet[i];
+		if (psb->isActive())
+		{
+			btVertexBufferDescriptor** vertexBuffer = m_vertexBuffers.find(btHashPtr(psb));
+			m_activeBodies.push_back(psb);
+			m_activeVertexBuffers.push_back(vertexBuffer ? *vertexBuffer : 0);
+		}
+	}
+	if (m_activeBodies.size())
+	{
+		btParallelFor(0,m_activeBodies.size(),1,btIntegrateSoftBodiesLoop(&m_activeBodies[0],&m_activeVertexBuffers[0]));
+	}
+} // updateSoftBodies
+
+
+void btCPUSoftBodySolver::copySoftBodyToVertexBuffer( const btSoftBody *const softBody, btVertexBufferDescriptor *vertexBuffer )
+{
+	copyToVertexBuffer(softBody,vertexBuffer);
+}
+
+void btCPUSoftBodySolver::setVertexBuffer( btSoftBody* softBody, btVertexBufferDescriptor* vertexBuffer )
+{
+	if (vertexBuffer)
+	{
+		m_vertexBuffers.insert(btHashPtr(softBody),vertexBuffer);
+	} else
+	{
+		m_vertexBuffers.remove(btHashPtr(softBody));
+	}
+}
+
+void btCPUSoftBodySolver::processCollision( btSoftBody* softBody, btSoftBody* otherSoftBody)
+{
+	softBody->defaultCollisionHandler( otherSoftBody);
+}
+
+void btCPUSoftBodySolver::processCollision( btSoftBody *softBody, const btCollisionObjectWrapper* collisionObjectWrap )
+{
+	softBody->defaultCollisionHandler( collisionObjectWrap );
+}
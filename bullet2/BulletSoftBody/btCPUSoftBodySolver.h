@@ -0,0 +1,146 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CPU_SOFT_BODY_SOLVER_H
+#define BT_CPU_SOFT_BODY_SOLVER_H
+
+
+#include "BulletSoftBody/btSoftBodySolvers.h"
+#include "btSoftBodySolverVertexBuffer.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
+struct btCollisionObjectWrapper;
+
+///btSoftBodyLinkData keeps the nodes and links of one soft body as packed arrays.
+///The links are sorted into batches, the links of a batch don't share nodes and can be solved at the same time.
+class btSoftBodyLinkData
+{
+public:
+	btSoftBody*		m_softBody;
+
+	///the node and link arrays the packed data was built from, a mismatch triggers a rebuild
+	const void*		m_nodeBase;
+	int				m_numNodes;
+	const void*		m_linkBase;
+	int				m_numLinks;
+
+	btAlignedObjectArray<btScalar>	m_positionX;
+	btAlignedObjectArray<btScalar>	m_positionY;
+	btAlignedObjectArray<btScalar>	m_positionZ;
+	btAlignedObjectArray<btScalar>	m_inverseMass;
+
+	btAlignedObjectArray<int>		m_linkNode0;
+	btAlignedObjectArray<int>		m_linkNode1;
+	///index into btSoftBody::m_links
+	btAlignedObjectArray<int>		m_linkIndex;
+	///(ima+imb)*kLST
+	btAlignedObjectArray<btScalar>	m_linkC0;
+	///rest length squared
+	btAlignedObjectArray<btScalar>	m_linkC1;
+
+	///links of batch i are [m_batchStart[i],m_batchStart[i+1])
+	btAlignedObjectArray<int>		m_batchStart;
+
+	btSoftBodyLinkData(btSoftBody* softBody);
+
+	///returns true if the nodes or links of the soft body were reallocated or reordered since the last build
+	bool	needsRebuild() const;
+
+	///sorts the links into batches, using the same greedy order every time so results are deterministic
+	void	build();
+
+	int		getNumBatches() const
+	{
+		return m_batchStart.size() ? m_batchStart.size()-1 : 0;
+	}
+};
+
+///The btCPUSoftBodySolver steps soft bodies on all threads of the task scheduler, see btSetTaskScheduler.
+///Soft bodies are predicted, solved and integrated in parallel. The position solver of the links works on packed
+///arrays and solves batches of independent links with SIMD. Scenes with few large soft bodies solve the links of one batch across threads instead.
+///Soft bodies that push dynamic rigid bodies, touch other soft bodies or use clusters, velocity or drift iterations are solved serially.
+///Links are solved in batch order instead of the order of btSoftBody::m_links, so results differ slightly from the btDefaultSoftBodySolver.
+class btCPUSoftBodySolver : public btSoftBodySolver
+{
+protected:
+	btAlignedObjectArray< btSoftBody * > m_softBodySet;
+
+	///packed data of m_softBodySet[i], the arrays are built the first time the soft body is solved
+	btAlignedObjectArray< btSoftBodyLinkData * > m_linkData;
+
+	btHashMap< btHashPtr, btSoftBodyLinkData * > m_linkDataMap;
+
+	///vertex buffers that are filled at the end of updateSoftBodies
+	btHashMap< btHashPtr, btVertexBufferDescriptor * > m_vertexBuffers;
+
+	btAlignedObjectArray< btSoftBody * > m_activeBodies;
+	btAlignedObjectArray< btVertexBufferDescriptor * > m_activeVertexBuffers;
+	btAlignedObjectArray< btSoftBodyLinkData * > m_parallelBodies;
+	btAlignedObjectArray< btSoftBodyLinkData * > m_serialBodies;
+	btAlignedObjectArray< btSoftBody * > m_fallbackBodies;
+
+	///minimum number of links of a batch before the links of a single soft body are spread across threads
+	int	m_minLinksPerParallelBatch;
+
+	btSoftBodyLinkData*	findOrCreateLinkData( btSoftBody* softBody );
+
+	void	solveSoftBody( btSoftBodyLinkData* data, bool parallelBatches );
+
+	friend struct btSolveSoftBodiesLoop;
+
+public:
+	btCPUSoftBodySolver();
+
+	virtual ~btCPUSoftBodySolver();
+
+	virtual SolverTypes getSolverType() const
+	{
+		return CPU_SOLVER;
+	}
+
+	virtual bool checkInitialized();
+
+	virtual void updateSoftBodies( );
+
+	virtual void optimize( btAlignedObjectArray< btSoftBody * > &softBodies,bool forceUpdate=false );
+
+	virtual void copyBackToSoftBodies(bool bMove = true);
+
+	virtual void solveConstraints( float solverdt );
+
+	virtual void predictMotion( float solverdt );
+
+	virtual void copySoftBodyToVertexBuffer( const btSoftBody *const softBody, btVertexBufferDescriptor *vertexBuffer );
+
+	virtual void processCollision( btSoftBody *, const btCollisionObjectWrapper* );
+
+	virtual void processCollision( btSoftBody*, btSoftBody* );
+
+	///positions and normals of softBody are written to vertexBuffer at the end of each updateSoftBodies, from the thread that updated the soft body.
+	///Pass 0 to stop. Only CPU_BUFFER descriptors are supported, the solver doesn't own the descriptor.
+	void	setVertexBuffer( btSoftBody* softBody, btVertexBufferDescriptor* vertexBuffer );
+
+	void	setMinLinksPerParallelBatch( int minLinks )
+	{
+		m_minLinksPerParallelBatch = minLinks;
+	}
+
+	int		getMinLinksPerParallelBatch() const
+	{
+		return m_minLinksPerParallelBatch;
+	}
+};
+
+#endif // #ifndef BT_CPU_SOFT_BODY_SOLVER_H
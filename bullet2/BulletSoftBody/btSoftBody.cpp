@@ -18,6 +18,10 @@ subject to the following restrictions:
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "btSoftBodyData.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
+
+///serializes the broadphase updates of soft bodies that are stepped in parallel
+static btSpinMutex	gBroadphaseMutex;
 
 
 //
@@ -2254,11 +2258,17 @@ void					btSoftBody::updateBounds()
 			m_bounds[0]=mins-mrg;
 			m_bounds[1]=maxs+mrg;
 			if(0!=getBroadphaseHandle())
-			{					
+			{
+				//soft bodies can predict their motion from several threads, see btCPUSoftBodySolver
+				const bool threadsRunning = btThreadsAreRunning();
+				if (threadsRunning)
+					gBroadphaseMutex.lock();
 				m_worldInfo->m_broadphase->setAabb(	getBroadphaseHandle(),
 					m_bounds[0],
 					m_bounds[1],
 					m_worldInfo->m_dispatcher);
+				if (threadsRunning)
+					gBroadphaseMutex.unlock();
 			}
 		}
 		else
@@ -23,6 +23,7 @@ subject to the following restrictions:
 #include "btSoftBodySolvers.h"
 #include "btDefaultSoftBodySolver.h"
 #include "LinearMath/btSerializer.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
 
 
 btSoftRigidDynamicsWorld::btSoftRigidDynamicsWorld(
@@ -136,6 +137,7 @@ void	btSoftRigidDynamicsWorld::addSoftBody(btSoftBody* body,short int collisionF
 	btCollisionWorld::addCollisionObject(body,
 		collisionFilterGroup,
 		collisionFilterMask);
+	getSimulationIslandManager()->addCollisionObject(body);
 
 }
 
@@ -143,6 +145,7 @@ void	btSoftRigidDynamicsWorld::removeSoftBody(btSoftBody* body)
 {
 	m_softBodies.remove(body);
 
+	getSimulationIslandManager()->removeCollisionObject(body);
 	btCollisionWorld::removeCollisionObject(body);
 }
 
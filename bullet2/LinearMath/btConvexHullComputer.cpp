@@ -18,6 +18,7 @@ subject to the following restrictions:
 #include "btAlignedObjectArray.h"
 #include "btMinMax.h"
 #include "btVector3.h"
+#include "btThreads.h"
 
 #ifdef __GNUC__
 	#include <stdint.h>
@@ -681,6 +682,11 @@ class btConvexHullInternal
 					btAlignedFree(array);
 				}
 
+				int getSize() const
+				{
+					return size;
+				}
+
 				T* init()
 				{
 					T* o = array;
@@ -706,6 +712,11 @@ class btConvexHullInternal
 				}
 
 				~Pool()
+				{
+					clear();
+				}
+
+				void clear()
 				{
 					while (arrays)
 					{
@@ -714,6 +725,8 @@ class btConvexHullInternal
 						p->~PoolArray<T>();
 						btAlignedFree(p);
 					}
+					nextArray = NULL;
+					freeObjects = NULL;
 				}
 
 				void reset()
@@ -722,6 +735,17 @@ class btConvexHullInternal
 					freeObjects = NULL;
 				}
 
+				// like reset, but the first "size" objects are guaranteed to be contiguous
+				void resetContiguous(int size)
+				{
+					if (arrays && (arrays->getSize() < size))
+					{
+						clear();
+					}
+					reset();
+					arraySize = size;
+				}
+
 				void setArraySize(int arraySize)
 				{
 					this->arraySize = arraySize;
@@ -813,6 +837,17 @@ class btConvexHullInternal
 		}
 		
 		void computeInternal(int start, int end, IntermediateHull& result);
+
+		// parallel divide and conquer, see computeParallel
+		btAlignedObjectArray<btConvexHullInternal*> workers;
+
+		void splitRange(int start, int end, int depth, btAlignedObjectArray<int>& ranges);
+
+		void mergeRange(int start, int end, int depth, btAlignedObjectArray<IntermediateHull>& leafHulls, int& leaf, IntermediateHull& result);
+
+		void computeParallel(int count, int depth, IntermediateHull& result);
+
+		friend struct btConvexHullLeafBody;
 		
 		bool mergeProjection(IntermediateHull& h0, IntermediateHull& h1, Vertex*& c0, Vertex*& c1);
 		
@@ -827,6 +862,8 @@ class btConvexHullInternal
 	public:
 		Vertex* vertexList;
 
+		~btConvexHullInternal();
+
 		void compute(const void* coords, bool doubleCoords, int stride, int count);
 
 		btVector3 getCoordinates(const Vertex* v);
@@ -1317,6 +1354,129 @@ void btConvexHullInternal::computeInternal(int start, int end, IntermediateHull&
 #endif
 }
 
+// clouds with fewer points per task are computed serially
+#define BT_CONVEX_HULL_MIN_TASK_POINTS 8192
+
+btConvexHullInternal::~btConvexHullInternal()
+{
+	for (int i = 0; i < workers.size(); i++)
+	{
+		workers[i]->~btConvexHullInternal();
+		btAlignedFree(workers[i]);
+	}
+}
+
+// splitRange appends the ranges that computeInternal reaches after "depth" levels of recursion
+void btConvexHullInternal::splitRange(int start, int end, int depth, btAlignedObjectArray<int>& ranges)
+{
+	int n = end - start;
+	if ((depth == 0) || (n < 2 * BT_CONVEX_HULL_MIN_TASK_POINTS))
+	{
+		ranges.push_back(start);
+		ranges.push_back(end);
+		return;
+	}
+	// same split as computeInternal
+	int split0 = start + n / 2;
+	Point32 p = originalVertices[split0-1]->point;
+	int split1 = split0;
+	while ((split1 < end) && (originalVertices[split1]->point == p))
+	{
+		split1++;
+	}
+	splitRange(start, split0, depth - 1, ranges);
+	splitRange(split1, end, depth - 1, ranges);
+}
+
+// mergeRange merges the hulls of the ranges of splitRange in the order of computeInternal
+void btConvexHullInternal::mergeRange(int start, int end, int depth, btAlignedObjectArray<IntermediateHull>& leafHulls, int& leaf, IntermediateHull& result)
+{
+	int n = end - start;
+	if ((depth == 0) || (n < 2 * BT_CONVEX_HULL_MIN_TASK_POINTS))
+	{
+		result = leafHulls[leaf++];
+		return;
+	}
+	int split0 = start + n / 2;
+	Point32 p = originalVertices[split0-1]->point;
+	int split1 = split0;
+	while ((split1 < end) && (originalVertices[split1]->point == p))
+	{
+		split1++;
+	}
+	mergeRange(start, split0, depth - 1, leafHulls, leaf, result);
+	IntermediateHull hull1;
+	mergeRange(split1, end, depth - 1, leafHulls, leaf, hull1);
+	merge(result, hull1);
+}
+
+struct btConvexHullLeafBody : public btIParallelForBody
+{
+	btConvexHullInternal* m_hull;
+	const int* m_ranges;
+	btConvexHullInternal::IntermediateHull* m_leafHulls;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			// each leaf builds its edges in its own pools, the edges stay valid until the hull is destroyed
+			btConvexHullInternal* worker = m_hull->workers[i];
+			int start = m_ranges[2 * i];
+			int n = m_ranges[2 * i + 1] - start;
+			worker->originalVertices.resize(n);
+			for (int j = 0; j < n; j++)
+			{
+				worker->originalVertices[j] = m_hull->originalVertices[start + j];
+			}
+			worker->edgePool.reset();
+			worker->edgePool.setArraySize(6 * n);
+			worker->usedEdgePairs = 0;
+			worker->maxUsedEdgePairs = 0;
+			worker->mergeStamp = -3;
+			worker->computeInternal(0, n, m_leafHulls[i]);
+		}
+	}
+};
+
+/*
+computeParallel computes the same hull as computeInternal(0, count, result). The subtrees "depth" levels down the recursion
+are computed concurrently by workers with their own edge pools and merge stamps, then merged in the same order as computeInternal.
+Merging only compares the stamps of edges for being older than or equal to the current merge, so continuing below the lowest
+stamp of all workers keeps every decision, and the result, identical to the serial path.
+*/
+void btConvexHullInternal::computeParallel(int count, int depth, IntermediateHull& result)
+{
+	btAlignedObjectArray<int> ranges;
+	splitRange(0, count, depth, ranges);
+	int numLeaves = ranges.size() / 2;
+
+	while (workers.size() < numLeaves)
+	{
+		void* mem = btAlignedAlloc(sizeof(btConvexHullInternal), 16);
+		workers.push_back(new(mem) btConvexHullInternal());
+	}
+
+	btAlignedObjectArray<IntermediateHull> leafHulls;
+	leafHulls.resize(numLeaves);
+
+	btConvexHullLeafBody body;
+	body.m_hull = this;
+	body.m_ranges = &ranges[0];
+	body.m_leafHulls = &leafHulls[0];
+	btParallelFor(0, numLeaves, 1, body);
+
+	for (int i = 0; i < numLeaves; i++)
+	{
+		mergeStamp = btMin(mergeStamp, workers[i]->mergeStamp);
+		usedEdgePairs += workers[i]->usedEdgePairs;
+		maxUsedEdgePairs += workers[i]->maxUsedEdgePairs;
+	}
+
+	int leaf = 0;
+	mergeRange(0, count, depth, leafHulls, leaf, result);
+}
+
 #ifdef DEBUG_CONVEX_HULL
 void btConvexHullInternal::IntermediateHull::print()
 {
@@ -2028,8 +2188,8 @@ void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int st
 	}
 	points.quickSort(pointCmp);
 
-	vertexPool.reset();
-	vertexPool.setArraySize(count);
+	// computeInternal expects consecutive vertices to be adjacent in memory
+	vertexPool.resetContiguous(count);
 	originalVertices.resize(count);
 	for (int i = 0; i < count; i++)
 	{
@@ -2042,16 +2202,41 @@ void btConvexHullInternal::compute(const void* coords, bool doubleCoords, int st
 
 	points.clear();
 
-	edgePool.reset();
-	edgePool.setArraySize(6 * count);
-
 	usedEdgePairs = 0;
 	maxUsedEdgePairs = 0;
 
 	mergeStamp = -3;
 
+	// split large clouds over the threads of the task scheduler, unless this already runs in a task
+	int depth = 0;
+	if (!btThreadsAreRunning())
+	{
+		int numTasks = 4 * btGetTaskScheduler()->getNumThreads();
+		while ((numTasks > 1) && ((count >> depth) >= 2 * BT_CONVEX_HULL_MIN_TASK_POINTS))
+		{
+			depth++;
+			numTasks >>= 1;
+		}
+		if (btGetTaskScheduler()->getNumThreads() < 2)
+		{
+			depth = 0;
+		}
+	}
+
+	edgePool.reset();
+	facePool.reset();
+	// with workers, only the merges of their hulls allocate edges here
+	edgePool.setArraySize(depth ? btMax(6 * (count >> depth), 256) : 6 * count);
+
 	IntermediateHull hull;
-	computeInternal(0, count, hull);
+	if (depth)
+	{
+		computeParallel(count, depth, hull);
+	}
+	else
+	{
+		computeInternal(0, count, hull);
+	}
 	vertexList = hull.minXy;
 #ifdef DEBUG_CONVEX_HULL
 	printf("max. edges %d (3v = %d)", maxUsedEdgePairs, 3 * count);
@@ -2639,6 +2824,12 @@ static int getVertexCopy(btConvexHullInternal::Vertex* vertex, btAlignedObjectAr
 }
 
 btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
+{
+	btConvexHullInternal hull;
+	return compute(hull, coords, doubleCoords, stride, count, shrink, shrinkClamp);
+}
+
+btScalar btConvexHullComputer::compute(btConvexHullInternal& hull, const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
 {
 	if (count <= 0)
 	{
@@ -2648,7 +2839,6 @@ btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, in
 		return 0;
 	}
 
-	btConvexHullInternal hull;
 	hull.compute(coords, doubleCoords, stride, count);
 
 	btScalar shift = 0;
@@ -2747,5 +2937,74 @@ btScalar btConvexHullComputer::compute(const void* coords, bool doubleCoords, in
 
 
 
+struct btConvexHullBatchBody : public btIParallelForBody
+{
+	btConvexHullInternal** m_arenas;
+	btConvexHullComputer* m_hulls;
+	const void* const* m_coords;
+	bool m_doubleCoords;
+	const int* m_counts;
+	int m_stride;
+	btScalar m_shrink;
+	btScalar m_shrinkClamp;
+	btScalar* m_shifts;
+
+	void forLoop(int iBegin, int iEnd) const
+	{
+		// only the current thread uses its arena
+		btConvexHullInternal*& arena = m_arenas[btGetCurrentThreadIndex()];
+		if (!arena)
+		{
+			arena = new(btAlignedAlloc(sizeof(btConvexHullInternal), 16)) btConvexHullInternal();
+		}
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btScalar shift = m_hulls[i].compute(*arena, m_coords[i], m_doubleCoords, m_stride, m_counts[i], m_shrink, m_shrinkClamp);
+			if (m_shifts)
+			{
+				m_shifts[i] = shift;
+			}
+		}
+	}
+};
+
+btConvexHullBatch::btConvexHullBatch()
+{
+	for (int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+	{
+		m_arenas[i] = NULL;
+	}
+}
+
+btConvexHullBatch::~btConvexHullBatch()
+{
+	releaseArenas();
+}
 
+void btConvexHullBatch::releaseArenas()
+{
+	for (int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+	{
+		if (m_arenas[i])
+		{
+			m_arenas[i]->~btConvexHullInternal();
+			btAlignedFree(m_arenas[i]);
+			m_arenas[i] = NULL;
+		}
+	}
+}
 
+void btConvexHullBatch::compute(btConvexHullComputer* hulls, const void* const* coords, bool doubleCoords, const int* counts, int numClouds, int stride, btScalar shrink, btScalar shrinkClamp, btScalar* shifts)
+{
+	btConvexHullBatchBody body;
+	body.m_arenas = m_arenas;
+	body.m_hulls = hulls;
+	body.m_coords = coords;
+	body.m_doubleCoords = doubleCoords;
+	body.m_counts = counts;
+	body.m_stride = stride;
+	body.m_shrink = shrink;
+	body.m_shrinkClamp = shrinkClamp;
+	body.m_shifts = shifts;
+	btParallelFor(0, numClouds, 1, body);
+}
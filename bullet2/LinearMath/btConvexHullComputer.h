@@ -17,6 +17,9 @@ subject to the following restrictions:
 
 #include "btVector3.h"
 #include "btAlignedObjectArray.h"
+#include "btThreads.h"
+
+class btConvexHullInternal;
 
 /// Convex hull implementation based on Preparata and Hong
 /// See http://code.google.com/p/bullet/issues/detail?id=275
@@ -26,6 +29,10 @@ class btConvexHullComputer
 	private:
 		btScalar compute(const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp);
 
+		btScalar compute(btConvexHullInternal& hull, const void* coords, bool doubleCoords, int stride, int count, btScalar shrink, btScalar shrinkClamp);
+
+		friend struct btConvexHullBatchBody;
+
 	public:
 
 		class Edge
@@ -85,6 +92,9 @@ class btConvexHullComputer
 		that the resulting convex hull is empty.
 
 		The output convex hull can be found in the member variables "vertices", "edges", "faces".
+
+		Clouds with many points (tens of thousands) are split over the threads of the current task scheduler (see btParallelFor),
+		the result is identical to the single threaded computation.
 		*/
 		btScalar compute(const float* coords, int stride, int count, btScalar shrink, btScalar shrinkClamp)
 		{
@@ -99,5 +109,40 @@ class btConvexHullComputer
 };
 
 
+/// btConvexHullBatch computes the convex hulls of many point clouds concurrently with btParallelFor.
+/// Every thread keeps its own memory pools, which it reuses for all clouds it processes and across calls, until releaseArenas is called.
+/// The hulls are identical to the ones computed one by one with btConvexHullComputer::compute.
+class btConvexHullBatch
+{
+	private:
+		btConvexHullInternal* m_arenas[BT_MAX_THREAD_COUNT];
+
+		void compute(btConvexHullComputer* hulls, const void* const* coords, bool doubleCoords, const int* counts, int numClouds, int stride, btScalar shrink, btScalar shrinkClamp, btScalar* shifts);
+
+	public:
+		btConvexHullBatch();
+
+		~btConvexHullBatch();
+
+		/*
+		Compute the convex hull of the "counts[i]" vertices at "coords[i]" into "hulls[i]", for each of the "numClouds" clouds.
+		"stride", "shrink" and "shrinkClamp" are the same as for btConvexHullComputer::compute, the returned amounts are stored in "shifts" if it is not NULL.
+		*/
+		void compute(btConvexHullComputer* hulls, const float* const* coords, const int* counts, int numClouds, int stride, btScalar shrink, btScalar shrinkClamp, btScalar* shifts = 0)
+		{
+			compute(hulls, (const void* const*) coords, false, counts, numClouds, stride, shrink, shrinkClamp, shifts);
+		}
+
+		// same as above, but double precision
+		void compute(btConvexHullComputer* hulls, const double* const* coords, const int* counts, int numClouds, int stride, btScalar shrink, btScalar shrinkClamp, btScalar* shifts = 0)
+		{
+			compute(hulls, (const void* const*) coords, true, counts, numClouds, stride, shrink, shrinkClamp, shifts);
+		}
+
+		// frees the memory pools of all threads
+		void releaseArenas();
+};
+
+
 #endif //BT_CONVEX_HULL_COMPUTER_H
 
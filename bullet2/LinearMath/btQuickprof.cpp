@@ -17,6 +17,9 @@
 
 #ifndef BT_NO_PROFILE
 
+#include "btThreads.h"
+#include "btAlignedObjectArray.h"
+
 
 static btClock gProfileClock;
 
@@ -239,16 +242,39 @@ unsigned long int btClock::getTimeMicroseconds()
 
 
 
-inline void Profile_Get_Ticks(unsigned long int * ticks)
+#if !defined(BT_USE_WINDOWS_TIMERS) && !defined(__CELLOS_LV2__)
+#include <time.h>
+#ifdef CLOCK_MONOTONIC
+#define BT_USE_MONOTONIC_PROFILE_TICKS
+#endif //CLOCK_MONOTONIC
+#endif
+
+btProfileTicks	Profile_Get_Ticks(void)
 {
-	*ticks = gProfileClock.getTimeMicroseconds();
+#if defined(BT_USE_WINDOWS_TIMERS)
+	LARGE_INTEGER currentTime;
+	QueryPerformanceCounter(&currentTime);
+	return btProfileTicks(currentTime.QuadPart);
+#elif defined(BT_USE_MONOTONIC_PROFILE_TICKS)
+	struct timespec currentTime;
+	clock_gettime(CLOCK_MONOTONIC, &currentTime);
+	return btProfileTicks(currentTime.tv_sec) * 1000000000 + btProfileTicks(currentTime.tv_nsec);
+#else
+	return gProfileClock.getTimeMicroseconds();
+#endif
 }
 
-inline float Profile_Get_Tick_Rate(void)
+double	Profile_Get_Tick_Rate(void)
 {
-//	return 1000000.f;
-	return 1000.f;
-
+#if defined(BT_USE_WINDOWS_TIMERS)
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return double(frequency.QuadPart) / 1000.;
+#elif defined(BT_USE_MONOTONIC_PROFILE_TICKS)
+	return 1000000.;
+#else
+	return 1000.;
+#endif
 }
 
 
@@ -271,8 +297,9 @@ inline float Profile_Get_Tick_Rate(void)
 CProfileNode::CProfileNode( const char * name, CProfileNode * parent ) :
 	Name( name ),
 	TotalCalls( 0 ),
-	TotalTime( 0 ),
+	TotalTicks( 0 ),
 	StartTime( 0 ),
+	LastTicks( 0 ),
 	RecursionCounter( 0 ),
 	Parent( parent ),
 	Child( NULL ),
@@ -329,7 +356,7 @@ CProfileNode * CProfileNode::Get_Sub_Node( const char * name )
 void	CProfileNode::Reset( void )
 {
 	TotalCalls = 0;
-	TotalTime = 0.0f;
+	TotalTicks = 0;
 	
 
 	if ( Child ) {
@@ -345,7 +372,7 @@ void	CProfileNode::Call( void )
 {
 	TotalCalls++;
 	if (RecursionCounter++ == 0) {
-		Profile_Get_Ticks(&StartTime);
+		StartTime = Profile_Get_Ticks();
 	}
 }
 
@@ -353,15 +380,23 @@ void	CProfileNode::Call( void )
 bool	CProfileNode::Return( void )
 {
 	if ( --RecursionCounter == 0 && TotalCalls != 0 ) { 
-		unsigned long int time;
-		Profile_Get_Ticks(&time);
-		time-=StartTime;
-		TotalTime += (float)time / Profile_Get_Tick_Rate();
+		LastTicks = Profile_Get_Ticks() - StartTime;
+		TotalTicks += LastTicks;
 	}
 	return ( RecursionCounter == 0 );
 }
 
 
+void	CProfileNode::Merge( const CProfileNode * other )
+{
+	TotalCalls += other->TotalCalls;
+	TotalTicks += other->TotalTicks;
+	for (const CProfileNode * child = other->Child; child; child = child->Sibling) {
+		Get_Sub_Node( child->Name )->Merge( child );
+	}
+}
+
+
 /***************************************************************************************************
 **
 ** CProfileIterator
@@ -422,17 +457,58 @@ void	CProfileIterator::Enter_Parent( void )
 **
 ***************************************************************************************************/
 
-CProfileNode	CProfileManager::Root( "Root", NULL );
-CProfileNode *	CProfileManager::CurrentNode = &CProfileManager::Root;
 int				CProfileManager::FrameCounter = 0;
-unsigned long int			CProfileManager::ResetTime = 0;
+btProfileTicks	CProfileManager::ResetTime = 0;
+
+
+///btProfileEvent is a finished sample, recorded for the trace
+struct btProfileEvent
+{
+	const char *	m_name;
+	btProfileTicks	m_startTime;
+	btProfileTicks	m_duration;
+};
+
+///btProfileThreadData is only modified by its own thread while samples are recorded
+struct btProfileThreadData
+{
+	CProfileNode	m_root;
+	CProfileNode *	m_currentNode;
+	btAlignedObjectArray<btProfileEvent>	m_events;
+
+	btProfileThreadData()
+		:m_root( "Root", NULL ),
+		m_currentNode( &m_root )
+	{
+	}
+};
+
+static btProfileThreadData *	gProfileThreadData[BT_MAX_THREAD_COUNT];
+static CProfileNode	gMergedRoot( "Root", NULL );
+
+static bool				gProfileTracing = false;
+static int				gProfileMaxEvents = 0;
+static btProfileTicks	gTraceStartTime = 0;
+
+
+static btProfileThreadData *	Profile_Get_Thread_Data( unsigned int threadIndex )
+{
+	btAssert( threadIndex < BT_MAX_THREAD_COUNT );
+	btProfileThreadData * data = gProfileThreadData[threadIndex];
+	if ( data == NULL ) {
+		data = new btProfileThreadData;
+		data->m_root.Call();
+		gProfileThreadData[threadIndex] = data;
+	}
+	return data;
+}
 
 
 /***********************************************************************************************
  * CProfileManager::Start_Profile -- Begin a named profile                                    *
  *                                                                                             *
- * Steps one level deeper into the tree, if a child already exists with the specified name     *
- * then it accumulates the profiling; otherwise a new child node is added to the profile tree. *
+ * Steps one level deeper into the tree of the calling thread, if a child already exists with  *
+ * the specified name then it accumulates the profiling; otherwise a new child node is added.  *
  *                                                                                             *
  * INPUT:                                                                                      *
  * name - name of this profiling record                                                        *
@@ -443,11 +519,13 @@ unsigned long int			CProfileManager::ResetTime = 0;
  *=============================================================================================*/
 void	CProfileManager::Start_Profile( const char * name )
 {
-	if (name != CurrentNode->Get_Name()) {
-		CurrentNode = CurrentNode->Get_Sub_Node( name );
-	} 
-	
-	CurrentNode->Call();
+	btProfileThreadData * data = Profile_Get_Thread_Data( btGetCurrentThreadIndex() );
+
+	if (name != data->m_currentNode->Get_Name()) {
+		data->m_currentNode = data->m_currentNode->Get_Sub_Node( name );
+	}
+
+	data->m_currentNode->Call();
 }
 
 
@@ -456,26 +534,55 @@ void	CProfileManager::Start_Profile( const char * name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	btProfileThreadData * data = gProfileThreadData[btGetCurrentThreadIndex()];
+	CProfileNode * node = data->m_currentNode;
+
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
-	if (CurrentNode->Return()) {
-		CurrentNode = CurrentNode->Get_Parent();
+	if (node->Return()) {
+		if (gProfileTracing && data->m_events.size() < gProfileMaxEvents) {
+			btProfileEvent& event = data->m_events.expandNonInitializing();
+			event.m_name = node->Get_Name();
+			event.m_startTime = node->Get_Start_Ticks();
+			event.m_duration = node->Get_Last_Ticks();
+		}
+		data->m_currentNode = node->Get_Parent();
+	}
+}
+
+
+void	CProfileManager::CleanupMemory( void )
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		btProfileThreadData * data = gProfileThreadData[i];
+		if ( data ) {
+			data->m_root.CleanupMemory();
+			data->m_currentNode = &data->m_root;
+			data->m_events.clear();
+		}
 	}
+	gMergedRoot.CleanupMemory();
 }
 
 
 /***********************************************************************************************
  * CProfileManager::Reset -- Reset the contents of the profiling system                       *
  *                                                                                             *
- *    This resets everything except for the tree structure.  All of the timing data is reset.  *
+ *    This resets everything except for the tree structures.  All of the timing data is reset. *
  *=============================================================================================*/
 void	CProfileManager::Reset( void )
-{ 
+{
 	gProfileClock.reset();
-	Root.Reset();
-    Root.Call();
+	Profile_Get_Thread_Data( 0 );
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		btProfileThreadData * data = gProfileThreadData[i];
+		if ( data ) {
+			data->m_root.Reset();
+			data->m_root.Call();
+		}
+	}
 	FrameCounter = 0;
-	Profile_Get_Ticks(&ResetTime);
+	ResetTime = Profile_Get_Ticks();
 }
 
 
@@ -493,10 +600,113 @@ void CProfileManager::Increment_Frame_Counter( void )
  *=============================================================================================*/
 float CProfileManager::Get_Time_Since_Reset( void )
 {
-	unsigned long int time;
-	Profile_Get_Ticks(&time);
-	time -= ResetTime;
-	return (float)time / Profile_Get_Tick_Rate();
+	btProfileTicks time = Profile_Get_Ticks() - ResetTime;
+	return float(time / Profile_Get_Tick_Rate());
+}
+
+
+int	CProfileManager::Get_Number_Of_Threads( void )
+{
+	int numThreads = 0;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		if ( gProfileThreadData[i] ) {
+			numThreads = i+1;
+		}
+	}
+	return numThreads;
+}
+
+
+CProfileIterator *	CProfileManager::Get_Iterator( int threadIndex )
+{
+	return new CProfileIterator( &Profile_Get_Thread_Data( threadIndex )->m_root );
+}
+
+
+CProfileIterator *	CProfileManager::Get_Merged_Iterator( void )
+{
+	gMergedRoot.CleanupMemory();
+	gMergedRoot.Reset();
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		if ( gProfileThreadData[i] ) {
+			gMergedRoot.Merge( &gProfileThreadData[i]->m_root );
+		}
+	}
+	//the merged root is the total time of all threads since the reset
+	gMergedRoot.TotalTicks = (Profile_Get_Ticks() - ResetTime) * Get_Number_Of_Threads();
+	return new CProfileIterator( &gMergedRoot );
+}
+
+
+void	CProfileManager::Start_Trace( int maxEventsPerThread )
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		if ( gProfileThreadData[i] ) {
+			gProfileThreadData[i]->m_events.resize(0);
+		}
+	}
+	gProfileMaxEvents = maxEventsPerThread;
+	gTraceStartTime = Profile_Get_Ticks();
+	gProfileTracing = true;
+}
+
+
+void	CProfileManager::Stop_Trace( void )
+{
+	gProfileTracing = false;
+}
+
+
+//writes a JSON string, escaping the characters of the name that can't appear in it as they are
+static void	Write_Json_String( FILE* file, const char * name )
+{
+	fputc( '"', file );
+	for (const char* c=name;*c;c++) {
+		if ( *c == '"' || *c == '\\' ) {
+			fputc( '\\', file );
+			fputc( *c, file );
+		} else if ( (unsigned char)*c < 0x20 ) {
+			fprintf( file, "\\u%04x", (unsigned char)*c );
+		} else {
+			fputc( *c, file );
+		}
+	}
+	fputc( '"', file );
+}
+
+
+bool	CProfileManager::Write_Chrome_Trace( const char * fileName )
+{
+	FILE* file = fopen( fileName, "w" );
+	if ( file == NULL )
+		return false;
+
+	double ticksPerMicrosecond = Profile_Get_Tick_Rate() / 1000.;
+	const char* separator = "";
+	fprintf( file, "{\"traceEvents\":[\n" );
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++) {
+		btProfileThreadData * data = gProfileThreadData[i];
+		if ( data == NULL )
+			continue;
+
+		char threadName[32];
+		sprintf( threadName, "%s %d", i ? "worker" : "main", i );
+		fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":", separator, i );
+		Write_Json_String( file, threadName );
+		fprintf( file, "}}" );
+		separator = ",\n";
+		for (int j=0;j<data->m_events.size();j++) {
+			const btProfileEvent& event = data->m_events[j];
+			double startTime = (double(event.m_startTime) - double(gTraceStartTime)) / ticksPerMicrosecond;
+			fprintf( file, ",\n{\"name\":" );
+			Write_Json_String( file, event.m_name );
+			fprintf( file, ",\"cat\":\"bullet\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				i, startTime, double(event.m_duration) / ticksPerMicrosecond );
+		}
+	}
+	fprintf( file, "\n]}\n" );
+	fclose( file );
+	return true;
 }
 
 #include <stdio.h>
@@ -507,7 +717,9 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 	if (profileIterator->Is_Done())
 		return;
 
-	float accumulated_time=0,parent_time = profileIterator->Is_Root() ? CProfileManager::Get_Time_Since_Reset() : profileIterator->Get_Current_Parent_Total_Time();
+	float accumulated_time=0,parent_time = profileIterator->Get_Current_Parent_Total_Time();
+	if (profileIterator->Is_Root() && parent_time <= 0.f)
+		parent_time = CProfileManager::Get_Time_Since_Reset();
 	int i;
 	int frames_since_reset = CProfileManager::Get_Frame_Count_Since_Reset();
 	for (i=0;i<spacing;i++)	printf(".");
@@ -553,7 +765,7 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 void	CProfileManager::dumpAll()
 {
 	CProfileIterator* profileIterator = 0;
-	profileIterator = CProfileManager::Get_Iterator();
+	profileIterator = CProfileManager::Get_Merged_Iterator();
 
 	dumpRecursive(profileIterator,0);
 
@@ -58,7 +58,17 @@ private:
 
 #endif //USE_BT_CLOCK
 
+#ifdef _MSC_VER
+typedef unsigned __int64	btProfileTicks;
+#else
+typedef unsigned long long int	btProfileTicks;
+#endif
+
+///The profile nodes measure time in ticks of the performance counter on Windows, in nanoseconds of the monotonic clock where it is available, and in microseconds otherwise
+btProfileTicks	Profile_Get_Ticks(void);
 
+///Profile_Get_Tick_Rate returns the number of ticks per millisecond
+double	Profile_Get_Tick_Rate(void);
 
 
 ///A node in the Profile Hierarchy Tree
@@ -79,23 +89,31 @@ public:
 	void				Call( void );
 	bool				Return( void );
 
+	///Merge adds the calls and times of another tree, creating the nodes that are missing
+	void				Merge( const CProfileNode * other );
+
 	const char *	Get_Name( void )				{ return Name; }
 	int				Get_Total_Calls( void )		{ return TotalCalls; }
-	float				Get_Total_Time( void )		{ return TotalTime; }
+	float				Get_Total_Time( void )		{ return float(TotalTicks / Profile_Get_Tick_Rate()); }
+	btProfileTicks	Get_Start_Ticks( void ) const	{ return StartTime; }
+	btProfileTicks	Get_Last_Ticks( void ) const	{ return LastTicks; }
 	void*			GetUserPointer() const {return m_userPtr;}
 	void			SetUserPointer(void* ptr) { m_userPtr = ptr;}
 protected:
 
 	const char *	Name;
 	int				TotalCalls;
-	float				TotalTime;
-	unsigned long int			StartTime;
+	btProfileTicks	TotalTicks;
+	btProfileTicks	StartTime;
+	btProfileTicks	LastTicks;
 	int				RecursionCounter;
 
 	CProfileNode *	Parent;
 	CProfileNode *	Child;
 	CProfileNode *	Sibling;
 	void*	m_userPtr;
+
+	friend	class		CProfileManager;
 };
 
 ///An iterator to navigate through the tree
@@ -138,37 +156,50 @@ protected:
 
 
 ///The Manager for the Profile system
+///Each thread of the task scheduler records into its own profile tree, so BT_PROFILE can be used inside parallel loops.
+///Reset, the iterators and the reports should only be used from the main thread while no parallel loop is running.
 class	CProfileManager {
 public:
 	static	void						Start_Profile( const char * name );
 	static	void						Stop_Profile( void );
 
-	static	void						CleanupMemory(void)
-	{
-		Root.CleanupMemory();
-	}
+	static	void						CleanupMemory(void);
 
 	static	void						Reset( void );
 	static	void						Increment_Frame_Counter( void );
 	static	int						Get_Frame_Count_Since_Reset( void )		{ return FrameCounter; }
 	static	float						Get_Time_Since_Reset( void );
 
+	///number of threads that recorded samples, the main thread has index 0
+	static	int						Get_Number_Of_Threads( void );
+
+	///iterator over the profile tree of the main thread
 	static	CProfileIterator *	Get_Iterator( void )	
 	{ 
-		
-		return new CProfileIterator( &Root ); 
+		return Get_Iterator( 0 ); 
 	}
+	static	CProfileIterator *	Get_Iterator( int threadIndex );
+
+	///iterator over the sum of the profile trees of all threads, it stays valid until the next call
+	static	CProfileIterator *	Get_Merged_Iterator( void );
+
 	static	void						Release_Iterator( CProfileIterator * iterator ) { delete ( iterator); }
 
 	static void	dumpRecursive(CProfileIterator* profileIterator, int spacing);
 
+	///dumpAll prints the merged tree of all threads, the times of the parallel samples are summed over the threads
 	static void	dumpAll();
 
+	///Start_Trace records the start time and duration of every sample, up to maxEventsPerThread per thread
+	static	void						Start_Trace( int maxEventsPerThread = 1024*1024 );
+	static	void						Stop_Trace( void );
+
+	///Write_Chrome_Trace writes the recorded samples in the trace event format of chrome://tracing
+	static	bool						Write_Chrome_Trace( const char * fileName );
+
 private:
-	static	CProfileNode			Root;
-	static	CProfileNode *			CurrentNode;
 	static	int						FrameCounter;
-	static	unsigned long int					ResetTime;
+	static	btProfileTicks			ResetTime;
 };
 
 
@@ -0,0 +1,232 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btThreadSafePoolAllocator.h"
+#include "btPoolAllocator.h"
+#include "btAlignedAllocator.h"
+
+
+btThreadSafePoolAllocator::btThreadSafePoolAllocator(int elemSize, int elementsPerPage)
+	:m_elemSize((elemSize+15)&~15),
+	m_elementsPerPage(elementsPerPage>0 ? elementsPerPage : 1),
+	m_numElements(0),
+	m_sharedFirstFree(0),
+	m_sharedFreeCount(0),
+	m_initialPool(0)
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		m_caches[i].m_firstFree = 0;
+		m_caches[i].m_freeCount = 0;
+	}
+	resetCounters();
+}
+
+btThreadSafePoolAllocator::btThreadSafePoolAllocator(btPoolAllocator* initialPool, int elementsPerPage)
+	:m_elemSize(initialPool->getElementSize()),
+	m_elementsPerPage(elementsPerPage>0 ? elementsPerPage : 1),
+	m_numElements(0),
+	m_sharedFirstFree(0),
+	m_sharedFreeCount(0),
+	m_initialPool(initialPool)
+{
+	btAssert(m_elemSize >= int(sizeof(void*)));
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		m_caches[i].m_firstFree = 0;
+		m_caches[i].m_freeCount = 0;
+	}
+	resetCounters();
+
+	//keep the address order of the pool, so the first allocations are contiguous
+	void** tail = &m_sharedFirstFree;
+	while (initialPool->getFreeCount())
+	{
+		void* ptr = initialPool->allocate(0);
+		*tail = ptr;
+		tail = (void**)ptr;
+		m_sharedFreeCount++;
+	}
+	*tail = 0;
+	m_numElements = m_sharedFreeCount;
+}
+
+btThreadSafePoolAllocator::~btThreadSafePoolAllocator()
+{
+	if (m_initialPool)
+	{
+		for (int i=0;i<=BT_MAX_THREAD_COUNT;i++)
+		{
+			void* ptr = (i<BT_MAX_THREAD_COUNT) ? m_caches[i].m_firstFree : m_sharedFirstFree;
+			while (ptr)
+			{
+				void* next = *(void**)ptr;
+				if (m_initialPool->validPtr(ptr))
+				{
+					m_initialPool->freeMemory(ptr);
+				}
+				ptr = next;
+			}
+		}
+	}
+	for (int i=0;i<m_pages.size();i++)
+	{
+		btAlignedFree(m_pages[i]);
+	}
+}
+
+///addPage links a new page in front of the shared free list, the caller holds m_sharedMutex
+void	btThreadSafePoolAllocator::addPage()
+{
+	unsigned char* page = (unsigned char*)btAlignedAlloc(static_cast<size_t>(m_elemSize*m_elementsPerPage),16);
+	m_pages.push_back(page);
+
+	unsigned char* p = page;
+	for (int i=1;i<m_elementsPerPage;i++)
+	{
+		*(void**)p = p + m_elemSize;
+		p += m_elemSize;
+	}
+	*(void**)p = m_sharedFirstFree;
+	m_sharedFirstFree = page;
+	m_sharedFreeCount += m_elementsPerPage;
+	m_numElements += m_elementsPerPage;
+}
+
+///refillCache moves up to a batch of elements from the shared free list to an empty cache, the caller holds m_sharedMutex
+void	btThreadSafePoolAllocator::refillCache(btThreadCache& cache)
+{
+	btAssert(cache.m_firstFree==0);
+	void* head = m_sharedFirstFree;
+	if (!head)
+		return;
+
+	void* tail = head;
+	int count = 1;
+	while (count < BT_POOL_CACHE_BATCH_SIZE && *(void**)tail)
+	{
+		tail = *(void**)tail;
+		count++;
+	}
+	m_sharedFirstFree = *(void**)tail;
+	m_sharedFreeCount -= count;
+	*(void**)tail = 0;
+
+	cache.m_firstFree = head;
+	cache.m_freeCount = count;
+}
+
+///flushCache moves the first count elements of a cache to the shared free list
+void	btThreadSafePoolAllocator::flushCache(btThreadCache& cache, int count)
+{
+	btAssert(count>0 && count<=cache.m_freeCount);
+	void* head = cache.m_firstFree;
+	void* tail = head;
+	for (int i=1;i<count;i++)
+	{
+		tail = *(void**)tail;
+	}
+	cache.m_firstFree = *(void**)tail;
+	cache.m_freeCount -= count;
+
+	m_sharedMutex.lock();
+	*(void**)tail = m_sharedFirstFree;
+	m_sharedFirstFree = head;
+	m_sharedFreeCount += count;
+	m_sharedMutex.unlock();
+}
+
+void*	btThreadSafePoolAllocator::allocate(int size, bool grow)
+{
+	// release mode fix
+	(void)size;
+	btAssert(!size || size<=m_elemSize);
+
+	btThreadCache& cache = m_caches[btGetCurrentThreadIndex()];
+	if (!cache.m_firstFree)
+	{
+		m_sharedMutex.lock();
+		if (!m_sharedFirstFree)
+		{
+			if (grow)
+			{
+				addPage();
+			}
+			cache.m_numMisses++;
+		} else
+		{
+			cache.m_numHits++;
+		}
+		refillCache(cache);
+		m_sharedMutex.unlock();
+
+		if (!cache.m_firstFree)
+			return 0;
+	} else
+	{
+		cache.m_numHits++;
+	}
+
+	void* result = cache.m_firstFree;
+	cache.m_firstFree = *(void**)result;
+	cache.m_freeCount--;
+	return result;
+}
+
+void	btThreadSafePoolAllocator::freeMemory(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	btThreadCache& cache = m_caches[btGetCurrentThreadIndex()];
+	*(void**)ptr = cache.m_firstFree;
+	cache.m_firstFree = ptr;
+	cache.m_freeCount++;
+
+	//a thread that mostly frees (such as the main thread merging results) hands its surplus back to the others
+	if (cache.m_freeCount > 2*BT_POOL_CACHE_BATCH_SIZE)
+	{
+		flushCache(cache,BT_POOL_CACHE_BATCH_SIZE);
+	}
+}
+
+int	btThreadSafePoolAllocator::getNumHits() const
+{
+	int numHits = 0;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		numHits += m_caches[i].m_numHits;
+	}
+	return numHits;
+}
+
+int	btThreadSafePoolAllocator::getNumMisses() const
+{
+	int numMisses = 0;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		numMisses += m_caches[i].m_numMisses;
+	}
+	return numMisses;
+}
+
+void	btThreadSafePoolAllocator::resetCounters()
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		m_caches[i].m_numHits = 0;
+		m_caches[i].m_numMisses = 0;
+	}
+}
@@ -0,0 +1,105 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_THREAD_SAFE_POOL_ALLOCATOR_H
+#define BT_THREAD_SAFE_POOL_ALLOCATOR_H
+
+#include "btScalar.h"
+#include "btAlignedObjectArray.h"
+#include "btThreads.h"
+
+class btPoolAllocator;
+
+///number of elements that move between a thread cache and the shared free list at once
+#define BT_POOL_CACHE_BATCH_SIZE 32
+
+///The btThreadSafePoolAllocator hands out elements of a fixed size to the threads of the task scheduler.
+///Each thread allocates from and frees to its own cache without locking. The caches exchange batches of elements
+///with a shared free list, and a new page of elements is added when the shared list runs empty.
+class btThreadSafePoolAllocator
+{
+	struct btThreadCache
+	{
+		void*	m_firstFree;
+		int		m_freeCount;
+		int		m_numHits;
+		int		m_numMisses;
+		//keep the caches of different threads on separate cache lines
+		char	m_padding[64-sizeof(void*)-3*sizeof(int)];
+	};
+
+	btThreadCache	m_caches[BT_MAX_THREAD_COUNT];
+
+	int		m_elemSize;
+	int		m_elementsPerPage;
+	int		m_numElements;
+
+	btSpinMutex		m_sharedMutex;
+	void*			m_sharedFirstFree;
+	int				m_sharedFreeCount;
+
+	btAlignedObjectArray<unsigned char*>	m_pages;
+
+	///elements taken over from a btPoolAllocator, they are handed back on destruction
+	btPoolAllocator*	m_initialPool;
+
+	void	addPage();
+
+	void	refillCache(btThreadCache& cache);
+
+	void	flushCache(btThreadCache& cache, int count);
+
+public:
+
+	btThreadSafePoolAllocator(int elemSize, int elementsPerPage);
+
+	///takes over all free elements of initialPool as the first page. The pool has to outlive this allocator.
+	btThreadSafePoolAllocator(btPoolAllocator* initialPool, int elementsPerPage);
+
+	~btThreadSafePoolAllocator();
+
+	///allocate returns 0 if the pool is empty and grow is false. Free elements in the caches of other threads are not considered.
+	void*	allocate(int size, bool grow = true);
+
+	///the element can be freed by any thread, it moves to the cache of the calling thread
+	void	freeMemory(void* ptr);
+
+	int	getElementSize() const
+	{
+		return m_elemSize;
+	}
+
+	///total number of elements, both used and free
+	int	getNumElements() const
+	{
+		return m_numElements;
+	}
+
+	///number of pages that were added, not counting the initial pool
+	int	getNumPages() const
+	{
+		return m_pages.size();
+	}
+
+	///number of allocations that were served from free elements, summed over all threads. Only call when no threads are running.
+	int	getNumHits() const;
+
+	///number of allocations that had to add a page or failed
+	int	getNumMisses() const;
+
+	void	resetCounters();
+};
+
+#endif //BT_THREAD_SAFE_POOL_ALLOCATOR_H
@@ -0,0 +1,513 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btThreads.h"
+#include "btAlignedAllocator.h"
+#include "btMinMax.h"
+#include <new>
+
+#if defined(WIN32) || defined(_WIN32)
+
+#define BT_USE_WIN32_THREADS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define BT_THREAD_LOCAL_STATIC static __declspec( thread )
+
+#else //_WIN32
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#define BT_THREAD_LOCAL_STATIC static __thread
+
+#endif //_WIN32
+
+
+BT_THREAD_LOCAL_STATIC unsigned int gThreadIndex = 0;
+
+static volatile int gThreadsRunningCounter = 0;
+
+unsigned int	btGetCurrentThreadIndex()
+{
+	return gThreadIndex;
+}
+
+bool	btIsMainThread()
+{
+	return gThreadIndex == 0;
+}
+
+bool	btThreadsAreRunning()
+{
+	return gThreadsRunningCounter != 0;
+}
+
+
+#ifdef BT_USE_WIN32_THREADS
+
+int	btAtomicIncrement(volatile int* value)
+{
+	return (int)InterlockedIncrement((volatile LONG*)value);
+}
+
+int	btAtomicAdd(volatile int* value, int amount)
+{
+	return (int)InterlockedExchangeAdd((volatile LONG*)value,amount);
+}
+
+bool	btSpinMutex::tryLock()
+{
+	return InterlockedCompareExchange((volatile LONG*)&m_lock,1,0) == 0;
+}
+
+void	btSpinMutex::unlock()
+{
+	InterlockedExchange((volatile LONG*)&m_lock,0);
+}
+
+static void	btThreadYield()
+{
+	SwitchToThread();
+}
+
+#else //BT_USE_WIN32_THREADS
+
+int	btAtomicIncrement(volatile int* value)
+{
+	return __sync_add_and_fetch(value,1);
+}
+
+int	btAtomicAdd(volatile int* value, int amount)
+{
+	return __sync_fetch_and_add(value,amount);
+}
+
+bool	btSpinMutex::tryLock()
+{
+	return __sync_bool_compare_and_swap(&m_lock,0,1);
+}
+
+void	btSpinMutex::unlock()
+{
+	__sync_lock_release(&m_lock);
+}
+
+static void	btThreadYield()
+{
+	sched_yield();
+}
+
+#endif //BT_USE_WIN32_THREADS
+
+void	btSpinMutex::lock()
+{
+	int spinCount = 0;
+	while (!tryLock())
+	{
+		if (++spinCount > 64)
+		{
+			btThreadYield();
+			spinCount = 0;
+		}
+	}
+}
+
+
+
+///btTaskSchedulerSequential runs the whole range on the calling thread
+class btTaskSchedulerSequential : public btITaskScheduler
+{
+public:
+	btTaskSchedulerSequential()
+		:btITaskScheduler("Sequential")
+	{
+	}
+	virtual int		getMaxNumThreads() const
+	{
+		return 1;
+	}
+	virtual int		getNumThreads() const
+	{
+		return 1;
+	}
+	virtual void	setNumThreads(int numThreads)
+	{
+		(void)numThreads;
+	}
+	virtual void	parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+	{
+		(void)grainSize;
+		body.forLoop(iBegin,iEnd);
+	}
+};
+
+
+
+///btTaskSchedulerDefault keeps a pool of worker threads alive; the calling (main) thread also takes part in each parallelFor
+class btTaskSchedulerDefault : public btITaskScheduler
+{
+	struct btWorkerInfo
+	{
+		btTaskSchedulerDefault*	m_scheduler;
+		unsigned int			m_threadIndex;
+#ifdef BT_USE_WIN32_THREADS
+		HANDLE					m_thread;
+		HANDLE					m_wakeEvent;
+		HANDLE					m_doneEvent;
+#else
+		pthread_t				m_thread;
+#endif
+	};
+
+	btWorkerInfo	m_workers[BT_MAX_THREAD_COUNT];
+	int				m_numWorkers;
+	int				m_numActiveWorkers;
+	bool			m_quit;
+
+	//current job
+	const btIParallelForBody*	m_body;
+	volatile int	m_nextIndex;
+	int				m_endIndex;
+	int				m_grainSize;
+
+#ifndef BT_USE_WIN32_THREADS
+	pthread_mutex_t	m_mutex;
+	pthread_cond_t	m_wakeCondition;
+	pthread_cond_t	m_doneCondition;
+	int				m_jobId;
+	int				m_numWorkersDone;
+#endif
+
+	void	runJob()
+	{
+		for (;;)
+		{
+			int begin = btAtomicAdd(&m_nextIndex,m_grainSize);
+			if (begin >= m_endIndex)
+				break;
+			int end = btMin(begin+m_grainSize,m_endIndex);
+			m_body->forLoop(begin,end);
+		}
+	}
+
+	void	workerLoop(btWorkerInfo* info);
+
+#ifdef BT_USE_WIN32_THREADS
+	static DWORD WINAPI	workerThreadFunc(LPVOID arg)
+	{
+		btWorkerInfo* info = (btWorkerInfo*) arg;
+		info->m_scheduler->workerLoop(info);
+		return 0;
+	}
+#else
+	static void*	workerThreadFunc(void* arg)
+	{
+		btWorkerInfo* info = (btWorkerInfo*) arg;
+		info->m_scheduler->workerLoop(info);
+		return 0;
+	}
+#endif
+
+public:
+
+	btTaskSchedulerDefault(int numThreads);
+
+	virtual ~btTaskSchedulerDefault();
+
+	virtual int		getMaxNumThreads() const
+	{
+		return m_numWorkers+1;
+	}
+	virtual int		getNumThreads() const
+	{
+		return m_numActiveWorkers+1;
+	}
+	virtual void	setNumThreads(int numThreads)
+	{
+		m_numActiveWorkers = btMax(1,btMin(numThreads,getMaxNumThreads()))-1;
+	}
+
+	virtual void	parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body);
+};
+
+
+#ifdef BT_USE_WIN32_THREADS
+
+btTaskSchedulerDefault::btTaskSchedulerDefault(int numThreads)
+	:btITaskScheduler("Win32Threads"),
+	m_numWorkers(0),
+	m_numActiveWorkers(0),
+	m_quit(false),
+	m_body(0),
+	m_nextIndex(0),
+	m_endIndex(0),
+	m_grainSize(1)
+{
+	for (int i=0;i<numThreads-1;i++)
+	{
+		btWorkerInfo& info = m_workers[i];
+		info.m_scheduler = this;
+		info.m_threadIndex = i+1;
+		info.m_wakeEvent = CreateEvent(0,FALSE,FALSE,0);
+		info.m_doneEvent = CreateEvent(0,FALSE,FALSE,0);
+		info.m_thread = CreateThread(0,0,workerThreadFunc,&info,0,0);
+		btAssert(info.m_thread);
+		m_numWorkers++;
+	}
+	m_numActiveWorkers = m_numWorkers;
+}
+
+btTaskSchedulerDefault::~btTaskSchedulerDefault()
+{
+	m_quit = true;
+	for (int i=0;i<m_numWorkers;i++)
+	{
+		SetEvent(m_workers[i].m_wakeEvent);
+	}
+	for (int i=0;i<m_numWorkers;i++)
+	{
+		btWorkerInfo& info = m_workers[i];
+		WaitForSingleObject(info.m_thread,INFINITE);
+		CloseHandle(info.m_thread);
+		CloseHandle(info.m_wakeEvent);
+		CloseHandle(info.m_doneEvent);
+	}
+}
+
+void	btTaskSchedulerDefault::workerLoop(btWorkerInfo* info)
+{
+	gThreadIndex = info->m_threadIndex;
+	for (;;)
+	{
+		WaitForSingleObject(info->m_wakeEvent,INFINITE);
+		if (m_quit)
+			break;
+		runJob();
+		SetEvent(info->m_doneEvent);
+	}
+}
+
+void	btTaskSchedulerDefault::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	m_body = &body;
+	m_nextIndex = iBegin;
+	m_endIndex = iEnd;
+	m_grainSize = btMax(grainSize,1);
+
+	int numActiveWorkers = m_numActiveWorkers;
+	HANDLE doneEvents[BT_MAX_THREAD_COUNT];
+	for (int i=0;i<numActiveWorkers;i++)
+	{
+		doneEvents[i] = m_workers[i].m_doneEvent;
+		SetEvent(m_workers[i].m_wakeEvent);
+	}
+
+	runJob();
+
+	if (numActiveWorkers)
+	{
+		WaitForMultipleObjects(numActiveWorkers,doneEvents,TRUE,INFINITE);
+	}
+	m_body = 0;
+}
+
+static int	btGetNumHardwareThreads()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return int(info.dwNumberOfProcessors);
+}
+
+#else //BT_USE_WIN32_THREADS
+
+btTaskSchedulerDefault::btTaskSchedulerDefault(int numThreads)
+	:btITaskScheduler("PosixThreads"),
+	m_numWorkers(0),
+	m_numActiveWorkers(0),
+	m_quit(false),
+	m_body(0),
+	m_nextIndex(0),
+	m_endIndex(0),
+	m_grainSize(1),
+	m_jobId(0),
+	m_numWorkersDone(0)
+{
+	pthread_mutex_init(&m_mutex,0);
+	pthread_cond_init(&m_wakeCondition,0);
+	pthread_cond_init(&m_doneCondition,0);
+
+	for (int i=0;i<numThreads-1;i++)
+	{
+		btWorkerInfo& info = m_workers[i];
+		info.m_scheduler = this;
+		info.m_threadIndex = i+1;
+		if (pthread_create(&info.m_thread,0,workerThreadFunc,&info) != 0)
+		{
+			btAssert(0);
+			break;
+		}
+		m_numWorkers++;
+	}
+	m_numActiveWorkers = m_numWorkers;
+}
+
+btTaskSchedulerDefault::~btTaskSchedulerDefault()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_wakeCondition);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (int i=0;i<m_numWorkers;i++)
+	{
+		pthread_join(m_workers[i].m_thread,0);
+	}
+	pthread_cond_destroy(&m_doneCondition);
+	pthread_cond_destroy(&m_wakeCondition);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void	btTaskSchedulerDefault::workerLoop(btWorkerInfo* info)
+{
+	gThreadIndex = info->m_threadIndex;
+	int lastJobId = 0;
+
+	pthread_mutex_lock(&m_mutex);
+	for (;;)
+	{
+		while (m_jobId == lastJobId && !m_quit)
+		{
+			pthread_cond_wait(&m_wakeCondition,&m_mutex);
+		}
+		if (m_quit)
+			break;
+		lastJobId = m_jobId;
+
+		//worker thread indices start at 1, the main thread has index 0
+		bool active = int(info->m_threadIndex) <= m_numActiveWorkers;
+		if (active)
+		{
+			pthread_mutex_unlock(&m_mutex);
+			runJob();
+			pthread_mutex_lock(&m_mutex);
+			m_numWorkersDone++;
+			if (m_numWorkersDone == m_numActiveWorkers)
+			{
+				pthread_cond_signal(&m_doneCondition);
+			}
+		}
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void	btTaskSchedulerDefault::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	if (!m_numActiveWorkers)
+	{
+		body.forLoop(iBegin,iEnd);
+		return;
+	}
+
+	pthread_mutex_lock(&m_mutex);
+	m_body = &body;
+	m_nextIndex = iBegin;
+	m_endIndex = iEnd;
+	m_grainSize = btMax(grainSize,1);
+	m_numWorkersDone = 0;
+	m_jobId++;
+	pthread_cond_broadcast(&m_wakeCondition);
+	pthread_mutex_unlock(&m_mutex);
+
+	runJob();
+
+	pthread_mutex_lock(&m_mutex);
+	while (m_numWorkersDone < m_numActiveWorkers)
+	{
+		pthread_cond_wait(&m_doneCondition,&m_mutex);
+	}
+	m_body = 0;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+static int	btGetNumHardwareThreads()
+{
+	long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	return numProcessors > 0 ? int(numProcessors) : 1;
+}
+
+#endif //BT_USE_WIN32_THREADS
+
+
+
+static btTaskSchedulerSequential	gSequentialTaskScheduler;
+static btITaskScheduler*	gTaskScheduler = &gSequentialTaskScheduler;
+
+void	btSetTaskScheduler(btITaskScheduler* taskScheduler)
+{
+	btAssert(!btThreadsAreRunning());
+	gTaskScheduler = taskScheduler ? taskScheduler : &gSequentialTaskScheduler;
+}
+
+btITaskScheduler*	btGetTaskScheduler()
+{
+	return gTaskScheduler;
+}
+
+btITaskScheduler*	btGetSequentialTaskScheduler()
+{
+	return &gSequentialTaskScheduler;
+}
+
+btITaskScheduler*	btCreateDefaultTaskScheduler(int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = btGetNumHardwareThreads();
+	}
+	numThreads = btMax(1,btMin(numThreads,int(BT_MAX_THREAD_COUNT)));
+
+	void* mem = btAlignedAlloc(sizeof(btTaskSchedulerDefault),16);
+	return new (mem) btTaskSchedulerDefault(numThreads);
+}
+
+void	btDeleteTaskScheduler(btITaskScheduler* taskScheduler)
+{
+	if (taskScheduler)
+	{
+		if (gTaskScheduler == taskScheduler)
+		{
+			btSetTaskScheduler(0);
+		}
+		taskScheduler->~btITaskScheduler();
+		btAlignedFree(taskScheduler);
+	}
+}
+
+void	btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	if (iBegin >= iEnd)
+		return;
+
+	if (btThreadsAreRunning() || !btIsMainThread())
+	{
+		//nested parallel sections run on the current thread
+		body.forLoop(iBegin,iEnd);
+		return;
+	}
+
+	gThreadsRunningCounter++;
+	gTaskScheduler->parallelFor(iBegin,iEnd,grainSize,body);
+	gThreadsRunningCounter--;
+}
@@ -0,0 +1,103 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2011 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_THREADS_H
+#define BT_THREADS_H
+
+#include "btScalar.h"
+
+///maximum number of threads (including the main thread) a task scheduler can use
+#define BT_MAX_THREAD_COUNT 64
+
+///btGetCurrentThreadIndex returns 0 for the main thread and 1..n-1 for the worker threads of the task scheduler
+unsigned int	btGetCurrentThreadIndex();
+
+bool	btIsMainThread();
+
+///btThreadsAreRunning returns true while a btParallelFor is in progress
+bool	btThreadsAreRunning();
+
+///btSpinMutex is a light-weight lock for short critical sections, such as pushing onto a shared array
+class btSpinMutex
+{
+	volatile int	m_lock;
+
+public:
+	btSpinMutex()
+		:m_lock(0)
+	{
+	}
+
+	void	lock();
+	void	unlock();
+	bool	tryLock();
+};
+
+///btAtomicIncrement returns the incremented value
+int		btAtomicIncrement(volatile int* value);
+///btAtomicAdd returns the value before the addition
+int		btAtomicAdd(volatile int* value, int amount);
+
+///btIParallelForBody is the loop body that is passed to btParallelFor. forLoop can be called concurrently for disjoint ranges.
+class btIParallelForBody
+{
+public:
+	virtual ~btIParallelForBody() {}
+
+	virtual void	forLoop(int iBegin, int iEnd) const = 0;
+};
+
+///btITaskScheduler distributes the ranges of a btParallelFor over a set of threads
+class btITaskScheduler
+{
+protected:
+	const char*	m_name;
+
+public:
+	btITaskScheduler(const char* name)
+		:m_name(name)
+	{
+	}
+	virtual ~btITaskScheduler() {}
+
+	const char*	getName() const
+	{
+		return m_name;
+	}
+
+	virtual int		getMaxNumThreads() const = 0;
+	virtual int		getNumThreads() const = 0;
+	virtual void	setNumThreads(int numThreads) = 0;
+	virtual void	parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) = 0;
+};
+
+///btSetTaskScheduler selects the task scheduler that is used by btParallelFor. Passing 0 reverts to the sequential scheduler.
+void	btSetTaskScheduler(btITaskScheduler* taskScheduler);
+
+btITaskScheduler*	btGetTaskScheduler();
+
+///the sequential task scheduler runs all ranges on the calling thread
+btITaskScheduler*	btGetSequentialTaskScheduler();
+
+///btCreateDefaultTaskScheduler creates a thread pool (pthreads or Win32 threads), use btDeleteTaskScheduler to destroy it
+btITaskScheduler*	btCreateDefaultTaskScheduler(int numThreads);
+
+void	btDeleteTaskScheduler(btITaskScheduler* taskScheduler);
+
+///btParallelFor splits [iBegin,iEnd) into chunks of grainSize and runs body.forLoop on them using the current task scheduler.
+///Nested calls from within a parallel section run sequentially on the calling thread.
+void	btParallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body);
+
+#endif //BT_THREADS_H
@@ -1629,3 +1629,140 @@ long _mindot_large_v1( const float *vv, const float *vec, unsigned long count, f
 #endif  /* __APPLE__ */
 
 
+
+
+#ifdef BT_USE_SSE2_DOT_KERNEL
+
+#include <emmintrin.h>
+
+//the dot products are evaluated in the same order as btVector3::dot, and ties resolve to the lowest index,
+//so the results are identical to the scalar loop in btVector3::maxDot and btVector3::minDot
+
+static SIMD_FORCE_INLINE __m128 _dot4_sse2( const float *vv, __m128 vx, __m128 vy, __m128 vz )
+{
+    __m128 v0 = _mm_loadu_ps( vv );
+    __m128 v1 = _mm_loadu_ps( vv + 4 );
+    __m128 v2 = _mm_loadu_ps( vv + 8 );
+    __m128 v3 = _mm_loadu_ps( vv + 12 );
+    _MM_TRANSPOSE4_PS( v0, v1, v2, v3 );
+    return _mm_add_ps( _mm_add_ps( _mm_mul_ps( v0, vx ), _mm_mul_ps( v1, vy ) ), _mm_mul_ps( v2, vz ) );
+}
+
+//keeps dot and index in the lanes where mask is set
+static SIMD_FORCE_INLINE void _select4_sse2( __m128 mask, __m128 dot, __m128i index, __m128 &bestDot, __m128i &bestIndex )
+{
+    __m128i maski = _mm_castps_si128( mask );
+    bestDot = _mm_or_ps( _mm_and_ps( mask, dot ), _mm_andnot_ps( mask, bestDot ) );
+    bestIndex = _mm_or_si128( _mm_and_si128( maski, index ), _mm_andnot_si128( maski, bestIndex ) );
+}
+
+//reduces the 8 lanes of two accumulators, lanes that never got a vertex have index -1
+static long _reduce8_sse2( __m128 dot0, __m128i index0, __m128 dot1, __m128i index1, bool findMax, float *dotResult )
+{
+    float dots[8];
+    int indices[8];
+    _mm_storeu_ps( dots, dot0 );
+    _mm_storeu_ps( dots + 4, dot1 );
+    _mm_storeu_si128( (__m128i*) indices, index0 );
+    _mm_storeu_si128( (__m128i*) (indices + 4), index1 );
+    long bestIndex = -1;
+    float bestDot = dots[0];
+    for( int lane = 0; lane < 8; lane++ )
+    {
+        if( indices[lane] < 0 )
+            continue;
+        bool better = findMax ? (dots[lane] > bestDot) : (dots[lane] < bestDot);
+        if( bestIndex < 0 || better || (dots[lane] == bestDot && indices[lane] < bestIndex) )
+        {
+            bestDot = dots[lane];
+            bestIndex = indices[lane];
+        }
+    }
+    *dotResult = bestIndex < 0 ? (findMax ? -SIMD_INFINITY : SIMD_INFINITY) : bestDot;
+    return bestIndex;
+}
+
+long _maxdot_large_sse2( const float *vv, const float *vec, unsigned long count, float *dotResult );
+long _maxdot_large_sse2( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    const __m128 vx = _mm_set1_ps( vec[0] );
+    const __m128 vy = _mm_set1_ps( vec[1] );
+    const __m128 vz = _mm_set1_ps( vec[2] );
+    const __m128i eight = _mm_set1_epi32( 8 );
+    __m128 dotMax0 = _mm_set1_ps( -SIMD_INFINITY );
+    __m128 dotMax1 = dotMax0;
+    __m128i indexMax0 = _mm_set1_epi32( -1 );
+    __m128i indexMax1 = indexMax0;
+    __m128i index0 = _mm_setr_epi32( 0, 1, 2, 3 );
+    __m128i index1 = _mm_setr_epi32( 4, 5, 6, 7 );
+
+    //two independent accumulators hide the latency of the compare and select
+    unsigned long i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        __m128 dot0 = _dot4_sse2( vv + 4*i, vx, vy, vz );
+        __m128 dot1 = _dot4_sse2( vv + 4*i + 16, vx, vy, vz );
+        _select4_sse2( _mm_cmpgt_ps( dot0, dotMax0 ), dot0, index0, dotMax0, indexMax0 );
+        _select4_sse2( _mm_cmpgt_ps( dot1, dotMax1 ), dot1, index1, dotMax1, indexMax1 );
+        index0 = _mm_add_epi32( index0, eight );
+        index1 = _mm_add_epi32( index1, eight );
+    }
+
+    float maxDot;
+    long maxIndex = _reduce8_sse2( dotMax0, indexMax0, dotMax1, indexMax1, true, &maxDot );
+    for( ; i < count; i++ )
+    {
+        const float *v = vv + 4*i;
+        float dot = v[0]*vec[0] + v[1]*vec[1] + v[2]*vec[2];
+        if( dot > maxDot )
+        {
+            maxDot = dot;
+            maxIndex = (long) i;
+        }
+    }
+    *dotResult = maxDot;
+    return maxIndex;
+}
+
+long _mindot_large_sse2( const float *vv, const float *vec, unsigned long count, float *dotResult );
+long _mindot_large_sse2( const float *vv, const float *vec, unsigned long count, float *dotResult )
+{
+    const __m128 vx = _mm_set1_ps( vec[0] );
+    const __m128 vy = _mm_set1_ps( vec[1] );
+    const __m128 vz = _mm_set1_ps( vec[2] );
+    const __m128i eight = _mm_set1_epi32( 8 );
+    __m128 dotMin0 = _mm_set1_ps( SIMD_INFINITY );
+    __m128 dotMin1 = dotMin0;
+    __m128i indexMin0 = _mm_set1_epi32( -1 );
+    __m128i indexMin1 = indexMin0;
+    __m128i index0 = _mm_setr_epi32( 0, 1, 2, 3 );
+    __m128i index1 = _mm_setr_epi32( 4, 5, 6, 7 );
+
+    unsigned long i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        __m128 dot0 = _dot4_sse2( vv + 4*i, vx, vy, vz );
+        __m128 dot1 = _dot4_sse2( vv + 4*i + 16, vx, vy, vz );
+        _select4_sse2( _mm_cmplt_ps( dot0, dotMin0 ), dot0, index0, dotMin0, indexMin0 );
+        _select4_sse2( _mm_cmplt_ps( dot1, dotMin1 ), dot1, index1, dotMin1, indexMin1 );
+        index0 = _mm_add_epi32( index0, eight );
+        index1 = _mm_add_epi32( index1, eight );
+    }
+
+    float minDot;
+    long minIndex = _reduce8_sse2( dotMin0, indexMin0, dotMin1, indexMin1, false, &minDot );
+    for( ; i < count; i++ )
+    {
+        const float *v = vv + 4*i;
+        float dot = v[0]*vec[0] + v[1]*vec[1] + v[2]*vec[2];
+        if( dot < minDot )
+        {
+            minDot = dot;
+            minIndex = (long) i;
+        }
+    }
+    *dotResult = minDot;
+    return minIndex;
+}
+
+#endif //BT_USE_SSE2_DOT_KERNEL
@@ -22,6 +22,12 @@ subject to the following restrictions:
 #include "btMinMax.h"
 #include "btAlignedAllocator.h"
 
+#if !defined (BT_USE_SSE) && !defined (BT_USE_NEON) && !defined (BT_USE_DOUBLE_PRECISION) && (defined (__SSE2__) || defined (_M_X64))
+///Without BT_USE_SSE the maxDot and minDot queries over large arrays still use a SSE2 kernel.
+///It only reads the arrays as float[4], so it doesn't depend on the SIMD layout of btVector3.
+#define BT_USE_SSE2_DOT_KERNEL
+#endif
+
 #ifdef BT_USE_DOUBLE_PRECISION
 #define btVector3Data btVector3DoubleData
 #define btVector3DataName "btVector3DoubleData"
@@ -993,8 +999,10 @@ SIMD_FORCE_INLINE   long    btVector3::maxDot( const btVector3 *array, long arra
         extern long (*_maxdot_large)( const float *array, const float *vec, unsigned long array_count, float *dotOut );
     #endif
     if( array_count < scalar_cutoff )
-#else
-	
+#elif defined (BT_USE_SSE2_DOT_KERNEL)
+    const long scalar_cutoff = 32;
+    long _maxdot_large_sse2( const float *array, const float *vec, unsigned long array_count, float *dotOut );
+    if( array_count < scalar_cutoff )
 #endif//BT_USE_SSE || BT_USE_NEON
     {
         btScalar maxDot = -SIMD_INFINITY;
@@ -1016,6 +1024,8 @@ SIMD_FORCE_INLINE   long    btVector3::maxDot( const btVector3 *array, long arra
     }
 #if defined (BT_USE_SSE) || defined (BT_USE_NEON)
     return _maxdot_large( (float*) array, (float*) &m_floats[0], array_count, &dotOut );
+#elif defined (BT_USE_SSE2_DOT_KERNEL)
+    return _maxdot_large_sse2( (const float*) array, &m_floats[0], array_count, &dotOut );
 #endif
 }
 
@@ -1032,6 +1042,10 @@ SIMD_FORCE_INLINE   long    btVector3::minDot( const btVector3 *array, long arra
         #error unhandled arch!
     #endif
     
+    if( array_count < scalar_cutoff )
+#elif defined (BT_USE_SSE2_DOT_KERNEL)
+    const long scalar_cutoff = 32;
+    long _mindot_large_sse2( const float *array, const float *vec, unsigned long array_count, float *dotOut );
     if( array_count < scalar_cutoff )
 #endif//BT_USE_SSE || BT_USE_NEON
     {
@@ -1056,6 +1070,8 @@ SIMD_FORCE_INLINE   long    btVector3::minDot( const btVector3 *array, long arra
     }
 #if defined (BT_USE_SSE) || defined (BT_USE_NEON)
     return _mindot_large( (float*) array, (float*) &m_floats[0], array_count, &dotOut );
+#elif defined (BT_USE_SSE2_DOT_KERNEL)
+    return _mindot_large_sse2( (const float*) array, &m_floats[0], array_count, &dotOut );
 #endif
 }
 
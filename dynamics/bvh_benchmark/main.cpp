@@ -0,0 +1,251 @@
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/BroadphaseCollision/btWideQuantizedBvh.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <string.h>
+#include <stdlib.h>
+
+//times building the quantized bvh of a large terrain on one thread and on a thread pool (pass the number of threads, default 4),
+//then compares aabb queries, raycasts and convex casts using the binary quantized bvh and the 4-ary btWideQuantizedBvh.
+//Finally it deforms patches of the terrain, times the partial refit of the wide bvh against rebuilding it, and checks
+//that the refit wide bvh reports exactly the leaves whose refit aabbs overlap a query. Returns 0 when all checks pass.
+
+static btScalar randRange(btScalar minRange, btScalar maxRange)
+{
+    return minRange + (maxRange-minRange)*(btScalar(rand())/btScalar(RAND_MAX));
+}
+
+struct CountingTriangleCallback : public btTriangleCallback
+{
+    int             m_numTriangles;
+    unsigned int    m_checksum;
+
+    CountingTriangleCallback() : m_numTriangles(0), m_checksum(0) {}
+
+    virtual void processTriangle(btVector3* triangle, int partId, int triangleIndex)
+    {
+        //the order differs between the trees, the sum doesn't
+        m_numTriangles++;
+        m_checksum += (unsigned int)(partId*7919+triangleIndex);
+    }
+};
+
+struct CountingNodeCallback : public btNodeOverlapCallback
+{
+    int             m_numTriangles;
+    unsigned int    m_checksum;
+
+    CountingNodeCallback() : m_numTriangles(0), m_checksum(0) {}
+
+    virtual void processNode(int partId, int triangleIndex)
+    {
+        m_numTriangles++;
+        m_checksum += (unsigned int)(partId*7919+triangleIndex);
+    }
+};
+
+//the leaves of the binary bvh that overlap the quantized query, without the inner nodes
+static void bruteForceQuery(const btQuantizedBvh* bvh, const btVector3& aabbMin, const btVector3& aabbMax, btNodeOverlapCallback* callback)
+{
+    unsigned short int quantizedMin[3];
+    unsigned short int quantizedMax[3];
+    bvh->quantizeWithClamp(quantizedMin,aabbMin,0);
+    bvh->quantizeWithClamp(quantizedMax,aabbMax,1);
+    const QuantizedNodeArray& nodes = bvh->getQuantizedNodeArray();
+    for (int i=0;i<nodes.size();i++)
+    {
+        if (nodes[i].isLeafNode() && testQuantizedAabbAgainstQuantizedAabb(quantizedMin,quantizedMax,nodes[i].m_quantizedAabbMin,nodes[i].m_quantizedAabbMax))
+            callback->processNode(nodes[i].getPartId(),nodes[i].getTriangleIndex());
+    }
+}
+
+enum QueryType
+{
+    AABB_QUERY,
+    RAYCAST,
+    CONVEXCAST
+};
+
+static const char* queryNames[] = {"aabb","raycast","convexcast"};
+
+static double runQueries(btBvhTriangleMeshShape* shape, QueryType type, const btAlignedObjectArray<btVector3>& from, const btAlignedObjectArray<btVector3>& to, CountingTriangleCallback& callback)
+{
+    const btVector3 castExtents(0.5,0.5,0.5);
+    btClock clock;
+    for (int i=0;i<from.size();i++)
+    {
+        switch (type)
+        {
+        case AABB_QUERY:
+            shape->processAllTriangles(&callback,from[i],to[i]);
+            break;
+        case RAYCAST:
+            shape->performRaycast(&callback,from[i],to[i]);
+            break;
+        case CONVEXCAST:
+            shape->performConvexcast(&callback,from[i],to[i],-castExtents,castExtents);
+            break;
+        }
+    }
+    return double(from.size())*1e6/double(clock.getTimeMicroseconds()+1);
+}
+
+int main(int argc, char* argv[])
+{
+    const int gridSizes[] = {100,300,700};
+    const int numQueries = 100000;
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+    int numFailures = 0;
+
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    srand(1234);
+    printf("triangles  query       binary/s    wide/s      speedup  (triangles reported, binary/wide checksums)\n");
+    for (int g=0;g<int(sizeof(gridSizes)/sizeof(gridSizes[0]));g++)
+    {
+        int n = gridSizes[g];
+        btAlignedObjectArray<btVector3> vertices;
+        btAlignedObjectArray<int> indices;
+        for (int i=0;i<=n;i++)
+        {
+            for (int j=0;j<=n;j++)
+            {
+                vertices.push_back(btVector3(btScalar(i),btSin(i*0.1f)*btCos(j*0.13f)*4.f+randRange(0,0.5),btScalar(j)));
+            }
+        }
+        for (int i=0;i<n;i++)
+        {
+            for (int j=0;j<n;j++)
+            {
+                int v = i*(n+1)+j;
+                indices.push_back(v); indices.push_back(v+1); indices.push_back(v+n+1);
+                indices.push_back(v+1); indices.push_back(v+n+2); indices.push_back(v+n+1);
+            }
+        }
+        btTriangleIndexVertexArray mesh(indices.size()/3,&indices[0],3*sizeof(int),vertices.size(),&vertices[0].m_floats[0],sizeof(btVector3));
+
+        btClock serialClock;
+        btBvhTriangleMeshShape shape(&mesh,true);
+        unsigned long serialBuildTime = serialClock.getTimeMicroseconds();
+
+        btSetTaskScheduler(scheduler);
+        btClock parallelClock;
+        btBvhTriangleMeshShape parallelShape(&mesh,true);
+        unsigned long parallelBuildTime = parallelClock.getTimeMicroseconds();
+        btSetTaskScheduler(0);
+
+        //the tree only depends on the mesh, not on the number of threads
+        const QuantizedNodeArray& serialNodes = shape.getOptimizedBvh()->getQuantizedNodeArray();
+        const QuantizedNodeArray& parallelNodes = parallelShape.getOptimizedBvh()->getQuantizedNodeArray();
+        bool identical = serialNodes.size()==parallelNodes.size() && !memcmp(&serialNodes[0],&parallelNodes[0],serialNodes.size()*sizeof(btQuantizedBvhNode));
+        printf("%-10d bvh build: %lu us on 1 thread, %lu us on %d threads (%s)\n",indices.size()/3,serialBuildTime,parallelBuildTime,
+            scheduler->getNumThreads(),identical ? "identical" : "DIFFERENT");
+
+        btClock buildClock;
+        shape.setUseWideBvh(true);
+        unsigned long buildTime = buildClock.getTimeMicroseconds();
+
+        for (int t=0;t<3;t++)
+        {
+            QueryType type = QueryType(t);
+            btAlignedObjectArray<btVector3> from;
+            btAlignedObjectArray<btVector3> to;
+            for (int q=0;q<numQueries;q++)
+            {
+                btVector3 p(randRange(0,n),randRange(-1,5),randRange(0,n));
+                if (type==AABB_QUERY)
+                {
+                    btVector3 extents(randRange(0.2,2),randRange(0.2,2),randRange(0.2,2));
+                    from.push_back(p-extents);
+                    to.push_back(p+extents);
+                } else
+                {
+                    //mostly downward rays of a few meters, like wheels and character probes
+                    from.push_back(p+btVector3(0,6,0));
+                    to.push_back(p+btVector3(randRange(-3,3),-6,randRange(-3,3)));
+                }
+            }
+
+            CountingTriangleCallback binaryCallback;
+            CountingTriangleCallback wideCallback;
+            shape.setUseWideBvh(false);
+            double binaryRate = runQueries(&shape,type,from,to,binaryCallback);
+            shape.setUseWideBvh(true);
+            double wideRate = runQueries(&shape,type,from,to,wideCallback);
+
+            printf("%-10d %-11s %-11.0f %-11.0f %-8.2f (%d/%d, %08x/%08x)\n",indices.size()/3,queryNames[t],binaryRate,wideRate,wideRate/binaryRate,
+                binaryCallback.m_numTriangles,wideCallback.m_numTriangles,binaryCallback.m_checksum,wideCallback.m_checksum);
+        }
+        printf("%-10d wide bvh: %d nodes, built in %lu us\n",indices.size()/3,shape.getWideBvh()->getNumNodes(),buildTime);
+
+        //move the vertices of small patches up and down, like a deforming terrain, the heights stay within the bvh quantization margin
+        const int patchSize = 16;
+        const int numRefits = 200;
+        btAlignedObjectArray<btScalar> heights;
+        heights.resize(vertices.size());
+        for (int i=0;i<vertices.size();i++)
+        {
+            heights[i] = vertices[i].getY();
+        }
+        btWideQuantizedBvh refitWideBvh;
+        btWideQuantizedBvh rebuiltWideBvh;
+        refitWideBvh.build(shape.getOptimizedBvh());
+        unsigned long shapeRefitTime = 0;
+        unsigned long wideRefitTime = 0;
+        unsigned long wideRebuildTime = 0;
+        for (int r=0;r<numRefits;r++)
+        {
+            int i0 = rand()%(n-patchSize);
+            int j0 = rand()%(n-patchSize);
+            btVector3 aabbMin(BT_LARGE_FLOAT,BT_LARGE_FLOAT,BT_LARGE_FLOAT);
+            btVector3 aabbMax(-BT_LARGE_FLOAT,-BT_LARGE_FLOAT,-BT_LARGE_FLOAT);
+            for (int i=i0;i<=i0+patchSize;i++)
+            {
+                for (int j=j0;j<=j0+patchSize;j++)
+                {
+                    btVector3& v = vertices[i*(n+1)+j];
+                    aabbMin.setMin(v);
+                    aabbMax.setMax(v);
+                    v.setY(heights[i*(n+1)+j]+randRange(-0.5,0.5));
+                    aabbMin.setMin(v);
+                    aabbMax.setMax(v);
+                }
+            }
+
+            btClock shapeClock;
+            shape.partialRefitTree(aabbMin,aabbMax);
+            shapeRefitTime += shapeClock.getTimeMicroseconds();
+
+            btClock refitClock;
+            refitWideBvh.refitPartial(aabbMin,aabbMax);
+            wideRefitTime += refitClock.getTimeMicroseconds();
+
+            btClock rebuildClock;
+            rebuiltWideBvh.build(shape.getOptimizedBvh());
+            wideRebuildTime += rebuildClock.getTimeMicroseconds();
+        }
+
+        //the refit wide bvh has to report every leaf that overlaps, and no more than that, so the bounds are the exact unions of the leaves
+        bool exact = true;
+        for (int q=0;q<1000 && exact;q++)
+        {
+            btVector3 p(randRange(0,n),randRange(-4,5),randRange(0,n));
+            btVector3 extents(randRange(0.2,4),randRange(0.2,4),randRange(0.2,4));
+            CountingNodeCallback expected;
+            CountingNodeCallback refit;
+            CountingNodeCallback shapeRefit;
+            bruteForceQuery(shape.getOptimizedBvh(),p-extents,p+extents,&expected);
+            refitWideBvh.reportAabbOverlappingNodex(&refit,p-extents,p+extents);
+            shape.getWideBvh()->reportAabbOverlappingNodex(&shapeRefit,p-extents,p+extents);
+            exact = refit.m_numTriangles==expected.m_numTriangles && refit.m_checksum==expected.m_checksum &&
+                shapeRefit.m_numTriangles==expected.m_numTriangles && shapeRefit.m_checksum==expected.m_checksum;
+        }
+        printf("%-10d %d partial refits of %dx%d cells: shape (binary+wide) %lu us, wide refit %lu us, wide rebuild %lu us (%s)\n",indices.size()/3,
+            numRefits,patchSize,patchSize,shapeRefitTime,wideRefitTime,wideRebuildTime,exact ? "exact" : "WRONG");
+        if (!exact)
+            numFailures++;
+    }
+    btDeleteTaskScheduler(scheduler);
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
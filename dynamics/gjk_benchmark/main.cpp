@@ -0,0 +1,72 @@
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
+#include "BulletCollision/NarrowPhaseCollision/btPointCollector.h"
+#include "LinearMath/btQuickprof.h"
+
+//measures GJK closest point queries per second between convex hulls of random points on a sphere
+
+static btScalar randRange(btScalar minRange, btScalar maxRange)
+{
+    return minRange + (maxRange-minRange)*(btScalar(rand())/btScalar(RAND_MAX));
+}
+
+static void createHull(btConvexHullShape& hull, int numVertices)
+{
+    for (int i=0;i<numVertices;i++)
+    {
+        btVector3 dir(randRange(-1,1),randRange(-1,1),randRange(-1,1));
+        if (dir.length2() < SIMD_EPSILON)
+            dir.setValue(1,0,0);
+        hull.addPoint(dir.normalized());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int numPairs = 256;
+    const int numQueries = 200000;
+    const int vertexCounts[] = {16,32,64,128,256};
+
+    srand(1234);
+    btVoronoiSimplexSolver simplexSolver;
+    btGjkEpaPenetrationDepthSolver penetrationSolver;
+
+    printf("vertices   queries/s   (separated and penetrating hull pairs)\n");
+    for (int v=0;v<int(sizeof(vertexCounts)/sizeof(vertexCounts[0]));v++)
+    {
+        btConvexHullShape hullA;
+        btConvexHullShape hullB;
+        createHull(hullA,vertexCounts[v]);
+        createHull(hullB,vertexCounts[v]);
+
+        btAlignedObjectArray<btTransform> transformsA;
+        btAlignedObjectArray<btTransform> transformsB;
+        for (int i=0;i<numPairs;i++)
+        {
+            btQuaternion rotA(btVector3(randRange(-1,1),randRange(-1,1),randRange(-1,1)).normalized(),randRange(0,SIMD_2_PI));
+            btQuaternion rotB(btVector3(randRange(-1,1),randRange(-1,1),randRange(-1,1)).normalized(),randRange(0,SIMD_2_PI));
+            transformsA.push_back(btTransform(rotA,btVector3(0,0,0)));
+            //distances between 1.6 and 2.4 give a mix of touching, penetrating and separated pairs
+            transformsB.push_back(btTransform(rotB,btVector3(randRange(1.6,2.4),randRange(-0.2,0.2),randRange(-0.2,0.2))));
+        }
+
+        btScalar checksum = 0.f;
+        btClock clock;
+        for (int q=0;q<numQueries;q++)
+        {
+            int i = q % numPairs;
+            btGjkPairDetector::ClosestPointInput input;
+            input.m_transformA = transformsA[i];
+            input.m_transformB = transformsB[i];
+            btPointCollector result;
+            btGjkPairDetector detector(&hullA,&hullB,&simplexSolver,&penetrationSolver);
+            detector.getClosestPoints(input,result,0);
+            checksum += result.m_distance;
+        }
+        unsigned long int microseconds = clock.getTimeMicroseconds();
+        printf("%8d   %9.0f   (checksum %f)\n",vertexCounts[v],double(numQueries)*1e6/double(microseconds),checksum);
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+		project "gjk_benchmark"
+
+		language "C++"
+				
+		kind "ConsoleApp"
+		targetdir "../../bin"
+
+  		includedirs {
+                ".",
+                "../../bullet2",
+                }
+
+		links {
+			"BulletCollision",
+			"LinearMath"
+		}
+
+		files {
+		"main.cpp"
+		}
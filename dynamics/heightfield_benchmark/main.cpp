@@ -0,0 +1,266 @@
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
+#include "LinearMath/btQuickprof.h"
+#include <stdio.h>
+
+//checks the box contacts of btHeightfieldConvexCollisionAlgorithm on a ridge, in a valley and on a spike, then drops spheres, capsules and boxes
+//on a bumpy heightfield with and without the algorithm and compares the time per frame. Returns 0 when all checks pass.
+
+static int numFailures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n",message);
+        numFailures++;
+    }
+}
+
+struct TerrainWorld
+{
+    btDefaultCollisionConfiguration* m_collisionConfiguration;
+    btCollisionDispatcher* m_dispatcher;
+    btDbvtBroadphase* m_broadphase;
+    btSequentialImpulseConstraintSolver* m_solver;
+    btDiscreteDynamicsWorld* m_world;
+    btHeightfieldTerrainShape* m_terrainShape;
+    btRigidBody* m_terrain;
+    btAlignedObjectArray<btCollisionShape*> m_shapes;
+
+    TerrainWorld(bool useHeightfieldAlgorithm, int size, const btScalar* heights, btScalar minHeight, btScalar maxHeight)
+    {
+        btDefaultCollisionConstructionInfo info;
+        info.m_useHeightfieldCollisionAlgorithm = useHeightfieldAlgorithm;
+        m_collisionConfiguration = new btDefaultCollisionConfiguration(info);
+        m_dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+        m_broadphase = new btDbvtBroadphase();
+        m_solver = new btSequentialImpulseConstraintSolver();
+        m_world = new btDiscreteDynamicsWorld(m_dispatcher,m_broadphase,m_solver,m_collisionConfiguration);
+        m_terrainShape = new btHeightfieldTerrainShape(size,size,heights,1.f,minHeight,maxHeight,1,PHY_FLOAT,false);
+        m_terrainShape->buildMinMaxMips();
+        m_terrain = new btRigidBody(0.f,0,m_terrainShape);
+        m_world->addRigidBody(m_terrain);
+    }
+
+    ~TerrainWorld()
+    {
+        for (int i=m_world->getNumCollisionObjects()-1;i>=0;i--)
+        {
+            btRigidBody* body = btRigidBody::upcast(m_world->getCollisionObjectArray()[i]);
+            m_world->removeRigidBody(body);
+            delete body;
+        }
+        for (int i=0;i<m_shapes.size();i++)
+        {
+            delete m_shapes[i];
+        }
+        delete m_terrainShape;
+        delete m_world;
+        delete m_solver;
+        delete m_broadphase;
+        delete m_dispatcher;
+        delete m_collisionConfiguration;
+    }
+
+    btRigidBody* addBody(btCollisionShape* shape, const btTransform& transform, btScalar mass)
+    {
+        m_shapes.push_back(shape);
+        btVector3 inertia(0,0,0);
+        if (mass>0.f)
+            shape->calculateLocalInertia(mass,inertia);
+        btRigidBody* body = new btRigidBody(mass,0,shape,inertia);
+        body->setWorldTransform(transform);
+        m_world->addRigidBody(body);
+        return body;
+    }
+
+    //the contacts between the terrain and body, after a collision pass without stepping
+    btPersistentManifold* findManifold()
+    {
+        m_world->performDiscreteCollisionDetection();
+        for (int i=0;i<m_dispatcher->getNumManifolds();i++)
+        {
+            btPersistentManifold* manifold = m_dispatcher->getManifoldByIndexInternal(i);
+            if (manifold->getNumContacts())
+                return manifold;
+        }
+        return 0;
+    }
+};
+
+//a box lying across a ridge touches it with its lowest edge only, no vertex of either shape is inside the other
+static void checkRidge()
+{
+    const int size = 9;
+    btScalar heights[size*size];
+    for (int y=0;y<size;y++)
+    {
+        for (int x=0;x<size;x++)
+        {
+            heights[y*size+x] = 4.f-btFabs(btScalar(x-size/2))*0.5f;
+        }
+    }
+    //the local origin is halfway between the min and max height, so the ridge is at height 2
+    TerrainWorld world(true,size,heights,0.f,4.f);
+    btTransform transform(btQuaternion(btVector3(1,0,0),SIMD_HALF_PI*0.5f),btVector3(0.f,1.9f+SIMDSQRT12,0.5f));
+    world.addBody(new btBoxShape(btVector3(2.f,0.5f,0.5f)),transform,1.f);
+
+    btPersistentManifold* manifold = world.findManifold();
+    check(manifold!=0,"no contact between a box edge and a ridge");
+    if (manifold)
+    {
+        const btManifoldPoint& pt = manifold->getContactPoint(0);
+        btScalar expected = -0.1f-world.m_terrainShape->getMargin();
+        check(btFabs(pt.getDistance()-expected)<1e-3f,"wrong depth of the box edge contact on the ridge");
+        check(btFabs(btFabs(pt.m_normalWorldOnB.getY())-1.f)<1e-3f,"the box edge contact on the ridge isn't vertical");
+        printf("ridge: %d contacts, depth %f (expected %f)\n",manifold->getNumContacts(),pt.getDistance(),expected);
+    }
+}
+
+//a box hanging above the bottom of a valley doesn't touch it. Both triangles fall away from the bottom edge downwards, which must not
+//give an edge contact that pulls the box into the terrain
+static void checkValley()
+{
+    const int size = 9;
+    btScalar heights[size*size];
+    for (int y=0;y<size;y++)
+    {
+        for (int x=0;x<size;x++)
+        {
+            heights[y*size+x] = btFabs(btScalar(x-size/2))*0.5f;
+        }
+    }
+    //the valley bottom is at height -1, the box bottom 0.3 above it and 0.2 above the slopes
+    TerrainWorld world(true,size,heights,0.f,2.f);
+    world.addBody(new btBoxShape(btVector3(0.2f,0.5f,2.f)),btTransform(btQuaternion::getIdentity(),btVector3(0.f,-0.2f,0.3f)),1.f);
+
+    btPersistentManifold* manifold = world.findManifold();
+    check(manifold==0,"a box above a valley touches the terrain");
+    printf("valley: %d contacts\n",manifold ? manifold->getNumContacts() : 0);
+}
+
+//a spike of the terrain pokes into the bottom of a box, its vertex is shared by 4 cells and gives 1 contact
+static void checkSpike()
+{
+    const int size = 9;
+    btScalar heights[size*size];
+    for (int i=0;i<size*size;i++)
+    {
+        heights[i] = 0.f;
+    }
+    heights[(size/2)*size+size/2] = 1.f;
+    TerrainWorld world(true,size,heights,0.f,1.f);
+    world.addBody(new btBoxShape(btVector3(2.f,0.5f,2.f)),btTransform(btQuaternion::getIdentity(),btVector3(0.f,0.7f,0.f)),1.f);
+
+    btPersistentManifold* manifold = world.findManifold();
+    check(manifold && manifold->getNumContacts()==1,"a terrain vertex inside a box doesn't give exactly 1 contact");
+    if (manifold)
+    {
+        const btManifoldPoint& pt = manifold->getContactPoint(0);
+        btScalar expected = -0.3f-world.m_terrainShape->getMargin();
+        check(btFabs(pt.getDistance()-expected)<1e-3f,"wrong depth of the terrain vertex inside the box");
+        printf("spike: %d contacts, depth %f (expected %f)\n",manifold->getNumContacts(),pt.getDistance(),expected);
+    }
+}
+
+static btScalar terrainHeight(const btScalar* heights, int size, btScalar x, btScalar z)
+{
+    //the lowest of the 4 samples of the cell, the triangles of a cell are within the range of its samples
+    btScalar fx = btMax(btMin(x+btScalar(size-1)/2.f,btScalar(size-1)-1e-3f),0.f);
+    btScalar fz = btMax(btMin(z+btScalar(size-1)/2.f,btScalar(size-1)-1e-3f),0.f);
+    int ix = int(fx);
+    int iz = int(fz);
+    btScalar h0 = heights[iz*size+ix];
+    btScalar h1 = heights[iz*size+ix+1];
+    btScalar h2 = heights[(iz+1)*size+ix];
+    btScalar h3 = heights[(iz+1)*size+ix+1];
+    return btMin(btMin(h0,h1),btMin(h2,h3));
+}
+
+static void benchmark()
+{
+    const int size = 129;
+    const int numBodies = 600;
+    const int numFrames = 300;
+    btAlignedObjectArray<btScalar> heights;
+    heights.resize(size*size);
+    btScalar minHeight = BT_LARGE_FLOAT;
+    btScalar maxHeight = -BT_LARGE_FLOAT;
+    for (int z=0;z<size;z++)
+    {
+        for (int x=0;x<size;x++)
+        {
+            btScalar h = 2.f*btSin(x*0.11f)*btCos(z*0.07f)+0.5f*btSin(x*0.9f+z*0.6f);
+            heights[z*size+x] = h;
+            minHeight = btMin(minHeight,h);
+            maxHeight = btMax(maxHeight,h);
+        }
+    }
+    btScalar originHeight = (minHeight+maxHeight)/2.f;
+
+    printf("%d bodies on a %dx%d heightfield, %d frames\n",numBodies,size-1,size-1,numFrames);
+    printf("algorithm                               us/frame   contacts   bodies on the terrain, lowest above the terrain\n");
+    for (int run=0;run<2;run++)
+    {
+        bool useHeightfieldAlgorithm = run==1;
+        TerrainWorld world(useHeightfieldAlgorithm,size,&heights[0],minHeight,maxHeight);
+        srand(4321);
+        btAlignedObjectArray<btRigidBody*> bodies;
+        for (int i=0;i<numBodies;i++)
+        {
+            btCollisionShape* shape;
+            switch (i%3)
+            {
+            case 0: shape = new btSphereShape(0.5f); break;
+            case 1: shape = new btCapsuleShape(0.3f,0.8f); break;
+            default: shape = new btBoxShape(btVector3(0.5f,0.3f,0.4f));
+            }
+            btScalar x = (btScalar(rand())/RAND_MAX-0.5f)*btScalar(size-8);
+            btScalar z = (btScalar(rand())/RAND_MAX-0.5f)*btScalar(size-8);
+            btQuaternion rotation(btVector3(btScalar(rand())/RAND_MAX,1.f,btScalar(rand())/RAND_MAX).normalized(),btScalar(rand())/RAND_MAX*SIMD_2_PI);
+            btScalar y = terrainHeight(&heights[0],size,x,z)-originHeight+3.5f;
+            bodies.push_back(world.addBody(shape,btTransform(rotation,btVector3(x,y,z)),1.f));
+        }
+
+        btClock clock;
+        for (int f=0;f<numFrames;f++)
+        {
+            world.m_world->stepSimulation(1.f/60.f,0);
+        }
+        unsigned long us = clock.getTimeMicroseconds();
+
+        int numContacts = 0;
+        for (int i=0;i<world.m_dispatcher->getNumManifolds();i++)
+        {
+            numContacts += world.m_dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+        }
+        //no body may sink into the terrain, its center stays above the lowest sample of the cell below it.
+        //Bodies that rolled off the edge of the terrain are not counted
+        btScalar lowest = BT_LARGE_FLOAT;
+        int numOnTerrain = 0;
+        for (int i=0;i<bodies.size();i++)
+        {
+            const btVector3& p = bodies[i]->getWorldTransform().getOrigin();
+            if (btFabs(p.getX())>btScalar(size-1)/2.f || btFabs(p.getZ())>btScalar(size-1)/2.f)
+                continue;
+            numOnTerrain++;
+            btScalar below = p.getY()-(terrainHeight(&heights[0],size,p.getX(),p.getZ())-originHeight);
+            lowest = btMin(lowest,below);
+        }
+        printf("%-39s %8.1f   %8d   %d, %f\n",useHeightfieldAlgorithm ? "btHeightfieldConvexCollisionAlgorithm" : "btConvexConcaveCollisionAlgorithm",
+            us/btScalar(numFrames),numContacts,numOnTerrain,lowest);
+        check(lowest>0.f,"a body sank into the terrain");
+    }
+}
+
+int main()
+{
+    checkRidge();
+    checkValley();
+    checkSpike();
+    benchmark();
+
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
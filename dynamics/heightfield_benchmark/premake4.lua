@@ -0,0 +1,21 @@
+		project "heightfield_benchmark"
+
+		language "C++"
+				
+		kind "ConsoleApp"
+		targetdir "../../bin"
+
+  		includedirs {
+                ".",
+                "../../bullet2",
+                }
+
+		links {
+			"BulletDynamics",
+			"BulletCollision",
+			"LinearMath"
+		}
+
+		files {
+		"main.cpp"
+		}
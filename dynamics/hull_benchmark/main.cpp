@@ -0,0 +1,235 @@
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/CollisionShapes/btShapeHull.h"
+#include "LinearMath/btConvexHullComputer.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//computes the convex hulls of random point clouds on one thread and split over a thread pool (pass the number of threads, default 4),
+//checks that the vertices, edges and faces are bit-identical and prints the times. The same is done for btConvexHullBatch
+//with many small clouds and for btShapeHull::buildHulls. Returns 0 when all hulls are identical.
+
+static int numFailures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n",message);
+        numFailures++;
+    }
+}
+
+static btScalar randRange(btScalar minRange, btScalar maxRange)
+{
+    return minRange + (maxRange-minRange)*(btScalar(rand())/btScalar(RAND_MAX));
+}
+
+enum CloudType
+{
+    CUBE_CLOUD,
+    SPHERE_CLOUD,
+    GRID_CLOUD,
+    NUM_CLOUD_TYPES
+};
+
+static const char* cloudNames[] = {"cube","sphere","grid"};
+
+//uniform points in a cube have small hulls, points on a sphere are almost all on the hull, and the integer grid has
+//duplicate points and coplanar faces
+static void makeCloud(CloudType type, int count, btAlignedObjectArray<btVector3>& points)
+{
+    points.resize(count);
+    for (int i=0;i<count;i++)
+    {
+        switch (type)
+        {
+        case CUBE_CLOUD:
+            points[i].setValue(randRange(-1,1),randRange(-1,1),randRange(-1,1));
+            break;
+        case SPHERE_CLOUD:
+        {
+            btVector3 p;
+            do
+            {
+                p.setValue(randRange(-1,1),randRange(-1,1),randRange(-1,1));
+            } while (p.length2()<0.01f || p.length2()>1.f);
+            points[i] = p.normalized()*10.f;
+            break;
+        }
+        default:
+            points[i].setValue(btScalar(rand()%20),btScalar(rand()%20),btScalar(rand()%20));
+        }
+    }
+}
+
+//the w component of the vertices is not set by the hull computation, so only x, y and z are compared
+static bool identicalHulls(const btConvexHullComputer& a, const btConvexHullComputer& b)
+{
+    if (a.vertices.size()!=b.vertices.size() || a.edges.size()!=b.edges.size() || a.faces.size()!=b.faces.size())
+        return false;
+    for (int i=0;i<a.vertices.size();i++)
+    {
+        if (memcmp(a.vertices[i].m_floats,b.vertices[i].m_floats,3*sizeof(btScalar)))
+            return false;
+    }
+    return (!a.edges.size() || !memcmp(&a.edges[0],&b.edges[0],a.edges.size()*sizeof(btConvexHullComputer::Edge))) &&
+        (!a.faces.size() || !memcmp(&a.faces[0],&b.faces[0],a.faces.size()*sizeof(int)));
+}
+
+static void compareLargeClouds(btITaskScheduler* scheduler)
+{
+    const int counts[] = {20000,100000,400000};
+    printf("cloud   points    hull vertices  1 thread us  %d threads us  speedup\n",scheduler->getNumThreads());
+    for (int t=0;t<NUM_CLOUD_TYPES;t++)
+    {
+        for (int c=0;c<int(sizeof(counts)/sizeof(counts[0]));c++)
+        {
+            btAlignedObjectArray<btVector3> points;
+            makeCloud(CloudType(t),counts[c],points);
+
+            btConvexHullComputer serial;
+            btClock serialClock;
+            btScalar serialShift = serial.compute(&points[0].getX(),sizeof(btVector3),points.size(),0.f,0.f);
+            unsigned long serialTime = serialClock.getTimeMicroseconds();
+
+            btSetTaskScheduler(scheduler);
+            btConvexHullComputer parallel;
+            btClock parallelClock;
+            btScalar parallelShift = parallel.compute(&points[0].getX(),sizeof(btVector3),points.size(),0.f,0.f);
+            unsigned long parallelTime = parallelClock.getTimeMicroseconds();
+            btSetTaskScheduler(0);
+
+            bool identical = identicalHulls(serial,parallel) && serialShift==parallelShift;
+            printf("%-7s %-9d %-14d %-12lu %-13lu %.2f %s\n",cloudNames[t],counts[c],serial.vertices.size(),serialTime,parallelTime,
+                double(serialTime)/double(parallelTime+1),identical ? "" : "DIFFERENT");
+            check(identical,"the parallel hull differs from the serial hull");
+        }
+    }
+
+    //the double precision path and a shrunken hull, which uses the faces of the hull
+    btAlignedObjectArray<btVector3> points;
+    makeCloud(SPHERE_CLOUD,50000,points);
+    btAlignedObjectArray<double> coords;
+    for (int i=0;i<points.size();i++)
+    {
+        coords.push_back(points[i].getX());
+        coords.push_back(points[i].getY());
+        coords.push_back(points[i].getZ());
+    }
+    btConvexHullComputer serial;
+    btScalar serialShift = serial.compute(&coords[0],3*sizeof(double),points.size(),0.1f,0.f);
+    btSetTaskScheduler(scheduler);
+    btConvexHullComputer parallel;
+    btScalar parallelShift = parallel.compute(&coords[0],3*sizeof(double),points.size(),0.1f,0.f);
+    btSetTaskScheduler(0);
+    check(identicalHulls(serial,parallel) && serialShift==parallelShift,"the parallel shrunken double precision hull differs from the serial hull");
+}
+
+static void compareBatch(btITaskScheduler* scheduler)
+{
+    const int numClouds = 2000;
+    btAlignedObjectArray<btAlignedObjectArray<btVector3> > clouds;
+    btAlignedObjectArray<const float*> coords;
+    btAlignedObjectArray<int> counts;
+    clouds.resize(numClouds);
+    for (int i=0;i<numClouds;i++)
+    {
+        makeCloud(CloudType(i%NUM_CLOUD_TYPES),50+rand()%450,clouds[i]);
+        coords.push_back(&clouds[i][0].getX());
+        counts.push_back(clouds[i].size());
+    }
+
+    btAlignedObjectArray<btConvexHullComputer> serial;
+    serial.resize(numClouds);
+    btClock serialClock;
+    for (int i=0;i<numClouds;i++)
+    {
+        serial[i].compute(coords[i],sizeof(btVector3),counts[i],0.f,0.f);
+    }
+    unsigned long serialTime = serialClock.getTimeMicroseconds();
+
+    btSetTaskScheduler(scheduler);
+    btConvexHullBatch batch;
+    btAlignedObjectArray<btConvexHullComputer> batched;
+    batched.resize(numClouds);
+    btClock batchClock;
+    batch.compute(&batched[0],&coords[0],&counts[0],numClouds,sizeof(btVector3),0.f,0.f);
+    unsigned long batchTime = batchClock.getTimeMicroseconds();
+    btSetTaskScheduler(0);
+
+    int numDifferent = 0;
+    for (int i=0;i<numClouds;i++)
+    {
+        if (!identicalHulls(serial[i],batched[i]))
+            numDifferent++;
+    }
+    printf("%d clouds of 50-500 points: one by one %lu us, btConvexHullBatch %lu us, %d different\n",numClouds,serialTime,batchTime,numDifferent);
+    check(!numDifferent,"btConvexHullBatch differs from btConvexHullComputer::compute");
+}
+
+static void compareShapeHulls(btITaskScheduler* scheduler)
+{
+    const int numShapes = 200;
+    btAlignedObjectArray<btConvexHullShape*> shapes;
+    btAlignedObjectArray<btShapeHull*> serial;
+    btAlignedObjectArray<btShapeHull*> parallel;
+    for (int i=0;i<numShapes;i++)
+    {
+        btAlignedObjectArray<btVector3> points;
+        makeCloud(CloudType(i%NUM_CLOUD_TYPES),100,points);
+        shapes.push_back(new btConvexHullShape(&points[0].getX(),points.size(),sizeof(btVector3)));
+        serial.push_back(new btShapeHull(shapes[i]));
+        parallel.push_back(new btShapeHull(shapes[i]));
+    }
+
+    btClock serialClock;
+    int numSerial = 0;
+    for (int i=0;i<numShapes;i++)
+    {
+        numSerial += serial[i]->buildHull(0.f) ? 1 : 0;
+    }
+    unsigned long serialTime = serialClock.getTimeMicroseconds();
+
+    btSetTaskScheduler(scheduler);
+    btClock parallelClock;
+    int numParallel = btShapeHull::buildHulls(&parallel[0],numShapes,0.f);
+    unsigned long parallelTime = parallelClock.getTimeMicroseconds();
+    btSetTaskScheduler(0);
+
+    int numDifferent = 0;
+    for (int i=0;i<numShapes;i++)
+    {
+        bool identical = serial[i]->numVertices()==parallel[i]->numVertices() && serial[i]->numIndices()==parallel[i]->numIndices();
+        for (int j=0;identical && j<serial[i]->numVertices();j++)
+        {
+            identical = !memcmp(serial[i]->getVertexPointer()[j].m_floats,parallel[i]->getVertexPointer()[j].m_floats,3*sizeof(btScalar));
+        }
+        identical = identical && (!serial[i]->numIndices() ||
+            !memcmp(serial[i]->getIndexPointer(),parallel[i]->getIndexPointer(),serial[i]->numIndices()*sizeof(unsigned int)));
+        if (!identical)
+            numDifferent++;
+        delete serial[i];
+        delete parallel[i];
+        delete shapes[i];
+    }
+    printf("%d shape hulls: buildHull %lu us, buildHulls %lu us, %d/%d built, %d different\n",numShapes,serialTime,parallelTime,numSerial,numParallel,numDifferent);
+    check(!numDifferent && numSerial==numParallel,"btShapeHull::buildHulls differs from buildHull");
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    srand(2011);
+    compareLargeClouds(scheduler);
+    compareBatch(scheduler);
+    compareShapeHulls(scheduler);
+
+    btDeleteTaskScheduler(scheduler);
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
@@ -0,0 +1,403 @@
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "LinearMath/btThreads.h"
+#include <stdlib.h>
+#include <string.h>
+
+//steps a scene of separate stacks of boxes and hinge chains, one island each, with the islands solved serially and with
+//btDiscreteDynamicsWorld::setNumTasks on a thread pool (pass the number of tasks, default 4), and checks that the bodies end up bitwise identical.
+//The parallel run is repeated with a derived solver, to check that its task solvers are of its own type and give the same result.
+//Finally the scene runs with persistent islands while boxes are added and removed and a kinematic box pushes through a row of stacks,
+//and the islands of every frame are checked against islands rebuilt from scratch.
+
+static const int numStacks = 48;
+static const int stackHeight = 6;
+static const int numChains = 16;
+static const int chainLength = 8;
+static const int numFrames = 180;
+
+//groups solved by the task solvers that CountingSolver creates, several tasks can add to it at the same time
+static int gNumTaskSolverGroups = 0;
+
+//the task solvers of a CountingSolver are CountingSolvers too, and count the groups they solve
+class CountingSolver : public btSequentialImpulseConstraintSolver
+{
+    bool m_isTaskSolver;
+
+public:
+    CountingSolver() : m_isTaskSolver(false) {}
+
+    virtual btScalar solveGroup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifold,int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,btDispatcher* dispatcher)
+    {
+        if (m_isTaskSolver)
+            btAtomicAdd(&gNumTaskSolverGroups,1);
+        return btSequentialImpulseConstraintSolver::solveGroup(bodies,numBodies,manifold,numManifolds,constraints,numConstraints,info,debugDrawer,stackAlloc,dispatcher);
+    }
+
+    virtual btConstraintSolver* createTaskSolver() const
+    {
+        void* mem = btAlignedAlloc(sizeof(CountingSolver),16);
+        CountingSolver* solver = new (mem) CountingSolver;
+        copySolverSettings(*solver);
+        solver->m_isTaskSolver = true;
+        return solver;
+    }
+};
+
+template <class T>
+struct PointerLess
+{
+    bool operator()(const T& a, const T& b) const
+    {
+        return a < b;
+    }
+};
+
+struct ManifoldRecorder : public btSimulationIslandManager::IslandCallback
+{
+    btAlignedObjectArray<btPersistentManifold*>* m_manifolds;
+
+    virtual void processIsland(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifolds,int numManifolds,int islandId)
+    {
+        for (int i=0;i<numManifolds;i++)
+            m_manifolds->push_back(manifolds[i]);
+    }
+};
+
+//before the islands of a frame are solved, RebuildCheckingSolver builds them again with an island manager without persistent islands.
+//The awake islands have to contain the same objects, and the manifolds passed to solveGroup have to be the rebuilt ones of the awake islands.
+//A sleeping object that a kinematic object wakes up while the islands are built joins the islands in the next frame with persistent islands,
+//the rebuilt islands add its manifolds that come after the one with the kinematic object, so those are left out
+class RebuildCheckingSolver : public btSequentialImpulseConstraintSolver
+{
+    btSimulationIslandManager m_rebuildIslandManager;
+
+    //the island of every object as the smallest index of the objects in it, -1 outside the awake islands
+    static void getIslandLabels(btCollisionObjectArray& objects, btAlignedObjectArray<int>& labels)
+    {
+        btHashMap<btHashInt,int> islandMin;
+        btHashMap<btHashInt,int> islandAwake;
+        int i;
+        for (i=0;i<objects.size();i++)
+        {
+            int tag = objects[i]->getIslandTag();
+            if (tag<0)
+                continue;
+            if (!islandMin.find(tag))
+                islandMin.insert(tag,i);
+            if (objects[i]->isActive())
+                islandAwake.insert(tag,1);
+        }
+        labels.resize(objects.size());
+        for (i=0;i<objects.size();i++)
+        {
+            int tag = objects[i]->getIslandTag();
+            labels[i] = tag>=0 && islandAwake.find(tag) ? *islandMin.find(tag) : -1;
+        }
+    }
+
+public:
+    btDiscreteDynamicsWorld* m_world;
+    btAlignedObjectArray<btPersistentManifold*> m_rebuiltManifolds;
+    btAlignedObjectArray<btPersistentManifold*> m_solvedManifolds;
+    int m_numIslandErrors;
+    int m_numAwakeObjects;
+
+    RebuildCheckingSolver() : m_world(0), m_numIslandErrors(0), m_numAwakeObjects(0) {}
+
+    virtual void prepareSolve(int numBodies, int numManifolds)
+    {
+        btCollisionObjectArray& objects = m_world->getCollisionObjectArray();
+        btAlignedObjectArray<int> persistentLabels;
+        getIslandLabels(objects,persistentLabels);
+
+        //building the islands changes the tags and puts islands to sleep, the persistent islands are built afterwards from the same state
+        btAlignedObjectArray<int> tags;
+        btAlignedObjectArray<int> activationStates;
+        btAlignedObjectArray<btScalar> deactivationTimes;
+        int i;
+        for (i=0;i<objects.size();i++)
+        {
+            tags.push_back(objects[i]->getIslandTag());
+            activationStates.push_back(objects[i]->getActivationState());
+            deactivationTimes.push_back(objects[i]->getDeactivationTime());
+        }
+
+        btDispatcher* dispatcher = m_world->getDispatcher();
+        m_rebuildIslandManager.updateActivationState(m_world,dispatcher);
+        for (i=0;i<m_world->getNumConstraints();i++)
+        {
+            btTypedConstraint* constraint = m_world->getConstraint(i);
+            btRigidBody& bodyA = constraint->getRigidBodyA();
+            btRigidBody& bodyB = constraint->getRigidBodyB();
+            if (constraint->isEnabled() && !bodyA.isStaticOrKinematicObject() && !bodyB.isStaticOrKinematicObject() && (bodyA.isActive() || bodyB.isActive()))
+                m_rebuildIslandManager.uniteIslands(&bodyA,&bodyB);
+        }
+        m_rebuildIslandManager.storeIslandActivationState(m_world);
+
+        btAlignedObjectArray<int> rebuiltLabels;
+        getIslandLabels(objects,rebuiltLabels);
+        for (i=0;i<objects.size();i++)
+        {
+            if (persistentLabels[i]!=rebuiltLabels[i])
+            {
+                m_numIslandErrors++;
+                break;
+            }
+            if (persistentLabels[i]>=0)
+                m_numAwakeObjects++;
+        }
+
+        ManifoldRecorder recorder;
+        btAlignedObjectArray<btPersistentManifold*> manifolds;
+        recorder.m_manifolds = &manifolds;
+        m_rebuildIslandManager.buildAndProcessIslands(dispatcher,m_world,&recorder);
+
+        btHashMap<btHashPtr,int> awakeObjects;
+        for (i=0;i<objects.size();i++)
+        {
+            if (persistentLabels[i]>=0)
+                awakeObjects.insert(objects[i],1);
+        }
+        m_rebuiltManifolds.resize(0);
+        m_solvedManifolds.resize(0);
+        for (i=0;i<manifolds.size();i++)
+        {
+            if (awakeObjects.find(manifolds[i]->getBody0()) || awakeObjects.find(manifolds[i]->getBody1()))
+                m_rebuiltManifolds.push_back(manifolds[i]);
+        }
+
+        for (i=0;i<objects.size();i++)
+        {
+            objects[i]->setIslandTag(tags[i]);
+            objects[i]->forceActivationState(activationStates[i]);
+            objects[i]->setDeactivationTime(deactivationTimes[i]);
+        }
+        btSequentialImpulseConstraintSolver::prepareSolve(numBodies,numManifolds);
+    }
+
+    virtual btScalar solveGroup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifold,int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,btDispatcher* dispatcher)
+    {
+        for (int i=0;i<numManifolds;i++)
+            m_solvedManifolds.push_back(manifold[i]);
+        return btSequentialImpulseConstraintSolver::solveGroup(bodies,numBodies,manifold,numManifolds,constraints,numConstraints,info,debugDrawer,stackAlloc,dispatcher);
+    }
+
+    bool sameManifolds()
+    {
+        m_rebuiltManifolds.quickSort(PointerLess<btPersistentManifold*>());
+        m_solvedManifolds.quickSort(PointerLess<btPersistentManifold*>());
+        return m_rebuiltManifolds.size()==m_solvedManifolds.size() &&
+            (!m_solvedManifolds.size() || !memcmp(&m_rebuiltManifolds[0],&m_solvedManifolds[0],m_solvedManifolds.size()*sizeof(btPersistentManifold*)));
+    }
+};
+
+struct IslandScene
+{
+    btDefaultCollisionConfiguration         m_collisionConfiguration;
+    btCollisionDispatcher                   m_dispatcher;
+    btDbvtBroadphase                        m_broadphase;
+    btConstraintSolver*                     m_solver;
+    btDiscreteDynamicsWorld*                m_world;
+
+    btBoxShape                              m_groundShape;
+    btBoxShape                              m_boxShape;
+    btAlignedObjectArray<btRigidBody*>      m_bodies;
+    btAlignedObjectArray<btTypedConstraint*> m_constraints;
+
+    IslandScene(btConstraintSolver* solver, int numTasks)
+        :m_dispatcher(&m_collisionConfiguration),
+        m_solver(solver),
+        m_groundShape(btVector3(200.f,1.f,200.f)),
+        m_boxShape(btVector3(0.5f,0.5f,0.5f))
+    {
+        m_world = new btDiscreteDynamicsWorld(&m_dispatcher,&m_broadphase,m_solver,&m_collisionConfiguration);
+        m_world->setNumTasks(numTasks);
+
+        btRigidBody::btRigidBodyConstructionInfo groundInfo(0.f,0,&m_groundShape);
+        groundInfo.m_startWorldTransform.setOrigin(btVector3(0.f,-1.f,0.f));
+        addBody(new btRigidBody(groundInfo));
+
+        btVector3 localInertia;
+        m_boxShape.calculateLocalInertia(1.f,localInertia);
+        for (int s=0;s<numStacks;s++)
+        {
+            for (int j=0;j<stackHeight;j++)
+            {
+                btRigidBody::btRigidBodyConstructionInfo boxInfo(1.f,0,&m_boxShape,localInertia);
+                //a small offset per level makes the stacks topple differently
+                boxInfo.m_startWorldTransform.setOrigin(btVector3(btScalar(s%8)*6.f+btScalar(j)*0.05f*btScalar(s%3),0.5f+btScalar(j)*1.01f,btScalar(s/8)*6.f));
+                addBody(new btRigidBody(boxInfo));
+            }
+        }
+        for (int c=0;c<numChains;c++)
+        {
+            btRigidBody* previous = 0;
+            for (int j=0;j<chainLength;j++)
+            {
+                btRigidBody::btRigidBodyConstructionInfo linkInfo(j ? 1.f : 0.f,0,&m_boxShape,j ? localInertia : btVector3(0,0,0));
+                linkInfo.m_startWorldTransform.setOrigin(btVector3(60.f+btScalar(j)*1.2f,20.f,btScalar(c)*4.f));
+                btRigidBody* link = new btRigidBody(linkInfo);
+                addBody(link);
+                if (previous)
+                {
+                    btHingeConstraint* hinge = new btHingeConstraint(*previous,*link,btVector3(0.6f,0,0),btVector3(-0.6f,0,0),btVector3(0,0,1),btVector3(0,0,1));
+                    m_constraints.push_back(hinge);
+                    m_world->addConstraint(hinge,true);
+                }
+                previous = link;
+            }
+        }
+    }
+
+    ~IslandScene()
+    {
+        int i;
+        for (i=0;i<m_constraints.size();i++)
+        {
+            m_world->removeConstraint(m_constraints[i]);
+            delete m_constraints[i];
+        }
+        for (i=0;i<m_bodies.size();i++)
+        {
+            m_world->removeRigidBody(m_bodies[i]);
+            delete m_bodies[i];
+        }
+        delete m_world;
+    }
+
+    void addBody(btRigidBody* body)
+    {
+        m_bodies.push_back(body);
+        m_world->addRigidBody(body);
+    }
+
+    void run()
+    {
+        for (int frame=0;frame<numFrames;frame++)
+        {
+            m_world->stepSimulation(1.f/60.f,0);
+        }
+    }
+};
+
+static bool identicalScenes(const IslandScene& a, const IslandScene& b)
+{
+    for (int i=0;i<a.m_bodies.size();i++)
+    {
+        const btRigidBody* bodyA = a.m_bodies[i];
+        const btRigidBody* bodyB = b.m_bodies[i];
+        if (memcmp(&bodyA->getWorldTransform(),&bodyB->getWorldTransform(),sizeof(btTransform)) ||
+            memcmp(&bodyA->getLinearVelocity(),&bodyB->getLinearVelocity(),sizeof(btVector3)) ||
+            memcmp(&bodyA->getAngularVelocity(),&bodyB->getAngularVelocity(),sizeof(btVector3)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//runs the scene with persistent islands for long enough that the stacks fall asleep, wakes them up with new boxes and a kinematic box,
+//and removes boxes. Returns the number of frames where the islands differ from the rebuilt ones
+static int checkPersistentIslands()
+{
+    RebuildCheckingSolver solver;
+    IslandScene scene(&solver,1);
+    solver.m_world = scene.m_world;
+    scene.m_world->setPersistentIslands(true);
+
+    btRigidBody::btRigidBodyConstructionInfo kinematicInfo(0.f,0,&scene.m_boxShape);
+    btRigidBody* kinematic = new btRigidBody(kinematicInfo);
+    kinematic->setCollisionFlags(kinematic->getCollisionFlags()|btCollisionObject::CF_KINEMATIC_OBJECT);
+    kinematic->setActivationState(DISABLE_DEACTIVATION);
+    scene.addBody(kinematic);
+
+    //the boxes of the stacks and the dropped boxes, the ground is body 0
+    btAlignedObjectArray<btRigidBody*> boxes;
+    for (int i=1;i<=numStacks*stackHeight;i++)
+        boxes.push_back(scene.m_bodies[i]);
+
+    const int numPersistentFrames = 900;
+    int numFrameErrors = 0;
+    int numRemoved = 0;
+    srand(77);
+    for (int frame=0;frame<numPersistentFrames;frame++)
+    {
+        //the kinematic box waits until the stacks sleep, then pushes through the first row
+        btScalar x = frame<400 ? -5.f : -5.f+btScalar(frame-400)*0.05f;
+        kinematic->getWorldTransform().setOrigin(btVector3(x,0.5f,0.f));
+
+        if (frame>=300 && frame%40==0)
+        {
+            int index = rand()%boxes.size();
+            btRigidBody* body = boxes[index];
+            boxes.swap(index,boxes.size()-1);
+            boxes.pop_back();
+            scene.m_bodies.remove(body);
+            scene.m_world->removeRigidBody(body);
+            delete body;
+            numRemoved++;
+
+            btVector3 localInertia;
+            scene.m_boxShape.calculateLocalInertia(1.f,localInertia);
+            btRigidBody::btRigidBodyConstructionInfo boxInfo(1.f,0,&scene.m_boxShape,localInertia);
+            int s = rand()%numStacks;
+            boxInfo.m_startWorldTransform.setOrigin(btVector3(btScalar(s%8)*6.f+0.2f,10.f,btScalar(s/8)*6.f));
+            boxes.push_back(new btRigidBody(boxInfo));
+            scene.addBody(boxes[boxes.size()-1]);
+        }
+
+        scene.m_world->stepSimulation(1.f/60.f,0);
+        if (!solver.sameManifolds())
+            numFrameErrors++;
+    }
+    numFrameErrors += solver.m_numIslandErrors;
+    printf("persistent islands: %d frames, %d awake objects per frame of %d, %d boxes removed, %s\n",numPersistentFrames,
+        solver.m_numAwakeObjects/numPersistentFrames,scene.m_world->getNumCollisionObjects(),numRemoved,numFrameErrors ? "DIFFERENT" : "identical to rebuilt islands");
+    return numFrameErrors;
+}
+
+int main(int argc, char* argv[])
+{
+    int numTasks = argc>1 ? atoi(argv[1]) : 4;
+    int numErrors = 0;
+
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numTasks);
+
+    btSequentialImpulseConstraintSolver serialSolver;
+    IslandScene serial(&serialSolver,1);
+    serial.run();
+
+    btSetTaskScheduler(scheduler);
+
+    btSequentialImpulseConstraintSolver parallelSolver;
+    IslandScene parallel(&parallelSolver,numTasks);
+    parallel.run();
+    bool parallelIdentical = identicalScenes(serial,parallel);
+
+    CountingSolver countingSolver;
+    IslandScene derived(&countingSolver,numTasks);
+    derived.run();
+    bool derivedIdentical = identicalScenes(serial,derived);
+
+    btSetTaskScheduler(0);
+
+    printf("%d islands, %d tasks, %d threads\n",numStacks+numChains,parallel.m_world->getNumTasks(),scheduler->getNumThreads());
+    printf("parallel islands: %s\n",parallelIdentical ? "identical" : "DIFFERENT");
+    printf("derived solver: %s, %d groups solved by its task solvers\n",derivedIdentical ? "identical" : "DIFFERENT",gNumTaskSolverGroups);
+    if (!parallelIdentical || !derivedIdentical)
+        numErrors++;
+    if (numTasks>1 && !gNumTaskSolverGroups)
+    {
+        printf("error: the derived solver didn't get task solvers of its own type\n");
+        numErrors++;
+    }
+
+    btDeleteTaskScheduler(scheduler);
+
+    if (checkPersistentIslands())
+        numErrors++;
+
+    printf(numErrors ? "FAILED\n" : "PASSED\n");
+    return numErrors ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+		project "island_test"
+
+		language "C++"
+				
+		kind "ConsoleApp"
+		targetdir "../../bin"
+
+  		includedirs {
+                ".",
+                "../../bullet2",
+                }
+
+		links {
+			"BulletDynamics",
+			"BulletCollision",
+			"LinearMath"
+		}
+
+		files {
+		"main.cpp"
+		}
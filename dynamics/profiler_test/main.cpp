@@ -1,37 +1,82 @@
-#include "LinearMath/btQuickprof.h"
-
-volatile int result=0;
-void innerloop()
-{
-    BT_PROFILE("innerloop");
-    for (int i=0;i<10000000;i++)
-    {
-        result += i;
-    }
-}
-
-void render()
-{
-    BT_PROFILE("render");
-    
-    innerloop();
-
-}
-
-int main(int argc, char* argv[])
-{
-
-    while(1)
-    {
-
-        CProfileManager::Reset();
-        render();
-        CProfileManager::Increment_Frame_Counter();
-    
-        bool showStats = true;
-        if (showStats)
-            CProfileManager::dumpAll();    
-    }    
-
-    printf("result=%d",result);
-}
\ No newline at end of file
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+
+//measures the cost of a BT_PROFILE sample, on its own, while tracing, and from the threads of a btParallelFor
+
+volatile int result=0;
+
+void emptyloop(int numIterations)
+{
+    for (int i=0;i<numIterations;i++)
+    {
+        result += i;
+    }
+}
+
+void profiledloop(int numIterations)
+{
+    for (int i=0;i<numIterations;i++)
+    {
+        BT_PROFILE("sample");
+        result += i;
+    }
+}
+
+struct ProfiledParallelLoop : public btIParallelForBody
+{
+    virtual void forLoop(int iBegin, int iEnd) const
+    {
+        BT_PROFILE("task");
+        profiledloop(iEnd-iBegin);
+    }
+};
+
+double nanosecondsPerIteration(void (*loop)(int), int numIterations)
+{
+    btClock clock;
+    loop(numIterations);
+    return double(clock.getTimeMicroseconds())*1000./double(numIterations);
+}
+
+int main()
+{
+    const int numIterations = 10000000;
+    const int numTraceIterations = 100000;
+
+    CProfileManager::Reset();
+    double emptyTime = nanosecondsPerIteration(emptyloop,numIterations);
+    double sampleTime = nanosecondsPerIteration(profiledloop,numIterations);
+    printf("empty loop: %.2f ns/iteration\n",emptyTime);
+    printf("BT_PROFILE: %.2f ns/sample overhead\n",sampleTime-emptyTime);
+
+    CProfileManager::Start_Trace();
+    double traceTime = nanosecondsPerIteration(profiledloop,numTraceIterations);
+    CProfileManager::Stop_Trace();
+    printf("BT_PROFILE while tracing: %.2f ns/sample overhead\n",traceTime-emptyTime);
+
+    //every thread of the scheduler records into its own tree, the merged report sums them
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(4);
+    btSetTaskScheduler(scheduler);
+    CProfileManager::Reset();
+    CProfileManager::Start_Trace();
+    {
+        BT_PROFILE("parallelFor");
+        btParallelFor(0,numTraceIterations,numTraceIterations/64,ProfiledParallelLoop());
+    }
+    CProfileManager::Stop_Trace();
+    CProfileManager::Increment_Frame_Counter();
+    btSetTaskScheduler(0);
+    btDeleteTaskScheduler(scheduler);
+
+    printf("%d threads recorded samples\n",CProfileManager::Get_Number_Of_Threads());
+
+    CProfileManager::dumpAll();
+
+    if (CProfileManager::Write_Chrome_Trace("profiler_test.json"))
+    {
+        printf("wrote profiler_test.json, open it in chrome://tracing\n");
+    }
+
+    printf("result=%d\n",result);
+    return 0;
+}
@@ -13,5 +13,7 @@
 
 		files {
 		"main.cpp",
-		"../../bullet2/LinearMath/btQuickprof.cpp"
+		"../../bullet2/LinearMath/btQuickprof.cpp",
+		"../../bullet2/LinearMath/btAlignedAllocator.cpp",
+		"../../bullet2/LinearMath/btThreads.cpp"
 		}
@@ -0,0 +1,221 @@
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
+#include "BulletSerialize/BulletFileLoader/btBulletFile.h"
+#include "BulletSerialize/BulletWorldImporter/btBulletWorldImporter.h"
+#include <stdio.h>
+#include <string.h>
+
+//saves a world with boxes, spheres, a compound and a static triangle mesh, and loads the file once from a malloc'd copy and once memory mapped.
+//Only the memory mapped file may use chunks in place, and both loads have to give the same objects.
+//A second file saved without bvhs is streamed in twice on 4 threads: the second load may not build the meshes of the first,
+//and the bvhs built by updateStreaming have to match the saved one. Returns 0 when they do.
+
+static const char* fileName = "serialize_test.bullet";
+static const char* streamedFileName = "serialize_test_nobvh.bullet";
+
+static int numFailures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n",message);
+        numFailures++;
+    }
+}
+
+static void saveWorld(const char* name, int serializationFlags)
+{
+    btDefaultCollisionConfiguration collisionConfiguration;
+    btCollisionDispatcher dispatcher(&collisionConfiguration);
+    btDbvtBroadphase broadphase;
+    btSequentialImpulseConstraintSolver solver;
+    btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+
+    btAlignedObjectArray<btVector3> vertices;
+    btAlignedObjectArray<int> indices;
+    const int gridSize = 32;
+    for (int i=0;i<=gridSize;i++)
+    {
+        for (int j=0;j<=gridSize;j++)
+        {
+            vertices.push_back(btVector3(btScalar(i),btSin(i*0.3f)*btCos(j*0.2f),btScalar(j)));
+        }
+    }
+    for (int i=0;i<gridSize;i++)
+    {
+        for (int j=0;j<gridSize;j++)
+        {
+            int v = i*(gridSize+1)+j;
+            indices.push_back(v); indices.push_back(v+1); indices.push_back(v+gridSize+1);
+            indices.push_back(v+1); indices.push_back(v+gridSize+2); indices.push_back(v+gridSize+1);
+        }
+    }
+    btTriangleIndexVertexArray mesh(indices.size()/3,&indices[0],3*sizeof(int),vertices.size(),(btScalar*)&vertices[0],sizeof(btVector3));
+    btBvhTriangleMeshShape terrainShape(&mesh,true);
+    btBoxShape boxShape(btVector3(0.5f,0.25f,1.f));
+    btSphereShape sphereShape(0.4f);
+    btCompoundShape compoundShape;
+    compoundShape.addChildShape(btTransform(btQuaternion::getIdentity(),btVector3(0.f,0.5f,0.f)),&boxShape);
+    compoundShape.addChildShape(btTransform(btQuaternion::getIdentity(),btVector3(0.f,-0.5f,0.f)),&sphereShape);
+
+    btAlignedObjectArray<btRigidBody*> bodies;
+    bodies.push_back(new btRigidBody(0.f,0,&terrainShape));
+    btCollisionShape* shapes[3] = {&boxShape,&sphereShape,&compoundShape};
+    for (int i=0;i<30;i++)
+    {
+        btCollisionShape* shape = shapes[i%3];
+        btVector3 inertia;
+        shape->calculateLocalInertia(btScalar(1+i%4),inertia);
+        btRigidBody* body = new btRigidBody(btScalar(1+i%4),0,shape,inertia);
+        body->setWorldTransform(btTransform(btQuaternion(btVector3(0,1,0),i*0.1f),btVector3(btScalar(i%6)*4.f+2.f,3.f+i/6,btScalar(i/6)*4.f+2.f)));
+        bodies.push_back(body);
+    }
+    for (int i=0;i<bodies.size();i++)
+    {
+        world.addRigidBody(bodies[i]);
+    }
+    btPoint2PointConstraint constraint(*bodies[1],*bodies[2],btVector3(0,1,0),btVector3(0,-1,0));
+    world.addConstraint(&constraint);
+
+    btDefaultSerializer serializer;
+    serializer.setSerializationFlags(serializationFlags);
+    world.serialize(&serializer);
+    FILE* file = fopen(name,"wb");
+    fwrite(serializer.getBufferPointer(),serializer.getCurrentBufferSize(),1,file);
+    fclose(file);
+
+    world.removeConstraint(&constraint);
+    for (int i=0;i<bodies.size();i++)
+    {
+        world.removeRigidBody(bodies[i]);
+        delete bodies[i];
+    }
+}
+
+static void compareFiles()
+{
+    bParse::btBulletFile copiedFile(fileName,false);
+    bParse::btBulletFile mappedFile(fileName,true);
+    copiedFile.parse(false);
+    mappedFile.parse(false);
+
+    check(copiedFile.ok() && mappedFile.ok(),"the file can't be parsed");
+    check(!copiedFile.isMemoryMapped() && copiedFile.getNumInPlaceChunks()==0,"a malloc'd file buffer was used in place");
+    check(copiedFile.m_rigidBodies.size()==mappedFile.m_rigidBodies.size(),"different number of rigid body chunks");
+    check(copiedFile.m_collisionShapes.size()==mappedFile.m_collisionShapes.size(),"different number of collision shape chunks");
+    check(copiedFile.m_constraints.size()==mappedFile.m_constraints.size(),"different number of constraint chunks");
+    check(copiedFile.m_bvhs.size()==mappedFile.m_bvhs.size(),"different number of bvh chunks");
+    printf("memory mapped: %s, %d chunks (%d bytes) used in place\n",mappedFile.isMemoryMapped() ? "yes" : "no",
+        mappedFile.getNumInPlaceChunks(),mappedFile.getInPlaceBytes());
+}
+
+static void compareImportedWorlds()
+{
+    btBulletWorldImporter copiedImporter;
+    btBulletWorldImporter mappedImporter;
+    mappedImporter.setMemoryMapFiles(true);
+    check(copiedImporter.loadFile(fileName),"loading the file failed");
+    check(mappedImporter.loadFile(fileName),"loading the memory mapped file failed");
+
+    check(copiedImporter.getNumRigidBodies()==31 && mappedImporter.getNumRigidBodies()==31,"wrong number of rigid bodies");
+    check(copiedImporter.getNumCollisionShapes()==mappedImporter.getNumCollisionShapes(),"different number of collision shapes");
+    check(copiedImporter.getNumConstraints()==1 && mappedImporter.getNumConstraints()==1,"wrong number of constraints");
+    check(copiedImporter.getNumBvhs()==mappedImporter.getNumBvhs(),"different number of bvhs");
+    for (int i=0;i<copiedImporter.getNumRigidBodies() && i<mappedImporter.getNumRigidBodies();i++)
+    {
+        btRigidBody* copiedBody = btRigidBody::upcast(copiedImporter.getRigidBodyByIndex(i));
+        btRigidBody* mappedBody = btRigidBody::upcast(mappedImporter.getRigidBodyByIndex(i));
+        check(copiedBody->getWorldTransform().getOrigin()==mappedBody->getWorldTransform().getOrigin() &&
+            copiedBody->getWorldTransform().getBasis()==mappedBody->getWorldTransform().getBasis(),"different rigid body transforms");
+        check(copiedBody->getInvMass()==mappedBody->getInvMass(),"different rigid body masses");
+        check(copiedBody->getCollisionShape()->getShapeType()==mappedBody->getCollisionShape()->getShapeType(),"different collision shapes");
+        btVector3 copiedMin,copiedMax,mappedMin,mappedMax;
+        copiedBody->getCollisionShape()->getAabb(copiedBody->getWorldTransform(),copiedMin,copiedMax);
+        mappedBody->getCollisionShape()->getAabb(mappedBody->getWorldTransform(),mappedMin,mappedMax);
+        check(copiedMin==mappedMin && copiedMax==mappedMax,"different collision shape bounds");
+    }
+
+    //the triangle mesh is queried through its bvh, which has to be intact in both
+    btCollisionWorld::ClosestRayResultCallback copiedRay(btVector3(16.3f,10.f,16.7f),btVector3(16.3f,-10.f,16.7f));
+    btCollisionWorld::ClosestRayResultCallback mappedRay(btVector3(16.3f,10.f,16.7f),btVector3(16.3f,-10.f,16.7f));
+    btTransform rayFrom(btQuaternion::getIdentity(),copiedRay.m_rayFromWorld);
+    btTransform rayTo(btQuaternion::getIdentity(),copiedRay.m_rayToWorld);
+    btCollisionObject* copiedTerrain = copiedImporter.getRigidBodyByIndex(0);
+    btCollisionObject* mappedTerrain = mappedImporter.getRigidBodyByIndex(0);
+    btCollisionWorld::rayTestSingle(rayFrom,rayTo,copiedTerrain,copiedTerrain->getCollisionShape(),copiedTerrain->getWorldTransform(),copiedRay);
+    btCollisionWorld::rayTestSingle(rayFrom,rayTo,mappedTerrain,mappedTerrain->getCollisionShape(),mappedTerrain->getWorldTransform(),mappedRay);
+    check(copiedRay.hasHit() && mappedRay.hasHit() && copiedRay.m_closestHitFraction==mappedRay.m_closestHitFraction,"different ray hits on the triangle mesh");
+
+    copiedImporter.deleteAllData();
+    mappedImporter.deleteAllData();
+}
+
+static bool identicalBvhs(btBvhTriangleMeshShape* a, btBvhTriangleMeshShape* b)
+{
+    const QuantizedNodeArray& nodesA = a->getOptimizedBvh()->getQuantizedNodeArray();
+    const QuantizedNodeArray& nodesB = b->getOptimizedBvh()->getQuantizedNodeArray();
+    return nodesA.size()==nodesB.size() && nodesA.size() &&
+        memcmp(&nodesA[0],&nodesB[0],nodesA.size()*sizeof(btQuantizedBvhNode))==0;
+}
+
+static void compareStreamedWorld()
+{
+    btDefaultCollisionConfiguration collisionConfiguration;
+    btCollisionDispatcher dispatcher(&collisionConfiguration);
+    btDbvtBroadphase broadphase;
+    btSequentialImpulseConstraintSolver solver;
+    btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+
+    btBulletWorldImporter savedImporter;
+    check(savedImporter.loadFile(fileName),"loading the file failed");
+    btBvhTriangleMeshShape* savedTerrain = (btBvhTriangleMeshShape*)savedImporter.getRigidBodyByIndex(0)->getCollisionShape();
+
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(4);
+    btSetTaskScheduler(scheduler);
+
+    btBulletWorldImporter importer(&world);
+    importer.setStreaming(true);
+    check(importer.loadFile(streamedFileName),"loading the streamed file failed");
+    check(importer.getNumPendingShapes()==1 && world.getNumCollisionObjects()==30,"the triangle mesh of the streamed file was built by the load");
+    check(importer.loadFile(streamedFileName),"loading the streamed file again failed");
+    check(importer.getNumPendingShapes()==2 && world.getNumCollisionObjects()==60,"the second load built the pending mesh of the first");
+
+    //the focus is on the mesh of the second file, it moves 1 unit up so its aabb is the nearest one
+    btCollisionObject* secondTerrain = importer.getRigidBodyByIndex(31);
+    secondTerrain->getWorldTransform().setOrigin(btVector3(0,1,0));
+    importer.setStreamingFocus(btVector3(16.f,20.f,16.f));
+    check(importer.updateStreaming(1)==1 && world.getNumCollisionObjects()==61,"updateStreaming(1) didn't build one mesh");
+    check(((btBvhTriangleMeshShape*)secondTerrain->getCollisionShape())->getOptimizedBvh()!=0,"updateStreaming didn't build the mesh nearest to the focus");
+    check(importer.updateStreaming(8)==0 && world.getNumCollisionObjects()==62,"updateStreaming didn't build the remaining mesh");
+
+    btSetTaskScheduler(0);
+    btDeleteTaskScheduler(scheduler);
+
+    for (int i=0;i<importer.getNumRigidBodies();i+=31)
+    {
+        btBvhTriangleMeshShape* terrain = (btBvhTriangleMeshShape*)importer.getRigidBodyByIndex(i)->getCollisionShape();
+        check(terrain->getShapeType()==TRIANGLE_MESH_SHAPE_PROXYTYPE && terrain->getOptimizedBvh(),"a streamed triangle mesh has no bvh");
+        if (terrain->getOptimizedBvh())
+            check(identicalBvhs(terrain,savedTerrain),"a streamed bvh differs from the saved one");
+    }
+    printf("streamed: %d objects in the world, %d meshes pending\n",world.getNumCollisionObjects(),importer.getNumPendingShapes());
+
+    importer.deleteAllData();
+    savedImporter.deleteAllData();
+}
+
+int main()
+{
+    saveWorld(fileName,0);
+    saveWorld(streamedFileName,BT_SERIALIZE_NO_BVH);
+    compareFiles();
+    compareImportedWorlds();
+    compareStreamedWorld();
+    remove(fileName);
+    remove(streamedFileName);
+
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+		project "serialize_test"
+
+		language "C++"
+				
+		kind "ConsoleApp"
+		targetdir "../../bin"
+
+  		includedirs {
+                ".",
+                "../../bullet2",
+                "../../bullet2/BulletSerialize/BulletFileLoader",
+                }
+
+		links {
+			"BulletFileLoader",
+			"BulletDynamics",
+			"BulletCollision",
+			"LinearMath"
+		}
+
+		files {
+		"main.cpp",
+		"../../bullet2/BulletSerialize/BulletWorldImporter/btBulletWorldImporter.cpp"
+		}
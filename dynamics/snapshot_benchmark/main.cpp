@@ -0,0 +1,136 @@
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/Dynamics/btRigidBodySnapshot.h"
+#include "LinearMath/btQuickprof.h"
+#include <stdlib.h>
+#include <string.h>
+
+//drops a grid of boxes (pass the number of boxes, default 10000) onto a ground box and takes a btRigidBodySnapshot every frame.
+//Prints the time per frame of capture, writeDelta against the previous frame, readDelta and restoring the previous frame,
+//and the average delta size. Every frame it also checks that the previous frame is restored exactly
+//and that the delta of an unchanged snapshot only holds the empty masks.
+
+struct BoxScene
+{
+    btDefaultCollisionConfiguration         m_collisionConfiguration;
+    btCollisionDispatcher                   m_dispatcher;
+    btDbvtBroadphase                        m_broadphase;
+    btSequentialImpulseConstraintSolver     m_solver;
+    btDiscreteDynamicsWorld                 m_world;
+
+    btBoxShape                              m_groundShape;
+    btBoxShape                              m_boxShape;
+    btAlignedObjectArray<btRigidBody*>      m_bodies;
+
+    BoxScene(int numBoxes)
+        :m_dispatcher(&m_collisionConfiguration),
+        m_world(&m_dispatcher,&m_broadphase,&m_solver,&m_collisionConfiguration),
+        m_groundShape(btVector3(1000.f,1.f,1000.f)),
+        m_boxShape(btVector3(0.5f,0.5f,0.5f))
+    {
+        btRigidBody::btRigidBodyConstructionInfo groundInfo(0.f,0,&m_groundShape);
+        groundInfo.m_startWorldTransform.setOrigin(btVector3(0.f,-1.f,0.f));
+        m_bodies.push_back(new btRigidBody(groundInfo));
+        m_world.addRigidBody(m_bodies[0]);
+
+        btVector3 localInertia;
+        m_boxShape.calculateLocalInertia(1.f,localInertia);
+        int boxesPerRow = int(btSqrt(btScalar(numBoxes)/10.f))+1;
+        for (int i=0;i<numBoxes;i++)
+        {
+            int column = i%(boxesPerRow*boxesPerRow);
+            int layer = i/(boxesPerRow*boxesPerRow);
+            btRigidBody::btRigidBodyConstructionInfo boxInfo(1.f,0,&m_boxShape,localInertia);
+            boxInfo.m_startWorldTransform.setOrigin(btVector3(btScalar(column%boxesPerRow)*1.5f,2.f+btScalar(layer)*1.5f,btScalar(column/boxesPerRow)*1.5f));
+            btRigidBody* body = new btRigidBody(boxInfo);
+            m_bodies.push_back(body);
+            m_world.addRigidBody(body);
+        }
+    }
+
+    ~BoxScene()
+    {
+        for (int i=0;i<m_bodies.size();i++)
+        {
+            m_world.removeRigidBody(m_bodies[i]);
+            delete m_bodies[i];
+        }
+    }
+};
+
+static bool equalSnapshots(const btRigidBodySnapshot& a, const btRigidBodySnapshot& b)
+{
+    if (a.size()!=b.size())
+        return false;
+    for (int i=0;i<a.size();i++)
+    {
+        if (memcmp(&a.getState(i),&b.getState(i),sizeof(btRigidBodySnapshotState)))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    int numBoxes = argc>1 ? atoi(argv[1]) : 10000;
+    const int numFrames = 120;
+
+    BoxScene scene(numBoxes);
+
+    btRigidBodySnapshot snapshots[2];
+    btRigidBodySnapshot received;
+    btRigidBodySnapshot check;
+    btAlignedObjectArray<unsigned int> delta;
+    unsigned long captureTime = 0;
+    unsigned long writeDeltaTime = 0;
+    unsigned long readDeltaTime = 0;
+    unsigned long restoreTime = 0;
+    unsigned long deltaWords = 0;
+    int numErrors = 0;
+
+    snapshots[0].capture(&scene.m_world);
+    for (int frame=1;frame<=numFrames;frame++)
+    {
+        const btRigidBodySnapshot& previous = snapshots[(frame-1)&1];
+        btRigidBodySnapshot& current = snapshots[frame&1];
+
+        scene.m_world.stepSimulation(1.f/60.f,0);
+
+        btClock clock;
+        current.capture(&scene.m_world);
+        captureTime += clock.getTimeMicroseconds();
+
+        clock.reset();
+        delta.resize(0);
+        current.writeDelta(previous,delta);
+        writeDeltaTime += clock.getTimeMicroseconds();
+        deltaWords += delta.size();
+
+        clock.reset();
+        received.readDelta(previous,&delta[0],delta.size());
+        readDeltaTime += clock.getTimeMicroseconds();
+
+        clock.reset();
+        previous.restore(&scene.m_world);
+        restoreTime += clock.getTimeMicroseconds();
+
+        check.capture(&scene.m_world);
+        if (!equalSnapshots(check,previous) || !equalSnapshots(received,current))
+            numErrors++;
+        //back to the simulated frame, an unchanged snapshot has an empty delta
+        current.restore(&scene.m_world);
+        delta.resize(0);
+        current.writeDelta(current,delta);
+        if (delta.size()!=1+current.size()*btRigidBodySnapshot::NUM_MASK_WORDS)
+            numErrors++;
+    }
+
+    printf("%d boxes, %d frames (us per frame)\n",numBoxes,numFrames);
+    printf("capture %lu, writeDelta %lu, readDelta %lu, restore %lu, delta %lu bytes\n",captureTime/numFrames,writeDeltaTime/numFrames,
+        readDeltaTime/numFrames,restoreTime/numFrames,deltaWords*sizeof(unsigned int)/numFrames);
+    if (numErrors)
+    {
+        printf("error: %d frames weren't restored exactly\n",numErrors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "btBulletDynamicsCommon.h"
+#include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
+#include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
+#include "BulletSoftBody/btSoftBodyHelpers.h"
+#include "BulletSoftBody/btDefaultSoftBodySolver.h"
+#include "BulletSoftBody/btCPUSoftBodySolver.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <stdlib.h>
+
+//steps hanging cloth patches, once with the btDefaultSoftBodySolver and once with the btCPUSoftBodySolver on one thread and on a thread pool
+//(pass the number of threads, default 4). Many small patches are solved one soft body per thread, a single large patch spreads the link batches across threads.
+//Prints the time per frame spent in stepSimulation and the largest difference of the node positions to the btDefaultSoftBodySolver run after 60 frames,
+//the btCPUSoftBodySolver solves the links in batch order so small differences are expected.
+
+struct ClothScene
+{
+    btSoftBodyRigidBodyCollisionConfiguration   m_collisionConfiguration;
+    btCollisionDispatcher                       m_dispatcher;
+    btDbvtBroadphase                            m_broadphase;
+    btSequentialImpulseConstraintSolver         m_solver;
+    btDefaultSoftBodySolver                     m_defaultSoftBodySolver;
+    btCPUSoftBodySolver                         m_cpuSoftBodySolver;
+    btSoftRigidDynamicsWorld*                   m_world;
+    unsigned long                               m_time;
+
+    ClothScene(int numPatches, int resolution, bool useCPUSolver)
+        :m_dispatcher(&m_collisionConfiguration),
+        m_time(0)
+    {
+        btSoftBodySolver* softBodySolver = useCPUSolver ? (btSoftBodySolver*)&m_cpuSoftBodySolver : (btSoftBodySolver*)&m_defaultSoftBodySolver;
+        m_world = new btSoftRigidDynamicsWorld(&m_dispatcher,&m_broadphase,&m_solver,&m_collisionConfiguration,softBodySolver);
+
+        int patchesPerRow = int(btSqrt(btScalar(numPatches)-0.5f))+1;
+        for (int i=0;i<numPatches;i++)
+        {
+            btVector3 origin(btScalar(i%patchesPerRow)*12.f,20.f,btScalar(i/patchesPerRow)*12.f);
+            btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(m_world->getWorldInfo(),origin,origin+btVector3(10.f,0.f,0.f),
+                origin+btVector3(0.f,0.f,10.f),origin+btVector3(10.f,0.f,10.f),resolution,resolution,1+2,true);
+            cloth->m_cfg.piterations = 4;
+            cloth->setTotalMass(1.f);
+            m_world->addSoftBody(cloth);
+        }
+    }
+
+    ~ClothScene()
+    {
+        for (int i=m_world->getSoftBodyArray().size()-1;i>=0;i--)
+        {
+            btSoftBody* cloth = m_world->getSoftBodyArray()[i];
+            m_world->removeSoftBody(cloth);
+            delete cloth;
+        }
+        delete m_world;
+    }
+
+    void step()
+    {
+        btClock clock;
+        m_world->stepSimulation(1.f/60.f,0);
+        m_time += clock.getTimeMicroseconds();
+    }
+};
+
+static btScalar maxDifference(ClothScene& a, ClothScene& b)
+{
+    btScalar maxDiff = 0.f;
+    for (int i=0;i<a.m_world->getSoftBodyArray().size();i++)
+    {
+        const btSoftBody* clothA = a.m_world->getSoftBodyArray()[i];
+        const btSoftBody* clothB = b.m_world->getSoftBodyArray()[i];
+        for (int n=0;n<clothA->m_nodes.size();n++)
+        {
+            maxDiff = btMax(maxDiff,(clothA->m_nodes[n].m_x-clothB->m_nodes[n].m_x).length());
+        }
+    }
+    return maxDiff;
+}
+
+int main(int argc, char* argv[])
+{
+    const int patchCounts[] = {64,1};
+    const int patchResolutions[] = {24,160};
+    const int numFrames = 300;
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    printf("patches x nodes   btDefaultSoftBodySolver   btCPUSoftBodySolver 1 thread   %d threads   (us per frame, max node difference)\n",scheduler->getNumThreads());
+    for (int c=0;c<int(sizeof(patchCounts)/sizeof(patchCounts[0]));c++)
+    {
+        ClothScene defaultSolver(patchCounts[c],patchResolutions[c],false);
+        ClothScene cpuSolver(patchCounts[c],patchResolutions[c],true);
+        ClothScene parallelCpuSolver(patchCounts[c],patchResolutions[c],true);
+
+        btScalar cpuSolverDifference = 0.f;
+        btScalar parallelCpuSolverDifference = 0.f;
+        for (int frame=0;frame<numFrames;frame++)
+        {
+            defaultSolver.step();
+            cpuSolver.step();
+            btSetTaskScheduler(scheduler);
+            parallelCpuSolver.step();
+            btSetTaskScheduler(0);
+            if (frame==60)
+            {
+                cpuSolverDifference = maxDifference(defaultSolver,cpuSolver);
+                parallelCpuSolverDifference = maxDifference(defaultSolver,parallelCpuSolver);
+            }
+        }
+
+        printf("%3d x %-11d %-25lu %-30lu %-11lu (%f, %f)\n",patchCounts[c],patchResolutions[c]*patchResolutions[c],defaultSolver.m_time/numFrames,
+            cpuSolver.m_time/numFrames,parallelCpuSolver.m_time/numFrames,cpuSolverDifference,parallelCpuSolverDifference);
+    }
+    btDeleteTaskScheduler(scheduler);
+    return 0;
+}
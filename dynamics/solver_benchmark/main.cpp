@@ -0,0 +1,183 @@
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//solves a scene of stacked boxes with the sequential solver and with SOLVER_BATCHED, using the scalar row kernels, the SoA row kernel
+//and the SoA row kernel on a thread pool (pass the number of threads, default 4), and compares the solver time per frame.
+//Returns 0 when the SoA row kernel gives the same simulation as the scalar row kernels and all stacks stay upright.
+
+static int numFailures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n",message);
+        numFailures++;
+    }
+}
+
+//TimedSolver measures the time spent in solveGroup, and solves all islands on one solver so the threads only work within the batches
+class TimedSolver : public btSequentialImpulseConstraintSolver
+{
+public:
+    unsigned long m_solverTime;
+
+    TimedSolver(bool useRowLanes)
+        :m_solverTime(0)
+    {
+        m_useConstraintRowLanes = useRowLanes;
+    }
+
+    virtual btScalar solveGroup(btCollisionObject** bodies,int numBodies,btPersistentManifold** manifold,int numManifolds,btTypedConstraint** constraints,int numConstraints,const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,btDispatcher* dispatcher)
+    {
+        btClock clock;
+        btScalar result = btSequentialImpulseConstraintSolver::solveGroup(bodies,numBodies,manifold,numManifolds,constraints,numConstraints,info,debugDrawer,stackAlloc,dispatcher);
+        m_solverTime += clock.getTimeMicroseconds();
+        return result;
+    }
+
+    virtual btConstraintSolver* createTaskSolver() const
+    {
+        return 0;
+    }
+};
+
+struct StackingRun
+{
+    const char* m_name;
+    bool m_batched;
+    bool m_useRowLanes;
+    bool m_threaded;
+    unsigned long m_solverTime;
+    unsigned long m_stepTime;
+    btAlignedObjectArray<btTransform> m_transforms;
+    btScalar m_maxDrift;
+    btScalar m_maxSink;
+};
+
+static void runStacks(StackingRun& run, btITaskScheduler* scheduler)
+{
+    const int numColumns = 12;
+    const int stackHeight = 8;
+    const int numFrames = 300;
+
+    btDefaultCollisionConfiguration collisionConfiguration;
+    btCollisionDispatcher dispatcher(&collisionConfiguration);
+    btDbvtBroadphase broadphase;
+    TimedSolver solver(run.m_useRowLanes);
+    btDiscreteDynamicsWorld world(&dispatcher,&broadphase,&solver,&collisionConfiguration);
+    if (run.m_batched)
+        world.getSolverInfo().m_solverMode |= SOLVER_BATCHED;
+
+    btBoxShape groundShape(btVector3(50.f,1.f,50.f));
+    btRigidBody ground(0.f,0,&groundShape);
+    ground.setWorldTransform(btTransform(btQuaternion::getIdentity(),btVector3(0.f,-1.f,0.f)));
+    world.addRigidBody(&ground);
+
+    btBoxShape boxShape(btVector3(0.5f,0.5f,0.5f));
+    btVector3 inertia;
+    boxShape.calculateLocalInertia(1.f,inertia);
+    btAlignedObjectArray<btRigidBody*> boxes;
+    btAlignedObjectArray<btVector3> startPositions;
+    for (int x=0;x<numColumns;x++)
+    {
+        for (int z=0;z<numColumns;z++)
+        {
+            for (int y=0;y<stackHeight;y++)
+            {
+                btVector3 position(btScalar(x-numColumns/2)*1.5f,0.5f+btScalar(y),btScalar(z-numColumns/2)*1.5f);
+                btRigidBody* box = new btRigidBody(1.f,0,&boxShape,inertia);
+                box->setWorldTransform(btTransform(btQuaternion::getIdentity(),position));
+                box->setActivationState(DISABLE_DEACTIVATION);
+                world.addRigidBody(box);
+                boxes.push_back(box);
+                startPositions.push_back(position);
+            }
+        }
+    }
+
+    if (run.m_threaded)
+        btSetTaskScheduler(scheduler);
+    btClock clock;
+    for (int f=0;f<numFrames;f++)
+    {
+        world.stepSimulation(1.f/60.f,0);
+    }
+    run.m_stepTime = clock.getTimeMicroseconds()/numFrames;
+    btSetTaskScheduler(0);
+    run.m_solverTime = solver.m_solverTime/numFrames;
+
+    //the boxes settle into the collision margins and jitter sideways a little, a box that fell off its stack drifts more than half
+    //a box width and drops by a box height
+    run.m_maxDrift = 0.f;
+    run.m_maxSink = 0.f;
+    for (int i=0;i<boxes.size();i++)
+    {
+        run.m_transforms.push_back(boxes[i]->getWorldTransform());
+        btVector3 offset = boxes[i]->getWorldTransform().getOrigin()-startPositions[i];
+        run.m_maxDrift = btMax(run.m_maxDrift,btSqrt(offset.getX()*offset.getX()+offset.getZ()*offset.getZ()));
+        run.m_maxSink = btMax(run.m_maxSink,-offset.getY());
+        world.removeRigidBody(boxes[i]);
+        delete boxes[i];
+    }
+    world.removeRigidBody(&ground);
+}
+
+//the SoA row kernel uses the arithmetic of the scalar row kernels, so the transforms must be equal
+static bool sameTransforms(const StackingRun& a, const StackingRun& b)
+{
+    if (a.m_transforms.size()!=b.m_transforms.size())
+        return false;
+    for (int i=0;i<a.m_transforms.size();i++)
+    {
+        const btTransform& ta = a.m_transforms[i];
+        const btTransform& tb = b.m_transforms[i];
+        if (!(ta.getOrigin()==tb.getOrigin()) || !(ta.getBasis()==tb.getBasis()))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    StackingRun runs[4];
+    runs[0].m_name = "sequential";
+    runs[0].m_batched = false;
+    runs[0].m_useRowLanes = false;
+    runs[0].m_threaded = false;
+    runs[1].m_name = "batched, scalar rows";
+    runs[1].m_batched = true;
+    runs[1].m_useRowLanes = false;
+    runs[1].m_threaded = false;
+    runs[2].m_name = "batched, SoA rows";
+    runs[2].m_batched = true;
+    runs[2].m_useRowLanes = true;
+    runs[2].m_threaded = false;
+    runs[3].m_name = "batched, SoA rows, threads";
+    runs[3].m_batched = true;
+    runs[3].m_useRowLanes = true;
+    runs[3].m_threaded = true;
+
+    printf("12x12 stacks of 8 boxes, 300 frames, %d threads\n",scheduler->getNumThreads());
+    printf("solver                       solver us/frame  step us/frame  max drift  max sink\n");
+    for (int i=0;i<4;i++)
+    {
+        runStacks(runs[i],scheduler);
+        printf("%-28s %-16lu %-14lu %-10f %f\n",runs[i].m_name,runs[i].m_solverTime,runs[i].m_stepTime,runs[i].m_maxDrift,runs[i].m_maxSink);
+        check(runs[i].m_maxDrift<0.5f && runs[i].m_maxSink<0.5f,"a stack didn't stay upright");
+    }
+    printf("sequential/batched SoA solver time: %.2f, scalar/SoA rows: %.2f\n",
+        double(runs[0].m_solverTime)/double(runs[2].m_solverTime+1),double(runs[1].m_solverTime)/double(runs[2].m_solverTime+1));
+    check(sameTransforms(runs[1],runs[2]),"the SoA row kernel differs from the scalar row kernels");
+    check(sameTransforms(runs[2],runs[3]),"the batched solver depends on the number of threads");
+
+    btDeleteTaskScheduler(scheduler);
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
@@ -0,0 +1,352 @@
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//simulates a field of falling, spinning spheres and a pile of boxes with ccd and user interaction, once with the per-body passes,
+//once with btDiscreteDynamicsWorld::setUseRigidBodyStateArray and once with the state array on a thread pool (pass the number of
+//threads, default 4), and compares the time per frame. Returns 0 when the state array gives bit-identical transforms, velocities
+//and activation states.
+
+extern int gNumClampedCcdMotions;
+
+static int numFailures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n",message);
+        numFailures++;
+    }
+}
+
+//TimedWorld measures the time spent in the passes that the state array packs
+class TimedWorld : public btDiscreteDynamicsWorld
+{
+public:
+    unsigned long m_passTime;
+
+    TimedWorld(btDispatcher* dispatcher,btBroadphaseInterface* broadphase,btConstraintSolver* solver,btCollisionConfiguration* collisionConfiguration)
+        :btDiscreteDynamicsWorld(dispatcher,broadphase,solver,collisionConfiguration),
+        m_passTime(0)
+    {
+    }
+
+    virtual void predictUnconstraintMotion(btScalar timeStep)
+    {
+        btClock clock;
+        btDiscreteDynamicsWorld::predictUnconstraintMotion(timeStep);
+        m_passTime += clock.getTimeMicroseconds();
+    }
+
+    virtual void integrateTransforms(btScalar timeStep)
+    {
+        btClock clock;
+        btDiscreteDynamicsWorld::integrateTransforms(timeStep);
+        m_passTime += clock.getTimeMicroseconds();
+    }
+
+    virtual void applyGravity()
+    {
+        btClock clock;
+        btDiscreteDynamicsWorld::applyGravity();
+        m_passTime += clock.getTimeMicroseconds();
+    }
+
+    virtual void clearForces()
+    {
+        btClock clock;
+        btDiscreteDynamicsWorld::clearForces();
+        m_passTime += clock.getTimeMicroseconds();
+    }
+};
+
+struct BodyState
+{
+    btTransform m_transform;
+    btVector3 m_linearVelocity;
+    btVector3 m_angularVelocity;
+    int m_activationState;
+};
+
+struct Run
+{
+    const char* m_name;
+    bool m_useStateArray;
+    bool m_threaded;
+    unsigned long m_passTime;
+    unsigned long m_stepTime;
+    btAlignedObjectArray<BodyState> m_states;
+};
+
+static void storeStates(Run& run, const btAlignedObjectArray<btRigidBody*>& bodies)
+{
+    for (int i=0;i<bodies.size();i++)
+    {
+        BodyState state;
+        state.m_transform = bodies[i]->getWorldTransform();
+        state.m_linearVelocity = bodies[i]->getLinearVelocity();
+        state.m_angularVelocity = bodies[i]->getAngularVelocity();
+        state.m_activationState = bodies[i]->getActivationState();
+        run.m_states.push_back(state);
+    }
+}
+
+//the w components of the vectors are not defined, so only x, y and z are compared
+static bool sameVector(const btVector3& a, const btVector3& b)
+{
+    return !memcmp(a.m_floats,b.m_floats,3*sizeof(btScalar));
+}
+
+static bool sameStates(const Run& a, const Run& b)
+{
+    if (a.m_states.size()!=b.m_states.size())
+        return false;
+    for (int i=0;i<a.m_states.size();i++)
+    {
+        const BodyState& sa = a.m_states[i];
+        const BodyState& sb = b.m_states[i];
+        if (!sameVector(sa.m_transform.getOrigin(),sb.m_transform.getOrigin()) ||
+            !sameVector(sa.m_transform.getBasis()[0],sb.m_transform.getBasis()[0]) ||
+            !sameVector(sa.m_transform.getBasis()[1],sb.m_transform.getBasis()[1]) ||
+            !sameVector(sa.m_transform.getBasis()[2],sb.m_transform.getBasis()[2]) ||
+            !sameVector(sa.m_linearVelocity,sb.m_linearVelocity) ||
+            !sameVector(sa.m_angularVelocity,sb.m_angularVelocity) ||
+            sa.m_activationState!=sb.m_activationState)
+            return false;
+    }
+    return true;
+}
+
+struct Scene
+{
+    btDefaultCollisionConfiguration m_collisionConfiguration;
+    btCollisionDispatcher m_dispatcher;
+    btDbvtBroadphase m_broadphase;
+    btSequentialImpulseConstraintSolver m_solver;
+    TimedWorld m_world;
+    btAlignedObjectArray<btRigidBody*> m_bodies;
+
+    Scene()
+        :m_dispatcher(&m_collisionConfiguration),
+        m_world(&m_dispatcher,&m_broadphase,&m_solver,&m_collisionConfiguration)
+    {
+    }
+
+    ~Scene()
+    {
+        for (int i=m_world.getNumCollisionObjects()-1;i>=0;i--)
+        {
+            btRigidBody* body = btRigidBody::upcast(m_world.getCollisionObjectArray()[i]);
+            m_world.removeRigidBody(body);
+            delete body;
+        }
+    }
+
+    btRigidBody* addBody(btCollisionShape* shape, const btTransform& transform, btScalar mass, bool additionalDamping=false)
+    {
+        btVector3 inertia(0,0,0);
+        if (mass>0.f)
+            shape->calculateLocalInertia(mass,inertia);
+        btRigidBody::btRigidBodyConstructionInfo info(mass,0,shape,inertia);
+        info.m_startWorldTransform = transform;
+        info.m_additionalDamping = additionalDamping;
+        btRigidBody* body = new btRigidBody(info);
+        m_world.addRigidBody(body);
+        if (mass>0.f)
+            m_bodies.push_back(body);
+        return body;
+    }
+};
+
+//spheres far apart, so the integration passes and the broadphase are all there is to the step.
+//Some bodies have damping, additional damping or their own gravity
+static void runFalling(Run& run, btITaskScheduler* scheduler)
+{
+    const int numSide = 40;
+    const int numLayers = 12;
+    const int numFrames = 120;
+
+    btSphereShape sphereShape(0.5f);
+    Scene scene;
+    scene.m_world.setUseRigidBodyStateArray(run.m_useStateArray);
+    srand(1234);
+    for (int y=0;y<numLayers;y++)
+    {
+        for (int x=0;x<numSide;x++)
+        {
+            for (int z=0;z<numSide;z++)
+            {
+                btQuaternion rotation(btVector3(btScalar(rand())/RAND_MAX,1.f,btScalar(rand())/RAND_MAX).normalized(),btScalar(rand())/RAND_MAX*SIMD_2_PI);
+                int i = scene.m_bodies.size();
+                btRigidBody* body = scene.addBody(&sphereShape,btTransform(rotation,btVector3(x*3.f,y*3.f,z*3.f)),1.f,i%97==0);
+                body->setLinearVelocity(btVector3(btScalar(rand())/RAND_MAX-0.5f,0.f,btScalar(rand())/RAND_MAX-0.5f));
+                body->setAngularVelocity(btVector3(btScalar(rand())/RAND_MAX,btScalar(rand())/RAND_MAX*10.f,btScalar(rand())/RAND_MAX)*3.f);
+                body->setActivationState(DISABLE_DEACTIVATION);
+                if (i%5==0)
+                    body->setDamping(0.1f,0.3f);
+                if (i%11==0)
+                    body->setGravity(btVector3(0.f,-2.f,0.f));
+            }
+        }
+    }
+
+    if (run.m_threaded)
+        btSetTaskScheduler(scheduler);
+    btClock clock;
+    for (int f=0;f<numFrames;f++)
+    {
+        scene.m_world.stepSimulation(1.f/60.f,0);
+    }
+    run.m_stepTime = clock.getTimeMicroseconds()/numFrames;
+    btSetTaskScheduler(0);
+    run.m_passTime = scene.m_world.m_passTime/numFrames;
+    storeStates(run,scene.m_bodies);
+}
+
+//boxes dropped on a ground box go to sleep, fast spheres use ccd. At some frames the test moves, pushes and removes bodies and
+//changes their gravity and damping between the steps, which the state array has to pick up
+static void runPile(Run& run, btITaskScheduler* scheduler)
+{
+    const int numBoxes = 600;
+    const int numSpheres = 40;
+    const int numFrames = 400;
+
+    btBoxShape groundShape(btVector3(40.f,1.f,40.f));
+    btBoxShape boxShape(btVector3(0.5f,0.5f,0.5f));
+    btSphereShape sphereShape(0.2f);
+    Scene scene;
+    scene.m_world.setUseRigidBodyStateArray(run.m_useStateArray);
+    scene.m_world.getDispatchInfo().m_useContinuous = true;
+    scene.addBody(&groundShape,btTransform(btQuaternion::getIdentity(),btVector3(0.f,-1.f,0.f)),0.f);
+    srand(4321);
+    for (int i=0;i<numBoxes;i++)
+    {
+        btQuaternion rotation(btVector3(btScalar(rand())/RAND_MAX,1.f,btScalar(rand())/RAND_MAX).normalized(),btScalar(rand())/RAND_MAX*SIMD_2_PI);
+        btVector3 position((btScalar(rand())/RAND_MAX-0.5f)*20.f,1.f+btScalar(i/50)*1.5f,(btScalar(rand())/RAND_MAX-0.5f)*20.f);
+        scene.addBody(&boxShape,btTransform(rotation,position),1.f,i%13==0);
+    }
+    for (int i=0;i<numSpheres;i++)
+    {
+        btVector3 position((btScalar(rand())/RAND_MAX-0.5f)*20.f,30.f,(btScalar(rand())/RAND_MAX-0.5f)*20.f);
+        btRigidBody* sphere = scene.addBody(&sphereShape,btTransform(btQuaternion::getIdentity(),position),0.1f);
+        sphere->setLinearVelocity(btVector3(0.f,-80.f,0.f));
+        sphere->setCcdMotionThreshold(0.1f);
+        sphere->setCcdSweptSphereRadius(0.1f);
+    }
+
+    btAlignedObjectArray<btRigidBody*> removed;
+    gNumClampedCcdMotions = 0;
+    if (run.m_threaded)
+        btSetTaskScheduler(scheduler);
+    btClock clock;
+    for (int f=0;f<numFrames;f++)
+    {
+        switch (f)
+        {
+        case 50:
+            for (int i=0;i<numBoxes;i+=7)
+            {
+                scene.m_bodies[i]->applyCentralImpulse(btVector3(0.f,3.f,0.f));
+                scene.m_bodies[i]->applyTorqueImpulse(btVector3(0.f,0.f,1.f));
+            }
+            break;
+        case 100:
+            for (int i=0;i<numBoxes;i+=9)
+            {
+                btTransform transform = scene.m_bodies[i]->getWorldTransform();
+                transform.getOrigin() += btVector3(0.f,5.f,0.f);
+                transform.setRotation(btQuaternion(btVector3(1.f,0.f,0.f),0.3f)*transform.getRotation());
+                scene.m_bodies[i]->setWorldTransform(transform);
+                scene.m_bodies[i]->activate();
+            }
+            for (int i=3;i<numBoxes;i+=11)
+            {
+                scene.m_bodies[i]->setDamping(0.5f,0.5f);
+                scene.m_bodies[i]->setGravity(btVector3(0.f,-20.f,0.f));
+                scene.m_bodies[i]->activate();
+            }
+            break;
+        case 150:
+            for (int i=5;i<numBoxes;i+=25)
+            {
+                scene.m_world.removeRigidBody(scene.m_bodies[i]);
+                removed.push_back(scene.m_bodies[i]);
+            }
+            break;
+        case 200:
+            for (int i=0;i<removed.size();i++)
+            {
+                removed[i]->setLinearVelocity(btVector3(0.f,-1.f,0.f));
+                scene.m_world.addRigidBody(removed[i]);
+            }
+            for (int i=0;i<numBoxes;i+=4)
+            {
+                scene.m_bodies[i]->applyForce(btVector3(50.f,0.f,0.f),btVector3(0.f,0.5f,0.f));
+                scene.m_bodies[i]->activate();
+            }
+            break;
+        case 250:
+            //switching the packed state off and on again mid-simulation keeps the bodies in sync
+            scene.m_world.setUseRigidBodyStateArray(false);
+            scene.m_world.setUseRigidBodyStateArray(run.m_useStateArray);
+            break;
+        }
+        scene.m_world.stepSimulation(1.f/60.f,0);
+    }
+    run.m_stepTime = clock.getTimeMicroseconds()/numFrames;
+    btSetTaskScheduler(0);
+    run.m_passTime = scene.m_world.m_passTime/numFrames;
+    storeStates(run,scene.m_bodies);
+
+    //the scene has to go through the ccd clamping and the sleeping paths
+    int numSleeping = 0;
+    for (int i=0;i<scene.m_bodies.size();i++)
+    {
+        if (scene.m_bodies[i]->getActivationState()==ISLAND_SLEEPING)
+            numSleeping++;
+    }
+    check(gNumClampedCcdMotions>0,"no ccd motion got clamped");
+    check(numSleeping>0,"no body went to sleep");
+}
+
+static void compareRuns(const char* name, void (*runScene)(Run&,btITaskScheduler*), btITaskScheduler* scheduler)
+{
+    Run runs[3];
+    runs[0].m_name = "per-body passes";
+    runs[0].m_useStateArray = false;
+    runs[0].m_threaded = false;
+    runs[1].m_name = "state array";
+    runs[1].m_useStateArray = true;
+    runs[1].m_threaded = false;
+    runs[2].m_name = "state array, threads";
+    runs[2].m_useStateArray = true;
+    runs[2].m_threaded = true;
+
+    printf("%s, %d threads\n",name,scheduler->getNumThreads());
+    printf("passes                 pass us/frame  step us/frame\n");
+    for (int i=0;i<3;i++)
+    {
+        runScene(runs[i],scheduler);
+        printf("%-22s %-14lu %lu\n",runs[i].m_name,runs[i].m_passTime,runs[i].m_stepTime);
+    }
+    printf("per-body/state array pass time: %.2f\n",double(runs[0].m_passTime)/double(runs[1].m_passTime+1));
+    check(sameStates(runs[0],runs[1]),"the state array differs from the per-body passes");
+    check(sameStates(runs[1],runs[2]),"the state array depends on the number of threads");
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    compareRuns("19200 falling spheres, 120 frames",runFalling,scheduler);
+    compareRuns("600 boxes on a pile and 40 ccd spheres, 400 frames",runPile,scheduler);
+
+    btDeleteTaskScheduler(scheduler);
+    printf("%s\n",numFailures ? "FAILED" : "PASSED");
+    return numFailures ? 1 : 0;
+}
@@ -0,0 +1,276 @@
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/Vehicle/btRaycastVehicleFleet.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include <stdlib.h>
+
+//drives a fleet of raycast vehicles over a triangle mesh terrain, once as btRaycastVehicle actions with a btDefaultVehicleRaycaster
+//and once as a btRaycastVehicleFleet on one thread and on a thread pool (pass the number of threads, default 4).
+//Prints the time spent in the vehicle actions and the largest difference of the chassis positions to the btRaycastVehicle run after 60 frames,
+//later on the rounding differences of the friction impulses grow as the vehicles bump into each other.
+
+static const int gridSize = 200;
+static const btScalar cellSize = 2.f;
+static const btScalar vehicleSpacing = 8.f;
+
+static const btScalar wheelRadius = 0.5f;
+static const btScalar wheelWidth = 0.4f;
+static const btScalar connectionHeight = 1.2f;
+static const btScalar suspensionRestLength = 0.6f;
+
+static btScalar terrainHeight(int i, int j)
+{
+    return btSin(i*0.05f)*btCos(j*0.07f)*2.f;
+}
+
+//measures the time spent in the wrapped action
+struct TimedAction : public btActionInterface
+{
+    btActionInterface*  m_action;
+    unsigned long       m_time;
+
+    TimedAction(btActionInterface* action) : m_action(action), m_time(0) {}
+
+    virtual void updateAction(btCollisionWorld* collisionWorld, btScalar step)
+    {
+        btClock clock;
+        m_action->updateAction(collisionWorld,step);
+        m_time += clock.getTimeMicroseconds();
+    }
+
+    virtual void debugDraw(btIDebugDraw* debugDrawer)
+    {
+        m_action->debugDraw(debugDrawer);
+    }
+};
+
+struct VehicleScene
+{
+    btDefaultCollisionConfiguration         m_collisionConfiguration;
+    btCollisionDispatcher                   m_dispatcher;
+    btDbvtBroadphase                        m_broadphase;
+    btSequentialImpulseConstraintSolver     m_solver;
+    btDiscreteDynamicsWorld                 m_world;
+
+    btAlignedObjectArray<btVector3>         m_vertices;
+    btAlignedObjectArray<int>               m_indices;
+    btTriangleIndexVertexArray*             m_mesh;
+    btBvhTriangleMeshShape*                 m_terrainShape;
+    btRigidBody*                            m_terrain;
+
+    btBoxShape                              m_chassisBox;
+    btCompoundShape                         m_chassisShape;
+    btAlignedObjectArray<btRigidBody*>      m_chassis;
+
+    btDefaultVehicleRaycaster               m_raycaster;
+    btAlignedObjectArray<btRaycastVehicle*> m_vehicles;
+    btRaycastVehicleFleet                   m_fleet;
+    btAlignedObjectArray<TimedAction*>      m_timedActions;
+
+    VehicleScene(int numVehicles, bool useFleet)
+        :m_dispatcher(&m_collisionConfiguration),
+        m_world(&m_dispatcher,&m_broadphase,&m_solver,&m_collisionConfiguration),
+        m_chassisBox(btVector3(1.f,0.5f,2.f)),
+        m_raycaster(&m_world)
+    {
+        for (int i=0;i<=gridSize;i++)
+        {
+            for (int j=0;j<=gridSize;j++)
+            {
+                m_vertices.push_back(btVector3(i*cellSize,terrainHeight(i,j),j*cellSize));
+            }
+        }
+        for (int i=0;i<gridSize;i++)
+        {
+            for (int j=0;j<gridSize;j++)
+            {
+                int v = i*(gridSize+1)+j;
+                m_indices.push_back(v); m_indices.push_back(v+1); m_indices.push_back(v+gridSize+1);
+                m_indices.push_back(v+1); m_indices.push_back(v+gridSize+2); m_indices.push_back(v+gridSize+1);
+            }
+        }
+        m_mesh = new btTriangleIndexVertexArray(m_indices.size()/3,&m_indices[0],3*sizeof(int),m_vertices.size(),&m_vertices[0].m_floats[0],sizeof(btVector3));
+        m_terrainShape = new btBvhTriangleMeshShape(m_mesh,true);
+        m_terrain = new btRigidBody(0,0,m_terrainShape);
+        m_world.addRigidBody(m_terrain);
+
+        btTransform localTrans;
+        localTrans.setIdentity();
+        localTrans.setOrigin(btVector3(0,1,0));
+        m_chassisShape.addChildShape(localTrans,&m_chassisBox);
+        btScalar mass = 800.f;
+        btVector3 localInertia;
+        m_chassisShape.calculateLocalInertia(mass,localInertia);
+
+        btRaycastVehicle::btVehicleTuning tuning;
+        tuning.m_suspensionStiffness = 20.f;
+        tuning.m_suspensionDamping = 2.3f;
+        tuning.m_suspensionCompression = 4.4f;
+        tuning.m_frictionSlip = 1000.f;
+
+        const btVector3 wheelDirectionCS0(0,-1,0);
+        const btVector3 wheelAxleCS(-1,0,0);
+        const btVector3 connectionPoints[4] = {
+            btVector3(1.f-(0.3f*wheelWidth),connectionHeight,2.f-wheelRadius),
+            btVector3(-1.f+(0.3f*wheelWidth),connectionHeight,2.f-wheelRadius),
+            btVector3(-1.f+(0.3f*wheelWidth),connectionHeight,-2.f+wheelRadius),
+            btVector3(1.f-(0.3f*wheelWidth),connectionHeight,-2.f+wheelRadius)};
+
+        int vehiclesPerRow = int(gridSize*cellSize/vehicleSpacing)-2;
+        m_fleet.setCoordinateSystem(0,1,2);
+        for (int i=0;i<numVehicles;i++)
+        {
+            btVector3 position((1+i%vehiclesPerRow)*vehicleSpacing,0,(1+i/vehiclesPerRow)*vehicleSpacing);
+            position.setY(terrainHeight(int(position.x()/cellSize),int(position.z()/cellSize))+0.5f);
+            btRigidBody* chassis = new btRigidBody(mass,0,&m_chassisShape,localInertia);
+            chassis->setWorldTransform(btTransform(btQuaternion::getIdentity(),position));
+            chassis->setActivationState(DISABLE_DEACTIVATION);
+            m_world.addRigidBody(chassis);
+            m_chassis.push_back(chassis);
+
+            if (useFleet)
+            {
+                int vehicle = m_fleet.addVehicle(chassis);
+                for (int w=0;w<4;w++)
+                {
+                    m_fleet.addWheel(vehicle,connectionPoints[w],wheelDirectionCS0,wheelAxleCS,suspensionRestLength,wheelRadius,tuning,w<2);
+                }
+            } else
+            {
+                btRaycastVehicle* raycastVehicle = new btRaycastVehicle(tuning,chassis,&m_raycaster);
+                raycastVehicle->setCoordinateSystem(0,1,2);
+                for (int w=0;w<4;w++)
+                {
+                    raycastVehicle->addWheel(connectionPoints[w],wheelDirectionCS0,wheelAxleCS,suspensionRestLength,wheelRadius,tuning,w<2);
+                }
+                m_vehicles.push_back(raycastVehicle);
+                TimedAction* action = new TimedAction(raycastVehicle);
+                m_timedActions.push_back(action);
+                m_world.addAction(action);
+            }
+        }
+        if (useFleet)
+        {
+            TimedAction* action = new TimedAction(&m_fleet);
+            m_timedActions.push_back(action);
+            m_world.addAction(action);
+        }
+    }
+
+    ~VehicleScene()
+    {
+        for (int i=0;i<m_timedActions.size();i++)
+        {
+            m_world.removeAction(m_timedActions[i]);
+            delete m_timedActions[i];
+        }
+        for (int i=0;i<m_vehicles.size();i++)
+        {
+            delete m_vehicles[i];
+        }
+        for (int i=0;i<m_chassis.size();i++)
+        {
+            m_world.removeRigidBody(m_chassis[i]);
+            delete m_chassis[i];
+        }
+        m_world.removeRigidBody(m_terrain);
+        delete m_terrain;
+        delete m_terrainShape;
+        delete m_mesh;
+    }
+
+    //the same throttle and steering for both kinds of vehicles
+    void drive(int frame)
+    {
+        for (int i=0;i<m_chassis.size();i++)
+        {
+            btScalar steering = btSin(frame*0.01f+i)*0.3f;
+            btScalar engineForce = (i%4) ? 1000.f : 0.f;
+            btScalar brake = (i%4) ? 0.f : 100.f;
+            for (int w=0;w<4;w++)
+            {
+                if (m_vehicles.size())
+                {
+                    if (w<2)
+                        m_vehicles[i]->setSteeringValue(steering,w);
+                    else
+                    {
+                        m_vehicles[i]->applyEngineForce(engineForce,w);
+                        m_vehicles[i]->setBrake(brake,w);
+                    }
+                } else
+                {
+                    if (w<2)
+                        m_fleet.setSteeringValue(steering,i,w);
+                    else
+                    {
+                        m_fleet.applyEngineForce(engineForce,i,w);
+                        m_fleet.setBrake(brake,i,w);
+                    }
+                }
+            }
+        }
+    }
+
+    unsigned long actionTime() const
+    {
+        unsigned long time = 0;
+        for (int i=0;i<m_timedActions.size();i++)
+        {
+            time += m_timedActions[i]->m_time;
+        }
+        return time;
+    }
+};
+
+static btScalar maxDifference(const VehicleScene& a, const VehicleScene& b)
+{
+    btScalar maxDiff = 0.f;
+    for (int i=0;i<a.m_chassis.size();i++)
+    {
+        maxDiff = btMax(maxDiff,(a.m_chassis[i]->getCenterOfMassPosition()-b.m_chassis[i]->getCenterOfMassPosition()).length());
+    }
+    return maxDiff;
+}
+
+int main(int argc, char* argv[])
+{
+    const int vehicleCounts[] = {250,2000};
+    const int numFrames = 300;
+    int numThreads = argc>1 ? atoi(argv[1]) : 4;
+
+    btITaskScheduler* scheduler = btCreateDefaultTaskScheduler(numThreads);
+
+    printf("vehicles   btRaycastVehicle   fleet 1 thread   fleet %d threads   (us per frame in the vehicle actions, max chassis difference)\n",scheduler->getNumThreads());
+    for (int c=0;c<int(sizeof(vehicleCounts)/sizeof(vehicleCounts[0]));c++)
+    {
+        int numVehicles = vehicleCounts[c];
+        VehicleScene vehicles(numVehicles,false);
+        VehicleScene fleet(numVehicles,true);
+        VehicleScene parallelFleet(numVehicles,true);
+
+        btScalar fleetDifference = 0.f;
+        btScalar parallelFleetDifference = 0.f;
+        for (int frame=0;frame<numFrames;frame++)
+        {
+            vehicles.drive(frame);
+            vehicles.m_world.stepSimulation(1.f/60.f,0);
+            fleet.drive(frame);
+            fleet.m_world.stepSimulation(1.f/60.f,0);
+            btSetTaskScheduler(scheduler);
+            parallelFleet.drive(frame);
+            parallelFleet.m_world.stepSimulation(1.f/60.f,0);
+            btSetTaskScheduler(0);
+            if (frame==60)
+            {
+                fleetDifference = maxDifference(vehicles,fleet);
+                parallelFleetDifference = maxDifference(vehicles,parallelFleet);
+            }
+        }
+
+        printf("%-10d %-18lu %-16lu %-17lu (%f, %f)\n",numVehicles,vehicles.actionTime()/numFrames,fleet.actionTime()/numFrames,parallelFleet.actionTime()/numFrames,
+            fleetDifference,parallelFleetDifference);
+    }
+    btDeleteTaskScheduler(scheduler);
+    return 0;
+}
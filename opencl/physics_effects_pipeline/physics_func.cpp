@@ -145,7 +145,7 @@ void broadphase()
 		PfxFindPairsParam findPairsParam;
 		findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(NUM_CONTACTS);
 		findPairsParam.pairBuff = pool.allocate(findPairsParam.pairBytes);
-		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(NUM_CONTACTS);
+		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(numRigidBodies,NUM_CONTACTS);
 		findPairsParam.workBuff = pool.allocate(findPairsParam.workBytes);
 		findPairsParam.proxies = proxies;
 		findPairsParam.numProxies = numRigidBodies;
@@ -308,8 +308,6 @@ void collision()
 	for(PfxUInt32 i=0;i<numCurrentPairs;i++) {
 		PfxConstraintPair &pair = currentPairs[i];
 	
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 
 		PfxContactManifold &contact = contacts[iConstraint];
@@ -361,8 +359,8 @@ PfxInt32 BulletSetupContactConstraints(PfxSetupContactConstraintsParam &param)
 	//		continue;
 		//}
 
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
+		PfxUInt32 iA = pfxGetObjectIdA(pair);
+		PfxUInt32 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 
 		PfxContactManifold &contact = offsetContactManifolds[iConstraint];
@@ -504,8 +502,6 @@ PfxInt32 BulletWriteWarmstartContactConstraints(PfxSetupContactConstraintsParam
 	{
 		PfxConstraintPair &pair = contactPairs[i];
 
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 
 		PfxContactManifold &contact = offsetContactManifolds[iConstraint];
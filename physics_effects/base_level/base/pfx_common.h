@@ -62,6 +62,14 @@ namespace PhysicsEffects {
 
 typedef bool                        PfxBool;
 typedef float                       PfxFloat;
+
+//J 剛体のID。SCE_PFX_USE_WIDE_OBJECT_IDを定義すると32ビットになり、65535個を超える剛体を扱える
+//E Rigid body id. Defining SCE_PFX_USE_WIDE_OBJECT_ID makes it 32 bits to handle more than 65535 rigid bodies
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+typedef PfxUInt32                   PfxObjectId;
+#else
+typedef PfxUInt16                   PfxObjectId;
+#endif
 } //namespace PhysicsEffects
 } //namespace sce
 
@@ -19,6 +19,10 @@ Physics Effects under the filename: physics_effects_license.txt
 
 #include "pfx_common.h"
 
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
 //J パフォーマンス測定する場合はPFX_USE_PERFCOUNTERを定義
 //J ブックマークを使用する場合はPFX_USE_BOOKMARKを定義
 
@@ -46,12 +50,18 @@ private:
 	SCE_PFX_PADDING(1,4)
 #ifdef _WIN32
 	LONGLONG  m_cnt[SCE_PFX_MAX_PERF_COUNT*2];
+#else
+	PfxUInt64 m_cnt[SCE_PFX_MAX_PERF_COUNT*2];
 #endif
 
 	void count(int i)
 	{
 #ifdef _WIN32
 		QueryPerformanceCounter( (LARGE_INTEGER *)&m_cnt[i] );
+#else
+		struct timeval tv;
+		gettimeofday(&tv,NULL);
+		m_cnt[i] = (PfxUInt64)tv.tv_sec * 1000000 + (PfxUInt64)tv.tv_usec;
 #endif
 	}
 
@@ -62,6 +72,8 @@ public:
 		LARGE_INTEGER sPerfCountFreq;
 		QueryPerformanceFrequency(&sPerfCountFreq);
 		m_freq = (float)sPerfCountFreq.QuadPart;
+#else
+		m_freq = 1000000.0f;
 #endif
 		resetCount();
 	}
@@ -93,12 +105,8 @@ public:
 
 	float getCountTime(int i)
 	{
-#if _WIN32
-	return (float)(m_cnt[i+1]-m_cnt[i]) / m_freq * 1000.0f;
-#else
-	return 0.f;
-#endif	
-}
+		return (float)(m_cnt[i+1]-m_cnt[i]) / m_freq * 1000.0f;
+	}
 
 	void printCount()
 	{
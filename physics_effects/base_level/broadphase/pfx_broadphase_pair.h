@@ -24,20 +24,37 @@ namespace PhysicsEffects {
 
 typedef PfxSortData16 PfxBroadphasePair;
 
-SCE_PFX_FORCE_INLINE void pfxSetObjectIdA(PfxBroadphasePair &pair,PfxUInt16 i)	{pair.set16(0,i);}
-SCE_PFX_FORCE_INLINE void pfxSetObjectIdB(PfxBroadphasePair &pair,PfxUInt16 i)	{pair.set16(1,i);}
-SCE_PFX_FORCE_INLINE void pfxSetMotionMaskA(PfxBroadphasePair &pair,PfxUInt8 i)		{pair.set8(4,i);}
-SCE_PFX_FORCE_INLINE void pfxSetMotionMaskB(PfxBroadphasePair &pair,PfxUInt8 i)		{pair.set8(5,i);}
-SCE_PFX_FORCE_INLINE void pfxSetBroadphaseFlag(PfxBroadphasePair &pair,PfxUInt8 f)	{pair.set8(6,(pair.get8(6)&0xf0)|(f&0x0f));}
-SCE_PFX_FORCE_INLINE void pfxSetActive(PfxBroadphasePair &pair,PfxBool b)			{pair.set8(6,(pair.get8(6)&0x0f)|((b?1:0)<<4));}
+//J ペアのレイアウト
+//J 16ビットID : [ID A,ID B][マスクA,マスクB,フラグ,拘束数][コンタクトID][キー]
+//J 32ビットID : [ID A][ID B][コンタクトID][マスクA,マスクB,フラグ,拘束数] (キーはIDから求める)
+//E Layout of a pair
+//E 16 bit ids : [id A,id B][mask A,mask B,flag,number of constraints][contact id][key]
+//E 32 bit ids : [id A][id B][contact id][mask A,mask B,flag,number of constraints] (the key is derived from the ids)
+
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+#define SCE_PFX_PAIR_BYTE_SLOT 12
+SCE_PFX_FORCE_INLINE void pfxSetObjectIdA(PfxBroadphasePair &pair,PfxObjectId i)	{pair.set32(0,i);}
+SCE_PFX_FORCE_INLINE void pfxSetObjectIdB(PfxBroadphasePair &pair,PfxObjectId i)	{pair.set32(1,i);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectIdA(const PfxBroadphasePair &pair)	{return pair.get32(0);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectIdB(const PfxBroadphasePair &pair)	{return pair.get32(1);}
+#else
+#define SCE_PFX_PAIR_BYTE_SLOT 4
+SCE_PFX_FORCE_INLINE void pfxSetObjectIdA(PfxBroadphasePair &pair,PfxObjectId i)	{pair.set16(0,i);}
+SCE_PFX_FORCE_INLINE void pfxSetObjectIdB(PfxBroadphasePair &pair,PfxObjectId i)	{pair.set16(1,i);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectIdA(const PfxBroadphasePair &pair)	{return pair.get16(0);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectIdB(const PfxBroadphasePair &pair)	{return pair.get16(1);}
+#endif
+
+SCE_PFX_FORCE_INLINE void pfxSetMotionMaskA(PfxBroadphasePair &pair,PfxUInt8 i)		{pair.set8(SCE_PFX_PAIR_BYTE_SLOT,i);}
+SCE_PFX_FORCE_INLINE void pfxSetMotionMaskB(PfxBroadphasePair &pair,PfxUInt8 i)		{pair.set8(SCE_PFX_PAIR_BYTE_SLOT+1,i);}
+SCE_PFX_FORCE_INLINE void pfxSetBroadphaseFlag(PfxBroadphasePair &pair,PfxUInt8 f)	{pair.set8(SCE_PFX_PAIR_BYTE_SLOT+2,(pair.get8(SCE_PFX_PAIR_BYTE_SLOT+2)&0xf0)|(f&0x0f));}
+SCE_PFX_FORCE_INLINE void pfxSetActive(PfxBroadphasePair &pair,PfxBool b)			{pair.set8(SCE_PFX_PAIR_BYTE_SLOT+2,(pair.get8(SCE_PFX_PAIR_BYTE_SLOT+2)&0x0f)|((b?1:0)<<4));}
 SCE_PFX_FORCE_INLINE void pfxSetContactId(PfxBroadphasePair &pair,PfxUInt32 i)		{pair.set32(2,i);}
 
-SCE_PFX_FORCE_INLINE PfxUInt16 pfxGetObjectIdA(const PfxBroadphasePair &pair)	{return pair.get16(0);}
-SCE_PFX_FORCE_INLINE PfxUInt16 pfxGetObjectIdB(const PfxBroadphasePair &pair)	{return pair.get16(1);}
-SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetMotionMaskA(const PfxBroadphasePair &pair)		{return pair.get8(4);}
-SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetMotionMaskB(const PfxBroadphasePair &pair)		{return pair.get8(5);}
-SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetBroadphaseFlag(const PfxBroadphasePair &pair)	{return pair.get8(6)&0x0f;}
-SCE_PFX_FORCE_INLINE PfxBool   pfxGetActive(const PfxBroadphasePair &pair)			{return (pair.get8(6)>>4)!=0;}
+SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetMotionMaskA(const PfxBroadphasePair &pair)		{return pair.get8(SCE_PFX_PAIR_BYTE_SLOT);}
+SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetMotionMaskB(const PfxBroadphasePair &pair)		{return pair.get8(SCE_PFX_PAIR_BYTE_SLOT+1);}
+SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetBroadphaseFlag(const PfxBroadphasePair &pair)	{return pair.get8(SCE_PFX_PAIR_BYTE_SLOT+2)&0x0f;}
+SCE_PFX_FORCE_INLINE PfxBool   pfxGetActive(const PfxBroadphasePair &pair)			{return (pair.get8(SCE_PFX_PAIR_BYTE_SLOT+2)>>4)!=0;}
 SCE_PFX_FORCE_INLINE PfxUInt32 pfxGetContactId(const PfxBroadphasePair &pair)		{return pair.get32(2);}
 
 } //namespace PhysicsEffects
@@ -25,13 +25,21 @@ typedef PfxSortData32 PfxBroadphaseProxy;
 //J	AABBパラメータはPfxAabbと共通
 //E PfxBroadphaseProxy shares AABB parameters with PfxAabb32
 
-SCE_PFX_FORCE_INLINE void pfxSetObjectId(PfxBroadphaseProxy &proxy,PfxUInt16 i)	   {proxy.set16(6,i);}
+//J 32ビットIDは使われていないスロット4に格納する
+//E 32 bit ids are stored in the unused slot 4
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+SCE_PFX_FORCE_INLINE void pfxSetObjectId(PfxBroadphaseProxy &proxy,PfxObjectId i)     {proxy.set32(4,i);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectId(const PfxBroadphaseProxy &proxy)     {return proxy.get32(4);}
+#else
+SCE_PFX_FORCE_INLINE void pfxSetObjectId(PfxBroadphaseProxy &proxy,PfxObjectId i)     {proxy.set16(6,i);}
+SCE_PFX_FORCE_INLINE PfxObjectId pfxGetObjectId(const PfxBroadphaseProxy &proxy)     {return proxy.get16(6);}
+#endif
+
 SCE_PFX_FORCE_INLINE void pfxSetMotionMask(PfxBroadphaseProxy &proxy,PfxUInt8 i)   {proxy.set8(14,i);}
 SCE_PFX_FORCE_INLINE void pfxSetProxyFlag(PfxBroadphaseProxy &proxy,PfxUInt8 i)    {proxy.set8(15,i);}
 SCE_PFX_FORCE_INLINE void pfxSetSelf(PfxBroadphaseProxy &proxy,PfxUInt32 i)        {proxy.set32(5,i);}
 SCE_PFX_FORCE_INLINE void pfxSetTarget(PfxBroadphaseProxy &proxy,PfxUInt32 i)      {proxy.set32(6,i);}
 
-SCE_PFX_FORCE_INLINE PfxUInt16 pfxGetObjectId(const PfxBroadphaseProxy &proxy)     {return proxy.get16(6);}
 SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetMotionMask(const PfxBroadphaseProxy &proxy)   {return proxy.get8(14);}
 SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetProxyFlag(const PfxBroadphaseProxy &proxy)	   {return proxy.get8(15);}
 SCE_PFX_FORCE_INLINE PfxUInt32 pfxGetSelf(const PfxBroadphaseProxy &proxy)		   {return proxy.get32(5);}
@@ -64,15 +64,24 @@ struct PfxContactPoint
 class SCE_PFX_ALIGNED(128) PfxContactManifold
 {
 private:
-	PfxUInt16 m_rigidBodyIdA,m_rigidBodyIdB;
+	PfxObjectId m_rigidBodyIdA,m_rigidBodyIdB;
 	PfxUInt16 m_duration;
 	PfxUInt16 m_numContacts;
 	PfxFloat  m_compositeFriction;
+#ifndef SCE_PFX_USE_WIDE_OBJECT_ID
 	PfxUInt32 m_internalFlag;
+#endif
 	PfxContactPoint m_contactPoints[SCE_PFX_NUMCONTACTS_PER_BODIES];
 	void		*m_userData;
 	PfxUInt32	m_userParam[4];
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+	//J 32ビットIDのときはコンタクトポイントの配置を変えないよう後ろに置く
+	//E Placed here with 32 bit ids not to move the contact points
+	PfxUInt32 m_internalFlag;
+	SCE_PFX_PADDING(1,24)
+#else
 	SCE_PFX_PADDING(1,28)
+#endif
 
 	int findNearestContactPoint(const PfxPoint3 &newPoint,const PfxVector3 &newNormal);
 	int sort4ContactPoints(const PfxPoint3 &newPoint,PfxFloat newDistance);
@@ -86,7 +95,7 @@ public:
 	void setInternalFlag(PfxUInt32 f) {m_internalFlag = f;}
 
 public:
-	void reset(PfxUInt16 rigidBodyIdA,PfxUInt16 rigidBodyIdB)
+	void reset(PfxObjectId rigidBodyIdA,PfxObjectId rigidBodyIdB)
 	{
 		m_userData = 0;
 		m_userParam[0] = m_userParam[1] = m_userParam[2] = m_userParam[3] = 0;
@@ -124,9 +133,9 @@ public:
 	
 	PfxUInt16 getDuration() const {return m_duration;}
 	
-	PfxUInt16 getRigidBodyIdA() const {return m_rigidBodyIdA;}
+	PfxObjectId getRigidBodyIdA() const {return m_rigidBodyIdA;}
 	
-	PfxUInt16 getRigidBodyIdB() const {return m_rigidBodyIdB;}
+	PfxObjectId getRigidBodyIdB() const {return m_rigidBodyIdB;}
 };
 
 } //namespace PhysicsEffects
@@ -29,10 +29,10 @@ typedef PfxSortData16 PfxConstraintPair;
 //E Same as PfxBroadphasePair
 
 SCE_PFX_FORCE_INLINE void pfxSetConstraintId(PfxConstraintPair &pair,PfxUInt32 i)	{pair.set32(2,i);}
-SCE_PFX_FORCE_INLINE void pfxSetNumConstraints(PfxConstraintPair &pair,PfxUInt8 n)	{pair.set8(7,n);}
+SCE_PFX_FORCE_INLINE void pfxSetNumConstraints(PfxConstraintPair &pair,PfxUInt8 n)	{pair.set8(SCE_PFX_PAIR_BYTE_SLOT+3,n);}
 
 SCE_PFX_FORCE_INLINE PfxUInt32 pfxGetConstraintId(const PfxConstraintPair &pair)	{return pair.get32(2);}
-SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetNumConstraints(const PfxConstraintPair &pair)	{return pair.get8(7);}
+SCE_PFX_FORCE_INLINE PfxUInt8  pfxGetNumConstraints(const PfxConstraintPair &pair)	{return pair.get8(SCE_PFX_PAIR_BYTE_SLOT+3);}
 
 } //namespace PhysicsEffects
 } //namespace sce
@@ -98,21 +98,25 @@ unsigned int i=0,j=0;
 
 while(i<n1&&j<n2) {
 	if(Key(d1[i]) < Key(d2[j])) {
-		buff[i+j] = d1[i++];
+		buff[i+j] = d1[i];
+		i++;
 	}
 	else {
-		buff[i+j] = d2[j++];
+		buff[i+j] = d2[j];
+		j++;
 	}
 }
 
 if(i<n1) {
 	while(i<n1) {
-		buff[i+j] = d1[i++];
+		buff[i+j] = d1[i];
+		i++;
 	}
 }
 else if(j<n2) {
 	while(j<n2) {
-		buff[i+j] = d2[j++];
+		buff[i+j] = d2[j];
+		j++;
 	}
 }
 
@@ -250,6 +254,32 @@ void pfxHybridSort(SortData *data,SortData *buff,unsigned int n)
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Insertion Sort
+
+template <class SortData>
+bool pfxInsertionSortInternal(SortData *d,unsigned int n,unsigned int maxMoves)
+{
+unsigned int numMoves = 0;
+
+for(unsigned int i=1;i<n;i++) {
+	if(Key(d[i-1]) <= Key(d[i])) continue;
+
+	SortData tmp = d[i];
+	unsigned int j = i;
+	while(j>0 && Key(d[j-1]) > Key(tmp)) {
+		d[j] = d[j-1];
+		j--;
+	}
+	d[j] = tmp;
+
+	numMoves += i-j;
+	if(numMoves > maxMoves) return false;
+}
+
+return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Single Sort
 
@@ -263,5 +293,15 @@ void pfxSort(PfxSortData32 *data,PfxSortData32 *buff,unsigned int n)
 pfxMergeSort(data,buff,n);
 }
 
+bool pfxInsertionSort(PfxSortData16 *data,unsigned int n,unsigned int maxMoves)
+{
+return pfxInsertionSortInternal(data,n,maxMoves);
+}
+
+bool pfxInsertionSort(PfxSortData32 *data,unsigned int n,unsigned int maxMoves)
+{
+return pfxInsertionSortInternal(data,n,maxMoves);
+}
+
 } //namespace PhysicsEffects
 } //namespace sce
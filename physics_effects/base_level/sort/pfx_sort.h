@@ -27,6 +27,17 @@ namespace PhysicsEffects {
 void pfxSort(PfxSortData16 *data,PfxSortData16 *buff,unsigned int n);
 void pfxSort(PfxSortData32 *data,PfxSortData32 *buff,unsigned int n);
 
+///////////////////////////////////////////////////////////////////////////////
+// Insertion Sort
+
+//J ほぼ整列済みのデータ用の挿入ソート
+//J 要素の移動回数がmaxMovesを超えた場合は途中で止めてfalseを返す。その場合はpfxSort()で並べ直すこと
+//E Insertion sort for nearly sorted data
+//E Stops and returns false when the elements have been moved more than maxMoves times, sort the data with pfxSort() then
+
+bool pfxInsertionSort(PfxSortData16 *data,unsigned int n,unsigned int maxMoves);
+bool pfxInsertionSort(PfxSortData32 *data,unsigned int n,unsigned int maxMoves);
+
 } //namespace PhysicsEffects
 } //namespace sce
 
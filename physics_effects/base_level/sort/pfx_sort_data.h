@@ -56,11 +56,35 @@ PfxUInt16 get16(int slot) const {return i16data[slot];}
 PfxUInt32 get32(int slot) const {return i32data[slot];}
 };
 
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+
+//J 32ビットIDのペアを16バイトに収めるため、PfxSortData16のキーは格納せずスロット0と1のIDから求める
+//E To keep pairs of 32 bit ids in 16 bytes, the key of PfxSortData16 is not stored but derived from the ids in slot 0 and 1
+
+typedef PfxUInt64 PfxSortKey16;
+
+SCE_PFX_FORCE_INLINE
+PfxSortKey16 pfxGetKey(const PfxSortData16 &sortData)
+{
+	PfxUInt32 i = sortData.get32(0);
+	PfxUInt32 j = sortData.get32(1);
+	return ((PfxSortKey16)SCE_PFX_MAX(i,j)<<32)|SCE_PFX_MIN(i,j);
+}
+
+SCE_PFX_FORCE_INLINE
+void pfxSetKey(PfxSortData16 &sortData,PfxSortKey16 key) {(void)sortData;(void)key;SCE_PFX_ASSERT(key == pfxGetKey(sortData));}
+
+#else
+
+typedef PfxUInt32 PfxSortKey16;
+
 SCE_PFX_FORCE_INLINE
-void pfxSetKey(PfxSortData16 &sortData,PfxUInt32 key) {sortData.set32(3,key);}
+void pfxSetKey(PfxSortData16 &sortData,PfxSortKey16 key) {sortData.set32(3,key);}
 
 SCE_PFX_FORCE_INLINE
-PfxUInt32 pfxGetKey(const PfxSortData16 &sortData) {return sortData.get32(3);}
+PfxSortKey16 pfxGetKey(const PfxSortData16 &sortData) {return sortData.get32(3);}
+
+#endif
 
 SCE_PFX_FORCE_INLINE
 void pfxSetKey(PfxSortData32 &sortData,PfxUInt32 key) {sortData.set32(7,key);}
@@ -69,11 +93,15 @@ SCE_PFX_FORCE_INLINE
 PfxUInt32 pfxGetKey(const PfxSortData32 &sortData) {return sortData.get32(7);}
 
 SCE_PFX_FORCE_INLINE
-PfxUInt32 pfxCreateUniqueKey(PfxUInt32 i,PfxUInt32 j)
+PfxSortKey16 pfxCreateUniqueKey(PfxUInt32 i,PfxUInt32 j)
 {
 	PfxUInt32 minIdx = SCE_PFX_MIN(i,j);
 	PfxUInt32 maxIdx = SCE_PFX_MAX(i,j);
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+	return ((PfxSortKey16)maxIdx<<32)|minIdx;
+#else
 	return (maxIdx<<16)|(minIdx&0xffff);
+#endif
 }
 
 } // namespace PhysicsEffects
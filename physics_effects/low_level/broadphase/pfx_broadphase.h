@@ -63,6 +63,42 @@ PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUp
 
 PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUpdateBroadphaseProxiesResult &result,PfxTaskManager *taskManager);
 
+///////////////////////////////////////////////////////////////////////////////
+// Update Sorted Broadphase Proxies
+
+//J 前のフレームでソートしたプロキシ配列をその並び順のまま更新し、挿入ソートで並べ直す
+//J 軸は剛体の中心の分散が最も大きい軸を選ぶ。軸を変えたときと剛体が大きく動いたときは全体をソートし直す
+//J 初回や剛体の数が変わったときはaxisに-1を指定してプロキシを作り直す。次のフレームではresult.axisをparam.axisに渡す
+//E Update a proxy array sorted in the previous frame in place and sort it again with an insertion sort
+//E The axis is chosen by the largest variance of the rigid body centers, the whole array is sorted again when the axis changes or rigid bodies moved a lot
+//E Set axis to -1 to create the proxies from scratch at the first frame or when the number of rigid bodies changes, pass result.axis to param.axis in the next frame
+
+struct PfxUpdateSortedBroadphaseProxiesParam {
+	void *workBuff;
+	PfxUInt32 workBytes;
+	PfxBroadphaseProxy *proxies;
+	PfxRigidState *offsetRigidStates;
+	PfxCollidable *offsetCollidables;
+	PfxUInt32 numRigidBodies;
+	PfxUInt32 outOfWorldBehavior;
+	PfxVector3 worldCenter;
+	PfxVector3 worldExtent;
+	int axis;
+	
+	PfxUpdateSortedBroadphaseProxiesParam() : outOfWorldBehavior(0),axis(-1) {}
+};
+
+struct PfxUpdateSortedBroadphaseProxiesResult {
+	PfxInt32 numOutOfWorldProxies;
+	int axis;
+};
+
+PfxUInt32 pfxGetWorkBytesOfUpdateSortedBroadphaseProxies(PfxUInt32 numRigidBodies);
+
+PfxInt32 pfxUpdateSortedBroadphaseProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result);
+
+PfxInt32 pfxUpdateSortedBroadphaseProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result,PfxTaskManager *taskManager);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Find Pairs
 
@@ -77,12 +113,19 @@ struct PfxFindPairsParam {
 	int axis;
 };
 
+//J ペアはキーの順に出力される。プロキシのオブジェクトIDがnumProxies未満のときは全体のソートを省略できる
+//E Pairs are output in the order of their keys. Sorting all pairs is skipped when object ids of the proxies are less than numProxies
+//J 1軸のスイープなので、各プロキシはソート軸の区間が重なる全てのプロキシと比較される。
+//J 平面上に格子状に並んだ積み上げのように、ソート軸に垂直な方向へ広がった配置では比較回数がおよそn^1.5で増える
+//E This is a single axis sweep, so each proxy is tested against all proxies overlapping it on the sort axis.
+//E When rigid bodies spread across the sort axis, like a grid of stacks on a plane, the number of tests grows with about n^1.5
+
 struct PfxFindPairsResult {
 	PfxBroadphasePair *pairs;
 	PfxUInt32 numPairs;
 };
 
-PfxUInt32 pfxGetWorkBytesOfFindPairs(PfxUInt32 maxPairs,PfxUInt32 maxTasks=1);
+PfxUInt32 pfxGetWorkBytesOfFindPairs(PfxUInt32 numProxies,PfxUInt32 maxPairs,PfxUInt32 maxTasks=1);
 PfxUInt32 pfxGetPairBytesOfFindPairs(PfxUInt32 maxPairs);
 
 PfxInt32 pfxFindPairs(PfxFindPairsParam &param,PfxFindPairsResult &result);
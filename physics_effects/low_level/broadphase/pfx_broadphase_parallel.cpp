@@ -0,0 +1,282 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "base_level/base/pfx_perf_counter.h"
+#include "base_level/sort/pfx_sort.h"
+#include "low_level/broadphase/pfx_broadphase.h"
+
+namespace sce {
+namespace PhysicsEffects {
+
+extern PfxInt32 pfxCheckParamOfUpdateBroadphaseProxies(const PfxUpdateBroadphaseProxiesParam &param);
+extern PfxInt32 pfxCheckParamOfUpdateSortedBroadphaseProxies(const PfxUpdateSortedBroadphaseProxiesParam &param);
+extern PfxInt32 pfxCheckParamOfFindPairs(const PfxFindPairsParam &param,int maxTasks);
+extern PfxInt32 pfxUpdateBroadphaseProxiesRange(PfxUpdateBroadphaseProxiesParam &param,PfxUInt32 start,PfxUInt32 num);
+extern PfxInt32 pfxUpdateSortedBroadphaseProxiesRange(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUInt32 start,PfxUInt32 num);
+extern void pfxSortUpdatedProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result);
+extern PfxInt32 pfxFindPairsRange(const PfxFindPairsParam &param,PfxUInt32 start,PfxUInt32 num,PfxBroadphasePair *pairs,PfxUInt32 &numPairs,PfxUInt32 maxPairs);
+extern void pfxGatherPairsInKeyOrder(
+	PfxBroadphasePair **srcPairs,const PfxUInt32 *numSrcPairs,PfxUInt32 numSrcs,
+	PfxBroadphasePair *pairs,PfxUInt32 numProxies,
+	PfxUInt32 *counts,PfxBroadphasePair *workPairs);
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI THREADS
+
+#define SCE_PFX_FIND_PAIRS_BATCH 32
+
+struct PfxSortProxiesIO {
+	PfxBroadphaseProxy *proxies[6];
+	PfxBroadphaseProxy *workProxies[6];
+	PfxUInt32 numProxies;
+};
+
+struct PfxFindPairsIO {
+	PfxFindPairsParam *param;
+	PfxBroadphasePair *taskPairs;
+	PfxUInt32 maxTaskPairs;
+};
+
+void pfxUpdateBroadphaseProxiesTaskEntry(PfxTaskArg *arg)
+{
+	PfxUpdateBroadphaseProxiesParam &param = *((PfxUpdateBroadphaseProxiesParam*)arg->io);
+	arg->data[2] = pfxUpdateBroadphaseProxiesRange(param,arg->data[0],arg->data[1]);
+}
+
+void pfxUpdateSortedBroadphaseProxiesTaskEntry(PfxTaskArg *arg)
+{
+	PfxUpdateSortedBroadphaseProxiesParam &param = *((PfxUpdateSortedBroadphaseProxiesParam*)arg->io);
+	arg->data[2] = pfxUpdateSortedBroadphaseProxiesRange(param,arg->data[0],arg->data[1]);
+}
+
+void pfxSortProxiesTaskEntry(PfxTaskArg *arg)
+{
+	PfxSortProxiesIO &io = *((PfxSortProxiesIO*)arg->io);
+	for(int axis=arg->taskId;axis<6;axis+=arg->maxTasks) {
+		pfxSort(io.proxies[axis],io.workProxies[axis],io.numProxies);
+	}
+}
+
+void pfxFindPairsTaskEntry(PfxTaskArg *arg)
+{
+	PfxFindPairsIO &io = *((PfxFindPairsIO*)arg->io);
+	PfxFindPairsParam &param = *io.param;
+
+	//J 各タスクは自分のバッファにペアを出力する
+	//E Each task writes the pairs into its own buffer
+	PfxBroadphasePair *pairs = io.taskPairs + io.maxTaskPairs * arg->taskId;
+	PfxUInt32 numPairs = 0;
+	PfxInt32 ret = SCE_PFX_OK;
+
+	for(;;) {
+		arg->criticalSection->lock();
+		PfxUInt32 start = arg->criticalSection->getSharedParam(0);
+		arg->criticalSection->setSharedParam(0,start+SCE_PFX_FIND_PAIRS_BATCH);
+		arg->criticalSection->unlock();
+
+		if(start >= param.numProxies) break;
+
+		ret = pfxFindPairsRange(param,start,SCE_PFX_MIN(SCE_PFX_FIND_PAIRS_BATCH,param.numProxies-start),pairs,numPairs,io.maxTaskPairs);
+		if(ret != SCE_PFX_OK) break;
+	}
+
+	arg->data[0] = numPairs;
+	arg->data[1] = (PfxUInt32)ret;
+}
+
+PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUpdateBroadphaseProxiesResult &result,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxUpdateBroadphaseProxies(param,result);
+
+	PfxInt32 ret = pfxCheckParamOfUpdateBroadphaseProxies(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(param.workBuff,param.workBytes) < pfxGetWorkBytesOfUpdateBroadphaseProxies(param.numRigidBodies,numTasks)) return SCE_PFX_ERR_OUT_OF_BUFFER;
+
+	SCE_PFX_PUSH_MARKER("pfxUpdateBroadphaseProxies")
+
+	//J プロキシの更新
+	//E Update proxies
+	taskManager->setTaskEntry((void*)pfxUpdateBroadphaseProxiesTaskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		PfxUInt32 start = param.numRigidBodies * t / numTasks;
+		PfxUInt32 end = param.numRigidBodies * (t+1) / numTasks;
+		taskManager->startTask(t,&param,start,end-start,0,0);
+	}
+
+	result.numOutOfWorldProxies = 0;
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+		result.numOutOfWorldProxies += (PfxInt32)data3;
+	}
+
+	//J 6軸のプロキシ配列をそれぞれ別のタスクでソート
+	//E Sort the proxy arrays of the 6 axes on separate tasks
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+
+	PfxSortProxiesIO *io = (PfxSortProxiesIO*)taskManager->allocate(sizeof(PfxSortProxiesIO));
+	io->proxies[0] = param.proxiesX;
+	io->proxies[1] = param.proxiesY;
+	io->proxies[2] = param.proxiesZ;
+	io->proxies[3] = param.proxiesXb;
+	io->proxies[4] = param.proxiesYb;
+	io->proxies[5] = param.proxiesZb;
+	for(int axis=0;axis<6;axis++) {
+		io->workProxies[axis] = (PfxBroadphaseProxy*)pool.allocate(sizeof(PfxBroadphaseProxy)*param.numRigidBodies,PfxHeapManager::ALIGN128);
+	}
+	io->numProxies = param.numRigidBodies;
+
+	PfxUInt32 numSortTasks = SCE_PFX_MIN(numTasks,6);
+
+	taskManager->setTaskEntry((void*)pfxSortProxiesTaskEntry);
+
+	for(PfxUInt32 t=0;t<numSortTasks;t++) {
+		taskManager->startTask(t,io,0,0,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numSortTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+
+	taskManager->deallocate(io);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxUpdateSortedBroadphaseProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxUpdateSortedBroadphaseProxies(param,result);
+
+	PfxInt32 ret = pfxCheckParamOfUpdateSortedBroadphaseProxies(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxUpdateSortedBroadphaseProxies")
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	//J プロキシをその場で更新
+	//E Update proxies in place
+	taskManager->setTaskEntry((void*)pfxUpdateSortedBroadphaseProxiesTaskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		PfxUInt32 start = param.numRigidBodies * t / numTasks;
+		PfxUInt32 end = param.numRigidBodies * (t+1) / numTasks;
+		taskManager->startTask(t,&param,start,end-start,0,0);
+	}
+
+	result.numOutOfWorldProxies = 0;
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+		result.numOutOfWorldProxies += (PfxInt32)data3;
+	}
+
+	//J ほぼ整列済みのプロキシの並べ直しは1スレッドで行う
+	//E Sorting the nearly sorted proxies is done on the calling thread
+	pfxSortUpdatedProxies(param,result);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxFindPairs(PfxFindPairsParam &param,PfxFindPairsResult &result,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxFindPairs(param,result);
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	PfxInt32 ret = pfxCheckParamOfFindPairs(param,numTasks);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxFindPairs")
+
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+
+	PfxFindPairsIO *io = (PfxFindPairsIO*)taskManager->allocate(sizeof(PfxFindPairsIO));
+	io->param = &param;
+	io->maxTaskPairs = param.maxPairs;
+	io->taskPairs = (PfxBroadphasePair*)pool.allocate(sizeof(PfxBroadphasePair)*param.maxPairs*numTasks,PfxHeapManager::ALIGN128);
+	PfxUInt32 *counts = (PfxUInt32*)pool.allocate(sizeof(PfxUInt32)*(param.numProxies+1));
+
+	taskManager->setTaskEntry((void*)pfxFindPairsTaskEntry);
+	taskManager->setSharedParam(0,0);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		taskManager->startTask(t,io,0,0,0,0);
+	}
+
+	PfxUInt32 *numTaskPairs = (PfxUInt32*)taskManager->allocate(sizeof(PfxUInt32)*numTasks);
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+		numTaskPairs[taskId] = data1;
+		if((PfxInt32)data2 != SCE_PFX_OK) ret = (PfxInt32)data2;
+	}
+
+	//J 各タスクのペアをキーの順に出力バッファへ集める
+	//E Gather the pairs of all tasks into the output buffer in the key order
+	PfxBroadphasePair *pairs = (PfxBroadphasePair*)SCE_PFX_PTR_ALIGN16(param.pairBuff);
+	PfxUInt32 numPairs = 0;
+
+	if(ret == SCE_PFX_OK) {
+		for(PfxUInt32 t=0;t<numTasks;t++) {
+			numPairs += numTaskPairs[t];
+		}
+		if(numPairs > param.maxPairs) {
+			ret = SCE_PFX_ERR_OUT_OF_MAX_PAIRS;
+		}
+	}
+
+	if(ret == SCE_PFX_OK) {
+		PfxBroadphasePair **taskPairs = (PfxBroadphasePair**)taskManager->allocate(sizeof(PfxBroadphasePair*)*numTasks);
+		for(PfxUInt32 t=0;t<numTasks;t++) {
+			taskPairs[t] = io->taskPairs + io->maxTaskPairs * t;
+		}
+
+		pfxGatherPairsInKeyOrder(taskPairs,numTaskPairs,numTasks,pairs,param.numProxies,counts,io->taskPairs);
+
+		taskManager->deallocate(taskPairs);
+
+		result.pairs = pairs;
+		result.numPairs = numPairs;
+	}
+
+	pool.deallocate(counts);
+	pool.deallocate(io->taskPairs);
+	taskManager->deallocate(numTaskPairs);
+	taskManager->deallocate(io);
+
+	SCE_PFX_POP_MARKER();
+
+	return ret;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
@@ -23,6 +23,18 @@ Physics Effects under the filename: physics_effects_license.txt
 namespace sce {
 namespace PhysicsEffects {
 
+//J 軸を切り替える分散の比率
+//E Ratio of the variances to switch the axis
+#define SCE_PFX_SWITCH_AXIS_RATIO 1.5
+
+//J 挿入ソートでプロキシ1つあたりに許す移動回数
+//E Moves allowed per proxy in the insertion sort
+#define SCE_PFX_MAX_INSERTION_MOVES 8
+
+//J この数以下のペアのバケットは挿入ソートで並べる
+//E Buckets with up to this number of pairs are sorted with the insertion sort
+#define SCE_PFX_MAX_INSERTION_PAIRS 32
+
 PfxUInt32 pfxGetWorkBytesOfUpdateBroadphaseProxies(PfxUInt32 numRigidBodies)
 {
 	return 128 + SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxBroadphaseProxy) * numRigidBodies);
@@ -34,9 +46,15 @@ PfxUInt32 pfxGetWorkBytesOfUpdateBroadphaseProxies(PfxUInt32 numRigidBodies,PfxU
 	return 128 + SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxBroadphaseProxy) * numRigidBodies) * 6;
 }
 
-PfxUInt32 pfxGetWorkBytesOfFindPairs(PfxUInt32 maxPairs,PfxUInt32 maxTasks)
+PfxUInt32 pfxGetWorkBytesOfUpdateSortedBroadphaseProxies(PfxUInt32 numRigidBodies)
 {
-	return 128 + SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxBroadphasePair) * maxPairs) * maxTasks;
+	return 128 + SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxBroadphaseProxy) * numRigidBodies);
+}
+
+PfxUInt32 pfxGetWorkBytesOfFindPairs(PfxUInt32 numProxies,PfxUInt32 maxPairs,PfxUInt32 maxTasks)
+{
+	return 128 + SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxBroadphasePair) * maxPairs) * maxTasks +
+		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxUInt32) * (numProxies+1));
 }
 
 PfxUInt32 pfxGetPairBytesOfFindPairs(PfxUInt32 maxPairs)
@@ -64,11 +82,19 @@ PfxInt32 pfxCheckParamOfUpdateBroadphaseProxies(const PfxUpdateBroadphaseProxies
 	return SCE_PFX_OK;
 }
 
+PfxInt32 pfxCheckParamOfUpdateSortedBroadphaseProxies(const PfxUpdateSortedBroadphaseProxiesParam &param)
+{
+	if(!param.workBuff || !param.proxies || !param.offsetRigidStates || !param.offsetCollidables || param.axis > 2) return SCE_PFX_ERR_INVALID_VALUE;
+	if(!SCE_PFX_PTR_IS_ALIGNED16(param.proxies)) return SCE_PFX_ERR_INVALID_ALIGN;
+	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(param.workBuff,param.workBytes) < pfxGetWorkBytesOfUpdateSortedBroadphaseProxies(param.numRigidBodies) ) return SCE_PFX_ERR_OUT_OF_BUFFER;
+	return SCE_PFX_OK;
+}
+
 PfxInt32 pfxCheckParamOfFindPairs(const PfxFindPairsParam &param,int maxTasks)
 {
 	if(!param.workBuff || !param.pairBuff || !param.proxies || param.axis > 2 || param.axis < 0) return SCE_PFX_ERR_INVALID_VALUE;
 	if(!SCE_PFX_PTR_IS_ALIGNED16(param.proxies) || !SCE_PFX_PTR_IS_ALIGNED16(param.pairBuff)) return SCE_PFX_ERR_INVALID_ALIGN;
-	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(param.workBuff,param.workBytes) < pfxGetWorkBytesOfFindPairs(param.maxPairs,maxTasks) ) return SCE_PFX_ERR_OUT_OF_BUFFER;
+	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(param.workBuff,param.workBytes) < pfxGetWorkBytesOfFindPairs(param.numProxies,param.maxPairs,maxTasks) ) return SCE_PFX_ERR_OUT_OF_BUFFER;
 	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(param.pairBuff,param.pairBytes) < pfxGetPairBytesOfFindPairs(param.maxPairs) ) return SCE_PFX_ERR_OUT_OF_BUFFER;
 	return SCE_PFX_OK;
 }
@@ -87,19 +113,11 @@ PfxInt32 pfxCheckParamOfDecomposePairs(const PfxDecomposePairsParam &param,int m
 	return SCE_PFX_OK;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// SINGLE THREAD
-
-PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUpdateBroadphaseProxiesResult &result)
+PfxInt32 pfxUpdateBroadphaseProxiesRange(PfxUpdateBroadphaseProxiesParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfUpdateBroadphaseProxies(param);
-	if(ret != SCE_PFX_OK) return ret;
-
-	SCE_PFX_PUSH_MARKER("pfxUpdateBroadphaseProxies")
+	PfxInt32 numOutOfWorldProxies = 0;
 
-	result.numOutOfWorldProxies = 0;
-
-	for(int i=0;i<(int)param.numRigidBodies;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		PfxInt32 chk = pfxUpdateBroadphaseProxy(
 			param.proxiesX[i],
 			param.proxiesY[i],
@@ -112,8 +130,8 @@ PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUp
 			param.worldCenter,
 			param.worldExtent);
 
-		if(chk == SCE_PFX_ERR_OUT_OF_WORLD) {
-			result.numOutOfWorldProxies++;
+		if(chk == (PfxInt32)SCE_PFX_ERR_OUT_OF_WORLD) {
+			numOutOfWorldProxies++;
 
 			if(param.outOfWorldBehavior & SCE_PFX_OUT_OF_WORLD_BEHAVIOR_FIX_MOTION) {
 				PfxRigidState &state = param.offsetRigidStates[i];
@@ -136,44 +154,120 @@ PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUp
 			}
 		}
 	}
-	
-	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
-	PfxBroadphaseProxy *workProxies = (PfxBroadphaseProxy*)pool.allocate(sizeof(PfxBroadphaseProxy)*param.numRigidBodies,PfxHeapManager::ALIGN128);
-	
-	pfxSort(param.proxiesX,workProxies,param.numRigidBodies);
-	pfxSort(param.proxiesY,workProxies,param.numRigidBodies);
-	pfxSort(param.proxiesZ,workProxies,param.numRigidBodies);
-	pfxSort(param.proxiesXb,workProxies,param.numRigidBodies);
-	pfxSort(param.proxiesYb,workProxies,param.numRigidBodies);
-	pfxSort(param.proxiesZb,workProxies,param.numRigidBodies);
-	
-	pool.deallocate(workProxies);
 
-	SCE_PFX_POP_MARKER();
+	return numOutOfWorldProxies;
+}
 
-	return SCE_PFX_OK;
+PfxInt32 pfxUpdateSortedBroadphaseProxiesRange(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUInt32 start,PfxUInt32 num)
+{
+	PfxInt32 numOutOfWorldProxies = 0;
+
+	//J 作り直すときはi番目のプロキシをi番目の剛体から作成し、X軸のキーを設定しておく
+	//E When creating the proxies from scratch, the i-th proxy is created from the i-th rigid body with the key of the X axis
+	PfxUInt32 axis = param.axis < 0 ? 0 : param.axis;
+
+	for(PfxUInt32 i=start;i<start+num;i++) {
+		PfxBroadphaseProxy &proxy = param.proxies[i];
+		PfxUInt32 rigidBodyId = param.axis < 0 ? i : pfxGetObjectId(proxy);
+		PfxRigidState &state = param.offsetRigidStates[rigidBodyId];
+
+		PfxInt32 chk = pfxUpdateBroadphaseProxy(
+			proxy,
+			state,
+			param.offsetCollidables[rigidBodyId],
+			param.worldCenter,
+			param.worldExtent,
+			axis);
+
+		if(chk == (PfxInt32)SCE_PFX_ERR_OUT_OF_WORLD) {
+			numOutOfWorldProxies++;
+
+			if(param.outOfWorldBehavior & SCE_PFX_OUT_OF_WORLD_BEHAVIOR_FIX_MOTION) {
+				state.setMotionType(kPfxMotionTypeFixed);
+				pfxSetMotionMask(proxy,state.getMotionMask());
+			}
+			
+			if(param.outOfWorldBehavior & SCE_PFX_OUT_OF_WORLD_BEHAVIOR_REMOVE_PROXY) {
+				pfxSetKey(proxy,SCE_PFX_SENTINEL_KEY);
+			}
+		}
+	}
+
+	return numOutOfWorldProxies;
 }
 
-PfxInt32 pfxFindPairs(PfxFindPairsParam &param,PfxFindPairsResult &result)
+//J プロキシの中心の分散が最も大きい軸を選ぶ。今の軸より十分大きくなければ軸を変えない
+//E Choose the axis with the largest variance of the proxy centers, keep the current axis unless the variance is large enough
+static int pfxSelectBroadphaseAxis(const PfxBroadphaseProxy *proxies,PfxUInt32 numProxies,int currentAxis)
 {
-	PfxInt32 ret = pfxCheckParamOfFindPairs(param,0);
-	if(ret != SCE_PFX_OK) return ret;
+	double s[3] = {0.0,0.0,0.0};
+	double s2[3] = {0.0,0.0,0.0};
+	PfxUInt32 n = 0;
 
-	SCE_PFX_PUSH_MARKER("pfxFindPairs")
+	for(PfxUInt32 i=0;i<numProxies;i++) {
+		if(pfxGetKey(proxies[i]) == SCE_PFX_SENTINEL_KEY) continue;
+		for(int axis=0;axis<3;axis++) {
+			double c = (double)pfxGetXYZMin(proxies[i],axis) + (double)pfxGetXYZMax(proxies[i],axis);
+			s[axis] += c;
+			s2[axis] += c * c;
+		}
+		n++;
+	}
+
+	if(n == 0) return currentAxis < 0 ? 0 : currentAxis;
+
+	double v[3];
+	for(int axis=0;axis<3;axis++) {
+		v[axis] = s2[axis] - s[axis] * s[axis] / (double)n;
+	}
+
+	int bestAxis = 0;
+	if(v[1] > v[bestAxis]) bestAxis = 1;
+	if(v[2] > v[bestAxis]) bestAxis = 2;
+
+	if(currentAxis < 0 || v[bestAxis] > v[currentAxis] * SCE_PFX_SWITCH_AXIS_RATIO) return bestAxis;
+
+	return currentAxis;
+}
+
+void pfxSortUpdatedProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result)
+{
+	PfxBroadphaseProxy *proxies = param.proxies;
+	PfxUInt32 numProxies = param.numRigidBodies;
+
+	int keyAxis = param.axis < 0 ? 0 : param.axis;
+	int axis = pfxSelectBroadphaseAxis(proxies,numProxies,param.axis);
+
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+	PfxBroadphaseProxy *workProxies = (PfxBroadphaseProxy*)pool.allocate(sizeof(PfxBroadphaseProxy)*numProxies,PfxHeapManager::ALIGN128);
+
+	if(axis != keyAxis) {
+		for(PfxUInt32 i=0;i<numProxies;i++) {
+			if(pfxGetKey(proxies[i]) != SCE_PFX_SENTINEL_KEY) {
+				pfxSetKey(proxies[i],pfxGetXYZMin(proxies[i],axis));
+			}
+		}
+	}
+
+	//J 前のフレームと同じ軸ならほぼ整列済みなので挿入ソートで並べ直す
+	//E The proxies are nearly sorted when the axis is the same as the previous frame, so the insertion sort is used
+	if(param.axis < 0 || axis != param.axis ||
+		!pfxInsertionSort(proxies,numProxies,numProxies*SCE_PFX_MAX_INSERTION_MOVES)) {
+		pfxSort(proxies,workProxies,numProxies);
+	}
+
+	pool.deallocate(workProxies);
+
+	result.axis = axis;
+}
 
-	void *workBuff = param.workBuff;
-	PfxUInt32 workBytes = param.workBytes;
+PfxInt32 pfxFindPairsRange(const PfxFindPairsParam &param,PfxUInt32 start,PfxUInt32 num,PfxBroadphasePair *pairs,PfxUInt32 &numPairs,PfxUInt32 maxPairs)
+{
 	PfxBroadphaseProxy *proxies = param.proxies;
 	PfxUInt32 numProxies = param.numProxies;
-	PfxUInt32 maxPairs = param.maxPairs;
 	int axis = param.axis;
 
-	(void) workBytes;
-
-	PfxBroadphasePair *pairs = (PfxBroadphasePair*)SCE_PFX_PTR_ALIGN16(param.pairBuff);
-	PfxUInt32 numPairs = 0;
-	
-	for(PfxUInt32 i=0;i<numProxies;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		for(PfxUInt32 j=i+1;j<numProxies;j++) {
 			PfxBroadphaseProxy proxyA,proxyB;
 			if(pfxGetObjectId(proxies[i]) < pfxGetObjectId(proxies[j])) {
@@ -204,17 +298,149 @@ PfxInt32 pfxFindPairs(PfxFindPairsParam &param,PfxFindPairsResult &result)
 			}
 		}
 	}
+
+	return SCE_PFX_OK;
+}
+
+//J 各バッファのペアをキーの上位（大きい方のオブジェクトID）毎のバケットに振り分け、
+//J バケット内を並べてキーの順に出力する。countsはnumProxies+1個、workPairsは全ペアが入る大きさが必要
+//E Scatter the pairs of all buffers into buckets by the upper half of the keys (the larger object id)
+//E and sort each bucket to output the pairs in the key order. counts needs numProxies+1 elements and workPairs needs to hold all pairs
+void pfxGatherPairsInKeyOrder(
+	PfxBroadphasePair **srcPairs,const PfxUInt32 *numSrcPairs,PfxUInt32 numSrcs,
+	PfxBroadphasePair *pairs,PfxUInt32 numProxies,
+	PfxUInt32 *counts,PfxBroadphasePair *workPairs)
+{
+	memset(counts,0,sizeof(PfxUInt32)*(numProxies+1));
+
+	PfxUInt32 numPairs = 0;
+	PfxBool inRange = true;
+
+	for(PfxUInt32 s=0;s<numSrcs;s++) {
+		for(PfxUInt32 i=0;i<numSrcPairs[s];i++) {
+			PfxUInt32 bucket = SCE_PFX_MAX(pfxGetObjectIdA(srcPairs[s][i]),pfxGetObjectIdB(srcPairs[s][i]));
+			if(bucket >= numProxies) {
+				inRange = false;
+				break;
+			}
+			counts[bucket+1]++;
+		}
+		numPairs += numSrcPairs[s];
+	}
+
+	//J オブジェクトIDが範囲外のときは全体をソートする
+	//E Sort all pairs when an object id is out of range
+	if(!inRange) {
+		PfxUInt32 n = 0;
+		for(PfxUInt32 s=0;s<numSrcs;s++) {
+			memcpy(pairs+n,srcPairs[s],sizeof(PfxBroadphasePair)*numSrcPairs[s]);
+			n += numSrcPairs[s];
+		}
+		pfxSort(pairs,workPairs,numPairs);
+		return;
+	}
+
+	for(PfxUInt32 b=0;b<numProxies;b++) {
+		counts[b+1] += counts[b];
+	}
+
+	for(PfxUInt32 s=0;s<numSrcs;s++) {
+		for(PfxUInt32 i=0;i<numSrcPairs[s];i++) {
+			PfxUInt32 bucket = SCE_PFX_MAX(pfxGetObjectIdA(srcPairs[s][i]),pfxGetObjectIdB(srcPairs[s][i]));
+			pairs[counts[bucket]++] = srcPairs[s][i];
+		}
+	}
+
+	PfxUInt32 start = 0;
+	for(PfxUInt32 b=0;b<numProxies;b++) {
+		PfxUInt32 n = counts[b] - start;
+		if(n > SCE_PFX_MAX_INSERTION_PAIRS) {
+			pfxSort(pairs+start,workPairs,n);
+		}
+		else if(n > 1) {
+			pfxInsertionSort(pairs+start,n,0xffffffff);
+		}
+		start = counts[b];
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SINGLE THREAD
+
+PfxInt32 pfxUpdateBroadphaseProxies(PfxUpdateBroadphaseProxiesParam &param,PfxUpdateBroadphaseProxiesResult &result)
+{
+	PfxInt32 ret = pfxCheckParamOfUpdateBroadphaseProxies(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxUpdateBroadphaseProxies")
+
+	result.numOutOfWorldProxies = pfxUpdateBroadphaseProxiesRange(param,0,param.numRigidBodies);
 	
-	pfxSort(pairs,(PfxBroadphasePair*)workBuff,numPairs);
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+	PfxBroadphaseProxy *workProxies = (PfxBroadphaseProxy*)pool.allocate(sizeof(PfxBroadphaseProxy)*param.numRigidBodies,PfxHeapManager::ALIGN128);
+	
+	pfxSort(param.proxiesX,workProxies,param.numRigidBodies);
+	pfxSort(param.proxiesY,workProxies,param.numRigidBodies);
+	pfxSort(param.proxiesZ,workProxies,param.numRigidBodies);
+	pfxSort(param.proxiesXb,workProxies,param.numRigidBodies);
+	pfxSort(param.proxiesYb,workProxies,param.numRigidBodies);
+	pfxSort(param.proxiesZb,workProxies,param.numRigidBodies);
 	
-	result.pairs = pairs;
-	result.numPairs = numPairs;
+	pool.deallocate(workProxies);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxUpdateSortedBroadphaseProxies(PfxUpdateSortedBroadphaseProxiesParam &param,PfxUpdateSortedBroadphaseProxiesResult &result)
+{
+	PfxInt32 ret = pfxCheckParamOfUpdateSortedBroadphaseProxies(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxUpdateSortedBroadphaseProxies")
+
+	result.numOutOfWorldProxies = pfxUpdateSortedBroadphaseProxiesRange(param,0,param.numRigidBodies);
+
+	pfxSortUpdatedProxies(param,result);
 
 	SCE_PFX_POP_MARKER();
 
 	return SCE_PFX_OK;
 }
 
+PfxInt32 pfxFindPairs(PfxFindPairsParam &param,PfxFindPairsResult &result)
+{
+	PfxInt32 ret = pfxCheckParamOfFindPairs(param,1);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxFindPairs")
+
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+	PfxBroadphasePair *workPairs = (PfxBroadphasePair*)pool.allocate(sizeof(PfxBroadphasePair)*param.maxPairs,PfxHeapManager::ALIGN128);
+	PfxUInt32 *counts = (PfxUInt32*)pool.allocate(sizeof(PfxUInt32)*(param.numProxies+1));
+
+	PfxUInt32 numWorkPairs = 0;
+
+	ret = pfxFindPairsRange(param,0,param.numProxies,workPairs,numWorkPairs,param.maxPairs);
+
+	if(ret == SCE_PFX_OK) {
+		PfxBroadphasePair *pairs = (PfxBroadphasePair*)SCE_PFX_PTR_ALIGN16(param.pairBuff);
+
+		pfxGatherPairsInKeyOrder(&workPairs,&numWorkPairs,1,pairs,param.numProxies,counts,workPairs);
+
+		result.pairs = pairs;
+		result.numPairs = numWorkPairs;
+	}
+
+	pool.deallocate(counts);
+	pool.deallocate(workPairs);
+
+	SCE_PFX_POP_MARKER();
+
+	return ret;
+}
+
 PfxInt32 pfxDecomposePairs(PfxDecomposePairsParam &param,PfxDecomposePairsResult &result)
 {
 	PfxInt32 ret = pfxCheckParamOfDecomposePairs(param,0);
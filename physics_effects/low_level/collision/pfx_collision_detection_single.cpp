@@ -34,27 +34,16 @@ int pfxCheckParamOfDetectCollision(PfxDetectCollisionParam &param)
 	return SCE_PFX_OK;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// SINGLE THREAD
-
 #define SCE_PFX_CONTACT_THRESHOLD 0.0f
 
-PfxInt32 pfxDetectCollision(PfxDetectCollisionParam &param)
+void pfxDetectCollisionRange(PfxDetectCollisionParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfDetectCollision(param);
-	if(ret != SCE_PFX_OK) 
-		return ret;
-
-	SCE_PFX_PUSH_MARKER("pfxDetectCollision");
-
 	PfxConstraintPair *contactPairs = param.contactPairs;
-	PfxUInt32 numContactPairs = param.numContactPairs;
 	PfxContactManifold *offsetContactManifolds = param.offsetContactManifolds;
 	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
 	PfxCollidable *offsetCollidables = param.offsetCollidables;
-	PfxUInt32 numRigidBodies = param.numRigidBodies;
 
-	for(PfxUInt32 i=0;i<numContactPairs;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		const PfxBroadphasePair &pair = contactPairs[i];
 		if(!pfxCheckCollidableInCollision(pair)) {
 			continue;
@@ -113,10 +102,22 @@ PfxInt32 pfxDetectCollision(PfxDetectCollisionParam &param)
 				);
 		}
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SINGLE THREAD
+
+PfxInt32 pfxDetectCollision(PfxDetectCollisionParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfDetectCollision(param);
+	if(ret != SCE_PFX_OK) 
+		return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxDetectCollision");
+
+	pfxDetectCollisionRange(param,0,param.numContactPairs);
 
 	SCE_PFX_POP_MARKER();
-	
-	(void) numRigidBodies;
 
 	return SCE_PFX_OK;
 }
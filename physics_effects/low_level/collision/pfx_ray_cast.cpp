@@ -57,7 +57,7 @@ void pfxRayTraverseForward(
 			continue;
 		}
 
-		PfxUInt16 rigidbodyId = pfxGetObjectId(proxy);
+		PfxObjectId rigidbodyId = pfxGetObjectId(proxy);
 		PfxUInt32 contactFilterSelf = pfxGetSelf(proxy);
 		PfxUInt32 contactFilterTarget = pfxGetTarget(proxy);
 
@@ -125,7 +125,7 @@ void pfxRayTraverseBackward(
 			continue;
 		}
 		
-		PfxUInt16 rigidbodyId = pfxGetObjectId(proxy);
+		PfxObjectId rigidbodyId = pfxGetObjectId(proxy);
 		PfxUInt32 contactFilterSelf = pfxGetSelf(proxy);
 		PfxUInt32 contactFilterTarget = pfxGetTarget(proxy);
 		
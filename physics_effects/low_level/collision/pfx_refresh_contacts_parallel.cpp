@@ -0,0 +1,78 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "base_level/base/pfx_perf_counter.h"
+#include "low_level/collision/pfx_refresh_contacts.h"
+
+namespace sce {
+namespace PhysicsEffects {
+
+extern int pfxCheckParamOfRefreshContacts(PfxRefreshContactsParam &param);
+extern void pfxRefreshContactsRange(PfxRefreshContactsParam &param,PfxUInt32 start,PfxUInt32 num);
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI THREADS
+
+#define SCE_PFX_REFRESH_CONTACTS_BATCH 64
+
+void pfxRefreshContactsTaskEntry(PfxTaskArg *arg)
+{
+	PfxRefreshContactsParam &param = *((PfxRefreshContactsParam*)arg->io);
+	PfxUInt32 batch = arg->data[0];
+
+	for(;;) {
+		arg->criticalSection->lock();
+		PfxUInt32 start = arg->criticalSection->getSharedParam(0);
+		arg->criticalSection->setSharedParam(0,start+batch);
+		arg->criticalSection->unlock();
+
+		if(start >= param.numContactPairs) break;
+
+		pfxRefreshContactsRange(param,start,SCE_PFX_MIN(batch,param.numContactPairs-start));
+	}
+}
+
+PfxInt32 pfxRefreshContacts(PfxRefreshContactsParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxRefreshContacts(param);
+
+	PfxInt32 ret = pfxCheckParamOfRefreshContacts(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxRefreshContacts");
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	taskManager->setTaskEntry((void*)pfxRefreshContactsTaskEntry);
+	taskManager->setSharedParam(0,0);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		taskManager->startTask(t,&param,SCE_PFX_REFRESH_CONTACTS_BATCH,0,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
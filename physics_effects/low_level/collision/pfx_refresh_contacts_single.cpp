@@ -29,23 +29,13 @@ int pfxCheckParamOfRefreshContacts(PfxRefreshContactsParam &param)
 	return SCE_PFX_OK;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// SINGLE THREAD
-
-PfxInt32 pfxRefreshContacts(PfxRefreshContactsParam &param)
+void pfxRefreshContactsRange(PfxRefreshContactsParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfRefreshContacts(param);
-	if(ret != SCE_PFX_OK) return ret;
-	
-	SCE_PFX_PUSH_MARKER("pfxRefreshContacts");
-
 	PfxConstraintPair *contactPairs = param.contactPairs;
-	PfxUInt32 numContactPairs = param.numContactPairs;
 	PfxContactManifold *offsetContactManifolds = param.offsetContactManifolds;
 	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
-	PfxUInt32 numRigidBodies = param.numRigidBodies;
 	
-	for(PfxUInt32 i=0;i<numContactPairs;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		PfxBroadphasePair &pair = contactPairs[i];
 		
 		PfxUInt32 iContact = pfxGetContactId(pair);
@@ -64,10 +54,21 @@ PfxInt32 pfxRefreshContacts(PfxRefreshContactsParam &param)
 			instA.getPosition(),instA.getOrientation(),
 			instB.getPosition(),instB.getOrientation() );
 	}
+}
 
-	SCE_PFX_POP_MARKER();
+///////////////////////////////////////////////////////////////////////////////
+// SINGLE THREAD
 
-	(void) numRigidBodies;
+PfxInt32 pfxRefreshContacts(PfxRefreshContactsParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfRefreshContacts(param);
+	if(ret != SCE_PFX_OK) return ret;
+	
+	SCE_PFX_PUSH_MARKER("pfxRefreshContacts");
+
+	pfxRefreshContactsRange(param,0,param.numContactPairs);
+
+	SCE_PFX_POP_MARKER();
 
 	return SCE_PFX_OK;
 }
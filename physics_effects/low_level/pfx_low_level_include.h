@@ -37,5 +37,7 @@ Physics Effects under the filename: physics_effects_license.txt
 
 #include "sort/pfx_parallel_sort.h"
 
+#include "task/pfx_task_manager_pthreads.h"
+
 
 #endif // _SCE_PFX_LOW_LEVEL_INCLUDE_H
@@ -0,0 +1,343 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "base_level/base/pfx_perf_counter.h"
+#include "base_level/solver/pfx_check_solver.h"
+#include "low_level/solver/pfx_constraint_solver.h"
+#include "pfx_parallel_group.h"
+
+namespace sce {
+namespace PhysicsEffects {
+
+extern PfxInt32 pfxCheckParamOfSetupSolverBodies(const PfxSetupSolverBodiesParam &param);
+extern PfxInt32 pfxCheckParamOfSetupContactConstraints(const PfxSetupContactConstraintsParam &param);
+extern PfxInt32 pfxCheckParamOfSetupJointConstraints(const PfxSetupJointConstraintsParam &param);
+extern PfxInt32 pfxCheckParamOfSolveConstraints(const PfxSolveConstraintsParam &param);
+
+extern void pfxSetupSolverBodiesRange(PfxSetupSolverBodiesParam &param,PfxUInt32 start,PfxUInt32 num);
+extern void pfxSetupContactConstraintsRange(PfxSetupContactConstraintsParam &param,PfxUInt32 start,PfxUInt32 num);
+extern void pfxSetupJointConstraintsRange(PfxSetupJointConstraintsParam &param,PfxUInt32 start,PfxUInt32 num);
+extern void pfxWarmStartJointPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair);
+extern void pfxWarmStartContactPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair);
+extern void pfxSolveJointPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair);
+extern void pfxSolveContactPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair);
+extern void pfxApplySolverBodiesRange(PfxSolveConstraintsParam &param,PfxUInt32 start,PfxUInt32 num);
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI THREADS
+
+//J 要素を均等に分割して各タスクで処理する
+//E Split the elements evenly and process a part on each task
+static void pfxRunTasks(PfxTaskManager *taskManager,void *taskEntry,void *io,PfxUInt32 numElements)
+{
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	taskManager->setTaskEntry(taskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		PfxUInt32 start = numElements * t / numTasks;
+		PfxUInt32 end = numElements * (t+1) / numTasks;
+		taskManager->startTask(t,io,start,end-start,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+}
+
+void pfxSetupSolverBodiesTaskEntry(PfxTaskArg *arg)
+{
+	PfxSetupSolverBodiesParam &param = *((PfxSetupSolverBodiesParam*)arg->io);
+	pfxSetupSolverBodiesRange(param,arg->data[0],arg->data[1]);
+}
+
+void pfxSetupContactConstraintsTaskEntry(PfxTaskArg *arg)
+{
+	PfxSetupContactConstraintsParam &param = *((PfxSetupContactConstraintsParam*)arg->io);
+	pfxSetupContactConstraintsRange(param,arg->data[0],arg->data[1]);
+}
+
+void pfxSetupJointConstraintsTaskEntry(PfxTaskArg *arg)
+{
+	PfxSetupJointConstraintsParam &param = *((PfxSetupJointConstraintsParam*)arg->io);
+	pfxSetupJointConstraintsRange(param,arg->data[0],arg->data[1]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Split Pairs
+
+//J 剛体を共有しないペアをバッチにまとめ、同時に処理できるバッチをフェーズにまとめる
+//J 分割はペアの並び順だけで決まるので、タスク数によらず同じ結果になる
+//J 全フェーズを使い切っても割り当てられなかったペアはpairTableのビットが0のまま残る
+//E Gather pairs that share no rigid bodies into batches and batches that can be solved at the same time into phases
+//E The split only depends on the order of the pairs, so it gives the same result for any number of tasks
+//E Pairs that don't fit into the phases are left with a cleared bit in pairTable
+static PfxUInt32 pfxSplitPairs(
+	PfxConstraintPair *pairs,PfxUInt32 numPairs,
+	PfxParallelGroup &group,PfxParallelBatch *batches,
+	PfxUInt8 *bodyTable,PfxUInt32 numRigidBodies,
+	PfxUInt32 *pairTable)
+{
+	memset(pairTable,0,sizeof(PfxUInt32)*((numPairs+31)/32));
+
+	PfxUInt32 targetCount = SCE_PFX_MAX(SCE_PFX_MIN_SOLVER_PAIRS,SCE_PFX_MIN(numPairs/SCE_PFX_MAX_SOLVER_BATCHES,SCE_PFX_MAX_SOLVER_PAIRS));
+	PfxUInt32 startIndex = 0;
+	PfxUInt32 totalCount = 0;
+	PfxUInt32 phaseId;
+
+	for(phaseId=0;phaseId<SCE_PFX_MAX_SOLVER_PHASES&&totalCount<numPairs;phaseId++) {
+		PfxBool startIndexCheck = true;
+		PfxUInt32 batchId;
+		PfxUInt32 i = startIndex;
+
+		memset(bodyTable,0xff,numRigidBodies);
+
+		for(batchId=0;i<numPairs&&totalCount<numPairs&&batchId<SCE_PFX_MAX_SOLVER_BATCHES;batchId++) {
+			PfxParallelBatch &batch = batches[phaseId*SCE_PFX_MAX_SOLVER_BATCHES+batchId];
+			PfxUInt32 pairCount = 0;
+
+			for(;i<numPairs&&pairCount<targetCount;i++) {
+				PfxUInt32 idxP = i>>5;
+				PfxUInt32 maskP = 1<<(i&31);
+
+				//J 割り当て済み
+				//E Already assigned
+				if(pairTable[idxP] & maskP) {
+					if(startIndexCheck) startIndex++;
+					continue;
+				}
+
+				//J ソルバーで処理しないペアは割り当て済みにして飛ばす
+				//E Pairs that are not solved are marked as assigned and skipped
+				if(!pfxCheckSolver(pairs[i])) {
+					if(startIndexCheck) startIndex++;
+					pairTable[idxP] |= maskP;
+					totalCount++;
+					continue;
+				}
+
+				//J 同じフェーズの別のバッチで使われている剛体を含むペアは次のフェーズに回す
+				//E Pairs with a rigid body used by another batch of this phase are left to the next phase
+				PfxUInt32 idxA = pfxGetObjectIdA(pairs[i]);
+				PfxUInt32 idxB = pfxGetObjectIdB(pairs[i]);
+				if( (bodyTable[idxA] != batchId && bodyTable[idxA] != 0xff) ||
+					(bodyTable[idxB] != batchId && bodyTable[idxB] != 0xff) ) {
+					startIndexCheck = false;
+					continue;
+				}
+
+				//J 速度を書き換える剛体だけを登録する
+				//E Only register the rigid bodies whose velocities are written
+				if(SCE_PFX_MOTION_MASK_DYNAMIC(pfxGetMotionMaskA(pairs[i])&SCE_PFX_MOTION_MASK_TYPE)) bodyTable[idxA] = batchId;
+				if(SCE_PFX_MOTION_MASK_DYNAMIC(pfxGetMotionMaskB(pairs[i])&SCE_PFX_MOTION_MASK_TYPE)) bodyTable[idxB] = batchId;
+
+				if(startIndexCheck) startIndex++;
+				pairTable[idxP] |= maskP;
+				batch.pairIndices[pairCount++] = i;
+			}
+
+			group.numPairs[phaseId*SCE_PFX_MAX_SOLVER_BATCHES+batchId] = (PfxUInt16)pairCount;
+			totalCount += pairCount;
+		}
+
+		group.numBatches[phaseId] = (PfxUInt16)batchId;
+	}
+
+	group.numPhases = (PfxUInt16)phaseId;
+
+	return numPairs - totalCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Solve Constraints
+
+struct PfxSolveConstraintsIO {
+	PfxSolveConstraintsParam *param;
+	PfxParallelGroup *contactGroup;
+	PfxParallelBatch *contactBatches;
+	PfxUInt32 *contactPairTable;
+	PfxUInt32 numContactRemains;
+	PfxParallelGroup *jointGroup;
+	PfxParallelBatch *jointBatches;
+	PfxUInt32 *jointPairTable;
+	PfxUInt32 numJointRemains;
+};
+
+typedef void (*PfxSolvePairFunc)(PfxSolveConstraintsParam &param,PfxConstraintPair &pair);
+
+//J フェーズ内のバッチを各タスクで処理し、フェーズ毎に同期する
+//J バッチの割り当てはタスクIDで決まるので結果は常に同じになる
+//E Solve the batches of a phase on all tasks and synchronize after each phase
+//E Batches are assigned by the task id, so the results are always the same
+static void pfxSolveGroup(PfxTaskArg *arg,PfxSolveConstraintsParam &param,
+	PfxConstraintPair *pairs,PfxUInt32 numPairs,
+	const PfxParallelGroup &group,const PfxParallelBatch *batches,
+	const PfxUInt32 *pairTable,PfxUInt32 numRemains,
+	PfxSolvePairFunc func)
+{
+	for(PfxUInt32 phaseId=0;phaseId<group.numPhases;phaseId++) {
+		for(PfxUInt32 batchId=arg->taskId;batchId<group.numBatches[phaseId];batchId+=arg->maxTasks) {
+			const PfxParallelBatch &batch = batches[phaseId*SCE_PFX_MAX_SOLVER_BATCHES+batchId];
+			PfxUInt32 numBatchPairs = group.numPairs[phaseId*SCE_PFX_MAX_SOLVER_BATCHES+batchId];
+			for(PfxUInt32 i=0;i<numBatchPairs;i++) {
+				func(param,pairs[batch.pairIndices[i]]);
+			}
+		}
+		arg->barrier->sync();
+	}
+
+	//J フェーズに入りきらなかったペアはタスク0で順番に処理する
+	//E Pairs that didn't fit into the phases are solved in order on task 0
+	if(numRemains > 0) {
+		if(arg->taskId == 0) {
+			for(PfxUInt32 i=0;i<numPairs;i++) {
+				if(!(pairTable[i>>5] & (1<<(i&31)))) {
+					func(param,pairs[i]);
+				}
+			}
+		}
+		arg->barrier->sync();
+	}
+}
+
+void pfxSolveConstraintsTaskEntry(PfxTaskArg *arg)
+{
+	PfxSolveConstraintsIO &io = *((PfxSolveConstraintsIO*)arg->io);
+	PfxSolveConstraintsParam &param = *io.param;
+
+	// Warm Starting
+	pfxSolveGroup(arg,param,param.jointPairs,param.numJointPairs,
+		*io.jointGroup,io.jointBatches,io.jointPairTable,io.numJointRemains,pfxWarmStartJointPair);
+	pfxSolveGroup(arg,param,param.contactPairs,param.numContactPairs,
+		*io.contactGroup,io.contactBatches,io.contactPairTable,io.numContactRemains,pfxWarmStartContactPair);
+
+	// Solver
+	for(PfxUInt32 iteration=0;iteration<param.iteration;iteration++) {
+		pfxSolveGroup(arg,param,param.jointPairs,param.numJointPairs,
+			*io.jointGroup,io.jointBatches,io.jointPairTable,io.numJointRemains,pfxSolveJointPair);
+		pfxSolveGroup(arg,param,param.contactPairs,param.numContactPairs,
+			*io.contactGroup,io.contactBatches,io.contactPairTable,io.numContactRemains,pfxSolveContactPair);
+	}
+
+	//J 速度の書き戻し
+	//E Write back the velocities
+	PfxUInt32 start = param.numRigidBodies * arg->taskId / arg->maxTasks;
+	PfxUInt32 end = param.numRigidBodies * (arg->taskId+1) / arg->maxTasks;
+	pfxApplySolverBodiesRange(param,start,end-start);
+}
+
+PfxInt32 pfxSetupSolverBodies(PfxSetupSolverBodiesParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxSetupSolverBodies(param);
+
+	PfxInt32 ret = pfxCheckParamOfSetupSolverBodies(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxSetupSolverBodies");
+
+	pfxRunTasks(taskManager,(void*)pfxSetupSolverBodiesTaskEntry,&param,param.numRigidBodies);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSetupContactConstraints(PfxSetupContactConstraintsParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxSetupContactConstraints(param);
+
+	PfxInt32 ret = pfxCheckParamOfSetupContactConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxSetupContactConstraints");
+
+	pfxRunTasks(taskManager,(void*)pfxSetupContactConstraintsTaskEntry,&param,param.numContactPairs);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSetupJointConstraints(PfxSetupJointConstraintsParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxSetupJointConstraints(param);
+
+	PfxInt32 ret = pfxCheckParamOfSetupJointConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxSetupJointConstraints");
+
+	pfxRunTasks(taskManager,(void*)pfxSetupJointConstraintsTaskEntry,&param,param.numJointPairs);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSolveConstraints(PfxSolveConstraintsParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxSolveConstraints(param);
+
+	PfxInt32 ret = pfxCheckParamOfSolveConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxSolveConstraints");
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	PfxHeapManager pool((unsigned char*)param.workBuff,param.workBytes);
+
+	PfxSolveConstraintsIO *io = (PfxSolveConstraintsIO*)taskManager->allocate(sizeof(PfxSolveConstraintsIO));
+	io->param = &param;
+
+	PfxUInt8 *bodyTable = (PfxUInt8*)pool.allocate(sizeof(PfxUInt8)*param.numRigidBodies);
+	io->contactPairTable = (PfxUInt32*)pool.allocate(sizeof(PfxUInt32)*((param.numContactPairs+31)/32));
+	io->jointPairTable = (PfxUInt32*)pool.allocate(sizeof(PfxUInt32)*((param.numJointPairs+31)/32));
+	io->contactGroup = (PfxParallelGroup*)pool.allocate(sizeof(PfxParallelGroup));
+	io->contactBatches = (PfxParallelBatch*)pool.allocate(sizeof(PfxParallelBatch)*(SCE_PFX_MAX_SOLVER_PHASES*SCE_PFX_MAX_SOLVER_BATCHES),PfxHeapManager::ALIGN128);
+	io->jointGroup = (PfxParallelGroup*)pool.allocate(sizeof(PfxParallelGroup));
+	io->jointBatches = (PfxParallelBatch*)pool.allocate(sizeof(PfxParallelBatch)*(SCE_PFX_MAX_SOLVER_PHASES*SCE_PFX_MAX_SOLVER_BATCHES),PfxHeapManager::ALIGN128);
+
+	//J ペアを剛体が重ならないバッチに分割
+	//E Split the pairs into batches that don't share rigid bodies
+	io->numJointRemains = pfxSplitPairs(param.jointPairs,param.numJointPairs,
+		*io->jointGroup,io->jointBatches,bodyTable,param.numRigidBodies,io->jointPairTable);
+	io->numContactRemains = pfxSplitPairs(param.contactPairs,param.numContactPairs,
+		*io->contactGroup,io->contactBatches,bodyTable,param.numRigidBodies,io->contactPairTable);
+
+	taskManager->setTaskEntry((void*)pfxSolveConstraintsTaskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		taskManager->startTask(t,io,0,0,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+
+	taskManager->deallocate(io);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
@@ -28,7 +28,8 @@ PfxUInt32 pfxGetWorkBytesOfSolveConstraints(PfxUInt32 numRigidBodies,PfxUInt32 n
 {
 	(void)maxTasks;
 	PfxUInt32 workBytes = SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxUInt8) * numRigidBodies) +
-		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxUInt32)*((SCE_PFX_MAX(numContactPairs,numJointPairs)+31)/32));
+		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxUInt32)*((numContactPairs+31)/32)) +
+		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxUInt32)*((numJointPairs+31)/32));
 
 	workBytes += 128 + (SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxParallelGroup)) + 
 		 SCE_PFX_ALLOC_BYTES_ALIGN128(sizeof(PfxParallelBatch)*(SCE_PFX_MAX_SOLVER_PHASES*SCE_PFX_MAX_SOLVER_BATCHES))) * 2;
@@ -72,22 +73,13 @@ PfxInt32 pfxCheckParamOfSolveConstraints(const PfxSolveConstraintsParam &param)
 	return SCE_PFX_OK;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// SINGLE THREAD
-
-PfxInt32 pfxSetupSolverBodies(PfxSetupSolverBodiesParam &param)
+void pfxSetupSolverBodiesRange(PfxSetupSolverBodiesParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfSetupSolverBodies(param);
-	if(ret != SCE_PFX_OK) return ret;
-	
-	SCE_PFX_PUSH_MARKER("pfxSetupSolverBodies");
-
 	PfxRigidState *states = param.states;
 	PfxRigidBody *bodies = param.bodies;
 	PfxSolverBody *solverBodies = param.solverBodies;
-	PfxUInt32 numRigidBodies = param.numRigidBodies;
 	
-	for(PfxUInt32 i=0;i<numRigidBodies;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		PfxRigidState &state = states[i];
 		PfxRigidBody &body = bodies[i];
 		PfxSolverBody &solverBody = solverBodies[i];
@@ -107,34 +99,24 @@ PfxInt32 pfxSetupSolverBodies(PfxSetupSolverBodiesParam &param)
 			solverBody.m_inertiaInv = PfxMatrix3(0.0f);
 		}
 	}
-
-	SCE_PFX_POP_MARKER();
-
-	return SCE_PFX_OK;
 }
 
-PfxInt32 pfxSetupContactConstraints(PfxSetupContactConstraintsParam &param)
+void pfxSetupContactConstraintsRange(PfxSetupContactConstraintsParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfSetupContactConstraints(param);
-	if(ret != SCE_PFX_OK) return ret;
-	
-	SCE_PFX_PUSH_MARKER("pfxSetupContactConstraints");
-
 	PfxConstraintPair *contactPairs = param.contactPairs;
-	PfxUInt32 numContactPairs = param.numContactPairs;
 	PfxContactManifold *offsetContactManifolds = param.offsetContactManifolds;
 	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
 	PfxRigidBody *offsetRigidBodies = param.offsetRigidBodies;
 	PfxSolverBody *offsetSolverBodies = param.offsetSolverBodies;
 	
-	for(PfxUInt32 i=0;i<numContactPairs;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		PfxConstraintPair &pair = contactPairs[i];
 		if(!pfxCheckSolver(pair)) {
 			continue;
 		}
 
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
+		PfxUInt32 iA = pfxGetObjectIdA(pair);
+		PfxUInt32 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 
 		PfxContactManifold &contact = offsetContactManifolds[iConstraint];
@@ -181,33 +163,23 @@ PfxInt32 pfxSetupContactConstraints(PfxSetupContactConstraintsParam &param)
 
 		contact.setCompositeFriction(friction);
 	}
-
-	SCE_PFX_POP_MARKER();
-
-	return SCE_PFX_OK;
 }
 
-PfxInt32 pfxSetupJointConstraints(PfxSetupJointConstraintsParam &param)
+void pfxSetupJointConstraintsRange(PfxSetupJointConstraintsParam &param,PfxUInt32 start,PfxUInt32 num)
 {
-	PfxInt32 ret = pfxCheckParamOfSetupJointConstraints(param);
-	if(ret != SCE_PFX_OK) return ret;
-	
-	SCE_PFX_PUSH_MARKER("pfxSetupJointConstraints");
-
 	PfxConstraintPair *jointPairs = param.jointPairs;
-	PfxUInt32 numJointPairs = param.numJointPairs;
 	PfxJoint *offsetJoints = param.offsetJoints;
 	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
 	PfxSolverBody *offsetSolverBodies = param.offsetSolverBodies;
 	
-	for(PfxUInt32 i=0;i<numJointPairs;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		PfxConstraintPair &pair = jointPairs[i];
 		if(!pfxCheckSolver(pair)) {
 			continue;
 		}
 
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
+		PfxUInt32 iA = pfxGetObjectIdA(pair);
+		PfxUInt32 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 		
 		PfxJoint &joint = offsetJoints[iConstraint];
@@ -229,166 +201,231 @@ PfxInt32 pfxSetupJointConstraints(PfxSetupJointConstraintsParam &param)
 			solverBodyB,
 			param.timeStep);
 	}
+}
 
-	SCE_PFX_POP_MARKER();
+void pfxWarmStartJointPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair)
+{
+	if(!pfxCheckSolver(pair)) {
+		return;
+	}
 
-	return SCE_PFX_OK;
+	PfxUInt32 iA = pfxGetObjectIdA(pair);
+	PfxUInt32 iB = pfxGetObjectIdB(pair);
+
+	PfxJoint &joint = param.offsetJoints[pfxGetConstraintId(pair)];
+
+	SCE_PFX_ASSERT(iA==joint.m_rigidBodyIdA);
+	SCE_PFX_ASSERT(iB==joint.m_rigidBodyIdB);
+
+	PfxSolverBody &solverBodyA = param.offsetSolverBodies[iA];
+	PfxSolverBody &solverBodyB = param.offsetSolverBodies[iB];
+	
+	pfxGetWarmStartJointConstraintFunc(joint.m_type)(
+		joint,
+		solverBodyA,
+		solverBodyB);
 }
 
-PfxInt32 pfxSolveConstraints(PfxSolveConstraintsParam &param)
+void pfxWarmStartContactPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair)
 {
-	PfxInt32 ret = pfxCheckParamOfSolveConstraints(param);
-	if(ret != SCE_PFX_OK) return ret;
+	if(!pfxCheckSolver(pair)) {
+		return;
+	}
 
-	SCE_PFX_PUSH_MARKER("pfxSolveConstraints");
+	PfxUInt32 iA = pfxGetObjectIdA(pair);
+	PfxUInt32 iB = pfxGetObjectIdB(pair);
+
+	PfxContactManifold &contact = param.offsetContactManifolds[pfxGetConstraintId(pair)];
+
+	SCE_PFX_ASSERT(iA==contact.getRigidBodyIdA());
+	SCE_PFX_ASSERT(iB==contact.getRigidBodyIdB());
+
+	PfxSolverBody &solverBodyA = param.offsetSolverBodies[iA];
+	PfxSolverBody &solverBodyB = param.offsetSolverBodies[iB];
+	
+	PfxFloat massInvA = solverBodyA.m_massInv;
+	PfxFloat massInvB = solverBodyB.m_massInv;
+	PfxMatrix3 inertiaInvA = solverBodyA.m_inertiaInv;
+	PfxMatrix3 inertiaInvB = solverBodyB.m_inertiaInv;
+
+	if(solverBodyA.m_motionType == kPfxMotionTypeOneWay) {
+		massInvB = 0.0f;
+		inertiaInvB = PfxMatrix3(0.0f);
+	}
+	if(solverBodyB.m_motionType == kPfxMotionTypeOneWay) {
+		massInvA = 0.0f;
+		inertiaInvA = PfxMatrix3(0.0f);
+	}
+
+	for(int j=0;j<contact.getNumContacts();j++) {
+		PfxContactPoint &cp = contact.getContactPoint(j);
+		
+		PfxVector3 rA = rotate(solverBodyA.m_orientation,pfxReadVector3(cp.m_localPointA));
+		PfxVector3 rB = rotate(solverBodyB.m_orientation,pfxReadVector3(cp.m_localPointB));
+		
+		for(int k=0;k<3;k++) {
+			PfxVector3 normal = pfxReadVector3(cp.m_constraintRow[k].m_normal);
+			PfxFloat deltaImpulse = cp.m_constraintRow[k].m_accumImpulse;
+			solverBodyA.m_deltaLinearVelocity += deltaImpulse * massInvA * normal;
+			solverBodyA.m_deltaAngularVelocity += deltaImpulse * inertiaInvA * cross(rA,normal);
+			solverBodyB.m_deltaLinearVelocity -= deltaImpulse * massInvB * normal;
+			solverBodyB.m_deltaAngularVelocity -= deltaImpulse * inertiaInvB * cross(rB,normal);
+		}
+	}
+}
+
+void pfxSolveJointPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair)
+{
+	if(!pfxCheckSolver(pair)) {
+		return;
+	}
+
+	PfxUInt32 iA = pfxGetObjectIdA(pair);
+	PfxUInt32 iB = pfxGetObjectIdB(pair);
+
+	PfxJoint &joint = param.offsetJoints[pfxGetConstraintId(pair)];
 
+	SCE_PFX_ASSERT(iA==joint.m_rigidBodyIdA);
+	SCE_PFX_ASSERT(iB==joint.m_rigidBodyIdB);
+
+	PfxSolverBody &solverBodyA = param.offsetSolverBodies[iA];
+	PfxSolverBody &solverBodyB = param.offsetSolverBodies[iB];
+	
+	pfxGetSolveJointConstraintFunc(joint.m_type)(
+		joint,
+		solverBodyA,
+		solverBodyB);
+}
+
+void pfxSolveContactPair(PfxSolveConstraintsParam &param,PfxConstraintPair &pair)
+{
+	if(!pfxCheckSolver(pair)) {
+		return;
+	}
+
+	PfxUInt32 iA = pfxGetObjectIdA(pair);
+	PfxUInt32 iB = pfxGetObjectIdB(pair);
+
+	PfxContactManifold &contact = param.offsetContactManifolds[pfxGetConstraintId(pair)];
+
+	SCE_PFX_ASSERT(iA==contact.getRigidBodyIdA());
+	SCE_PFX_ASSERT(iB==contact.getRigidBodyIdB());
+
+	PfxSolverBody &solverBodyA = param.offsetSolverBodies[iA];
+	PfxSolverBody &solverBodyB = param.offsetSolverBodies[iB];
+	
+	for(int j=0;j<contact.getNumContacts();j++) {
+		PfxContactPoint &cp = contact.getContactPoint(j);
+		
+		pfxSolveContactConstraint(
+			cp.m_constraintRow[0],
+			cp.m_constraintRow[1],
+			cp.m_constraintRow[2],
+			pfxReadVector3(cp.m_localPointA),
+			pfxReadVector3(cp.m_localPointB),
+			solverBodyA,
+			solverBodyB,
+			contact.getCompositeFriction()
+			);
+	}
+}
+
+void pfxSolveConstraintsIterations(PfxSolveConstraintsParam &param)
+{
 	PfxConstraintPair *contactPairs = param.contactPairs;
 	PfxUInt32 numContactPairs = param.numContactPairs;
-	PfxContactManifold *offsetContactManifolds = param.offsetContactManifolds;
 	PfxConstraintPair *jointPairs = param.jointPairs;
 	PfxUInt32 numJointPairs = param.numJointPairs;
-	PfxJoint *offsetJoints = param.offsetJoints;
-	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
-	PfxSolverBody *offsetSolverBodies = param.offsetSolverBodies;
-	PfxUInt32 numRigidBodies = param.numRigidBodies;
 	
 	// Warm Starting
 	{
 		for(PfxUInt32 i=0;i<numJointPairs;i++) {
-			PfxConstraintPair &pair = jointPairs[i];
-			if(!pfxCheckSolver(pair)) {
-				continue;
-			}
-
-			PfxUInt16 iA = pfxGetObjectIdA(pair);
-			PfxUInt16 iB = pfxGetObjectIdB(pair);
-
-			PfxJoint &joint = offsetJoints[pfxGetConstraintId(pair)];
-
-			SCE_PFX_ASSERT(iA==joint.m_rigidBodyIdA);
-			SCE_PFX_ASSERT(iB==joint.m_rigidBodyIdB);
-
-			PfxSolverBody &solverBodyA = offsetSolverBodies[iA];
-			PfxSolverBody &solverBodyB = offsetSolverBodies[iB];
-			
-			pfxGetWarmStartJointConstraintFunc(joint.m_type)(
-				joint,
-				solverBodyA,
-				solverBodyB);
+			pfxWarmStartJointPair(param,jointPairs[i]);
 		}
 		for(PfxUInt32 i=0;i<numContactPairs;i++) {
-			PfxConstraintPair &pair = contactPairs[i];
-			if(!pfxCheckSolver(pair)) {
-				continue;
-			}
-
-			PfxUInt16 iA = pfxGetObjectIdA(pair);
-			PfxUInt16 iB = pfxGetObjectIdB(pair);
-
-			PfxContactManifold &contact = offsetContactManifolds[pfxGetConstraintId(pair)];
-
-			SCE_PFX_ASSERT(iA==contact.getRigidBodyIdA());
-			SCE_PFX_ASSERT(iB==contact.getRigidBodyIdB());
-
-			PfxSolverBody &solverBodyA = offsetSolverBodies[iA];
-			PfxSolverBody &solverBodyB = offsetSolverBodies[iB];
-			
-			PfxFloat massInvA = solverBodyA.m_massInv;
-			PfxFloat massInvB = solverBodyB.m_massInv;
-			PfxMatrix3 inertiaInvA = solverBodyA.m_inertiaInv;
-			PfxMatrix3 inertiaInvB = solverBodyB.m_inertiaInv;
-
-			if(solverBodyA.m_motionType == kPfxMotionTypeOneWay) {
-				massInvB = 0.0f;
-				inertiaInvB = PfxMatrix3(0.0f);
-			}
-			if(solverBodyB.m_motionType == kPfxMotionTypeOneWay) {
-				massInvA = 0.0f;
-				inertiaInvA = PfxMatrix3(0.0f);
-			}
-
-			for(int j=0;j<contact.getNumContacts();j++) {
-				PfxContactPoint &cp = contact.getContactPoint(j);
-				
-				PfxVector3 rA = rotate(solverBodyA.m_orientation,pfxReadVector3(cp.m_localPointA));
-				PfxVector3 rB = rotate(solverBodyB.m_orientation,pfxReadVector3(cp.m_localPointB));
-				
-				for(int k=0;k<3;k++) {
-					PfxVector3 normal = pfxReadVector3(cp.m_constraintRow[k].m_normal);
-					PfxFloat deltaImpulse = cp.m_constraintRow[k].m_accumImpulse;
-					solverBodyA.m_deltaLinearVelocity += deltaImpulse * massInvA * normal;
-					solverBodyA.m_deltaAngularVelocity += deltaImpulse * inertiaInvA * cross(rA,normal);
-					solverBodyB.m_deltaLinearVelocity -= deltaImpulse * massInvB * normal;
-					solverBodyB.m_deltaAngularVelocity -= deltaImpulse * inertiaInvB * cross(rB,normal);
-				}
-			}
+			pfxWarmStartContactPair(param,contactPairs[i]);
 		}
 	}
 	
 	// Solver
 	for(PfxUInt32 iteration=0;iteration<param.iteration;iteration++) {
 		for(PfxUInt32 i=0;i<numJointPairs;i++) {
-			PfxConstraintPair &pair = jointPairs[i];
-			if(!pfxCheckSolver(pair)) {
-				continue;
-			}
-
-			PfxUInt16 iA = pfxGetObjectIdA(pair);
-			PfxUInt16 iB = pfxGetObjectIdB(pair);
-
-			PfxJoint &joint = offsetJoints[pfxGetConstraintId(pair)];
-
-			SCE_PFX_ASSERT(iA==joint.m_rigidBodyIdA);
-			SCE_PFX_ASSERT(iB==joint.m_rigidBodyIdB);
-
-			PfxSolverBody &solverBodyA = offsetSolverBodies[iA];
-			PfxSolverBody &solverBodyB = offsetSolverBodies[iB];
-			
-			pfxGetSolveJointConstraintFunc(joint.m_type)(
-				joint,
-				solverBodyA,
-				solverBodyB);
+			pfxSolveJointPair(param,jointPairs[i]);
 		}
 		for(PfxUInt32 i=0;i<numContactPairs;i++) {
-			PfxConstraintPair &pair = contactPairs[i];
-			if(!pfxCheckSolver(pair)) {
-				continue;
-			}
-
-			PfxUInt16 iA = pfxGetObjectIdA(pair);
-			PfxUInt16 iB = pfxGetObjectIdB(pair);
-
-			PfxContactManifold &contact = offsetContactManifolds[pfxGetConstraintId(pair)];
-
-			SCE_PFX_ASSERT(iA==contact.getRigidBodyIdA());
-			SCE_PFX_ASSERT(iB==contact.getRigidBodyIdB());
-
-			PfxSolverBody &solverBodyA = offsetSolverBodies[iA];
-			PfxSolverBody &solverBodyB = offsetSolverBodies[iB];
-			
-			for(int j=0;j<contact.getNumContacts();j++) {
-				PfxContactPoint &cp = contact.getContactPoint(j);
-				
-				pfxSolveContactConstraint(
-					cp.m_constraintRow[0],
-					cp.m_constraintRow[1],
-					cp.m_constraintRow[2],
-					pfxReadVector3(cp.m_localPointA),
-					pfxReadVector3(cp.m_localPointB),
-					solverBodyA,
-					solverBodyB,
-					contact.getCompositeFriction()
-					);
-			}
+			pfxSolveContactPair(param,contactPairs[i]);
 		}
 	}
+}
+
+void pfxApplySolverBodiesRange(PfxSolveConstraintsParam &param,PfxUInt32 start,PfxUInt32 num)
+{
+	PfxRigidState *offsetRigidStates = param.offsetRigidStates;
+	PfxSolverBody *offsetSolverBodies = param.offsetSolverBodies;
 
-	for(PfxUInt32 i=0;i<numRigidBodies;i++) {
+	for(PfxUInt32 i=start;i<start+num;i++) {
 		offsetRigidStates[i].setLinearVelocity(
 			offsetRigidStates[i].getLinearVelocity()+offsetSolverBodies[i].m_deltaLinearVelocity);
 		offsetRigidStates[i].setAngularVelocity(
 			offsetRigidStates[i].getAngularVelocity()+offsetSolverBodies[i].m_deltaAngularVelocity);
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SINGLE THREAD
+
+PfxInt32 pfxSetupSolverBodies(PfxSetupSolverBodiesParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfSetupSolverBodies(param);
+	if(ret != SCE_PFX_OK) return ret;
+	
+	SCE_PFX_PUSH_MARKER("pfxSetupSolverBodies");
+
+	pfxSetupSolverBodiesRange(param,0,param.numRigidBodies);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSetupContactConstraints(PfxSetupContactConstraintsParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfSetupContactConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+	
+	SCE_PFX_PUSH_MARKER("pfxSetupContactConstraints");
+
+	pfxSetupContactConstraintsRange(param,0,param.numContactPairs);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSetupJointConstraints(PfxSetupJointConstraintsParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfSetupJointConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+	
+	SCE_PFX_PUSH_MARKER("pfxSetupJointConstraints");
+
+	pfxSetupJointConstraintsRange(param,0,param.numJointPairs);
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxSolveConstraints(PfxSolveConstraintsParam &param)
+{
+	PfxInt32 ret = pfxCheckParamOfSolveConstraints(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxSolveConstraints");
+
+	pfxSolveConstraintsIterations(param);
+
+	pfxApplySolverBodiesRange(param,0,param.numRigidBodies);
 
 	SCE_PFX_POP_MARKER();
 
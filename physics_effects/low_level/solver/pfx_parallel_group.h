@@ -29,7 +29,7 @@ namespace sce {
 namespace PhysicsEffects {
 
 struct SCE_PFX_ALIGNED(128) PfxParallelBatch {
-	PfxUInt16 pairIndices[SCE_PFX_MAX_SOLVER_PAIRS];
+	PfxUInt32 pairIndices[SCE_PFX_MAX_SOLVER_PAIRS];
 };
 
 struct SCE_PFX_ALIGNED(128) PfxParallelGroup {
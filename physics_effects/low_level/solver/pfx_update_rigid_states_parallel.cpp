@@ -0,0 +1,66 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "base_level/base/pfx_perf_counter.h"
+#include "low_level/solver/pfx_update_rigid_states.h"
+
+namespace sce {
+namespace PhysicsEffects {
+
+extern PfxInt32 pfxCheckParamOfUpdateRigidStates(const PfxUpdateRigidStatesParam &param);
+extern void pfxUpdateRigidStatesRange(PfxUpdateRigidStatesParam &param,PfxUInt32 start,PfxUInt32 num);
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI THREADS
+
+void pfxUpdateRigidStatesTaskEntry(PfxTaskArg *arg)
+{
+	PfxUpdateRigidStatesParam &param = *((PfxUpdateRigidStatesParam*)arg->io);
+	pfxUpdateRigidStatesRange(param,arg->data[0],arg->data[1]);
+}
+
+PfxInt32 pfxUpdateRigidStates(PfxUpdateRigidStatesParam &param,PfxTaskManager *taskManager)
+{
+	if(!taskManager) return pfxUpdateRigidStates(param);
+
+	PfxInt32 ret = pfxCheckParamOfUpdateRigidStates(param);
+	if(ret != SCE_PFX_OK) return ret;
+
+	SCE_PFX_PUSH_MARKER("pfxUpdateRigidStates");
+
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	taskManager->setTaskEntry((void*)pfxUpdateRigidStatesTaskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		PfxUInt32 start = param.numRigidBodies * t / numTasks;
+		PfxUInt32 end = param.numRigidBodies * (t+1) / numTasks;
+		taskManager->startTask(t,&param,start,end-start,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
@@ -28,6 +28,13 @@ PfxInt32 pfxCheckParamOfUpdateRigidStates(const PfxUpdateRigidStatesParam &param
 	return SCE_PFX_OK;
 }
 
+void pfxUpdateRigidStatesRange(PfxUpdateRigidStatesParam &param,PfxUInt32 start,PfxUInt32 num)
+{
+	for(PfxUInt32 i=start;i<start+num;i++) {
+		pfxIntegrate(param.states[i],param.bodies[i],param.timeStep);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // SINGLE THREAD
 
@@ -38,9 +45,7 @@ PfxInt32 pfxUpdateRigidStates(PfxUpdateRigidStatesParam &param)
 
 	SCE_PFX_PUSH_MARKER("pfxUpdateRigidStates");
 
-	for(PfxUInt32 i=0;i<param.numRigidBodies;i++) {
-		pfxIntegrate(param.states[i],param.bodies[i],param.timeStep);
-	}
+	pfxUpdateRigidStatesRange(param,0,param.numRigidBodies);
 
 	SCE_PFX_POP_MARKER();
 
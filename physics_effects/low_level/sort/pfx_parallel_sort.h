@@ -25,6 +25,11 @@ Physics Effects under the filename: physics_effects_license.txt
 namespace sce {
 namespace PhysicsEffects {
 
+//J キーの順に安定ソートする。ワークバッファにはデータと同じサイズが必要
+//J 整列済みやほぼ整列済みのデータはそのまま返し、それ以外は基数ソートで並べる
+//E Stable sort by keys. The work buffer needs the same size as the data
+//E Already or nearly sorted data returns early, other data is sorted with a radix sort
+
 PfxInt32 pfxParallelSort(PfxSortData16 *data,PfxUInt32 numData,void *workBuff,PfxUInt32 workBytes);
 
 PfxInt32 pfxParallelSort(PfxSortData32 *data,PfxUInt32 numData,void *workBuff,PfxUInt32 workBytes);
@@ -0,0 +1,184 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "base_level/base/pfx_perf_counter.h"
+#include "low_level/sort/pfx_parallel_sort.h"
+
+namespace sce {
+namespace PhysicsEffects {
+
+extern void pfxCountRadix(const PfxSortData16 *src,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *counts);
+extern void pfxCountRadix(const PfxSortData32 *src,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *counts);
+extern void pfxScatterRadix(const PfxSortData16 *src,PfxSortData16 *dst,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *offsets);
+extern void pfxScatterRadix(const PfxSortData32 *src,PfxSortData32 *dst,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *offsets);
+extern PfxBool pfxPresort(PfxSortData16 *data,PfxUInt32 numData);
+extern PfxBool pfxPresort(PfxSortData32 *data,PfxUInt32 numData);
+
+///////////////////////////////////////////////////////////////////////////////
+// MULTI THREADS
+
+//J タスクあたりのデータがこの数より少ないときは呼び出したスレッドで並べる
+//E Sort on the calling thread when each task would get fewer data than this number
+#define SCE_PFX_PARALLEL_SORT_MIN 1024
+
+#define SCE_PFX_RADIX_BITS 8
+#define SCE_PFX_RADIX_SIZE (1<<SCE_PFX_RADIX_BITS)
+
+struct PfxParallelSortIO {
+	void *data;
+	void *buff;
+	PfxUInt32 numData;
+	PfxUInt32 *counts;
+};
+
+template <class SortData>
+void pfxRadixSortTask(PfxTaskArg *arg,PfxParallelSortIO &io)
+{
+	SortData *src = (SortData*)io.data;
+	SortData *dst = (SortData*)io.buff;
+
+	PfxUInt32 numTasks = arg->maxTasks;
+	PfxUInt32 start = io.numData * arg->taskId / numTasks;
+	PfxUInt32 num = io.numData * (arg->taskId+1) / numTasks - start;
+
+	PfxUInt32 *counts = io.counts + SCE_PFX_RADIX_SIZE * arg->taskId;
+	PfxUInt32 offsets[SCE_PFX_RADIX_SIZE];
+
+	const PfxUInt32 keyBits = sizeof(pfxGetKey(src[0]))*8;
+
+	for(PfxUInt32 shift=0;shift<keyBits;shift+=SCE_PFX_RADIX_BITS) {
+		//J 各タスクは自分の範囲のヒストグラムを数える
+		//E Each task counts the histogram of its own range
+		pfxCountRadix(src,start,num,shift,counts);
+
+		arg->barrier->sync();
+
+		//J 全タスクのヒストグラムから自分の書き込み先を求める
+		//E Compute the destinations of this task from the histograms of all tasks
+		PfxUInt32 sum = 0;
+		PfxBool skip = false;
+		for(PfxUInt32 b=0;b<SCE_PFX_RADIX_SIZE;b++) {
+			PfxUInt32 total = 0;
+			for(PfxUInt32 t=0;t<numTasks;t++) {
+				if(t == (PfxUInt32)arg->taskId) offsets[b] = sum + total;
+				total += io.counts[SCE_PFX_RADIX_SIZE*t+b];
+			}
+			if(total == io.numData) skip = true;
+			sum += total;
+		}
+
+		//J 全ての要素が同じ桁を持つパスは飛ばす
+		//E Skip the pass when all elements have the same digit
+		if(!skip) {
+			pfxScatterRadix(src,dst,start,num,shift,offsets);
+		}
+
+		arg->barrier->sync();
+
+		if(!skip) {
+			SortData *tmp = src;
+			src = dst;
+			dst = tmp;
+		}
+	}
+
+	if(src != (SortData*)io.data) {
+		memcpy((SortData*)io.data+start,src+start,sizeof(SortData)*num);
+	}
+}
+
+void pfxParallelSort16TaskEntry(PfxTaskArg *arg)
+{
+	PfxParallelSortIO &io = *((PfxParallelSortIO*)arg->io);
+	pfxRadixSortTask<PfxSortData16>(arg,io);
+}
+
+void pfxParallelSort32TaskEntry(PfxTaskArg *arg)
+{
+	PfxParallelSortIO &io = *((PfxParallelSortIO*)arg->io);
+	pfxRadixSortTask<PfxSortData32>(arg,io);
+}
+
+static void pfxStartParallelSortTasks(void *data,void *buff,PfxUInt32 numData,void *taskEntry,PfxTaskManager *taskManager)
+{
+	PfxUInt32 numTasks = taskManager->getNumTasks();
+
+	PfxParallelSortIO *io = (PfxParallelSortIO*)taskManager->allocate(sizeof(PfxParallelSortIO));
+	io->data = data;
+	io->buff = buff;
+	io->numData = numData;
+	io->counts = (PfxUInt32*)taskManager->allocate(sizeof(PfxUInt32)*SCE_PFX_RADIX_SIZE*numTasks);
+
+	taskManager->setTaskEntry(taskEntry);
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		taskManager->startTask(t,io,0,0,0,0);
+	}
+
+	for(PfxUInt32 t=0;t<numTasks;t++) {
+		int taskId;
+		PfxUInt32 data1,data2,data3,data4;
+		taskManager->waitTask(taskId,data1,data2,data3,data4);
+	}
+
+	taskManager->deallocate(io->counts);
+	taskManager->deallocate(io);
+}
+
+PfxInt32 pfxParallelSort(
+	PfxSortData16 *data,PfxUInt32 numData,
+	void *workBuff,PfxUInt32 workBytes,
+	PfxTaskManager *taskManager)
+{
+	if(!taskManager || numData < SCE_PFX_PARALLEL_SORT_MIN * taskManager->getNumTasks()) {
+		return pfxParallelSort(data,numData,workBuff,workBytes);
+	}
+
+	if(!SCE_PFX_PTR_IS_ALIGNED16(workBuff)) return SCE_PFX_ERR_INVALID_ALIGN;
+	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(workBuff,workBytes) < sizeof(PfxSortData16) * numData) return SCE_PFX_ERR_OUT_OF_BUFFER;
+
+	SCE_PFX_PUSH_MARKER("pfxParallelSort");
+	if(!pfxPresort(data,numData)) {
+		pfxStartParallelSortTasks(data,workBuff,numData,(void*)pfxParallelSort16TaskEntry,taskManager);
+	}
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+PfxInt32 pfxParallelSort(
+	PfxSortData32 *data,PfxUInt32 numData,
+	void *workBuff,PfxUInt32 workBytes,
+	PfxTaskManager *taskManager)
+{
+	if(!taskManager || numData < SCE_PFX_PARALLEL_SORT_MIN * taskManager->getNumTasks()) {
+		return pfxParallelSort(data,numData,workBuff,workBytes);
+	}
+
+	if(!SCE_PFX_PTR_IS_ALIGNED16(workBuff)) return SCE_PFX_ERR_INVALID_ALIGN;
+	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(workBuff,workBytes) < sizeof(PfxSortData32) * numData) return SCE_PFX_ERR_OUT_OF_BUFFER;
+
+	SCE_PFX_PUSH_MARKER("pfxParallelSort");
+	if(!pfxPresort(data,numData)) {
+		pfxStartParallelSortTasks(data,workBuff,numData,(void*)pfxParallelSort32TaskEntry,taskManager);
+	}
+	SCE_PFX_POP_MARKER();
+
+	return SCE_PFX_OK;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
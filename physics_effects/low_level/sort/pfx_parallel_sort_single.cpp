@@ -18,12 +18,141 @@ Physics Effects under the filename: physics_effects_license.txt
 #include "low_level/sort/pfx_parallel_sort.h"
 #include "base_level/sort/pfx_sort.h"
 
-///////////////////////////////////////////////////////////////////////////////
-// SINGLE THREAD
-
 namespace sce {
 namespace PhysicsEffects {
 
+//J この数より少ないデータはマージソートで並べる
+//E Data fewer than this number are sorted with the merge sort
+#define SCE_PFX_RADIX_SORT_MIN 256
+
+//J 基数ソートの1パスで扱うビット数
+//E Number of bits handled in one pass of the radix sort
+#define SCE_PFX_RADIX_BITS 8
+#define SCE_PFX_RADIX_SIZE (1<<SCE_PFX_RADIX_BITS)
+#define SCE_PFX_RADIX_MASK (SCE_PFX_RADIX_SIZE-1)
+
+//J 64ビットキーの桁数
+//E Number of digits of 64 bit keys
+#define SCE_PFX_RADIX_MAX_DIGITS (64/SCE_PFX_RADIX_BITS)
+
+template <class SortData>
+PfxBool pfxIsSortedInternal(const SortData *data,PfxUInt32 numData)
+{
+	for(PfxUInt32 i=1;i<numData;i++) {
+		if(pfxGetKey(data[i-1]) > pfxGetKey(data[i])) return false;
+	}
+	return true;
+}
+
+template <class SortData>
+void pfxCountRadixInternal(const SortData *src,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *counts)
+{
+	memset(counts,0,sizeof(PfxUInt32)*SCE_PFX_RADIX_SIZE);
+	for(PfxUInt32 i=start;i<start+num;i++) {
+		counts[(pfxGetKey(src[i])>>shift)&SCE_PFX_RADIX_MASK]++;
+	}
+}
+
+//J offsetsには各桁の書き込み先の先頭を渡す。要素は16バイト単位でコピーされる
+//E offsets holds the first destination of each digit. Elements are copied in 16 bytes blocks
+template <class SortData>
+void pfxScatterRadixInternal(const SortData *src,SortData *dst,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *offsets)
+{
+	for(PfxUInt32 i=start;i<start+num;i++) {
+		dst[offsets[(pfxGetKey(src[i])>>shift)&SCE_PFX_RADIX_MASK]++] = src[i];
+	}
+}
+
+//J 既に整列済み、またはほぼ整列済みのデータはここで並べ終える
+//E Finish sorting here if the data is already or nearly sorted
+template <class SortData>
+PfxBool pfxPresortInternal(SortData *data,PfxUInt32 numData)
+{
+	if(pfxIsSortedInternal(data,numData)) return true;
+	return pfxInsertionSort(data,numData,numData);
+}
+
+template <class SortData>
+void pfxRadixSortInternal(SortData *data,SortData *buff,PfxUInt32 numData)
+{
+	//J キーの幅はPfxSortData16が32ビットIDのとき64ビットになる
+	//E Keys are 64 bits wide for PfxSortData16 with 32 bit ids
+	const PfxUInt32 numDigits = sizeof(pfxGetKey(data[0]))*8/SCE_PFX_RADIX_BITS;
+
+	PfxUInt32 counts[SCE_PFX_RADIX_MAX_DIGITS][SCE_PFX_RADIX_SIZE];
+	memset(counts,0,sizeof(counts));
+
+	//J 全ての桁のヒストグラムを一度に数える
+	//E Count the histograms of all digits at once
+	for(PfxUInt32 i=0;i<numData;i++) {
+		PfxUInt64 key = pfxGetKey(data[i]);
+		for(PfxUInt32 d=0;d<numDigits;d++) {
+			counts[d][(key>>(d*SCE_PFX_RADIX_BITS))&SCE_PFX_RADIX_MASK]++;
+		}
+	}
+
+	SortData *src = data;
+	SortData *dst = buff;
+
+	for(PfxUInt32 d=0;d<numDigits;d++) {
+		PfxUInt32 shift = d*SCE_PFX_RADIX_BITS;
+
+		//J 全ての要素が同じ桁を持つパスは飛ばす
+		//E Skip the pass when all elements have the same digit
+		if(counts[d][(pfxGetKey(src[0])>>shift)&SCE_PFX_RADIX_MASK] == numData) continue;
+
+		PfxUInt32 sum = 0;
+		for(PfxUInt32 b=0;b<SCE_PFX_RADIX_SIZE;b++) {
+			PfxUInt32 c = counts[d][b];
+			counts[d][b] = sum;
+			sum += c;
+		}
+
+		pfxScatterRadixInternal(src,dst,0,numData,shift,counts[d]);
+
+		SortData *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if(src != data) {
+		memcpy(data,src,sizeof(SortData)*numData);
+	}
+}
+
+void pfxCountRadix(const PfxSortData16 *src,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *counts)
+{
+	pfxCountRadixInternal(src,start,num,shift,counts);
+}
+
+void pfxCountRadix(const PfxSortData32 *src,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *counts)
+{
+	pfxCountRadixInternal(src,start,num,shift,counts);
+}
+
+void pfxScatterRadix(const PfxSortData16 *src,PfxSortData16 *dst,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *offsets)
+{
+	pfxScatterRadixInternal(src,dst,start,num,shift,offsets);
+}
+
+void pfxScatterRadix(const PfxSortData32 *src,PfxSortData32 *dst,PfxUInt32 start,PfxUInt32 num,PfxUInt32 shift,PfxUInt32 *offsets)
+{
+	pfxScatterRadixInternal(src,dst,start,num,shift,offsets);
+}
+
+PfxBool pfxPresort(PfxSortData16 *data,PfxUInt32 numData)
+{
+	return pfxPresortInternal(data,numData);
+}
+
+PfxBool pfxPresort(PfxSortData32 *data,PfxUInt32 numData)
+{
+	return pfxPresortInternal(data,numData);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SINGLE THREAD
+
 PfxInt32 pfxParallelSort(
 	PfxSortData16 *data,PfxUInt32 numData,
 	void *workBuff,PfxUInt32 workBytes)
@@ -32,7 +161,14 @@ PfxInt32 pfxParallelSort(
 	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(workBuff,workBytes) < sizeof(PfxSortData16) * numData) return SCE_PFX_ERR_OUT_OF_BUFFER;
 
 	SCE_PFX_PUSH_MARKER("pfxParallelSort");
-	pfxSort(data,(PfxSortData16*)workBuff,numData);
+	if(!pfxPresortInternal(data,numData)) {
+		if(numData < SCE_PFX_RADIX_SORT_MIN) {
+			pfxSort(data,(PfxSortData16*)workBuff,numData);
+		}
+		else {
+			pfxRadixSortInternal(data,(PfxSortData16*)workBuff,numData);
+		}
+	}
 	SCE_PFX_POP_MARKER();
 
 	return SCE_PFX_OK;
@@ -46,7 +182,14 @@ PfxInt32 pfxParallelSort(
 	if(SCE_PFX_AVAILABLE_BYTES_ALIGN16(workBuff,workBytes) < sizeof(PfxSortData32) * numData) return SCE_PFX_ERR_OUT_OF_BUFFER;
 
 	SCE_PFX_PUSH_MARKER("pfxParallelSort");
-	pfxSort(data,(PfxSortData32*)workBuff,numData);
+	if(!pfxPresortInternal(data,numData)) {
+		if(numData < SCE_PFX_RADIX_SORT_MIN) {
+			pfxSort(data,(PfxSortData32*)workBuff,numData);
+		}
+		else {
+			pfxRadixSortInternal(data,(PfxSortData32*)workBuff,numData);
+		}
+	}
 	SCE_PFX_POP_MARKER();
 
 	return SCE_PFX_OK;
@@ -0,0 +1,129 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "pfx_sync_components_pthreads.h"
+
+#ifndef _WIN32
+
+namespace sce {
+namespace PhysicsEffects {
+
+///////////////////////////////////////////////////////////////////////////////
+// Barrier
+
+PfxPthreadsBarrier::PfxPthreadsBarrier()
+{
+	pthread_mutex_init(&m_mutex,NULL);
+	pthread_cond_init(&m_cond,NULL);
+	m_maxCount = 1;
+	m_count = 0;
+	m_generation = 0;
+}
+
+PfxPthreadsBarrier::~PfxPthreadsBarrier()
+{
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void PfxPthreadsBarrier::sync()
+{
+	pthread_mutex_lock(&m_mutex);
+
+	//J 世代番号で区別するので、同じバリアを続けて使用できる
+	//E The generation number lets the barrier be reused right after it is released
+	PfxUInt32 generation = m_generation;
+	if(++m_count >= m_maxCount) {
+		m_count = 0;
+		m_generation++;
+		pthread_cond_broadcast(&m_cond);
+	}
+	else {
+		while(generation == m_generation) {
+			pthread_cond_wait(&m_cond,&m_mutex);
+		}
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void PfxPthreadsBarrier::setMaxCount(int n)
+{
+	pthread_mutex_lock(&m_mutex);
+	m_maxCount = n;
+	m_count = 0;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+int PfxPthreadsBarrier::getMaxCount()
+{
+	return m_maxCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Critical Section
+
+PfxPthreadsCriticalSection::PfxPthreadsCriticalSection()
+{
+	pthread_mutex_init(&m_mutex,NULL);
+	memset(m_commonBuff,0,sizeof(m_commonBuff));
+}
+
+PfxPthreadsCriticalSection::~PfxPthreadsCriticalSection()
+{
+	pthread_mutex_destroy(&m_mutex);
+}
+
+PfxUInt32 PfxPthreadsCriticalSection::getSharedParam(int i)
+{
+	SCE_PFX_ASSERT(i>=0&&i<32);
+	return m_commonBuff[i];
+}
+
+void PfxPthreadsCriticalSection::setSharedParam(int i,PfxUInt32 p)
+{
+	SCE_PFX_ASSERT(i>=0&&i<32);
+	m_commonBuff[i] = p;
+}
+
+void PfxPthreadsCriticalSection::lock()
+{
+	pthread_mutex_lock(&m_mutex);
+}
+
+void PfxPthreadsCriticalSection::unlock()
+{
+	pthread_mutex_unlock(&m_mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PfxBarrier *pfxCreateBarrierPthreads(int n)
+{
+	PfxPthreadsBarrier *barrier = new PfxPthreadsBarrier;
+	barrier->setMaxCount(n);
+	return barrier;
+}
+
+PfxCriticalSection *pfxCreateCriticalSectionPthreads()
+{
+	return new PfxPthreadsCriticalSection;
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
+
+#endif // _WIN32
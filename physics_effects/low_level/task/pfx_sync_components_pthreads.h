@@ -0,0 +1,70 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#ifndef _SCE_PFX_SYNC_COMPONENTS_PTHREADS_H
+#define _SCE_PFX_SYNC_COMPONENTS_PTHREADS_H
+
+#include "pfx_sync_components.h"
+
+#ifndef _WIN32
+
+#include <pthread.h>
+
+//J pthreadsによる同期コンポネント
+//E Synchronization components implemented with pthreads
+namespace sce {
+namespace PhysicsEffects {
+
+class PfxPthreadsBarrier : public PfxBarrier {
+private:
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	int m_maxCount;
+	int m_count;
+	PfxUInt32 m_generation;
+
+public:
+	PfxPthreadsBarrier();
+	~PfxPthreadsBarrier();
+
+	void sync();
+	void setMaxCount(int n);
+	int  getMaxCount();
+};
+
+class PfxPthreadsCriticalSection : public PfxCriticalSection {
+private:
+	pthread_mutex_t m_mutex;
+
+public:
+	PfxPthreadsCriticalSection();
+	~PfxPthreadsCriticalSection();
+
+	PfxUInt32 getSharedParam(int i);
+	void setSharedParam(int i,PfxUInt32 p);
+
+	void lock();
+	void unlock();
+};
+
+PfxBarrier *pfxCreateBarrierPthreads(int n);
+PfxCriticalSection *pfxCreateCriticalSectionPthreads();
+
+} //namespace PhysicsEffects
+} //namespace sce
+
+#endif // _WIN32
+#endif // _SCE_PFX_SYNC_COMPONENTS_PTHREADS_H
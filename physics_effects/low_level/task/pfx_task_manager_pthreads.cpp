@@ -0,0 +1,195 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "pfx_task_manager_pthreads.h"
+
+#ifndef _WIN32
+
+namespace sce {
+namespace PhysicsEffects {
+
+PfxUInt32 PfxPthreadsTaskManager::getWorkBytes(PfxUInt32 maxTasks)
+{
+	return 128 +
+		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxTaskArg)*maxTasks) +
+		SCE_PFX_ALLOC_BYTES_ALIGN16(sizeof(PfxThreadContext)*maxTasks);
+}
+
+PfxUInt32 pfxGetWorkBytesOfTaskManager(PfxUInt32 numTasks,PfxUInt32 maxTasks)
+{
+	(void)numTasks;
+	return PfxPthreadsTaskManager::getWorkBytes(maxTasks);
+}
+
+PfxPthreadsTaskManager::PfxPthreadsTaskManager(PfxUInt32 numTasks,PfxUInt32 maxTasks,void *workBuff,PfxUInt32 workBytes)
+	: PfxTaskManager(numTasks,maxTasks,workBuff,workBytes)
+{
+	m_threads = (PfxThreadContext*)m_pool.allocate(sizeof(PfxThreadContext)*m_maxTasks);
+	m_initialized = false;
+	m_taskEntry = NULL;
+	pthread_mutex_init(&m_mutex,NULL);
+	pthread_cond_init(&m_finishCond,NULL);
+	m_barrier.setMaxCount(m_numTasks);
+}
+
+PfxPthreadsTaskManager::~PfxPthreadsTaskManager()
+{
+	finalize();
+	pthread_cond_destroy(&m_finishCond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void *PfxPthreadsTaskManager::threadMain(void *arg)
+{
+	PfxThreadContext &context = *((PfxThreadContext*)arg);
+	PfxPthreadsTaskManager *manager = context.manager;
+
+	for(;;) {
+		pthread_mutex_lock(&manager->m_mutex);
+		while(context.status != SCE_PFX_TASK_RUNNING && context.status != SCE_PFX_TASK_EXIT) {
+			pthread_cond_wait(&context.startCond,&manager->m_mutex);
+		}
+		int status = context.status;
+		pthread_mutex_unlock(&manager->m_mutex);
+
+		if(status == SCE_PFX_TASK_EXIT) break;
+
+		manager->m_taskEntry(&manager->m_taskArg[context.taskId]);
+
+		pthread_mutex_lock(&manager->m_mutex);
+		context.status = SCE_PFX_TASK_FINISHED;
+		pthread_cond_signal(&manager->m_finishCond);
+		pthread_mutex_unlock(&manager->m_mutex);
+	}
+
+	return NULL;
+}
+
+PfxUInt32 PfxPthreadsTaskManager::getSharedParam(int i)
+{
+	return m_criticalSection.getSharedParam(i);
+}
+
+void PfxPthreadsTaskManager::setSharedParam(int i,PfxUInt32 p)
+{
+	m_criticalSection.setSharedParam(i,p);
+}
+
+void PfxPthreadsTaskManager::startTask(int taskId,void *io,PfxUInt32 data1,PfxUInt32 data2,PfxUInt32 data3,PfxUInt32 data4)
+{
+	SCE_PFX_ASSERT(m_initialized);
+	SCE_PFX_ASSERT(taskId>=0&&taskId<(int)m_numTasks);
+
+	PfxTaskArg &arg = m_taskArg[taskId];
+	arg.taskId = taskId;
+	arg.maxTasks = m_numTasks;
+	arg.barrier = &m_barrier;
+	arg.criticalSection = &m_criticalSection;
+	arg.io = io;
+	arg.data[0] = data1;
+	arg.data[1] = data2;
+	arg.data[2] = data3;
+	arg.data[3] = data4;
+
+	PfxThreadContext &context = m_threads[taskId];
+
+	pthread_mutex_lock(&m_mutex);
+	SCE_PFX_ASSERT(context.status == SCE_PFX_TASK_IDLE);
+	context.status = SCE_PFX_TASK_RUNNING;
+	pthread_cond_signal(&context.startCond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void PfxPthreadsTaskManager::waitTask(int &taskId,PfxUInt32 &data1,PfxUInt32 &data2,PfxUInt32 &data3,PfxUInt32 &data4)
+{
+	SCE_PFX_ASSERT(m_initialized);
+
+	pthread_mutex_lock(&m_mutex);
+	int finishedId = -1;
+	for(;;) {
+		for(PfxUInt32 i=0;i<m_maxTasks;i++) {
+			if(m_threads[i].status == SCE_PFX_TASK_FINISHED) {
+				finishedId = i;
+				break;
+			}
+		}
+		if(finishedId >= 0) break;
+		pthread_cond_wait(&m_finishCond,&m_mutex);
+	}
+	m_threads[finishedId].status = SCE_PFX_TASK_IDLE;
+	pthread_mutex_unlock(&m_mutex);
+
+	PfxTaskArg &arg = m_taskArg[finishedId];
+	taskId = finishedId;
+	data1 = arg.data[0];
+	data2 = arg.data[1];
+	data3 = arg.data[2];
+	data4 = arg.data[3];
+}
+
+void PfxPthreadsTaskManager::setNumTasks(PfxUInt32 tasks)
+{
+	PfxTaskManager::setNumTasks(tasks);
+	m_barrier.setMaxCount(m_numTasks);
+}
+
+void PfxPthreadsTaskManager::initialize()
+{
+	if(m_initialized) return;
+
+	for(PfxUInt32 i=0;i<m_maxTasks;i++) {
+		PfxThreadContext &context = m_threads[i];
+		context.manager = this;
+		context.taskId = i;
+		context.status = SCE_PFX_TASK_IDLE;
+		pthread_cond_init(&context.startCond,NULL);
+		int ret = pthread_create(&context.thread,NULL,threadMain,&context);
+		SCE_PFX_ALWAYS_ASSERT(ret == 0);
+		(void)ret;
+	}
+
+	m_initialized = true;
+}
+
+void PfxPthreadsTaskManager::finalize()
+{
+	if(!m_initialized) return;
+
+	pthread_mutex_lock(&m_mutex);
+	for(PfxUInt32 i=0;i<m_maxTasks;i++) {
+		m_threads[i].status = SCE_PFX_TASK_EXIT;
+		pthread_cond_signal(&m_threads[i].startCond);
+	}
+	pthread_mutex_unlock(&m_mutex);
+
+	for(PfxUInt32 i=0;i<m_maxTasks;i++) {
+		pthread_join(m_threads[i].thread,NULL);
+		pthread_cond_destroy(&m_threads[i].startCond);
+	}
+
+	m_initialized = false;
+}
+
+PfxTaskManager *pfxCreateTaskManagerPthreads(PfxUInt32 numTasks,PfxUInt32 maxTasks,void *workBuff,PfxUInt32 workBytes)
+{
+	SCE_PFX_ALWAYS_ASSERT(workBytes >= pfxGetWorkBytesOfTaskManager(numTasks,maxTasks));
+	return new PfxPthreadsTaskManager(numTasks,maxTasks,workBuff,workBytes);
+}
+
+} //namespace PhysicsEffects
+} //namespace sce
+
+#endif // _WIN32
@@ -0,0 +1,90 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#ifndef _SCE_PFX_TASK_MANAGER_PTHREADS_H
+#define _SCE_PFX_TASK_MANAGER_PTHREADS_H
+
+#include "pfx_task_manager.h"
+#include "pfx_sync_components_pthreads.h"
+
+#ifndef _WIN32
+
+namespace sce {
+namespace PhysicsEffects {
+
+//J pthreadsによるタスクマネージャ
+//J initialize()でmaxTasks個のワーカースレッドを作成し、finalize()で終了させる
+//E Task manager implemented with pthreads
+//E initialize() creates maxTasks worker threads, finalize() terminates them
+
+class PfxPthreadsTaskManager : public PfxTaskManager
+{
+private:
+	enum {
+		SCE_PFX_TASK_IDLE,
+		SCE_PFX_TASK_RUNNING,
+		SCE_PFX_TASK_FINISHED,
+		SCE_PFX_TASK_EXIT
+	};
+
+	struct PfxThreadContext {
+		PfxPthreadsTaskManager *manager;
+		pthread_t thread;
+		pthread_cond_t startCond;
+		int taskId;
+		int status;
+	};
+
+	PfxThreadContext *m_threads;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_finishCond;
+	PfxPthreadsBarrier m_barrier;
+	PfxPthreadsCriticalSection m_criticalSection;
+	PfxBool m_initialized;
+
+	static void *threadMain(void *arg);
+
+public:
+	static PfxUInt32 getWorkBytes(PfxUInt32 maxTasks);
+
+	PfxPthreadsTaskManager(PfxUInt32 numTasks,PfxUInt32 maxTasks,void *workBuff,PfxUInt32 workBytes);
+	~PfxPthreadsTaskManager();
+
+	PfxUInt32 getSharedParam(int i);
+	void setSharedParam(int i,PfxUInt32 p);
+
+	void startTask(int taskId,void *io,PfxUInt32 data1,PfxUInt32 data2,PfxUInt32 data3,PfxUInt32 data4);
+	void waitTask(int &taskId,PfxUInt32 &data1,PfxUInt32 &data2,PfxUInt32 &data3,PfxUInt32 &data4);
+
+	void setNumTasks(PfxUInt32 tasks);
+
+	void initialize();
+	void finalize();
+};
+
+//J タスクマネージャが使用するワークバッファのサイズ
+//E Size of the work buffer used by the task manager
+PfxUInt32 pfxGetWorkBytesOfTaskManager(PfxUInt32 numTasks,PfxUInt32 maxTasks);
+
+//J タスクマネージャを作成する。使用後はfinalize()を呼んでからdeleteで開放する
+//E Create a task manager. Call finalize() and delete it when it's no longer used
+PfxTaskManager *pfxCreateTaskManagerPthreads(PfxUInt32 numTasks,PfxUInt32 maxTasks,void *workBuff,PfxUInt32 workBytes);
+
+} //namespace PhysicsEffects
+} //namespace sce
+
+#endif // _WIN32
+#endif // _SCE_PFX_TASK_MANAGER_PTHREADS_H
@@ -18,14 +18,29 @@ Physics Effects under the filename: physics_effects_license.txt
 #include "physics_func.h"
 #include "../common/perf_func.h"
 
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
 static int frameCount = 0;
 static int sceneId = 2;
 
-int main()
+int main(int argc,char **argv)
 {
+	//J タスク数（省略時はCPUのコア数）
+	//E Number of tasks (the number of cores by default)
+	int numTasks = 1;
+#ifndef _WIN32
+	numTasks = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(argc > 1) numTasks = atoi(argv[1]);
+#else
+	(void)argc;
+	(void)argv;
+#endif
 
 	perf_init();
-	physics_init();
+	physics_init(numTasks);
 
 	physics_create_scene(sceneId);
 
@@ -36,8 +51,11 @@ int main()
 	while(frameCount<600) {
 		physics_simulate();
 		perf_sync();
+		frameCount++;
 	}
 
+	physics_release();
+
 	SCE_PFX_PRINTF("program complete\n");
 
 	return 0;
@@ -54,6 +54,7 @@ PfxConvexMesh gConvex;
 //J プロキシ
 //E Proxies
 PfxBroadphaseProxy proxies[NUM_RIGIDBODIES];
+int proxyAxis = -1;
 
 //J ジョイント
 //E Joint
@@ -84,6 +85,14 @@ unsigned char SCE_PFX_ALIGNED(128) poolBuff[POOL_BYTES];
 //E Stack allocator for temporary buffers
 PfxHeapManager pool(poolBuff,POOL_BYTES);
 
+//J タスクマネージャ
+//E Task manager
+#define MAX_TASKS 16
+#ifndef _WIN32
+unsigned char SCE_PFX_ALIGNED(16) taskBuff[32*1024];
+#endif
+PfxTaskManager *taskManager = NULL;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Simulation Function
 
@@ -98,34 +107,30 @@ void broadphase()
 	PfxBroadphasePair *previousPairs = pairsBuff[1-pairSwap];
 	PfxBroadphasePair *currentPairs = pairsBuff[pairSwap];
 
-	//J 剛体が最も分散している軸を見つける
-	//E Find the axis along which all rigid bodies are most widely positioned
-	int axis = 0;
-	{
-		PfxVector3 s(0.0f),s2(0.0f);
-		for(int i=0;i<numRigidBodies;i++) {
-			PfxVector3 c = states[i].getPosition();
-			s += c;
-			s2 += mulPerElem(c,c);
-		}
-		PfxVector3 v = s2 - mulPerElem(s,s) / (float)numRigidBodies;
-		if(v[1] > v[0]) axis = 1;
-		if(v[2] > v[axis]) axis = 2;
-	}
-
 	//J ブロードフェーズプロキシの更新
-	//E Create broadpahse proxies
+	//E Update broadpahse proxies
+	//J 剛体が最も分散している軸の選択と並べ替えも行われる
+	//E The axis along which all rigid bodies are most widely positioned is selected, and proxies are sorted along it
 	{
-		for(int i=0;i<numRigidBodies;i++) {
-			pfxUpdateBroadphaseProxy(proxies[i],states[i],collidables[i],worldCenter,worldExtent,axis);
-		}
+		PfxUpdateSortedBroadphaseProxiesParam param;
+		param.workBytes = pfxGetWorkBytesOfUpdateSortedBroadphaseProxies(numRigidBodies);
+		param.workBuff = pool.allocate(param.workBytes,128);
+		param.proxies = proxies;
+		param.offsetRigidStates = states;
+		param.offsetCollidables = collidables;
+		param.numRigidBodies = numRigidBodies;
+		param.worldCenter = worldCenter;
+		param.worldExtent = worldExtent;
+		param.axis = proxyAxis;
 
-		int workBytes = sizeof(PfxBroadphaseProxy) * numRigidBodies;
-		void *workBuff = pool.allocate(workBytes);
-				
-		pfxParallelSort(proxies,numRigidBodies,workBuff,workBytes);
+		PfxUpdateSortedBroadphaseProxiesResult result;
 
-		pool.deallocate(workBuff);
+		int ret = pfxUpdateSortedBroadphaseProxies(param,result,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxUpdateSortedBroadphaseProxies failed %d\n",ret);
+
+		pool.deallocate(param.workBuff);
+
+		proxyAxis = result.axis;
 	}
 
 	//J 交差ペア探索
@@ -134,16 +139,16 @@ void broadphase()
 		PfxFindPairsParam findPairsParam;
 		findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(NUM_CONTACTS);
 		findPairsParam.pairBuff = pool.allocate(findPairsParam.pairBytes);
-		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(NUM_CONTACTS);
+		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(numRigidBodies,NUM_CONTACTS,taskManager?taskManager->getNumTasks():1);
 		findPairsParam.workBuff = pool.allocate(findPairsParam.workBytes);
 		findPairsParam.proxies = proxies;
 		findPairsParam.numProxies = numRigidBodies;
 		findPairsParam.maxPairs = NUM_CONTACTS;
-		findPairsParam.axis = axis;
+		findPairsParam.axis = proxyAxis;
 
 		PfxFindPairsResult findPairsResult;
 
-		int ret = pfxFindPairs(findPairsParam,findPairsResult);
+		int ret = pfxFindPairs(findPairsParam,findPairsResult,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxFindPairs failed %d\n",ret);
 		
 		pool.deallocate(findPairsParam.workBuff);
@@ -239,7 +244,7 @@ void collision()
 		param.offsetCollidables = collidables;
 		param.numRigidBodies = numRigidBodies;
 
-		int ret = pfxDetectCollision(param);
+		int ret = pfxDetectCollision(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxDetectCollision failed %d\n",ret);
 	}
 
@@ -253,7 +258,7 @@ void collision()
 		param.offsetRigidStates = states;
 		param.numRigidBodies = numRigidBodies;
 
-		int ret = pfxRefreshContacts(param);
+		int ret = pfxRefreshContacts(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxRefreshContacts failed %d\n",ret);
 	}
 }
@@ -273,7 +278,7 @@ void constraintSolver()
 		param.solverBodies = solverBodies;
 		param.numRigidBodies = numRigidBodies;
 		
-		int ret = pfxSetupSolverBodies(param);
+		int ret = pfxSetupSolverBodies(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSetupSolverBodies failed %d\n",ret);
 	}
 	pc.countEnd();
@@ -291,7 +296,7 @@ void constraintSolver()
 		param.timeStep = timeStep;
 		param.separateBias = separateBias;
 		
-		int ret = pfxSetupContactConstraints(param);
+		int ret = pfxSetupContactConstraints(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSetupJointConstraints failed %d\n",ret);
 	}
 	pc.countEnd();
@@ -312,7 +317,7 @@ void constraintSolver()
 			pfxUpdateJointPairs(jointPairs[i],i,joints[i],states[joints[i].m_rigidBodyIdA],states[joints[i].m_rigidBodyIdB]);
 		}
 
-		int ret = pfxSetupJointConstraints(param);
+		int ret = pfxSetupJointConstraints(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSetupJointConstraints failed %d\n",ret);
 	}
 	pc.countEnd();
@@ -333,7 +338,7 @@ void constraintSolver()
 		param.numRigidBodies = numRigidBodies;
 		param.iteration = iteration;
 
-		int ret = pfxSolveConstraints(param);
+		int ret = pfxSolveConstraints(param,taskManager);
 		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSolveConstraints failed %d\n",ret);
 		
 		pool.deallocate(param.workBuff);
@@ -351,7 +356,7 @@ void integrate()
 	param.numRigidBodies = numRigidBodies;
 	param.timeStep = timeStep;
 	
-	pfxUpdateRigidStates(param);
+	pfxUpdateRigidStates(param,taskManager);
 }
 
 void physics_simulate()
@@ -757,6 +762,7 @@ void physics_create_scene(int sceneId)
 	numContacts = 0;
 	numContactIdPool = 0;
 	numJoints = 0;
+	proxyAxis = -1;
 	frame = 0;
 	
 	switch(sid) {
@@ -802,13 +808,30 @@ void physics_create_scene(int sceneId)
 ///////////////////////////////////////////////////////////////////////////////
 // Initialize / Finalize Engine
 
-bool physics_init()
+bool physics_init(int numTasks)
 {
+#ifndef _WIN32
+	//J numTasks個のワーカースレッドでシミュレーションを実行する
+	//E Run the simulation on numTasks worker threads
+	if(numTasks > 1) {
+		numTasks = SCE_PFX_MIN(numTasks,MAX_TASKS);
+		SCE_PFX_ALWAYS_ASSERT(pfxGetWorkBytesOfTaskManager(numTasks,numTasks) <= sizeof(taskBuff));
+		taskManager = pfxCreateTaskManagerPthreads(numTasks,numTasks,taskBuff,sizeof(taskBuff));
+		taskManager->initialize();
+	}
+#else
+	(void)numTasks;
+#endif
 	return true;
 }
 
 void physics_release()
 {
+	if(taskManager) {
+		taskManager->finalize();
+		delete taskManager;
+		taskManager = NULL;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -25,7 +25,7 @@ using namespace sce::PhysicsEffects;
 
 //E Simulation
 //J シミュレーション
-bool physics_init();
+bool physics_init(int numTasks = 1);
 void physics_release();
 void physics_create_scene(int sceneId);
 void physics_simulate();
@@ -121,7 +121,7 @@ void broadphase()
 	//E Find overlapped pairs
 	{
 		PfxFindPairsParam param;
-		param.workBytes = pfxGetWorkBytesOfFindPairs(NUM_CONTACTS);
+		param.workBytes = pfxGetWorkBytesOfFindPairs(numRigidBodies,NUM_CONTACTS);
 		param.workBuff = pool.allocate(param.workBytes);
 		param.pairBytes = pfxGetPairBytesOfFindPairs(NUM_CONTACTS);
 		param.pairBuff = pool.allocate(param.pairBytes);
@@ -136,7 +136,7 @@ void broadphase()
 		PfxFindPairsParam findPairsParam;
 		findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(NUM_CONTACTS);
 		findPairsParam.pairBuff = pool.allocate(findPairsParam.pairBytes);
-		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(NUM_CONTACTS);
+		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(numRigidBodies,NUM_CONTACTS);
 		findPairsParam.workBuff = pool.allocate(findPairsParam.workBytes);
 		findPairsParam.proxies = proxies;
 		findPairsParam.numProxies = numRigidBodies;
@@ -252,8 +252,6 @@ void collision()
 	for(PfxUInt32 i=0;i<numCurrentPairs;i++) {
 		PfxConstraintPair &pair = currentPairs[i];
 	
-		PfxUInt16 iA = pfxGetObjectIdA(pair);
-		PfxUInt16 iB = pfxGetObjectIdB(pair);
 		PfxUInt32 iConstraint = pfxGetConstraintId(pair);
 
 		PfxContactManifold &contact = contacts[iConstraint];
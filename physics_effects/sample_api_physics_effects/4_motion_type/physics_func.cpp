@@ -154,7 +154,7 @@ void broadphase()
 		PfxFindPairsParam findPairsParam;
 		findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(NUM_CONTACTS);
 		findPairsParam.pairBuff = pool.allocate(findPairsParam.pairBytes);
-		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(NUM_CONTACTS);
+		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(numRigidBodies,NUM_CONTACTS);
 		findPairsParam.workBuff = pool.allocate(findPairsParam.workBytes);
 		findPairsParam.proxies = proxies;
 		findPairsParam.numProxies = numRigidBodies;
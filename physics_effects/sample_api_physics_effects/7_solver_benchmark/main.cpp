@@ -0,0 +1,342 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "physics_effects.h"
+#include "util/pfx_util_common.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace sce::PhysicsEffects;
+
+//J 箱の山を一度だけ衝突検出し、同じコンタクトに対してpfxSolveConstraintsを
+//J シングルスレッド版、1タスク、Nタスク(引数、省略時はCPUのコア数)で実行して時間を比較する
+//J Nタスクの結果が1タスクの結果と完全に一致するか、シングルスレッド版との速度の最大誤差も表示する
+//E Detects collisions of stacks of boxes once, then runs pfxSolveConstraints on the same contacts
+//E with the single thread path, on 1 task and on N tasks (argument, the number of cores by default) and compares the times
+//E Also prints whether the N task results are identical to the 1 task results and the largest velocity difference to the single thread path
+
+#define STACK_HEIGHT 5
+#define NUM_REPEATS  5
+
+const float timeStep = 0.016f;
+const float separateBias = 0.1f;
+const int iteration = 10;
+
+PfxVector3 worldCenter(0.0f);
+PfxVector3 worldExtent(500.0f);
+
+struct SolverScene {
+	PfxUInt32 numRigidBodies;
+	PfxRigidState *states;
+	PfxRigidState *initialStates;
+	PfxRigidBody *bodies;
+	PfxCollidable *collidables;
+	PfxSolverBody *solverBodies;
+
+	PfxUInt32 numPairs;
+	PfxConstraintPair *pairs;
+	PfxContactManifold *contacts;
+	PfxContactManifold *initialContacts;
+
+	PfxUInt32 workBytes;
+	void *workBuff;
+};
+
+void createBox(SolverScene &scene,const PfxVector3 &pos,const PfxVector3 &boxSize,PfxFloat mass,ePfxMotionType motionType)
+{
+	PfxUInt32 id = scene.numRigidBodies++;
+	PfxBox box(boxSize);
+	PfxShape shape;
+	shape.reset();
+	shape.setBox(box);
+	scene.collidables[id].reset();
+	scene.collidables[id].addShape(shape);
+	scene.collidables[id].finish();
+	scene.bodies[id].reset();
+	scene.states[id].reset();
+	scene.states[id].setPosition(pos);
+	scene.states[id].setMotionType(motionType);
+	scene.states[id].setRigidBodyId(id);
+	if(motionType == kPfxMotionTypeActive) {
+		scene.bodies[id].setRestitution(0.0f);
+		scene.bodies[id].setMass(mass);
+		scene.bodies[id].setInertia(pfxCalcInertiaBox(boxSize,mass));
+	}
+}
+
+void createScene(SolverScene &scene,PfxUInt32 numRigidBodies)
+{
+	memset(&scene,0,sizeof(SolverScene));
+
+	scene.states = (PfxRigidState*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxRigidState)*numRigidBodies);
+	scene.initialStates = (PfxRigidState*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxRigidState)*numRigidBodies);
+	scene.bodies = (PfxRigidBody*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxRigidBody)*numRigidBodies);
+	scene.collidables = (PfxCollidable*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxCollidable)*numRigidBodies);
+	scene.solverBodies = (PfxSolverBody*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxSolverBody)*numRigidBodies);
+
+	//J 地面と格子状に並べた箱の山
+	//E A ground and stacks of boxes on a grid
+	createBox(scene,PfxVector3(0.0f,-2.5f,0.0f),PfxVector3(150.0f,2.5f,150.0f),0.0f,kPfxMotionTypeFixed);
+
+	PfxUInt32 numStacks = (numRigidBodies - 1) / STACK_HEIGHT;
+	PfxUInt32 gridSize = (PfxUInt32)ceilf(sqrtf((float)numStacks));
+	PfxVector3 boxSize(0.5f);
+	PfxFloat spacing = 1.1f;
+	PfxFloat offset = -0.5f * spacing * gridSize;
+
+	for(PfxUInt32 s=0;s<numStacks;s++) {
+		PfxFloat x = offset + spacing * (s % gridSize);
+		PfxFloat z = offset + spacing * (s / gridSize);
+		for(int h=0;h<STACK_HEIGHT;h++) {
+			createBox(scene,PfxVector3(x,0.49f+0.99f*h,z),boxSize,1.0f,kPfxMotionTypeActive);
+		}
+	}
+
+	for(PfxUInt32 i=1;i<scene.numRigidBodies;i++) {
+		pfxApplyExternalForce(scene.states[i],scene.bodies[i],scene.bodies[i].getMass()*PfxVector3(0.0f,-9.8f,0.0f),PfxVector3(0.0f),timeStep);
+	}
+
+	memcpy((void*)scene.initialStates,scene.states,sizeof(PfxRigidState)*scene.numRigidBodies);
+
+	//J ブロードフェーズ
+	//E Broadphase
+	PfxBroadphaseProxy *proxies = (PfxBroadphaseProxy*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxBroadphaseProxy)*scene.numRigidBodies);
+	for(PfxUInt32 i=0;i<scene.numRigidBodies;i++) {
+		pfxUpdateBroadphaseProxy(proxies[i],scene.states[i],scene.collidables[i],worldCenter,worldExtent,0);
+	}
+
+	{
+		PfxUInt32 workBytes = sizeof(PfxBroadphaseProxy) * scene.numRigidBodies;
+		void *workBuff = SCE_PFX_UTIL_ALLOC(16,workBytes);
+		pfxParallelSort(proxies,scene.numRigidBodies,workBuff,workBytes);
+		SCE_PFX_UTIL_FREE(workBuff);
+	}
+
+	PfxUInt32 maxPairs = scene.numRigidBodies * 8;
+
+	PfxFindPairsParam findPairsParam;
+	findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(maxPairs);
+	findPairsParam.pairBuff = SCE_PFX_UTIL_ALLOC(16,findPairsParam.pairBytes);
+	findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(scene.numRigidBodies,maxPairs);
+	findPairsParam.workBuff = SCE_PFX_UTIL_ALLOC(16,findPairsParam.workBytes);
+	findPairsParam.proxies = proxies;
+	findPairsParam.numProxies = scene.numRigidBodies;
+	findPairsParam.maxPairs = maxPairs;
+	findPairsParam.axis = 0;
+
+	PfxFindPairsResult findPairsResult;
+
+	int ret = pfxFindPairs(findPairsParam,findPairsResult);
+	if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxFindPairs failed %d\n",ret);
+
+	scene.numPairs = findPairsResult.numPairs;
+	scene.pairs = (PfxConstraintPair*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxConstraintPair)*scene.numPairs);
+	memcpy(scene.pairs,findPairsResult.pairs,sizeof(PfxConstraintPair)*scene.numPairs);
+
+	SCE_PFX_UTIL_FREE(findPairsParam.workBuff);
+	SCE_PFX_UTIL_FREE(findPairsParam.pairBuff);
+	SCE_PFX_UTIL_FREE(proxies);
+
+	//J 衝突検出
+	//E Detect collisions
+	scene.contacts = (PfxContactManifold*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxContactManifold)*scene.numPairs);
+	scene.initialContacts = (PfxContactManifold*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxContactManifold)*scene.numPairs);
+
+	for(PfxUInt32 i=0;i<scene.numPairs;i++) {
+		pfxSetContactId(scene.pairs[i],i);
+		scene.contacts[i].reset(pfxGetObjectIdA(scene.pairs[i]),pfxGetObjectIdB(scene.pairs[i]));
+	}
+
+	PfxDetectCollisionParam detectParam;
+	detectParam.contactPairs = scene.pairs;
+	detectParam.numContactPairs = scene.numPairs;
+	detectParam.offsetContactManifolds = scene.contacts;
+	detectParam.offsetRigidStates = scene.states;
+	detectParam.offsetCollidables = scene.collidables;
+	detectParam.numRigidBodies = scene.numRigidBodies;
+
+	ret = pfxDetectCollision(detectParam);
+	if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxDetectCollision failed %d\n",ret);
+
+	memcpy(scene.initialContacts,scene.contacts,sizeof(PfxContactManifold)*scene.numPairs);
+
+	scene.workBytes = pfxGetWorkBytesOfSolveConstraints(scene.numRigidBodies,scene.numPairs,0);
+	scene.workBuff = SCE_PFX_UTIL_ALLOC(16,scene.workBytes);
+}
+
+void releaseScene(SolverScene &scene)
+{
+	SCE_PFX_UTIL_FREE(scene.workBuff);
+	SCE_PFX_UTIL_FREE(scene.initialContacts);
+	SCE_PFX_UTIL_FREE(scene.contacts);
+	SCE_PFX_UTIL_FREE(scene.pairs);
+	SCE_PFX_UTIL_FREE(scene.solverBodies);
+	SCE_PFX_UTIL_FREE(scene.collidables);
+	SCE_PFX_UTIL_FREE(scene.bodies);
+	SCE_PFX_UTIL_FREE(scene.initialStates);
+	SCE_PFX_UTIL_FREE(scene.states);
+}
+
+//J コンタクトと剛体の状態を元に戻してソルバーを実行し、pfxSolveConstraintsの時間(ms)を返す
+//E Restore the contacts and the rigid states, run the solver and return the time of pfxSolveConstraints in ms
+float solve(SolverScene &scene,PfxTaskManager *taskManager)
+{
+	memcpy((void*)scene.states,scene.initialStates,sizeof(PfxRigidState)*scene.numRigidBodies);
+	memcpy(scene.contacts,scene.initialContacts,sizeof(PfxContactManifold)*scene.numPairs);
+
+	PfxSetupSolverBodiesParam setupSolverBodiesParam;
+	setupSolverBodiesParam.states = scene.states;
+	setupSolverBodiesParam.bodies = scene.bodies;
+	setupSolverBodiesParam.solverBodies = scene.solverBodies;
+	setupSolverBodiesParam.numRigidBodies = scene.numRigidBodies;
+
+	pfxSetupSolverBodies(setupSolverBodiesParam,taskManager);
+
+	PfxSetupContactConstraintsParam setupContactParam;
+	setupContactParam.contactPairs = scene.pairs;
+	setupContactParam.numContactPairs = scene.numPairs;
+	setupContactParam.offsetContactManifolds = scene.contacts;
+	setupContactParam.offsetRigidStates = scene.states;
+	setupContactParam.offsetRigidBodies = scene.bodies;
+	setupContactParam.offsetSolverBodies = scene.solverBodies;
+	setupContactParam.numRigidBodies = scene.numRigidBodies;
+	setupContactParam.timeStep = timeStep;
+	setupContactParam.separateBias = separateBias;
+
+	pfxSetupContactConstraints(setupContactParam,taskManager);
+
+	PfxSolveConstraintsParam param;
+	param.workBytes = scene.workBytes;
+	param.workBuff = scene.workBuff;
+	param.contactPairs = scene.pairs;
+	param.numContactPairs = scene.numPairs;
+	param.offsetContactManifolds = scene.contacts;
+	param.jointPairs = NULL;
+	param.numJointPairs = 0;
+	param.offsetJoints = NULL;
+	param.offsetRigidStates = scene.states;
+	param.offsetSolverBodies = scene.solverBodies;
+	param.numRigidBodies = scene.numRigidBodies;
+	param.iteration = iteration;
+
+	PfxPerfCounter pc;
+	pc.countBegin("solve constraints");
+	int ret = pfxSolveConstraints(param,taskManager);
+	pc.countEnd();
+	if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSolveConstraints failed %d\n",ret);
+
+	return pc.getCountTime(0);
+}
+
+float solveRepeat(SolverScene &scene,PfxTaskManager *taskManager)
+{
+	float best = 0.0f;
+	for(int i=0;i<NUM_REPEATS;i++) {
+		float t = solve(scene,taskManager);
+		if(i == 0 || t < best) best = t;
+	}
+	return best;
+}
+
+void getVelocities(const SolverScene &scene,PfxVector3 *velocities)
+{
+	for(PfxUInt32 i=0;i<scene.numRigidBodies;i++) {
+		velocities[i*2+0] = scene.states[i].getLinearVelocity();
+		velocities[i*2+1] = scene.states[i].getAngularVelocity();
+	}
+}
+
+int main(int argc,char **argv)
+{
+	int numTasks = 4;
+#ifndef _WIN32
+	numTasks = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if(argc > 1) numTasks = atoi(argv[1]);
+	if(numTasks < 1) numTasks = 1;
+
+	PfxTaskManager *taskManager = NULL;
+#ifndef _WIN32
+	PfxUInt32 taskBytes = pfxGetWorkBytesOfTaskManager(numTasks,numTasks);
+	void *taskBuff = SCE_PFX_UTIL_ALLOC(16,taskBytes);
+	taskManager = pfxCreateTaskManagerPthreads(numTasks,numTasks,taskBuff,taskBytes);
+	taskManager->initialize();
+#else
+	SCE_PFX_PRINTF("no task manager on this platform, only the single thread path is measured\n");
+#endif
+
+	SCE_PFX_PRINTF("%d tasks, %d iterations, best of %d runs\n",numTasks,iteration,NUM_REPEATS);
+
+	const PfxUInt32 sceneSizes[] = {10000,20000,30000,40000,50000};
+
+	for(int s=0;s<(int)(sizeof(sceneSizes)/sizeof(sceneSizes[0]));s++) {
+		SolverScene scene;
+		createScene(scene,sceneSizes[s]);
+
+		PfxVector3 *singleVelocities = (PfxVector3*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxVector3)*scene.numRigidBodies*2);
+		PfxVector3 *taskVelocities = (PfxVector3*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxVector3)*scene.numRigidBodies*2);
+
+		float singleTime = solveRepeat(scene,NULL);
+		getVelocities(scene,singleVelocities);
+
+		SCE_PFX_PRINTF("bodies %5u pairs %6u | single %8.2fms",scene.numRigidBodies,scene.numPairs,singleTime);
+
+		if(taskManager) {
+			taskManager->setNumTasks(1);
+			float oneTaskTime = solveRepeat(scene,taskManager);
+			getVelocities(scene,taskVelocities);
+
+			PfxFloat maxDiff = 0.0f;
+			for(PfxUInt32 i=0;i<scene.numRigidBodies*2;i++) {
+				maxDiff = SCE_PFX_MAX(maxDiff,maxElem(absPerElem(taskVelocities[i]-singleVelocities[i])));
+			}
+
+			taskManager->setNumTasks(numTasks);
+			float numTasksTime = solveRepeat(scene,taskManager);
+
+			PfxBool identical = true;
+			for(PfxUInt32 i=0;i<scene.numRigidBodies;i++) {
+				PfxVector3 linVel = scene.states[i].getLinearVelocity();
+				PfxVector3 angVel = scene.states[i].getAngularVelocity();
+				for(int j=0;j<3;j++) {
+					if(linVel[j] != taskVelocities[i*2+0][j] || angVel[j] != taskVelocities[i*2+1][j]) identical = false;
+				}
+			}
+
+			SCE_PFX_PRINTF(" | 1 task %8.2fms | %d tasks %8.2fms (x%.2f) | %s | max diff to single %g",
+				oneTaskTime,numTasks,numTasksTime,singleTime/numTasksTime,
+				identical?"identical to 1 task":"DIFFERENT from 1 task",maxDiff);
+		}
+
+		SCE_PFX_PRINTF("\n");
+
+		SCE_PFX_UTIL_FREE(taskVelocities);
+		SCE_PFX_UTIL_FREE(singleVelocities);
+		releaseScene(scene);
+	}
+
+	if(taskManager) {
+		taskManager->finalize();
+		delete taskManager;
+#ifndef _WIN32
+		SCE_PFX_UTIL_FREE(taskBuff);
+#endif
+	}
+
+	return 0;
+}
@@ -0,0 +1,460 @@
+/*
+Physics Effects Copyright(C) 2010 Sony Computer Entertainment Inc.
+All rights reserved.
+
+Physics Effects is open software; you can redistribute it and/or
+modify it under the terms of the BSD License.
+
+Physics Effects is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+See the BSD License for more details.
+
+A copy of the BSD License is distributed with
+Physics Effects under the filename: physics_effects_license.txt
+*/
+
+#include "physics_effects.h"
+#include "util/pfx_util_common.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace sce::PhysicsEffects;
+
+//J 剛体IDの幅(16ビットかSCE_PFX_USE_WIDE_OBJECT_IDを定義した32ビット)によるメモリと速度の違いを測る
+//J 各データ構造のサイズとシーン全体のバイト数を表示し、箱の山をパイプライン全体で数フレーム進めて各ステージの時間を表示する
+//J 32ビットIDのビルドでは65535個を超える剛体のシーンも実行する
+//E Measures the memory and speed cost of the width of rigid body ids (16 bits, or 32 bits with SCE_PFX_USE_WIDE_OBJECT_ID defined)
+//E Prints the size of each data structure and the bytes of the whole scene, then runs stacks of boxes through the whole pipeline
+//E for a few frames and prints the time of each stage
+//E The 32 bit id build also runs scenes of more than 65535 rigid bodies
+
+#define STACK_HEIGHT 5
+#define PAIRS_PER_BODY 4
+#define NUM_WARMUP_FRAMES 1
+#define NUM_FRAMES 4
+
+const float timeStep = 0.016f;
+const float separateBias = 0.1f;
+const int iteration = 5;
+
+PfxVector3 worldCenter(0.0f);
+PfxVector3 worldExtent(500.0f);
+
+enum {
+	STAGE_UPDATE_PROXIES = 0,
+	STAGE_FIND_PAIRS,
+	STAGE_DECOMPOSE_PAIRS,
+	STAGE_SORT_PAIRS,
+	STAGE_COLLISION,
+	STAGE_SOLVER,
+	STAGE_INTEGRATE,
+	NUM_STAGES
+};
+
+const char *stageNames[NUM_STAGES] = {
+	"proxies",
+	"find",
+	"decompose",
+	"sort",
+	"collision",
+	"solver",
+	"integrate",
+};
+
+struct BenchmarkScene {
+	PfxUInt32 numRigidBodies;
+	PfxRigidState *states;
+	PfxRigidBody *bodies;
+	PfxCollidable *collidables;
+	PfxSolverBody *solverBodies;
+	PfxBroadphaseProxy *proxies;
+	int proxyAxis;
+
+	PfxUInt32 maxPairs;
+	PfxUInt32 numPairs[2];
+	PfxBroadphasePair *pairsBuff[2];
+	int pairSwap;
+
+	PfxUInt32 numContacts;
+	PfxContactManifold *contacts;
+	PfxUInt32 numContactIdPool;
+	PfxUInt32 *contactIdPool;
+};
+
+//J シーンが確保するバイト数
+//E Bytes allocated by a scene
+PfxUInt32 getSceneBytes(PfxUInt32 numRigidBodies,PfxUInt32 maxPairs)
+{
+	PfxUInt32 bytesPerBody = sizeof(PfxRigidState) + sizeof(PfxRigidBody) + sizeof(PfxCollidable) + sizeof(PfxSolverBody) + sizeof(PfxBroadphaseProxy);
+	PfxUInt32 bytesPerPair = sizeof(PfxBroadphasePair) * 2 + sizeof(PfxContactManifold) + sizeof(PfxUInt32);
+	return bytesPerBody * numRigidBodies + bytesPerPair * maxPairs;
+}
+
+void createBox(BenchmarkScene &scene,const PfxVector3 &pos,const PfxVector3 &boxSize,PfxFloat mass,ePfxMotionType motionType)
+{
+	PfxUInt32 id = scene.numRigidBodies++;
+	PfxBox box(boxSize);
+	PfxShape shape;
+	shape.reset();
+	shape.setBox(box);
+	scene.collidables[id].reset();
+	scene.collidables[id].addShape(shape);
+	scene.collidables[id].finish();
+	scene.bodies[id].reset();
+	scene.states[id].reset();
+	scene.states[id].setPosition(pos);
+	scene.states[id].setMotionType(motionType);
+	scene.states[id].setRigidBodyId(id);
+	if(motionType == kPfxMotionTypeActive) {
+		scene.bodies[id].setRestitution(0.0f);
+		scene.bodies[id].setMass(mass);
+		scene.bodies[id].setInertia(pfxCalcInertiaBox(boxSize,mass));
+	}
+}
+
+void createScene(BenchmarkScene &scene,PfxUInt32 numRigidBodies)
+{
+	memset(&scene,0,sizeof(BenchmarkScene));
+
+	scene.states = (PfxRigidState*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxRigidState)*numRigidBodies);
+	scene.bodies = (PfxRigidBody*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxRigidBody)*numRigidBodies);
+	scene.collidables = (PfxCollidable*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxCollidable)*numRigidBodies);
+	scene.solverBodies = (PfxSolverBody*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxSolverBody)*numRigidBodies);
+	scene.proxies = (PfxBroadphaseProxy*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxBroadphaseProxy)*numRigidBodies);
+	scene.proxyAxis = -1;
+
+	scene.maxPairs = numRigidBodies * PAIRS_PER_BODY;
+	scene.pairsBuff[0] = (PfxBroadphasePair*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxBroadphasePair)*scene.maxPairs);
+	scene.pairsBuff[1] = (PfxBroadphasePair*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxBroadphasePair)*scene.maxPairs);
+	scene.contacts = (PfxContactManifold*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxContactManifold)*scene.maxPairs);
+	scene.contactIdPool = (PfxUInt32*)SCE_PFX_UTIL_ALLOC(16,sizeof(PfxUInt32)*scene.maxPairs);
+
+	//J 地面と格子状に並べた箱の山
+	//E A ground and stacks of boxes on a grid
+	createBox(scene,PfxVector3(0.0f,-2.5f,0.0f),PfxVector3(150.0f,2.5f,150.0f),0.0f,kPfxMotionTypeFixed);
+
+	PfxUInt32 numStacks = (numRigidBodies - 1) / STACK_HEIGHT;
+	PfxUInt32 gridSize = (PfxUInt32)ceilf(sqrtf((float)numStacks));
+	PfxVector3 boxSize(0.5f);
+	PfxFloat spacing = 1.1f;
+	PfxFloat offset = -0.5f * spacing * gridSize;
+
+	for(PfxUInt32 s=0;s<numStacks;s++) {
+		PfxFloat x = offset + spacing * (s % gridSize);
+		PfxFloat z = offset + spacing * (s / gridSize);
+		for(int h=0;h<STACK_HEIGHT;h++) {
+			createBox(scene,PfxVector3(x,0.49f+0.99f*h,z),boxSize,1.0f,kPfxMotionTypeActive);
+		}
+	}
+}
+
+void releaseScene(BenchmarkScene &scene)
+{
+	SCE_PFX_UTIL_FREE(scene.contactIdPool);
+	SCE_PFX_UTIL_FREE(scene.contacts);
+	SCE_PFX_UTIL_FREE(scene.pairsBuff[1]);
+	SCE_PFX_UTIL_FREE(scene.pairsBuff[0]);
+	SCE_PFX_UTIL_FREE(scene.proxies);
+	SCE_PFX_UTIL_FREE(scene.solverBodies);
+	SCE_PFX_UTIL_FREE(scene.collidables);
+	SCE_PFX_UTIL_FREE(scene.bodies);
+	SCE_PFX_UTIL_FREE(scene.states);
+}
+
+//J 1フレーム進め、各ステージの時間(ms)をstageTimesに加える
+//E Step one frame and add the time of each stage in ms to stageTimes
+void simulate(BenchmarkScene &scene,PfxTaskManager *taskManager,float *stageTimes)
+{
+	PfxPerfCounter pc;
+	int ret;
+
+	for(PfxUInt32 i=1;i<scene.numRigidBodies;i++) {
+		pfxApplyExternalForce(scene.states[i],scene.bodies[i],scene.bodies[i].getMass()*PfxVector3(0.0f,-9.8f,0.0f),PfxVector3(0.0f),timeStep);
+	}
+
+	scene.pairSwap = 1-scene.pairSwap;
+
+	PfxUInt32 &numPreviousPairs = scene.numPairs[1-scene.pairSwap];
+	PfxUInt32 &numCurrentPairs = scene.numPairs[scene.pairSwap];
+	PfxBroadphasePair *previousPairs = scene.pairsBuff[1-scene.pairSwap];
+	PfxBroadphasePair *currentPairs = scene.pairsBuff[scene.pairSwap];
+
+	//J ブロードフェーズプロキシの更新
+	//E Update broadphase proxies
+	{
+		PfxUpdateSortedBroadphaseProxiesParam param;
+		param.workBytes = pfxGetWorkBytesOfUpdateSortedBroadphaseProxies(scene.numRigidBodies);
+		param.workBuff = SCE_PFX_UTIL_ALLOC(16,param.workBytes);
+		param.proxies = scene.proxies;
+		param.offsetRigidStates = scene.states;
+		param.offsetCollidables = scene.collidables;
+		param.numRigidBodies = scene.numRigidBodies;
+		param.worldCenter = worldCenter;
+		param.worldExtent = worldExtent;
+		param.axis = scene.proxyAxis;
+
+		PfxUpdateSortedBroadphaseProxiesResult result;
+
+		pc.countBegin(stageNames[STAGE_UPDATE_PROXIES]);
+		ret = pfxUpdateSortedBroadphaseProxies(param,result,taskManager);
+		pc.countEnd();
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxUpdateSortedBroadphaseProxies failed %d\n",ret);
+
+		SCE_PFX_UTIL_FREE(param.workBuff);
+
+		scene.proxyAxis = result.axis;
+	}
+
+	//J 交差ペア探索と合成
+	//E Find overlapped pairs and decompose them
+	{
+		PfxFindPairsParam findPairsParam;
+		findPairsParam.pairBytes = pfxGetPairBytesOfFindPairs(scene.maxPairs);
+		findPairsParam.pairBuff = SCE_PFX_UTIL_ALLOC(16,findPairsParam.pairBytes);
+		findPairsParam.workBytes = pfxGetWorkBytesOfFindPairs(scene.numRigidBodies,scene.maxPairs,taskManager?taskManager->getNumTasks():1);
+		findPairsParam.workBuff = SCE_PFX_UTIL_ALLOC(16,findPairsParam.workBytes);
+		findPairsParam.proxies = scene.proxies;
+		findPairsParam.numProxies = scene.numRigidBodies;
+		findPairsParam.maxPairs = scene.maxPairs;
+		findPairsParam.axis = scene.proxyAxis;
+
+		PfxFindPairsResult findPairsResult;
+
+		pc.countBegin(stageNames[STAGE_FIND_PAIRS]);
+		ret = pfxFindPairs(findPairsParam,findPairsResult,taskManager);
+		pc.countEnd();
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxFindPairs failed %d\n",ret);
+
+		SCE_PFX_UTIL_FREE(findPairsParam.workBuff);
+
+		PfxDecomposePairsParam decomposePairsParam;
+		decomposePairsParam.pairBytes = pfxGetPairBytesOfDecomposePairs(numPreviousPairs,findPairsResult.numPairs);
+		decomposePairsParam.pairBuff = SCE_PFX_UTIL_ALLOC(16,decomposePairsParam.pairBytes);
+		decomposePairsParam.workBytes = pfxGetWorkBytesOfDecomposePairs(numPreviousPairs,findPairsResult.numPairs);
+		decomposePairsParam.workBuff = SCE_PFX_UTIL_ALLOC(16,decomposePairsParam.workBytes);
+		decomposePairsParam.previousPairs = previousPairs;
+		decomposePairsParam.numPreviousPairs = numPreviousPairs;
+		decomposePairsParam.currentPairs = findPairsResult.pairs;
+		decomposePairsParam.numCurrentPairs = findPairsResult.numPairs;
+
+		PfxDecomposePairsResult decomposePairsResult;
+
+		pc.countBegin(stageNames[STAGE_DECOMPOSE_PAIRS]);
+		ret = pfxDecomposePairs(decomposePairsParam,decomposePairsResult);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxDecomposePairs failed %d\n",ret);
+
+		for(PfxUInt32 i=0;i<decomposePairsResult.numOutRemovePairs;i++) {
+			scene.contactIdPool[scene.numContactIdPool++] = pfxGetContactId(decomposePairsResult.outRemovePairs[i]);
+		}
+
+		for(PfxUInt32 i=0;i<decomposePairsResult.numOutNewPairs;i++) {
+			PfxUInt32 cId = 0;
+			if(scene.numContactIdPool > 0) {
+				cId = scene.contactIdPool[--scene.numContactIdPool];
+			}
+			else {
+				cId = scene.numContacts++;
+			}
+			SCE_PFX_ASSERT(cId < scene.maxPairs);
+			pfxSetContactId(decomposePairsResult.outNewPairs[i],cId);
+			scene.contacts[cId].reset(pfxGetObjectIdA(decomposePairsResult.outNewPairs[i]),pfxGetObjectIdB(decomposePairsResult.outNewPairs[i]));
+		}
+
+		numCurrentPairs = 0;
+		for(PfxUInt32 i=0;i<decomposePairsResult.numOutKeepPairs;i++) {
+			currentPairs[numCurrentPairs++] = decomposePairsResult.outKeepPairs[i];
+		}
+		for(PfxUInt32 i=0;i<decomposePairsResult.numOutNewPairs;i++) {
+			currentPairs[numCurrentPairs++] = decomposePairsResult.outNewPairs[i];
+		}
+		pc.countEnd();
+
+		SCE_PFX_UTIL_FREE(decomposePairsParam.workBuff);
+		SCE_PFX_UTIL_FREE(decomposePairsParam.pairBuff);
+		SCE_PFX_UTIL_FREE(findPairsParam.pairBuff);
+	}
+
+	//J ペアのソート
+	//E Sort pairs
+	{
+		PfxUInt32 workBytes = sizeof(PfxBroadphasePair) * numCurrentPairs;
+		void *workBuff = SCE_PFX_UTIL_ALLOC(16,workBytes);
+
+		pc.countBegin(stageNames[STAGE_SORT_PAIRS]);
+		ret = pfxParallelSort(currentPairs,numCurrentPairs,workBuff,workBytes,taskManager);
+		pc.countEnd();
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxParallelSort failed %d\n",ret);
+
+		SCE_PFX_UTIL_FREE(workBuff);
+	}
+
+	//J 衝突検出とリフレッシュ
+	//E Detect collisions and refresh contacts
+	{
+		PfxDetectCollisionParam detectParam;
+		detectParam.contactPairs = currentPairs;
+		detectParam.numContactPairs = numCurrentPairs;
+		detectParam.offsetContactManifolds = scene.contacts;
+		detectParam.offsetRigidStates = scene.states;
+		detectParam.offsetCollidables = scene.collidables;
+		detectParam.numRigidBodies = scene.numRigidBodies;
+
+		PfxRefreshContactsParam refreshParam;
+		refreshParam.contactPairs = currentPairs;
+		refreshParam.numContactPairs = numCurrentPairs;
+		refreshParam.offsetContactManifolds = scene.contacts;
+		refreshParam.offsetRigidStates = scene.states;
+		refreshParam.numRigidBodies = scene.numRigidBodies;
+
+		pc.countBegin(stageNames[STAGE_COLLISION]);
+		ret = pfxDetectCollision(detectParam,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxDetectCollision failed %d\n",ret);
+		ret = pfxRefreshContacts(refreshParam,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxRefreshContacts failed %d\n",ret);
+		pc.countEnd();
+	}
+
+	//J 拘束ソルバー
+	//E Constraint solver
+	{
+		PfxSetupSolverBodiesParam setupSolverBodiesParam;
+		setupSolverBodiesParam.states = scene.states;
+		setupSolverBodiesParam.bodies = scene.bodies;
+		setupSolverBodiesParam.solverBodies = scene.solverBodies;
+		setupSolverBodiesParam.numRigidBodies = scene.numRigidBodies;
+
+		PfxSetupContactConstraintsParam setupContactParam;
+		setupContactParam.contactPairs = currentPairs;
+		setupContactParam.numContactPairs = numCurrentPairs;
+		setupContactParam.offsetContactManifolds = scene.contacts;
+		setupContactParam.offsetRigidStates = scene.states;
+		setupContactParam.offsetRigidBodies = scene.bodies;
+		setupContactParam.offsetSolverBodies = scene.solverBodies;
+		setupContactParam.numRigidBodies = scene.numRigidBodies;
+		setupContactParam.timeStep = timeStep;
+		setupContactParam.separateBias = separateBias;
+
+		PfxSolveConstraintsParam solveParam;
+		solveParam.workBytes = pfxGetWorkBytesOfSolveConstraints(scene.numRigidBodies,numCurrentPairs,0);
+		solveParam.workBuff = SCE_PFX_UTIL_ALLOC(16,solveParam.workBytes);
+		solveParam.contactPairs = currentPairs;
+		solveParam.numContactPairs = numCurrentPairs;
+		solveParam.offsetContactManifolds = scene.contacts;
+		solveParam.jointPairs = NULL;
+		solveParam.numJointPairs = 0;
+		solveParam.offsetJoints = NULL;
+		solveParam.offsetRigidStates = scene.states;
+		solveParam.offsetSolverBodies = scene.solverBodies;
+		solveParam.numRigidBodies = scene.numRigidBodies;
+		solveParam.iteration = iteration;
+
+		pc.countBegin(stageNames[STAGE_SOLVER]);
+		ret = pfxSetupSolverBodies(setupSolverBodiesParam,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSetupSolverBodies failed %d\n",ret);
+		ret = pfxSetupContactConstraints(setupContactParam,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSetupContactConstraints failed %d\n",ret);
+		ret = pfxSolveConstraints(solveParam,taskManager);
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxSolveConstraints failed %d\n",ret);
+		pc.countEnd();
+
+		SCE_PFX_UTIL_FREE(solveParam.workBuff);
+	}
+
+	//J 剛体の状態の更新
+	//E Integrate rigid states
+	{
+		PfxUpdateRigidStatesParam param;
+		param.states = scene.states;
+		param.bodies = scene.bodies;
+		param.numRigidBodies = scene.numRigidBodies;
+		param.timeStep = timeStep;
+
+		pc.countBegin(stageNames[STAGE_INTEGRATE]);
+		ret = pfxUpdateRigidStates(param,taskManager);
+		pc.countEnd();
+		if(ret != SCE_PFX_OK) SCE_PFX_PRINTF("pfxUpdateRigidStates failed %d\n",ret);
+	}
+
+	for(int s=0;s<NUM_STAGES;s++) {
+		stageTimes[s] += pc.getCountTime(s*2);
+	}
+}
+
+int main(int argc,char **argv)
+{
+	int numTasks = 1;
+	if(argc > 1) numTasks = atoi(argv[1]);
+	if(numTasks < 1) numTasks = 1;
+
+	PfxTaskManager *taskManager = NULL;
+#ifndef _WIN32
+	PfxUInt32 taskBytes = 0;
+	void *taskBuff = NULL;
+	if(numTasks > 1) {
+		taskBytes = pfxGetWorkBytesOfTaskManager(numTasks,numTasks);
+		taskBuff = SCE_PFX_UTIL_ALLOC(16,taskBytes);
+		taskManager = pfxCreateTaskManagerPthreads(numTasks,numTasks,taskBuff,taskBytes);
+		taskManager->initialize();
+	}
+#else
+	numTasks = 1;
+#endif
+
+#ifdef SCE_PFX_USE_WIDE_OBJECT_ID
+	SCE_PFX_PRINTF("32 bit object ids (SCE_PFX_USE_WIDE_OBJECT_ID)\n");
+	const PfxUInt32 sceneSizes[] = {16384,32768,65535,131072,262144};
+#else
+	SCE_PFX_PRINTF("16 bit object ids, up to 65535 rigid bodies\n");
+	const PfxUInt32 sceneSizes[] = {16384,32768,65535};
+#endif
+
+	SCE_PFX_PRINTF("PfxRigidState %u PfxBroadphaseProxy %u PfxBroadphasePair %u PfxContactManifold %u PfxJoint %u bytes, pair sort key %u bits\n",
+		(PfxUInt32)sizeof(PfxRigidState),(PfxUInt32)sizeof(PfxBroadphaseProxy),(PfxUInt32)sizeof(PfxBroadphasePair),
+		(PfxUInt32)sizeof(PfxContactManifold),(PfxUInt32)sizeof(PfxJoint),
+		(PfxUInt32)sizeof(pfxGetKey(PfxBroadphasePair()))*8);
+
+	SCE_PFX_PRINTF("%d tasks, %d iterations, ms per frame averaged over %d frames\n",numTasks,iteration,NUM_FRAMES);
+
+	for(int s=0;s<(int)(sizeof(sceneSizes)/sizeof(sceneSizes[0]));s++) {
+		BenchmarkScene scene;
+		createScene(scene,sceneSizes[s]);
+
+		float stageTimes[NUM_STAGES];
+
+		//J 最初のフレームは全てのコンタクトを作るので計測しない
+		//E Do not measure the first frames, which create all contacts
+		memset(stageTimes,0,sizeof(stageTimes));
+		for(int f=0;f<NUM_WARMUP_FRAMES;f++) {
+			simulate(scene,taskManager,stageTimes);
+		}
+
+		memset(stageTimes,0,sizeof(stageTimes));
+		for(int f=0;f<NUM_FRAMES;f++) {
+			simulate(scene,taskManager,stageTimes);
+		}
+
+		float totalTime = 0.0f;
+		SCE_PFX_PRINTF("bodies %6u pairs %7u %6.1fMB |",scene.numRigidBodies,scene.numPairs[scene.pairSwap],
+			getSceneBytes(scene.numRigidBodies,scene.maxPairs)/(1024.0f*1024.0f));
+		for(int i=0;i<NUM_STAGES;i++) {
+			SCE_PFX_PRINTF(" %s %7.2f",stageNames[i],stageTimes[i]/NUM_FRAMES);
+			totalTime += stageTimes[i]/NUM_FRAMES;
+		}
+		SCE_PFX_PRINTF(" | total %8.2f\n",totalTime);
+
+		releaseScene(scene);
+	}
+
+	if(taskManager) {
+		taskManager->finalize();
+		delete taskManager;
+#ifndef _WIN32
+		SCE_PFX_UTIL_FREE(taskBuff);
+#endif
+	}
+
+	return 0;
+}
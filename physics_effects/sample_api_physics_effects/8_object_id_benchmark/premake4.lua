@@ -0,0 +1,15 @@
+	project "pe_sample_8_object_id_benchmark"
+		
+	kind "ConsoleApp"
+	targetdir "../../../bin"
+	includedirs {"../../../physics_effects"}
+		
+	links {
+		"physics_effects_low_level",
+		"physics_effects_base_level",
+		"physics_effects_util"
+	}
+	
+	files {
+		"main.cpp"
+	}